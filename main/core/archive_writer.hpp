@@ -0,0 +1,409 @@
+/**
+ * @file archive_writer.hpp
+ * @brief Streaming ZIP (stored entries) and TAR writer for bulk frame export
+ *
+ * Architecture:
+ *   begin(sink) → [add_entry() → write()... → end_entry()] x n → finish()
+ *
+ * Archive bytes go to the sink in order as they are produced. Entry data is
+ * passed through untouched (frames are sent straight from ring slots, the
+ * burst arena or a storage read buffer); only headers are staged, in one
+ * 512-byte scratch block that also batches the small records between
+ * entries into one sink call.
+ *
+ * ZIP entries are stored (frames are already JPEG) with general purpose
+ * bit 3 set: the CRC follows the data in a data descriptor, so nothing is
+ * buffered or read twice. The central directory needs each entry's CRC,
+ * size and offset, kept in a table of 20 bytes per entry (max_entries,
+ * PSRAM); TAR needs no table, so its memory use is constant.
+ *
+ * Entry names are generated: prefix + zero-padded number + suffix
+ * (e.g. "clip_12/000001.jpg"), so the table does not store them.
+ * ZIP is limited to 65535 entries and 4 GB (no ZIP64), TAR to 8 GB entries.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include "civil_time.hpp"
+#include "crc32.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+namespace core {
+
+enum class ArchiveFormat : uint8_t {
+    Zip = 0,   // Stored entries with data descriptors
+    Tar = 1    // POSIX ustar
+};
+
+struct ArchiveConfig {
+    ArchiveFormat format = ArchiveFormat::Zip;
+    uint32_t max_entries = 4096;   // ZIP central directory table (20 B per entry)
+};
+
+// Receives archive bytes in order; returning false aborts the archive
+using ArchiveSink = bool (*)(void* context, const uint8_t* data, size_t size);
+
+static constexpr size_t ARCHIVE_MAX_PREFIX = 40;
+static constexpr size_t ARCHIVE_MAX_SUFFIX = 8;
+static constexpr size_t ARCHIVE_NUMBER_DIGITS = 6;   // Wider numbers are not truncated
+static constexpr size_t ARCHIVE_BLOCK_SIZE = 512;     // TAR block, scratch size
+
+/**
+ * @brief MS-DOS date (high 16 bits) and time (low 16 bits), UTC
+ *
+ * Two-second resolution; clamped to 1980-01-01, the earliest DOS date.
+ */
+inline uint32_t zip_dos_datetime(int64_t epoch_s) {
+    if (epoch_s < 315532800) epoch_s = 315532800;   // 1980-01-01 00:00:00
+    int64_t days = epoch_s / 86400;
+    int64_t secs = epoch_s % 86400;
+
+    int64_t year, month, day;
+    civil_from_days(days, &year, &month, &day);
+    if (year > 2107) year = 2107;
+
+    uint32_t date = static_cast<uint32_t>(((year - 1980) << 9) | (month << 5) | day);
+    uint32_t time = static_cast<uint32_t>(((secs / 3600) << 11) | ((secs / 60 % 60) << 5) | (secs % 60 / 2));
+    return date << 16 | time;
+}
+
+/**
+ * @brief Writes one archive at a time to a sink
+ *
+ * Usage:
+ *   ArchiveWriter zip;
+ *   zip.init({.format = ArchiveFormat::Zip});
+ *   zip.begin(send_fn, ctx, "clip_12/", ".jpg");
+ *   for (each frame) {
+ *       zip.add_entry(index, mtime_s, size);
+ *       zip.write(data, size);         // Straight to the sink
+ *       zip.end_entry();
+ *   }
+ *   zip.finish();
+ */
+class ArchiveWriter {
+public:
+    ArchiveWriter() = default;
+    ~ArchiveWriter() { deinit(); }
+
+    // Non-copyable
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    /**
+     * @brief Allocate the central directory table (ZIP only)
+     * @param use_psram Use PSRAM for the table (ESP32 only)
+     */
+    bool init(const ArchiveConfig& config = {}, bool use_psram = true) {
+        if (initialized_) return true;
+        config_ = config;
+        if (config_.format == ArchiveFormat::Zip) {
+            if (config_.max_entries == 0) return false;
+            if (config_.max_entries > 0xFFFF) config_.max_entries = 0xFFFF;
+            size_t bytes = config_.max_entries * sizeof(ZipEntry);
+#ifdef ESP_PLATFORM
+            entries_ = static_cast<ZipEntry*>(use_psram ? heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM)
+                                                        : malloc(bytes));
+#else
+            (void)use_psram;
+            entries_ = static_cast<ZipEntry*>(malloc(bytes));
+#endif
+            if (!entries_) return false;
+        }
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        if (entries_) {
+#ifdef ESP_PLATFORM
+            heap_caps_free(entries_);
+#else
+            free(entries_);
+#endif
+            entries_ = nullptr;
+        }
+        state_ = State::Idle;
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Start a new archive (any unfinished one is abandoned)
+     * @param prefix Prepended to every entry name (may contain '/')
+     * @param suffix Appended to every entry name (e.g. ".jpg")
+     * @return false if not initialized or prefix/suffix are too long
+     */
+    bool begin(ArchiveSink sink, void* context, const char* prefix = "", const char* suffix = "") {
+        if (!initialized_ || !sink || !prefix || !suffix) return false;
+        if (strlen(prefix) > ARCHIVE_MAX_PREFIX || strlen(suffix) > ARCHIVE_MAX_SUFFIX) return false;
+        sink_ = sink;
+        context_ = context;
+        strcpy(prefix_, prefix);
+        strcpy(suffix_, suffix);
+        count_ = 0;
+        offset_ = 0;
+        staged_ = 0;
+        state_ = State::Open;
+        return true;
+    }
+
+    /**
+     * @brief Start an entry; its header is staged until write() or the next call
+     * @param number Names the entry (prefix + number + suffix)
+     * @param mtime_s Modification time, seconds since the Unix epoch
+     * @param size Exact number of bytes write() will be given
+     */
+    bool add_entry(uint32_t number, int64_t mtime_s, uint64_t size) {
+        if (state_ != State::Open) return fail_if_active();
+        char name[ARCHIVE_MAX_PREFIX + 10 + ARCHIVE_MAX_SUFFIX + 1];
+        size_t name_len = format_name(number, name);
+
+        if (config_.format == ArchiveFormat::Zip) {
+            if (count_ >= config_.max_entries || size > 0xFFFFFFFEu ||
+                offset_ + staged_ + 30 + name_len + size + 16 > 0xFFFFFFFEu) return fail();
+            ZipEntry& e = entries_[count_];
+            e.number = number;
+            e.dos_datetime = zip_dos_datetime(mtime_s);
+            e.offset = static_cast<uint32_t>(offset_ + staged_);
+            e.size = 0;
+            e.crc = 0;
+            uint8_t header[30];
+            put32(header, 0x04034b50);
+            put16(header + 4, 20);                 // Version needed: 2.0
+            put16(header + 6, 0x0008);             // CRC and sizes in the data descriptor
+            put16(header + 8, 0);                  // Stored
+            put32(header + 10, e.dos_datetime);    // Time, then date
+            put32(header + 14, 0);
+            put32(header + 18, 0);
+            put32(header + 22, 0);
+            put16(header + 26, static_cast<uint16_t>(name_len));
+            put16(header + 28, 0);
+            if (!stage(header, sizeof(header)) ||
+                !stage(reinterpret_cast<const uint8_t*>(name), name_len)) return fail();
+        } else {
+            if (size > 077777777777ull || name_len > 99) return fail();
+            uint8_t header[ARCHIVE_BLOCK_SIZE] = {};
+            memcpy(header, name, name_len);
+            memcpy(header + 100, "0000644", 8);    // Mode
+            memcpy(header + 108, "0000000", 8);    // uid
+            memcpy(header + 116, "0000000", 8);    // gid
+            put_octal(header + 124, 12, size);
+            put_octal(header + 136, 12, static_cast<uint64_t>(mtime_s > 0 ? mtime_s : 0));
+            header[156] = '0';                     // Regular file
+            memcpy(header + 257, "ustar", 6);
+            memcpy(header + 263, "00", 2);
+            memset(header + 148, ' ', 8);
+            uint32_t sum = 0;
+            for (uint8_t b : header) sum += b;
+            put_octal(header + 148, 7, sum);       // Six digits, NUL, then the space
+            header[155] = ' ';
+            if (!stage(header, sizeof(header))) return fail();
+        }
+        entry_size_ = size;
+        entry_written_ = 0;
+        crc_ = 0;
+        state_ = State::Entry;
+        return true;
+    }
+
+    /**
+     * @brief Pass entry data to the sink (never copied)
+     */
+    bool write(const uint8_t* data, size_t size) {
+        if (state_ != State::Entry) return fail_if_active();
+        if (size == 0) return true;
+        if (!data || entry_written_ + size > entry_size_) return fail();
+        if (!flush()) return fail();
+        if (config_.format == ArchiveFormat::Zip) crc_ = crc32_update(crc_, data, size);
+        if (!sink_(context_, data, size)) return fail();
+        entry_written_ += size;
+        offset_ += size;
+        return true;
+    }
+
+    /**
+     * @brief Close the entry (data descriptor or block padding)
+     * @return false if fewer bytes were written than add_entry() declared
+     */
+    bool end_entry() {
+        if (state_ != State::Entry) return fail_if_active();
+        if (entry_written_ != entry_size_) return fail();
+        if (config_.format == ArchiveFormat::Zip) {
+            ZipEntry& e = entries_[count_];
+            e.crc = crc_;
+            e.size = static_cast<uint32_t>(entry_size_);
+            uint8_t descriptor[16];
+            put32(descriptor, 0x08074b50);
+            put32(descriptor + 4, crc_);
+            put32(descriptor + 8, e.size);
+            put32(descriptor + 12, e.size);
+            if (!stage(descriptor, sizeof(descriptor))) return fail();
+        } else {
+            static const uint8_t zeros[ARCHIVE_BLOCK_SIZE] = {};
+            size_t pad = static_cast<size_t>((ARCHIVE_BLOCK_SIZE - entry_size_ % ARCHIVE_BLOCK_SIZE) %
+                                             ARCHIVE_BLOCK_SIZE);
+            if (!stage(zeros, pad)) return fail();
+        }
+        count_++;
+        state_ = State::Open;
+        return true;
+    }
+
+    /**
+     * @brief Write the central directory (ZIP) or end blocks (TAR) and flush
+     * @param comment ZIP archive comment (e.g. a JSON report); ignored for TAR
+     */
+    bool finish(const char* comment = nullptr) {
+        if (state_ != State::Open) return fail_if_active();
+        if (config_.format == ArchiveFormat::Zip) {
+            uint64_t directory_offset = offset_ + staged_;
+            char name[ARCHIVE_MAX_PREFIX + 10 + ARCHIVE_MAX_SUFFIX + 1];
+            for (uint32_t i = 0; i < count_; i++) {
+                const ZipEntry& e = entries_[i];
+                size_t name_len = format_name(e.number, name);
+                uint8_t header[46];
+                put32(header, 0x02014b50);
+                put16(header + 4, 20);                 // Made by: MS-DOS, 2.0
+                put16(header + 6, 20);
+                put16(header + 8, 0x0008);
+                put16(header + 10, 0);
+                put32(header + 12, e.dos_datetime);
+                put32(header + 16, e.crc);
+                put32(header + 20, e.size);
+                put32(header + 24, e.size);
+                put16(header + 28, static_cast<uint16_t>(name_len));
+                put16(header + 30, 0);                 // Extra
+                put16(header + 32, 0);                 // Comment
+                put16(header + 34, 0);                 // Disk
+                put16(header + 36, 0);                 // Internal attributes
+                put32(header + 38, 0);                 // External attributes
+                put32(header + 42, e.offset);
+                if (!stage(header, sizeof(header)) ||
+                    !stage(reinterpret_cast<const uint8_t*>(name), name_len)) return fail();
+            }
+            uint64_t directory_size = offset_ + staged_ - directory_offset;
+            if (directory_offset + directory_size > 0xFFFFFFFEu) return fail();
+            size_t comment_len = comment ? strlen(comment) : 0;
+            if (comment_len > 0xFFFF) comment_len = 0xFFFF;
+            uint8_t end[22];
+            put32(end, 0x06054b50);
+            put16(end + 4, 0);
+            put16(end + 6, 0);
+            put16(end + 8, static_cast<uint16_t>(count_));
+            put16(end + 10, static_cast<uint16_t>(count_));
+            put32(end + 12, static_cast<uint32_t>(directory_size));
+            put32(end + 16, static_cast<uint32_t>(directory_offset));
+            put16(end + 20, static_cast<uint16_t>(comment_len));
+            if (!stage(end, sizeof(end)) ||
+                !stage(reinterpret_cast<const uint8_t*>(comment), comment_len)) return fail();
+        } else {
+            static const uint8_t zeros[ARCHIVE_BLOCK_SIZE] = {};
+            if (!stage(zeros, sizeof(zeros)) || !stage(zeros, sizeof(zeros))) return fail();
+        }
+        if (!flush()) return fail();
+        state_ = State::Finished;
+        return true;
+    }
+
+    bool is_initialized() const { return initialized_; }
+    bool failed() const { return state_ == State::Failed; }
+    uint32_t entries() const { return count_; }
+    uint64_t bytes_written() const { return offset_; }   // Delivered to the sink
+    const ArchiveConfig& config() const { return config_; }
+
+private:
+    enum class State : uint8_t { Idle, Open, Entry, Finished, Failed };
+
+    struct ZipEntry {
+        uint32_t number;
+        uint32_t dos_datetime;
+        uint32_t offset;      // Local header
+        uint32_t size;
+        uint32_t crc;
+    };
+
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        put16(p, static_cast<uint16_t>(v));
+        put16(p + 2, static_cast<uint16_t>(v >> 16));
+    }
+
+    // width - 1 zero-padded octal digits and a NUL (value must fit)
+    static void put_octal(uint8_t* field, size_t width, uint64_t value) {
+        field[width - 1] = 0;
+        for (size_t i = width - 1; i-- > 0; value >>= 3) {
+            field[i] = static_cast<uint8_t>('0' + (value & 7));
+        }
+    }
+
+    size_t format_name(uint32_t number, char* out) const {
+        int len = snprintf(out, ARCHIVE_MAX_PREFIX + 10 + ARCHIVE_MAX_SUFFIX + 1, "%s%0*lu%s", prefix_,
+                           static_cast<int>(ARCHIVE_NUMBER_DIGITS), static_cast<unsigned long>(number),
+                           suffix_);
+        return len > 0 ? static_cast<size_t>(len) : 0;
+    }
+
+    // Append to the scratch block, handing full blocks to the sink
+    bool stage(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            size_t n = ARCHIVE_BLOCK_SIZE - staged_;
+            if (n > size) n = size;
+            memcpy(scratch_ + staged_, data, n);
+            staged_ += n;
+            data += n;
+            size -= n;
+            if (staged_ == ARCHIVE_BLOCK_SIZE && !flush()) return false;
+        }
+        return true;
+    }
+
+    bool flush() {
+        if (staged_ == 0) return true;
+        if (!sink_(context_, scratch_, staged_)) return false;
+        offset_ += staged_;
+        staged_ = 0;
+        return true;
+    }
+
+    bool fail() {
+        state_ = State::Failed;
+        return false;
+    }
+
+    // Call out of order: an archive in progress is broken, otherwise no-op
+    bool fail_if_active() {
+        if (state_ == State::Open || state_ == State::Entry) state_ = State::Failed;
+        return false;
+    }
+
+    ArchiveConfig config_;
+    ZipEntry* entries_ = nullptr;
+    ArchiveSink sink_ = nullptr;
+    void* context_ = nullptr;
+    char prefix_[ARCHIVE_MAX_PREFIX + 1] = {};
+    char suffix_[ARCHIVE_MAX_SUFFIX + 1] = {};
+
+    uint8_t scratch_[ARCHIVE_BLOCK_SIZE];
+    size_t staged_ = 0;
+    uint64_t offset_ = 0;          // Bytes handed to the sink
+    uint32_t count_ = 0;
+    uint64_t entry_size_ = 0;
+    uint64_t entry_written_ = 0;
+    uint32_t crc_ = 0;
+    State state_ = State::Idle;
+    bool initialized_ = false;
+};
+
+} // namespace core
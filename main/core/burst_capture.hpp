@@ -0,0 +1,512 @@
+/**
+ * @file burst_capture.hpp
+ * @brief Short full-rate frame sequences captured into a dedicated arena
+ *
+ * Architecture:
+ *   [HTTP handler] → begin(n, interval) → Pending
+ *   [Producer]     → run(): Capturing → n x (capture → arena) → Done
+ *   [HTTP handler] → wait_frame(i) → send frame i → ... → end() → Idle
+ *
+ * The streaming producer is paced by the stream's target FPS. A burst takes
+ * it over instead: run() is called from the producer task and captures back
+ * to back (or at the requested interval), so the sensor's full rate is
+ * reached without a second task fighting over the camera. Stream viewers
+ * and sinks see a pause for the length of the burst.
+ *
+ * Frames land in one bump-allocated arena (PSRAM) and are never moved or
+ * overwritten until end(), so the consumer streams frame i out while frame
+ * i+1 is being captured, straight from the arena. With a frame processor
+ * installed, its output is written into the arena directly; otherwise each
+ * frame is copied once out of the driver's buffer, which has to go back to
+ * the driver before the next frame can be grabbed.
+ *
+ * The report gives the achieved inter-frame interval (sensor timestamps)
+ * and the arena bytes used; a burst that would overflow the arena stops
+ * early with truncated set.
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::mutex on host.
+ */
+#pragma once
+#include "../interfaces/i_camera.hpp"
+#include "../interfaces/i_clock.hpp"
+#include "../interfaces/i_frame_processor.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#else
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+namespace core {
+
+struct BurstConfig {
+    size_t arena_size = 1024 * 1024;   // Frame storage shared by one burst
+    uint16_t max_frames = 30;          // Longer requests are clamped
+    uint32_t max_interval_ms = 1000;   // Longer intervals are clamped
+};
+
+// Frame inside the arena; valid until end()
+struct BurstFrame {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int64_t timestamp_us = 0;
+};
+
+// Outcome of one burst (final once wait_frame() returns Done)
+struct BurstReport {
+    uint16_t requested = 0;
+    uint16_t frames = 0;
+    uint32_t interval_ms = 0;         // Requested spacing (0 = sensor rate)
+    int64_t interval_min_us = 0;      // Achieved spacing, from frame timestamps
+    int64_t interval_max_us = 0;
+    int64_t interval_mean_us = 0;
+    int64_t capture_us = 0;           // First capture call to last commit
+    uint16_t capture_errors = 0;
+    uint16_t frames_rejected = 0;     // Dropped by the frame processor
+    bool truncated = false;           // Stopped early: arena full
+    size_t arena_used = 0;
+    size_t arena_size = 0;
+};
+
+struct BurstStats {
+    std::atomic<uint32_t> bursts{0};
+    std::atomic<uint32_t> frames{0};
+    std::atomic<uint32_t> truncated{0};
+    std::atomic<uint32_t> cancelled{0};        // Ended by the consumer before completion
+    std::atomic<uint32_t> capture_errors{0};
+    std::atomic<size_t> peak_arena_bytes{0};
+
+    void reset() {
+        bursts = 0;
+        frames = 0;
+        truncated = 0;
+        cancelled = 0;
+        capture_errors = 0;
+        peak_arena_bytes = 0;
+    }
+};
+
+/**
+ * @brief Format a report as one JSON object
+ * @return Bytes written (excluding NUL), 0 if it does not fit
+ */
+inline size_t format_burst_report_json(const BurstReport& report, char* out, size_t capacity) {
+    if (!out || capacity == 0) return 0;
+    int len = snprintf(out, capacity,
+        "{\"requested\":%u,\"frames\":%u,\"interval_ms\":%lu,"
+        "\"interval_min_us\":%lld,\"interval_mean_us\":%lld,\"interval_max_us\":%lld,"
+        "\"capture_us\":%lld,\"capture_errors\":%u,\"rejected\":%u,\"truncated\":%s,"
+        "\"arena_used\":%lu,\"arena_size\":%lu}",
+        report.requested, report.frames, static_cast<unsigned long>(report.interval_ms),
+        static_cast<long long>(report.interval_min_us),
+        static_cast<long long>(report.interval_mean_us),
+        static_cast<long long>(report.interval_max_us),
+        static_cast<long long>(report.capture_us), report.capture_errors,
+        report.frames_rejected, report.truncated ? "true" : "false",
+        static_cast<unsigned long>(report.arena_used),
+        static_cast<unsigned long>(report.arena_size));
+    if (len < 0 || static_cast<size_t>(len) >= capacity) return 0;
+    return static_cast<size_t>(len);
+}
+
+/**
+ * @brief Parse a /burst frame count (decimal digits only)
+ * @return false for empty or non-numeric text, 0, or more than max_frames
+ */
+inline bool parse_burst_count(const char* text, uint16_t max_frames, uint16_t* out) {
+    if (!text || !out) return false;
+    size_t digits = strspn(text, "0123456789");
+    if (digits == 0 || text[digits] != '\0' || digits > 5) return false;
+    unsigned long n = strtoul(text, nullptr, 10);
+    if (n == 0 || n > max_frames) return false;
+    *out = static_cast<uint16_t>(n);
+    return true;
+}
+
+enum class BurstWait : uint8_t {
+    Frame = 0,    // Frame index is available
+    Done = 1,     // Burst finished with fewer frames than index + 1
+    Timeout = 2
+};
+
+/**
+ * @brief One burst at a time, captured by the streaming producer
+ *
+ * Usage:
+ *   BurstCapture burst;
+ *   burst.init({.arena_size = 2 * 1024 * 1024});
+ *   streaming.set_burst(&burst);             // Before start()
+ *
+ *   // Consumer (e.g., HTTP handler):
+ *   if (burst.begin(20, 0)) {
+ *       BurstFrame frame;
+ *       for (uint16_t i = 0; burst.wait_frame(i, &frame, 2000) == BurstWait::Frame; i++) {
+ *           send(frame.data, frame.size);
+ *       }
+ *       BurstReport report = burst.report();
+ *       burst.end();
+ *   }
+ */
+class BurstCapture {
+public:
+    static constexpr size_t ALIGNMENT = 4;              // Frame start alignment in the arena
+    static constexpr uint8_t MAX_CONSECUTIVE_ERRORS = 3;
+
+    BurstCapture() = default;
+    ~BurstCapture() { deinit(); }
+
+    // Non-copyable
+    BurstCapture(const BurstCapture&) = delete;
+    BurstCapture& operator=(const BurstCapture&) = delete;
+
+    /**
+     * @brief Allocate the arena and frame table
+     * @param use_psram Use PSRAM for the arena (ESP32 only)
+     */
+    bool init(const BurstConfig& config = {}, bool use_psram = true) {
+        if (initialized_) return true;
+        if (config.arena_size == 0 || config.max_frames == 0) return false;
+        config_ = config;
+#ifdef ESP_PLATFORM
+        arena_ = static_cast<uint8_t*>(use_psram ? heap_caps_malloc(config_.arena_size, MALLOC_CAP_SPIRAM)
+                                                 : malloc(config_.arena_size));
+#else
+        (void)use_psram;
+        arena_ = static_cast<uint8_t*>(malloc(config_.arena_size));
+#endif
+        frames_ = new (std::nothrow) BurstFrame[config_.max_frames];
+        if (!arena_ || !frames_) {
+            deinit();
+            return false;
+        }
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        frame_ready_ = xSemaphoreCreateBinary();
+        if (!mutex_ || !frame_ready_) {
+            deinit();
+            return false;
+        }
+#endif
+        state_ = State::Idle;
+        initialized_ = true;
+        return true;
+    }
+
+    /**
+     * @note The producer must not be inside run() (stop streaming first)
+     */
+    void deinit() {
+        if (arena_) {
+#ifdef ESP_PLATFORM
+            heap_caps_free(arena_);
+#else
+            free(arena_);
+#endif
+            arena_ = nullptr;
+        }
+        delete[] frames_;
+        frames_ = nullptr;
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+        if (frame_ready_) {
+            vSemaphoreDelete(frame_ready_);
+            frame_ready_ = nullptr;
+        }
+#endif
+        state_ = State::Idle;
+        initialized_ = false;
+    }
+
+    // -------------------------------------------------------------------------
+    // Consumer API
+    // -------------------------------------------------------------------------
+
+    /**
+     * @brief Request a burst; the producer starts it on its next iteration
+     * @param count Frames to capture (clamped to max_frames)
+     * @param interval_ms Spacing between captures (0 = as fast as the sensor
+     *        delivers; clamped to max_interval_ms)
+     * @return false if not initialized, count is 0, or a burst is in progress
+     */
+    bool begin(uint16_t count, uint32_t interval_ms) {
+        if (!initialized_ || count == 0) return false;
+        if (count > config_.max_frames) count = config_.max_frames;
+        if (interval_ms > config_.max_interval_ms) interval_ms = config_.max_interval_ms;
+
+        lock();
+        if (state_ != State::Idle) {
+            unlock();
+            return false;
+        }
+        report_ = {};
+        report_.requested = count;
+        report_.interval_ms = interval_ms;
+        report_.arena_size = config_.arena_size;
+        used_ = 0;
+        cancel_ = false;
+        state_ = State::Pending;
+        unlock();
+        return true;
+    }
+
+    /**
+     * @brief Wait until frame index is captured or the burst is over
+     * @param frame Output: the frame (valid until end())
+     */
+    BurstWait wait_frame(uint16_t index, BurstFrame* frame, uint32_t timeout_ms) {
+        if (!initialized_ || !frame) return BurstWait::Done;
+#ifdef ESP_PLATFORM
+        TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+        while (true) {
+            lock();
+            BurstWait result = poll_frame(index, frame);
+            unlock();
+            if (result != BurstWait::Timeout) return result;
+            TickType_t now = xTaskGetTickCount();
+            if (static_cast<int32_t>(deadline - now) <= 0) return BurstWait::Timeout;
+            xSemaphoreTake(frame_ready_, deadline - now);
+        }
+#else
+        std::unique_lock<std::mutex> guard(mutex_);
+        BurstWait result = BurstWait::Timeout;
+        ready_cv_.wait_for(guard, std::chrono::milliseconds(timeout_ms), [&] {
+            result = poll_frame(index, frame);
+            return result != BurstWait::Timeout;
+        });
+        return result;
+#endif
+    }
+
+    /**
+     * @brief Release the arena for the next burst
+     *
+     * Ends a burst early if it is still capturing: the producer stops at its
+     * next frame and the arena becomes free once it has.
+     */
+    void end() {
+        if (!initialized_) return;
+        lock();
+        if (state_ == State::Capturing) {
+            cancel_ = true;
+        } else if (state_ != State::Idle) {
+            if (state_ == State::Pending) stats_.cancelled++;
+            state_ = State::Idle;
+        }
+        unlock();
+    }
+
+    BurstReport report() {
+        lock();
+        BurstReport copy = report_;
+        unlock();
+        return copy;
+    }
+
+    // -------------------------------------------------------------------------
+    // Producer API
+    // -------------------------------------------------------------------------
+
+    // Cheap check for the producer loop
+    bool pending() const { return state_.load() == State::Pending; }
+
+    /**
+     * @brief Capture the pending burst (called from the producer task)
+     * @param processor Applied to every frame, as for the stream (may be nullptr)
+     * @param processor_capacity Output size the processor expects (max frame size)
+     * @param stop Producer's stop flag; ends the burst early
+     * @return Frames captured
+     */
+    uint16_t run(interfaces::ICamera& camera, interfaces::IClock& clock,
+                 interfaces::IFrameProcessor* processor, size_t processor_capacity,
+                 const std::atomic<bool>& stop) {
+        lock();
+        if (state_ != State::Pending) {
+            unlock();
+            return 0;
+        }
+        state_ = State::Capturing;
+        uint16_t count = report_.requested;
+        int64_t interval_us = static_cast<int64_t>(report_.interval_ms) * 1000;
+        unlock();
+
+        int64_t start_us = clock.now_us();
+        int64_t next_capture = start_us;
+        uint16_t captured = 0;
+        uint8_t consecutive_errors = 0;
+        uint16_t errors = 0;
+        uint16_t rejected = 0;
+        bool truncated = false;
+
+        while (captured < count && !stop.load() && !cancel_.load()) {
+            int64_t now = clock.now_us();
+            if (now < next_capture) {
+                int64_t sleep_ms = (next_capture - now) / 1000;
+                if (sleep_ms > 0) clock.delay_ms(static_cast<uint32_t>(sleep_ms));
+                continue;
+            }
+
+            auto frame = camera.capture_frame();
+            if (!frame.valid()) {
+                camera.release_frame();
+                errors++;
+                if (++consecutive_errors >= MAX_CONSECUTIVE_ERRORS) break;
+                continue;
+            }
+            consecutive_errors = 0;
+
+            // The consumer only reads below used_, so the tail is ours
+            uint8_t* dst = arena_ + used_;
+            size_t room = config_.arena_size - used_;
+            size_t size = 0;
+            if (processor) {
+                size_t capacity = room < processor_capacity ? room : processor_capacity;
+                size = capacity ? processor->process(frame, dst, capacity) : 0;
+                if (size == 0) {
+                    // Less room than a full frame may be why it failed
+                    if (capacity < processor_capacity) truncated = true;
+                    else rejected++;
+                }
+            } else if (frame.size <= room) {
+                memcpy(dst, frame.data, frame.size);
+                size = frame.size;
+            } else {
+                truncated = true;
+            }
+            int64_t timestamp_us = frame.timestamp_us ? frame.timestamp_us : clock.now_us();
+            camera.release_frame();
+            if (truncated) break;
+
+            if (size > 0) {
+                lock();
+                frames_[captured] = {dst, size, timestamp_us};
+                used_ += (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+                if (used_ > config_.arena_size) used_ = config_.arena_size;
+                record_interval(captured, timestamp_us);
+                captured++;
+                report_.frames = captured;
+                report_.arena_used = used_;
+                report_.capture_us = clock.now_us() - start_us;
+                unlock();
+                wake();
+            }
+
+            // Behind schedule (or no interval): capture again right away
+            next_capture += interval_us;
+            now = clock.now_us();
+            if (next_capture < now) next_capture = now;
+        }
+
+        lock();
+        report_.capture_errors = errors;
+        report_.frames_rejected = rejected;
+        report_.truncated = truncated;
+        stats_.bursts++;
+        stats_.frames += captured;
+        stats_.capture_errors += errors;
+        if (truncated) stats_.truncated++;
+        if (used_ > stats_.peak_arena_bytes.load()) stats_.peak_arena_bytes = used_;
+        if (cancel_) {
+            stats_.cancelled++;
+            state_ = State::Idle;
+        } else {
+            state_ = State::Done;
+        }
+        unlock();
+        wake();
+        return captured;
+    }
+
+    // -------------------------------------------------------------------------
+    // Status
+    // -------------------------------------------------------------------------
+
+    bool is_initialized() const { return initialized_; }
+    bool is_busy() const { return state_.load() != State::Idle; }
+    const BurstConfig& config() const { return config_; }
+    const BurstStats& stats() const { return stats_; }
+    void reset_stats() { stats_.reset(); }
+
+private:
+    enum class State : uint8_t { Idle, Pending, Capturing, Done };
+
+    // Under lock
+    BurstWait poll_frame(uint16_t index, BurstFrame* frame) const {
+        State state = state_.load();
+        if (state != State::Idle && index < report_.frames) {
+            *frame = frames_[index];
+            return BurstWait::Frame;
+        }
+        return state == State::Pending || state == State::Capturing ? BurstWait::Timeout
+                                                                      : BurstWait::Done;
+    }
+
+    // Under lock; index is the frame about to be committed
+    void record_interval(uint16_t index, int64_t timestamp_us) {
+        if (index == 0) return;
+        int64_t interval = timestamp_us - frames_[index - 1].timestamp_us;
+        if (index == 1 || interval < report_.interval_min_us) report_.interval_min_us = interval;
+        if (index == 1 || interval > report_.interval_max_us) report_.interval_max_us = interval;
+        report_.interval_mean_us = (timestamp_us - frames_[0].timestamp_us) / index;
+    }
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    void wake() {
+#ifdef ESP_PLATFORM
+        if (frame_ready_) xSemaphoreGive(frame_ready_);
+#else
+        // Waiters check under mutex_, so a commit can't slip between check and wait
+        ready_cv_.notify_all();
+#endif
+    }
+
+    BurstConfig config_;
+    BurstStats stats_;
+    BurstReport report_;
+
+    uint8_t* arena_ = nullptr;
+    BurstFrame* frames_ = nullptr;
+    size_t used_ = 0;
+
+    std::atomic<State> state_{State::Idle};
+    std::atomic<bool> cancel_{false};
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t mutex_ = nullptr;
+    SemaphoreHandle_t frame_ready_ = nullptr;
+#else
+    std::mutex mutex_;
+    std::condition_variable ready_cv_;
+#endif
+};
+
+} // namespace core
@@ -0,0 +1,270 @@
+/**
+ * @file camera_registry.hpp
+ * @brief Several camera pipelines behind one server, with shared budgets
+ *
+ * Design: Each registered camera gets its own StreamingService (producer,
+ * ring buffer, stats), addressed by a short id as /cam/<id>/<endpoint>.
+ * The cameras share two budgets so adding sources cannot exhaust the device:
+ * - Memory: ring buffers (slots x max frame size) must fit the registry's
+ *   byte budget, checked when a camera is added.
+ * - Producer rate: the sum of all producers' frame rates is capped. Each
+ *   camera asks for a rate; the budget is split by max-min fairness (slow
+ *   cameras get what they ask, the rest share the remainder equally).
+ *
+ * Cameras are added and removed during setup, before the server starts;
+ * lookups afterwards are read-only and need no locking.
+ */
+#pragma once
+#include "streaming_service.hpp"
+#include "../interfaces/i_camera.hpp"
+#include "../interfaces/i_clock.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace core {
+
+static constexpr size_t CAMERA_ID_MAX_LENGTH = 15;
+
+struct CameraRegistryConfig {
+    size_t memory_budget_bytes = 2 * 1024 * 1024;  // Ring memory across all cameras
+    uint32_t total_fps_budget = 30;                // Sum of producer rates
+};
+
+/**
+ * @brief Split a frame-rate budget across cameras (max-min fairness)
+ *
+ * Requests are served smallest first; each gets min(request, equal share of
+ * what is left). Every camera is granted at least 1 FPS, so the sum can only
+ * exceed the budget when budget < count (rejected by the registry).
+ */
+inline void allocate_fps(const uint8_t* requested, uint8_t* granted, size_t count,
+                         uint32_t budget) {
+    for (size_t i = 0; i < count; i++) granted[i] = 0;
+
+    uint32_t remaining = budget;
+    for (size_t left = count; left > 0; left--) {
+        size_t pick = count;
+        for (size_t i = 0; i < count; i++) {
+            if (granted[i] == 0 && (pick == count || requested[i] < requested[pick])) {
+                pick = i;
+            }
+        }
+        uint32_t want = requested[pick] ? requested[pick] : 1;
+        uint32_t share = remaining / left;
+        uint32_t grant = want < share ? want : share;
+        if (grant == 0) grant = 1;
+        granted[pick] = static_cast<uint8_t>(grant);
+        remaining -= grant < remaining ? grant : remaining;
+    }
+}
+
+/**
+ * @brief Valid camera id: 1..CAMERA_ID_MAX_LENGTH of [A-Za-z0-9_-]
+ */
+inline bool is_valid_camera_id(const char* id, size_t len) {
+    if (!id || len == 0 || len > CAMERA_ID_MAX_LENGTH) return false;
+    for (size_t i = 0; i < len; i++) {
+        char c = id[i];
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c >= '0' && c <= '9') || c == '_' || c == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Split "/cam/<id>/<endpoint>[?query]" into id and endpoint
+ * @param id Receives the NUL-terminated id (id_cap bytes)
+ * @param endpoint Receives the NUL-terminated endpoint name (endpoint_cap bytes)
+ * @return false if the path is not of that form
+ */
+inline bool parse_camera_path(const char* uri, char* id, size_t id_cap,
+                              char* endpoint, size_t endpoint_cap) {
+    static constexpr char PREFIX[] = "/cam/";
+    if (!uri || !id || !endpoint) return false;
+    if (strncmp(uri, PREFIX, sizeof(PREFIX) - 1) != 0) return false;
+
+    const char* p = uri + sizeof(PREFIX) - 1;
+    const char* slash = strchr(p, '/');
+    if (!slash) return false;
+    size_t id_len = static_cast<size_t>(slash - p);
+    if (!is_valid_camera_id(p, id_len) || id_len >= id_cap) return false;
+
+    const char* ep = slash + 1;
+    size_t ep_len = strcspn(ep, "?/");
+    if (ep_len == 0 || ep[ep_len] == '/' || ep_len >= endpoint_cap) return false;
+
+    memcpy(id, p, id_len);
+    id[id_len] = '\0';
+    memcpy(endpoint, ep, ep_len);
+    endpoint[ep_len] = '\0';
+    return true;
+}
+
+/**
+ * @brief Owns one StreamingService per camera under shared budgets
+ *
+ * Usage:
+ *   CameraRegistry cams({.memory_budget_bytes = 1 << 20, .total_fps_budget = 20});
+ *   cams.add_camera("front", front_cam, clock, {.target_fps = 10});
+ *   cams.add_camera("back", back_cam, clock, {.target_fps = 10});
+ *   cams.start_all();
+ *   StreamingService* svc = cams.find("front");
+ */
+class CameraRegistry {
+public:
+    static constexpr size_t MAX_CAMERAS = 8;
+
+    explicit CameraRegistry(const CameraRegistryConfig& config = {}) : config_(config) {}
+
+    ~CameraRegistry() {
+        while (count_ > 0) remove_at(count_ - 1);
+    }
+
+    // Non-copyable
+    CameraRegistry(const CameraRegistry&) = delete;
+    CameraRegistry& operator=(const CameraRegistry&) = delete;
+
+    /**
+     * @brief Register a camera and initialize its pipeline
+     *
+     * config.target_fps is the camera's requested rate; the producer runs at
+     * its fair share of the registry's FPS budget (see granted_fps()).
+     * @return The camera's service, or nullptr if the id is invalid or taken,
+     *         the registry is full, or either budget would be exceeded
+     */
+    StreamingService* add_camera(const char* id, interfaces::ICamera& camera,
+                                 interfaces::IClock& clock, const StreamingConfig& config = {}) {
+        if (count_ >= MAX_CAMERAS || !id) return nullptr;
+        size_t id_len = strlen(id);
+        if (!is_valid_camera_id(id, id_len) || find(id)) return nullptr;
+        if (config.target_fps == 0) return nullptr;
+
+        // Every producer needs at least 1 FPS of the shared budget
+        if (count_ + 1 > config_.total_fps_budget) return nullptr;
+        size_t ring_bytes = config.buffer_slots * config.max_frame_size;
+        if (ring_bytes > config_.memory_budget_bytes - memory_used_) return nullptr;
+
+        auto* service = new (std::nothrow) StreamingService(camera, clock);
+        if (!service) return nullptr;
+        if (!service->init(config)) {
+            delete service;
+            return nullptr;
+        }
+
+        Entry& e = entries_[count_++];
+        memcpy(e.id, id, id_len + 1);
+        e.camera = &camera;
+        e.service = service;
+        e.requested_fps = config.target_fps;
+        e.ring_bytes = ring_bytes;
+        memory_used_ += ring_bytes;
+        rebalance();
+        return service;
+    }
+
+    /**
+     * @brief Stop and free a camera's pipeline; its share goes to the others
+     */
+    bool remove_camera(const char* id) {
+        int index = index_of(id);
+        if (index < 0) return false;
+        remove_at(static_cast<size_t>(index));
+        rebalance();
+        return true;
+    }
+
+    /**
+     * @brief Change a camera's requested rate and re-split the budget
+     */
+    bool set_requested_fps(const char* id, uint8_t fps) {
+        int index = index_of(id);
+        if (index < 0 || fps == 0 || fps > StreamingService::MAX_TARGET_FPS) return false;
+        entries_[index].requested_fps = fps;
+        rebalance();
+        return true;
+    }
+
+    /**
+     * @brief Start every producer
+     * @return false if any failed to start (the others keep running)
+     */
+    bool start_all() {
+        bool ok = true;
+        for (size_t i = 0; i < count_; i++) {
+            if (!entries_[i].service->start()) ok = false;
+        }
+        return ok;
+    }
+
+    void stop_all() {
+        for (size_t i = 0; i < count_; i++) entries_[i].service->stop();
+    }
+
+    StreamingService* find(const char* id) const {
+        int index = index_of(id);
+        return index < 0 ? nullptr : entries_[index].service;
+    }
+
+    interfaces::ICamera* find_camera(const char* id) const {
+        int index = index_of(id);
+        return index < 0 ? nullptr : entries_[index].camera;
+    }
+
+    size_t count() const { return count_; }
+    const char* id_at(size_t i) const { return i < count_ ? entries_[i].id : nullptr; }
+    StreamingService* service_at(size_t i) const { return i < count_ ? entries_[i].service : nullptr; }
+    uint8_t requested_fps(size_t i) const { return i < count_ ? entries_[i].requested_fps : 0; }
+    uint8_t granted_fps(size_t i) const { return i < count_ ? entries_[i].granted_fps : 0; }
+
+    size_t memory_used() const { return memory_used_; }
+    size_t memory_budget() const { return config_.memory_budget_bytes; }
+    uint32_t fps_budget() const { return config_.total_fps_budget; }
+
+private:
+    struct Entry {
+        char id[CAMERA_ID_MAX_LENGTH + 1] = {0};
+        interfaces::ICamera* camera = nullptr;
+        StreamingService* service = nullptr;
+        uint8_t requested_fps = 0;
+        uint8_t granted_fps = 0;
+        size_t ring_bytes = 0;
+    };
+
+    int index_of(const char* id) const {
+        if (!id) return -1;
+        for (size_t i = 0; i < count_; i++) {
+            if (strcmp(entries_[i].id, id) == 0) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    void remove_at(size_t index) {
+        Entry& e = entries_[index];
+        delete e.service;   // Stops the producer and frees the ring
+        memory_used_ -= e.ring_bytes;
+        for (size_t i = index; i + 1 < count_; i++) entries_[i] = entries_[i + 1];
+        entries_[--count_] = Entry{};
+    }
+
+    // Re-split the FPS budget and retime every producer
+    void rebalance() {
+        uint8_t requested[MAX_CAMERAS];
+        uint8_t granted[MAX_CAMERAS];
+        for (size_t i = 0; i < count_; i++) requested[i] = entries_[i].requested_fps;
+        allocate_fps(requested, granted, count_, config_.total_fps_budget);
+        for (size_t i = 0; i < count_; i++) {
+            entries_[i].granted_fps = granted[i];
+            entries_[i].service->set_target_fps(granted[i]);
+        }
+    }
+
+    CameraRegistryConfig config_;
+    Entry entries_[MAX_CAMERAS];
+    size_t count_ = 0;
+    size_t memory_used_ = 0;
+};
+
+} // namespace core
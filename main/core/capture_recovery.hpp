@@ -0,0 +1,205 @@
+/**
+ * @file capture_recovery.hpp
+ * @brief Escalating recovery from capture failures: backoff, sensor reset, re-init
+ *
+ * A wedged sensor (every fb_get timing out) does not come back by retrying
+ * at the frame rate, and each retry blocks the producer for the driver's
+ * timeout. The policy escalates over consecutive failures:
+ *
+ *   failure 1, 2, 3 ...  → wait backoff_initial_ms, doubling up to backoff_max_ms
+ *   every failures_before_reset-th failure → soft reset of the sensor
+ *   after resets_before_reinit resets that did not help → full deinit/init
+ *
+ * e.g. with the defaults (50 ms, 2 s, 4, 2): retries after 50/100/200 ms,
+ * a reset at failure 4, another at 8, a re-init at 12, then resets again.
+ * The first good frame ends the episode.
+ *
+ * Stats: recovery latency (first failure of an episode to the next good
+ * frame) and MTBF (healthy time between episodes). The policy only sees
+ * the timestamps it is given, so under a mock clock it is deterministic.
+ *
+ * Cross-platform: Pure C++, no platform dependencies. Not thread-safe:
+ * driven by the producer task; stats may be read anywhere.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace core {
+
+// How far recovery has escalated (StreamingService::health())
+enum class CameraHealth : uint8_t {
+    Healthy = 0,
+    Retrying = 1,        // Backing off between captures
+    SensorReset = 2,     // Soft reset issued this episode
+    Reinitialized = 3    // Full re-init issued this episode
+};
+
+static constexpr const char* CAMERA_HEALTH_NAMES[] = {
+    "healthy", "retrying", "sensor_reset", "reinitialized"
+};
+
+inline const char* camera_health_name(CameraHealth health) {
+    return CAMERA_HEALTH_NAMES[static_cast<uint8_t>(health) & 3];
+}
+
+enum class RecoveryAction : uint8_t {
+    Retry = 0,        // Wait delay_ms, capture again
+    ResetSensor = 1,  // Soft-reset the sensor, then wait
+    Reinit = 2        // deinit() + init() the camera, then wait
+};
+
+struct RecoveryStep {
+    RecoveryAction action = RecoveryAction::Retry;
+    uint32_t delay_ms = 0;     // Before the next capture attempt
+};
+
+struct CaptureRecoveryConfig {
+    uint32_t backoff_initial_ms = 50;   // Wait after the first failure
+    uint32_t backoff_max_ms = 2000;     // Cap of the doubling wait
+    uint8_t failures_before_reset = 4;  // Consecutive failures per escalation (0 = never escalate)
+    uint8_t resets_before_reinit = 2;   // Resets that did not help before a re-init (0 = re-init only)
+};
+
+/**
+ * @brief Statistics (thread-safe reads)
+ */
+struct CaptureRecoveryStats {
+    std::atomic<uint32_t> episodes{0};           // Runs of consecutive failures
+    std::atomic<uint32_t> recoveries{0};         // Episodes ended by a good frame
+    std::atomic<uint32_t> consecutive_failures{0};
+    std::atomic<uint32_t> sensor_resets{0};
+    std::atomic<uint32_t> reinits{0};
+    std::atomic<uint32_t> action_failures{0};    // Resets/re-inits the camera refused
+    std::atomic<uint32_t> recovery_us_last{0};
+    std::atomic<uint32_t> recovery_us_max{0};
+    std::atomic<uint64_t> recovery_us_total{0};
+    std::atomic<uint64_t> healthy_us_total{0};   // Healthy time before each episode
+    std::atomic<uint8_t> health{0};              // CameraHealth
+
+    uint32_t recovery_us_mean() const {
+        uint32_t n = recoveries.load();
+        return n ? static_cast<uint32_t>(recovery_us_total.load() / n) : 0;
+    }
+
+    // Mean healthy time between failure episodes (0 before the first one)
+    uint64_t mtbf_us() const {
+        uint32_t n = episodes.load();
+        return n ? healthy_us_total.load() / n : 0;
+    }
+
+    void reset() {
+        episodes = 0;
+        recoveries = 0;
+        consecutive_failures = 0;
+        sensor_resets = 0;
+        reinits = 0;
+        action_failures = 0;
+        recovery_us_last = 0;
+        recovery_us_max = 0;
+        recovery_us_total = 0;
+        healthy_us_total = 0;
+        health = 0;
+    }
+};
+
+/**
+ * @brief Escalation state machine over capture outcomes
+ *
+ * Usage (producer):
+ *   policy.start(now);
+ *   if (frame.valid()) policy.on_success(now);
+ *   else { RecoveryStep step = policy.on_failure(now); ... act, wait step.delay_ms }
+ */
+class CaptureRecoveryPolicy {
+public:
+    explicit CaptureRecoveryPolicy(const CaptureRecoveryConfig& config = {}) : config_(config) {}
+
+    void set_config(const CaptureRecoveryConfig& config) { config_ = config; }
+    const CaptureRecoveryConfig& config() const { return config_; }
+
+    /**
+     * @brief Begin a healthy period (producer start)
+     */
+    void start(int64_t now_us) {
+        stats_.reset();
+        healthy_since_us_ = now_us;
+        episode_start_us_ = 0;
+        consecutive_ = 0;
+        resets_ = 0;
+    }
+
+    /**
+     * @brief A capture failed
+     * @return What to do before the next attempt
+     */
+    RecoveryStep on_failure(int64_t now_us) {
+        if (consecutive_ == 0) {
+            episode_start_us_ = now_us;
+            resets_ = 0;
+            stats_.episodes++;
+            if (now_us > healthy_since_us_) stats_.healthy_us_total += static_cast<uint64_t>(now_us - healthy_since_us_);
+            set_health(CameraHealth::Retrying);
+        }
+        consecutive_++;
+        stats_.consecutive_failures = consecutive_;
+
+        RecoveryStep step;
+        uint32_t shift = consecutive_ - 1 < 31 ? consecutive_ - 1 : 31;
+        uint64_t delay = static_cast<uint64_t>(config_.backoff_initial_ms) << shift;
+        step.delay_ms = delay > config_.backoff_max_ms ? config_.backoff_max_ms : static_cast<uint32_t>(delay);
+
+        if (config_.failures_before_reset && consecutive_ % config_.failures_before_reset == 0) {
+            if (resets_ < config_.resets_before_reinit) {
+                resets_++;
+                step.action = RecoveryAction::ResetSensor;
+                stats_.sensor_resets++;
+                if (health() < CameraHealth::SensorReset) set_health(CameraHealth::SensorReset);
+            } else {
+                resets_ = 0;
+                step.action = RecoveryAction::Reinit;
+                stats_.reinits++;
+                set_health(CameraHealth::Reinitialized);
+            }
+        }
+        return step;
+    }
+
+    /**
+     * @brief A capture succeeded
+     * @return true if this ended a failure episode (health changed to Healthy)
+     */
+    bool on_success(int64_t now_us) {
+        if (consecutive_ == 0) return false;
+        int64_t elapsed = now_us - episode_start_us_;
+        uint32_t latency = elapsed > 0 ? (elapsed < UINT32_MAX ? static_cast<uint32_t>(elapsed) : UINT32_MAX) : 0;
+        stats_.recoveries++;
+        stats_.recovery_us_last = latency;
+        stats_.recovery_us_total += latency;
+        if (latency > stats_.recovery_us_max.load()) stats_.recovery_us_max = latency;
+        consecutive_ = 0;
+        stats_.consecutive_failures = 0;
+        healthy_since_us_ = now_us;
+        set_health(CameraHealth::Healthy);
+        return true;
+    }
+
+    // The camera refused a reset or re-init (the next escalation tries again)
+    void on_action_failed() { stats_.action_failures++; }
+
+    CameraHealth health() const { return static_cast<CameraHealth>(stats_.health.load()); }
+    bool healthy() const { return consecutive_ == 0; }
+    const CaptureRecoveryStats& stats() const { return stats_; }
+
+private:
+    void set_health(CameraHealth health) { stats_.health = static_cast<uint8_t>(health); }
+
+    CaptureRecoveryConfig config_;
+    CaptureRecoveryStats stats_;
+    int64_t healthy_since_us_ = 0;
+    int64_t episode_start_us_ = 0;
+    uint32_t consecutive_ = 0;
+    uint8_t resets_ = 0;      // Resets since the last re-init, this episode
+};
+
+} // namespace core
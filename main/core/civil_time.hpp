@@ -0,0 +1,32 @@
+/**
+ * @file civil_time.hpp
+ * @brief Calendar date from a day count, without the C library's time zone state
+ *
+ * Shared by the overlay timestamp and the ZIP entry times.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include <cstdint>
+
+namespace core {
+
+/**
+ * @brief Civil date from days since 1970-01-01 (proleptic Gregorian, H. Hinnant)
+ * @param y Output: year
+ * @param m Output: month, 1-12
+ * @param d Output: day of the month, 1-31
+ */
+inline void civil_from_days(int64_t days, int64_t* y, int64_t* m, int64_t* d) {
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = yoe + era * 400 + (*m <= 2 ? 1 : 0);
+}
+
+} // namespace core
@@ -0,0 +1,49 @@
+/**
+ * @file crc32.hpp
+ * @brief CRC-32 (IEEE 802.3, as used by zlib/ZIP/PNG)
+ *
+ * Table-driven, one byte per step; the 1 KB table is built at compile time
+ * and lives in flash.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace core {
+
+namespace detail {
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    constexpr Crc32Table() : entries() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+inline constexpr Crc32Table CRC32_TABLE{};
+
+} // namespace detail
+
+/**
+ * @brief Continue a CRC over more data
+ * @param crc Result of a previous call (0 to start)
+ */
+inline uint32_t crc32_update(uint32_t crc, const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = detail::CRC32_TABLE.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline uint32_t crc32(const void* data, size_t size) { return crc32_update(0, data, size); }
+
+} // namespace core
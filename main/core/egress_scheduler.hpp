@@ -0,0 +1,390 @@
+/**
+ * @file egress_scheduler.hpp
+ * @brief Priority classes for frame consumers sharing the link
+ *
+ * When the link is short every consumer used to lose frames alike, so a
+ * dashboard thumbnail viewer could make the recording uploader fall
+ * behind. Each network consumer of StreamingService is tagged with a class:
+ *
+ *   Recorder   frame uploader, recording clients  (highest)
+ *   Operator   live viewers (the default for streams)
+ *   Dashboard  thumbnails, wall displays          (lowest)
+ *
+ * and asks the scheduler before each frame goes out:
+ *
+ *   offer(class, bytes) ── demand meter ──┐
+ *                                         ├→ egress_allocate() → per-class rate
+ *   capacity (link estimate × share) ─────┘          │
+ *                          per-class token bucket ←──┘ → send / skip this frame
+ *
+ * Demand is what a class offered over the last EgressMeter window (skipped
+ * frames included). Every bucket interval the capacity is split by policy:
+ * - Strict: classes in priority order take all they ask for until the
+ *   capacity runs out, so the lowest classes are the first to lose frames.
+ * - Weighted: max-min fair by weight; a class asking for less than its
+ *   share gets it all and the rest is split among the others.
+ * Capacity no class claims is open to every class, so a consumer that has
+ * just started is not held back until its demand shows in the window.
+ *
+ * A skipped frame is the degradation: the consumer moves on to a newer one.
+ * Senders that cannot skip (the uploader resends until acknowledged)
+ * charge() what they sent instead; it counts as demand and delivery, so it
+ * still takes its share from the classes below.
+ *
+ * Per-class offered/delivered counts give the delivery ratio for /egress.
+ * Capacity 0 turns scheduling off (every frame goes, counts are still kept).
+ */
+#pragma once
+#include "stream_admission.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace core {
+
+enum class ConsumerClass : uint8_t {
+    Recorder = 0,
+    Operator = 1,
+    Dashboard = 2
+};
+
+constexpr size_t NUM_CONSUMER_CLASSES = 3;
+
+inline const char* consumer_class_name(ConsumerClass cls) {
+    switch (cls) {
+        case ConsumerClass::Recorder: return "recorder";
+        case ConsumerClass::Operator: return "operator";
+        case ConsumerClass::Dashboard: return "dashboard";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Parse a class name as in ?class=
+ * @return false if it names no class
+ */
+inline bool parse_consumer_class(const char* text, ConsumerClass* out) {
+    for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) {
+        auto cls = static_cast<ConsumerClass>(i);
+        if (strcmp(text, consumer_class_name(cls)) == 0) {
+            *out = cls;
+            return true;
+        }
+    }
+    return false;
+}
+
+enum class EgressPolicy : uint8_t {
+    Strict,     // Higher classes first
+    Weighted    // Max-min fair by weight
+};
+
+inline const char* egress_policy_name(EgressPolicy policy) {
+    return policy == EgressPolicy::Weighted ? "weighted" : "strict";
+}
+
+struct EgressSchedulerConfig {
+    EgressPolicy policy = EgressPolicy::Strict;
+    uint8_t weights[NUM_CONSUMER_CLASSES] = {6, 3, 1};   // Weighted: shares under contention
+    uint32_t burst_ms = 250;                              // Unused rate a class may bank
+};
+
+/**
+ * @brief Split capacity between classes by policy
+ * @param demand Bytes/s each class asks for
+ * @param alloc Bytes/s each class gets (sums to at most capacity_Bps)
+ */
+inline void egress_allocate(const EgressSchedulerConfig& config, uint32_t capacity_Bps,
+                            const uint32_t demand[NUM_CONSUMER_CLASSES],
+                            uint32_t alloc[NUM_CONSUMER_CLASSES]) {
+    uint64_t left = capacity_Bps;
+    if (config.policy == EgressPolicy::Strict) {
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) {
+            alloc[i] = static_cast<uint32_t>(demand[i] < left ? demand[i] : left);
+            left -= alloc[i];
+        }
+        return;
+    }
+
+    // Water-filling: satisfy every class asking for no more than its share
+    // of what is left, then split the rest by weight among the others
+    bool open[NUM_CONSUMER_CLASSES];
+    for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) {
+        alloc[i] = 0;
+        open[i] = demand[i] > 0;
+    }
+    for (;;) {
+        uint64_t weight_sum = 0;
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) {
+            if (open[i]) weight_sum += config.weights[i] ? config.weights[i] : 1;
+        }
+        if (weight_sum == 0) return;
+
+        uint64_t satisfied = 0;
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) {
+            if (!open[i]) continue;
+            uint64_t share = left * (config.weights[i] ? config.weights[i] : 1) / weight_sum;
+            if (demand[i] <= share) {
+                alloc[i] = demand[i];
+                satisfied += demand[i];
+                open[i] = false;
+            }
+        }
+        if (satisfied == 0) {
+            for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) {
+                if (open[i]) {
+                    alloc[i] = static_cast<uint32_t>(
+                        left * (config.weights[i] ? config.weights[i] : 1) / weight_sum);
+                }
+            }
+            return;
+        }
+        left -= satisfied;
+    }
+}
+
+/**
+ * @brief One class's counters (thread-safe reads)
+ */
+struct EgressClassStats {
+    std::atomic<uint32_t> offered{0};       // Frames asked for (charged ones included)
+    std::atomic<uint32_t> delivered{0};
+    std::atomic<uint32_t> skipped{0};       // Over the class's rate
+    std::atomic<uint64_t> bytes_delivered{0};
+    std::atomic<uint32_t> demand_Bps{0};    // At the last allocation
+    std::atomic<uint32_t> alloc_Bps{0};
+
+    // Delivered per thousand offered (1000 before any offer)
+    uint32_t delivery_permille() const {
+        uint32_t n = offered.load();
+        return n ? static_cast<uint32_t>(static_cast<uint64_t>(delivered.load()) * 1000 / n) : 1000;
+    }
+
+    void reset() {
+        offered = 0;
+        delivered = 0;
+        skipped = 0;
+        bytes_delivered = 0;
+        demand_Bps = 0;
+        alloc_Bps = 0;
+    }
+};
+
+struct EgressSchedulerStats {
+    EgressClassStats classes[NUM_CONSUMER_CLASSES];
+    std::atomic<uint32_t> capacity_Bps{0};
+    std::atomic<uint32_t> spare_Bps{0};        // Unclaimed at the last allocation
+    std::atomic<uint32_t> allocations{0};
+
+    const EgressClassStats& of(ConsumerClass cls) const { return classes[static_cast<size_t>(cls)]; }
+
+    void reset() {
+        for (auto& c : classes) c.reset();
+        spare_Bps = 0;
+        allocations = 0;
+    }
+};
+
+/**
+ * @brief Per-class rates over a shared capacity
+ *
+ * Usage:
+ *   scheduler.set_capacity_Bps(link_estimate * share);
+ *   if (scheduler.offer(ConsumerClass::Dashboard, part_bytes, now_us)) send it;
+ *   else skip to a newer frame
+ *
+ * Thread-safe: stream workers and the uploader task share one scheduler.
+ */
+class EgressScheduler {
+public:
+    EgressScheduler() = default;
+
+    // Non-copyable
+    EgressScheduler(const EgressScheduler&) = delete;
+    EgressScheduler& operator=(const EgressScheduler&) = delete;
+
+    void set_config(const EgressSchedulerConfig& config) {
+        lock();
+        config_ = config;
+        alloc_epoch_ = -1;
+        unlock();
+    }
+
+    const EgressSchedulerConfig& config() const { return config_; }
+
+    /**
+     * @brief Bytes/s the classes share (0 = unlimited)
+     */
+    void set_capacity_Bps(uint32_t capacity_Bps) {
+        if (stats_.capacity_Bps.exchange(capacity_Bps) != capacity_Bps) {
+            lock();
+            alloc_epoch_ = -1;   // Reallocate on the next offer
+            unlock();
+        }
+    }
+
+    uint32_t capacity_Bps() const { return stats_.capacity_Bps.load(); }
+
+    /**
+     * @brief May this frame go out now?
+     * @param bytes Bytes it will take on the link
+     * @return false = over the class's rate: skip it
+     */
+    bool offer(ConsumerClass cls, size_t bytes, int64_t now_us) {
+        size_t c = static_cast<size_t>(cls);
+        offered_[c].on_frame(bytes, 0, now_us);
+        stats_.classes[c].offered++;
+        allocate(now_us);
+
+        bool send = true;
+        if (stats_.capacity_Bps.load() > 0) {
+            lock();
+            refill(c, now_us);
+            send = tokens_[c] >= 0;   // A frame may overdraw; the debt delays the next
+            if (send) tokens_[c] -= static_cast<int64_t>(bytes) * US_PER_S;
+            unlock();
+        }
+        if (send) {
+            delivered_[c].on_frame(bytes, 0, now_us);
+            stats_.classes[c].delivered++;
+            stats_.classes[c].bytes_delivered += bytes;
+        } else {
+            stats_.classes[c].skipped++;
+        }
+        return send;
+    }
+
+    /**
+     * @brief Record frames sent without asking (they cannot be skipped)
+     */
+    void charge(ConsumerClass cls, size_t bytes, uint32_t frames, int64_t now_us) {
+        size_t c = static_cast<size_t>(cls);
+        offered_[c].on_frame(bytes, 0, now_us);
+        delivered_[c].on_frame(bytes, 0, now_us);
+        stats_.classes[c].offered += frames;
+        stats_.classes[c].delivered += frames;
+        stats_.classes[c].bytes_delivered += bytes;
+        allocate(now_us);
+        if (stats_.capacity_Bps.load() > 0) {
+            lock();
+            refill(c, now_us);
+            tokens_[c] -= static_cast<int64_t>(bytes) * US_PER_S;
+            unlock();
+        }
+    }
+
+    /**
+     * @brief Delivered bytes/s of this class and every class above it
+     */
+    uint32_t delivered_Bps(ConsumerClass through, int64_t now_us) const {
+        uint32_t total = 0;
+        for (size_t i = 0; i <= static_cast<size_t>(through); i++) total += delivered_[i].throughput_Bps(now_us);
+        return total;
+    }
+
+    const EgressSchedulerStats& stats() const { return stats_; }
+    void reset_stats() { stats_.reset(); }
+
+private:
+    static constexpr int64_t US_PER_S = 1000 * 1000;
+
+    // Re-split the capacity once per meter bucket (the demand changes no faster)
+    void allocate(int64_t now_us) {
+        int64_t epoch = now_us / EgressMeter::BUCKET_US;
+        lock();
+        bool due = epoch != alloc_epoch_;
+        unlock();
+        if (!due) return;
+
+        uint32_t demand[NUM_CONSUMER_CLASSES];
+        uint32_t alloc[NUM_CONSUMER_CLASSES];
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) demand[i] = offered_[i].throughput_Bps(now_us);
+        uint32_t capacity = stats_.capacity_Bps.load();
+
+        lock();
+        if (epoch == alloc_epoch_) {   // Another consumer got here first
+            unlock();
+            return;
+        }
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) refill(i, now_us);   // At the old rates
+        egress_allocate(config_, capacity, demand, alloc);
+        uint64_t claimed = 0;
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) claimed += alloc[i];
+        uint32_t spare = capacity > claimed ? static_cast<uint32_t>(capacity - claimed) : 0;
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) rate_[i] = alloc[i] + spare;
+        alloc_epoch_ = epoch;
+        unlock();
+
+        for (size_t i = 0; i < NUM_CONSUMER_CLASSES; i++) {
+            stats_.classes[i].demand_Bps = demand[i];
+            stats_.classes[i].alloc_Bps = alloc[i];
+        }
+        stats_.spare_Bps = spare;
+        stats_.allocations++;
+    }
+
+    // Token bucket in bytes x 1e6 (as RtpPacer), capped at burst_ms of the rate
+    void refill(size_t c, int64_t now_us) {
+        if (now_us > last_refill_us_[c]) {
+            if (last_refill_us_[c] != INT64_MIN) {
+                tokens_[c] += (now_us - last_refill_us_[c]) * static_cast<int64_t>(rate_[c]);
+                int64_t cap = static_cast<int64_t>(rate_[c]) * config_.burst_ms * 1000;
+                if (tokens_[c] > cap) tokens_[c] = cap;
+            }
+            last_refill_us_[c] = now_us;
+        }
+    }
+
+#ifdef ESP_PLATFORM
+    void lock() const { taskENTER_CRITICAL(&lock_); }
+    void unlock() const { taskEXIT_CRITICAL(&lock_); }
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+    void lock() const { mutex_.lock(); }
+    void unlock() const { mutex_.unlock(); }
+    mutable std::mutex mutex_;
+#endif
+
+    EgressSchedulerConfig config_;
+    EgressSchedulerStats stats_;
+    EgressMeter offered_[NUM_CONSUMER_CLASSES];     // Demand
+    EgressMeter delivered_[NUM_CONSUMER_CLASSES];
+    uint32_t rate_[NUM_CONSUMER_CLASSES] = {};      // Allocation plus spare
+    int64_t tokens_[NUM_CONSUMER_CLASSES] = {};
+    int64_t last_refill_us_[NUM_CONSUMER_CLASSES] = {INT64_MIN, INT64_MIN, INT64_MIN};
+    int64_t alloc_epoch_ = -1;
+};
+
+/**
+ * @brief Format scheduler stats as JSON for /egress
+ * @return Length written, or 0 if buf is too small
+ */
+inline size_t format_egress_json(const EgressSchedulerStats& s, EgressPolicy policy, char* buf, size_t cap) {
+    int len = snprintf(buf, cap, "{\"policy\":\"%s\",\"capacity_Bps\":%lu,\"spare_Bps\":%lu,\"classes\":{",
+                       egress_policy_name(policy), static_cast<unsigned long>(s.capacity_Bps.load()),
+                       static_cast<unsigned long>(s.spare_Bps.load()));
+    for (size_t i = 0; i < NUM_CONSUMER_CLASSES && len > 0 && static_cast<size_t>(len) < cap; i++) {
+        const EgressClassStats& c = s.classes[i];
+        int n = snprintf(buf + len, cap - len,
+            "%s\"%s\":{\"offered\":%lu,\"delivered\":%lu,\"skipped\":%lu,\"delivery_permille\":%lu,"
+            "\"bytes_delivered\":%llu,\"demand_Bps\":%lu,\"alloc_Bps\":%lu}",
+            i ? "," : "", consumer_class_name(static_cast<ConsumerClass>(i)),
+            static_cast<unsigned long>(c.offered.load()),
+            static_cast<unsigned long>(c.delivered.load()),
+            static_cast<unsigned long>(c.skipped.load()),
+            static_cast<unsigned long>(c.delivery_permille()),
+            static_cast<unsigned long long>(c.bytes_delivered.load()),
+            static_cast<unsigned long>(c.demand_Bps.load()),
+            static_cast<unsigned long>(c.alloc_Bps.load()));
+        if (n < 0) return 0;
+        len += n;
+    }
+    if (len <= 0 || static_cast<size_t>(len) >= cap) return 0;
+    int n = snprintf(buf + len, cap - len, "}}");
+    if (n < 0 || static_cast<size_t>(len + n) >= cap) return 0;
+    return static_cast<size_t>(len + n);
+}
+
+} // namespace core
@@ -0,0 +1,270 @@
+/**
+ * @file exposure_controller.hpp
+ * @brief Closed-loop exposure and gain from frame luminance statistics
+ *
+ * Architecture:
+ *   [QualityMonitor] → metrics callback → update() → ICamera::set_exposure()
+ *   (DC-domain block luma: mean, clipped share)
+ *
+ * The sensor's AEC meters its own window and steps slowly, and without a
+ * banding filter it hunts under mains lighting. This controller takes the
+ * sensor to manual exposure and closes the loop on what is actually
+ * streamed:
+ *   - error: mean block luma against target_luma, with a deadband of
+ *     tolerance levels so it does not chase noise; when more than
+ *     max_clipped_pct of the blocks are clipped, exposure comes down even
+ *     if the mean is on target (highlights cannot be recovered later)
+ *   - correction: the exposure ratio that would reach the target (luma is
+ *     about exposure^(1/2.2) after the sensor's gamma), damped in the log
+ *     domain to damping_pct of it and limited to max_step_pct per update.
+ *     A reversal of direction halves the damping (an overshoot means the
+ *     loop is too hot for this scene); steps in the same direction restore it
+ *   - split: exposure first, up to max_exposure_us (motion blur) or one
+ *     frame; then gain, up to max_gain_x16 (noise). With anti-flicker,
+ *     exposure is held to whole light periods whenever it is at least one,
+ *     so every frame integrates the same amount of light
+ *   - settling: samples from the settle_frames frames after a change are
+ *     ignored, as they were exposed with the old setting
+ *
+ * Cross-platform: Pure C++, no platform dependencies. Not thread-safe:
+ * call update() from one task (the quality task via on_metrics()).
+ */
+#pragma once
+#include "../interfaces/i_camera.hpp"
+#include "image_quality.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace core {
+
+using interfaces::AntiFlicker;
+using interfaces::ExposureLimits;
+using interfaces::ExposureSettings;
+
+// Light period for an anti-flicker setting (lights flicker at twice the mains frequency)
+constexpr uint32_t flicker_period_us(AntiFlicker anti_flicker) {
+    return anti_flicker == AntiFlicker::Hz50 ? 10000
+         : anti_flicker == AntiFlicker::Hz60 ? 8333
+         : 0;
+}
+
+struct ExposureControllerConfig {
+    uint8_t target_luma = 110;        // Mean block luma to hold
+    uint8_t tolerance = 8;            // No change within target +/- tolerance
+    uint8_t max_clipped_pct = 5;      // Clipped blocks tolerated before exposure comes down
+    uint8_t damping_pct = 60;         // Share of the (log-domain) correction applied per update
+    uint16_t max_step_pct = 100;      // Largest change per update (100 = x2 or /2)
+    uint32_t max_exposure_us = 0;     // Motion blur limit (0 = sensor limit, about one frame)
+    uint16_t max_gain_x16 = 0;        // Noise limit (0 = sensor limit)
+    uint8_t settle_frames = 2;        // Frames exposed with the old setting after a change
+    AntiFlicker anti_flicker = AntiFlicker::Off;
+};
+
+/**
+ * @brief Statistics (thread-safe reads)
+ */
+struct ExposureControllerStats {
+    std::atomic<uint32_t> samples{0};
+    std::atomic<uint32_t> samples_settling{0};   // Ignored: exposed before the last change
+    std::atomic<uint32_t> adjustments{0};
+    std::atomic<uint32_t> reversals{0};          // Direction changes (damping halved)
+    std::atomic<uint32_t> apply_errors{0};
+    std::atomic<uint32_t> exposure_us{0};
+    std::atomic<uint16_t> gain_x16{0};
+    std::atomic<uint8_t> mean_luma{0};
+    std::atomic<bool> converged{false};          // Last sample within the deadband
+    std::atomic<bool> limited{false};            // Wanted more or less than the limits allow
+
+    void reset() {
+        samples = 0;
+        samples_settling = 0;
+        adjustments = 0;
+        reversals = 0;
+        apply_errors = 0;
+        exposure_us = 0;
+        gain_x16 = 0;
+        mean_luma = 0;
+        converged = false;
+        limited = false;
+    }
+};
+
+/**
+ * @brief Damped exposure/gain loop driving an ICamera
+ *
+ * Usage:
+ *   core::ExposureController exposure;
+ *   exposure.init(&camera, config);        // Sensor AEC off, from its current point
+ *   quality.set_metrics_callback(core::ExposureController::on_metrics, &exposure);
+ *   ...
+ *   exposure.deinit();                     // Back to the sensor's AEC
+ */
+class ExposureController {
+public:
+    ExposureController() = default;
+    ~ExposureController() { deinit(); }
+
+    // Non-copyable
+    ExposureController(const ExposureController&) = delete;
+    ExposureController& operator=(const ExposureController&) = delete;
+
+    /**
+     * @brief Take the camera to manual exposure, starting where its AEC left off
+     * @return false if the camera rejects manual exposure
+     */
+    bool init(interfaces::ICamera* camera, const ExposureControllerConfig& config) {
+        if (initialized_) return true;
+        if (!camera || config.target_luma == 0) return false;
+        camera_ = camera;
+        config_ = config;
+        limits_ = camera->get_exposure_limits();
+        if (limits_.max_exposure_us == 0 || limits_.min_gain_x16 == 0) return false;
+
+        ExposureSettings current = camera->get_exposure();
+        settings_ = split(static_cast<float>(current.exposure_us) * current.gain_x16 / 16.0f);
+        if (!camera->set_exposure(settings_)) return false;
+
+        stats_.reset();
+        stats_.exposure_us = settings_.exposure_us;
+        stats_.gain_x16 = settings_.gain_x16;
+        damping_scale_ = 1.0f;
+        direction_ = 0;
+        have_change_ = false;
+        initialized_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Hand exposure back to the sensor's AEC (with its banding filter)
+     */
+    void deinit() {
+        if (!initialized_) return;
+        ExposureSettings automatic = settings_;
+        automatic.auto_exposure = true;
+        camera_->set_exposure(automatic);
+        camera_ = nullptr;
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Feed one frame's statistics
+     * @param sequence Stream sequence number of the frame they came from
+     * @return true if new settings were applied
+     */
+    bool update(const ImageQualityMetrics& metrics, uint32_t sequence) {
+        if (!initialized_ || metrics.blocks == 0) return false;
+        stats_.samples++;
+        stats_.mean_luma = metrics.mean_luma;
+        if (have_change_ && static_cast<int32_t>(sequence - settled_sequence_) < 0) {
+            stats_.samples_settling++;
+            return false;
+        }
+
+        float target = config_.target_luma;
+        float measured = metrics.mean_luma ? metrics.mean_luma : 1.0f;
+        bool clipped = metrics.bright_pct > config_.max_clipped_pct;
+        bool in_range = std::fabs(measured - target) <= config_.tolerance;
+        stats_.converged = in_range && !clipped;
+        if (stats_.converged.load()) {
+            stats_.limited = false;
+            return false;
+        }
+
+        // Log-domain correction toward the target; clipped highlights always pull down
+        float correction = std::log(target / measured) * GAMMA;
+        if (clipped && correction > CLIPPED_CORRECTION) correction = CLIPPED_CORRECTION;
+        int8_t direction = correction > 0 ? 1 : -1;
+        if (direction_ && direction != direction_) {
+            stats_.reversals++;
+            damping_scale_ = std::fmax(damping_scale_ * 0.5f, MIN_DAMPING_SCALE);
+        } else {
+            damping_scale_ = std::fmin(damping_scale_ * 2.0f, 1.0f);
+        }
+        direction_ = direction;
+
+        correction *= config_.damping_pct / 100.0f * damping_scale_;
+        float max_step = std::log(1.0f + config_.max_step_pct / 100.0f);
+        if (correction > max_step) correction = max_step;
+        if (correction < -max_step) correction = -max_step;
+
+        float total = static_cast<float>(settings_.exposure_us) * settings_.gain_x16 / 16.0f;
+        ExposureSettings next = split(total * std::exp(correction));
+        if (next.exposure_us == settings_.exposure_us && next.gain_x16 == settings_.gain_x16) {
+            stats_.limited = true;
+            return false;
+        }
+        stats_.limited = false;
+        if (!camera_->set_exposure(next)) {
+            stats_.apply_errors++;
+            return false;
+        }
+        settings_ = next;
+        settled_sequence_ = sequence + 1 + config_.settle_frames;
+        have_change_ = true;
+        stats_.adjustments++;
+        stats_.exposure_us = next.exposure_us;
+        stats_.gain_x16 = next.gain_x16;
+        return true;
+    }
+
+    // QualityMetricsCallback adapter (context = ExposureController*)
+    static void on_metrics(void* context, const ImageQualityMetrics& metrics, uint32_t sequence) {
+        static_cast<ExposureController*>(context)->update(metrics, sequence);
+    }
+
+    /**
+     * @brief Exposure and gain for a total (exposure x gain, in 1x microseconds)
+     *
+     * Exposure first, then gain; with anti-flicker, exposure is rounded
+     * down to whole light periods when it reaches one and gain makes up
+     * the difference.
+     */
+    ExposureSettings split(float total_us) const {
+        uint32_t max_exposure = limits_.max_exposure_us;
+        if (config_.max_exposure_us && config_.max_exposure_us < max_exposure) max_exposure = config_.max_exposure_us;
+        uint16_t max_gain = limits_.max_gain_x16;
+        if (config_.max_gain_x16 && config_.max_gain_x16 < max_gain) max_gain = config_.max_gain_x16;
+        if (max_gain < limits_.min_gain_x16) max_gain = limits_.min_gain_x16;
+
+        ExposureSettings s;
+        s.auto_exposure = false;
+        s.anti_flicker = config_.anti_flicker;
+        float exposure = std::fmin(std::fmax(total_us, static_cast<float>(limits_.min_exposure_us)),
+                                   static_cast<float>(max_exposure));
+        s.exposure_us = static_cast<uint32_t>(exposure);
+        uint32_t period = flicker_period_us(config_.anti_flicker);
+        if (period && s.exposure_us >= period) s.exposure_us = s.exposure_us / period * period;
+        if (s.exposure_us == 0) s.exposure_us = 1;
+
+        float gain = total_us * 16.0f / s.exposure_us;
+        gain = std::fmin(std::fmax(gain + 0.5f, static_cast<float>(limits_.min_gain_x16)),
+                         static_cast<float>(max_gain));
+        s.gain_x16 = static_cast<uint16_t>(gain);
+        return s;
+    }
+
+    const ExposureSettings& settings() const { return settings_; }
+    const ExposureLimits& limits() const { return limits_; }
+    const ExposureControllerStats& stats() const { return stats_; }
+    const ExposureControllerConfig& config() const { return config_; }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    static constexpr float GAMMA = 2.2f;                 // Sensor output gamma
+    static constexpr float CLIPPED_CORRECTION = -0.2f;   // At least -18% when highlights clip
+    static constexpr float MIN_DAMPING_SCALE = 0.125f;
+
+    interfaces::ICamera* camera_ = nullptr;
+    ExposureControllerConfig config_;
+    ExposureLimits limits_;
+    ExposureSettings settings_;
+    ExposureControllerStats stats_;
+    float damping_scale_ = 1.0f;       // Halved on each reversal
+    int8_t direction_ = 0;             // Sign of the last correction
+    uint32_t settled_sequence_ = 0;    // First frame exposed with settings_
+    bool have_change_ = false;
+    bool initialized_ = false;
+};
+
+} // namespace core
@@ -0,0 +1,360 @@
+/**
+ * @file flash_recorder.hpp
+ * @brief Continuous recording of the live stream into a SegmentStore
+ *
+ * Architecture:
+ *   [Producer] → on_frame() → [pending] ⇄ [writing] → [Recorder Task] → SegmentStore
+ *                                                        (idle: service() erases ahead)
+ *
+ * Flash programs at a few hundred KB/s and erases a 64 KB segment in
+ * hundreds of milliseconds, so the producer must never wait on it: frames
+ * are thinned to frame_interval (by frame timestamp, before any copy) and
+ * handed over latest-wins. The task erases spare segments whenever it has
+ * nothing to write, keeping erases off the append path.
+ *
+ * An optional RecordingCatalog indexes each stored frame (clips, motion,
+ * thumbnails) on the recorder task, off the producer's path.
+ *
+ * Store timestamps are frame timestamps plus a clock offset (set once the
+ * wall-clock time is known). Frame timestamps restart at boot, so if a
+ * frame would land before the newest stored record the offset is raised
+ * to keep the log's time axis monotonic.
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::thread on host.
+ */
+#pragma once
+#include "../interfaces/i_frame_sink.hpp"
+#include "segment_store.hpp"
+#include "recording_catalog.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+namespace core {
+
+struct FlashRecorderConfig {
+    size_t max_frame_size = 100 * 1024;   // Larger frames are skipped
+    uint32_t frame_interval_ms = 1000;    // Minimum spacing of recorded frames (0 = all)
+};
+
+struct FlashRecorderStats {
+    std::atomic<uint32_t> frames_offered{0};
+    std::atomic<uint32_t> frames_recorded{0};
+    std::atomic<uint32_t> frames_thinned{0};      // Within frame_interval of the last one
+    std::atomic<uint32_t> frames_superseded{0};   // Replaced before the task got to them
+    std::atomic<uint32_t> frames_rejected{0};     // Larger than max_frame_size
+    std::atomic<uint32_t> write_errors{0};
+    std::atomic<uint32_t> erases_ahead{0};
+    std::atomic<bool> running{false};
+
+    void reset() {
+        frames_offered = 0;
+        frames_recorded = 0;
+        frames_thinned = 0;
+        frames_superseded = 0;
+        frames_rejected = 0;
+        write_errors = 0;
+        erases_ahead = 0;
+    }
+};
+
+/**
+ * @brief IFrameSink appending thinned live frames to a SegmentStore
+ *
+ * Usage:
+ *   FlashRecorder recorder(store);
+ *   recorder.init(config);
+ *   recorder.set_catalog(&catalog);   // Optional
+ *   streaming.add_sink(&recorder);
+ *   recorder.start();
+ */
+class FlashRecorder : public interfaces::IFrameSink {
+public:
+    explicit FlashRecorder(SegmentStore& store) : store_(store) {}
+    ~FlashRecorder() override { deinit(); }
+
+    // Non-copyable
+    FlashRecorder(const FlashRecorder&) = delete;
+    FlashRecorder& operator=(const FlashRecorder&) = delete;
+
+    /**
+     * @brief Allocate the hand-over buffers
+     * @param use_psram Use PSRAM for the buffers (ESP32 only)
+     */
+    bool init(const FlashRecorderConfig& config, bool use_psram = true) {
+        if (initialized_) return true;
+        if (config.max_frame_size == 0) return false;
+        config_ = config;
+        for (auto*& buf : frames_) {
+#ifdef ESP_PLATFORM
+            buf = static_cast<uint8_t*>(use_psram ? heap_caps_malloc(config_.max_frame_size, MALLOC_CAP_SPIRAM)
+                                                  : malloc(config_.max_frame_size));
+#else
+            (void)use_psram;
+            buf = static_cast<uint8_t*>(malloc(config_.max_frame_size));
+#endif
+            if (!buf) {
+                deinit();
+                return false;
+            }
+        }
+        pending_ = frames_[0];
+        writing_ = frames_[1];
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        work_ready_ = xSemaphoreCreateBinary();
+        if (!mutex_ || !work_ready_) {
+            deinit();
+            return false;
+        }
+#endif
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        stop();
+        for (auto*& buf : frames_) {
+            if (!buf) continue;
+#ifdef ESP_PLATFORM
+            heap_caps_free(buf);
+#else
+            free(buf);
+#endif
+            buf = nullptr;
+        }
+        pending_ = nullptr;
+        writing_ = nullptr;
+        has_pending_ = false;
+
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+        if (work_ready_) {
+            vSemaphoreDelete(work_ready_);
+            work_ready_ = nullptr;
+        }
+#endif
+        initialized_ = false;
+    }
+
+    bool start() {
+        if (!initialized_ || !store_.is_mounted()) return false;
+        if (stats_.running.load()) return true;
+        stop_requested_ = false;
+        stats_.reset();
+        last_offered_us_ = INT64_MIN;
+        stats_.running = true;
+
+#ifdef ESP_PLATFORM
+        // Low priority: flash writes and erases run in the background
+        if (xTaskCreatePinnedToCore(record_task_wrapper, "recorder", 4096, this, 2,
+                                    &record_task_, 0) != pdPASS) {
+            stats_.running = false;
+            return false;
+        }
+#else
+        record_thread_ = std::thread(&FlashRecorder::record_loop, this);
+#endif
+        return true;
+    }
+
+    void stop() {
+        stop_requested_ = true;
+#ifdef ESP_PLATFORM
+        if (work_ready_) xSemaphoreGive(work_ready_);
+        for (int i = 0; i < 100 && stats_.running.load(); i++) {
+            vTaskDelay(pdMS_TO_TICKS(20));   // An erase can take a while
+        }
+        if (record_task_ && stats_.running.load()) {
+            vTaskDelete(record_task_);
+            stats_.running = false;
+        }
+        record_task_ = nullptr;
+#else
+        wake();
+        if (record_thread_.joinable()) record_thread_.join();
+        stats_.running = false;
+#endif
+    }
+
+    // IFrameSink: thin by timestamp, then copy into the pending slot
+    void on_frame(const uint8_t* data, size_t size,
+                  int64_t timestamp_us, uint32_t sequence) override {
+        (void)sequence;   // The store numbers its own records
+        if (!initialized_ || !stats_.running.load()) return;
+        stats_.frames_offered++;
+        if (!data || size == 0 || size > config_.max_frame_size) {
+            stats_.frames_rejected++;
+            return;
+        }
+        if (last_offered_us_ != INT64_MIN &&
+            timestamp_us - last_offered_us_ < static_cast<int64_t>(config_.frame_interval_ms) * 1000) {
+            stats_.frames_thinned++;
+            return;
+        }
+        last_offered_us_ = timestamp_us;
+
+        lock();
+        if (has_pending_) stats_.frames_superseded++;
+        memcpy(pending_, data, size);
+        pending_size_ = size;
+        pending_ts_ = timestamp_us;
+        has_pending_ = true;
+        unlock();
+        wake();
+    }
+
+    /**
+     * @brief Index stored frames in a catalog over the same store (set before start())
+     */
+    void set_catalog(RecordingCatalog* catalog) { catalog_ = catalog; }
+
+    /**
+     * @brief Offset added to frame timestamps (epoch - uptime once known)
+     */
+    void set_clock_offset_us(int64_t offset_us) { clock_offset_us_.store(offset_us); }
+
+    const FlashRecorderStats& stats() const { return stats_; }
+    const FlashRecorderConfig& config() const { return config_; }
+    bool is_running() const { return stats_.running.load(); }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    static constexpr uint32_t IDLE_WAIT_MS = 100;
+
+#ifdef ESP_PLATFORM
+    static void record_task_wrapper(void* arg) {
+        static_cast<FlashRecorder*>(arg)->record_loop();
+        vTaskDelete(nullptr);
+    }
+#endif
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    void wake() {
+#ifdef ESP_PLATFORM
+        if (work_ready_) xSemaphoreGive(work_ready_);
+#else
+        {
+            std::lock_guard<std::mutex> guard(wake_mutex_);
+            work_flag_ = true;
+        }
+        wake_cv_.notify_one();
+#endif
+    }
+
+    void wait_for_work(uint32_t timeout_ms) {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(work_ready_, pdMS_TO_TICKS(timeout_ms));
+#else
+        std::unique_lock<std::mutex> guard(wake_mutex_);
+        wake_cv_.wait_for(guard, std::chrono::milliseconds(timeout_ms),
+                          [this] { return work_flag_ || stop_requested_.load(); });
+        work_flag_ = false;
+#endif
+    }
+
+    void record_loop() {
+        while (!stop_requested_.load()) {
+            lock();
+            bool taken = has_pending_;
+            size_t size = pending_size_;
+            int64_t ts = pending_ts_;
+            if (taken) {
+                uint8_t* tmp = writing_;
+                writing_ = pending_;
+                pending_ = tmp;
+                has_pending_ = false;
+            }
+            unlock();
+
+            if (!taken) {
+                // Nothing to write: erase ahead so appends never have to
+                if (store_.service() || (catalog_ && catalog_->service())) {
+                    stats_.erases_ahead++;
+                } else {
+                    wait_for_work(IDLE_WAIT_MS);
+                }
+                continue;
+            }
+
+            int64_t store_ts = ts + clock_offset_us_.load() + boot_adjust_us_;
+            if (store_.newest_sequence() != 0 && store_ts <= store_.newest_timestamp_us()) {
+                boot_adjust_us_ += store_.newest_timestamp_us() - store_ts + 1;
+                store_ts = store_.newest_timestamp_us() + 1;
+            }
+            uint32_t sequence = store_.append(writing_, size, store_ts);
+            if (sequence) {
+                stats_.frames_recorded++;
+                if (catalog_) catalog_->on_record(sequence, store_ts, writing_, size);
+            } else {
+                stats_.write_errors++;
+            }
+        }
+        stats_.running = false;
+    }
+
+    SegmentStore& store_;
+    RecordingCatalog* catalog_ = nullptr;
+    FlashRecorderConfig config_;
+    FlashRecorderStats stats_;
+
+    uint8_t* frames_[2] = {nullptr, nullptr};
+    uint8_t* pending_ = nullptr;     // Written by the producer under the lock
+    uint8_t* writing_ = nullptr;     // Owned by the recorder task
+    size_t pending_size_ = 0;
+    int64_t pending_ts_ = 0;
+    bool has_pending_ = false;
+    int64_t last_offered_us_ = INT64_MIN;   // Producer only
+
+    std::atomic<int64_t> clock_offset_us_{0};
+    int64_t boot_adjust_us_ = 0;     // Recorder task only
+
+    std::atomic<bool> stop_requested_{false};
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t record_task_ = nullptr;
+    SemaphoreHandle_t mutex_ = nullptr;
+    SemaphoreHandle_t work_ready_ = nullptr;
+#else
+    std::thread record_thread_;
+    std::mutex mutex_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool work_flag_ = false;
+#endif
+};
+
+} // namespace core
@@ -3,6 +3,11 @@
  * @brief Thread-safe circular buffer for smooth streaming
  * 
  * Design: Fixed-size ring buffer with overflow policy (drop oldest).
+ * Besides the single destructive consumer (peek/pop), any number of readers
+ * can pin the newest frame (acquire_latest/release) without consuming it.
+ * Readers that may stall (slow network clients) take a lease instead: a pin
+ * the producer can revoke once its holder has made no progress for a while,
+ * so one stalled reader cannot make push() drop frames indefinitely.
  * Cross-platform: Uses FreeRTOS primitives on ESP32, std::mutex on host.
  */
 #pragma once
@@ -27,8 +32,20 @@ struct FrameSlot {
     size_t capacity = 0;
     size_t size = 0;
     int64_t timestamp_us = 0;
+    uint32_t sequence = 0;  // Monotonic per buffer, starts at 1
     bool occupied = false;
     bool reading = false;  // Consumer is reading this slot
+    uint16_t pins = 0;     // Non-destructive readers holding this slot
+};
+
+// A revocable pin (lease_latest); the holder brackets each read of the
+// data with lease_read_begin/lease_read_end
+struct FrameLease {
+    int slot = -1;
+    int64_t last_progress_us = 0;   // Last read that got somewhere
+    bool active = false;
+    bool reading = false;           // Between begin and end: never revoked
+    bool revoked = false;           // Pin dropped; the data may be overwritten
 };
 
 /**
@@ -37,6 +54,7 @@ struct FrameSlot {
  * Push: Adds frame to buffer. If full, drops oldest frame.
  * Peek: Returns pointer to oldest frame without removing.
  * Pop: Removes oldest frame from buffer.
+ * Acquire latest: Pins newest frame (if newer than a sequence) until release().
  * 
  * Memory: Pre-allocates slots in PSRAM (ESP32) or heap (host).
  */
@@ -44,6 +62,7 @@ class FrameBuffer {
 public:
     static constexpr size_t DEFAULT_SLOTS = 3;
     static constexpr size_t DEFAULT_FRAME_SIZE = 100 * 1024;  // 100KB
+    static constexpr size_t MAX_LEASES = 16;
 
     FrameBuffer() = default;
     ~FrameBuffer() { deinit(); }
@@ -133,6 +152,10 @@ public:
         read_idx_ = 0;
         count_ = 0;
         frames_dropped_ = 0;
+        leases_revoked_ = 0;
+        last_sequence_ = 0;
+        latest_idx_ = -1;
+        for (auto& lease : leases_) lease = FrameLease{};
         initialized_ = false;
     }
     
@@ -141,14 +164,25 @@ public:
      * @param data Frame data (copied)
      * @param size Frame size in bytes
      * @param timestamp_us Frame timestamp
-     * @return true on success, false if data is null/too large/buffer not initialized/full with locked slot
+     * @param sequence Output: assigned sequence number, 0 if the frame was dropped (optional)
+     * @return true on success, false if data is null/too large/buffer not initialized
+     * @note If the slot to overwrite is being read or pinned, the new frame is dropped
      */
-    bool push(const uint8_t* data, size_t size, int64_t timestamp_us = 0) {
+    bool push(const uint8_t* data, size_t size, int64_t timestamp_us = 0,
+              uint32_t* sequence = nullptr) {
+        if (sequence) *sequence = 0;
         if (!initialized_ || !data || size == 0) return false;
         if (size > max_frame_size_) return false;
         
         lock();
         
+        // Never overwrite a pinned slot (may be free if the consumer popped it)
+        if (slots_[write_idx_].pins > 0) {
+            unlock();
+            frames_dropped_++;
+            return true;  // Return true so caller doesn't retry immediately
+        }
+        
         // If buffer full, try to drop oldest frame
         if (count_ >= num_slots_) {
             // Don't drop the slot being read by consumer
@@ -170,11 +204,15 @@ public:
         memcpy(slot.data, data, size);
         slot.size = size;
         slot.timestamp_us = timestamp_us;
+        slot.sequence = last_sequence_.load() + 1;
+        last_sequence_ = slot.sequence;
         slot.occupied = true;
         slot.reading = false;
+        latest_idx_ = static_cast<int>(write_idx_);
         
         write_idx_ = (write_idx_ + 1) % num_slots_;
         count_++;
+        if (sequence) *sequence = slot.sequence;
         
         unlock();
         return true;
@@ -185,10 +223,12 @@ public:
      * @param data Output: pointer to frame data
      * @param size Output: frame size
      * @param timestamp_us Output: frame timestamp (optional)
+     * @param sequence Output: frame sequence number (optional)
      * @return true if frame available, false if buffer empty
      * @note Caller MUST call pop() after done reading to release the slot
      */
-    bool peek(const uint8_t** data, size_t* size, int64_t* timestamp_us = nullptr) {
+    bool peek(const uint8_t** data, size_t* size, int64_t* timestamp_us = nullptr,
+              uint32_t* sequence = nullptr) {
         if (!initialized_ || !data || !size) return false;
         
         lock();
@@ -205,6 +245,9 @@ public:
         if (timestamp_us) {
             *timestamp_us = slot.timestamp_us;
         }
+        if (sequence) {
+            *sequence = slot.sequence;
+        }
         
         unlock();
         return true;
@@ -228,11 +271,163 @@ public:
         unlock();
     }
     
+    /**
+     * @brief Pin the newest frame if it is newer than a given sequence
+     * 
+     * Does not consume the frame: the peek/pop consumer and other readers still
+     * see it. The newest frame stays readable after pop() until overwritten.
+     * @param after_sequence Only return a frame with sequence > this
+     * @param data Output: pointer to frame data
+     * @param size Output: frame size
+     * @param timestamp_us Output: frame timestamp (optional)
+     * @param sequence Output: frame sequence number (optional)
+     * @return Slot handle for release(), or -1 if no newer frame
+     * @note Push drops new frames while the slot it would overwrite is pinned
+     */
+    int acquire_latest(uint32_t after_sequence, const uint8_t** data, size_t* size,
+                       int64_t* timestamp_us = nullptr, uint32_t* sequence = nullptr) {
+        if (!initialized_ || !data || !size) return -1;
+        
+        lock();
+        
+        if (latest_idx_ < 0 || slots_[latest_idx_].sequence <= after_sequence) {
+            unlock();
+            return -1;
+        }
+        
+        FrameSlot& slot = slots_[latest_idx_];
+        slot.pins++;
+        *data = slot.data;
+        *size = slot.size;
+        if (timestamp_us) {
+            *timestamp_us = slot.timestamp_us;
+        }
+        if (sequence) {
+            *sequence = slot.sequence;
+        }
+        int handle = latest_idx_;
+        
+        unlock();
+        return handle;
+    }
+    
+    /**
+     * @brief Unpin a slot returned by acquire_latest()
+     */
+    void release(int handle) {
+        if (!initialized_ || handle < 0 || static_cast<size_t>(handle) >= num_slots_) return;
+        
+        lock();
+        if (slots_[handle].pins > 0) {
+            slots_[handle].pins--;
+        }
+        unlock();
+    }
+    
+    /**
+     * @brief Pin the newest frame, revocably (see revoke_stale_leases())
+     * @param now_us Start of the lease (counts as progress)
+     * @return Lease id, or -1 if no newer frame or every lease is taken
+     * @note Read the data only between lease_read_begin() and lease_read_end()
+     */
+    int lease_latest(uint32_t after_sequence, const uint8_t** data, size_t* size, int64_t now_us,
+                     int64_t* timestamp_us = nullptr, uint32_t* sequence = nullptr) {
+        if (!initialized_ || !data || !size) return -1;
+        
+        lock();
+        int id = -1;
+        for (size_t i = 0; i < MAX_LEASES; i++) {
+            if (!leases_[i].active) {
+                id = static_cast<int>(i);
+                break;
+            }
+        }
+        if (id < 0 || latest_idx_ < 0 || slots_[latest_idx_].sequence <= after_sequence) {
+            unlock();
+            return -1;
+        }
+        
+        FrameSlot& slot = slots_[latest_idx_];
+        slot.pins++;
+        leases_[id] = FrameLease{latest_idx_, now_us, true, false, false};
+        *data = slot.data;
+        *size = slot.size;
+        if (timestamp_us) *timestamp_us = slot.timestamp_us;
+        if (sequence) *sequence = slot.sequence;
+        
+        unlock();
+        return id;
+    }
+    
+    /**
+     * @brief About to read leased data
+     * @return false if the lease was revoked (the data must not be touched)
+     */
+    bool lease_read_begin(int lease) {
+        if (!valid_lease(lease)) return false;
+        lock();
+        FrameLease& l = leases_[lease];
+        bool ok = l.active && !l.revoked;
+        if (ok) l.reading = true;
+        unlock();
+        return ok;
+    }
+    
+    /**
+     * @brief Done reading for now
+     * @param progressed The read got somewhere (restarts the lease timeout)
+     */
+    void lease_read_end(int lease, int64_t now_us, bool progressed) {
+        if (!valid_lease(lease)) return;
+        lock();
+        FrameLease& l = leases_[lease];
+        l.reading = false;
+        if (progressed) l.last_progress_us = now_us;
+        unlock();
+    }
+    
+    /**
+     * @brief End a lease (revoked or not)
+     */
+    void release_lease(int lease) {
+        if (!valid_lease(lease)) return;
+        lock();
+        FrameLease& l = leases_[lease];
+        if (l.active && !l.revoked && slots_[l.slot].pins > 0) slots_[l.slot].pins--;
+        l = FrameLease{};
+        unlock();
+    }
+    
+    /**
+     * @brief Unpin frames whose lease holders made no progress for timeout_us
+     * 
+     * Only leases between reads are revoked; a holder finds out at its next
+     * lease_read_begin(). Call before push() so it can reuse the slot.
+     * @return Leases revoked
+     */
+    size_t revoke_stale_leases(int64_t now_us, int64_t timeout_us) {
+        if (!initialized_ || timeout_us <= 0) return 0;
+        size_t revoked = 0;
+        lock();
+        for (auto& l : leases_) {
+            if (!l.active || l.revoked || l.reading) continue;
+            if (now_us - l.last_progress_us < timeout_us) continue;
+            l.revoked = true;
+            if (slots_[l.slot].pins > 0) slots_[l.slot].pins--;
+            revoked++;
+        }
+        unlock();
+        leases_revoked_ += static_cast<uint32_t>(revoked);
+        return revoked;
+    }
+    
     // Status queries (lock-free reads)
     size_t available() const { return count_.load(); }
     bool empty() const { return count_.load() == 0; }
     bool full() const { return initialized_ && count_.load() >= num_slots_; }
     uint32_t frames_dropped() const { return frames_dropped_.load(); }
+    uint32_t leases_revoked() const { return leases_revoked_.load(); }
+    uint32_t last_sequence() const { return last_sequence_.load(); }
     size_t capacity() const { return num_slots_; }
     size_t max_frame_size() const { return max_frame_size_; }
     bool is_initialized() const { return initialized_; }
@@ -251,6 +446,7 @@ public:
         read_idx_ = 0;
         write_idx_ = 0;
         count_ = 0;
+        latest_idx_ = -1;
         unlock();
     }
     
@@ -259,9 +455,14 @@ public:
      */
     void reset_stats() {
         frames_dropped_ = 0;
+        leases_revoked_ = 0;
     }
 
 private:
+    bool valid_lease(int lease) const {
+        return initialized_ && lease >= 0 && static_cast<size_t>(lease) < MAX_LEASES;
+    }
+    
     void lock() {
 #ifdef ESP_PLATFORM
         xSemaphoreTake(mutex_, portMAX_DELAY);
@@ -283,8 +484,12 @@ private:
     size_t max_frame_size_ = 0;
     size_t write_idx_ = 0;
     size_t read_idx_ = 0;
+    int latest_idx_ = -1;  // Most recently pushed slot
     std::atomic<size_t> count_{0};
     std::atomic<uint32_t> frames_dropped_{0};
+    std::atomic<uint32_t> leases_revoked_{0};
+    std::atomic<uint32_t> last_sequence_{0};
+    FrameLease leases_[MAX_LEASES];
     bool initialized_ = false;
     
 #ifdef ESP_PLATFORM
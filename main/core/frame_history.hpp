@@ -0,0 +1,467 @@
+/**
+ * @file frame_history.hpp
+ * @brief In-memory history of recent frames for time-shifted playback
+ *
+ * Design: Frames are appended back-to-back into one byte arena (PSRAM on
+ * ESP32) with a FIFO index of {offset, size, timestamp, sequence}. The
+ * oldest frames are evicted to stay within a byte budget, an entry budget
+ * and a maximum age. Both timestamps and sequences increase along the
+ * index, so lookups are binary searches.
+ *
+ * The producer never waits on readers: the lock only covers index updates,
+ * and frame bytes are copied outside it. A reader copies a frame out and
+ * then checks it was not evicted meanwhile (the producer evicts before it
+ * overwrites), retrying or skipping ahead if it was.
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::mutex on host.
+ */
+#pragma once
+#include "../interfaces/i_frame_sink.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#else
+#include <mutex>
+#endif
+
+namespace core {
+
+struct HistoryEntry {
+    size_t offset = 0;
+    size_t size = 0;
+    int64_t timestamp_us = 0;
+    uint32_t sequence = 0;
+};
+
+struct FrameHistoryStats {
+    std::atomic<uint32_t> appended{0};
+    std::atomic<uint32_t> evicted{0};
+    std::atomic<uint32_t> rejected{0};     // Larger than the arena or out of order
+    std::atomic<uint32_t> torn_reads{0};   // Evicted while a reader was copying
+};
+
+/**
+ * @brief Byte/age-budgeted ring of recent frames with a timestamp index
+ *
+ * Append: called by the producer (as an IFrameSink) for every committed frame.
+ * Lookup: find_time() / next_after() return index entries.
+ * Read: read() copies a frame into a caller buffer.
+ */
+class FrameHistory : public interfaces::IFrameSink {
+public:
+    FrameHistory() = default;
+    ~FrameHistory() override { deinit(); }
+
+    // Non-copyable
+    FrameHistory(const FrameHistory&) = delete;
+    FrameHistory& operator=(const FrameHistory&) = delete;
+
+    /**
+     * @brief Pre-allocate the arena and index
+     * @param max_bytes Arena size (byte budget)
+     * @param max_entries Index capacity (frame budget)
+     * @param max_age_us Frames older than newest - max_age are evicted (0 = no limit)
+     * @param use_psram Use PSRAM for the arena (ESP32 only)
+     * @return true on success
+     */
+    bool init(size_t max_bytes, size_t max_entries, int64_t max_age_us = 0,
+              bool use_psram = true) {
+        if (initialized_) return true;
+        if (max_bytes == 0 || max_entries == 0) return false;
+
+        entries_ = new (std::nothrow) HistoryEntry[max_entries];
+        if (!entries_) return false;
+        max_entries_ = max_entries;
+
+#ifdef ESP_PLATFORM
+        arena_ = static_cast<uint8_t*>(use_psram
+            ? heap_caps_malloc(max_bytes, MALLOC_CAP_SPIRAM) : malloc(max_bytes));
+#else
+        (void)use_psram;
+        arena_ = static_cast<uint8_t*>(malloc(max_bytes));
+#endif
+        if (!arena_) {
+            deinit();
+            return false;
+        }
+        max_bytes_ = max_bytes;
+        max_age_us_ = max_age_us;
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        if (!mutex_) {
+            deinit();
+            return false;
+        }
+#endif
+
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        if (arena_) {
+#ifdef ESP_PLATFORM
+            heap_caps_free(arena_);
+#else
+            free(arena_);
+#endif
+            arena_ = nullptr;
+        }
+        delete[] entries_;
+        entries_ = nullptr;
+
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+#endif
+
+        max_bytes_ = 0;
+        max_entries_ = 0;
+        head_ = 0;
+        count_ = 0;
+        write_pos_ = 0;
+        bytes_used_ = 0;
+        evicted_through_ = 0;
+        initialized_ = false;
+    }
+
+    // IFrameSink: record every committed ring frame
+    void on_frame(const uint8_t* data, size_t size,
+                  int64_t timestamp_us, uint32_t sequence) override {
+        append(data, size, timestamp_us, sequence);
+    }
+
+    /**
+     * @brief Append a frame, evicting the oldest as needed (producer only)
+     * @return false if the frame is larger than the arena or out of order
+     */
+    bool append(const uint8_t* data, size_t size, int64_t timestamp_us, uint32_t sequence) {
+        if (!initialized_ || !data || size == 0) return false;
+        if (size > max_bytes_) {
+            stats_.rejected++;
+            return false;
+        }
+
+        // Reserve: evict whatever the new frame will overwrite
+        lock();
+        if (count_ > 0) {
+            const HistoryEntry& newest = at(count_ - 1);
+            if (sequence <= newest.sequence || timestamp_us < newest.timestamp_us) {
+                unlock();
+                stats_.rejected++;
+                return false;
+            }
+        }
+        size_t pos = write_pos_;
+        if (pos + size > max_bytes_) {
+            // Wrap: frames stay contiguous, the arena tail is left unused
+            while (count_ > 0 && at(0).offset >= pos) evict_oldest();
+            pos = 0;
+        }
+        while (count_ > 0 && overlaps(at(0), pos, size)) evict_oldest();
+        if (count_ == max_entries_) evict_oldest();
+        if (max_age_us_ > 0) {
+            while (count_ > 0 && at(0).timestamp_us < timestamp_us - max_age_us_) evict_oldest();
+        }
+        write_pos_ = pos + size;
+        unlock();
+
+        // Copy outside the lock; the range is no longer indexed
+        memcpy(arena_ + pos, data, size);
+
+        // Publish
+        lock();
+        HistoryEntry& entry = entries_[(head_ + count_) % max_entries_];
+        entry.offset = pos;
+        entry.size = size;
+        entry.timestamp_us = timestamp_us;
+        entry.sequence = sequence;
+        count_++;
+        bytes_used_ += size;
+        unlock();
+
+        stats_.appended++;
+        return true;
+    }
+
+    /**
+     * @brief First frame with timestamp >= timestamp_us
+     * @note Returns the oldest frame if timestamp_us precedes the history
+     */
+    bool find_time(int64_t timestamp_us, HistoryEntry* out) {
+        if (!initialized_ || !out) return false;
+        lock();
+        size_t lo = 0, hi = count_;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (at(mid).timestamp_us < timestamp_us) lo = mid + 1;
+            else hi = mid;
+        }
+        bool found = lo < count_;
+        if (found) *out = at(lo);
+        unlock();
+        return found;
+    }
+
+    /**
+     * @brief First frame with sequence > sequence
+     * @note Skips ahead to the oldest frame if the successor was evicted
+     */
+    bool next_after(uint32_t sequence, HistoryEntry* out) {
+        if (!initialized_ || !out) return false;
+        lock();
+        size_t lo = 0, hi = count_;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (at(mid).sequence <= sequence) lo = mid + 1;
+            else hi = mid;
+        }
+        bool found = lo < count_;
+        if (found) *out = at(lo);
+        unlock();
+        return found;
+    }
+
+    /**
+     * @brief Copy a frame out of the history
+     * @param entry Entry from find_time()/next_after()
+     * @param out Destination (at least entry.size bytes)
+     * @param capacity Destination size
+     * @return false if the frame was evicted before or during the copy
+     */
+    bool read(const HistoryEntry& entry, uint8_t* out, size_t capacity) {
+        if (!initialized_ || !out || entry.size > capacity) return false;
+        if (!contains(entry.sequence)) return false;
+
+        memcpy(out, arena_ + entry.offset, entry.size);
+
+        // Eviction happens before overwrite, so a still-present entry is intact
+        if (!contains(entry.sequence)) {
+            stats_.torn_reads++;
+            return false;
+        }
+        return true;
+    }
+
+    // Status queries
+    size_t frames() {
+        lock();
+        size_t n = count_;
+        unlock();
+        return n;
+    }
+
+    size_t bytes_used() {
+        lock();
+        size_t n = bytes_used_;
+        unlock();
+        return n;
+    }
+
+    int64_t duration_us() {
+        lock();
+        int64_t d = count_ > 1 ? at(count_ - 1).timestamp_us - at(0).timestamp_us : 0;
+        unlock();
+        return d;
+    }
+
+    bool newest(HistoryEntry* out) {
+        if (!initialized_ || !out) return false;
+        lock();
+        bool found = count_ > 0;
+        if (found) *out = at(count_ - 1);
+        unlock();
+        return found;
+    }
+
+    size_t max_bytes() const { return max_bytes_; }
+    size_t max_entries() const { return max_entries_; }
+    bool is_initialized() const { return initialized_; }
+    const FrameHistoryStats& stats() const { return stats_; }
+
+private:
+    // Logical index i (0 = oldest); caller holds the lock
+    const HistoryEntry& at(size_t i) const { return entries_[(head_ + i) % max_entries_]; }
+
+    static bool overlaps(const HistoryEntry& e, size_t pos, size_t size) {
+        return e.offset < pos + size && pos < e.offset + e.size;
+    }
+
+    void evict_oldest() {
+        const HistoryEntry& e = at(0);
+        bytes_used_ -= e.size;
+        evicted_through_ = e.sequence;
+        head_ = (head_ + 1) % max_entries_;
+        count_--;
+        stats_.evicted++;
+    }
+
+    bool contains(uint32_t sequence) {
+        lock();
+        bool present = count_ > 0 && sequence > evicted_through_ &&
+                       sequence <= at(count_ - 1).sequence;
+        unlock();
+        return present;
+    }
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    uint8_t* arena_ = nullptr;
+    size_t max_bytes_ = 0;
+    HistoryEntry* entries_ = nullptr;
+    size_t max_entries_ = 0;
+    size_t head_ = 0;            // Index slot of the oldest entry
+    size_t count_ = 0;
+    size_t write_pos_ = 0;       // Arena offset for the next frame
+    size_t bytes_used_ = 0;
+    uint32_t evicted_through_ = 0;  // Highest sequence evicted so far
+    int64_t max_age_us_ = 0;
+    FrameHistoryStats stats_;
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t mutex_ = nullptr;
+#else
+    std::mutex mutex_;
+#endif
+};
+
+/**
+ * @brief Paces frames out of a FrameHistory, then hands over to live
+ *
+ * Media time starts at the first replayed frame and advances at `speed`
+ * times wall-clock time. poll() returns each frame once its timestamp is
+ * due. When the player reaches the newest recorded frame it reports Live;
+ * the caller continues from last_sequence() on the live ring, so no frame
+ * is skipped or repeated at the hand-over. At speed 1 playback stays
+ * time-shifted; any speed > 1 eventually catches up.
+ *
+ * Pure logic: time is passed in, so it runs the same under MockClock.
+ */
+class HistoryPlayer {
+public:
+    enum class Step { Frame, Wait, Live };
+
+    // Timeline gaps longer than this (eviction, producer stall) are skipped
+    static constexpr int64_t MAX_GAP_US = 1000 * 1000;
+
+    /**
+     * @brief Position playback relative to the newest frame
+     * @param history Source of frames (must outlive the player)
+     * @param offset_us How far back to start (<= 0, e.g. -10 s)
+     * @param speed Playback rate (1 = real time)
+     * @param now_us Current wall-clock time
+     * @return false if the history is empty
+     */
+    bool start(FrameHistory& history, int64_t offset_us, float speed, int64_t now_us) {
+        history_ = &history;
+        HistoryEntry newest;
+        if (!history.newest(&newest)) return false;
+        if (offset_us > 0) offset_us = 0;
+
+        HistoryEntry first;
+        if (!history.find_time(newest.timestamp_us + offset_us, &first)) return false;
+
+        speed_milli_ = speed > 0.0f ? static_cast<int64_t>(speed * 1000.0f + 0.5f) : 1000;
+        if (speed_milli_ < 1) speed_milli_ = 1;
+        last_sequence_ = first.sequence - 1;
+        anchor(first.timestamp_us, now_us);
+        return true;
+    }
+
+    /**
+     * @brief Next playback step
+     * @param now_us Current wall-clock time
+     * @param entry Output: frame to send (Step::Frame)
+     * @param wait_us Output: time until the next frame is due (Step::Wait)
+     */
+    Step poll(int64_t now_us, HistoryEntry* entry, int64_t* wait_us) {
+        HistoryEntry next;
+        if (!history_ || !history_->next_after(last_sequence_, &next)) return Step::Live;
+
+        int64_t media_now = media_time(now_us);
+        if (next.timestamp_us - media_now > MAX_GAP_US) {
+            anchor(next.timestamp_us, now_us);
+            media_now = next.timestamp_us;
+        }
+
+        if (next.timestamp_us <= media_now) {
+            last_sequence_ = next.sequence;
+            if (entry) *entry = next;
+            return Step::Frame;
+        }
+        if (wait_us) {
+            // Round up so waiting the returned time always makes the frame due
+            *wait_us = ((next.timestamp_us - media_now) * 1000 + speed_milli_ - 1) / speed_milli_;
+        }
+        return Step::Wait;
+    }
+
+    // Sequence of the last frame returned (continue live after this)
+    uint32_t last_sequence() const { return last_sequence_; }
+    float speed() const { return static_cast<float>(speed_milli_) / 1000.0f; }
+
+private:
+    void anchor(int64_t media_us, int64_t wall_us) {
+        anchor_media_us_ = media_us;
+        anchor_wall_us_ = wall_us;
+    }
+
+    int64_t media_time(int64_t now_us) const {
+        // Integer math: float loses microseconds after a few seconds of playback
+        return anchor_media_us_ + (now_us - anchor_wall_us_) * speed_milli_ / 1000;
+    }
+
+    FrameHistory* history_ = nullptr;
+    int64_t speed_milli_ = 1000;  // Playback rate x1000
+    uint32_t last_sequence_ = 0;
+    int64_t anchor_media_us_ = 0;
+    int64_t anchor_wall_us_ = 0;
+};
+
+/**
+ * @brief Parse a playback offset such as "-10s", "-500ms" or "-10"
+ * @param text Offset (no suffix = seconds); must be <= 0
+ * @param out Output: offset in microseconds
+ * @return true on success
+ */
+inline bool parse_time_offset(const char* text, int64_t* out) {
+    if (!text || !out || !*text) return false;
+    char* end = nullptr;
+    long long value = strtoll(text, &end, 10);
+    if (end == text) return false;
+    int64_t scale = 1000 * 1000;
+    if (strcmp(end, "ms") == 0) scale = 1000;
+    else if (strcmp(end, "s") == 0 || *end == '\0') scale = 1000 * 1000;
+    else return false;
+    if (value > 0) return false;
+    *out = static_cast<int64_t>(value) * scale;
+    return true;
+}
+
+} // namespace core
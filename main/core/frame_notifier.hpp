@@ -0,0 +1,210 @@
+/**
+ * @file frame_notifier.hpp
+ * @brief Lossless "buffer state changed" notification for frame consumers
+ *
+ * A binary semaphore given once per commit loses wakeups: two commits
+ * before the consumer runs leave one give, so after taking the first frame
+ * the consumer sleeps its full timeout with the second one buffered.
+ *
+ * FrameNotifier pairs an epoch counter with the wait primitive. Waiters
+ * check their condition against the buffer itself (frames pending, sequence
+ * newer than X), and only sleep if the epoch has not moved since before
+ * that check:
+ *
+ *   epoch = notifier.epoch();       // 1. snapshot
+ *   if (ready()) return;            // 2. check buffer state
+ *   sleep until epoch changes       // 3. a publish() after 1 returns at once
+ *
+ * so a publish() can never fall between the check and the sleep, however
+ * many there are. wait() wraps this loop around a predicate.
+ *
+ * ESP32: waiters register their task handle under a spinlock that also
+ * guards the epoch; publish() gives each registered task a notification
+ * (xTaskNotifyGive). More than MAX_WAITERS at once fall back to polling
+ * every POLL_MS. Host: std::mutex + condition_variable, notified under the
+ * lock.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace core {
+
+/**
+ * @brief Statistics (thread-safe reads)
+ */
+struct FrameNotifierStats {
+    std::atomic<uint32_t> publishes{0};
+    std::atomic<uint32_t> waits{0};
+    std::atomic<uint32_t> ready_on_entry{0};   // Condition already true: no sleep
+    std::atomic<uint32_t> wakeups{0};          // Slept, then condition true
+    std::atomic<uint32_t> spurious{0};         // Woken with the condition still false
+    std::atomic<uint32_t> timeouts{0};
+    std::atomic<uint32_t> overflows{0};        // Waits that had to poll (ESP: no free slot)
+
+    void reset() {
+        publishes = 0;
+        waits = 0;
+        ready_on_entry = 0;
+        wakeups = 0;
+        spurious = 0;
+        timeouts = 0;
+        overflows = 0;
+    }
+};
+
+/**
+ * @brief Epoch counter + broadcast wakeup, free of lost wakeups
+ *
+ * Usage:
+ *   // Producer, after the buffer has changed:
+ *   notifier.publish();
+ *
+ *   // Consumer:
+ *   bool ok = notifier.wait([&] { return !buffer.empty() || stopping; }, timeout_ms);
+ */
+class FrameNotifier {
+public:
+    static constexpr size_t MAX_WAITERS = 8;   // Concurrent sleepers (HTTP streams + pollers)
+    static constexpr uint32_t POLL_MS = 10;    // Re-check interval past MAX_WAITERS
+
+    FrameNotifier() = default;
+
+    // Non-copyable
+    FrameNotifier(const FrameNotifier&) = delete;
+    FrameNotifier& operator=(const FrameNotifier&) = delete;
+
+    /**
+     * @brief Buffer state changed: wake every waiter
+     */
+    void publish() {
+#ifdef ESP_PLATFORM
+        TaskHandle_t wake[MAX_WAITERS];
+        size_t count = 0;
+        taskENTER_CRITICAL(&lock_);
+        epoch_.fetch_add(1);
+        for (size_t i = 0; i < MAX_WAITERS; i++) {
+            if (waiters_[i]) wake[count++] = waiters_[i];
+        }
+        taskEXIT_CRITICAL(&lock_);
+        for (size_t i = 0; i < count; i++) xTaskNotifyGive(wake[i]);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            epoch_.fetch_add(1);
+        }
+        cv_.notify_all();
+#endif
+        stats_.publishes++;
+    }
+
+    /**
+     * @brief Wait until a condition on the buffer holds
+     * @param ready Checked on entry and after every publish(); must not block
+     * @param timeout_ms Max time to wait (0 = check once)
+     * @return ready() (false on timeout)
+     */
+    template <typename Pred>
+    bool wait(Pred ready, uint32_t timeout_ms) {
+        stats_.waits++;
+        uint32_t seen = epoch_.load();
+        if (ready()) {
+            stats_.ready_on_entry++;
+            return true;
+        }
+        if (timeout_ms == 0) return false;
+
+#ifdef ESP_PLATFORM
+        TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+        TaskHandle_t self = xTaskGetCurrentTaskHandle();
+        while (true) {
+            TickType_t now = xTaskGetTickCount();
+            if (static_cast<int32_t>(deadline - now) <= 0) break;
+            TickType_t ticks = deadline - now;
+
+            // Register and re-check the epoch atomically with respect to publish()
+            int slot = -1;
+            bool moved;
+            taskENTER_CRITICAL(&lock_);
+            moved = epoch_.load() != seen;
+            if (!moved) {
+                for (size_t i = 0; i < MAX_WAITERS; i++) {
+                    if (!waiters_[i]) {
+                        waiters_[i] = self;
+                        slot = static_cast<int>(i);
+                        break;
+                    }
+                }
+            }
+            taskEXIT_CRITICAL(&lock_);
+
+            if (!moved) {
+                if (slot >= 0) {
+                    ulTaskNotifyTake(pdTRUE, ticks);
+                    taskENTER_CRITICAL(&lock_);
+                    waiters_[slot] = nullptr;
+                    taskEXIT_CRITICAL(&lock_);
+                } else {
+                    stats_.overflows++;
+                    TickType_t poll = pdMS_TO_TICKS(POLL_MS);
+                    vTaskDelay(poll < ticks ? poll : ticks);
+                }
+            }
+
+            seen = epoch_.load();
+            if (ready()) {
+                stats_.wakeups++;
+                return true;
+            }
+            // A notification left over from an earlier wait, or a publish
+            // that did not satisfy this waiter's condition
+            stats_.spurious++;
+        }
+#else
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            if (!cv_.wait_until(lock, deadline, [this, seen] { return epoch_.load() != seen; })) break;
+            seen = epoch_.load();
+            lock.unlock();
+            bool ok = ready();
+            lock.lock();
+            if (ok) {
+                stats_.wakeups++;
+                return true;
+            }
+            stats_.spurious++;
+        }
+#endif
+        stats_.timeouts++;
+        return false;
+    }
+
+    // Number of publish() calls so far (wraps)
+    uint32_t epoch() const { return epoch_.load(); }
+    const FrameNotifierStats& stats() const { return stats_; }
+    void reset_stats() { stats_.reset(); }
+
+private:
+    std::atomic<uint32_t> epoch_{0};
+    FrameNotifierStats stats_;
+
+#ifdef ESP_PLATFORM
+    portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+    TaskHandle_t waiters_[MAX_WAITERS] = {};
+#else
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
+
+} // namespace core
@@ -0,0 +1,455 @@
+/**
+ * @file frame_uploader.hpp
+ * @brief Batched multipart upload of frames to a remote collector, spooled across outages
+ *
+ * Architecture:
+ *   [Producer] → on_frame() → [Spool (FrameHistory)] → [Upload Task] → IHttpClient
+ *                (copy, append)  (byte-bounded FIFO)    (batch, pace, retry)
+ *
+ * Every committed frame is appended to a byte-bounded spool. The upload
+ * task sends everything after the last acknowledged sequence as one
+ * multipart/mixed POST of up to max_batch_frames frames, waiting up to
+ * batch_interval for a batch to fill while live. A failed POST drops the
+ * connection and is retried with exponential backoff; meanwhile the spool
+ * keeps filling and evicts its oldest frames once full (counted as lost).
+ * After the collector comes back the backlog drains in back-to-back
+ * batches, paced by a token bucket so catching up cannot saturate the link.
+ *
+ * Uploads are charged to an EgressScheduler as the Recorder class when one
+ * is set: they are never skipped, but they take their share of the link
+ * from stream clients first.
+ *
+ * Each part carries Content-Length, X-Camera-Id, X-Frame-Sequence and
+ * X-Frame-Timestamp headers; sequences are the ring's, so the collector
+ * can detect gaps and duplicates (a batch is resent whole after a failure).
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::thread on host.
+ */
+#pragma once
+#include "../interfaces/i_clock.hpp"
+#include "../interfaces/i_frame_sink.hpp"
+#include "../interfaces/i_http_client.hpp"
+#include "frame_history.hpp"
+#include "rtp_jpeg.hpp"
+#include "egress_scheduler.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+namespace core {
+
+#define UPLOAD_BOUNDARY "espcam-upload"
+#define UPLOAD_CONTENT_TYPE "multipart/mixed; boundary=" UPLOAD_BOUNDARY
+
+struct UploaderConfig {
+    const char* camera_id = "0";          // X-Camera-Id of every part (must outlive the uploader)
+    size_t spool_bytes = 1024 * 1024;     // Frames kept while the collector is unreachable
+    size_t spool_frames = 256;            // Spool index capacity
+    size_t max_batch_frames = 8;          // Frames per POST
+    size_t max_batch_bytes = 256 * 1024;  // POST body limit (larger frames are skipped)
+    uint32_t batch_interval_ms = 1000;    // Max wait for a batch to fill while live
+    uint32_t rate_kbps = 4000;            // Upload pacing (0 = unlimited); bounds backlog drain
+    uint32_t retry_initial_ms = 500;      // Backoff after the first failure
+    uint32_t retry_max_ms = 30000;        // Backoff cap (doubles per failure)
+    EgressScheduler* scheduler = nullptr; // Acknowledged batches charged as Recorder (optional)
+};
+
+struct UploaderStats {
+    std::atomic<uint32_t> batches_sent{0};
+    std::atomic<uint32_t> frames_uploaded{0};
+    std::atomic<uint64_t> bytes_uploaded{0};     // POST bodies acknowledged with 2xx
+    std::atomic<uint64_t> upload_time_us{0};     // Time spent in successful POSTs
+    std::atomic<uint32_t> upload_errors{0};      // Failed POSTs (transport or 5xx/408/429)
+    std::atomic<uint32_t> retries{0};            // POSTs resending after a failure
+    std::atomic<uint32_t> reconnects{0};         // Outages recovered from
+    std::atomic<uint32_t> frames_rejected{0};    // Too large, or refused with another 4xx
+    std::atomic<uint32_t> frames_lost{0};        // Evicted from the spool before upload
+    std::atomic<uint32_t> queue_depth{0};        // Spooled frames not yet acknowledged
+    std::atomic<bool> running{false};
+
+    void reset() {
+        batches_sent = 0;
+        frames_uploaded = 0;
+        bytes_uploaded = 0;
+        upload_time_us = 0;
+        upload_errors = 0;
+        retries = 0;
+        reconnects = 0;
+        frames_rejected = 0;
+        frames_lost = 0;
+        queue_depth = 0;
+    }
+
+    /**
+     * @brief Bytes per second while uploading (excludes idle and backoff time)
+     */
+    uint32_t throughput_bps() const {
+        uint64_t us = upload_time_us.load();
+        return us ? static_cast<uint32_t>(bytes_uploaded.load() * 1000000 / us) : 0;
+    }
+};
+
+/**
+ * @brief IFrameSink that uploads every frame it can spool
+ *
+ * Usage:
+ *   FrameUploader uploader(http, clock);
+ *   uploader.init(config);
+ *   streaming.add_sink(&uploader);
+ *   uploader.start();
+ */
+class FrameUploader : public interfaces::IFrameSink {
+public:
+    FrameUploader(interfaces::IHttpClient& client, interfaces::IClock& clock)
+        : client_(client), clock_(clock) {}
+
+    ~FrameUploader() override { deinit(); }
+
+    // Non-copyable
+    FrameUploader(const FrameUploader&) = delete;
+    FrameUploader& operator=(const FrameUploader&) = delete;
+
+    /**
+     * @brief Allocate the spool and batch buffer
+     * @param use_psram Use PSRAM for both (ESP32 only)
+     * @return false on invalid config or allocation failure
+     */
+    bool init(const UploaderConfig& config, bool use_psram = true) {
+        if (initialized_) return true;
+        if (config.max_batch_frames == 0 || config.max_batch_bytes < 1024 ||
+            config.spool_frames == 0 || !config.camera_id) {
+            return false;
+        }
+        config_ = config;
+        if (config.rate_kbps) {
+            pacer_.configure(config.rate_kbps * 1000 / 8, static_cast<uint32_t>(config.max_batch_bytes));
+        }
+
+        if (!spool_.init(config.spool_bytes, config.spool_frames, 0, use_psram)) return false;
+#ifdef ESP_PLATFORM
+        batch_ = static_cast<uint8_t*>(use_psram
+            ? heap_caps_malloc(config.max_batch_bytes, MALLOC_CAP_SPIRAM)
+            : malloc(config.max_batch_bytes));
+#else
+        batch_ = static_cast<uint8_t*>(malloc(config.max_batch_bytes));
+#endif
+        if (!batch_) {
+            deinit();
+            return false;
+        }
+
+#ifdef ESP_PLATFORM
+        batch_ready_ = xSemaphoreCreateBinary();
+        if (!batch_ready_) {
+            deinit();
+            return false;
+        }
+#endif
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        stop();
+        spool_.deinit();
+        if (batch_) {
+#ifdef ESP_PLATFORM
+            heap_caps_free(batch_);
+#else
+            free(batch_);
+#endif
+            batch_ = nullptr;
+        }
+#ifdef ESP_PLATFORM
+        if (batch_ready_) {
+            vSemaphoreDelete(batch_ready_);
+            batch_ready_ = nullptr;
+        }
+#endif
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Start the upload task
+     */
+    bool start() {
+        if (!initialized_) return false;
+        if (stats_.running.load()) return true;
+        stop_requested_ = false;
+        stats_.reset();
+        stats_.running = true;
+
+#ifdef ESP_PLATFORM
+        if (xTaskCreatePinnedToCore(upload_task_wrapper, "uploader", 6144, this, 3,
+                                    &upload_task_, 0) != pdPASS) {
+            stats_.running = false;
+            return false;
+        }
+#else
+        upload_thread_ = std::thread(&FrameUploader::upload_loop, this);
+#endif
+        return true;
+    }
+
+    void stop() {
+        stop_requested_ = true;
+#ifdef ESP_PLATFORM
+        if (batch_ready_) xSemaphoreGive(batch_ready_);
+        // A POST in flight can take up to the client's timeout
+        for (int i = 0; i < 600 && stats_.running.load(); i++) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        if (upload_task_ && stats_.running.load()) {
+            vTaskDelete(upload_task_);
+            stats_.running = false;
+        }
+        upload_task_ = nullptr;
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+        if (upload_thread_.joinable()) upload_thread_.join();
+        stats_.running = false;
+#endif
+    }
+
+    // IFrameSink: spool the frame (evicting the oldest if full)
+    void on_frame(const uint8_t* data, size_t size,
+                  int64_t timestamp_us, uint32_t sequence) override {
+        if (!initialized_ || !stats_.running.load()) return;
+        if (!started_) {
+            acked_through_ = sequence - 1;
+            started_ = true;
+        }
+        if (!spool_.append(data, size, timestamp_us, sequence)) return;
+        newest_sequence_ = sequence;
+
+        size_t pending = pending_frames();
+        stats_.queue_depth = static_cast<uint32_t>(pending);
+        if (pending >= config_.max_batch_frames) {
+#ifdef ESP_PLATFORM
+            xSemaphoreGive(batch_ready_);
+#else
+            { std::lock_guard<std::mutex> lock(mutex_); }
+            cv_.notify_one();
+#endif
+        }
+    }
+
+    const UploaderStats& stats() const { return stats_; }
+    const UploaderConfig& config() const { return config_; }
+    bool is_running() const { return stats_.running.load(); }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    static constexpr char CLOSE_DELIMITER[] = "--" UPLOAD_BOUNDARY "--\r\n";
+    static constexpr size_t CLOSE_LENGTH = sizeof(CLOSE_DELIMITER) - 1;
+    static constexpr uint32_t WAIT_SLICE_MS = 100;   // Stop latency while backing off
+
+    struct Batch {
+        size_t frames = 0;           // Frames in the body
+        size_t too_large = 0;        // Skipped: cannot fit any batch
+        uint32_t last_sequence = 0;  // Acknowledged through this on success
+    };
+
+#ifdef ESP_PLATFORM
+    static void upload_task_wrapper(void* arg) {
+        static_cast<FrameUploader*>(arg)->upload_loop();
+        vTaskDelete(nullptr);
+    }
+#endif
+
+    // Frames spooled after the last acknowledged one (bounded by the spool)
+    size_t pending_frames() {
+        uint32_t pending = newest_sequence_.load() - acked_through_.load();
+        size_t spooled = spool_.frames();
+        return pending < spooled ? pending : spooled;
+    }
+
+    // Wait until a full batch is spooled, batch_interval passes, or stop
+    void wait_for_batch() {
+        if (pending_frames() >= config_.max_batch_frames) return;
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(batch_ready_, pdMS_TO_TICKS(config_.batch_interval_ms));
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::milliseconds(config_.batch_interval_ms), [this] {
+            return stop_requested_.load() || pending_frames() >= config_.max_batch_frames;
+        });
+#endif
+    }
+
+    // Backoff and pacing delays, in slices so stop() is not held up
+    void pause_ms(uint32_t ms) {
+        while (ms > 0 && !stop_requested_.load()) {
+            uint32_t step = ms < WAIT_SLICE_MS ? ms : WAIT_SLICE_MS;
+            clock_.delay_ms(step);
+            ms -= step;
+        }
+    }
+
+    // Write the frames after acked_through_ into batch_ as multipart parts
+    size_t build_batch(Batch* batch) {
+        *batch = Batch{};
+        uint32_t cursor = acked_through_.load();
+        size_t len = 0;
+        HistoryEntry entry;
+        while (batch->frames < config_.max_batch_frames && spool_.next_after(cursor, &entry)) {
+            char header[192];
+            int hlen = snprintf(header, sizeof(header),
+                "--" UPLOAD_BOUNDARY "\r\n"
+                "Content-Type: image/jpeg\r\n"
+                "Content-Length: %zu\r\n"
+                "X-Camera-Id: %s\r\n"
+                "X-Frame-Sequence: %lu\r\n"
+                "X-Frame-Timestamp: %lld\r\n\r\n",
+                entry.size, config_.camera_id, static_cast<unsigned long>(entry.sequence),
+                static_cast<long long>(entry.timestamp_us));
+            if (hlen < 0 || static_cast<size_t>(hlen) >= sizeof(header)) break;
+            size_t part = static_cast<size_t>(hlen) + entry.size + 2;
+
+            if (part + CLOSE_LENGTH > config_.max_batch_bytes) {
+                if (batch->frames > 0) break;   // Settle it alone, next round
+                batch->too_large++;
+                cursor = entry.sequence;
+                continue;
+            }
+            if (len + part + CLOSE_LENGTH > config_.max_batch_bytes) break;
+
+            uint8_t* out = batch_ + len;
+            if (!spool_.read(entry, out + hlen, config_.max_batch_bytes - len - hlen)) {
+                cursor = entry.sequence;   // Evicted while copying: lost
+                continue;
+            }
+            memcpy(out, header, static_cast<size_t>(hlen));
+            len += static_cast<size_t>(hlen) + entry.size;
+            batch_[len++] = '\r';
+            batch_[len++] = '\n';
+            cursor = entry.sequence;
+            batch->frames++;
+        }
+        batch->last_sequence = cursor;
+        if (batch->frames == 0) return 0;
+        memcpy(batch_ + len, CLOSE_DELIMITER, CLOSE_LENGTH);
+        return len + CLOSE_LENGTH;
+    }
+
+    // Settle everything through batch.last_sequence
+    void acknowledge(const Batch& batch, bool accepted) {
+        uint32_t span = batch.last_sequence - acked_through_.load();
+        uint32_t settled = static_cast<uint32_t>(batch.frames + batch.too_large);
+        stats_.frames_lost += span - settled;
+        stats_.frames_rejected += static_cast<uint32_t>(batch.too_large);
+        if (accepted) stats_.frames_uploaded += static_cast<uint32_t>(batch.frames);
+        else stats_.frames_rejected += static_cast<uint32_t>(batch.frames);
+        acked_through_ = batch.last_sequence;
+        stats_.queue_depth = static_cast<uint32_t>(pending_frames());
+    }
+
+    static bool is_retryable(int status) {
+        return status < 0 || status >= 500 || status == 408 || status == 429;
+    }
+
+    void upload_loop() {
+        uint32_t backoff_ms = 0;
+        while (!stop_requested_.load()) {
+            if (backoff_ms) pause_ms(backoff_ms);
+            else wait_for_batch();
+            if (stop_requested_.load()) break;
+
+            Batch batch;
+            size_t len = build_batch(&batch);
+            if (len == 0) {
+                // Nothing sendable; still settle evicted/oversized frames
+                if (batch.last_sequence != acked_through_.load()) acknowledge(batch, false);
+                continue;
+            }
+
+            if (config_.rate_kbps) {
+                int64_t wait_us = pacer_.reserve(len, clock_.now_us());
+                if (wait_us >= 1000) pause_ms(static_cast<uint32_t>(wait_us / 1000));
+                if (stop_requested_.load()) break;
+            }
+
+            if (backoff_ms) stats_.retries++;
+            int64_t t0 = clock_.now_us();
+            int status = client_.post(UPLOAD_CONTENT_TYPE, batch_, len);
+            int64_t elapsed_us = clock_.now_us() - t0;
+
+            if (status >= 200 && status < 300) {
+                if (backoff_ms) stats_.reconnects++;
+                backoff_ms = 0;
+                stats_.batches_sent++;
+                stats_.bytes_uploaded += len;
+                stats_.upload_time_us += static_cast<uint64_t>(elapsed_us > 0 ? elapsed_us : 0);
+                if (config_.scheduler) {
+                    config_.scheduler->charge(ConsumerClass::Recorder, len,
+                                              static_cast<uint32_t>(batch.frames), clock_.now_us());
+                }
+                acknowledge(batch, true);
+            } else if (!is_retryable(status)) {
+                // The collector refuses these frames; resending cannot help
+                backoff_ms = 0;
+                acknowledge(batch, false);
+#ifdef ESP_PLATFORM
+                ESP_LOGW("Uploader", "Batch rejected with HTTP %d", status);
+#endif
+            } else {
+                stats_.upload_errors++;
+                client_.disconnect();
+                backoff_ms = backoff_ms ? backoff_ms * 2 : config_.retry_initial_ms;
+                if (backoff_ms > config_.retry_max_ms) backoff_ms = config_.retry_max_ms;
+                if (backoff_ms == 0) backoff_ms = 1;
+#ifdef ESP_PLATFORM
+                ESP_LOGW("Uploader", "Upload failed (%d), retry in %lu ms, %lu queued", status,
+                         static_cast<unsigned long>(backoff_ms),
+                         static_cast<unsigned long>(stats_.queue_depth.load()));
+#endif
+            }
+        }
+        stats_.running = false;
+    }
+
+    interfaces::IHttpClient& client_;
+    interfaces::IClock& clock_;
+
+    UploaderConfig config_;
+    UploaderStats stats_;
+    FrameHistory spool_;
+    RtpPacer pacer_;
+    uint8_t* batch_ = nullptr;   // Owned by the upload task
+
+    std::atomic<uint32_t> acked_through_{0};    // Highest sequence settled
+    std::atomic<uint32_t> newest_sequence_{0};  // Highest sequence spooled
+    bool started_ = false;                      // Producer only
+
+    std::atomic<bool> stop_requested_{false};
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t upload_task_ = nullptr;
+    SemaphoreHandle_t batch_ready_ = nullptr;
+#else
+    std::thread upload_thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
+
+} // namespace core
@@ -0,0 +1,765 @@
+/**
+ * @file image_quality.hpp
+ * @brief Sharpness, exposure and noise metrics from JPEG coefficients, with
+ *        debounced alerts for defocused, fogged, blinded or dark cameras
+ *
+ * Architecture:
+ *   [Producer] → on_frame() → [pending] ⇄ [analysing] → [Quality Task]
+ *                (every Nth)                              → metrics, stats, alert/metrics callbacks
+ *
+ * Metrics come from the entropy-decoded luma coefficients alone (no IDCT,
+ * no chroma work, no pixels). The JPEG DCT is orthonormal, so after
+ * dequantization a coefficient has the units of luma levels:
+ *   - exposure: block mean luma is 128 + DC / 8; its histogram gives the
+ *     mean, the share of near-black blocks and of clipped (near-white) ones
+ *   - contrast: standard deviation of the block means (fog flattens it)
+ *   - sharpness: share of the AC energy (sum of |coefficient|) above the
+ *     lowest frequencies (u + v > 3), over textured blocks only, after
+ *     taking off the high-frequency energy flat blocks show (noise would
+ *     otherwise read as detail); defocus removes high frequencies first,
+ *     whatever the scene's contrast
+ *   - noise: RMS of the high-frequency coefficients in the flattest tenth
+ *     of the blocks, where there is no detail for them to come from.
+ *     Noise below about half a quantizer step is zeroed by the encoder, so
+ *     this measures the noise that survives into the stream.
+ *
+ * With restart markers, interval_step > 1 decodes one restart interval in
+ * every interval_step and skips the rest without Huffman decoding.
+ *
+ * Alerts: a threshold must be crossed on alert_samples consecutive samples
+ * to raise its alert, and be back within it as many times to clear it, so a
+ * hand waved past the lens does not page anyone.
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::thread on host.
+ */
+#pragma once
+#include "../interfaces/i_frame_sink.hpp"
+#include "jpeg_codec.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+namespace core {
+
+static constexpr size_t QUALITY_HISTOGRAM_BINS = 16;   // 16 luma levels per bin
+static constexpr uint8_t QUALITY_LOW_FREQUENCIES = 10; // Zigzag 1-9: u + v <= 3
+
+// Alert bits (QualityMonitor::alerts(), alert callback)
+static constexpr uint8_t QUALITY_ALERT_BLUR = 1 << 0;
+static constexpr uint8_t QUALITY_ALERT_LOW_CONTRAST = 1 << 1;
+static constexpr uint8_t QUALITY_ALERT_OVEREXPOSED = 1 << 2;
+static constexpr uint8_t QUALITY_ALERT_UNDEREXPOSED = 1 << 3;
+static constexpr uint8_t QUALITY_ALERT_NOISE = 1 << 4;
+static constexpr size_t QUALITY_ALERT_COUNT = 5;
+
+// JSON names, in bit order
+static constexpr const char* QUALITY_ALERT_NAMES[QUALITY_ALERT_COUNT] = {
+    "blur", "low_contrast", "overexposed", "underexposed", "noise"
+};
+
+struct ImageQualityConfig {
+    uint8_t dark_level = 16;          // Block mean below this counts as dark
+    uint8_t bright_level = 240;       // Block mean above this counts as clipped
+    uint16_t texture_energy = 48;     // AC energy (sum of |coefficient|) of a textured block
+    uint8_t interval_step = 1;        // Decode 1 restart interval in N (needs restart markers)
+};
+
+/**
+ * @brief Quality of one frame (luma only)
+ */
+struct ImageQualityMetrics {
+    uint16_t sharpness = 0;      // High-frequency share of textured blocks' AC energy, per mille
+    uint16_t contrast = 0;       // Std dev of block mean luma, levels
+    uint16_t noise = 0;          // Noise estimate, tenths of a luma level
+    uint8_t mean_luma = 0;
+    uint8_t dark_pct = 0;        // Blocks darker than dark_level
+    uint8_t bright_pct = 0;      // Blocks brighter than bright_level
+    uint8_t textured_pct = 0;    // Blocks that took part in sharpness
+    uint32_t blocks = 0;         // Luma blocks analysed
+    uint32_t histogram[QUALITY_HISTOGRAM_BINS] = {};   // Blocks per mean-luma bin
+};
+
+/**
+ * @brief Computes ImageQualityMetrics from a baseline JPEG
+ *
+ * Holds the parser state and Huffman tables (~8 KB); keep it off small
+ * task stacks. Not thread-safe.
+ */
+class ImageQualityAnalyzer {
+public:
+    explicit ImageQualityAnalyzer(const ImageQualityConfig& config = {}) : config_(config) {}
+
+    // Non-copyable
+    ImageQualityAnalyzer(const ImageQualityAnalyzer&) = delete;
+    ImageQualityAnalyzer& operator=(const ImageQualityAnalyzer&) = delete;
+
+    void set_config(const ImageQualityConfig& config) { config_ = config; }
+    const ImageQualityConfig& config() const { return config_; }
+
+    /**
+     * @return false if the data is not a decodable baseline JPEG
+     */
+    bool analyze(const uint8_t* jpeg, size_t size, ImageQualityMetrics* out) {
+        if (!out || !jpeg_parse(jpeg, size, &info_)) return false;
+        const JpegComponent& luma = info_.components[0];
+        if (luma.tq > 3 || !info_.quant_present[luma.tq]) return false;
+        if (!decoder_.begin(jpeg, size, info_)) return false;
+
+        const uint16_t* q = info_.quant[luma.tq];
+        uint8_t h = info_.num_components == 1 ? 1 : luma.h;
+        uint8_t v = info_.num_components == 1 ? 1 : luma.v;
+        uint32_t width_blocks = (info_.width + 7u) / 8;
+        uint32_t height_blocks = (info_.height + 7u) / 8;
+        uint32_t total = info_.total_mcus();
+        uint32_t step = config_.interval_step > 1 && info_.restart_interval ? config_.interval_step : 1;
+
+        Accumulator acc;
+        int16_t blocks[JPEG_MAX_BLOCKS_PER_MCU][64];
+        for (uint32_t mcu = 0; mcu < total;) {
+            if (!decoder_.decode_mcu(blocks)) return false;
+            uint32_t mx = mcu % info_.mcus_x;
+            uint32_t my = mcu / info_.mcus_x;
+            // Luma blocks come first in an MCU, h x v of them row-major
+            for (uint8_t i = 0; i < h * v; i++) {
+                if (mx * h + i % h >= width_blocks || my * v + i / h >= height_blocks) continue;
+                add_block(blocks[i], q, &acc);
+            }
+            mcu++;
+            if (step > 1 && mcu % info_.restart_interval == 0 && mcu < total) {
+                if (!decoder_.skip_intervals(step - 1)) return false;
+                mcu = decoder_.mcus_decoded();
+            }
+        }
+        if (acc.blocks == 0) return false;
+        finish(acc, out);
+        return true;
+    }
+
+private:
+    static constexpr size_t FLATNESS_BUCKETS = 32;   // By bit length of low-frequency energy
+    static constexpr uint32_t HIGH_CAP = 4095;       // Far above any noise level
+
+    struct Accumulator {
+        uint32_t blocks = 0;
+        uint64_t luma_sum = 0;
+        uint64_t luma_sq_sum = 0;
+        uint32_t dark = 0;
+        uint32_t bright = 0;
+        uint32_t histogram[QUALITY_HISTOGRAM_BINS] = {};
+        uint32_t textured = 0;
+        uint64_t texture_ac = 0;      // AC energy of textured blocks
+        uint64_t texture_high = 0;    // Of which above the low frequencies
+        // Per flatness bucket: blocks and their high-frequency energy / sum of squares
+        uint32_t flat_blocks[FLATNESS_BUCKETS] = {};
+        uint64_t flat_high[FLATNESS_BUCKETS] = {};
+        uint64_t flat_sq[FLATNESS_BUCKETS] = {};
+    };
+
+    void add_block(const int16_t* blk, const uint16_t* q, Accumulator* acc) const {
+        int32_t mean = 128 + blk[0] * static_cast<int32_t>(q[0]) / 8;
+        mean = mean < 0 ? 0 : mean > 255 ? 255 : mean;
+        acc->blocks++;
+        acc->luma_sum += static_cast<uint32_t>(mean);
+        acc->luma_sq_sum += static_cast<uint32_t>(mean * mean);
+        acc->histogram[mean >> 4]++;
+        if (mean < config_.dark_level) acc->dark++;
+        if (mean > config_.bright_level) acc->bright++;
+
+        uint32_t low = 0;
+        for (int k = 1; k < QUALITY_LOW_FREQUENCIES; k++) {
+            low += static_cast<uint32_t>(abs(blk[k])) * q[k];
+        }
+        // Most high-frequency coefficients are zero: skip them four at a time
+        uint32_t high = 0;
+        uint32_t high_sq = 0;
+        for (int k = QUALITY_LOW_FREQUENCIES; k < 64; k += 2) {
+            if (k % 4 == 0) {
+                uint64_t quad;
+                memcpy(&quad, blk + k, sizeof(quad));
+                if (quad == 0) {
+                    k += 2;
+                    continue;
+                }
+            }
+            for (int j = k; j < k + 2; j++) {
+                if (!blk[j]) continue;
+                uint32_t c = static_cast<uint32_t>(abs(blk[j])) * q[j];
+                uint32_t capped = c < HIGH_CAP ? c : HIGH_CAP;   // Keeps the square sum in 32 bits
+                high += c;
+                high_sq += capped * capped;
+            }
+        }
+        if (low + high >= config_.texture_energy) {
+            acc->textured++;
+            acc->texture_ac += low + high;
+            acc->texture_high += high;
+        }
+        size_t bucket = low ? 32 - static_cast<size_t>(__builtin_clz(low)) : 0;
+        if (bucket > FLATNESS_BUCKETS - 1) bucket = FLATNESS_BUCKETS - 1;
+        acc->flat_blocks[bucket]++;
+        acc->flat_high[bucket] += high;
+        acc->flat_sq[bucket] += high_sq;
+    }
+
+    static void finish(const Accumulator& acc, ImageQualityMetrics* out) {
+        *out = ImageQualityMetrics{};
+        out->blocks = acc.blocks;
+        memcpy(out->histogram, acc.histogram, sizeof(out->histogram));
+        uint64_t mean = acc.luma_sum / acc.blocks;
+        out->mean_luma = static_cast<uint8_t>(mean);
+        double variance = static_cast<double>(acc.luma_sq_sum) / acc.blocks -
+                          static_cast<double>(acc.luma_sum) * acc.luma_sum / acc.blocks / acc.blocks;
+        out->contrast = static_cast<uint16_t>(variance > 0 ? sqrt_u64(static_cast<uint64_t>(variance)) : 0);
+        out->dark_pct = static_cast<uint8_t>(acc.dark * 100ull / acc.blocks);
+        out->bright_pct = static_cast<uint8_t>(acc.bright * 100ull / acc.blocks);
+        out->textured_pct = static_cast<uint8_t>(acc.textured * 100ull / acc.blocks);
+
+        // Flattest blocks first until a tenth of the frame is covered
+        uint32_t want = acc.blocks / 10 ? acc.blocks / 10 : 1;
+        uint32_t taken = 0;
+        uint64_t high = 0;
+        uint64_t sq = 0;
+        for (size_t b = 0; b < FLATNESS_BUCKETS && taken < want; b++) {
+            taken += acc.flat_blocks[b];
+            high += acc.flat_high[b];
+            sq += acc.flat_sq[b];
+        }
+        uint64_t coefficients = static_cast<uint64_t>(taken) * (64 - QUALITY_LOW_FREQUENCIES);
+        uint64_t noise = sqrt_u64(sq * 100 / coefficients);   // x10
+        out->noise = static_cast<uint16_t>(noise > UINT16_MAX ? UINT16_MAX : noise);
+
+        // Textured blocks carry the same noise: take the flat blocks'
+        // high-frequency energy off each, or noise would read as detail
+        uint64_t floor = high / taken * acc.textured;
+        if (acc.texture_high > floor && acc.texture_ac > floor) {
+            out->sharpness = static_cast<uint16_t>((acc.texture_high - floor) * 1000 /
+                                                   (acc.texture_ac - floor));
+        }
+    }
+
+    static uint64_t sqrt_u64(uint64_t v) {
+        uint64_t r = 0;
+        for (uint64_t bit = 1ull << 62; bit; bit >>= 2) {
+            if (v >= r + bit) {
+                v -= r + bit;
+                r = (r >> 1) + bit;
+            } else {
+                r >>= 1;
+            }
+        }
+        return r;
+    }
+
+    ImageQualityConfig config_;
+    JpegInfo info_;
+    JpegScanDecoder decoder_;
+};
+
+/**
+ * @brief Alert thresholds (0 disables a check)
+ */
+struct QualityThresholds {
+    uint16_t min_sharpness = 100;     // Per mille: below = blur
+    uint16_t min_contrast = 12;       // Levels: below = low contrast (fog, covered lens)
+    uint8_t max_bright_pct = 40;      // Clipped blocks: above = overexposed (blinded)
+    uint8_t max_dark_pct = 80;        // Dark blocks: above = underexposed
+    uint16_t max_noise = 0;           // Tenths of a level: above = noisy
+};
+
+/**
+ * @brief Alerts raised and cleared after a run of consecutive samples
+ */
+class QualityAlerts {
+public:
+    explicit QualityAlerts(const QualityThresholds& thresholds = {}, uint8_t samples = 3)
+        : thresholds_(thresholds), samples_(samples ? samples : 1) {}
+
+    /**
+     * @brief Alert bits one sample violates on its own
+     */
+    static uint8_t violations(const ImageQualityMetrics& m, const QualityThresholds& t) {
+        uint8_t bits = 0;
+        if (t.min_sharpness && m.sharpness < t.min_sharpness) bits |= QUALITY_ALERT_BLUR;
+        if (t.min_contrast && m.contrast < t.min_contrast) bits |= QUALITY_ALERT_LOW_CONTRAST;
+        if (t.max_bright_pct && m.bright_pct > t.max_bright_pct) bits |= QUALITY_ALERT_OVEREXPOSED;
+        if (t.max_dark_pct && m.dark_pct > t.max_dark_pct) bits |= QUALITY_ALERT_UNDEREXPOSED;
+        if (t.max_noise && m.noise > t.max_noise) bits |= QUALITY_ALERT_NOISE;
+        return bits;
+    }
+
+    /**
+     * @return true if the active alerts changed
+     */
+    bool update(const ImageQualityMetrics& metrics) {
+        uint8_t seen = violations(metrics, thresholds_);
+        uint8_t before = active_;
+        for (size_t i = 0; i < QUALITY_ALERT_COUNT; i++) {
+            uint8_t bit = static_cast<uint8_t>(1u << i);
+            bool differs = ((seen ^ active_) & bit) != 0;
+            streak_[i] = differs ? static_cast<uint8_t>(streak_[i] + 1) : 0;
+            if (streak_[i] >= samples_) {
+                active_ ^= bit;
+                streak_[i] = 0;
+            }
+        }
+        return active_ != before;
+    }
+
+    void reset() {
+        active_ = 0;
+        memset(streak_, 0, sizeof(streak_));
+    }
+
+    uint8_t active() const { return active_; }
+    const QualityThresholds& thresholds() const { return thresholds_; }
+
+private:
+    QualityThresholds thresholds_;
+    uint8_t samples_;
+    uint8_t active_ = 0;
+    uint8_t streak_[QUALITY_ALERT_COUNT] = {};   // Consecutive samples disagreeing with active_
+};
+
+/**
+ * @brief Serialize metrics and active alerts, e.g. as an MQTT event
+ * @return Length written (NUL-terminated), or 0 if the buffer is too small
+ */
+inline size_t format_quality_json(const ImageQualityMetrics& m, uint8_t alerts,
+                                  char* buf, size_t capacity) {
+    if (!buf || capacity == 0) return 0;
+    int n = snprintf(buf, capacity,
+                     "{\"type\":\"quality\",\"sharpness\":%u,\"contrast\":%u,\"noise\":%u.%u,"
+                     "\"mean_luma\":%u,\"dark_pct\":%u,\"bright_pct\":%u,\"alerts\":[",
+                     m.sharpness, m.contrast, m.noise / 10, m.noise % 10,
+                     m.mean_luma, m.dark_pct, m.bright_pct);
+    if (n < 0 || static_cast<size_t>(n) >= capacity) return 0;
+    size_t len = static_cast<size_t>(n);
+    bool first = true;
+    for (size_t i = 0; i < QUALITY_ALERT_COUNT; i++) {
+        if (!(alerts & (1u << i))) continue;
+        n = snprintf(buf + len, capacity - len, "%s\"%s\"", first ? "" : ",", QUALITY_ALERT_NAMES[i]);
+        if (n < 0 || static_cast<size_t>(n) >= capacity - len) return 0;
+        len += static_cast<size_t>(n);
+        first = false;
+    }
+    if (len + 3 > capacity) return 0;
+    buf[len++] = ']';
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
+
+struct QualityMonitorConfig {
+    size_t max_frame_size = 100 * 1024;   // Larger frames are skipped
+    uint32_t sample_interval = 30;        // Analyse every Nth frame
+    uint8_t alert_samples = 3;            // Consecutive samples to raise or clear an alert
+    ImageQualityConfig analysis;
+    QualityThresholds thresholds;
+};
+
+struct QualityMonitorStats {
+    std::atomic<uint32_t> frames_seen{0};
+    std::atomic<uint32_t> frames_analyzed{0};
+    std::atomic<uint32_t> frames_superseded{0};   // Replaced before the task got to them
+    std::atomic<uint32_t> frames_rejected{0};     // Larger than max_frame_size
+    std::atomic<uint32_t> decode_errors{0};
+    std::atomic<uint32_t> alerts_raised{0};
+    std::atomic<uint8_t> alerts_active{0};
+    std::atomic<uint32_t> analyze_us_last{0};
+    std::atomic<uint32_t> analyze_us_max{0};
+    std::atomic<uint64_t> analyze_us_total{0};
+    // Latest sample
+    std::atomic<uint16_t> sharpness{0};
+    std::atomic<uint16_t> contrast{0};
+    std::atomic<uint16_t> noise{0};
+    std::atomic<uint8_t> mean_luma{0};
+    std::atomic<uint8_t> dark_pct{0};
+    std::atomic<uint8_t> bright_pct{0};
+    std::atomic<bool> running{false};
+
+    uint32_t analyze_us_mean() const {
+        uint32_t n = frames_analyzed.load();
+        return n ? static_cast<uint32_t>(analyze_us_total.load() / n) : 0;
+    }
+
+    void reset() {
+        frames_seen = 0;
+        frames_analyzed = 0;
+        frames_superseded = 0;
+        frames_rejected = 0;
+        decode_errors = 0;
+        alerts_raised = 0;
+        alerts_active = 0;
+        analyze_us_last = 0;
+        analyze_us_max = 0;
+        analyze_us_total = 0;
+        sharpness = 0;
+        contrast = 0;
+        noise = 0;
+        mean_luma = 0;
+        dark_pct = 0;
+        bright_pct = 0;
+    }
+};
+
+/**
+ * @brief Called on the quality task when the active alerts change
+ */
+using QualityAlertCallback = void (*)(void* context, uint8_t alerts, const ImageQualityMetrics& metrics);
+
+/**
+ * @brief Called on the quality task with every analysed sample
+ * @param sequence Stream sequence number of the sampled frame
+ */
+using QualityMetricsCallback = void (*)(void* context, const ImageQualityMetrics& metrics, uint32_t sequence);
+
+/**
+ * @brief IFrameSink sampling live frames for image quality
+ *
+ * Usage:
+ *   static QualityMonitor quality;   // Codec tables, off the stack
+ *   quality.init(config);
+ *   quality.set_alert_callback(on_alert, ctx);
+ *   streaming.add_sink(&quality);
+ *   quality.start();
+ */
+class QualityMonitor : public interfaces::IFrameSink {
+public:
+    QualityMonitor() = default;
+    ~QualityMonitor() override { deinit(); }
+
+    // Non-copyable
+    QualityMonitor(const QualityMonitor&) = delete;
+    QualityMonitor& operator=(const QualityMonitor&) = delete;
+
+    /**
+     * @brief Allocate the hand-over buffers
+     * @param use_psram Use PSRAM for the buffers (ESP32 only)
+     */
+    bool init(const QualityMonitorConfig& config, bool use_psram = true) {
+        if (initialized_) return true;
+        if (config.max_frame_size == 0) return false;
+        config_ = config;
+        if (config_.sample_interval == 0) config_.sample_interval = 1;
+        analyzer_.set_config(config_.analysis);
+        alerts_ = QualityAlerts(config_.thresholds, config_.alert_samples);
+        for (auto*& buf : frames_) {
+#ifdef ESP_PLATFORM
+            buf = static_cast<uint8_t*>(use_psram ? heap_caps_malloc(config_.max_frame_size, MALLOC_CAP_SPIRAM)
+                                                  : malloc(config_.max_frame_size));
+#else
+            (void)use_psram;
+            buf = static_cast<uint8_t*>(malloc(config_.max_frame_size));
+#endif
+            if (!buf) {
+                deinit();
+                return false;
+            }
+        }
+        pending_ = frames_[0];
+        analysing_ = frames_[1];
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        work_ready_ = xSemaphoreCreateBinary();
+        if (!mutex_ || !work_ready_) {
+            deinit();
+            return false;
+        }
+#endif
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        stop();
+        for (auto*& buf : frames_) {
+            if (!buf) continue;
+#ifdef ESP_PLATFORM
+            heap_caps_free(buf);
+#else
+            free(buf);
+#endif
+            buf = nullptr;
+        }
+        pending_ = nullptr;
+        analysing_ = nullptr;
+        has_pending_ = false;
+
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+        if (work_ready_) {
+            vSemaphoreDelete(work_ready_);
+            work_ready_ = nullptr;
+        }
+#endif
+        initialized_ = false;
+    }
+
+    bool start() {
+        if (!initialized_) return false;
+        if (stats_.running.load()) return true;
+        stop_requested_ = false;
+        stats_.reset();
+        alerts_.reset();
+        frame_count_ = 0;
+        have_latest_ = false;
+        stats_.running = true;
+
+#ifdef ESP_PLATFORM
+        // Lowest priority: a late sample costs nothing
+        if (xTaskCreatePinnedToCore(quality_task_wrapper, "quality", 4096, this, 1,
+                                    &quality_task_, 0) != pdPASS) {
+            stats_.running = false;
+            return false;
+        }
+#else
+        quality_thread_ = std::thread(&QualityMonitor::quality_loop, this);
+#endif
+        return true;
+    }
+
+    void stop() {
+        stop_requested_ = true;
+#ifdef ESP_PLATFORM
+        if (work_ready_) xSemaphoreGive(work_ready_);
+        for (int i = 0; i < 50 && stats_.running.load(); i++) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        if (quality_task_ && stats_.running.load()) {
+            vTaskDelete(quality_task_);
+            stats_.running = false;
+        }
+        quality_task_ = nullptr;
+#else
+        wake();
+        if (quality_thread_.joinable()) quality_thread_.join();
+        stats_.running = false;
+#endif
+    }
+
+    // IFrameSink: copy every sample_interval-th frame into the pending slot
+    void on_frame(const uint8_t* data, size_t size,
+                  int64_t timestamp_us, uint32_t sequence) override {
+        (void)timestamp_us;
+        if (!initialized_ || !stats_.running.load()) return;
+        stats_.frames_seen++;
+        if (frame_count_++ % config_.sample_interval != 0) return;
+        if (!data || size == 0 || size > config_.max_frame_size) {
+            stats_.frames_rejected++;
+            return;
+        }
+
+        lock();
+        if (has_pending_) stats_.frames_superseded++;
+        memcpy(pending_, data, size);
+        pending_size_ = size;
+        pending_sequence_ = sequence;
+        has_pending_ = true;
+        unlock();
+        wake();
+    }
+
+    /**
+     * @brief Called when the active alerts change (set before start())
+     */
+    void set_alert_callback(QualityAlertCallback callback, void* context) {
+        callback_ = callback;
+        callback_context_ = context;
+    }
+
+    /**
+     * @brief Called with every sample's metrics, e.g. for an ExposureController (set before start())
+     */
+    void set_metrics_callback(QualityMetricsCallback callback, void* context) {
+        metrics_callback_ = callback;
+        metrics_context_ = context;
+    }
+
+    /**
+     * @brief Copy of the latest sample's metrics (histogram included)
+     * @return false if no frame has been analysed yet
+     */
+    bool latest(ImageQualityMetrics* out) {
+        lock();
+        bool have = have_latest_;
+        if (have && out) *out = latest_;
+        unlock();
+        return have;
+    }
+
+    uint8_t alerts() const { return stats_.alerts_active.load(); }
+    const QualityMonitorStats& stats() const { return stats_; }
+    const QualityMonitorConfig& config() const { return config_; }
+    bool is_running() const { return stats_.running.load(); }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    static constexpr uint32_t IDLE_WAIT_MS = 1000;
+
+#ifdef ESP_PLATFORM
+    static void quality_task_wrapper(void* arg) {
+        static_cast<QualityMonitor*>(arg)->quality_loop();
+        vTaskDelete(nullptr);
+    }
+#endif
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    void wake() {
+#ifdef ESP_PLATFORM
+        if (work_ready_) xSemaphoreGive(work_ready_);
+#else
+        {
+            std::lock_guard<std::mutex> guard(wake_mutex_);
+            work_flag_ = true;
+        }
+        wake_cv_.notify_one();
+#endif
+    }
+
+    void wait_for_work(uint32_t timeout_ms) {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(work_ready_, pdMS_TO_TICKS(timeout_ms));
+#else
+        std::unique_lock<std::mutex> guard(wake_mutex_);
+        wake_cv_.wait_for(guard, std::chrono::milliseconds(timeout_ms),
+                          [this] { return work_flag_ || stop_requested_.load(); });
+        work_flag_ = false;
+#endif
+    }
+
+    static int64_t now_us() {
+#ifdef ESP_PLATFORM
+        return esp_timer_get_time();
+#else
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    void quality_loop() {
+        while (!stop_requested_.load()) {
+            lock();
+            bool taken = has_pending_;
+            size_t size = pending_size_;
+            uint32_t sequence = pending_sequence_;
+            if (taken) {
+                uint8_t* tmp = analysing_;
+                analysing_ = pending_;
+                pending_ = tmp;
+                has_pending_ = false;
+            }
+            unlock();
+
+            if (!taken) {
+                wait_for_work(IDLE_WAIT_MS);
+                continue;
+            }
+
+            ImageQualityMetrics metrics;
+            int64_t start = now_us();
+            bool ok = analyzer_.analyze(analysing_, size, &metrics);
+            uint32_t elapsed = static_cast<uint32_t>(now_us() - start);
+            if (!ok) {
+                stats_.decode_errors++;
+                continue;
+            }
+            record(metrics, elapsed);
+            if (metrics_callback_) metrics_callback_(metrics_context_, metrics, sequence);
+        }
+        stats_.running = false;
+    }
+
+    void record(const ImageQualityMetrics& metrics, uint32_t elapsed_us) {
+        stats_.frames_analyzed++;
+        stats_.analyze_us_last = elapsed_us;
+        stats_.analyze_us_total += elapsed_us;
+        if (elapsed_us > stats_.analyze_us_max.load()) stats_.analyze_us_max = elapsed_us;
+        stats_.sharpness = metrics.sharpness;
+        stats_.contrast = metrics.contrast;
+        stats_.noise = metrics.noise;
+        stats_.mean_luma = metrics.mean_luma;
+        stats_.dark_pct = metrics.dark_pct;
+        stats_.bright_pct = metrics.bright_pct;
+        lock();
+        latest_ = metrics;
+        have_latest_ = true;
+        unlock();
+
+        uint8_t before = alerts_.active();
+        if (!alerts_.update(metrics)) return;
+        uint8_t raised = alerts_.active() & ~before;
+        for (; raised; raised &= static_cast<uint8_t>(raised - 1)) stats_.alerts_raised++;
+        stats_.alerts_active = alerts_.active();
+        if (callback_) callback_(callback_context_, alerts_.active(), metrics);
+    }
+
+    QualityMonitorConfig config_;
+    QualityMonitorStats stats_;
+    ImageQualityAnalyzer analyzer_;     // Quality task only
+    QualityAlerts alerts_;              // Quality task only
+    QualityAlertCallback callback_ = nullptr;
+    void* callback_context_ = nullptr;
+    QualityMetricsCallback metrics_callback_ = nullptr;
+    void* metrics_context_ = nullptr;
+
+    uint8_t* frames_[2] = {nullptr, nullptr};
+    uint8_t* pending_ = nullptr;     // Written by the producer under the lock
+    uint8_t* analysing_ = nullptr;   // Owned by the quality task
+    size_t pending_size_ = 0;
+    uint32_t pending_sequence_ = 0;
+    bool has_pending_ = false;
+    uint32_t frame_count_ = 0;       // Producer only
+    ImageQualityMetrics latest_;     // Under the lock
+    bool have_latest_ = false;
+
+    std::atomic<bool> stop_requested_{false};
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t quality_task_ = nullptr;
+    SemaphoreHandle_t mutex_ = nullptr;
+    SemaphoreHandle_t work_ready_ = nullptr;
+#else
+    std::thread quality_thread_;
+    std::mutex mutex_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool work_flag_ = false;
+#endif
+};
+
+} // namespace core
@@ -0,0 +1,854 @@
+/**
+ * @file jpeg_codec.hpp
+ * @brief Baseline JPEG parsing and entropy coding in the coefficient domain
+ *
+ * Design: Walks a baseline (SOF0/SOF1, 8-bit, Huffman) scan MCU by MCU and
+ * hands out quantized DCT coefficients without IDCT or colour conversion.
+ * Features that only move or tweak coefficients (cropping, masking, metadata)
+ * transcode the entropy-coded data directly with O(1) working memory.
+ *
+ * Output always uses the standard Annex K Huffman tables, which cover every
+ * baseline symbol, so any decoded block can be re-encoded.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace core {
+
+static constexpr size_t JPEG_MAX_COMPONENTS = 3;
+static constexpr size_t JPEG_MAX_BLOCKS_PER_MCU = 10;
+
+namespace jpeg_marker {
+    static constexpr uint8_t SOF0 = 0xC0;
+    static constexpr uint8_t SOF1 = 0xC1;
+    static constexpr uint8_t DHT  = 0xC4;
+    static constexpr uint8_t RST0 = 0xD0;
+    static constexpr uint8_t SOI  = 0xD8;
+    static constexpr uint8_t EOI  = 0xD9;
+    static constexpr uint8_t SOS  = 0xDA;
+    static constexpr uint8_t DQT  = 0xDB;
+    static constexpr uint8_t DRI  = 0xDD;
+    static constexpr uint8_t APP0 = 0xE0;
+    static constexpr uint8_t COM  = 0xFE;
+}
+
+// Zigzag position -> natural (row-major) index inside an 8x8 block
+inline constexpr uint8_t JPEG_NATURAL_ORDER[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Standard Huffman tables (ITU T.81 Annex K.3)
+inline constexpr uint8_t JPEG_STD_DC_LUMA_COUNTS[16] = {0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
+inline constexpr uint8_t JPEG_STD_DC_CHROMA_COUNTS[16] = {0,3,1,1,1,1,1,1,1,1,1,0,0,0,0,0};
+inline constexpr uint8_t JPEG_STD_DC_SYMBOLS[12] = {0,1,2,3,4,5,6,7,8,9,10,11};
+
+inline constexpr uint8_t JPEG_STD_AC_LUMA_COUNTS[16] = {0,2,1,3,3,2,4,3,5,5,4,4,0,0,1,0x7d};
+inline constexpr uint8_t JPEG_STD_AC_LUMA_SYMBOLS[162] = {
+    0x01,0x02,0x03,0x00,0x04,0x11,0x05,0x12,0x21,0x31,0x41,0x06,0x13,0x51,0x61,0x07,
+    0x22,0x71,0x14,0x32,0x81,0x91,0xa1,0x08,0x23,0x42,0xb1,0xc1,0x15,0x52,0xd1,0xf0,
+    0x24,0x33,0x62,0x72,0x82,0x09,0x0a,0x16,0x17,0x18,0x19,0x1a,0x25,0x26,0x27,0x28,
+    0x29,0x2a,0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,
+    0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,
+    0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x83,0x84,0x85,0x86,0x87,0x88,0x89,
+    0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,
+    0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,
+    0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,0xe1,0xe2,
+    0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,
+    0xf9,0xfa
+};
+
+inline constexpr uint8_t JPEG_STD_AC_CHROMA_COUNTS[16] = {0,2,1,2,4,4,3,4,7,5,4,4,0,1,2,0x77};
+inline constexpr uint8_t JPEG_STD_AC_CHROMA_SYMBOLS[162] = {
+    0x00,0x01,0x02,0x03,0x11,0x04,0x05,0x21,0x31,0x06,0x12,0x41,0x51,0x07,0x61,0x71,
+    0x13,0x22,0x32,0x81,0x08,0x14,0x42,0x91,0xa1,0xb1,0xc1,0x09,0x23,0x33,0x52,0xf0,
+    0x15,0x62,0x72,0xd1,0x0a,0x16,0x24,0x34,0xe1,0x25,0xf1,0x17,0x18,0x19,0x1a,0x26,
+    0x27,0x28,0x29,0x2a,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,
+    0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,
+    0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x82,0x83,0x84,0x85,0x86,0x87,
+    0x88,0x89,0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,
+    0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,
+    0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,
+    0xe2,0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,
+    0xf9,0xfa
+};
+
+struct JpegComponent {
+    uint8_t id = 0;
+    uint8_t h = 1;        // Horizontal sampling factor
+    uint8_t v = 1;        // Vertical sampling factor
+    uint8_t tq = 0;       // Quantization table index
+    uint8_t td = 0;       // DC Huffman table index (from SOS)
+    uint8_t ta = 0;       // AC Huffman table index (from SOS)
+};
+
+struct JpegHuffmanSpec {
+    bool present = false;
+    uint8_t counts[16] = {0};
+    uint8_t symbols[256] = {0};
+};
+
+/**
+ * @brief Parsed baseline JPEG headers plus derived MCU geometry
+ *
+ * Also used to describe output images: fill width/height/components/quant,
+ * then call jpeg_compute_layout().
+ */
+struct JpegInfo {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint8_t num_components = 0;
+    JpegComponent components[JPEG_MAX_COMPONENTS];
+    uint16_t quant[4][64] = {};          // Zigzag order
+    bool quant_present[4] = {};
+    JpegHuffmanSpec dc_tables[4];
+    JpegHuffmanSpec ac_tables[4];
+    uint16_t restart_interval = 0;       // MCUs per restart interval (0 = none)
+
+    size_t scan_offset = 0;              // First byte of entropy-coded data
+    size_t scan_size = 0;                // Entropy-coded bytes (up to EOI)
+
+    // Derived by jpeg_compute_layout()
+    uint8_t max_h = 1;
+    uint8_t max_v = 1;
+    uint16_t mcu_width = 8;
+    uint16_t mcu_height = 8;
+    uint16_t mcus_x = 0;
+    uint16_t mcus_y = 0;
+    uint8_t blocks_per_mcu = 0;
+    uint8_t block_component[JPEG_MAX_BLOCKS_PER_MCU] = {};
+
+    uint32_t total_mcus() const { return static_cast<uint32_t>(mcus_x) * mcus_y; }
+};
+
+/**
+ * @brief Derive MCU geometry from dimensions and sampling factors
+ * @return false if the layout is not representable in a baseline scan
+ */
+inline bool jpeg_compute_layout(JpegInfo& info) {
+    if (info.width == 0 || info.height == 0) return false;
+    if (info.num_components == 0 || info.num_components > JPEG_MAX_COMPONENTS) return false;
+
+    info.max_h = 1;
+    info.max_v = 1;
+    for (uint8_t c = 0; c < info.num_components; c++) {
+        const auto& comp = info.components[c];
+        if (comp.h < 1 || comp.h > 4 || comp.v < 1 || comp.v > 4) return false;
+        if (comp.h > info.max_h) info.max_h = comp.h;
+        if (comp.v > info.max_v) info.max_v = comp.v;
+    }
+
+    if (info.num_components == 1) {
+        // Non-interleaved scan: one block per MCU regardless of sampling factors
+        info.mcu_width = 8;
+        info.mcu_height = 8;
+        info.blocks_per_mcu = 1;
+        info.block_component[0] = 0;
+    } else {
+        info.mcu_width = 8 * info.max_h;
+        info.mcu_height = 8 * info.max_v;
+        uint8_t n = 0;
+        for (uint8_t c = 0; c < info.num_components; c++) {
+            const auto& comp = info.components[c];
+            for (uint8_t i = 0; i < comp.h * comp.v; i++) {
+                if (n >= JPEG_MAX_BLOCKS_PER_MCU) return false;
+                info.block_component[n++] = c;
+            }
+        }
+        info.blocks_per_mcu = n;
+    }
+
+    info.mcus_x = static_cast<uint16_t>((info.width + info.mcu_width - 1) / info.mcu_width);
+    info.mcus_y = static_cast<uint16_t>((info.height + info.mcu_height - 1) / info.mcu_height);
+    return true;
+}
+
+/**
+ * @brief Parse headers of a baseline JPEG up to the start of scan data
+ * @return false for progressive/arithmetic/12-bit files, multi-scan files or
+ *         truncated/malformed headers
+ */
+inline bool jpeg_parse(const uint8_t* data, size_t size, JpegInfo* info) {
+    if (!data || !info || size < 4) return false;
+    if (data[0] != 0xFF || data[1] != jpeg_marker::SOI) return false;
+
+    *info = JpegInfo{};
+    bool have_sof = false;
+    size_t pos = 2;
+
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) return false;
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) { pos++; continue; }   // Fill byte
+        pos += 2;
+
+        if (marker == jpeg_marker::EOI) return false;  // No scan
+        if (marker >= jpeg_marker::RST0 && marker <= jpeg_marker::RST0 + 7) continue;
+
+        uint16_t len = static_cast<uint16_t>((data[pos] << 8) | data[pos + 1]);
+        if (len < 2 || pos + len > size) return false;
+        const uint8_t* seg = data + pos + 2;
+        size_t seg_len = len - 2;
+
+        switch (marker) {
+            case jpeg_marker::DQT: {
+                size_t i = 0;
+                while (i < seg_len) {
+                    uint8_t pq = seg[i] >> 4;
+                    uint8_t tq = seg[i] & 0x0F;
+                    i++;
+                    if (tq > 3 || pq > 1) return false;
+                    size_t need = pq ? 128 : 64;
+                    if (i + need > seg_len) return false;
+                    for (size_t k = 0; k < 64; k++) {
+                        info->quant[tq][k] = pq
+                            ? static_cast<uint16_t>((seg[i + 2 * k] << 8) | seg[i + 2 * k + 1])
+                            : seg[i + k];
+                    }
+                    info->quant_present[tq] = true;
+                    i += need;
+                }
+                break;
+            }
+            case jpeg_marker::SOF0:
+            case jpeg_marker::SOF1: {
+                if (seg_len < 6 || seg[0] != 8) return false;
+                info->height = static_cast<uint16_t>((seg[1] << 8) | seg[2]);
+                info->width = static_cast<uint16_t>((seg[3] << 8) | seg[4]);
+                info->num_components = seg[5];
+                if (info->num_components == 0 || info->num_components > JPEG_MAX_COMPONENTS) return false;
+                if (seg_len < 6u + 3u * info->num_components) return false;
+                for (uint8_t c = 0; c < info->num_components; c++) {
+                    auto& comp = info->components[c];
+                    comp.id = seg[6 + 3 * c];
+                    comp.h = seg[7 + 3 * c] >> 4;
+                    comp.v = seg[7 + 3 * c] & 0x0F;
+                    comp.tq = seg[8 + 3 * c];
+                    if (comp.tq > 3) return false;
+                }
+                have_sof = true;
+                break;
+            }
+            case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                return false;  // Progressive, lossless, hierarchical or arithmetic
+            case jpeg_marker::DHT: {
+                size_t i = 0;
+                while (i < seg_len) {
+                    uint8_t tc = seg[i] >> 4;
+                    uint8_t th = seg[i] & 0x0F;
+                    i++;
+                    if (tc > 1 || th > 3 || i + 16 > seg_len) return false;
+                    JpegHuffmanSpec& spec = tc ? info->ac_tables[th] : info->dc_tables[th];
+                    size_t total = 0;
+                    for (int k = 0; k < 16; k++) {
+                        spec.counts[k] = seg[i + k];
+                        total += seg[i + k];
+                    }
+                    i += 16;
+                    if (total > 256 || i + total > seg_len) return false;
+                    memcpy(spec.symbols, seg + i, total);
+                    spec.present = true;
+                    i += total;
+                }
+                break;
+            }
+            case jpeg_marker::DRI:
+                if (seg_len < 2) return false;
+                info->restart_interval = static_cast<uint16_t>((seg[0] << 8) | seg[1]);
+                break;
+            case jpeg_marker::SOS: {
+                if (!have_sof || seg_len < 1) return false;
+                uint8_t ns = seg[0];
+                // Only a single scan carrying every component is supported
+                if (ns != info->num_components || seg_len < 1u + 2u * ns + 3u) return false;
+                for (uint8_t s = 0; s < ns; s++) {
+                    uint8_t cid = seg[1 + 2 * s];
+                    bool found = false;
+                    for (uint8_t c = 0; c < info->num_components; c++) {
+                        if (info->components[c].id == cid) {
+                            info->components[c].td = seg[2 + 2 * s] >> 4;
+                            info->components[c].ta = seg[2 + 2 * s] & 0x0F;
+                            if (info->components[c].td > 3 || info->components[c].ta > 3) return false;
+                            found = true;
+                            break;
+                        }
+                    }
+                    if (!found) return false;
+                }
+                if (!jpeg_compute_layout(*info)) return false;
+
+                info->scan_offset = pos + len;
+                // Locate EOI from the end (sensor buffers may carry padding)
+                size_t end = size;
+                for (size_t p = size; p >= info->scan_offset + 2; p--) {
+                    if (data[p - 2] == 0xFF && data[p - 1] == jpeg_marker::EOI) {
+                        end = p - 2;
+                        break;
+                    }
+                }
+                info->scan_size = end - info->scan_offset;
+                return true;
+            }
+            default:
+                break;  // APPn, COM and others are skipped
+        }
+        pos += len;
+    }
+    return false;
+}
+
+/**
+ * @brief True if every component uses the Annex K tables jpeg_write_headers() emits
+ *
+ * Entropy-coded data from such a file can be moved under rebuilt headers
+ * without re-encoding.
+ */
+inline bool jpeg_uses_standard_huffman(const JpegInfo& info) {
+    auto same = [](const JpegHuffmanSpec& spec, const uint8_t* counts,
+                   const uint8_t* symbols, size_t total) {
+        if (!spec.present) return false;
+        return memcmp(spec.counts, counts, 16) == 0 && memcmp(spec.symbols, symbols, total) == 0;
+    };
+    for (uint8_t c = 0; c < info.num_components; c++) {
+        const auto& comp = info.components[c];
+        bool luma = c == 0;
+        if (!same(info.dc_tables[comp.td], luma ? JPEG_STD_DC_LUMA_COUNTS : JPEG_STD_DC_CHROMA_COUNTS,
+                  JPEG_STD_DC_SYMBOLS, 12)) return false;
+        if (!same(info.ac_tables[comp.ta], luma ? JPEG_STD_AC_LUMA_COUNTS : JPEG_STD_AC_CHROMA_COUNTS,
+                  luma ? JPEG_STD_AC_LUMA_SYMBOLS : JPEG_STD_AC_CHROMA_SYMBOLS, 162)) return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// Huffman decoding
+// =============================================================================
+
+/**
+ * @brief Reads entropy-coded bits, removing 0xFF00 byte stuffing
+ *
+ * Stops at the first marker and feeds zero bits past it, as decoders are
+ * required to do. restart() consumes an RSTn marker and realigns.
+ */
+class JpegBitReader {
+public:
+    void begin(const uint8_t* data, size_t size) {
+        start_ = data;
+        p_ = data;
+        end_ = data + size;
+        buf_ = 0;
+        count_ = 0;
+        marker_ = false;
+    }
+
+    uint32_t peek(int n) {
+        if (count_ < n) fill();
+        return static_cast<uint32_t>(buf_ >> (64 - n));
+    }
+
+    void skip(int n) {
+        buf_ <<= n;
+        count_ -= n;
+    }
+
+    uint32_t get(int n) {
+        uint32_t v = peek(n);
+        skip(n);
+        return v;
+    }
+
+    /**
+     * @brief Discard padding bits and consume the next RSTn marker
+     * @return true if a restart marker was found
+     */
+    bool restart() {
+        buf_ = 0;
+        count_ = 0;
+        while (p_ + 1 < end_) {
+            if (p_[0] == 0xFF) {
+                uint8_t m = p_[1];
+                if (m >= jpeg_marker::RST0 && m <= jpeg_marker::RST0 + 7) {
+                    p_ += 2;
+                    marker_ = false;
+                    return true;
+                }
+                if (m != 0x00 && m != 0xFF) return false;  // Some other marker
+            }
+            p_++;
+        }
+        return false;
+    }
+
+    // Offset of the next unread byte relative to begin()
+    size_t position() const { return static_cast<size_t>(p_ - start_); }
+    bool exhausted() const { return marker_ && count_ <= 0; }
+
+private:
+    void fill() {
+        while (count_ <= 56) {
+            uint64_t b = 0;
+            if (!marker_) {
+                if (p_ >= end_) {
+                    marker_ = true;
+                } else if (*p_ == 0xFF) {
+                    if (p_ + 1 < end_ && p_[1] == 0x00) {
+                        b = 0xFF;
+                        p_ += 2;
+                    } else {
+                        marker_ = true;
+                    }
+                } else {
+                    b = *p_++;
+                }
+            }
+            buf_ |= b << (56 - count_);
+            count_ += 8;
+        }
+    }
+
+    const uint8_t* start_ = nullptr;
+    const uint8_t* p_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    uint64_t buf_ = 0;
+    int count_ = 0;
+    bool marker_ = false;
+};
+
+/**
+ * @brief Derived decoding table with 8-bit lookahead
+ */
+class JpegHuffmanDecoder {
+public:
+    bool build(const JpegHuffmanSpec& spec) {
+        if (!spec.present) return false;
+        memset(lookup_, 0, sizeof(lookup_));
+
+        int32_t code = 0;
+        int32_t k = 0;
+        for (int len = 1; len <= 16; len++) {
+            int n = spec.counts[len - 1];
+            valoffset_[len] = k - code;
+            for (int i = 0; i < n; i++) {
+                uint8_t sym = spec.symbols[k];
+                if (len <= 8) {
+                    int shift = 8 - len;
+                    int first = code << shift;
+                    for (int j = 0; j < (1 << shift); j++) {
+                        lookup_[first + j] = static_cast<uint16_t>((len << 8) | sym);
+                    }
+                }
+                code++;
+                k++;
+            }
+            if (code > (1 << len)) return false;  // Over-subscribed table
+            maxcode_[len] = n ? code - 1 : -1;
+            code <<= 1;
+        }
+        memcpy(symbols_, spec.symbols, sizeof(symbols_));
+        return true;
+    }
+
+    // @return symbol, or -1 on an invalid code
+    int decode(JpegBitReader& br) const {
+        uint16_t e = lookup_[br.peek(8)];
+        if (e) {
+            br.skip(e >> 8);
+            return e & 0xFF;
+        }
+        uint32_t bits = br.peek(16);
+        for (int len = 9; len <= 16; len++) {
+            int32_t c = static_cast<int32_t>(bits >> (16 - len));
+            if (c <= maxcode_[len]) {
+                br.skip(len);
+                return symbols_[c + valoffset_[len]];
+            }
+        }
+        return -1;
+    }
+
+private:
+    uint16_t lookup_[256] = {};       // (length << 8) | symbol, 0 = longer code
+    int32_t maxcode_[17] = {};
+    int32_t valoffset_[17] = {};
+    uint8_t symbols_[256] = {};
+};
+
+/**
+ * @brief Streams a baseline scan one MCU at a time
+ *
+ * Blocks are returned in zigzag order with absolute (de-predicted) DC values,
+ * ordered per JpegInfo::block_component.
+ */
+class JpegScanDecoder {
+public:
+    bool begin(const uint8_t* data, size_t size, const JpegInfo& info) {
+        if (!data || info.scan_offset + info.scan_size > size) return false;
+        info_ = &info;
+        for (uint8_t c = 0; c < info.num_components; c++) {
+            const auto& comp = info.components[c];
+            if (!dc_[c].build(info.dc_tables[comp.td])) return false;
+            if (!ac_[c].build(info.ac_tables[comp.ta])) return false;
+        }
+        reader_.begin(data + info.scan_offset, info.scan_size);
+        memset(pred_, 0, sizeof(pred_));
+        mcu_count_ = 0;
+        at_interval_start_ = false;
+        return true;
+    }
+
+    /**
+     * @brief Decode the next MCU
+     * @param blocks Output: blocks_per_mcu blocks of 64 coefficients
+     * @return false on corrupt data or past the last MCU
+     */
+    bool decode_mcu(int16_t (*blocks)[64]) {
+        if (!info_ || mcu_count_ >= info_->total_mcus()) return false;
+        if (info_->restart_interval && mcu_count_ > 0 &&
+            mcu_count_ % info_->restart_interval == 0 && !at_interval_start_) {
+            if (!reader_.restart()) return false;
+            memset(pred_, 0, sizeof(pred_));
+        }
+        at_interval_start_ = false;
+        for (uint8_t b = 0; b < info_->blocks_per_mcu; b++) {
+            uint8_t c = info_->block_component[b];
+            if (!decode_block(blocks[b], dc_[c], ac_[c], pred_[c])) return false;
+        }
+        mcu_count_++;
+        return true;
+    }
+
+    /**
+     * @brief Skip whole restart intervals without Huffman decoding
+     *
+     * Only valid when positioned at an interval boundary.
+     * @return false if the file has no restart markers or data runs out
+     */
+    bool skip_intervals(uint32_t count) {
+        if (!info_ || info_->restart_interval == 0) return false;
+        if (mcu_count_ % info_->restart_interval != 0) return false;
+        if (count == 0) return true;
+        // Consume the marker that closes the interval just decoded
+        if (mcu_count_ > 0 && !at_interval_start_ && !reader_.restart()) return false;
+        for (uint32_t i = 0; i < count; i++) {
+            mcu_count_ += info_->restart_interval;
+            if (mcu_count_ >= info_->total_mcus()) break;  // Last interval has no marker
+            if (!reader_.restart()) return false;
+        }
+        memset(pred_, 0, sizeof(pred_));
+        at_interval_start_ = true;
+        return true;
+    }
+
+    uint32_t mcus_decoded() const { return mcu_count_; }
+    size_t byte_position() const { return reader_.position(); }
+
+private:
+    bool decode_block(int16_t* blk, const JpegHuffmanDecoder& dc,
+                      const JpegHuffmanDecoder& ac, int16_t& pred) {
+        memset(blk, 0, 64 * sizeof(int16_t));
+
+        int s = dc.decode(reader_);
+        if (s < 0 || s > 11) return false;
+        int diff = s ? extend(reader_.get(s), s) : 0;
+        pred = static_cast<int16_t>(pred + diff);
+        blk[0] = pred;
+
+        for (int k = 1; k < 64;) {
+            int rs = ac.decode(reader_);
+            if (rs < 0) return false;
+            int r = rs >> 4;
+            s = rs & 0x0F;
+            if (s == 0) {
+                if (r != 15) break;  // EOB
+                k += 16;             // ZRL
+                continue;
+            }
+            k += r;
+            if (k > 63) return false;
+            blk[k++] = static_cast<int16_t>(extend(reader_.get(s), s));
+        }
+        return true;
+    }
+
+    static int extend(uint32_t v, int s) {
+        return v < (1u << (s - 1)) ? static_cast<int>(v) - (1 << s) + 1 : static_cast<int>(v);
+    }
+
+    const JpegInfo* info_ = nullptr;
+    JpegBitReader reader_;
+    JpegHuffmanDecoder dc_[JPEG_MAX_COMPONENTS];
+    JpegHuffmanDecoder ac_[JPEG_MAX_COMPONENTS];
+    int16_t pred_[JPEG_MAX_COMPONENTS] = {};
+    uint32_t mcu_count_ = 0;
+    bool at_interval_start_ = false;   // RSTn already consumed by skip_intervals()
+};
+
+// =============================================================================
+// Huffman encoding
+// =============================================================================
+
+/**
+ * @brief Bounded byte writer over a caller-owned buffer
+ *
+ * Never reallocates: on overflow it stops writing and sets overflow(), so the
+ * scratch memory can be pre-allocated in PSRAM like FrameBuffer slots.
+ */
+class JpegByteWriter {
+public:
+    JpegByteWriter(uint8_t* buf, size_t capacity) : buf_(buf), cap_(capacity) {}
+
+    void put(uint8_t b) {
+        if (pos_ < cap_) buf_[pos_++] = b;
+        else overflow_ = true;
+    }
+
+    void put16(uint16_t v) {
+        put(static_cast<uint8_t>(v >> 8));
+        put(static_cast<uint8_t>(v & 0xFF));
+    }
+
+    void write(const uint8_t* data, size_t n) {
+        if (pos_ + n > cap_) {
+            overflow_ = true;
+            return;
+        }
+        memcpy(buf_ + pos_, data, n);
+        pos_ += n;
+    }
+
+    void marker(uint8_t m) {
+        put(0xFF);
+        put(m);
+    }
+
+    size_t size() const { return pos_; }
+    bool overflow() const { return overflow_; }
+
+private:
+    uint8_t* buf_;
+    size_t cap_;
+    size_t pos_ = 0;
+    bool overflow_ = false;
+};
+
+class JpegHuffmanEncoder {
+public:
+    bool build(const uint8_t* counts, const uint8_t* symbols) {
+        memset(size_, 0, sizeof(size_));
+        uint16_t code = 0;
+        int k = 0;
+        for (int len = 1; len <= 16; len++) {
+            for (int i = 0; i < counts[len - 1]; i++) {
+                code_[symbols[k]] = code++;
+                size_[symbols[k]] = static_cast<uint8_t>(len);
+                k++;
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    uint16_t code(uint8_t sym) const { return code_[sym]; }
+    uint8_t size(uint8_t sym) const { return size_[sym]; }
+
+private:
+    uint16_t code_[256] = {};
+    uint8_t size_[256] = {};
+};
+
+/**
+ * @brief Encodes MCUs with the standard tables (luma: table 0, chroma: table 1)
+ */
+class JpegScanEncoder {
+public:
+    JpegScanEncoder() {
+        dc_[0].build(JPEG_STD_DC_LUMA_COUNTS, JPEG_STD_DC_SYMBOLS);
+        ac_[0].build(JPEG_STD_AC_LUMA_COUNTS, JPEG_STD_AC_LUMA_SYMBOLS);
+        dc_[1].build(JPEG_STD_DC_CHROMA_COUNTS, JPEG_STD_DC_SYMBOLS);
+        ac_[1].build(JPEG_STD_AC_CHROMA_COUNTS, JPEG_STD_AC_CHROMA_SYMBOLS);
+    }
+
+    void begin(JpegByteWriter& out, const JpegInfo& info) {
+        out_ = &out;
+        info_ = &info;
+        acc_ = 0;
+        nbits_ = 0;
+        mcu_count_ = 0;
+        restart_index_ = 0;
+        memset(pred_, 0, sizeof(pred_));
+    }
+
+    void encode_mcu(const int16_t (*blocks)[64]) {
+        if (info_->restart_interval && mcu_count_ > 0 &&
+            mcu_count_ % info_->restart_interval == 0) {
+            flush_bits();
+            out_->marker(static_cast<uint8_t>(jpeg_marker::RST0 + (restart_index_++ & 7)));
+            memset(pred_, 0, sizeof(pred_));
+        }
+        for (uint8_t b = 0; b < info_->blocks_per_mcu; b++) {
+            uint8_t c = info_->block_component[b];
+            uint8_t t = c == 0 ? 0 : 1;
+            encode_block(blocks[b], dc_[t], ac_[t], pred_[c]);
+        }
+        mcu_count_++;
+    }
+
+    // Pad the final byte with 1-bits
+    void finish() { flush_bits(); }
+
+    uint32_t mcus_encoded() const { return mcu_count_; }
+
+private:
+    void put_bits(uint32_t bits, int n) {
+        acc_ = (acc_ << n) | (bits & ((1u << n) - 1));
+        nbits_ += n;
+        while (nbits_ >= 8) {
+            uint8_t byte = static_cast<uint8_t>(acc_ >> (nbits_ - 8));
+            out_->put(byte);
+            if (byte == 0xFF) out_->put(0x00);
+            nbits_ -= 8;
+        }
+    }
+
+    void flush_bits() {
+        if (nbits_ > 0) put_bits(0x7F, 8 - nbits_);
+        acc_ = 0;
+    }
+
+    static int bit_length(int v) {
+        unsigned a = static_cast<unsigned>(v < 0 ? -v : v);
+        int n = 0;
+        while (a) { n++; a >>= 1; }
+        return n;
+    }
+
+    void put_value(int v, int s) {
+        if (s == 0) return;
+        put_bits(static_cast<uint32_t>(v < 0 ? v - 1 : v), s);
+    }
+
+    void encode_block(const int16_t* blk, const JpegHuffmanEncoder& dc,
+                      const JpegHuffmanEncoder& ac, int16_t& pred) {
+        int diff = blk[0] - pred;
+        pred = blk[0];
+        int s = bit_length(diff);
+        if (s > 11) s = 11;
+        put_bits(dc.code(static_cast<uint8_t>(s)), dc.size(static_cast<uint8_t>(s)));
+        put_value(diff, s);
+
+        int run = 0;
+        for (int k = 1; k < 64; k++) {
+            int v = blk[k];
+            if (v == 0) {
+                run++;
+                continue;
+            }
+            while (run > 15) {
+                put_bits(ac.code(0xF0), ac.size(0xF0));
+                run -= 16;
+            }
+            s = bit_length(v);
+            if (s > 10) {
+                s = 10;
+                v = v < 0 ? -1023 : 1023;
+            }
+            uint8_t sym = static_cast<uint8_t>((run << 4) | s);
+            put_bits(ac.code(sym), ac.size(sym));
+            put_value(v, s);
+            run = 0;
+        }
+        if (run > 0) put_bits(ac.code(0x00), ac.size(0x00));
+    }
+
+    JpegByteWriter* out_ = nullptr;
+    const JpegInfo* info_ = nullptr;
+    JpegHuffmanEncoder dc_[2];
+    JpegHuffmanEncoder ac_[2];
+    int16_t pred_[JPEG_MAX_COMPONENTS] = {};
+    uint32_t acc_ = 0;
+    int nbits_ = 0;
+    uint32_t mcu_count_ = 0;
+    uint32_t restart_index_ = 0;
+};
+
+/**
+ * @brief Write SOI, DQT, SOF0, standard DHT, optional DRI and SOS
+ *
+ * The entropy-coded data must then be produced by JpegScanEncoder,
+ * followed by an EOI marker.
+ */
+inline bool jpeg_write_headers(JpegByteWriter& w, const JpegInfo& info) {
+    w.marker(jpeg_marker::SOI);
+
+    for (uint8_t t = 0; t < 4; t++) {
+        if (!info.quant_present[t]) continue;
+        bool wide = false;
+        for (int k = 0; k < 64; k++) {
+            if (info.quant[t][k] > 255) wide = true;
+        }
+        w.marker(jpeg_marker::DQT);
+        w.put16(static_cast<uint16_t>(2 + 1 + (wide ? 128 : 64)));
+        w.put(static_cast<uint8_t>((wide ? 0x10 : 0x00) | t));
+        for (int k = 0; k < 64; k++) {
+            if (wide) w.put16(info.quant[t][k]);
+            else w.put(static_cast<uint8_t>(info.quant[t][k]));
+        }
+    }
+
+    w.marker(jpeg_marker::SOF0);
+    w.put16(static_cast<uint16_t>(8 + 3 * info.num_components));
+    w.put(8);
+    w.put16(info.height);
+    w.put16(info.width);
+    w.put(info.num_components);
+    for (uint8_t c = 0; c < info.num_components; c++) {
+        const auto& comp = info.components[c];
+        w.put(comp.id);
+        w.put(static_cast<uint8_t>((comp.h << 4) | comp.v));
+        w.put(comp.tq);
+    }
+
+    auto put_table = [&w](uint8_t tc_th, const uint8_t* counts, const uint8_t* symbols) {
+        size_t total = 0;
+        for (int k = 0; k < 16; k++) total += counts[k];
+        w.marker(jpeg_marker::DHT);
+        w.put16(static_cast<uint16_t>(2 + 1 + 16 + total));
+        w.put(tc_th);
+        w.write(counts, 16);
+        w.write(symbols, total);
+    };
+    put_table(0x00, JPEG_STD_DC_LUMA_COUNTS, JPEG_STD_DC_SYMBOLS);
+    put_table(0x10, JPEG_STD_AC_LUMA_COUNTS, JPEG_STD_AC_LUMA_SYMBOLS);
+    if (info.num_components > 1) {
+        put_table(0x01, JPEG_STD_DC_CHROMA_COUNTS, JPEG_STD_DC_SYMBOLS);
+        put_table(0x11, JPEG_STD_AC_CHROMA_COUNTS, JPEG_STD_AC_CHROMA_SYMBOLS);
+    }
+
+    if (info.restart_interval) {
+        w.marker(jpeg_marker::DRI);
+        w.put16(4);
+        w.put16(info.restart_interval);
+    }
+
+    w.marker(jpeg_marker::SOS);
+    w.put16(static_cast<uint16_t>(6 + 2 * info.num_components));
+    w.put(info.num_components);
+    for (uint8_t c = 0; c < info.num_components; c++) {
+        w.put(info.components[c].id);
+        w.put(c == 0 ? 0x00 : 0x11);
+    }
+    w.put(0);    // Ss
+    w.put(63);   // Se
+    w.put(0);    // Ah/Al
+
+    return !w.overflow();
+}
+
+} // namespace core
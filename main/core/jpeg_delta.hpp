@@ -0,0 +1,431 @@
+/**
+ * @file jpeg_delta.hpp
+ * @brief Tile-level delta updates for mostly static scenes
+ *
+ * Design: Frames are cut into tiles at restart-interval boundaries. A restart
+ * interval resets the DC predictors, so each tile's entropy-coded bytes
+ * depend only on its own coefficients: an unchanged tile yields identical
+ * bytes, and a hash of those bytes tells whether it changed. Tiles are one
+ * MCU row by default, or a fixed number of MCUs that divides the row.
+ *
+ * If the sensor already emits restart markers at the tile size the scan is
+ * split in place; otherwise it is re-entropy-coded with that interval (no
+ * IDCT, coefficients are unchanged).
+ *
+ * Each client gets a stream of records:
+ *   - Key: the original JPEG, drawn whole
+ *   - Patch: a small JPEG whose MCU rows are the changed tiles, stacked,
+ *     plus the destination index of each; the client draws row i of the
+ *     patch at tile index[i]
+ * A key frame is sent first, every key_interval frames, when the layout or
+ * quantization changes, and when a patch would not be much smaller.
+ * Frames with no changed tile produce no record at all.
+ *
+ * Record layout (big-endian, DELTA_RECORD_HEADER_SIZE bytes, then
+ * `tiles` x u16 tile indices, then `jpeg_size` bytes of JPEG):
+ *   0  'D'          1  type (0 key, 1 patch)
+ *   2  frame width  4  frame height
+ *   6  tile width   8  tile height      (pixels; tiles per row = ceil(width / tile width))
+ *   10 tiles        12 sequence (u32)   16 jpeg_size (u32)
+ *
+ * Not thread-safe: one encoder per client (holds what that client shows).
+ * Cross-platform: Pure C++, no platform dependencies (PSRAM on ESP32).
+ */
+#pragma once
+#include "jpeg_codec.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+namespace core {
+
+static constexpr size_t DELTA_RECORD_HEADER_SIZE = 20;
+static constexpr uint8_t DELTA_RECORD_MAGIC = 'D';
+
+enum class DeltaRecordType : uint8_t {
+    Key = 0,
+    Patch = 1
+};
+
+struct JpegSegment {
+    uint32_t offset = 0;   // Relative to the start of the scan
+    uint32_t size = 0;     // Entropy-coded bytes, excluding the RSTn marker
+};
+
+/**
+ * @brief Split entropy-coded data at RSTn markers
+ *
+ * 0xFF bytes inside entropy-coded data are stuffed (FF 00), so FF D0..D7 can
+ * only be a restart marker.
+ * @return Number of segments, or 0 if there are more than max_segments
+ */
+inline size_t jpeg_split_restart_segments(const uint8_t* scan, size_t size,
+                                          JpegSegment* out, size_t max_segments) {
+    if (!scan || !out || max_segments == 0) return 0;
+    size_t count = 0;
+    size_t start = 0;
+    for (size_t i = 0; i + 1 < size; i++) {
+        if (scan[i] != 0xFF) continue;
+        uint8_t m = scan[i + 1];
+        if (m < jpeg_marker::RST0 || m > jpeg_marker::RST0 + 7) continue;
+        if (count == max_segments) return 0;
+        out[count].offset = static_cast<uint32_t>(start);
+        out[count].size = static_cast<uint32_t>(i - start);
+        count++;
+        start = i + 2;
+        i++;
+    }
+    if (count == max_segments) return 0;
+    out[count].offset = static_cast<uint32_t>(start);
+    out[count].size = static_cast<uint32_t>(size - start);
+    return count + 1;
+}
+
+// FNV-1a, seeded with the length so empty and short tiles differ too
+inline uint32_t delta_hash(const uint8_t* data, size_t size) {
+    uint32_t h = 2166136261u ^ static_cast<uint32_t>(size);
+    for (size_t i = 0; i < size; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+struct JpegDeltaConfig {
+    uint16_t tile_mcus = 0;          // MCUs per tile (0 = one MCU row); rounded to a divisor of the row
+    uint16_t key_interval = 100;     // Frames between key frames (0 = only when required)
+    uint8_t max_patch_percent = 60;  // Send a key frame instead if more tiles than this changed
+};
+
+struct JpegDeltaStats {
+    uint32_t frames = 0;
+    uint32_t keys = 0;
+    uint32_t patches = 0;
+    uint32_t unchanged = 0;       // Frames with nothing to send
+    uint32_t transcoded = 0;      // Frames re-entropy-coded to the tile interval
+    uint32_t tiles_sent = 0;
+    uint64_t source_bytes = 0;    // What plain MJPEG would have sent
+    uint64_t sent_bytes = 0;      // Record headers + JPEG bytes
+};
+
+/**
+ * @brief Output of JpegDeltaEncoder::encode(); empty when nothing changed
+ */
+struct DeltaRecord {
+    const uint8_t* header = nullptr;  // Record header + tile indices
+    size_t header_size = 0;
+    const uint8_t* jpeg = nullptr;    // Key: the source frame, Patch: encoder buffer
+    size_t jpeg_size = 0;
+
+    bool empty() const { return header_size == 0; }
+    size_t total() const { return header_size + jpeg_size; }
+};
+
+/**
+ * @brief Per-client delta encoder
+ *
+ * Usage (stream handler):
+ *   encoder.init(max_frame_size, max_tiles, config);
+ *   while (streaming) {
+ *       DeltaRecord rec;
+ *       if (encoder.encode(frame, size, sequence, &rec) && !rec.empty()) {
+ *           send(rec.header, rec.header_size);
+ *           send(rec.jpeg, rec.jpeg_size);
+ *       }
+ *   }
+ */
+class JpegDeltaEncoder {
+public:
+    JpegDeltaEncoder() = default;
+    ~JpegDeltaEncoder() { deinit(); }
+
+    // Non-copyable
+    JpegDeltaEncoder(const JpegDeltaEncoder&) = delete;
+    JpegDeltaEncoder& operator=(const JpegDeltaEncoder&) = delete;
+
+    /**
+     * @brief Pre-allocate scratch and output buffers
+     * @param max_frame_size Largest source JPEG
+     * @param max_tiles Largest tile count per frame (frames with more are sent as keys)
+     * @param use_psram Use PSRAM for the buffers (ESP32 only)
+     */
+    bool init(size_t max_frame_size, size_t max_tiles, const JpegDeltaConfig& config,
+              bool use_psram = true) {
+        if (initialized_) return true;
+        if (max_frame_size == 0 || max_tiles == 0) return false;
+
+        // Re-coding adds restart markers and may use larger standard tables
+        buffer_size_ = max_frame_size + max_frame_size / 4 + 1024;
+        max_tiles_ = max_tiles;
+        config_ = config;
+
+        scratch_ = static_cast<uint8_t*>(alloc(buffer_size_, use_psram));
+        patch_ = static_cast<uint8_t*>(alloc(buffer_size_, use_psram));
+        header_ = static_cast<uint8_t*>(alloc(DELTA_RECORD_HEADER_SIZE + 2 * max_tiles, use_psram));
+        segments_ = static_cast<JpegSegment*>(alloc(max_tiles * sizeof(JpegSegment), use_psram));
+        hashes_ = static_cast<uint32_t*>(alloc(max_tiles * sizeof(uint32_t), use_psram));
+        shown_ = static_cast<uint32_t*>(alloc(max_tiles * sizeof(uint32_t), use_psram));
+        if (!scratch_ || !patch_ || !header_ || !segments_ || !hashes_ || !shown_) {
+            deinit();
+            return false;
+        }
+
+        initialized_ = true;
+        reset();
+        return true;
+    }
+
+    void deinit() {
+        release(scratch_);
+        release(patch_);
+        release(header_);
+        release(segments_);
+        release(hashes_);
+        release(shown_);
+        scratch_ = nullptr;
+        patch_ = nullptr;
+        header_ = nullptr;
+        segments_ = nullptr;
+        hashes_ = nullptr;
+        shown_ = nullptr;
+        initialized_ = false;
+    }
+
+    // Forget what the client shows; the next frame is a key frame
+    void reset() {
+        have_key_ = false;
+        frames_since_key_ = 0;
+    }
+
+    /**
+     * @brief Produce the record that brings the client up to this frame
+     * @param record Output (empty if the client already shows this frame);
+     *        valid until the next call. Key records point into `jpeg`.
+     * @return false if the frame could not be parsed
+     */
+    bool encode(const uint8_t* jpeg, size_t size, uint32_t sequence, DeltaRecord* record) {
+        if (!initialized_ || !record) return false;
+        *record = DeltaRecord{};
+        JpegInfo info;
+        if (!jpeg_parse(jpeg, size, &info)) return false;
+        stats_.frames++;
+        stats_.source_bytes += size;
+
+        uint32_t layout = layout_hash(info);
+        uint16_t tile_mcus = tile_size(info);
+        size_t tiles = split(jpeg, size, info, tile_mcus);
+
+        bool key = !have_key_ || layout != layout_ || tiles == 0 ||
+                   (config_.key_interval && frames_since_key_ + 1 >= config_.key_interval);
+
+        size_t changed = 0;
+        if (!key) {
+            for (size_t t = 0; t < tiles; t++) {
+                if (hashes_[t] != shown_[t]) changed++;
+            }
+            if (changed * 100 > static_cast<size_t>(config_.max_patch_percent) * tiles) key = true;
+        }
+
+        if (key) {
+            write_header(DeltaRecordType::Key, info, 0, 0, 0, sequence, size);
+            record->header = header_;
+            record->header_size = DELTA_RECORD_HEADER_SIZE;
+            record->jpeg = jpeg;
+            record->jpeg_size = size;
+            // Tiles are only comparable if the split worked
+            have_key_ = tiles > 0;
+            layout_ = layout;
+            frames_since_key_ = 0;
+            if (tiles) memcpy(shown_, hashes_, tiles * sizeof(uint32_t));
+            stats_.keys++;
+        } else if (changed == 0) {
+            frames_since_key_++;
+            stats_.unchanged++;
+            return true;
+        } else {
+            size_t patch_size = build_patch(info, tile_mcus, tiles, changed, sequence);
+            if (patch_size == 0) {
+                // Should not happen (buffer sized for a full frame); resync with a key
+                reset();
+                return encode(jpeg, size, sequence, record);
+            }
+            record->header = header_;
+            record->header_size = DELTA_RECORD_HEADER_SIZE + 2 * changed;
+            record->jpeg = patch_;
+            record->jpeg_size = patch_size;
+            frames_since_key_++;
+            stats_.patches++;
+            stats_.tiles_sent += static_cast<uint32_t>(changed);
+        }
+        stats_.sent_bytes += record->total();
+        return true;
+    }
+
+    const JpegDeltaStats& stats() const { return stats_; }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    static void* alloc(size_t size, bool use_psram) {
+#ifdef ESP_PLATFORM
+        return use_psram ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM) : malloc(size);
+#else
+        (void)use_psram;
+        return malloc(size);
+#endif
+    }
+
+    static void release(void* p) {
+#ifdef ESP_PLATFORM
+        heap_caps_free(p);
+#else
+        free(p);
+#endif
+    }
+
+    // Largest divisor of the MCU row not above the configured tile size
+    uint16_t tile_size(const JpegInfo& info) const {
+        uint16_t row = info.mcus_x;
+        if (config_.tile_mcus == 0 || config_.tile_mcus >= row) return row;
+        uint16_t t = config_.tile_mcus;
+        while (row % t) t--;
+        return t;
+    }
+
+    // Dimensions, sampling, quantization and restart interval: tiles only compare within one layout
+    static uint32_t layout_hash(const JpegInfo& info) {
+        uint32_t h = delta_hash(reinterpret_cast<const uint8_t*>(&info.width), sizeof(info.width));
+        h ^= delta_hash(reinterpret_cast<const uint8_t*>(&info.height), sizeof(info.height)) * 3;
+        h ^= delta_hash(reinterpret_cast<const uint8_t*>(&info.restart_interval),
+                        sizeof(info.restart_interval)) * 5;
+        for (uint8_t c = 0; c < info.num_components; c++) {
+            const auto& comp = info.components[c];
+            uint8_t desc[3] = {comp.h, comp.v, comp.tq};
+            h = h * 31 + delta_hash(desc, sizeof(desc));
+            h = h * 31 + delta_hash(reinterpret_cast<const uint8_t*>(info.quant[comp.tq]),
+                                    sizeof(info.quant[comp.tq]));
+        }
+        return h;
+    }
+
+    /**
+     * @brief Cut the scan into tiles and hash them (re-coding if needed)
+     * @return Tile count, or 0 if the frame cannot be split
+     */
+    size_t split(const uint8_t* jpeg, size_t size, const JpegInfo& info, uint16_t tile_mcus) {
+        size_t expected = (info.total_mcus() + tile_mcus - 1) / tile_mcus;
+        if (expected > max_tiles_) return 0;
+
+        tile_base_ = jpeg + info.scan_offset;
+        size_t scan_size = info.scan_size;
+        if (info.restart_interval != tile_mcus || !jpeg_uses_standard_huffman(info)) {
+            scan_size = recode(jpeg, size, info, tile_mcus);
+            if (scan_size == 0) return 0;
+            tile_base_ = scratch_;
+            stats_.transcoded++;
+        }
+
+        size_t tiles = jpeg_split_restart_segments(tile_base_, scan_size, segments_, max_tiles_);
+        if (tiles != expected) return 0;
+        for (size_t t = 0; t < tiles; t++) {
+            hashes_[t] = delta_hash(tile_base_ + segments_[t].offset, segments_[t].size);
+        }
+        return tiles;
+    }
+
+    // Re-entropy-code the scan with one restart interval per tile
+    size_t recode(const uint8_t* jpeg, size_t size, const JpegInfo& info, uint16_t tile_mcus) {
+        JpegScanDecoder dec;
+        if (!dec.begin(jpeg, size, info)) return 0;
+        JpegInfo out_info = info;
+        out_info.restart_interval = tile_mcus;
+
+        JpegByteWriter w(scratch_, buffer_size_);
+        JpegScanEncoder enc;
+        enc.begin(w, out_info);
+        int16_t blocks[JPEG_MAX_BLOCKS_PER_MCU][64];
+        for (uint32_t m = 0; m < info.total_mcus(); m++) {
+            if (!dec.decode_mcu(blocks)) return 0;
+            enc.encode_mcu(blocks);
+        }
+        enc.finish();
+        return w.overflow() ? 0 : w.size();
+    }
+
+    // Stack the changed tiles as MCU rows of a narrow JPEG
+    size_t build_patch(const JpegInfo& info, uint16_t tile_mcus, size_t tiles,
+                       size_t changed, uint32_t sequence) {
+        JpegInfo patch = info;
+        patch.width = static_cast<uint16_t>(tile_mcus * info.mcu_width);
+        patch.height = static_cast<uint16_t>(changed * info.mcu_height);
+        patch.restart_interval = tile_mcus;
+        if (!jpeg_compute_layout(patch)) return 0;
+
+        JpegByteWriter w(patch_, buffer_size_);
+        if (!jpeg_write_headers(w, patch)) return 0;
+
+        uint8_t* index = header_ + DELTA_RECORD_HEADER_SIZE;
+        size_t n = 0;
+        for (size_t t = 0; t < tiles; t++) {
+            if (hashes_[t] == shown_[t]) continue;
+            if (n > 0) w.marker(static_cast<uint8_t>(jpeg_marker::RST0 + ((n - 1) & 7)));
+            w.write(tile_base_ + segments_[t].offset, segments_[t].size);
+            index[2 * n] = static_cast<uint8_t>(t >> 8);
+            index[2 * n + 1] = static_cast<uint8_t>(t);
+            shown_[t] = hashes_[t];
+            n++;
+        }
+        w.marker(jpeg_marker::EOI);
+        if (w.overflow()) return 0;
+
+        write_header(DeltaRecordType::Patch, info, patch.width, info.mcu_height,
+                     static_cast<uint16_t>(changed), sequence, w.size());
+        return w.size();
+    }
+
+    void write_header(DeltaRecordType type, const JpegInfo& info, uint16_t tile_w,
+                      uint16_t tile_h, uint16_t tiles, uint32_t sequence, size_t jpeg_size) {
+        uint8_t* p = header_;
+        auto put16 = [&p](uint16_t v) {
+            *p++ = static_cast<uint8_t>(v >> 8);
+            *p++ = static_cast<uint8_t>(v);
+        };
+        auto put32 = [&put16](uint32_t v) {
+            put16(static_cast<uint16_t>(v >> 16));
+            put16(static_cast<uint16_t>(v));
+        };
+        *p++ = DELTA_RECORD_MAGIC;
+        *p++ = static_cast<uint8_t>(type);
+        put16(info.width);
+        put16(info.height);
+        put16(tile_w);
+        put16(tile_h);
+        put16(tiles);
+        put32(sequence);
+        put32(static_cast<uint32_t>(jpeg_size));
+    }
+
+    JpegDeltaConfig config_;
+    JpegDeltaStats stats_;
+    bool initialized_ = false;
+
+    size_t buffer_size_ = 0;
+    size_t max_tiles_ = 0;
+    uint8_t* scratch_ = nullptr;        // Re-coded scan
+    uint8_t* patch_ = nullptr;          // Patch JPEG
+    uint8_t* header_ = nullptr;         // Record header + tile indices
+    JpegSegment* segments_ = nullptr;   // Tiles of the current frame
+    uint32_t* hashes_ = nullptr;        // ...and their hashes
+    uint32_t* shown_ = nullptr;         // Tile hashes the client currently shows
+    const uint8_t* tile_base_ = nullptr;
+
+    bool have_key_ = false;
+    uint32_t layout_ = 0;
+    uint32_t frames_since_key_ = 0;
+};
+
+} // namespace core
@@ -0,0 +1,375 @@
+/**
+ * @file jpeg_encoder.hpp
+ * @brief Baseline JPEG encoder for raw YUV422 / grayscale / RGB565 frames
+ *
+ * Design: The transforms work on eight lanes at a time using GCC/Clang
+ * vector extensions, so they compile to SSE/AVX/NEON on the host and to
+ * plain loops on targets without a vector unit. ESP32-S3 PIE has no compiler
+ * intrinsics, so the device build uses the scalar lowering.
+ *   - Color conversion: RGB565 pixels eight at a time (even/odd pixels in
+ *     separate vectors, so 2:1 chroma averaging stays lane-parallel)
+ *   - DCT: libjpeg's integer LL&M DCT (jfdctint.c), each pass running on
+ *     all eight rows/columns of a block at once
+ *   - Quantization: multiply-shift by per-coefficient reciprocals that give
+ *     exactly floor((|x| + q/2) / q), i.e. libjpeg's rounding
+ * Same arithmetic as libjpeg's ISLOW path, so output is comparable with it
+ * coefficient for coefficient. Entropy coding reuses JpegScanEncoder with the
+ * standard Huffman tables; output is 4:2:2 (color) or single-component.
+ *
+ * Edge MCUs replicate the last column/row, as libjpeg does.
+ * Cross-platform: Pure C++ (GCC/Clang vector extensions), no platform dependencies.
+ */
+#pragma once
+#include "jpeg_codec.hpp"
+#include "../interfaces/i_camera.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if !defined(__GNUC__)
+#error "jpeg_encoder.hpp requires GCC/Clang vector extensions"
+#endif
+
+namespace core {
+
+using interfaces::PixelFormat;
+
+// Eight 32-bit lanes
+typedef int32_t JpegLanes __attribute__((vector_size(8 * sizeof(int32_t))));
+typedef uint32_t JpegULanes __attribute__((vector_size(8 * sizeof(uint32_t))));
+
+// Annex K example tables, natural order (libjpeg's defaults)
+inline constexpr uint8_t JPEG_STD_LUMA_QUANT[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,  24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99
+};
+inline constexpr uint8_t JPEG_STD_CHROMA_QUANT[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99
+};
+
+/**
+ * @brief Scale a standard table to a quality (1-100, libjpeg's scale)
+ */
+inline void jpeg_scale_quant_table(const uint8_t* base, int quality, uint16_t* out_natural) {
+    if (quality < 1) quality = 1;
+    if (quality > 100) quality = 100;
+    int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    for (int i = 0; i < 64; i++) {
+        int v = (base[i] * scale + 50) / 100;
+        out_natural[i] = static_cast<uint16_t>(v < 1 ? 1 : v > 255 ? 255 : v);
+    }
+}
+
+// =============================================================================
+// Color conversion
+// =============================================================================
+
+/**
+ * @brief RGB (0-255 per lane) to YCbCr, libjpeg's fixed-point coefficients
+ */
+inline void jpeg_rgb_to_ycc(const JpegLanes& r, const JpegLanes& g, const JpegLanes& b,
+                            JpegLanes* y, JpegLanes* cb, JpegLanes* cr) {
+    constexpr int32_t ONE_HALF = 1 << 15;
+    constexpr int32_t CBCR_OFFSET = 128 << 16;
+    *y = (r * 19595 + g * 38470 + b * 7471 + ONE_HALF) >> 16;
+    *cb = (r * -11059 + g * -21709 + b * 32768 + (CBCR_OFFSET + ONE_HALF - 1)) >> 16;
+    *cr = (r * 32768 + g * -27439 + b * -5329 + (CBCR_OFFSET + ONE_HALF - 1)) >> 16;
+}
+
+// =============================================================================
+// Forward DCT (libjpeg jfdctint.c, eight lanes per pass)
+// =============================================================================
+
+template <bool FirstPass>
+inline void jpeg_fdct_pass(JpegLanes* d) {
+    constexpr int CONST_BITS = 13;
+    constexpr int PASS1_BITS = 2;
+    constexpr int OUT_BITS = FirstPass ? CONST_BITS - PASS1_BITS : CONST_BITS + PASS1_BITS;
+    constexpr int32_t OUT_ROUND = 1 << (OUT_BITS - 1);
+    constexpr int32_t PASS1_ROUND = 1 << (PASS1_BITS - 1);
+
+    JpegLanes tmp0 = d[0] + d[7];
+    JpegLanes tmp7 = d[0] - d[7];
+    JpegLanes tmp1 = d[1] + d[6];
+    JpegLanes tmp6 = d[1] - d[6];
+    JpegLanes tmp2 = d[2] + d[5];
+    JpegLanes tmp5 = d[2] - d[5];
+    JpegLanes tmp3 = d[3] + d[4];
+    JpegLanes tmp4 = d[3] - d[4];
+
+    // Even part
+    JpegLanes tmp10 = tmp0 + tmp3;
+    JpegLanes tmp13 = tmp0 - tmp3;
+    JpegLanes tmp11 = tmp1 + tmp2;
+    JpegLanes tmp12 = tmp1 - tmp2;
+
+    if (FirstPass) {
+        d[0] = (tmp10 + tmp11) << PASS1_BITS;
+        d[4] = (tmp10 - tmp11) << PASS1_BITS;
+    } else {
+        d[0] = (tmp10 + tmp11 + PASS1_ROUND) >> PASS1_BITS;
+        d[4] = (tmp10 - tmp11 + PASS1_ROUND) >> PASS1_BITS;
+    }
+    JpegLanes z1 = (tmp12 + tmp13) * 4433;                // FIX(0.541196100)
+    d[2] = (z1 + tmp13 * 6270 + OUT_ROUND) >> OUT_BITS;   // FIX(0.765366865)
+    d[6] = (z1 - tmp12 * 15137 + OUT_ROUND) >> OUT_BITS;  // FIX(1.847759065)
+
+    // Odd part
+    z1 = tmp4 + tmp7;
+    JpegLanes z2 = tmp5 + tmp6;
+    JpegLanes z3 = tmp4 + tmp6;
+    JpegLanes z4 = tmp5 + tmp7;
+    JpegLanes z5 = (z3 + z4) * 9633;                       // FIX(1.175875602)
+
+    tmp4 = tmp4 * 2446;                                    // FIX(0.298631336)
+    tmp5 = tmp5 * 16819;                                   // FIX(2.053119869)
+    tmp6 = tmp6 * 25172;                                   // FIX(3.072711026)
+    tmp7 = tmp7 * 12299;                                   // FIX(1.501321110)
+    z1 = z1 * -7373;                                       // FIX(0.899976223)
+    z2 = z2 * -20995;                                      // FIX(2.562915447)
+    z3 = z3 * -16069 + z5;                                 // FIX(1.961570560)
+    z4 = z4 * -3196 + z5;                                  // FIX(0.390180644)
+
+    d[7] = (tmp4 + z1 + z3 + OUT_ROUND) >> OUT_BITS;
+    d[5] = (tmp5 + z2 + z4 + OUT_ROUND) >> OUT_BITS;
+    d[3] = (tmp6 + z2 + z3 + OUT_ROUND) >> OUT_BITS;
+    d[1] = (tmp7 + z1 + z4 + OUT_ROUND) >> OUT_BITS;
+}
+
+/**
+ * @brief 2-D DCT of a level-shifted block
+ * @param samples Natural order
+ * @param rows Output: row u of coefficients per vector (natural order), scaled by 8
+ */
+inline void jpeg_fdct_islow(const int32_t* samples, JpegLanes* rows) {
+    JpegLanes cols[8];
+    for (int c = 0; c < 8; c++) {
+        for (int r = 0; r < 8; r++) cols[c][r] = samples[r * 8 + c];
+    }
+    jpeg_fdct_pass<true>(cols);     // Lane r: 1-D DCT of row r
+    for (int r = 0; r < 8; r++) {
+        for (int k = 0; k < 8; k++) rows[r][k] = cols[k][r];
+    }
+    jpeg_fdct_pass<false>(rows);    // Lane k: 1-D DCT of column k
+}
+
+// =============================================================================
+// Quantization
+// =============================================================================
+
+/**
+ * @brief Per-coefficient reciprocals for one quantization table
+ *
+ * floor(n / d) == (n * m) >> s for all 0 <= n < 2^15 when
+ * s = 15 + ceil(log2 d) and m = ceil(2^s / d) (Granlund-Montgomery); the
+ * product stays below 2^32.
+ */
+struct JpegDivisors {
+    JpegLanes half[8];
+    JpegULanes mul[8];
+    JpegULanes shift[8];
+
+    // quant: natural order; divisors are 8q to undo the DCT's scaling
+    void build(const uint16_t* quant) {
+        for (int i = 0; i < 64; i++) {
+            uint32_t d = static_cast<uint32_t>(quant[i]) * 8;
+            uint32_t log2 = 0;
+            while ((1u << log2) < d) log2++;
+            uint32_t s = 15 + log2;
+            half[i / 8][i % 8] = static_cast<int32_t>(d / 2);
+            mul[i / 8][i % 8] = static_cast<uint32_t>(((1ull << s) + d - 1) / d);
+            shift[i / 8][i % 8] = s;
+        }
+    }
+};
+
+/**
+ * @brief Quantize DCT output into a zigzag-ordered block
+ */
+inline void jpeg_quantize(const JpegLanes* rows, const JpegDivisors& div, int16_t* zigzag) {
+    int32_t natural[64];
+    for (int u = 0; u < 8; u++) {
+        JpegLanes x = rows[u];
+        JpegLanes sign = x >> 31;
+        JpegULanes n = (JpegULanes)(((x ^ sign) - sign) + div.half[u]);
+        JpegLanes q = (JpegLanes)((n * div.mul[u]) >> div.shift[u]);
+        JpegLanes out = (q ^ sign) - sign;
+        memcpy(&natural[u * 8], &out, sizeof(out));
+    }
+    for (int k = 0; k < 64; k++) {
+        zigzag[k] = static_cast<int16_t>(natural[JPEG_NATURAL_ORDER[k]]);
+    }
+}
+
+// =============================================================================
+// Encoder
+// =============================================================================
+
+/**
+ * @brief Encodes raw frames into a caller-provided buffer
+ *
+ * Usage:
+ *   JpegEncoder enc;
+ *   enc.set_quality(80);
+ *   size_t n = enc.encode(pixels, size, 640, 480, PixelFormat::Yuv422, out, cap);
+ *
+ * Not thread-safe (holds the scan encoder); holds no frame-sized buffers.
+ */
+class JpegEncoder {
+public:
+    JpegEncoder() { set_quality(80); }
+
+    // Non-copyable
+    JpegEncoder(const JpegEncoder&) = delete;
+    JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+    /**
+     * @brief Quality on libjpeg's 1-100 scale (higher = better, larger)
+     */
+    void set_quality(int quality) {
+        quality_ = quality < 1 ? 1 : quality > 100 ? 100 : quality;
+        uint16_t natural[64];
+        jpeg_scale_quant_table(JPEG_STD_LUMA_QUANT, quality_, natural);
+        divisors_[0].build(natural);
+        for (int k = 0; k < 64; k++) quant_[0][k] = natural[JPEG_NATURAL_ORDER[k]];
+        jpeg_scale_quant_table(JPEG_STD_CHROMA_QUANT, quality_, natural);
+        divisors_[1].build(natural);
+        for (int k = 0; k < 64; k++) quant_[1][k] = natural[JPEG_NATURAL_ORDER[k]];
+    }
+
+    int quality() const { return quality_; }
+
+    /**
+     * @brief Encode one frame
+     * @param size Bytes available at pixels (at least width x height x bytes per pixel)
+     * @return JPEG size, or 0 on invalid input or if the output does not fit
+     */
+    size_t encode(const uint8_t* pixels, size_t size, uint16_t width, uint16_t height,
+                  PixelFormat format, uint8_t* out, size_t capacity) {
+        size_t bpp = interfaces::pixel_format_bytes(format);
+        if (!pixels || !out || bpp == 0 || width == 0 || height == 0) return 0;
+        if (size < static_cast<size_t>(width) * height * bpp) return 0;
+        if (format == PixelFormat::Yuv422 && (width & 1)) return 0;
+
+        JpegInfo info;
+        info.width = width;
+        info.height = height;
+        bool color = format != PixelFormat::Grayscale;
+        info.num_components = color ? 3 : 1;
+        for (uint8_t c = 0; c < info.num_components; c++) {
+            info.components[c].id = static_cast<uint8_t>(c + 1);
+            info.components[c].h = c == 0 && color ? 2 : 1;
+            info.components[c].v = 1;
+            info.components[c].tq = c == 0 ? 0 : 1;
+        }
+        memcpy(info.quant[0], quant_[0], sizeof(quant_[0]));
+        memcpy(info.quant[1], quant_[1], sizeof(quant_[1]));
+        info.quant_present[0] = true;
+        info.quant_present[1] = color;
+        if (!jpeg_compute_layout(info)) return 0;
+
+        JpegByteWriter w(out, capacity);
+        if (!jpeg_write_headers(w, info)) return 0;
+        scan_.begin(w, info);
+
+        int32_t samples[JPEG_MAX_BLOCKS_PER_MCU][64];
+        int16_t blocks[JPEG_MAX_BLOCKS_PER_MCU][64];
+        JpegLanes rows[8];
+        for (uint16_t my = 0; my < info.mcus_y; my++) {
+            for (uint16_t mx = 0; mx < info.mcus_x; mx++) {
+                uint32_t x0 = static_cast<uint32_t>(mx) * info.mcu_width;
+                uint32_t y0 = static_cast<uint32_t>(my) * info.mcu_height;
+                switch (format) {
+                    case PixelFormat::Grayscale: load_gray(pixels, width, height, x0, y0, samples); break;
+                    case PixelFormat::Yuv422:    load_yuyv(pixels, width, height, x0, y0, samples); break;
+                    default:                     load_rgb565(pixels, width, height, x0, y0, samples); break;
+                }
+                for (uint8_t b = 0; b < info.blocks_per_mcu; b++) {
+                    jpeg_fdct_islow(samples[b], rows);
+                    jpeg_quantize(rows, divisors_[info.block_component[b] == 0 ? 0 : 1], blocks[b]);
+                }
+                scan_.encode_mcu(blocks);
+            }
+            if (w.overflow()) return 0;
+        }
+        scan_.finish();
+        w.marker(jpeg_marker::EOI);
+        return w.overflow() ? 0 : w.size();
+    }
+
+private:
+    static uint32_t clamp_x(uint32_t x, uint16_t width) { return x < width ? x : width - 1u; }
+
+    // 8x8 block, one byte per pixel
+    static void load_gray(const uint8_t* px, uint16_t width, uint16_t height,
+                          uint32_t x0, uint32_t y0, int32_t (*samples)[64]) {
+        for (int r = 0; r < 8; r++) {
+            const uint8_t* row = px + static_cast<size_t>(clamp_x(y0 + r, height)) * width;
+            int32_t* s = &samples[0][r * 8];
+            if (x0 + 8 <= width) {
+                for (int c = 0; c < 8; c++) s[c] = row[x0 + c] - 128;
+            } else {
+                for (int c = 0; c < 8; c++) s[c] = row[clamp_x(x0 + c, width)] - 128;
+            }
+        }
+    }
+
+    // 16x8 MCU from YUYV: already 4:2:2, only de-interleaved
+    static void load_yuyv(const uint8_t* px, uint16_t width, uint16_t height,
+                          uint32_t x0, uint32_t y0, int32_t (*samples)[64]) {
+        uint32_t pairs = width / 2u;
+        for (int r = 0; r < 8; r++) {
+            const uint8_t* row = px + static_cast<size_t>(clamp_x(y0 + r, height)) * width * 2;
+            for (int c = 0; c < 16; c++) {
+                samples[c >> 3][r * 8 + (c & 7)] = row[2 * clamp_x(x0 + c, width)] - 128;
+            }
+            for (int c = 0; c < 8; c++) {
+                uint32_t p = x0 / 2 + c;
+                if (p >= pairs) p = pairs - 1;
+                samples[2][r * 8 + c] = row[4 * p + 1] - 128;
+                samples[3][r * 8 + c] = row[4 * p + 3] - 128;
+            }
+        }
+    }
+
+    // 16x8 MCU from big-endian RGB565: convert, then average pixel pairs
+    // for chroma with libjpeg's alternating 0/1 rounding bias
+    static void load_rgb565(const uint8_t* px, uint16_t width, uint16_t height,
+                            uint32_t x0, uint32_t y0, int32_t (*samples)[64]) {
+        const JpegLanes bias = {0, 1, 0, 1, 0, 1, 0, 1};
+        for (int r = 0; r < 8; r++) {
+            const uint8_t* row = px + static_cast<size_t>(clamp_x(y0 + r, height)) * width * 2;
+            JpegLanes rgb[2][3];   // [even/odd pixel][channel]
+            for (int i = 0; i < 16; i++) {
+                const uint8_t* p = row + 2 * clamp_x(x0 + i, width);
+                int32_t v = (p[0] << 8) | p[1];
+                int32_t r5 = v >> 11, g6 = (v >> 5) & 0x3F, b5 = v & 0x1F;
+                rgb[i & 1][0][i >> 1] = (r5 << 3) | (r5 >> 2);
+                rgb[i & 1][1][i >> 1] = (g6 << 2) | (g6 >> 4);
+                rgb[i & 1][2][i >> 1] = (b5 << 3) | (b5 >> 2);
+            }
+            JpegLanes y[2], cb[2], cr[2];
+            jpeg_rgb_to_ycc(rgb[0][0], rgb[0][1], rgb[0][2], &y[0], &cb[0], &cr[0]);
+            jpeg_rgb_to_ycc(rgb[1][0], rgb[1][1], rgb[1][2], &y[1], &cb[1], &cr[1]);
+            JpegLanes cb_avg = ((cb[0] + cb[1] + bias) >> 1) - 128;
+            JpegLanes cr_avg = ((cr[0] + cr[1] + bias) >> 1) - 128;
+            for (int i = 0; i < 16; i++) {
+                samples[i >> 3][r * 8 + (i & 7)] = y[i & 1][i >> 1] - 128;
+            }
+            memcpy(&samples[2][r * 8], &cb_avg, sizeof(cb_avg));
+            memcpy(&samples[3][r * 8], &cr_avg, sizeof(cr_avg));
+        }
+    }
+
+    int quality_ = 80;
+    uint16_t quant_[2][64] = {};   // Zigzag order, for the DQT segments
+    JpegDivisors divisors_[2];
+    JpegScanEncoder scan_;
+};
+
+} // namespace core
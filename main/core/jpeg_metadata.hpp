@@ -0,0 +1,143 @@
+/**
+ * @file jpeg_metadata.hpp
+ * @brief Zero-copy capture metadata (sequence, timestamp) for outgoing JPEGs
+ *
+ * Design: Instead of rewriting the frame, the send path emits three pieces:
+ *   [SOI (+ JFIF/Exif APPn)] [generated APP9 segment] [rest of the slot]
+ * The stored frame is never modified; the only per-frame work is building a
+ * 24-byte segment on the stack.
+ *
+ * Segment layout (all integers big-endian):
+ *   FF E9 | len(2) | "ESPCAM\0"(7) | version(1) | source(1) | sequence(4) | timestamp_us(8)
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include "jpeg_codec.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace core {
+
+static constexpr uint8_t JPEG_METADATA_MARKER = 0xE9;  // APP9
+static constexpr uint8_t JPEG_METADATA_VERSION = 1;
+static constexpr char JPEG_METADATA_ID[7] = {'E', 'S', 'P', 'C', 'A', 'M', '\0'};
+static constexpr size_t JPEG_METADATA_SEGMENT_SIZE = 2 + 2 + 7 + 1 + 1 + 4 + 8;
+
+enum class FrameSource : uint8_t {
+    Stream = 0,     // Frame from the streaming ring (sequence = ring sequence)
+    Snapshot = 1,   // Direct sensor capture (sequence = snapshot counter)
+    Recording = 2,  // Frame read back from storage (sequence = store sequence)
+    History = 3,    // Frame replayed from the in-memory history (sequence = ring sequence)
+    Burst = 4       // Burst capture (sequence = position in the burst, from 1)
+};
+
+struct FrameMetadata {
+    uint32_t sequence = 0;
+    int64_t timestamp_us = 0;
+    FrameSource source = FrameSource::Stream;
+};
+
+/**
+ * @brief Build the APP9 metadata segment
+ * @param meta Metadata to encode
+ * @param buf Output buffer (at least JPEG_METADATA_SEGMENT_SIZE bytes)
+ * @param capacity Output buffer size
+ * @return Segment size, or 0 if the buffer is too small
+ */
+inline size_t jpeg_build_metadata_segment(const FrameMetadata& meta, uint8_t* buf, size_t capacity) {
+    if (!buf || capacity < JPEG_METADATA_SEGMENT_SIZE) return 0;
+    uint8_t* p = buf;
+    *p++ = 0xFF;
+    *p++ = JPEG_METADATA_MARKER;
+    uint16_t len = static_cast<uint16_t>(JPEG_METADATA_SEGMENT_SIZE - 2);
+    *p++ = static_cast<uint8_t>(len >> 8);
+    *p++ = static_cast<uint8_t>(len & 0xFF);
+    memcpy(p, JPEG_METADATA_ID, sizeof(JPEG_METADATA_ID));
+    p += sizeof(JPEG_METADATA_ID);
+    *p++ = JPEG_METADATA_VERSION;
+    *p++ = static_cast<uint8_t>(meta.source);
+    for (int i = 3; i >= 0; i--) *p++ = static_cast<uint8_t>(meta.sequence >> (8 * i));
+    uint64_t ts = static_cast<uint64_t>(meta.timestamp_us);
+    for (int i = 7; i >= 0; i--) *p++ = static_cast<uint8_t>(ts >> (8 * i));
+    return JPEG_METADATA_SEGMENT_SIZE;
+}
+
+/**
+ * @brief Find and decode the metadata segment in a JPEG header
+ * @return true if an ESPCAM APP9 segment precedes the scan
+ */
+inline bool jpeg_read_metadata(const uint8_t* data, size_t size, FrameMetadata* out) {
+    if (!data || !out || size < 4 || data[0] != 0xFF || data[1] != jpeg_marker::SOI) return false;
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) return false;
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) { pos++; continue; }
+        if (marker == jpeg_marker::SOS || marker == jpeg_marker::EOI) return false;
+        size_t len = static_cast<size_t>((data[pos + 2] << 8) | data[pos + 3]);
+        if (len < 2 || pos + 2 + len > size) return false;
+        const uint8_t* seg = data + pos + 4;
+        if (marker == JPEG_METADATA_MARKER && len + 2 == JPEG_METADATA_SEGMENT_SIZE &&
+            memcmp(seg, JPEG_METADATA_ID, sizeof(JPEG_METADATA_ID)) == 0) {
+            const uint8_t* p = seg + sizeof(JPEG_METADATA_ID);
+            if (*p++ != JPEG_METADATA_VERSION) return false;
+            out->source = static_cast<FrameSource>(*p++);
+            uint32_t seq = 0;
+            for (int i = 0; i < 4; i++) seq = (seq << 8) | *p++;
+            uint64_t ts = 0;
+            for (int i = 0; i < 8; i++) ts = (ts << 8) | *p++;
+            out->sequence = seq;
+            out->timestamp_us = static_cast<int64_t>(ts);
+            return true;
+        }
+        pos += 2 + len;
+    }
+    return false;
+}
+
+/**
+ * @brief Scatter-gather view of a JPEG with a spliced-in segment
+ *
+ * parts[0] = head of the original frame (SOI, plus a leading JFIF/Exif APPn)
+ * parts[1] = generated segment
+ * parts[2] = remainder of the original frame
+ */
+struct JpegSplice {
+    static constexpr size_t NUM_PARTS = 3;
+    const uint8_t* data[NUM_PARTS] = {};
+    size_t size[NUM_PARTS] = {};
+
+    size_t total() const { return size[0] + size[1] + size[2]; }
+};
+
+/**
+ * @brief Describe a frame with a segment inserted after its SOI
+ *
+ * A leading APP0 (JFIF) or APP1 (Exif) segment is kept first, since those
+ * formats require it to directly follow SOI. No bytes are copied.
+ * @return false if the frame does not start with SOI
+ */
+inline bool jpeg_splice_segment(const uint8_t* jpeg, size_t size,
+                                const uint8_t* segment, size_t segment_size,
+                                JpegSplice* out) {
+    if (!jpeg || !out || size < 4 || jpeg[0] != 0xFF || jpeg[1] != jpeg_marker::SOI) return false;
+
+    size_t head = 2;
+    if (jpeg[2] == 0xFF && (jpeg[3] == jpeg_marker::APP0 || jpeg[3] == jpeg_marker::APP0 + 1) &&
+        size >= 6) {
+        size_t len = static_cast<size_t>((jpeg[4] << 8) | jpeg[5]);
+        if (len >= 2 && 2 + 2 + len <= size) head = 2 + 2 + len;
+    }
+
+    out->data[0] = jpeg;
+    out->size[0] = head;
+    out->data[1] = segment;
+    out->size[1] = segment ? segment_size : 0;
+    out->data[2] = jpeg + head;
+    out->size[2] = size - head;
+    return true;
+}
+
+} // namespace core
@@ -0,0 +1,359 @@
+/**
+ * @file jpeg_overlay.hpp
+ * @brief Privacy masks and a burned-in timestamp, applied in the DCT domain
+ *
+ * Design: A frame processor (IFrameProcessor) that entropy-decodes the scan
+ * to quantized coefficients, rewrites the affected MCUs and re-encodes; no
+ * IDCT, color conversion or re-quantization, so untouched MCUs come out
+ * identical to the sensor's.
+ *   - Masks: every MCU overlapping a mask rectangle becomes a flat block
+ *     (luma = mask level, chroma neutral). Rectangles grow to MCU bounds.
+ *   - Timestamp: "YYYY-MM-DD HH:MM:SS" drawn from a 5x7 font. Each 8x8 luma
+ *     block of a glyph is forward-DCT'd and quantized once per luma table
+ *     and cached, so drawing is a block copy. Chroma under the text is
+ *     neutral (gray/white text regardless of the scene).
+ *
+ * Cost is one Huffman decode + encode of the frame. A frame that cannot be
+ * parsed or does not fit is rejected, so the stream drops it instead of
+ * committing it unmasked.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include "civil_time.hpp"
+#include "jpeg_codec.hpp"
+#include "jpeg_encoder.hpp"
+#include "roi_crop.hpp"
+#include "../interfaces/i_frame_processor.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace core {
+
+static constexpr size_t OVERLAY_MAX_MASKS = 8;
+static constexpr size_t OVERLAY_TIMESTAMP_LENGTH = 19;   // "YYYY-MM-DD HH:MM:SS"
+
+struct OverlayConfig {
+    RoiRect masks[OVERLAY_MAX_MASKS];
+    size_t num_masks = 0;
+    uint8_t mask_luma = 16;           // Video black
+
+    bool timestamp = true;
+    uint16_t timestamp_x = 0;         // Top-left, snapped down to the MCU grid
+    uint16_t timestamp_y = 0;
+    uint8_t text_scale = 2;           // 1: 8x8 px per character, 2: 16x16
+    uint8_t text_luma = 235;
+    uint8_t background_luma = 16;
+};
+
+struct OverlayStats {
+    uint32_t frames;
+    uint32_t rejected;                // Unparseable or output too large
+    uint32_t masked_mcus;             // Per frame, last frame
+    uint32_t text_mcus;
+};
+
+/**
+ * @brief Parse "x,y,w,h;x,y,w,h;..." (pixels) into the mask list
+ * @return false on malformed input or more than OVERLAY_MAX_MASKS rectangles
+ */
+inline bool parse_overlay_masks(const char* text, OverlayConfig* config) {
+    if (!text || !config) return false;
+    config->num_masks = 0;
+    while (*text) {
+        const char* end = strchr(text, ';');
+        size_t len = end ? static_cast<size_t>(end - text) : strlen(text);
+        char part[32];
+        if (len == 0 || len >= sizeof(part) || config->num_masks >= OVERLAY_MAX_MASKS) return false;
+        if (end && end[1] == '\0') return false;   // Trailing separator
+        memcpy(part, text, len);
+        part[len] = '\0';
+        if (!parse_roi(part, &config->masks[config->num_masks])) return false;
+        config->num_masks++;
+        text += len + (end ? 1 : 0);
+    }
+    return true;
+}
+
+/**
+ * @brief Format seconds since the Unix epoch as "YYYY-MM-DD HH:MM:SS" (UTC)
+ * @param out At least OVERLAY_TIMESTAMP_LENGTH + 1 bytes
+ */
+inline void format_overlay_timestamp(int64_t epoch_s, char* out) {
+    if (epoch_s < 0) epoch_s = 0;
+    int64_t days = epoch_s / 86400;
+    int64_t secs = epoch_s % 86400;
+
+    int64_t year, month, day;
+    civil_from_days(days, &year, &month, &day);
+    if (year > 9999) year = 9999;
+
+    auto put = [](char* p, int64_t v, int digits) {
+        for (int i = digits - 1; i >= 0; i--) {
+            p[i] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        }
+    };
+    put(out, year, 4);
+    out[4] = '-';
+    put(out + 5, month, 2);
+    out[7] = '-';
+    put(out + 8, day, 2);
+    out[10] = ' ';
+    put(out + 11, secs / 3600, 2);
+    out[13] = ':';
+    put(out + 14, secs / 60 % 60, 2);
+    out[16] = ':';
+    put(out + 17, secs % 60, 2);
+    out[OVERLAY_TIMESTAMP_LENGTH] = '\0';
+}
+
+/**
+ * @brief Rewrites masked and timestamp MCUs of each frame
+ *
+ * Usage:
+ *   JpegOverlayProcessor overlay;
+ *   overlay.init(config);
+ *   streaming.set_processor(&overlay);
+ *
+ * process() runs on the producer task only; set_clock_offset_us() may be
+ * called from any task (e.g. after SNTP sync).
+ */
+class JpegOverlayProcessor : public interfaces::IFrameProcessor {
+public:
+    static constexpr size_t GLYPH_COUNT = 13;   // 0-9, '-', ':', ' '
+
+    JpegOverlayProcessor() = default;
+
+    // Non-copyable
+    JpegOverlayProcessor(const JpegOverlayProcessor&) = delete;
+    JpegOverlayProcessor& operator=(const JpegOverlayProcessor&) = delete;
+
+    bool init(const OverlayConfig& config) {
+        if (config.num_masks > OVERLAY_MAX_MASKS) return false;
+        if (config.text_scale != 1 && config.text_scale != 2) return false;
+        for (size_t i = 0; i < config.num_masks; i++) {
+            if (config.masks[i].empty()) return false;
+        }
+        config_ = config;
+        cached_valid_ = false;
+        initialized_ = true;
+        return true;
+    }
+
+    bool is_initialized() const { return initialized_; }
+    const OverlayConfig& config() const { return config_; }
+
+    /**
+     * @brief Offset added to frame timestamps before formatting
+     *
+     * Frame timestamps count from boot; set this to (epoch - uptime) once
+     * wall-clock time is known. Until then the overlay shows uptime
+     * (1970-01-01 plus time since boot).
+     */
+    void set_clock_offset_us(int64_t offset_us) { clock_offset_us_.store(offset_us); }
+
+    OverlayStats stats() const {
+        return {frames_.load(std::memory_order_relaxed), rejected_.load(std::memory_order_relaxed),
+                masked_mcus_.load(std::memory_order_relaxed), text_mcus_.load(std::memory_order_relaxed)};
+    }
+
+    size_t process(const interfaces::FrameView& frame, uint8_t* out, size_t capacity) override {
+        size_t size = initialized_ ? rewrite(frame, out, capacity) : 0;
+        if (size == 0) rejected_.fetch_add(1, std::memory_order_relaxed);
+        else frames_.fetch_add(1, std::memory_order_relaxed);
+        return size;
+    }
+
+private:
+    // Rows of 5 bits, MSB = leftmost column
+    static constexpr uint8_t FONT[GLYPH_COUNT][7] = {
+        {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},   // 0
+        {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},   // 1
+        {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},   // 2
+        {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},   // 3
+        {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},   // 4
+        {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},   // 5
+        {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},   // 6
+        {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},   // 7
+        {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},   // 8
+        {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},   // 9
+        {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},   // -
+        {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00},   // :
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   // space
+    };
+
+    static size_t glyph_index(char c) {
+        if (c >= '0' && c <= '9') return static_cast<size_t>(c - '0');
+        if (c == '-') return 10;
+        if (c == ':') return 11;
+        return 12;
+    }
+
+    // MCU range [x0, x1) x [y0, y1)
+    struct McuRect {
+        uint16_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+        bool contains(uint16_t x, uint16_t y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+    };
+
+    static McuRect to_mcus(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const JpegInfo& info) {
+        McuRect r;
+        auto clamp = [](uint32_t v, uint16_t max) { return static_cast<uint16_t>(v < max ? v : max); };
+        r.x0 = clamp(x / info.mcu_width, info.mcus_x);
+        r.y0 = clamp(y / info.mcu_height, info.mcus_y);
+        r.x1 = clamp((x + w + info.mcu_width - 1) / info.mcu_width, info.mcus_x);
+        r.y1 = clamp((y + h + info.mcu_height - 1) / info.mcu_height, info.mcus_y);
+        return r;
+    }
+
+    // Quantized flat / glyph blocks for the frame's luma table
+    void refresh_blocks(const JpegInfo& info) {
+        const uint16_t* quant = info.quant[info.components[0].tq];
+        if (cached_valid_ && memcmp(quant, cached_quant_, sizeof(cached_quant_)) == 0) return;
+        memcpy(cached_quant_, quant, sizeof(cached_quant_));
+
+        uint16_t natural[64];
+        for (int k = 0; k < 64; k++) natural[JPEG_NATURAL_ORDER[k]] = quant[k];
+        JpegDivisors div;
+        div.build(natural);
+
+        int32_t samples[64];
+        JpegLanes rows[8];
+        auto flat = [&](uint8_t level, int16_t* out) {
+            for (auto& s : samples) s = level - 128;
+            jpeg_fdct_islow(samples, rows);
+            jpeg_quantize(rows, div, out);
+        };
+        flat(config_.mask_luma, mask_block_);
+        flat(config_.background_luma, background_block_);
+
+        const int scale = config_.text_scale;
+        for (size_t g = 0; g < GLYPH_COUNT; g++) {
+            for (int by = 0; by < scale; by++) {
+                for (int bx = 0; bx < scale; bx++) {
+                    for (int py = 0; py < 8; py++) {
+                        for (int px = 0; px < 8; px++) {
+                            int gx = (bx * 8 + px) / scale - 1;   // One column of left margin
+                            int gy = (by * 8 + py) / scale;
+                            bool on = gx >= 0 && gx < 5 && gy < 7 && (FONT[g][gy] >> (4 - gx)) & 1;
+                            samples[py * 8 + px] = (on ? config_.text_luma : config_.background_luma) - 128;
+                        }
+                    }
+                    jpeg_fdct_islow(samples, rows);
+                    jpeg_quantize(rows, div, glyph_blocks_[g][by * scale + bx]);
+                }
+            }
+        }
+        cached_valid_ = true;
+    }
+
+    size_t rewrite(const interfaces::FrameView& frame, uint8_t* out, size_t capacity) {
+        if (!frame.valid() || frame.format != interfaces::PixelFormat::Jpeg) return 0;
+        JpegInfo info;
+        if (!jpeg_parse(frame.data, frame.size, &info)) return 0;
+        refresh_blocks(info);
+
+        McuRect masks[OVERLAY_MAX_MASKS];
+        for (size_t i = 0; i < config_.num_masks; i++) {
+            const RoiRect& m = config_.masks[i];
+            masks[i] = to_mcus(m.x, m.y, m.w, m.h, info);
+        }
+
+        // Text origin on the MCU grid; the overlay covers whole MCUs
+        const uint32_t cell = 8u * config_.text_scale;
+        uint32_t tx = config_.timestamp_x / info.mcu_width * info.mcu_width;
+        uint32_t ty = config_.timestamp_y / info.mcu_height * info.mcu_height;
+        McuRect text;
+        char stamp[OVERLAY_TIMESTAMP_LENGTH + 1];
+        if (config_.timestamp) {
+            text = to_mcus(tx, ty, cell * OVERLAY_TIMESTAMP_LENGTH, cell, info);
+            int64_t us = frame.timestamp_us + clock_offset_us_.load();
+            format_overlay_timestamp(us / 1000000, stamp);
+        }
+
+        if (!decoder_.begin(frame.data, frame.size, info)) return 0;
+        JpegByteWriter w(out, capacity);
+        if (!jpeg_write_headers(w, info)) return 0;
+        encoder_.begin(w, info);
+
+        uint32_t masked = 0, texted = 0;
+        for (uint16_t my = 0; my < info.mcus_y; my++) {
+            for (uint16_t mx = 0; mx < info.mcus_x; mx++) {
+                if (!decoder_.decode_mcu(blocks_)) return 0;
+                bool in_mask = false;
+                for (size_t i = 0; i < config_.num_masks && !in_mask; i++) {
+                    in_mask = masks[i].contains(mx, my);
+                }
+                if (in_mask) {
+                    fill_mcu(info, mask_block_);
+                    masked++;
+                } else if (config_.timestamp && text.contains(mx, my)) {
+                    draw_text_mcu(info, mx, my, tx, ty, cell, stamp);
+                    texted++;
+                }
+                encoder_.encode_mcu(blocks_);
+            }
+            if (w.overflow()) return 0;
+        }
+        encoder_.finish();
+        w.marker(jpeg_marker::EOI);
+        if (w.overflow()) return 0;
+
+        masked_mcus_.store(masked, std::memory_order_relaxed);
+        text_mcus_.store(texted, std::memory_order_relaxed);
+        return w.size();
+    }
+
+    // Luma blocks from the given block, chroma neutral
+    void fill_mcu(const JpegInfo& info, const int16_t* luma) {
+        for (uint8_t b = 0; b < info.blocks_per_mcu; b++) {
+            if (info.block_component[b] == 0) memcpy(blocks_[b], luma, sizeof(blocks_[b]));
+            else memset(blocks_[b], 0, sizeof(blocks_[b]));
+        }
+    }
+
+    void draw_text_mcu(const JpegInfo& info, uint16_t mx, uint16_t my,
+                       uint32_t tx, uint32_t ty, uint32_t cell, const char* stamp) {
+        fill_mcu(info, background_block_);
+        const JpegComponent& luma = info.components[0];
+        if (info.num_components > 1 && (luma.h != info.max_h || luma.v != info.max_v)) return;
+
+        const uint8_t h = info.num_components > 1 ? luma.h : 1;
+        const uint8_t v = info.num_components > 1 ? luma.v : 1;
+        for (uint8_t i = 0; i < h * v; i++) {
+            // Luma blocks come first in the MCU, row-major
+            int64_t px = static_cast<int64_t>(mx) * info.mcu_width + (i % h) * 8 - tx;
+            int64_t py = static_cast<int64_t>(my) * info.mcu_height + (i / h) * 8 - ty;
+            if (px < 0 || py < 0 || py >= static_cast<int64_t>(cell) ||
+                px >= static_cast<int64_t>(cell * OVERLAY_TIMESTAMP_LENGTH)) {
+                continue;
+            }
+            size_t g = glyph_index(stamp[px / cell]);
+            size_t sub = (py / 8) * config_.text_scale + (px % cell) / 8;
+            memcpy(blocks_[i], glyph_blocks_[g][sub], sizeof(blocks_[i]));
+        }
+    }
+
+    OverlayConfig config_;
+    bool initialized_ = false;
+    std::atomic<int64_t> clock_offset_us_{0};
+
+    bool cached_valid_ = false;
+    uint16_t cached_quant_[64] = {};
+    int16_t mask_block_[64] = {};
+    int16_t background_block_[64] = {};
+    int16_t glyph_blocks_[GLYPH_COUNT][4][64] = {};   // Up to 2x2 blocks per glyph
+
+    int16_t blocks_[JPEG_MAX_BLOCKS_PER_MCU][64] = {};
+    JpegScanDecoder decoder_;
+    JpegScanEncoder encoder_;
+
+    std::atomic<uint32_t> frames_{0};
+    std::atomic<uint32_t> rejected_{0};
+    std::atomic<uint32_t> masked_mcus_{0};
+    std::atomic<uint32_t> text_mcus_{0};
+};
+
+} // namespace core
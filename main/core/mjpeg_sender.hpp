@@ -0,0 +1,334 @@
+/**
+ * @file mjpeg_sender.hpp
+ * @brief Non-blocking MJPEG output for one client, with slow-client eviction
+ *
+ * A blocking send holds its ring slot until the client drains it: with
+ * send_wait_timeout = 30 one stalled client pins a slot for up to 30 s, and
+ * while it does FrameBuffer::push() drops every new frame for everybody.
+ *
+ * MjpegSender keeps the client's output state instead (the part in flight
+ * and how far into it the socket got) and only ever writes what the socket
+ * takes right now:
+ *
+ *   poll() → Sent     a part finished; call again
+ *          → Idle     nothing newer than the last part: wait for a frame
+ *          → Blocked  socket full: wait until writable
+ *          → Closed / Evicted
+ *
+ * - Frames are leased (FrameBuffer::lease_latest), not pinned: if the client
+ *   makes no progress for the service's lease_timeout_ms the producer takes
+ *   the slot back. The rest of that part goes out as zeros so the
+ *   Content-Length framing holds; the client sees one damaged frame.
+ * - Between parts the sender always takes the newest frame, so a client
+ *   that fell behind skips straight to it (frames_skipped).
+ * - A client that takes nothing for stall_budget_ms while data is pending
+ *   is evicted.
+ * - A degraded client (admission control) gets at most one part per
+ *   min_interval_ms; finished parts are reported to an EgressMeter.
+ * - With an EgressScheduler each part is offered under the client's class
+ *   first; a part over the class's rate is not sent and the client waits
+ *   for the next frame (frames_deferred).
+ *
+ * The socket is a write callback, so host tests can drive it with a
+ * simulated stalled socket.
+ */
+#pragma once
+#include "streaming_service.hpp"
+#include "jpeg_metadata.hpp"
+#include "stream_admission.hpp"
+#include "egress_scheduler.hpp"
+#include "socket_write.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace core {
+
+struct MjpegSenderConfig {
+    uint32_t stall_budget_ms = 10000;   // No progress this long with data pending: evict
+    bool embed_metadata = true;         // Splice sequence/timestamp APP9 segment into JPEGs
+    uint32_t min_interval_ms = 0;       // Pace parts (degraded client; 0 = every frame)
+    EgressMeter* meter = nullptr;       // Finished parts are measured here (optional)
+    EgressScheduler* scheduler = nullptr;                 // Parts offered here first (optional)
+    ConsumerClass consumer_class = ConsumerClass::Operator;
+};
+
+/**
+ * @brief Statistics (thread-safe reads)
+ */
+struct MjpegSenderStats {
+    std::atomic<uint32_t> frames_sent{0};
+    std::atomic<uint32_t> frames_skipped{0};     // Committed while the client was behind
+    std::atomic<uint32_t> frames_truncated{0};   // Lease revoked mid-part: zero-padded
+    std::atomic<uint32_t> frames_deferred{0};    // Over the class's rate: not sent
+    std::atomic<uint32_t> blocked_writes{0};     // Socket full
+    std::atomic<uint32_t> partial_writes{0};     // Socket took part of a write
+    std::atomic<uint64_t> bytes_sent{0};
+
+    void reset() {
+        frames_sent = 0;
+        frames_skipped = 0;
+        frames_truncated = 0;
+        frames_deferred = 0;
+        blocked_writes = 0;
+        partial_writes = 0;
+        bytes_sent = 0;
+    }
+};
+
+enum class SendStep {
+    Sent,      // A part finished
+    Idle,      // No newer frame
+    Blocked,   // Socket full, data pending
+    Closed,    // Write failed
+    Evicted    // Stall budget exceeded
+};
+
+/**
+ * @brief One client's MJPEG stream over a non-blocking socket
+ *
+ * Usage:
+ *   sender.begin(svc, write_fn, sock, response_head, config, now_us);
+ *   while (running) {
+ *       switch (sender.poll(now_us)) {
+ *           case SendStep::Idle:
+ *               if (sender.resume_at_us() > now_us) sleep_until(sender.resume_at_us());
+ *               else svc.wait_frame_after(sender.last_sequence(), 500);
+ *               break;
+ *           case SendStep::Blocked: wait_writable(sock, 50); break;
+ *           case SendStep::Sent: break;
+ *           default: running = false;
+ *       }
+ *   }
+ *   sender.end();
+ */
+class MjpegSender {
+public:
+    static constexpr const char* BOUNDARY = "frame";
+
+    MjpegSender() = default;
+    ~MjpegSender() { end(); }
+
+    // Non-copyable (pieces point into the sender)
+    MjpegSender(const MjpegSender&) = delete;
+    MjpegSender& operator=(const MjpegSender&) = delete;
+
+    /**
+     * @param head Sent before the first part (HTTP response head); must
+     *             outlive the sender. nullptr = none.
+     * @param now_us Start of the stall budget for the head
+     */
+    bool begin(StreamingService& svc, SocketWriteFn write, void* context, const char* head,
+               const MjpegSenderConfig& config, int64_t now_us) {
+        if (!write) return false;
+        end();
+        svc_ = &svc;
+        write_ = write;
+        context_ = context;
+        config_ = config;
+        stats_.reset();
+        last_sequence_ = 0;
+        lease_ = -1;
+        count_ = 0;
+        index_ = 0;
+        offset_ = 0;
+        truncated_ = false;
+        done_ = false;
+        part_start_us_ = 0;
+        part_bytes_ = 0;
+        paced_ = false;
+        if (head && head[0]) {
+            pieces_[count_++] = {reinterpret_cast<const uint8_t*>(head), strlen(head), false};
+        }
+        last_progress_us_ = now_us;
+        return true;
+    }
+
+    /**
+     * @brief Release the frame in flight (the part is abandoned)
+     */
+    void end() {
+        if (svc_ && lease_ >= 0) svc_->release_lease(lease_);
+        lease_ = -1;
+        count_ = 0;
+        index_ = 0;
+        offset_ = 0;
+    }
+
+    /**
+     * @brief Write what the socket takes now
+     * @param now_us Current time (stall budget)
+     */
+    SendStep poll(int64_t now_us) {
+        if (!svc_ || done_) return SendStep::Closed;
+        if (index_ == count_ && !load_next(now_us)) return SendStep::Idle;
+
+        // The frame may only be read under lease_read_begin(); once revoked,
+        // zeros stand in for the rest of it
+        bool reading = false;
+        if (lease_ >= 0 && !truncated_) {
+            reading = svc_->lease_read_begin(lease_);
+            if (!reading) {
+                truncated_ = true;
+                stats_.frames_truncated++;
+            }
+        }
+
+        size_t written = 0;
+        int32_t n = 1;
+        while (index_ < count_) {
+            const Piece& piece = pieces_[index_];
+            const uint8_t* src = piece.data + offset_;
+            size_t len = piece.size - offset_;
+            if (piece.leased && truncated_) {
+                src = ZEROS;
+                if (len > sizeof(ZEROS)) len = sizeof(ZEROS);
+            }
+            n = write_(context_, src, len);
+            if (n <= 0) break;
+            if (static_cast<size_t>(n) < len) stats_.partial_writes++;
+            written += static_cast<size_t>(n);
+            offset_ += static_cast<size_t>(n);
+            if (offset_ >= piece.size) {
+                index_++;
+                offset_ = 0;
+            }
+        }
+        if (reading) svc_->lease_read_end(lease_, written > 0);
+
+        stats_.bytes_sent += written;
+        if (written > 0) last_progress_us_ = now_us;
+        if (n < 0) {
+            done_ = true;
+            end();
+            return SendStep::Closed;
+        }
+        if (index_ < count_) {
+            stats_.blocked_writes++;
+            if (now_us - last_progress_us_ >= static_cast<int64_t>(config_.stall_budget_ms) * 1000) {
+                done_ = true;
+                end();
+                return SendStep::Evicted;
+            }
+            return SendStep::Blocked;
+        }
+
+        // Part complete (or only the head went out)
+        if (lease_ >= 0) {
+            svc_->release_lease(lease_, !truncated_);
+            lease_ = -1;
+            stats_.frames_sent++;
+            if (config_.meter) {
+                config_.meter->on_frame(part_bytes_, static_cast<uint32_t>(now_us - part_start_us_), now_us);
+            }
+        }
+        count_ = 0;
+        index_ = 0;
+        return SendStep::Sent;
+    }
+
+    // Last sequence taken (wait_frame_after() this for the next)
+    uint32_t last_sequence() const { return last_sequence_; }
+    // Earliest start of the next part under min_interval_ms (0 = any time)
+    int64_t resume_at_us() const {
+        if (config_.min_interval_ms == 0 || !paced_) return 0;
+        return part_start_us_ + static_cast<int64_t>(config_.min_interval_ms) * 1000;
+    }
+    // Data of the current part still to go
+    bool pending() const { return index_ < count_; }
+    const MjpegSenderStats& stats() const { return stats_; }
+
+private:
+    struct Piece {
+        const uint8_t* data;
+        size_t size;
+        bool leased;   // Points into the ring
+    };
+
+    // Lease the newest frame and lay out its part; false if there is none
+    bool load_next(int64_t now_us) {
+        if (now_us < resume_at_us()) return false;
+        count_ = 0;
+        index_ = 0;
+        offset_ = 0;
+        truncated_ = false;
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        int64_t timestamp_us = 0;
+        uint32_t sequence = 0;
+        int lease = svc_->lease_frame_after(last_sequence_, &data, &size, &timestamp_us, &sequence);
+        if (lease >= 0 && !svc_->lease_read_begin(lease)) {
+            svc_->release_lease(lease);
+            lease = -1;
+        }
+        if (lease < 0) return false;
+
+        JpegSplice splice;
+        size_t seg_len = config_.embed_metadata
+            ? jpeg_build_metadata_segment({sequence, timestamp_us, FrameSource::Stream},
+                                          segment_, sizeof(segment_))
+            : 0;
+        if (!jpeg_splice_segment(data, size, segment_, seg_len, &splice)) {
+            // Not a JPEG: send untouched
+            splice = JpegSplice{};
+            splice.data[0] = data;
+            splice.size[0] = size;
+        }
+        svc_->lease_read_end(lease, false);
+
+        if (last_sequence_ != 0 && sequence > last_sequence_ + 1) {
+            stats_.frames_skipped += sequence - last_sequence_ - 1;
+        }
+        last_sequence_ = sequence;
+
+        int len = snprintf(part_header_, sizeof(part_header_),
+                           "\r\n--%s\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n",
+                           BOUNDARY, splice.total());
+        if (config_.scheduler &&
+            !config_.scheduler->offer(config_.consumer_class, static_cast<size_t>(len) + splice.total(), now_us)) {
+            svc_->release_lease(lease);
+            stats_.frames_deferred++;
+            return false;
+        }
+        lease_ = lease;
+        pieces_[count_++] = {reinterpret_cast<const uint8_t*>(part_header_), static_cast<size_t>(len), false};
+        for (size_t i = 0; i < JpegSplice::NUM_PARTS; i++) {
+            if (splice.size[i] == 0) continue;
+            pieces_[count_++] = {splice.data[i], splice.size[i], splice.data[i] != segment_};
+        }
+        last_progress_us_ = now_us;   // The budget runs while data is pending
+        part_start_us_ = now_us;
+        paced_ = true;
+        part_bytes_ = 0;
+        for (size_t i = 0; i < count_; i++) part_bytes_ += pieces_[i].size;
+        return true;
+    }
+
+    static constexpr uint8_t ZEROS[256] = {};
+    static constexpr size_t MAX_PIECES = 2 + JpegSplice::NUM_PARTS;   // Head, part header, splice
+
+    StreamingService* svc_ = nullptr;
+    SocketWriteFn write_ = nullptr;
+    void* context_ = nullptr;
+    MjpegSenderConfig config_;
+    MjpegSenderStats stats_;
+
+    Piece pieces_[MAX_PIECES] = {};
+    size_t count_ = 0;
+    size_t index_ = 0;         // Piece in flight
+    size_t offset_ = 0;        // Bytes of it already sent
+    int lease_ = -1;
+    bool truncated_ = false;   // Lease revoked: padding the rest
+    bool done_ = false;
+    uint32_t last_sequence_ = 0;
+    int64_t last_progress_us_ = 0;
+    int64_t part_start_us_ = 0;   // Part in flight (or last part) loaded
+    size_t part_bytes_ = 0;
+    bool paced_ = false;          // A part was loaded: resume_at_us() applies
+    char part_header_[96] = {};
+    uint8_t segment_[JPEG_METADATA_SEGMENT_SIZE] = {};
+};
+
+} // namespace core
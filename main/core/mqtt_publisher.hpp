@@ -0,0 +1,723 @@
+/**
+ * @file mqtt_publisher.hpp
+ * @brief Publishes frames, events and status deltas to an MQTT broker
+ *
+ * Architecture:
+ *   [Producer] → on_frame() ──→ [pending frame] ⇄ [sending] ─┐
+ *   [Anyone]   → publish_event() → [event queue] ─────────────┼→ [Publisher Task] → IMqttClient
+ *   [Owner]    → publish_status() → [latest snapshot] ────────┘   (chunk, batch, window)
+ *
+ * Nothing on the producer side waits for the broker: frames are handed
+ * over latest-wins (a newer frame replaces one not yet started), events go
+ * into a bounded queue that drops its oldest entry when full, and status
+ * snapshots coalesce into the newest one.
+ *
+ * The task sends, in priority order:
+ * - Events: everything queued, batched into one JSON array per publish, so
+ *   a burst costs one QoS 1 round trip instead of one per event.
+ * - Status: a delta against the last snapshot the broker got (a full one
+ *   after every reconnect), serialized like the /events stream.
+ * - Frames: one chunk per pass, so events never wait behind a large frame.
+ *   Each chunk starts with a 20-byte header (see MqttChunkHeader).
+ *
+ * QoS 1 messages occupy an in-flight slot until the broker acknowledges
+ * them; at most max_inflight are outstanding, so a slow broker throttles
+ * the task (and frames get superseded) instead of growing the client's
+ * outbox. Slots not acknowledged within ack_timeout are reclaimed.
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::thread on host.
+ */
+#pragma once
+#include "../interfaces/i_clock.hpp"
+#include "../interfaces/i_frame_sink.hpp"
+#include "../interfaces/i_mqtt_client.hpp"
+#include "stats_publisher.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+namespace core {
+
+// =============================================================================
+// Frame chunk header
+// =============================================================================
+
+static constexpr size_t MQTT_CHUNK_HEADER_SIZE = 20;
+
+/**
+ * @brief Prefix of every frame chunk payload (big-endian on the wire)
+ *
+ * Layout: sequence(4) index(2) count(2) total_size(4) timestamp_us(8).
+ * A subscriber reassembles a frame from the count chunks sharing a
+ * sequence; chunk i holds bytes [i * chunk_size, ...) of the JPEG.
+ */
+struct MqttChunkHeader {
+    uint32_t sequence = 0;
+    uint16_t index = 0;
+    uint16_t count = 0;
+    uint32_t total_size = 0;
+    int64_t timestamp_us = 0;
+};
+
+inline void mqtt_write_chunk_header(const MqttChunkHeader& h, uint8_t* out) {
+    auto put = [&out](uint64_t v, int bytes) {
+        for (int i = bytes - 1; i >= 0; i--) *out++ = static_cast<uint8_t>(v >> (8 * i));
+    };
+    put(h.sequence, 4);
+    put(h.index, 2);
+    put(h.count, 2);
+    put(h.total_size, 4);
+    put(static_cast<uint64_t>(h.timestamp_us), 8);
+}
+
+/**
+ * @return false if size is too short or the indices are inconsistent
+ */
+inline bool mqtt_parse_chunk_header(const uint8_t* data, size_t size, MqttChunkHeader* out) {
+    if (!data || !out || size < MQTT_CHUNK_HEADER_SIZE) return false;
+    auto get = [&data](int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v = (v << 8) | *data++;
+        return v;
+    };
+    out->sequence = static_cast<uint32_t>(get(4));
+    out->index = static_cast<uint16_t>(get(2));
+    out->count = static_cast<uint16_t>(get(2));
+    out->total_size = static_cast<uint32_t>(get(4));
+    out->timestamp_us = static_cast<int64_t>(get(8));
+    return out->count > 0 && out->index < out->count;
+}
+
+// =============================================================================
+// Publisher
+// =============================================================================
+
+struct MqttPublisherConfig {
+    const char* frame_topic = "espcam/frame";     // Topics must outlive the publisher
+    const char* event_topic = "espcam/event";
+    const char* status_topic = "espcam/status";
+    bool publish_frames = true;
+    uint8_t frame_qos = 0;                // Lost chunks lose a frame; the next one follows
+    uint8_t event_qos = 1;
+    uint8_t status_qos = 0;               // Deltas: a lost one is corrected by the next full
+    size_t max_frame_size = 100 * 1024;   // Larger frames are skipped
+    size_t chunk_size = 16 * 1024;        // Frame bytes per message (plus header)
+    size_t max_inflight = 8;              // Unacknowledged QoS 1 messages
+    uint32_t ack_timeout_ms = 5000;       // Slot reclaimed after this
+    uint32_t frame_interval_ms = 0;       // Minimum spacing between frames (0 = as fast as possible)
+};
+
+struct MqttPublisherStats {
+    std::atomic<uint32_t> frames_offered{0};
+    std::atomic<uint32_t> frames_published{0};
+    std::atomic<uint32_t> frames_superseded{0};   // Replaced before sending started
+    std::atomic<uint32_t> frames_rejected{0};     // Larger than max_frame_size
+    std::atomic<uint32_t> frames_abandoned{0};    // Publish failed or link lost mid-frame
+    std::atomic<uint32_t> chunks_published{0};
+    std::atomic<uint32_t> events_published{0};
+    std::atomic<uint32_t> event_batches{0};
+    std::atomic<uint32_t> events_dropped{0};      // Queue overflow or publish failure
+    std::atomic<uint32_t> status_published{0};
+    std::atomic<uint32_t> publish_errors{0};
+    std::atomic<uint32_t> acks{0};
+    std::atomic<uint32_t> ack_timeouts{0};
+    std::atomic<uint32_t> inflight{0};            // Currently unacknowledged
+    std::atomic<uint64_t> bytes_published{0};
+    std::atomic<bool> running{false};
+
+    void reset() {
+        frames_offered = 0;
+        frames_published = 0;
+        frames_superseded = 0;
+        frames_rejected = 0;
+        frames_abandoned = 0;
+        chunks_published = 0;
+        events_published = 0;
+        event_batches = 0;
+        events_dropped = 0;
+        status_published = 0;
+        publish_errors = 0;
+        acks = 0;
+        ack_timeouts = 0;
+        inflight = 0;
+        bytes_published = 0;
+    }
+};
+
+/**
+ * @brief IFrameSink publishing frames, events and status over MQTT
+ *
+ * Usage:
+ *   MqttPublisher mqtt(client, clock);
+ *   mqtt.init(config);
+ *   streaming.add_sink(&mqtt);
+ *   mqtt.start();
+ *   mqtt.publish_event("{\"type\":\"motion\"}");
+ *   mqtt.publish_status(snapshot);
+ */
+class MqttPublisher : public interfaces::IFrameSink {
+public:
+    static constexpr size_t MAX_EVENT_SIZE = 192;      // One event's JSON
+    static constexpr size_t MAX_QUEUED_EVENTS = 16;
+    static constexpr size_t MAX_EVENT_BATCH = 1024;    // One published event array
+    static constexpr size_t MAX_INFLIGHT = 32;
+
+    MqttPublisher(interfaces::IMqttClient& client, interfaces::IClock& clock)
+        : client_(client), clock_(clock) {}
+
+    ~MqttPublisher() override { deinit(); }
+
+    // Non-copyable
+    MqttPublisher(const MqttPublisher&) = delete;
+    MqttPublisher& operator=(const MqttPublisher&) = delete;
+
+    /**
+     * @brief Allocate frame and chunk buffers and register for acks
+     * @param use_psram Use PSRAM for the buffers (ESP32 only)
+     * @return false on invalid config or allocation failure
+     */
+    bool init(const MqttPublisherConfig& config, bool use_psram = true) {
+        if (initialized_) return true;
+        if (!config.frame_topic || !config.event_topic || !config.status_topic) return false;
+        if (config.chunk_size == 0 || config.max_frame_size == 0) return false;
+        if (config.max_inflight == 0 || config.max_inflight > MAX_INFLIGHT) return false;
+        if (config.frame_qos > 1 || config.event_qos > 1 || config.status_qos > 1) return false;
+        // Chunk indices are 16-bit
+        if ((config.max_frame_size + config.chunk_size - 1) / config.chunk_size > 0xFFFF) return false;
+        config_ = config;
+
+        if (config_.publish_frames) {
+            for (auto*& buf : frames_) {
+                buf = alloc(config_.max_frame_size, use_psram);
+                if (!buf) {
+                    deinit();
+                    return false;
+                }
+            }
+            chunk_buf_ = alloc(MQTT_CHUNK_HEADER_SIZE + config_.chunk_size, use_psram);
+            if (!chunk_buf_) {
+                deinit();
+                return false;
+            }
+            pending_ = frames_[0];
+            sending_ = frames_[1];
+        }
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        work_ready_ = xSemaphoreCreateBinary();
+        if (!mutex_ || !work_ready_) {
+            deinit();
+            return false;
+        }
+#endif
+        client_.set_ack_handler(&MqttPublisher::ack_trampoline, this);
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        stop();
+        if (initialized_) client_.set_ack_handler(nullptr, nullptr);
+        for (auto*& buf : frames_) {
+            release(buf);
+            buf = nullptr;
+        }
+        release(chunk_buf_);
+        chunk_buf_ = nullptr;
+        pending_ = nullptr;
+        sending_ = nullptr;
+        has_pending_ = false;
+        frame_active_ = false;
+
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+        if (work_ready_) {
+            vSemaphoreDelete(work_ready_);
+            work_ready_ = nullptr;
+        }
+#endif
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Start the publisher task
+     */
+    bool start() {
+        if (!initialized_) return false;
+        if (stats_.running.load()) return true;
+        stop_requested_ = false;
+        stats_.reset();
+        inflight_count_ = 0;
+        early_ack_count_ = 0;
+        stats_.running = true;
+
+#ifdef ESP_PLATFORM
+        if (xTaskCreatePinnedToCore(publish_task_wrapper, "mqtt_pub", 4096, this, 3,
+                                    &publish_task_, 0) != pdPASS) {
+            stats_.running = false;
+            return false;
+        }
+#else
+        publish_thread_ = std::thread(&MqttPublisher::publish_loop, this);
+#endif
+        return true;
+    }
+
+    void stop() {
+        stop_requested_ = true;
+#ifdef ESP_PLATFORM
+        if (work_ready_) xSemaphoreGive(work_ready_);
+        for (int i = 0; i < 50 && stats_.running.load(); i++) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        if (publish_task_ && stats_.running.load()) {
+            vTaskDelete(publish_task_);
+            stats_.running = false;
+        }
+        publish_task_ = nullptr;
+#else
+        wake();
+        if (publish_thread_.joinable()) publish_thread_.join();
+        stats_.running = false;
+#endif
+    }
+
+    // IFrameSink: copy into the pending slot, replacing a frame not yet started
+    void on_frame(const uint8_t* data, size_t size,
+                  int64_t timestamp_us, uint32_t sequence) override {
+        if (!initialized_ || !config_.publish_frames || !stats_.running.load()) return;
+        stats_.frames_offered++;
+        if (!data || size == 0 || size > config_.max_frame_size) {
+            stats_.frames_rejected++;
+            return;
+        }
+
+        lock();
+        if (has_pending_) stats_.frames_superseded++;
+        memcpy(pending_, data, size);
+        pending_size_ = size;
+        pending_ts_ = timestamp_us;
+        pending_seq_ = sequence;
+        has_pending_ = true;
+        unlock();
+        wake();
+    }
+
+    /**
+     * @brief Queue an event (a JSON object) for the event topic
+     * @return false if it does not fit MAX_EVENT_SIZE; the oldest queued
+     *         event is dropped if the queue is full
+     */
+    bool publish_event(const char* json) {
+        if (!initialized_ || !json) return false;
+        size_t len = strlen(json);
+        if (len == 0 || len >= MAX_EVENT_SIZE) return false;
+
+        lock();
+        if (event_count_ == MAX_QUEUED_EVENTS) {
+            event_head_ = (event_head_ + 1) % MAX_QUEUED_EVENTS;
+            event_count_--;
+            stats_.events_dropped++;
+        }
+        size_t slot = (event_head_ + event_count_) % MAX_QUEUED_EVENTS;
+        memcpy(events_[slot], json, len);
+        event_len_[slot] = len;
+        event_count_++;
+        unlock();
+        wake();
+        return true;
+    }
+
+    /**
+     * @brief Offer the current status; only changed fields are published
+     */
+    void publish_status(const StatusSnapshot& snap) {
+        if (!initialized_) return;
+        lock();
+        bool changed = !status_valid_ || snap != latest_status_;
+        latest_status_ = snap;
+        status_valid_ = true;
+        if (changed) status_dirty_ = true;
+        unlock();
+        if (changed) wake();
+    }
+
+    /**
+     * @brief Broker acknowledged a QoS 1 message (client task; exposed for tests)
+     */
+    void on_ack(int msg_id) {
+        lock();
+        if (!remove_inflight(msg_id) && early_ack_count_ < MAX_INFLIGHT) {
+            // Acked before publish() returned and the slot was recorded
+            early_acks_[early_ack_count_++] = msg_id;
+        }
+        unlock();
+        stats_.acks++;
+        wake();
+    }
+
+    const MqttPublisherStats& stats() const { return stats_; }
+    const MqttPublisherConfig& config() const { return config_; }
+    bool is_running() const { return stats_.running.load(); }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    static constexpr uint32_t IDLE_WAIT_MS = 50;
+
+    struct Inflight {
+        int msg_id = 0;
+        int64_t sent_us = 0;
+    };
+
+#ifdef ESP_PLATFORM
+    static void publish_task_wrapper(void* arg) {
+        static_cast<MqttPublisher*>(arg)->publish_loop();
+        vTaskDelete(nullptr);
+    }
+#endif
+
+    static void ack_trampoline(void* ctx, int msg_id) {
+        static_cast<MqttPublisher*>(ctx)->on_ack(msg_id);
+    }
+
+    static uint8_t* alloc(size_t size, bool use_psram) {
+#ifdef ESP_PLATFORM
+        return static_cast<uint8_t*>(use_psram ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM)
+                                               : malloc(size));
+#else
+        (void)use_psram;
+        return static_cast<uint8_t*>(malloc(size));
+#endif
+    }
+
+    static void release(uint8_t* buf) {
+        if (!buf) return;
+#ifdef ESP_PLATFORM
+        heap_caps_free(buf);
+#else
+        free(buf);
+#endif
+    }
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    void wake() {
+#ifdef ESP_PLATFORM
+        if (work_ready_) xSemaphoreGive(work_ready_);
+#else
+        {
+            std::lock_guard<std::mutex> guard(wake_mutex_);
+            work_flag_ = true;
+        }
+        wake_cv_.notify_one();
+#endif
+    }
+
+    void wait_for_work(uint32_t timeout_ms) {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(work_ready_, pdMS_TO_TICKS(timeout_ms));
+#else
+        std::unique_lock<std::mutex> guard(wake_mutex_);
+        wake_cv_.wait_for(guard, std::chrono::milliseconds(timeout_ms),
+                          [this] { return work_flag_ || stop_requested_.load(); });
+        work_flag_ = false;
+#endif
+    }
+
+    // --- In-flight window (under lock) ------------------------------------
+
+    bool remove_inflight(int msg_id) {
+        for (size_t i = 0; i < inflight_count_; i++) {
+            if (inflight_[i].msg_id == msg_id) {
+                inflight_[i] = inflight_[--inflight_count_];
+                stats_.inflight = static_cast<uint32_t>(inflight_count_);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void track_inflight(int msg_id, int64_t now_us) {
+        lock();
+        for (size_t i = 0; i < early_ack_count_; i++) {
+            if (early_acks_[i] == msg_id) {
+                early_acks_[i] = early_acks_[--early_ack_count_];
+                unlock();
+                return;
+            }
+        }
+        if (inflight_count_ < MAX_INFLIGHT) {
+            inflight_[inflight_count_++] = {msg_id, now_us};
+            stats_.inflight = static_cast<uint32_t>(inflight_count_);
+        }
+        unlock();
+    }
+
+    void expire_inflight(int64_t now_us) {
+        int64_t timeout_us = static_cast<int64_t>(config_.ack_timeout_ms) * 1000;
+        lock();
+        for (size_t i = 0; i < inflight_count_;) {
+            if (now_us - inflight_[i].sent_us >= timeout_us) {
+                inflight_[i] = inflight_[--inflight_count_];
+                stats_.ack_timeouts++;
+            } else {
+                i++;
+            }
+        }
+        stats_.inflight = static_cast<uint32_t>(inflight_count_);
+        unlock();
+    }
+
+    bool window_open(uint8_t qos) {
+        if (qos == 0) return true;
+        lock();
+        bool open = inflight_count_ < config_.max_inflight;
+        unlock();
+        return open;
+    }
+
+    bool send(const char* topic, const uint8_t* payload, size_t size, uint8_t qos) {
+        int id = client_.publish(topic, payload, size, qos, false);
+        if (id < 0) {
+            stats_.publish_errors++;
+            return false;
+        }
+        stats_.bytes_published += size;
+        if (qos > 0 && id > 0) track_inflight(id, clock_.now_us());
+        return true;
+    }
+
+    // --- Senders (publisher task) -----------------------------------------
+
+    // All queued events that fit one batch, as one message
+    bool send_events() {
+        if (!window_open(config_.event_qos)) return false;
+        char batch[MAX_EVENT_BATCH];
+        size_t len = 0;
+        size_t taken = 0;
+
+        lock();
+        while (taken < event_count_) {
+            size_t slot = (event_head_ + taken) % MAX_QUEUED_EVENTS;
+            size_t need = event_len_[slot] + 1;   // Separator or bracket
+            if (len + need + 2 > sizeof(batch)) break;
+            batch[len++] = taken == 0 ? '[' : ',';
+            memcpy(batch + len, events_[slot], event_len_[slot]);
+            len += event_len_[slot];
+            taken++;
+        }
+        event_head_ = (event_head_ + taken) % MAX_QUEUED_EVENTS;
+        event_count_ -= taken;
+        unlock();
+        if (taken == 0) return false;
+
+        const char* payload = batch;
+        if (taken == 1) {
+            payload = batch + 1;   // A lone event goes out as a plain object
+            len -= 1;
+        } else {
+            batch[len++] = ']';
+        }
+        if (!send(config_.event_topic, reinterpret_cast<const uint8_t*>(payload), len,
+                  config_.event_qos)) {
+            stats_.events_dropped += static_cast<uint32_t>(taken);
+            return false;
+        }
+        stats_.events_published += static_cast<uint32_t>(taken);
+        stats_.event_batches++;
+        return true;
+    }
+
+    bool send_status() {
+        if (!window_open(config_.status_qos)) return false;
+        lock();
+        bool dirty = status_dirty_;
+        StatusSnapshot snap = latest_status_;
+        status_dirty_ = false;
+        unlock();
+        if (!dirty) return false;
+
+        char json[StatsPublisher::MAX_EVENT_SIZE];
+        size_t len = format_status_json(snap, have_sent_status_ ? &sent_status_ : nullptr,
+                                        json, sizeof(json));
+        if (len == 0) return false;   // Changed back before we got to it
+        if (!send(config_.status_topic, reinterpret_cast<const uint8_t*>(json), len,
+                  config_.status_qos)) {
+            lock();
+            status_dirty_ = true;
+            unlock();
+            return false;
+        }
+        sent_status_ = snap;
+        have_sent_status_ = true;
+        stats_.status_published++;
+        return true;
+    }
+
+    // Next chunk of the current frame, taking the pending frame when idle
+    bool send_frame_chunk() {
+        if (!config_.publish_frames) return false;
+        if (!frame_active_) {
+            int64_t now = clock_.now_us();
+            if (config_.frame_interval_ms && last_frame_start_us_ &&
+                now - last_frame_start_us_ < static_cast<int64_t>(config_.frame_interval_ms) * 1000) {
+                return false;
+            }
+            lock();
+            bool taken = has_pending_;
+            if (taken) {
+                uint8_t* tmp = sending_;
+                sending_ = pending_;
+                pending_ = tmp;
+                frame_.sequence = pending_seq_;
+                frame_.total_size = static_cast<uint32_t>(pending_size_);
+                frame_.timestamp_us = pending_ts_;
+                has_pending_ = false;
+            }
+            unlock();
+            if (!taken) return false;
+            frame_.index = 0;
+            frame_.count = static_cast<uint16_t>(
+                (frame_.total_size + config_.chunk_size - 1) / config_.chunk_size);
+            frame_active_ = true;
+            last_frame_start_us_ = now ? now : 1;
+        }
+        if (!window_open(config_.frame_qos)) return false;
+
+        size_t offset = static_cast<size_t>(frame_.index) * config_.chunk_size;
+        size_t len = frame_.total_size - offset;
+        if (len > config_.chunk_size) len = config_.chunk_size;
+        mqtt_write_chunk_header(frame_, chunk_buf_);
+        memcpy(chunk_buf_ + MQTT_CHUNK_HEADER_SIZE, sending_ + offset, len);
+        if (!send(config_.frame_topic, chunk_buf_, MQTT_CHUNK_HEADER_SIZE + len, config_.frame_qos)) {
+            frame_active_ = false;
+            stats_.frames_abandoned++;
+            return false;
+        }
+        stats_.chunks_published++;
+        if (++frame_.index == frame_.count) {
+            frame_active_ = false;
+            stats_.frames_published++;
+        }
+        return true;
+    }
+
+    void publish_loop() {
+        while (!stop_requested_.load()) {
+            expire_inflight(clock_.now_us());
+
+            bool connected = client_.connected();
+            if (!connected) {
+                if (frame_active_) {
+                    frame_active_ = false;
+                    stats_.frames_abandoned++;
+                }
+                if (was_connected_) {
+                    // Next status after reconnect is a full snapshot
+                    have_sent_status_ = false;
+                    lock();
+                    status_dirty_ = status_valid_;
+                    unlock();
+                }
+                was_connected_ = false;
+                wait_for_work(IDLE_WAIT_MS);
+                continue;
+            }
+            was_connected_ = true;
+
+            bool progressed = send_events();
+            progressed |= send_status();
+            progressed |= send_frame_chunk();
+            if (!progressed) wait_for_work(IDLE_WAIT_MS);
+        }
+        stats_.running = false;
+    }
+
+    interfaces::IMqttClient& client_;
+    interfaces::IClock& clock_;
+
+    MqttPublisherConfig config_;
+    MqttPublisherStats stats_;
+
+    // Frames: pending_ written by the producer under the lock
+    uint8_t* frames_[2] = {nullptr, nullptr};
+    uint8_t* pending_ = nullptr;
+    uint8_t* sending_ = nullptr;     // Owned by the publisher task
+    uint8_t* chunk_buf_ = nullptr;   // Owned by the publisher task
+    size_t pending_size_ = 0;
+    int64_t pending_ts_ = 0;
+    uint32_t pending_seq_ = 0;
+    bool has_pending_ = false;
+    MqttChunkHeader frame_;          // Frame being sent (task)
+    bool frame_active_ = false;
+    int64_t last_frame_start_us_ = 0;
+
+    // Events (under the lock)
+    char events_[MAX_QUEUED_EVENTS][MAX_EVENT_SIZE] = {};
+    size_t event_len_[MAX_QUEUED_EVENTS] = {};
+    size_t event_head_ = 0;
+    size_t event_count_ = 0;
+
+    // Status: latest_ under the lock, sent_ owned by the task
+    StatusSnapshot latest_status_;
+    bool status_valid_ = false;
+    bool status_dirty_ = false;
+    StatusSnapshot sent_status_;
+    bool have_sent_status_ = false;
+    bool was_connected_ = false;
+
+    // In-flight QoS 1 messages (under the lock)
+    Inflight inflight_[MAX_INFLIGHT];
+    size_t inflight_count_ = 0;
+    int early_acks_[MAX_INFLIGHT] = {};
+    size_t early_ack_count_ = 0;
+
+    std::atomic<bool> stop_requested_{false};
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t publish_task_ = nullptr;
+    SemaphoreHandle_t mutex_ = nullptr;
+    SemaphoreHandle_t work_ready_ = nullptr;
+#else
+    std::thread publish_thread_;
+    std::mutex mutex_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool work_flag_ = false;
+#endif
+};
+
+} // namespace core
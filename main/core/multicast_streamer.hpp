@@ -0,0 +1,356 @@
+/**
+ * @file multicast_streamer.hpp
+ * @brief Paced RTP/JPEG multicast of the live stream with parity packets
+ *
+ * Architecture:
+ *   [Producer] → on_frame() → [pending] ⇄ [sending] → [Sender Task] → IDatagramSender
+ *                (copy, latest wins)                    (packetize once, pace)
+ *
+ * Every viewer joins the same multicast group, so airtime no longer grows
+ * with the number of monitors. The producer hands frames over without
+ * waiting: if the sender is still busy with the previous frame, a newer one
+ * replaces the pending frame instead of queueing behind it.
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::thread on host.
+ */
+#pragma once
+#include "../interfaces/i_clock.hpp"
+#include "../interfaces/i_datagram_sender.hpp"
+#include "../interfaces/i_frame_sink.hpp"
+#include "rtp_jpeg.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+namespace core {
+
+struct MulticastConfig {
+    uint16_t port = 5004;                 // RTP/JPEG; parity goes to port + 2
+    size_t max_frame_size = 100 * 1024;   // Larger frames are skipped
+    size_t max_datagram = 1400;           // Stay under the Wi-Fi MTU
+    uint8_t parity_group = 4;             // Media packets per parity packet (0 = none)
+    uint32_t rate_kbps = 8000;            // Pacing rate (kilobits/s)
+    uint32_t burst_bytes = 4 * 1400;      // Sent back-to-back before pacing applies
+    uint32_t ssrc = 0x45535043;           // "ESPC"
+};
+
+struct MulticastStats {
+    std::atomic<uint32_t> frames_offered{0};     // Frames handed over by the producer
+    std::atomic<uint32_t> frames_sent{0};
+    std::atomic<uint32_t> frames_superseded{0};  // Replaced by a newer frame before sending
+    std::atomic<uint32_t> frames_rejected{0};    // Too large or not RTP/JPEG compatible
+    std::atomic<uint32_t> packets_sent{0};
+    std::atomic<uint32_t> parity_sent{0};
+    std::atomic<uint32_t> send_errors{0};
+    std::atomic<uint64_t> bytes_sent{0};
+    std::atomic<bool> running{false};
+
+    void reset() {
+        frames_offered = 0;
+        frames_sent = 0;
+        frames_superseded = 0;
+        frames_rejected = 0;
+        packets_sent = 0;
+        parity_sent = 0;
+        send_errors = 0;
+        bytes_sent = 0;
+    }
+};
+
+/**
+ * @brief IFrameSink that multicasts every frame it can keep up with
+ *
+ * Usage:
+ *   MulticastStreamer mcast(udp, clock);
+ *   mcast.init(config);
+ *   streaming.add_sink(&mcast);
+ *   mcast.start();
+ */
+class MulticastStreamer : public interfaces::IFrameSink {
+public:
+    MulticastStreamer(interfaces::IDatagramSender& sender, interfaces::IClock& clock)
+        : sender_(sender), clock_(clock) {}
+
+    ~MulticastStreamer() override { deinit(); }
+
+    // Non-copyable
+    MulticastStreamer(const MulticastStreamer&) = delete;
+    MulticastStreamer& operator=(const MulticastStreamer&) = delete;
+
+    /**
+     * @brief Allocate the frame hand-over buffers
+     * @param use_psram Use PSRAM for frame copies (ESP32 only)
+     * @return false on invalid config or allocation failure
+     */
+    bool init(const MulticastConfig& config, bool use_psram = true) {
+        if (initialized_) return true;
+        if (config.max_frame_size == 0) return false;
+        if (!packetizer_.configure(config.max_datagram, config.parity_group, config.ssrc)) return false;
+        config_ = config;
+        pacer_.configure(config.rate_kbps * 1000 / 8, config.burst_bytes);
+
+        for (auto*& buf : frames_) {
+#ifdef ESP_PLATFORM
+            buf = static_cast<uint8_t*>(use_psram
+                ? heap_caps_malloc(config.max_frame_size, MALLOC_CAP_SPIRAM)
+                : malloc(config.max_frame_size));
+#else
+            (void)use_psram;
+            buf = static_cast<uint8_t*>(malloc(config.max_frame_size));
+#endif
+            if (!buf) {
+                deinit();
+                return false;
+            }
+        }
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        frame_ready_ = xSemaphoreCreateBinary();
+        if (!mutex_ || !frame_ready_) {
+            deinit();
+            return false;
+        }
+#endif
+
+        pending_ = frames_[0];
+        sending_ = frames_[1];
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        stop();
+        for (auto*& buf : frames_) {
+            if (!buf) continue;
+#ifdef ESP_PLATFORM
+            heap_caps_free(buf);
+#else
+            free(buf);
+#endif
+            buf = nullptr;
+        }
+        pending_ = nullptr;
+        sending_ = nullptr;
+        has_pending_ = false;
+
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+        if (frame_ready_) {
+            vSemaphoreDelete(frame_ready_);
+            frame_ready_ = nullptr;
+        }
+#endif
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Start the sender task
+     */
+    bool start() {
+        if (!initialized_) return false;
+        if (stats_.running.load()) return true;
+        stop_requested_ = false;
+        stats_.reset();
+        stats_.running = true;
+
+#ifdef ESP_PLATFORM
+        if (xTaskCreatePinnedToCore(sender_task_wrapper, "mcast_send", 4096, this, 4,
+                                    &sender_task_, 0) != pdPASS) {
+            stats_.running = false;
+            return false;
+        }
+#else
+        sender_thread_ = std::thread(&MulticastStreamer::sender_loop, this);
+#endif
+        return true;
+    }
+
+    void stop() {
+        stop_requested_ = true;
+#ifdef ESP_PLATFORM
+        if (frame_ready_) xSemaphoreGive(frame_ready_);
+        for (int i = 0; i < 50 && stats_.running.load(); i++) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        if (sender_task_ && stats_.running.load()) {
+            vTaskDelete(sender_task_);
+            stats_.running = false;
+        }
+        sender_task_ = nullptr;
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+        if (sender_thread_.joinable()) sender_thread_.join();
+        stats_.running = false;
+#endif
+    }
+
+    // IFrameSink: copy into the pending slot, replacing an unsent frame
+    void on_frame(const uint8_t* data, size_t size,
+                  int64_t timestamp_us, uint32_t sequence) override {
+        (void)sequence;
+        if (!initialized_ || !stats_.running.load()) return;
+        stats_.frames_offered++;
+        if (!data || size == 0 || size > config_.max_frame_size) {
+            stats_.frames_rejected++;
+            return;
+        }
+
+        lock();
+        if (has_pending_) stats_.frames_superseded++;
+        memcpy(pending_, data, size);
+        pending_size_ = size;
+        pending_ts_ = timestamp_us;
+        has_pending_ = true;
+        unlock();
+
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(frame_ready_);
+#else
+        cv_.notify_one();
+#endif
+    }
+
+    /**
+     * @brief Packetize, pace and send one frame (sender task; exposed for tests)
+     * @return false if the frame cannot be carried as RTP/JPEG
+     */
+    bool send_frame(const uint8_t* data, size_t size, int64_t timestamp_us) {
+        if (!packetizer_.begin(data, size, timestamp_us)) {
+            stats_.frames_rejected++;
+            return false;
+        }
+        RtpPacketKind kind;
+        while (size_t len = packetizer_.next(datagram_, sizeof(datagram_), &kind)) {
+            int64_t wait_us = pacer_.reserve(len, clock_.now_us());
+            if (wait_us >= 1000) clock_.delay_ms(static_cast<uint32_t>(wait_us / 1000));
+
+            bool parity = kind == RtpPacketKind::Parity;
+            if (!sender_.send(datagram_, len, parity ? parity_port() : config_.port)) {
+                stats_.send_errors++;
+                continue;
+            }
+            stats_.bytes_sent += len;
+            if (parity) stats_.parity_sent++;
+            else stats_.packets_sent++;
+        }
+        stats_.frames_sent++;
+        return true;
+    }
+
+    const MulticastStats& stats() const { return stats_; }
+    const MulticastConfig& config() const { return config_; }
+    uint16_t parity_port() const { return static_cast<uint16_t>(config_.port + 2); }
+    bool is_running() const { return stats_.running.load(); }
+    bool is_initialized() const { return initialized_; }
+
+private:
+#ifdef ESP_PLATFORM
+    static void sender_task_wrapper(void* arg) {
+        static_cast<MulticastStreamer*>(arg)->sender_loop();
+        vTaskDelete(nullptr);
+    }
+#endif
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    // Take the pending frame (swapping buffers), waiting up to 100 ms
+    bool take_pending(size_t* size, int64_t* timestamp_us) {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(frame_ready_, pdMS_TO_TICKS(100));
+        lock();
+#else
+        std::unique_lock<std::mutex> guard(mutex_);
+        cv_.wait_for(guard, std::chrono::milliseconds(100),
+                     [this] { return has_pending_ || stop_requested_.load(); });
+        guard.release();
+#endif
+        bool taken = has_pending_;
+        if (taken) {
+            uint8_t* tmp = sending_;
+            sending_ = pending_;
+            pending_ = tmp;
+            *size = pending_size_;
+            *timestamp_us = pending_ts_;
+            has_pending_ = false;
+        }
+        unlock();
+        return taken;
+    }
+
+    void sender_loop() {
+        while (!stop_requested_.load()) {
+            size_t size = 0;
+            int64_t timestamp_us = 0;
+            if (take_pending(&size, &timestamp_us)) {
+                send_frame(sending_, size, timestamp_us);
+            }
+        }
+        stats_.running = false;
+    }
+
+    interfaces::IDatagramSender& sender_;
+    interfaces::IClock& clock_;
+
+    MulticastConfig config_;
+    MulticastStats stats_;
+    RtpJpegPacketizer packetizer_;
+    RtpPacer pacer_;
+    uint8_t datagram_[RTP_MAX_DATAGRAM] = {};
+
+    uint8_t* frames_[2] = {nullptr, nullptr};
+    uint8_t* pending_ = nullptr;   // Written by the producer under the lock
+    uint8_t* sending_ = nullptr;   // Owned by the sender task
+    size_t pending_size_ = 0;
+    int64_t pending_ts_ = 0;
+    bool has_pending_ = false;
+
+    std::atomic<bool> stop_requested_{false};
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t sender_task_ = nullptr;
+    SemaphoreHandle_t mutex_ = nullptr;
+    SemaphoreHandle_t frame_ready_ = nullptr;
+#else
+    std::thread sender_thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
+
+} // namespace core
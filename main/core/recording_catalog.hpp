@@ -0,0 +1,892 @@
+/**
+ * @file recording_catalog.hpp
+ * @brief Clip index over recorded frames: time-range queries, motion
+ *        summary and thumbnails, persisted next to the recording
+ *
+ * Design: Recorded frames are grouped into clips. A clip ends when the next
+ * frame comes more than clip_gap after the last one or the clip reaches
+ * max_clip_duration. Clips never overlap and are kept in time order in an
+ * in-RAM ring, so a time-range query is a binary search for the first clip
+ * ending at or after `from`, then a walk while clips start before `to`.
+ *
+ * The luma DC coefficients of every recorded frame (one value per 8x8
+ * block, no IDCT) form a 1/8-scale grayscale image. It gives:
+ *   - motion: percentage of blocks whose mean luma moved by more than
+ *     motion_threshold since the previous frame (per-clip max and mean)
+ *   - thumbnails: that image JPEG-encoded, at the first frame of a clip
+ *     and every thumbnail_interval after
+ *
+ * Persistence: thumbnails and closed-clip summaries are appended to a
+ * second, small SegmentStore (the index store). init() reloads the
+ * summaries and rebuilds the clip that was open at power loss from the
+ * frame store's record headers (its motion summary is lost). Clips leave
+ * the index when the frame store reclaims their frames; a clip that lost
+ * only its first frames is trimmed.
+ *
+ * Index store record payloads (little-endian):
+ *   Clip summary (CATALOG_CLIP_RECORD_SIZE bytes):
+ *     0 'C'  1 motion max  2 thumbnails (u16)  4 id  8 first sequence
+ *     12 last sequence  16 frames  20 motion sum  24 start (i64 us)  32 end
+ *   Thumbnail: 0 'T'  1..3 zero  4 clip id, then a grayscale JPEG
+ *
+ * Thread-safe: the recorder task adds frames; queries and thumbnail reads
+ * may come from any task.
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::mutex on host.
+ */
+#pragma once
+#include "segment_store.hpp"
+#include "jpeg_codec.hpp"
+#include "jpeg_encoder.hpp"
+#include "archive_writer.hpp"
+#include "jpeg_metadata.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#else
+#include <mutex>
+#endif
+
+namespace core {
+
+static constexpr uint8_t CATALOG_CLIP_RECORD = 'C';
+static constexpr uint8_t CATALOG_THUMBNAIL_RECORD = 'T';
+static constexpr size_t CATALOG_CLIP_RECORD_SIZE = 40;
+static constexpr size_t CATALOG_THUMBNAIL_HEADER_SIZE = 8;
+
+struct RecordingCatalogConfig {
+    size_t max_clips = 1024;                 // Index entries (oldest dropped beyond this)
+    uint32_t clip_gap_ms = 5000;             // A longer pause between frames starts a new clip
+    uint32_t max_clip_duration_ms = 60000;   // Longer clips are split
+    uint32_t thumbnail_interval_ms = 10000;  // Within a clip (0 = first frame only)
+    uint8_t motion_threshold = 12;           // Mean-luma change that counts a block as moved
+    size_t max_grid_blocks = 200 * 150;      // 8x8 blocks per frame (1600x1200)
+    size_t max_thumbnail_size = 8 * 1024;
+    int thumbnail_quality = 75;
+};
+
+/**
+ * @brief One clip: a run of recorded frames without long pauses
+ */
+struct ClipSummary {
+    uint32_t id = 0;                 // Increases with time, never reused
+    int64_t start_us = 0;            // First frame (store timestamps)
+    int64_t end_us = 0;              // Last frame
+    uint32_t first_sequence = 0;     // Frame store sequences (consecutive)
+    uint32_t last_sequence = 0;
+    uint32_t frames = 0;
+    uint32_t motion_sum = 0;         // Sum of per-frame motion percentages
+    uint8_t motion_max = 0;          // Percentage of blocks changed, busiest frame
+    uint16_t thumbnails = 0;
+    bool open = false;               // Still being recorded
+
+    uint8_t motion_mean() const {
+        return frames ? static_cast<uint8_t>(motion_sum / frames) : 0;
+    }
+};
+
+struct RecordingCatalogStats {
+    std::atomic<uint32_t> frames_indexed{0};
+    std::atomic<uint32_t> clips_closed{0};
+    std::atomic<uint32_t> clips_expired{0};       // Frames reclaimed, or index full
+    std::atomic<uint32_t> clips_recovered{0};     // Rebuilt from frame headers at init
+    std::atomic<uint32_t> thumbnails_written{0};
+    std::atomic<uint32_t> decode_errors{0};       // Frames without motion/thumbnail
+    std::atomic<uint32_t> write_errors{0};        // Index store appends that failed
+    std::atomic<uint32_t> queries{0};
+
+    void reset() {
+        frames_indexed = 0;
+        clips_closed = 0;
+        clips_expired = 0;
+        clips_recovered = 0;
+        thumbnails_written = 0;
+        decode_errors = 0;
+        write_errors = 0;
+        queries = 0;
+    }
+};
+
+/**
+ * @brief Split "/recordings/<id>.<name>" or "/recordings/<id>/<name>[?query]"
+ * @param name Receives the NUL-terminated name, e.g. "mjpeg" or "thumb"
+ * @return false if the path is not of that form
+ */
+inline bool parse_recording_path(const char* uri, uint32_t* id, char* name, size_t name_cap) {
+    static constexpr char PREFIX[] = "/recordings/";
+    if (!uri || !id || !name || name_cap == 0) return false;
+    if (strncmp(uri, PREFIX, sizeof(PREFIX) - 1) != 0) return false;
+
+    const char* p = uri + sizeof(PREFIX) - 1;
+    size_t digits = strspn(p, "0123456789");
+    if (digits == 0 || digits > 10 || (p[digits] != '.' && p[digits] != '/')) return false;
+    unsigned long long value = strtoull(p, nullptr, 10);
+    if (value == 0 || value > UINT32_MAX) return false;
+
+    const char* n = p + digits + 1;
+    size_t len = strcspn(n, "?/.");
+    if (len == 0 || (n[len] != '\0' && n[len] != '?') || len >= name_cap) return false;
+
+    *id = static_cast<uint32_t>(value);
+    memcpy(name, n, len);
+    name[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief Parse ?from= / ?to= Unix seconds into microseconds
+ * @return false unless all digits and small enough for int64 microseconds
+ */
+inline bool parse_unix_seconds(const char* text, int64_t* out_us) {
+    static constexpr uint64_t MAX_SECONDS = INT64_MAX / 1000000;
+    if (!text || !out_us) return false;
+    size_t digits = strspn(text, "0123456789");
+    if (digits == 0 || text[digits] != '\0' || digits > 19) return false;
+    unsigned long long value = strtoull(text, nullptr, 10);
+    if (value > MAX_SECONDS) return false;
+    *out_us = static_cast<int64_t>(value) * 1000000;
+    return true;
+}
+
+enum class ByteRange : uint8_t {
+    Full,            // No (usable) Range header: send everything
+    Partial,         // Send [first, last]
+    Unsatisfiable,   // Starts past the end: 416
+};
+
+/**
+ * @brief Interpret a Range header for a resource of `size` bytes
+ *
+ * Single ranges only ("bytes=a-b", "bytes=a-", "bytes=-n"). Malformed or
+ * multi-range headers are ignored (answered with the full resource), as
+ * RFC 7233 allows.
+ */
+inline ByteRange parse_byte_range(const char* header, uint64_t size,
+                                  uint64_t* first, uint64_t* last) {
+    static constexpr char UNIT[] = "bytes=";
+    if (!header || !first || !last) return ByteRange::Full;
+    if (strncmp(header, UNIT, sizeof(UNIT) - 1) != 0) return ByteRange::Full;
+    const char* p = header + sizeof(UNIT) - 1;
+    if (strchr(p, ',')) return ByteRange::Full;
+
+    char* end = nullptr;
+    if (*p == '-') {
+        // Suffix: the last n bytes
+        if (p[1] < '0' || p[1] > '9') return ByteRange::Full;
+        unsigned long long n = strtoull(p + 1, &end, 10);
+        if (*end != '\0') return ByteRange::Full;
+        if (n == 0 || size == 0) return ByteRange::Unsatisfiable;
+        *first = n >= size ? 0 : size - n;
+        *last = size - 1;
+        return ByteRange::Partial;
+    }
+    if (*p < '0' || *p > '9') return ByteRange::Full;
+    unsigned long long a = strtoull(p, &end, 10);
+    if (*end != '-') return ByteRange::Full;
+    const char* q = end + 1;
+    unsigned long long b = UINT64_MAX;
+    if (*q != '\0') {
+        if (*q < '0' || *q > '9') return ByteRange::Full;
+        b = strtoull(q, &end, 10);
+        if (*end != '\0' || b < a) return ByteRange::Full;
+    }
+    if (a >= size) return ByteRange::Unsatisfiable;
+    *first = a;
+    *last = b >= size ? size - 1 : b;
+    return ByteRange::Partial;
+}
+
+/**
+ * @brief JSON object describing a clip (times in store milliseconds)
+ * @return Length written (excluding NUL), 0 if it does not fit
+ */
+inline size_t format_clip_json(const ClipSummary& clip, char* out, size_t capacity) {
+    if (!out || capacity == 0) return 0;
+    int len = snprintf(out, capacity,
+        "{\"id\":%lu,\"start_ms\":%lld,\"end_ms\":%lld,\"frames\":%lu,"
+        "\"motion_max\":%u,\"motion_mean\":%u,\"thumbnails\":%u,\"open\":%s}",
+        static_cast<unsigned long>(clip.id),
+        static_cast<long long>(clip.start_us / 1000), static_cast<long long>(clip.end_us / 1000),
+        static_cast<unsigned long>(clip.frames), clip.motion_max, clip.motion_mean(),
+        clip.thumbnails, clip.open ? "true" : "false");
+    if (len < 0 || static_cast<size_t>(len) >= capacity) return 0;
+    return static_cast<size_t>(len);
+}
+
+/**
+ * @brief Indexes frames as the recorder stores them
+ *
+ * Usage:
+ *   RecordingCatalog catalog(frame_store, index_store);   // Both mounted
+ *   catalog.init(config);                                 // Reloads the index
+ *   recorder.set_catalog(&catalog);                       // on_record() per frame
+ *   catalog.query(from_us, to_us, clips, max, &more);
+ */
+class RecordingCatalog {
+public:
+    RecordingCatalog(SegmentStore& frames, SegmentStore& index) : frames_(frames), index_(index) {}
+    ~RecordingCatalog() { deinit(); }
+
+    // Non-copyable
+    RecordingCatalog(const RecordingCatalog&) = delete;
+    RecordingCatalog& operator=(const RecordingCatalog&) = delete;
+
+    /**
+     * @brief Allocate the index and reload it from the stores
+     * @param use_psram Use PSRAM for the index and luma grids (ESP32 only)
+     * @return false if a store is not mounted or allocation fails
+     */
+    bool init(const RecordingCatalogConfig& config, bool use_psram = true) {
+        if (initialized_) return true;
+        if (!frames_.is_mounted() || !index_.is_mounted()) return false;
+        if (config.max_clips == 0 || config.max_grid_blocks == 0) return false;
+        if (config.max_thumbnail_size + CATALOG_THUMBNAIL_HEADER_SIZE > index_.max_record_size()) return false;
+        config_ = config;
+
+        clips_ = new (std::nothrow) ClipSummary[config_.max_clips];
+        if (!clips_) return false;
+        for (auto*& buf : grids_) buf = allocate(config_.max_grid_blocks, use_psram);
+        thumbnail_ = allocate(CATALOG_THUMBNAIL_HEADER_SIZE + config_.max_thumbnail_size, use_psram);
+        if (!grids_[0] || !grids_[1] || !thumbnail_) {
+            deinit();
+            return false;
+        }
+        encoder_.set_quality(config_.thumbnail_quality);
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        if (!mutex_) {
+            deinit();
+            return false;
+        }
+#endif
+        stats_.reset();
+        initialized_ = true;
+        load();
+        return true;
+    }
+
+    void deinit() {
+        delete[] clips_;
+        clips_ = nullptr;
+        for (auto*& buf : grids_) {
+            release(buf);
+            buf = nullptr;
+        }
+        release(thumbnail_);
+        thumbnail_ = nullptr;
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+#endif
+        first_ = 0;
+        count_ = 0;
+        next_id_ = 1;
+        has_grid_ = false;
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Index a frame the recorder just appended to the frame store
+     *        (recorder task only)
+     * @param sequence Sequence frame_store.append() returned
+     */
+    void on_record(uint32_t sequence, int64_t timestamp_us, const uint8_t* data, size_t size) {
+        if (!initialized_) return;
+        lock();
+        bool new_clip = starts_clip(timestamp_us);
+        uint32_t clip_id = new_clip ? next_id_ : clip_at(count_ - 1).id;
+        bool thumbnail_due = new_clip ||
+            (config_.thumbnail_interval_ms > 0 &&
+             timestamp_us - last_thumbnail_us_ >= static_cast<int64_t>(config_.thumbnail_interval_ms) * 1000);
+        unlock();
+        if (new_clip) close_clip();
+
+        // Luma grid: motion against the previous frame, thumbnail if due
+        int motion = -1;
+        uint16_t gw = 0, gh = 0;
+        uint8_t* grid = grids_[current_grid_];
+        if (data && decode_grid(data, size, grid, &gw, &gh)) {
+            motion = new_clip ? 0 : compare_grids(grid, gw, gh);
+            has_grid_ = true;
+            grid_w_ = gw;
+            grid_h_ = gh;
+            current_grid_ ^= 1;
+        } else {
+            stats_.decode_errors++;
+            has_grid_ = false;
+        }
+        bool thumbnail_written = false;
+        if (thumbnail_due && motion >= 0) {
+            thumbnail_written = write_thumbnail(clip_id, grid, gw, gh, timestamp_us);
+        }
+
+        lock();
+        track(sequence, timestamp_us, motion);
+        if (thumbnail_written) {
+            clip_at(count_ - 1).thumbnails++;
+            last_thumbnail_us_ = timestamp_us;
+        }
+        expire_reclaimed();
+        unlock();
+        stats_.frames_indexed++;
+    }
+
+    /**
+     * @brief Persist and close the open clip (recorder task only)
+     */
+    void close_clip() {
+        if (!initialized_) return;
+        lock();
+        bool open = count_ > 0 && clip_at(count_ - 1).open;
+        ClipSummary clip;
+        if (open) {
+            clip_at(count_ - 1).open = false;
+            clip = clip_at(count_ - 1);
+        }
+        unlock();
+        if (!open) return;
+
+        uint8_t record[CATALOG_CLIP_RECORD_SIZE];
+        encode_clip(clip, record);
+        if (index_.append(record, sizeof(record), clip.end_us)) {
+            stats_.clips_closed++;
+        } else {
+            stats_.write_errors++;
+        }
+    }
+
+    /**
+     * @brief Erase ahead in the index store (call when idle)
+     */
+    bool service() { return initialized_ && index_.service(); }
+
+    /**
+     * @brief Clips overlapping [from_us, to_us], oldest first
+     * @param more Set if further clips match (continue from the last end + 1)
+     * @return Clips copied to out
+     */
+    size_t query(int64_t from_us, int64_t to_us, ClipSummary* out, size_t max_out,
+                 bool* more = nullptr) {
+        if (more) *more = false;
+        if (!initialized_ || !out || from_us > to_us) return 0;
+        stats_.queries++;
+        lock();
+        expire_reclaimed();
+        // Clips are disjoint and ordered, so end times increase too
+        size_t lo = 0, hi = count_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (clip_at(mid).end_us < from_us) lo = mid + 1;
+            else hi = mid;
+        }
+        size_t n = 0;
+        for (size_t i = lo; i < count_ && clip_at(i).start_us <= to_us; i++) {
+            if (n == max_out) {
+                if (more) *more = true;
+                break;
+            }
+            out[n++] = clip_at(i);
+        }
+        unlock();
+        return n;
+    }
+
+    bool find(uint32_t id, ClipSummary* out) {
+        if (!initialized_ || !out) return false;
+        lock();
+        size_t lo = 0, hi = count_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (clip_at(mid).id < id) lo = mid + 1;
+            else hi = mid;
+        }
+        bool found = lo < count_ && clip_at(lo).id == id;
+        if (found) *out = clip_at(lo);
+        unlock();
+        return found;
+    }
+
+    /**
+     * @brief Copy out a clip's index-th thumbnail (grayscale JPEG)
+     * @param capacity At least max_thumbnail_size + CATALOG_THUMBNAIL_HEADER_SIZE
+     * @return JPEG size, 0 if there is no such thumbnail
+     */
+    size_t thumbnail(const ClipSummary& clip, uint16_t index, uint8_t* out, size_t capacity) {
+        if (!initialized_ || !out) return 0;
+        RecordInfo rec;
+        if (!index_.find_time(clip.start_us, &rec)) return 0;
+        uint16_t seen = 0;
+        do {
+            if (rec.timestamp_us > clip.end_us) break;
+            size_t n = index_.read(rec, out, capacity);
+            if (n > CATALOG_THUMBNAIL_HEADER_SIZE && out[0] == CATALOG_THUMBNAIL_RECORD &&
+                get32(out + 4) == clip.id && seen++ == index) {
+                n -= CATALOG_THUMBNAIL_HEADER_SIZE;
+                memmove(out, out + CATALOG_THUMBNAIL_HEADER_SIZE, n);
+                return n;
+            }
+        } while (index_.next_after(rec, &rec));
+        return 0;
+    }
+
+    size_t clip_count() {
+        lock();
+        size_t n = count_;
+        unlock();
+        return n;
+    }
+
+    SegmentStore& frames() { return frames_; }
+    const RecordingCatalogStats& stats() const { return stats_; }
+    const RecordingCatalogConfig& config() const { return config_; }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    static uint8_t* allocate(size_t size, bool use_psram) {
+#ifdef ESP_PLATFORM
+        return static_cast<uint8_t*>(use_psram ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM) : malloc(size));
+#else
+        (void)use_psram;
+        return static_cast<uint8_t*>(malloc(size));
+#endif
+    }
+
+    static void release(uint8_t* buf) {
+        if (!buf) return;
+#ifdef ESP_PLATFORM
+        heap_caps_free(buf);
+#else
+        free(buf);
+#endif
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+    static void put64(uint8_t* p, uint64_t v) {
+        for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+    static uint32_t get32(const uint8_t* p) {
+        uint32_t v = 0;
+        for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+        return v;
+    }
+    static uint64_t get64(const uint8_t* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+        return v;
+    }
+
+    static void encode_clip(const ClipSummary& clip, uint8_t* r) {
+        r[0] = CATALOG_CLIP_RECORD;
+        r[1] = clip.motion_max;
+        r[2] = static_cast<uint8_t>(clip.thumbnails);
+        r[3] = static_cast<uint8_t>(clip.thumbnails >> 8);
+        put32(r + 4, clip.id);
+        put32(r + 8, clip.first_sequence);
+        put32(r + 12, clip.last_sequence);
+        put32(r + 16, clip.frames);
+        put32(r + 20, clip.motion_sum);
+        put64(r + 24, static_cast<uint64_t>(clip.start_us));
+        put64(r + 32, static_cast<uint64_t>(clip.end_us));
+    }
+
+    static ClipSummary decode_clip(const uint8_t* r) {
+        ClipSummary clip;
+        clip.motion_max = r[1];
+        clip.thumbnails = static_cast<uint16_t>(r[2] | (r[3] << 8));
+        clip.id = get32(r + 4);
+        clip.first_sequence = get32(r + 8);
+        clip.last_sequence = get32(r + 12);
+        clip.frames = get32(r + 16);
+        clip.motion_sum = get32(r + 20);
+        clip.start_us = static_cast<int64_t>(get64(r + 24));
+        clip.end_us = static_cast<int64_t>(get64(r + 32));
+        return clip;
+    }
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    // --- Clip ring (under lock) --------------------------------------------
+
+    ClipSummary& clip_at(size_t i) { return clips_[(first_ + i) % config_.max_clips]; }
+
+    bool starts_clip(int64_t timestamp_us) {
+        if (count_ == 0 || !clip_at(count_ - 1).open) return true;
+        const ClipSummary& clip = clip_at(count_ - 1);
+        return timestamp_us - clip.end_us > static_cast<int64_t>(config_.clip_gap_ms) * 1000 ||
+               timestamp_us - clip.start_us >= static_cast<int64_t>(config_.max_clip_duration_ms) * 1000;
+    }
+
+    void push(const ClipSummary& clip) {
+        if (count_ == config_.max_clips) {
+            first_ = (first_ + 1) % config_.max_clips;
+            count_--;
+            stats_.clips_expired++;
+        }
+        clip_at(count_++) = clip;
+        if (clip.id >= next_id_) next_id_ = clip.id + 1;
+    }
+
+    // Extend the open clip, or open a new one (motion < 0: unknown)
+    void track(uint32_t sequence, int64_t timestamp_us, int motion) {
+        if (starts_clip(timestamp_us)) {
+            if (count_ > 0) clip_at(count_ - 1).open = false;
+            ClipSummary clip;
+            clip.id = next_id_;
+            clip.start_us = timestamp_us;
+            clip.first_sequence = sequence;
+            clip.open = true;
+            push(clip);
+        }
+        ClipSummary& clip = clip_at(count_ - 1);
+        clip.end_us = timestamp_us;
+        clip.last_sequence = sequence;
+        clip.frames++;
+        if (motion > 0) {
+            clip.motion_sum += static_cast<uint32_t>(motion);
+            if (motion > clip.motion_max) clip.motion_max = static_cast<uint8_t>(motion);
+        }
+    }
+
+    // Drop clips whose frames were reclaimed; trim one that lost its start
+    void expire_reclaimed() {
+        if (count_ == 0) return;
+        RecordInfo oldest;
+        bool any = frames_.oldest(&oldest);
+        while (count_ > 0 && (!any || clip_at(0).last_sequence < oldest.sequence)) {
+            first_ = (first_ + 1) % config_.max_clips;
+            count_--;
+            stats_.clips_expired++;
+        }
+        if (count_ > 0 && clip_at(0).first_sequence < oldest.sequence) {
+            ClipSummary& clip = clip_at(0);
+            clip.frames = clip.last_sequence - oldest.sequence + 1;
+            clip.first_sequence = oldest.sequence;
+            clip.start_us = oldest.timestamp_us;
+        }
+    }
+
+    // --- Recovery ----------------------------------------------------------
+
+    void load() {
+        // Closed clips, oldest first; thumbnails past the last summary
+        // belong to the clip that was open
+        uint32_t orphan_id = 0;
+        uint16_t orphan_thumbnails = 0;
+        RecordInfo rec;
+        for (bool ok = index_.oldest(&rec); ok; ok = index_.next_after(rec, &rec)) {
+            size_t n = index_.read(rec, thumbnail_, CATALOG_THUMBNAIL_HEADER_SIZE + config_.max_thumbnail_size);
+            if (n == CATALOG_CLIP_RECORD_SIZE && thumbnail_[0] == CATALOG_CLIP_RECORD) {
+                ClipSummary clip = decode_clip(thumbnail_);
+                if (clip.id < next_id_ || clip.frames == 0) continue;
+                push(clip);
+                last_thumbnail_us_ = clip.end_us;
+            } else if (n > CATALOG_THUMBNAIL_HEADER_SIZE && thumbnail_[0] == CATALOG_THUMBNAIL_RECORD) {
+                uint32_t id = get32(thumbnail_ + 4);
+                if (id != orphan_id) orphan_thumbnails = 0;
+                orphan_id = id;
+                orphan_thumbnails++;
+                last_thumbnail_us_ = rec.timestamp_us;
+            }
+        }
+
+        // Frames recorded after the last summary: walk their headers
+        RecordInfo frame;
+        bool found = count_ > 0 ? frames_.find_time(clip_at(count_ - 1).end_us + 1, &frame)
+                                : frames_.oldest(&frame);
+        uint32_t after = count_ > 0 ? clip_at(count_ - 1).last_sequence : 0;
+        uint32_t recovered_from = next_id_;
+        for (; found; found = frames_.next_after(frame, &frame)) {
+            if (frame.sequence <= after) continue;
+            track(frame.sequence, frame.timestamp_us, -1);
+        }
+        for (size_t i = 0; i < count_; i++) {
+            ClipSummary& clip = clip_at(i);
+            if (clip.id < recovered_from) continue;
+            if (clip.id == orphan_id) clip.thumbnails = orphan_thumbnails;
+            stats_.clips_recovered++;
+        }
+        // All but the newest recovered clip are complete: persist them
+        for (size_t i = 0; i < count_; i++) {
+            ClipSummary& clip = clip_at(i);
+            if (clip.id < recovered_from || clip.open) continue;
+            uint8_t record[CATALOG_CLIP_RECORD_SIZE];
+            encode_clip(clip, record);
+            if (!index_.append(record, sizeof(record), clip.end_us)) stats_.write_errors++;
+        }
+        expire_reclaimed();
+    }
+
+    // --- Luma grid ---------------------------------------------------------
+
+    // Mean luma of every 8x8 block of the first component, from DC
+    // coefficients only (a 1/8-scale grayscale image, row-major)
+    bool decode_grid(const uint8_t* jpeg, size_t size, uint8_t* grid, uint16_t* gw, uint16_t* gh) {
+        if (!jpeg_parse(jpeg, size, &info_)) return false;
+        const JpegComponent& luma = info_.components[0];
+        uint8_t h = info_.num_components == 1 ? 1 : luma.h;
+        uint8_t v = info_.num_components == 1 ? 1 : luma.v;
+        if (info_.num_components > 1 && (h != info_.max_h || v != info_.max_v)) return false;
+        if (luma.tq > 3 || !info_.quant_present[luma.tq]) return false;
+        uint16_t w = static_cast<uint16_t>((info_.width + 7) / 8);
+        uint16_t ht = static_cast<uint16_t>((info_.height + 7) / 8);
+        if (static_cast<size_t>(w) * ht > config_.max_grid_blocks) return false;
+        if (!decoder_.begin(jpeg, size, info_)) return false;
+
+        int32_t q = info_.quant[luma.tq][0];
+        int16_t blocks[JPEG_MAX_BLOCKS_PER_MCU][64];
+        for (uint16_t my = 0; my < info_.mcus_y; my++) {
+            for (uint16_t mx = 0; mx < info_.mcus_x; mx++) {
+                if (!decoder_.decode_mcu(blocks)) return false;
+                for (uint8_t i = 0; i < h * v; i++) {
+                    uint32_t bx = static_cast<uint32_t>(mx) * h + i % h;
+                    uint32_t by = static_cast<uint32_t>(my) * v + i / h;
+                    if (bx >= w || by >= ht) continue;
+                    // DC = 8 x (mean - 128) before quantization
+                    int32_t mean = 128 + blocks[i][0] * q / 8;
+                    grid[by * w + bx] = static_cast<uint8_t>(mean < 0 ? 0 : mean > 255 ? 255 : mean);
+                }
+            }
+        }
+        *gw = w;
+        *gh = ht;
+        return true;
+    }
+
+    // Percentage of blocks that changed since the previous grid
+    int compare_grids(const uint8_t* grid, uint16_t gw, uint16_t gh) const {
+        if (!has_grid_ || gw != grid_w_ || gh != grid_h_) return 0;
+        const uint8_t* prev = grids_[current_grid_ ^ 1];
+        size_t total = static_cast<size_t>(gw) * gh;
+        size_t changed = 0;
+        for (size_t i = 0; i < total; i++) {
+            int d = grid[i] - prev[i];
+            if (d > config_.motion_threshold || -d > config_.motion_threshold) changed++;
+        }
+        return static_cast<int>(changed * 100 / total);
+    }
+
+    bool write_thumbnail(uint32_t clip_id, const uint8_t* grid, uint16_t gw, uint16_t gh,
+                         int64_t timestamp_us) {
+        memset(thumbnail_, 0, CATALOG_THUMBNAIL_HEADER_SIZE);
+        thumbnail_[0] = CATALOG_THUMBNAIL_RECORD;
+        put32(thumbnail_ + 4, clip_id);
+        size_t n = encoder_.encode(grid, static_cast<size_t>(gw) * gh, gw, gh, PixelFormat::Grayscale,
+                                   thumbnail_ + CATALOG_THUMBNAIL_HEADER_SIZE, config_.max_thumbnail_size);
+        if (n == 0) return false;
+        if (!index_.append(thumbnail_, CATALOG_THUMBNAIL_HEADER_SIZE + n, timestamp_us)) {
+            stats_.write_errors++;
+            return false;
+        }
+        stats_.thumbnails_written++;
+        return true;
+    }
+
+    SegmentStore& frames_;
+    SegmentStore& index_;
+    RecordingCatalogConfig config_;
+    RecordingCatalogStats stats_;
+
+    ClipSummary* clips_ = nullptr;   // Ring, oldest at first_
+    size_t first_ = 0;
+    size_t count_ = 0;
+    uint32_t next_id_ = 1;
+    int64_t last_thumbnail_us_ = 0;
+
+    // Recorder task only
+    JpegInfo info_;
+    JpegScanDecoder decoder_;
+    JpegEncoder encoder_;
+    uint8_t* grids_[2] = {nullptr, nullptr};   // Current / previous frame
+    uint8_t current_grid_ = 0;
+    bool has_grid_ = false;
+    uint16_t grid_w_ = 0;
+    uint16_t grid_h_ = 0;
+    uint8_t* thumbnail_ = nullptr;   // Record header + JPEG
+
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t mutex_ = nullptr;
+#else
+    std::mutex mutex_;
+#endif
+};
+
+/**
+ * @brief Reads a clip's frames as one byte stream of concatenated JPEGs
+ *        (an MJPEG file), with random access for HTTP Range requests
+ *
+ * open() walks the clip's record headers once to size the stream; reading
+ * copies one whole frame at a time (the store verifies it) and hands out
+ * the requested part of it.
+ *
+ * With embed_metadata, every frame carries the APP9 metadata segment
+ * (FrameSource::Recording, store sequence and timestamp). Sizes and offsets
+ * include it, so ranges stay consistent. The frame is read in after a gap
+ * of JPEG_METADATA_SEGMENT_SIZE bytes and only its SOI/APPn head moves
+ * down to make room. A stored frame that is not a JPEG ends the stream,
+ * like a reclaimed one.
+ */
+class ClipReader {
+public:
+    explicit ClipReader(SegmentStore& frames, bool embed_metadata = false)
+        : frames_(frames), pad_(embed_metadata ? JPEG_METADATA_SEGMENT_SIZE : 0) {}
+
+    /**
+     * @return false if none of the clip's frames are left
+     */
+    bool open(const ClipSummary& clip) {
+        clip_ = clip;
+        size_ = 0;
+        frames_in_clip_ = 0;
+        RecordInfo rec;
+        if (!frames_.find_time(clip.start_us, &rec)) return false;
+        first_ = rec;
+        for (bool ok = true; ok && rec.sequence <= clip.last_sequence; ok = frames_.next_after(rec, &rec)) {
+            if (rec.sequence < clip.first_sequence) continue;
+            size_ += rec.size + pad_;
+            frames_in_clip_++;
+        }
+        current_ = first_;
+        position_ = 0;
+        valid_ = frames_in_clip_ > 0;
+        return valid_;
+    }
+
+    /**
+     * @brief Position at a byte offset of the stream (header walk)
+     */
+    bool seek(uint64_t offset) {
+        if (!valid_ || offset >= size_) return false;
+        current_ = first_;
+        position_ = 0;
+        while (position_ + current_.size + pad_ <= offset) {
+            position_ += current_.size + pad_;
+            if (!frames_.next_after(current_, &current_) || current_.sequence > clip_.last_sequence) {
+                valid_ = false;
+                return false;
+            }
+        }
+        skip_ = static_cast<size_t>(offset - position_);
+        return true;
+    }
+
+    /**
+     * @brief Read the frame at the current position into buf and advance
+     * @param capacity At least buffer_size()
+     * @param data Set to the first requested byte inside buf
+     * @return Bytes available at *data, 0 at the end or if the frame is gone
+     */
+    size_t read(uint8_t* buf, size_t capacity, const uint8_t** data) {
+        if (!valid_ || !data || position_ >= size_ || capacity < pad_) return 0;
+        size_t n = frames_.read(current_, buf + pad_, capacity - pad_);
+        if (n != current_.size || (pad_ > 0 && !embed_metadata(buf, n))) {
+            valid_ = false;
+            return 0;
+        }
+        n += pad_;
+        *data = buf + skip_;
+        size_t available = n - skip_;
+        position_ += n;
+        skip_ = 0;
+        if (position_ < size_ &&
+            (!frames_.next_after(current_, &current_) || current_.sequence > clip_.last_sequence)) {
+            valid_ = false;   // Reclaimed from under the reader
+        }
+        return available;
+    }
+
+    /**
+     * @brief Read the next whole frame (at a frame boundary, e.g. after open())
+     * @param timestamp_us Output: the frame's store timestamp (optional)
+     * @return Frame bytes at the start of buf, 0 at the end or if the frame is gone
+     */
+    size_t read_frame(uint8_t* buf, size_t capacity, int64_t* timestamp_us = nullptr) {
+        if (skip_ != 0) return 0;
+        int64_t ts = current_.timestamp_us;
+        const uint8_t* data = nullptr;
+        size_t n = read(buf, capacity, &data);
+        if (n > 0 && timestamp_us) *timestamp_us = ts;
+        return n;
+    }
+
+    uint64_t size() const { return size_; }
+    uint32_t frames() const { return frames_in_clip_; }
+
+    // Read buffer needed for any frame of the store
+    size_t buffer_size() const { return frames_.max_record_size() + pad_; }
+
+private:
+    // Frame of `size` bytes at buf + pad_: move its head down and write
+    // the segment behind it
+    bool embed_metadata(uint8_t* buf, size_t size) {
+        JpegSplice splice;
+        if (!jpeg_splice_segment(buf + pad_, size, nullptr, 0, &splice)) return false;
+        memmove(buf, buf + pad_, splice.size[0]);
+        FrameMetadata meta{current_.sequence, current_.timestamp_us, FrameSource::Recording};
+        return jpeg_build_metadata_segment(meta, buf + splice.size[0], pad_) == pad_;
+    }
+
+    SegmentStore& frames_;
+    size_t pad_;                 // Metadata segment bytes per frame (0 = off)
+    ClipSummary clip_;
+    RecordInfo first_;
+    RecordInfo current_;
+    uint64_t size_ = 0;
+    uint64_t position_ = 0;      // Stream offset of current_
+    size_t skip_ = 0;            // Bytes of current_ before the seek offset
+    uint32_t frames_in_clip_ = 0;
+    bool valid_ = false;
+};
+
+/**
+ * @brief Write a clip's frames to an archive as <prefix>000001.jpg, ...
+ *
+ * Each frame is read whole into buf (one record, CRC-checked by the store)
+ * and handed to the archive from there; mtime is the frame's store time.
+ * The archive must be begun; it is not finished here.
+ * @param capacity At least reader.buffer_size()
+ * @return Frames written; fewer than reader.frames() if the sink failed or
+ *         the clip was reclaimed mid-export (do not finish the archive then)
+ */
+inline uint32_t write_clip_archive(ClipReader& reader, ArchiveWriter& archive,
+                                   uint8_t* buf, size_t capacity) {
+    uint32_t written = 0;
+    int64_t timestamp_us = 0;
+    while (written < reader.frames()) {
+        size_t n = reader.read_frame(buf, capacity, &timestamp_us);
+        if (n == 0 || !archive.add_entry(written + 1, timestamp_us / 1000000, n) ||
+            !archive.write(buf, n) || !archive.end_entry()) break;
+        written++;
+    }
+    return written;
+}
+
+} // namespace core
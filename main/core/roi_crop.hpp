@@ -0,0 +1,404 @@
+/**
+ * @file roi_crop.hpp
+ * @brief Region-of-interest cropping of JPEG frames in the compressed domain
+ *
+ * Design: Cuts MCU-aligned rectangles out of a baseline JPEG without IDCT or
+ * re-quantization. Blocks inside the ROI are re-entropy-coded with fresh DC
+ * predictors (the "DC fix-up"); rows above the ROI are skipped via restart
+ * markers when the sensor emits them, otherwise they are Huffman-decoded and
+ * dropped. Results are cached per (frame sequence, ROI) so clients watching
+ * the same region share one crop.
+ *
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::mutex on host.
+ */
+#pragma once
+#include "jpeg_codec.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#else
+#include <mutex>
+#endif
+
+namespace core {
+
+struct RoiRect {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t w = 0;
+    uint16_t h = 0;
+
+    bool empty() const { return w == 0 || h == 0; }
+    bool operator==(const RoiRect& o) const {
+        return x == o.x && y == o.y && w == o.w && h == o.h;
+    }
+};
+
+/**
+ * @brief Parse "x,y,w,h" (decimal pixels) as used by /stream?roi=
+ * @return false on malformed input or an empty rectangle
+ */
+inline bool parse_roi(const char* text, RoiRect* out) {
+    if (!text || !out) return false;
+    long v[4];
+    const char* p = text;
+    for (int i = 0; i < 4; i++) {
+        char* end = nullptr;
+        v[i] = strtol(p, &end, 10);
+        if (end == p || v[i] < 0 || v[i] > 65535) return false;
+        p = end;
+        if (i < 3) {
+            if (*p != ',') return false;
+            p++;
+        }
+    }
+    if (*p != '\0') return false;
+    if (v[2] == 0 || v[3] == 0) return false;
+    out->x = static_cast<uint16_t>(v[0]);
+    out->y = static_cast<uint16_t>(v[1]);
+    out->w = static_cast<uint16_t>(v[2]);
+    out->h = static_cast<uint16_t>(v[3]);
+    return true;
+}
+
+/**
+ * @brief Compressed-domain cropper
+ *
+ * Holds Huffman tables and scratch blocks (~10KB), so keep one long-lived
+ * instance per user rather than constructing it on a task stack.
+ */
+class JpegRoiCropper {
+public:
+    /**
+     * @brief Crop an MCU-aligned region out of a baseline JPEG
+     * @param src Source JPEG
+     * @param src_size Source size in bytes
+     * @param roi Requested region in pixels (expanded outward to MCU grid)
+     * @param out Output buffer for the cropped JPEG
+     * @param capacity Output buffer size
+     * @param out_size Output: cropped JPEG size
+     * @param applied Output: region actually cut (optional)
+     * @return false if the source is unsupported, the ROI misses the frame
+     *         or the output does not fit
+     */
+    bool crop(const uint8_t* src, size_t src_size, const RoiRect& roi,
+              uint8_t* out, size_t capacity, size_t* out_size,
+              RoiRect* applied = nullptr) {
+        if (!src || !out || !out_size || roi.empty()) return false;
+        if (!jpeg_parse(src, src_size, &in_)) return false;
+        if (roi.x >= in_.width || roi.y >= in_.height) return false;
+
+        // Snap outward to the MCU grid
+        uint32_t mx0 = roi.x / in_.mcu_width;
+        uint32_t my0 = roi.y / in_.mcu_height;
+        uint32_t x_end = static_cast<uint32_t>(roi.x) + roi.w;
+        uint32_t y_end = static_cast<uint32_t>(roi.y) + roi.h;
+        uint32_t mx1 = (x_end + in_.mcu_width - 1) / in_.mcu_width;
+        uint32_t my1 = (y_end + in_.mcu_height - 1) / in_.mcu_height;
+        if (mx1 > in_.mcus_x) mx1 = in_.mcus_x;
+        if (my1 > in_.mcus_y) my1 = in_.mcus_y;
+
+        // Partial edge MCUs stay partial: clip to the source dimensions
+        uint32_t px0 = mx0 * in_.mcu_width;
+        uint32_t py0 = my0 * in_.mcu_height;
+        uint32_t px1 = mx1 * in_.mcu_width;
+        uint32_t py1 = my1 * in_.mcu_height;
+        if (px1 > in_.width) px1 = in_.width;
+        if (py1 > in_.height) py1 = in_.height;
+
+        out_info_ = in_;
+        out_info_.width = static_cast<uint16_t>(px1 - px0);
+        out_info_.height = static_cast<uint16_t>(py1 - py0);
+        out_info_.restart_interval = 0;
+        if (!jpeg_compute_layout(out_info_)) return false;
+
+        JpegByteWriter w(out, capacity);
+        if (!jpeg_write_headers(w, out_info_)) return false;
+        if (!decoder_.begin(src, src_size, in_)) return false;
+        encoder_.begin(w, out_info_);
+
+        // Skip rows above the ROI using restart markers when they align with rows
+        uint32_t mcu = 0;
+        uint32_t first_needed = my0 * in_.mcus_x;
+        if (in_.restart_interval && first_needed >= in_.restart_interval) {
+            uint32_t intervals = first_needed / in_.restart_interval;
+            if (decoder_.skip_intervals(intervals)) {
+                mcu = intervals * in_.restart_interval;
+            } else if (!decoder_.begin(src, src_size, in_)) {
+                return false;
+            }
+        }
+
+        uint32_t last_needed = my1 * in_.mcus_x;
+        for (; mcu < last_needed; mcu++) {
+            if (!decoder_.decode_mcu(blocks_)) return false;
+            uint32_t mx = mcu % in_.mcus_x;
+            uint32_t my = mcu / in_.mcus_x;
+            if (my >= my0 && mx >= mx0 && mx < mx1) {
+                encoder_.encode_mcu(blocks_);
+            }
+        }
+
+        encoder_.finish();
+        w.marker(jpeg_marker::EOI);
+        if (w.overflow()) return false;
+
+        *out_size = w.size();
+        if (applied) {
+            applied->x = static_cast<uint16_t>(px0);
+            applied->y = static_cast<uint16_t>(py0);
+            applied->w = out_info_.width;
+            applied->h = out_info_.height;
+        }
+        return true;
+    }
+
+private:
+    JpegInfo in_;
+    JpegInfo out_info_;
+    JpegScanDecoder decoder_;
+    JpegScanEncoder encoder_;
+    int16_t blocks_[JPEG_MAX_BLOCKS_PER_MCU][64];
+};
+
+struct RoiCropStats {
+    std::atomic<uint32_t> hits{0};
+    std::atomic<uint32_t> misses{0};
+    std::atomic<uint32_t> failures{0};
+
+    void reset() {
+        hits = 0;
+        misses = 0;
+        failures = 0;
+    }
+};
+
+/**
+ * @brief Per-frame cache of cropped JPEGs shared between stream clients
+ *
+ * Entries are keyed by (frame sequence, ROI) and reference-counted while a
+ * client is sending them. The least recently used unreferenced entry is
+ * recycled on a miss. Cropping runs under the cache lock, so concurrent
+ * clients asking for the same crop wait once and then hit.
+ *
+ * Memory: Pre-allocates entries in PSRAM (ESP32) or heap (host).
+ */
+class RoiCropCache {
+public:
+    RoiCropCache() = default;
+    ~RoiCropCache() { deinit(); }
+
+    // Non-copyable
+    RoiCropCache(const RoiCropCache&) = delete;
+    RoiCropCache& operator=(const RoiCropCache&) = delete;
+
+    /**
+     * @brief Pre-allocate cache entries
+     * @param num_entries Distinct crops kept at once
+     * @param max_frame_size Maximum bytes per cropped frame
+     * @param use_psram Use PSRAM for allocation (ESP32 only)
+     * @return true on success
+     */
+    bool init(size_t num_entries, size_t max_frame_size, bool use_psram = true) {
+        if (initialized_) return true;
+        if (num_entries == 0 || max_frame_size == 0) return false;
+
+        entries_ = new (std::nothrow) Entry[num_entries];
+        if (!entries_) return false;
+        num_entries_ = num_entries;
+
+        cropper_ = new (std::nothrow) JpegRoiCropper();
+        if (!cropper_) {
+            deinit();
+            return false;
+        }
+
+        for (size_t i = 0; i < num_entries_; i++) {
+#ifdef ESP_PLATFORM
+            entries_[i].data = static_cast<uint8_t*>(use_psram
+                ? heap_caps_malloc(max_frame_size, MALLOC_CAP_SPIRAM)
+                : malloc(max_frame_size));
+#else
+            (void)use_psram;
+            entries_[i].data = static_cast<uint8_t*>(malloc(max_frame_size));
+#endif
+            if (!entries_[i].data) {
+                deinit();
+                return false;
+            }
+            entries_[i].capacity = max_frame_size;
+        }
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        if (!mutex_) {
+            deinit();
+            return false;
+        }
+#endif
+
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() {
+        if (entries_) {
+            for (size_t i = 0; i < num_entries_; i++) {
+                if (entries_[i].data) {
+#ifdef ESP_PLATFORM
+                    heap_caps_free(entries_[i].data);
+#else
+                    free(entries_[i].data);
+#endif
+                }
+            }
+            delete[] entries_;
+            entries_ = nullptr;
+        }
+        delete cropper_;
+        cropper_ = nullptr;
+
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+#endif
+
+        num_entries_ = 0;
+        use_counter_ = 0;
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Get the crop of a frame, computing it on first request
+     * @param sequence Frame sequence number (cache key)
+     * @param roi Requested region
+     * @param src Source JPEG (only read on a miss)
+     * @param src_size Source size
+     * @param data Output: cropped JPEG
+     * @param size Output: cropped JPEG size
+     * @return Handle for release(), or -1 if the crop failed or every entry is in use
+     * @note Caller MUST call release() with the handle after sending
+     */
+    int acquire(uint32_t sequence, const RoiRect& roi,
+                const uint8_t* src, size_t src_size,
+                const uint8_t** data, size_t* size) {
+        if (!initialized_ || !data || !size) return -1;
+
+        lock();
+
+        int victim = -1;
+        for (size_t i = 0; i < num_entries_; i++) {
+            Entry& e = entries_[i];
+            if (e.valid && e.sequence == sequence && e.roi == roi) {
+                e.refs++;
+                e.last_used = ++use_counter_;
+                *data = e.data;
+                *size = e.size;
+                unlock();
+                stats_.hits++;
+                return static_cast<int>(i);
+            }
+            if (e.refs != 0) continue;
+            // Prefer empty entries, then the least recently used one
+            if (victim < 0) {
+                victim = static_cast<int>(i);
+            } else {
+                const Entry& v = entries_[victim];
+                if (v.valid && (!e.valid || e.last_used < v.last_used)) {
+                    victim = static_cast<int>(i);
+                }
+            }
+        }
+
+        if (victim < 0) {
+            unlock();
+            stats_.failures++;
+            return -1;
+        }
+
+        Entry& e = entries_[victim];
+        e.valid = false;
+        if (!cropper_->crop(src, src_size, roi, e.data, e.capacity, &e.size)) {
+            unlock();
+            stats_.failures++;
+            return -1;
+        }
+        e.valid = true;
+        e.sequence = sequence;
+        e.roi = roi;
+        e.refs = 1;
+        e.last_used = ++use_counter_;
+        *data = e.data;
+        *size = e.size;
+
+        unlock();
+        stats_.misses++;
+        return victim;
+    }
+
+    /**
+     * @brief Release an entry obtained from acquire()
+     */
+    void release(int handle) {
+        if (!initialized_ || handle < 0 || static_cast<size_t>(handle) >= num_entries_) return;
+        lock();
+        if (entries_[handle].refs > 0) entries_[handle].refs--;
+        unlock();
+    }
+
+    const RoiCropStats& stats() const { return stats_; }
+    size_t capacity() const { return num_entries_; }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    struct Entry {
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+        size_t size = 0;
+        uint32_t sequence = 0;
+        RoiRect roi;
+        uint32_t refs = 0;
+        uint32_t last_used = 0;
+        bool valid = false;
+    };
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    Entry* entries_ = nullptr;
+    size_t num_entries_ = 0;
+    JpegRoiCropper* cropper_ = nullptr;
+    uint32_t use_counter_ = 0;
+    RoiCropStats stats_;
+    bool initialized_ = false;
+
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t mutex_ = nullptr;
+#else
+    std::mutex mutex_;
+#endif
+};
+
+} // namespace core
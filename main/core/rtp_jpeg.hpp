@@ -0,0 +1,765 @@
+/**
+ * @file rtp_jpeg.hpp
+ * @brief RTP/JPEG (RFC 2435) packetization with XOR parity, pacing and reassembly
+ *
+ * Design: A frame is parsed once and cut into RTP packets carrying the
+ * entropy-coded scan; the JPEG headers are not sent but rebuilt by the
+ * receiver from an 8-byte per-packet header and in-band quantization tables
+ * (Q=255), so a standard RTP/JPEG player can watch the stream directly.
+ *
+ * Loss resilience: after every `parity_group` media packets of a frame (and
+ * after the last one) the packetizer emits a parity packet on a separate
+ * stream: the XOR of those packets' payloads, lengths and marker bits. A
+ * receiver can rebuild any single lost packet per group. Groups never span
+ * frames, so a frame only waits on its own parity.
+ *
+ * Pacing: RtpPacer is a token bucket that spreads a frame's packets over
+ * time instead of bursting them into the Wi-Fi queue.
+ *
+ * Limits: baseline YCbCr 4:2:2 or 4:2:0 with standard Huffman tables (what
+ * the OV2640 emits), width and height multiples of 8 up to 2040 pixels.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include "jpeg_codec.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace core {
+
+static constexpr uint8_t RTP_JPEG_PAYLOAD_TYPE = 26;      // Static PT for JPEG (RFC 3551)
+static constexpr uint8_t RTP_PARITY_PAYLOAD_TYPE = 127;   // Dynamic PT for parity packets
+static constexpr uint32_t RTP_JPEG_CLOCK_RATE = 90000;
+static constexpr size_t RTP_HEADER_SIZE = 12;
+static constexpr size_t RTP_JPEG_HEADER_SIZE = 8;
+static constexpr size_t RTP_RESTART_HEADER_SIZE = 4;
+static constexpr size_t RTP_QUANT_HEADER_SIZE = 4;
+static constexpr size_t RTP_PARITY_HEADER_SIZE = 8;
+static constexpr size_t RTP_MAX_DATAGRAM = 1472;          // Ethernet MTU minus IPv4/UDP
+static constexpr size_t RTP_MIN_DATAGRAM = 320;           // Room for headers + quant tables
+static constexpr uint8_t RTP_MAX_PARITY_GROUP = 32;
+static constexpr uint8_t RTP_JPEG_Q_DYNAMIC = 255;        // Tables sent in-band every frame
+
+inline uint32_t rtp_jpeg_timestamp(int64_t timestamp_us) {
+    return static_cast<uint32_t>(timestamp_us * 9 / 100);
+}
+
+struct RtpHeader {
+    bool marker = false;
+    uint8_t payload_type = 0;
+    uint16_t sequence = 0;
+    uint32_t timestamp = 0;
+    uint32_t ssrc = 0;
+};
+
+inline void rtp_write_header(uint8_t* out, const RtpHeader& h) {
+    out[0] = 0x80;  // V=2, no padding/extension/CSRC
+    out[1] = static_cast<uint8_t>((h.marker ? 0x80 : 0x00) | (h.payload_type & 0x7F));
+    out[2] = static_cast<uint8_t>(h.sequence >> 8);
+    out[3] = static_cast<uint8_t>(h.sequence);
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = static_cast<uint8_t>(h.timestamp >> (24 - 8 * i));
+        out[8 + i] = static_cast<uint8_t>(h.ssrc >> (24 - 8 * i));
+    }
+}
+
+/**
+ * @brief Parse an RTP fixed header (plus CSRC list and extension)
+ * @return Offset of the payload, or 0 if the packet is malformed
+ */
+inline size_t rtp_read_header(const uint8_t* data, size_t size, RtpHeader* h) {
+    if (!data || !h || size < RTP_HEADER_SIZE || (data[0] >> 6) != 2) return 0;
+    size_t offset = RTP_HEADER_SIZE + 4u * (data[0] & 0x0F);
+    if (data[0] & 0x10) {
+        if (offset + 4 > size) return 0;
+        offset += 4 + 4u * static_cast<size_t>((data[offset + 2] << 8) | data[offset + 3]);
+    }
+    size_t end = size;
+    if (data[0] & 0x20) {
+        if (data[size - 1] == 0 || data[size - 1] > size) return 0;
+        end -= data[size - 1];
+    }
+    if (offset > end) return 0;
+    h->marker = (data[1] & 0x80) != 0;
+    h->payload_type = data[1] & 0x7F;
+    h->sequence = static_cast<uint16_t>((data[2] << 8) | data[3]);
+    h->timestamp = 0;
+    h->ssrc = 0;
+    for (int i = 0; i < 4; i++) {
+        h->timestamp = (h->timestamp << 8) | data[4 + i];
+        h->ssrc = (h->ssrc << 8) | data[8 + i];
+    }
+    return offset;
+}
+
+// =============================================================================
+// Packetizer
+// =============================================================================
+
+enum class RtpPacketKind : uint8_t {
+    Media = 0,    // RTP/JPEG, sent to the stream port
+    Parity        // XOR parity, sent to the stream port + 2
+};
+
+/**
+ * @brief Cuts JPEG frames into RTP/JPEG packets interleaved with parity packets
+ *
+ * Usage:
+ *   if (packetizer.begin(jpeg, size, timestamp_us)) {
+ *       RtpPacketKind kind;
+ *       while (size_t n = packetizer.next(buf, sizeof(buf), &kind)) send(buf, n, kind);
+ *   }
+ *
+ * The frame must stay valid until next() returns 0. Packets are built on
+ * demand, so memory use is one datagram plus one parity accumulator.
+ */
+class RtpJpegPacketizer {
+public:
+    RtpJpegPacketizer() = default;
+
+    // Non-copyable
+    RtpJpegPacketizer(const RtpJpegPacketizer&) = delete;
+    RtpJpegPacketizer& operator=(const RtpJpegPacketizer&) = delete;
+
+    /**
+     * @param max_datagram Largest datagram produced (media and parity)
+     * @param parity_group Media packets covered by each parity packet (0 = no parity)
+     * @param ssrc RTP synchronization source of both streams
+     * @return false if the datagram size or group is out of range
+     */
+    bool configure(size_t max_datagram, uint8_t parity_group, uint32_t ssrc) {
+        if (max_datagram < RTP_MIN_DATAGRAM || max_datagram > RTP_MAX_DATAGRAM) return false;
+        if (parity_group > RTP_MAX_PARITY_GROUP) return false;
+        max_datagram_ = max_datagram;
+        parity_group_ = parity_group;
+        ssrc_ = ssrc;
+        return true;
+    }
+
+    /**
+     * @brief Parse a frame and prepare its packets
+     * @return false if RFC 2435 cannot carry this JPEG
+     */
+    bool begin(const uint8_t* jpeg, size_t size, int64_t timestamp_us) {
+        active_ = false;
+        JpegInfo info;
+        if (!jpeg_parse(jpeg, size, &info) || info.scan_size == 0) return false;
+        if (!describe(info)) return false;
+
+        scan_ = jpeg + info.scan_offset;
+        scan_size_ = info.scan_size;
+        offset_ = 0;
+        timestamp_ = rtp_jpeg_timestamp(timestamp_us);
+        reset_group();
+        parity_pending_ = false;
+        active_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Build the next datagram of the current frame
+     * @param out Destination (at least max_datagram bytes)
+     * @param kind Output: which stream the datagram belongs to
+     * @return Datagram length, or 0 when the frame is done
+     */
+    size_t next(uint8_t* out, size_t capacity, RtpPacketKind* kind) {
+        if (!out || !kind || capacity < max_datagram_) return 0;
+        if (parity_pending_) {
+            *kind = RtpPacketKind::Parity;
+            return build_parity(out);
+        }
+        if (!active_ || offset_ >= scan_size_) {
+            active_ = false;
+            return 0;
+        }
+        *kind = RtpPacketKind::Media;
+        return build_media(out);
+    }
+
+    uint16_t media_sequence() const { return media_seq_; }
+    uint16_t parity_sequence() const { return parity_seq_; }
+    uint8_t jpeg_type() const { return type_; }
+    size_t max_datagram() const { return max_datagram_; }
+    uint8_t parity_group() const { return parity_group_; }
+
+private:
+    // Map the JPEG onto RFC 2435 type, dimensions and quant table header
+    bool describe(const JpegInfo& info) {
+        if (info.num_components != 3) return false;
+        const auto& y = info.components[0];
+        const auto& cb = info.components[1];
+        const auto& cr = info.components[2];
+        if (cb.h != 1 || cb.v != 1 || cr.h != 1 || cr.v != 1) return false;
+        if (y.h != 2 || (y.v != 1 && y.v != 2)) return false;
+        if (cb.tq != cr.tq) return false;
+        if (!info.quant_present[y.tq] || !info.quant_present[cb.tq]) return false;
+        if ((info.width & 7) || (info.height & 7)) return false;
+        if (info.width > 2040 || info.height > 2040) return false;
+        if (!jpeg_uses_standard_huffman(info)) return false;
+
+        type_ = static_cast<uint8_t>((y.v == 2 ? 1 : 0) | (info.restart_interval ? 64 : 0));
+        width8_ = static_cast<uint8_t>(info.width / 8);
+        height8_ = static_cast<uint8_t>(info.height / 8);
+        restart_interval_ = info.restart_interval;
+
+        // Quantization table header: luma table then the shared chroma table
+        precision_ = 0;
+        quant_len_ = 0;
+        const uint8_t tables[2] = {y.tq, cb.tq};
+        for (int t = 0; t < 2; t++) {
+            const uint16_t* q = info.quant[tables[t]];
+            bool wide = false;
+            for (int k = 0; k < 64; k++) {
+                if (q[k] > 255) wide = true;
+            }
+            if (wide) precision_ |= static_cast<uint8_t>(1 << t);
+            for (int k = 0; k < 64; k++) {
+                if (wide) quant_[quant_len_++] = static_cast<uint8_t>(q[k] >> 8);
+                quant_[quant_len_++] = static_cast<uint8_t>(q[k]);
+            }
+        }
+        return true;
+    }
+
+    size_t build_media(uint8_t* out) {
+        // Media packets leave room for the parity header so parity fits too
+        size_t limit = max_datagram_ - (parity_group_ ? RTP_PARITY_HEADER_SIZE : 0);
+        uint8_t* p = out + RTP_HEADER_SIZE;
+
+        p[0] = 0;  // Type-specific
+        p[1] = static_cast<uint8_t>(offset_ >> 16);
+        p[2] = static_cast<uint8_t>(offset_ >> 8);
+        p[3] = static_cast<uint8_t>(offset_);
+        p[4] = type_;
+        p[5] = RTP_JPEG_Q_DYNAMIC;
+        p[6] = width8_;
+        p[7] = height8_;
+        p += RTP_JPEG_HEADER_SIZE;
+
+        if (restart_interval_) {
+            p[0] = static_cast<uint8_t>(restart_interval_ >> 8);
+            p[1] = static_cast<uint8_t>(restart_interval_);
+            p[2] = 0xFF;  // F=1, L=1, count=0x3FFF: fragment not aligned to intervals
+            p[3] = 0xFF;
+            p += RTP_RESTART_HEADER_SIZE;
+        }
+
+        if (offset_ == 0) {
+            p[0] = 0;  // MBZ
+            p[1] = precision_;
+            p[2] = static_cast<uint8_t>(quant_len_ >> 8);
+            p[3] = static_cast<uint8_t>(quant_len_);
+            memcpy(p + RTP_QUANT_HEADER_SIZE, quant_, quant_len_);
+            p += RTP_QUANT_HEADER_SIZE + quant_len_;
+        }
+
+        size_t room = limit - static_cast<size_t>(p - out);
+        size_t chunk = scan_size_ - offset_;
+        if (chunk > room) chunk = room;
+        memcpy(p, scan_ + offset_, chunk);
+        offset_ += chunk;
+        p += chunk;
+
+        RtpHeader h;
+        h.marker = offset_ >= scan_size_;
+        h.payload_type = RTP_JPEG_PAYLOAD_TYPE;
+        h.sequence = media_seq_;
+        h.timestamp = timestamp_;
+        h.ssrc = ssrc_;
+        rtp_write_header(out, h);
+
+        size_t len = static_cast<size_t>(p - out);
+        if (parity_group_) {
+            accumulate(out + RTP_HEADER_SIZE, len - RTP_HEADER_SIZE, h.marker);
+            if (group_count_ == parity_group_ || h.marker) parity_pending_ = true;
+        }
+        media_seq_++;
+        return len;
+    }
+
+    void accumulate(const uint8_t* payload, size_t len, bool marker) {
+        if (group_count_ == 0) group_base_ = media_seq_;
+        for (size_t i = 0; i < len; i++) parity_[i] ^= payload[i];
+        if (len > parity_len_) parity_len_ = len;
+        len_xor_ ^= static_cast<uint16_t>(len);
+        marker_xor_ ^= marker ? 1 : 0;
+        group_count_++;
+    }
+
+    size_t build_parity(uint8_t* out) {
+        RtpHeader h;
+        h.marker = !active_ || offset_ >= scan_size_;  // Last parity of the frame
+        h.payload_type = RTP_PARITY_PAYLOAD_TYPE;
+        h.sequence = parity_seq_++;
+        h.timestamp = timestamp_;
+        h.ssrc = ssrc_;
+        rtp_write_header(out, h);
+
+        uint8_t* p = out + RTP_HEADER_SIZE;
+        p[0] = static_cast<uint8_t>(group_base_ >> 8);
+        p[1] = static_cast<uint8_t>(group_base_);
+        p[2] = group_count_;
+        p[3] = marker_xor_;
+        p[4] = static_cast<uint8_t>(len_xor_ >> 8);
+        p[5] = static_cast<uint8_t>(len_xor_);
+        p[6] = 0;
+        p[7] = 0;
+        memcpy(p + RTP_PARITY_HEADER_SIZE, parity_, parity_len_);
+
+        size_t len = RTP_HEADER_SIZE + RTP_PARITY_HEADER_SIZE + parity_len_;
+        reset_group();
+        parity_pending_ = false;
+        return len;
+    }
+
+    void reset_group() {
+        memset(parity_, 0, parity_len_);
+        parity_len_ = 0;
+        len_xor_ = 0;
+        marker_xor_ = 0;
+        group_count_ = 0;
+    }
+
+    // Configuration
+    size_t max_datagram_ = 1400;
+    uint8_t parity_group_ = 4;
+    uint32_t ssrc_ = 0;
+
+    // Current frame
+    const uint8_t* scan_ = nullptr;
+    size_t scan_size_ = 0;
+    size_t offset_ = 0;
+    uint32_t timestamp_ = 0;
+    bool active_ = false;
+    uint8_t type_ = 0;
+    uint8_t width8_ = 0;
+    uint8_t height8_ = 0;
+    uint16_t restart_interval_ = 0;
+    uint8_t precision_ = 0;
+    uint16_t quant_len_ = 0;
+    uint8_t quant_[256] = {};
+
+    // Sequence numbers persist across frames
+    uint16_t media_seq_ = 0;
+    uint16_t parity_seq_ = 0;
+
+    // Parity accumulator for the open group
+    uint8_t parity_[RTP_MAX_DATAGRAM] = {};
+    size_t parity_len_ = 0;
+    uint16_t len_xor_ = 0;
+    uint8_t marker_xor_ = 0;
+    uint8_t group_count_ = 0;
+    uint16_t group_base_ = 0;
+    bool parity_pending_ = false;
+};
+
+// =============================================================================
+// Pacer
+// =============================================================================
+
+/**
+ * @brief Token bucket: sustained rate with a bounded burst
+ *
+ * reserve() books a datagram and returns how long the caller should wait
+ * before sending it. Waiting less than asked is safe: the shortfall is
+ * carried as debt and added to the next wait.
+ */
+class RtpPacer {
+public:
+    RtpPacer(uint32_t rate_bytes_per_s = 500 * 1000, uint32_t burst_bytes = 4 * 1400) {
+        configure(rate_bytes_per_s, burst_bytes);
+    }
+
+    void configure(uint32_t rate_bytes_per_s, uint32_t burst_bytes) {
+        rate_ = rate_bytes_per_s ? rate_bytes_per_s : 1;
+        burst_ = static_cast<int64_t>(burst_bytes) * US_PER_S;
+        tokens_ = burst_;
+        last_us_ = INT64_MIN;
+    }
+
+    /**
+     * @return Microseconds to wait before sending (0 = send now)
+     */
+    int64_t reserve(size_t bytes, int64_t now_us) {
+        if (last_us_ != INT64_MIN && now_us > last_us_) {
+            tokens_ += (now_us - last_us_) * static_cast<int64_t>(rate_);
+            if (tokens_ > burst_) tokens_ = burst_;
+        }
+        if (last_us_ == INT64_MIN || now_us > last_us_) last_us_ = now_us;
+
+        tokens_ -= static_cast<int64_t>(bytes) * US_PER_S;
+        if (tokens_ >= 0) return 0;
+        return (-tokens_ + rate_ - 1) / rate_;
+    }
+
+    uint32_t rate() const { return rate_; }
+
+private:
+    static constexpr int64_t US_PER_S = 1000 * 1000;
+
+    uint32_t rate_ = 1;
+    int64_t burst_ = 0;
+    int64_t tokens_ = 0;   // Bytes x 1e6, so refills stay integral
+    int64_t last_us_ = INT64_MIN;
+};
+
+// =============================================================================
+// Receiver
+// =============================================================================
+
+struct RtpJpegReceiverStats {
+    uint32_t packets = 0;             // Media packets received
+    uint32_t parity_packets = 0;      // Parity packets received
+    uint32_t recovered_packets = 0;   // Media packets rebuilt from parity
+    uint32_t frames_complete = 0;     // Frames delivered
+    uint32_t frames_recovered = 0;    // ...of which needed parity
+    uint32_t frames_incomplete = 0;   // Frames abandoned with missing packets
+    uint32_t malformed = 0;           // Packets or frames that could not be parsed
+};
+
+/**
+ * @brief Reassembles RTP/JPEG frames, repairing single losses per parity group
+ *
+ * Feed every datagram from both ports to on_packet(); when it returns true
+ * frame() holds a complete JPEG (headers rebuilt, scan bytes as sent). A
+ * frame is abandoned once packets of a newer frame arrive.
+ *
+ * Used by host tests and tools; buffers are heap-allocated by init().
+ */
+class RtpJpegReceiver {
+public:
+    static constexpr size_t RING_SIZE = 256;        // Media packets kept (power of two)
+    static constexpr size_t PARITY_RING_SIZE = 64;  // Parity packets kept
+
+    RtpJpegReceiver() = default;
+    ~RtpJpegReceiver() { deinit(); }
+
+    // Non-copyable
+    RtpJpegReceiver(const RtpJpegReceiver&) = delete;
+    RtpJpegReceiver& operator=(const RtpJpegReceiver&) = delete;
+
+    /**
+     * @param max_frame_size Largest JPEG that can be rebuilt
+     */
+    bool init(size_t max_frame_size) {
+        if (slots_) return true;
+        slots_ = new (std::nothrow) Packet[RING_SIZE];
+        parity_ = new (std::nothrow) Packet[PARITY_RING_SIZE];
+        frame_ = static_cast<uint8_t*>(malloc(max_frame_size));
+        if (!slots_ || !parity_ || !frame_) {
+            deinit();
+            return false;
+        }
+        frame_capacity_ = max_frame_size;
+        reset();
+        return true;
+    }
+
+    void deinit() {
+        delete[] slots_;
+        slots_ = nullptr;
+        delete[] parity_;
+        parity_ = nullptr;
+        free(frame_);
+        frame_ = nullptr;
+        frame_capacity_ = 0;
+    }
+
+    void reset() {
+        if (slots_) {
+            for (size_t i = 0; i < RING_SIZE; i++) slots_[i].used = false;
+        }
+        if (parity_) {
+            for (size_t i = 0; i < PARITY_RING_SIZE; i++) parity_[i].used = false;
+        }
+        have_current_ = false;
+        current_done_ = false;
+        frame_size_ = 0;
+        stats_ = RtpJpegReceiverStats{};
+    }
+
+    /**
+     * @brief Process one datagram from either stream
+     * @return true if it completed a frame (see frame())
+     */
+    bool on_packet(const uint8_t* data, size_t size) {
+        if (!slots_) return false;
+        RtpHeader h;
+        size_t offset = rtp_read_header(data, size, &h);
+        if (offset == 0 || size - offset > RTP_MAX_DATAGRAM) {
+            stats_.malformed++;
+            return false;
+        }
+        const uint8_t* payload = data + offset;
+        size_t len = size - offset;
+
+        if (!track(h.timestamp)) return false;  // Older than the current frame
+
+        if (h.payload_type == RTP_PARITY_PAYLOAD_TYPE) {
+            if (len < RTP_PARITY_HEADER_SIZE) {
+                stats_.malformed++;
+                return false;
+            }
+            stats_.parity_packets++;
+            Packet& p = parity_[h.sequence % PARITY_RING_SIZE];
+            store(p, h, payload, len);
+            recover(p);
+        } else if (h.payload_type == RTP_JPEG_PAYLOAD_TYPE) {
+            if (len < RTP_JPEG_HEADER_SIZE) {
+                stats_.malformed++;
+                return false;
+            }
+            stats_.packets++;
+            store(slots_[h.sequence % RING_SIZE], h, payload, len);
+            for (size_t i = 0; i < PARITY_RING_SIZE; i++) {
+                if (covers(parity_[i], h.sequence)) recover(parity_[i]);
+            }
+        } else {
+            return false;
+        }
+        return try_complete();
+    }
+
+    const uint8_t* frame() const { return frame_; }
+    size_t frame_size() const { return frame_size_; }
+    uint32_t frame_timestamp() const { return current_ts_; }
+    const RtpJpegReceiverStats& stats() const { return stats_; }
+
+private:
+    struct Packet {
+        bool used = false;
+        bool recovered = false;
+        bool marker = false;
+        uint16_t sequence = 0;
+        uint32_t timestamp = 0;
+        uint16_t len = 0;
+        uint8_t data[RTP_MAX_DATAGRAM];
+    };
+
+    void store(Packet& p, const RtpHeader& h, const uint8_t* payload, size_t len) {
+        p.used = true;
+        p.recovered = false;
+        p.marker = h.marker;
+        p.sequence = h.sequence;
+        p.timestamp = h.timestamp;
+        p.len = static_cast<uint16_t>(len);
+        memcpy(p.data, payload, len);
+    }
+
+    // Follow the newest timestamp; returns false for packets of older frames
+    bool track(uint32_t ts) {
+        if (!have_current_) {
+            have_current_ = true;
+            current_ts_ = ts;
+            current_done_ = false;
+            return true;
+        }
+        if (ts == current_ts_) return true;
+        if (static_cast<int32_t>(ts - current_ts_) < 0) return false;
+        if (!current_done_) stats_.frames_incomplete++;
+        current_ts_ = ts;
+        current_done_ = false;
+        return true;
+    }
+
+    Packet* media(uint16_t seq, uint32_t ts) {
+        Packet& p = slots_[seq % RING_SIZE];
+        return (p.used && p.sequence == seq && p.timestamp == ts) ? &p : nullptr;
+    }
+
+    static uint16_t parity_base(const Packet& p) {
+        return static_cast<uint16_t>((p.data[0] << 8) | p.data[1]);
+    }
+
+    bool covers(const Packet& p, uint16_t seq) const {
+        return p.used && p.timestamp == current_ts_ &&
+               static_cast<uint16_t>(seq - parity_base(p)) < p.data[2];
+    }
+
+    // Rebuild the group's missing packet if exactly one is missing
+    void recover(const Packet& parity) {
+        if (parity.timestamp != current_ts_) return;
+        uint16_t base = parity_base(parity);
+        uint8_t count = parity.data[2];
+        int missing = -1;
+        for (uint8_t i = 0; i < count; i++) {
+            if (!media(static_cast<uint16_t>(base + i), parity.timestamp)) {
+                if (missing >= 0) return;  // Two or more lost: unrecoverable
+                missing = i;
+            }
+        }
+        if (missing < 0) return;
+
+        const uint8_t* bits = parity.data + RTP_PARITY_HEADER_SIZE;
+        size_t bits_len = parity.len - RTP_PARITY_HEADER_SIZE;
+        uint16_t len = static_cast<uint16_t>((parity.data[4] << 8) | parity.data[5]);
+        uint8_t marker = parity.data[3];
+        uint8_t rebuilt[RTP_MAX_DATAGRAM];
+        memcpy(rebuilt, bits, bits_len);
+        for (uint8_t i = 0; i < count; i++) {
+            if (i == missing) continue;
+            const Packet* p = media(static_cast<uint16_t>(base + i), parity.timestamp);
+            for (size_t k = 0; k < p->len; k++) rebuilt[k] ^= p->data[k];
+            len ^= p->len;
+            marker ^= p->marker ? 1 : 0;
+        }
+        if (len > bits_len || len < RTP_JPEG_HEADER_SIZE) {
+            stats_.malformed++;
+            return;
+        }
+
+        RtpHeader h;
+        h.marker = marker & 1;
+        h.payload_type = RTP_JPEG_PAYLOAD_TYPE;
+        h.sequence = static_cast<uint16_t>(base + missing);
+        h.timestamp = parity.timestamp;
+        Packet& slot = slots_[h.sequence % RING_SIZE];
+        store(slot, h, rebuilt, len);
+        slot.recovered = true;
+        stats_.recovered_packets++;
+    }
+
+    static uint32_t fragment_offset(const Packet& p) {
+        return (static_cast<uint32_t>(p.data[1]) << 16) | (p.data[2] << 8) | p.data[3];
+    }
+
+    bool try_complete() {
+        if (current_done_) return false;
+
+        // Locate the first (offset 0) and last (marker) packets of the frame
+        const Packet* first = nullptr;
+        const Packet* last = nullptr;
+        for (size_t i = 0; i < RING_SIZE; i++) {
+            const Packet& p = slots_[i];
+            if (!p.used || p.timestamp != current_ts_) continue;
+            if (fragment_offset(p) == 0) first = &p;
+            if (p.marker) last = &p;
+        }
+        if (!first || !last) return false;
+
+        uint16_t count = static_cast<uint16_t>(last->sequence - first->sequence + 1);
+        if (count > RING_SIZE) return false;
+        for (uint16_t i = 0; i < count; i++) {
+            if (!media(static_cast<uint16_t>(first->sequence + i), current_ts_)) return false;
+        }
+
+        current_done_ = true;
+        if (!assemble(first->sequence, count)) {
+            stats_.malformed++;
+            return false;
+        }
+        stats_.frames_complete++;
+        for (uint16_t i = 0; i < count; i++) {
+            if (media(static_cast<uint16_t>(first->sequence + i), current_ts_)->recovered) {
+                stats_.frames_recovered++;
+                break;
+            }
+        }
+        return true;
+    }
+
+    // Rebuild JPEG headers from the first packet, then append every fragment
+    bool assemble(uint16_t first_seq, uint16_t count) {
+        const Packet& first = *media(first_seq, current_ts_);
+        const uint8_t* p = first.data;
+        uint8_t type = p[4];
+        uint8_t q = p[5];
+        size_t pos = RTP_JPEG_HEADER_SIZE;
+        if ((type & 0x3F) > 1 || q < 128) return false;  // Only in-band tables are supported
+
+        JpegInfo info;
+        info.width = static_cast<uint16_t>(p[6] * 8);
+        info.height = static_cast<uint16_t>(p[7] * 8);
+        if (type & 64) {
+            if (first.len < pos + RTP_RESTART_HEADER_SIZE) return false;
+            info.restart_interval = static_cast<uint16_t>((p[pos] << 8) | p[pos + 1]);
+            pos += RTP_RESTART_HEADER_SIZE;
+        }
+        if (first.len < pos + RTP_QUANT_HEADER_SIZE) return false;
+        uint8_t precision = p[pos + 1];
+        size_t quant_len = static_cast<size_t>((p[pos + 2] << 8) | p[pos + 3]);
+        pos += RTP_QUANT_HEADER_SIZE;
+        size_t need = ((precision & 1) ? 128 : 64) + ((precision & 2) ? 128 : 64);
+        if (quant_len != need || first.len < pos + quant_len) return false;
+        const uint8_t* qt = p + pos;
+        for (int t = 0; t < 2; t++) {
+            bool wide = (precision >> t) & 1;
+            for (int k = 0; k < 64; k++) {
+                info.quant[t][k] = wide ? static_cast<uint16_t>((qt[0] << 8) | qt[1]) : qt[0];
+                qt += wide ? 2 : 1;
+            }
+            info.quant_present[t] = true;
+        }
+
+        info.num_components = 3;
+        for (uint8_t c = 0; c < 3; c++) {
+            auto& comp = info.components[c];
+            comp.id = static_cast<uint8_t>(c + 1);
+            comp.h = c == 0 ? 2 : 1;
+            comp.v = (c == 0 && (type & 0x3F) == 1) ? 2 : 1;
+            comp.tq = c == 0 ? 0 : 1;
+            comp.td = comp.tq;
+            comp.ta = comp.tq;
+        }
+        if (!jpeg_compute_layout(info)) return false;
+
+        JpegByteWriter w(frame_, frame_capacity_);
+        if (!jpeg_write_headers(w, info)) return false;
+
+        size_t header_len = RTP_JPEG_HEADER_SIZE + ((type & 64) ? RTP_RESTART_HEADER_SIZE : 0);
+        uint32_t expected = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            const Packet& frag = *media(static_cast<uint16_t>(first_seq + i), current_ts_);
+            size_t skip = header_len + (i == 0 ? RTP_QUANT_HEADER_SIZE + quant_len : 0);
+            if (fragment_offset(frag) != expected || frag.len < skip) return false;
+            w.write(frag.data + skip, frag.len - skip);
+            expected += static_cast<uint32_t>(frag.len - skip);
+        }
+        w.marker(jpeg_marker::EOI);
+        if (w.overflow()) return false;
+        frame_size_ = w.size();
+        return true;
+    }
+
+    Packet* slots_ = nullptr;
+    Packet* parity_ = nullptr;
+    uint8_t* frame_ = nullptr;
+    size_t frame_capacity_ = 0;
+    size_t frame_size_ = 0;
+
+    uint32_t current_ts_ = 0;
+    bool have_current_ = false;
+    bool current_done_ = false;
+    RtpJpegReceiverStats stats_;
+};
+
+/**
+ * @brief Session description for players (e.g. `ffplay -protocol_whitelist
+ *        file,udp,rtp stream.sdp` or VLC)
+ * @return Length written, or 0 if the buffer is too small
+ */
+inline size_t rtp_jpeg_format_sdp(char* buf, size_t capacity, const char* source_ip,
+                                  const char* group, uint16_t port, uint8_t ttl,
+                                  uint32_t ssrc) {
+    int n = snprintf(buf, capacity,
+                     "v=0\r\n"
+                     "o=- %lu 1 IN IP4 %s\r\n"
+                     "s=ESP32 Camera\r\n"
+                     "c=IN IP4 %s/%u\r\n"
+                     "t=0 0\r\n"
+                     "m=video %u RTP/AVP %u\r\n"
+                     "a=rtpmap:%u JPEG/%lu\r\n"
+                     "a=recvonly\r\n",
+                     static_cast<unsigned long>(ssrc), source_ip, group, ttl, port,
+                     RTP_JPEG_PAYLOAD_TYPE, RTP_JPEG_PAYLOAD_TYPE,
+                     static_cast<unsigned long>(RTP_JPEG_CLOCK_RATE));
+    if (n < 0 || static_cast<size_t>(n) >= capacity) return 0;
+    return static_cast<size_t>(n);
+}
+
+} // namespace core
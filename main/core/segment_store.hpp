@@ -0,0 +1,739 @@
+/**
+ * @file segment_store.hpp
+ * @brief Log-structured circular frame store on erase-before-write media
+ *
+ * Layout: the medium is cut into fixed-size segments (a multiple of the
+ * erase block) used strictly in circular order. Each segment starts with a
+ * header carrying a generation number and holds back-to-back records:
+ *
+ *   [segment header 16 B][record header 28 B][payload][pad to 4]...[0xFF...]
+ *
+ * Record header: magic, payload size, sequence, timestamp, payload CRC-32,
+ * header CRC-32. Nothing is ever rewritten in place: every byte is
+ * programmed once between erases, so a lap of the log costs exactly one
+ * erase per segment and wear is spread evenly.
+ *
+ * Erases are taken off the append path: service() keeps spare_segments
+ * erased ahead of the write head, reclaiming the oldest segments as it
+ * goes. append() only erases itself (counted as an erase stall) if the
+ * spares ran out.
+ *
+ * Power loss: mount() orders segments by generation, summarizes each from
+ * its record headers, and verifies payload CRCs in the newest segment only.
+ * A torn record (bad CRC, or non-blank bytes where the next header would
+ * go) ends the log; that segment is sealed and writing resumes in a fresh
+ * one. The in-RAM index is one summary per segment (time/sequence range),
+ * so seeking is a binary search over segments plus a header walk inside
+ * one segment.
+ *
+ * Thread-safe: one lock covers index and medium access.
+ * Cross-platform: Uses FreeRTOS primitives on ESP32, std::mutex on host.
+ */
+#pragma once
+#include "../interfaces/i_block_storage.hpp"
+#include "crc32.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#else
+#include <mutex>
+#endif
+
+namespace core {
+
+static constexpr uint32_t SEGMENT_MAGIC = 0x314D4753;   // "SGM1"
+static constexpr uint32_t RECORD_MAGIC = 0x31434552;    // "REC1"
+static constexpr size_t SEGMENT_HEADER_SIZE = 16;
+static constexpr size_t RECORD_HEADER_SIZE = 28;
+
+struct SegmentStoreConfig {
+    size_t segment_size = 64 * 1024;   // Multiple of the erase block
+    size_t spare_segments = 1;         // Kept erased ahead of the write head
+};
+
+struct SegmentStoreStats {
+    std::atomic<uint32_t> records_appended{0};
+    std::atomic<uint32_t> records_rejected{0};    // Too large, out of order or I/O error
+    std::atomic<uint32_t> records_reclaimed{0};   // Lost to oldest-segment reclamation
+    std::atomic<uint32_t> segments_reclaimed{0};
+    std::atomic<uint32_t> erases{0};
+    std::atomic<uint32_t> erase_stalls{0};        // Erases append() had to do itself
+    std::atomic<uint32_t> torn_records{0};        // Cut off by power loss (found at mount)
+    std::atomic<uint32_t> crc_errors{0};          // read() found a corrupt payload
+    std::atomic<uint64_t> payload_bytes{0};
+    std::atomic<uint64_t> bytes_written{0};       // Headers + payload programmed
+    std::atomic<uint64_t> bytes_erased{0};
+
+    /**
+     * @brief Bytes programmed per payload byte (>= 1; headers and padding)
+     */
+    double write_amplification() const {
+        uint64_t payload = payload_bytes.load();
+        return payload ? static_cast<double>(bytes_written.load()) / static_cast<double>(payload) : 0.0;
+    }
+
+    void reset() {
+        records_appended = 0;
+        records_rejected = 0;
+        records_reclaimed = 0;
+        segments_reclaimed = 0;
+        erases = 0;
+        erase_stalls = 0;
+        torn_records = 0;
+        crc_errors = 0;
+        payload_bytes = 0;
+        bytes_written = 0;
+        bytes_erased = 0;
+    }
+};
+
+/**
+ * @brief Location of one record; stays valid until its segment is reclaimed
+ */
+struct RecordInfo {
+    size_t segment = 0;
+    uint32_t generation = 0;      // Segment generation when looked up
+    size_t offset = 0;            // Record header, relative to the segment
+    uint32_t size = 0;            // Payload bytes
+    uint32_t sequence = 0;
+    int64_t timestamp_us = 0;
+};
+
+/**
+ * @brief Window of another IBlockStorage, so one partition can hold
+ *        several stores
+ *
+ * offset and size must be multiples of the parent's erase size.
+ */
+class BlockStorageRegion : public interfaces::IBlockStorage {
+public:
+    BlockStorageRegion(interfaces::IBlockStorage& parent, size_t offset, size_t size)
+        : parent_(parent), offset_(offset), size_(size) {}
+
+    size_t size() const override { return size_; }
+    size_t erase_size() const override { return parent_.erase_size(); }
+
+    bool read(size_t offset, void* out, size_t size) override {
+        return offset + size <= size_ && parent_.read(offset_ + offset, out, size);
+    }
+    bool write(size_t offset, const void* data, size_t size) override {
+        return offset + size <= size_ && parent_.write(offset_ + offset, data, size);
+    }
+    bool erase(size_t offset, size_t size) override {
+        return offset + size <= size_ && parent_.erase(offset_ + offset, size);
+    }
+
+private:
+    interfaces::IBlockStorage& parent_;
+    size_t offset_;
+    size_t size_;
+};
+
+/**
+ * @brief Append-only circular record log over an IBlockStorage
+ *
+ * Usage:
+ *   SegmentStore store(flash);
+ *   store.mount(config);                  // Recovers whatever is on the medium
+ *   store.append(jpeg, size, timestamp);  // Recorder task
+ *   store.service();                      // When idle: erase ahead
+ *   store.find_time(t, &rec); store.read(rec, buf, cap);
+ */
+class SegmentStore {
+public:
+    explicit SegmentStore(interfaces::IBlockStorage& storage) : storage_(storage) {}
+    ~SegmentStore() { unmount(); }
+
+    // Non-copyable
+    SegmentStore(const SegmentStore&) = delete;
+    SegmentStore& operator=(const SegmentStore&) = delete;
+
+    /**
+     * @brief Index the medium, recovering from any interrupted write
+     * @return false on invalid geometry, allocation or read failure
+     */
+    bool mount(const SegmentStoreConfig& config) {
+        if (mounted_) return true;
+        size_t erase = storage_.erase_size();
+        if (erase == 0 || config.segment_size == 0 || config.segment_size % erase != 0) return false;
+        if (config.segment_size <= SEGMENT_HEADER_SIZE + RECORD_HEADER_SIZE) return false;
+        size_t count = storage_.size() / config.segment_size;
+        if (count < 2 || config.spare_segments == 0 || config.spare_segments >= count) return false;
+
+        segments_ = new (std::nothrow) Segment[count];
+        order_ = new (std::nothrow) size_t[count];
+        if (!segments_ || !order_) {
+            unmount();
+            return false;
+        }
+        config_ = config;
+        segment_count_ = count;
+
+#ifdef ESP_PLATFORM
+        mutex_ = xSemaphoreCreateMutex();
+        if (!mutex_) {
+            unmount();
+            return false;
+        }
+#endif
+
+        if (!recover()) {
+            unmount();
+            return false;
+        }
+        mounted_ = true;
+        return true;
+    }
+
+    void unmount() {
+        delete[] segments_;
+        segments_ = nullptr;
+        delete[] order_;
+        order_ = nullptr;
+#ifdef ESP_PLATFORM
+        if (mutex_) {
+            vSemaphoreDelete(mutex_);
+            mutex_ = nullptr;
+        }
+#endif
+        segment_count_ = 0;
+        order_head_ = 0;
+        order_count_ = 0;
+        head_ = NONE;
+        next_generation_ = 1;
+        last_sequence_ = 0;
+        last_timestamp_us_ = 0;
+        mounted_ = false;
+    }
+
+    /**
+     * @brief Append one record, opening (and if needed reclaiming) the next
+     *        segment when the current one is full
+     * @param timestamp_us Must not be earlier than the newest record
+     * @return Assigned sequence (continues across mounts), 0 on failure
+     */
+    uint32_t append(const uint8_t* data, size_t size, int64_t timestamp_us) {
+        if (!mounted_ || !data || size == 0) return 0;
+        lock();
+        if (size > max_record_size() ||
+            (last_sequence_ != 0 && timestamp_us < last_timestamp_us_)) {
+            unlock();
+            stats_.records_rejected++;
+            return 0;
+        }
+
+        size_t need = RECORD_HEADER_SIZE + size;
+        if (head_ == NONE || segments_[head_].write_offset + need > config_.segment_size) {
+            if (!open_next_segment()) {
+                unlock();
+                stats_.records_rejected++;
+                return 0;
+            }
+        }
+        Segment& seg = segments_[head_];
+        uint32_t sequence = last_sequence_ + 1;
+        uint8_t header[RECORD_HEADER_SIZE];
+        encode_record_header(header, static_cast<uint32_t>(size), sequence, timestamp_us,
+                             crc32(data, size));
+
+        // Header first: a cut inside the payload leaves a header whose CRC
+        // check fails, a cut inside the header leaves non-blank bytes
+        size_t at = base(head_) + seg.write_offset;
+        bool ok = storage_.write(at, header, sizeof(header)) &&
+                  storage_.write(at + sizeof(header), data, size);
+        size_t end = align4(seg.write_offset + need);
+        if (!ok) {
+            // Whatever was programmed cannot be reused: seal the segment
+            seg.write_offset = config_.segment_size;
+            unlock();
+            stats_.records_rejected++;
+            return 0;
+        }
+        if (seg.records == 0) {
+            seg.first_sequence = sequence;
+            seg.first_timestamp_us = timestamp_us;
+        }
+        seg.records++;
+        seg.last_sequence = sequence;
+        seg.last_timestamp_us = timestamp_us;
+        seg.write_offset = end > config_.segment_size ? config_.segment_size : end;
+        last_sequence_ = sequence;
+        last_timestamp_us_ = timestamp_us;
+        unlock();
+
+        stats_.records_appended++;
+        stats_.payload_bytes += size;
+        stats_.bytes_written += need;
+        return sequence;
+    }
+
+    /**
+     * @brief Erase one segment ahead of the write head if one is due
+     * @return true if an erase was done (call again until false)
+     */
+    bool service() {
+        if (!mounted_) return false;
+        lock();
+        size_t start = head_ == NONE ? segment_count_ - 1 : head_;
+        bool worked = false;
+        for (size_t k = 1; k <= config_.spare_segments && !worked; k++) {
+            size_t s = (start + k) % segment_count_;
+            if (segments_[s].state == State::Ready) continue;
+            worked = prepare(s);
+        }
+        unlock();
+        return worked;
+    }
+
+    /**
+     * @brief First record with timestamp >= timestamp_us (the oldest record
+     *        if timestamp_us precedes the log)
+     * @return false if the log is empty or every record is older
+     */
+    bool find_time(int64_t timestamp_us, RecordInfo* out) {
+        if (!mounted_ || !out) return false;
+        lock();
+        // First segment (in log order) whose newest record is late enough
+        size_t lo = 0, hi = order_count_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (segments_[order_at(mid)].last_timestamp_us < timestamp_us) lo = mid + 1;
+            else hi = mid;
+        }
+        bool found = false;
+        for (; lo < order_count_ && !found; lo++) {   // Past empty (sealed) segments
+            RecordInfo rec;
+            for (bool ok = first_record(order_at(lo), &rec); ok; ok = next_in_segment(rec, &rec)) {
+                if (rec.timestamp_us >= timestamp_us) {
+                    *out = rec;
+                    found = true;
+                    break;
+                }
+            }
+        }
+        unlock();
+        return found;
+    }
+
+    /**
+     * @brief Record following prev; skips ahead to the oldest record if
+     *        prev's segment was reclaimed meanwhile
+     */
+    bool next_after(const RecordInfo& prev, RecordInfo* out) {
+        if (!mounted_ || !out) return false;
+        lock();
+        bool found;
+        if (prev.segment >= segment_count_ || !holds(prev.segment, prev.generation)) {
+            found = oldest_locked(out);
+            if (found && out->sequence <= prev.sequence) found = false;
+        } else if (next_in_segment(prev, out)) {
+            found = true;
+        } else {
+            found = false;
+            for (size_t i = 0; i + 1 < order_count_; i++) {
+                if (order_at(i) == prev.segment) {
+                    found = first_record(order_at(i + 1), out);
+                    break;
+                }
+            }
+        }
+        unlock();
+        return found;
+    }
+
+    bool oldest(RecordInfo* out) {
+        if (!mounted_ || !out) return false;
+        lock();
+        bool found = oldest_locked(out);
+        unlock();
+        return found;
+    }
+
+    /**
+     * @brief Copy a record's payload out, verifying its CRC
+     * @return Payload size, or 0 if reclaimed, too large for out, or corrupt
+     */
+    size_t read(const RecordInfo& rec, uint8_t* out, size_t capacity) {
+        if (!mounted_ || !out || rec.size > capacity) return 0;
+        lock();
+        size_t n = 0;
+        RecordInfo current;
+        if (rec.segment < segment_count_ && holds(rec.segment, rec.generation) &&
+            read_record_header(rec.segment, rec.offset, &current) &&
+            current.sequence == rec.sequence &&
+            storage_.read(base(rec.segment) + rec.offset + RECORD_HEADER_SIZE, out, rec.size)) {
+            if (crc32(out, rec.size) == current_crc_) {
+                n = rec.size;
+            } else {
+                stats_.crc_errors++;
+            }
+        }
+        unlock();
+        return n;
+    }
+
+    // --- Introspection ----------------------------------------------------
+
+    size_t max_record_size() const {
+        return config_.segment_size - SEGMENT_HEADER_SIZE - RECORD_HEADER_SIZE;
+    }
+    size_t segment_count() const { return segment_count_; }
+
+    // Segments holding records, oldest first
+    size_t data_segments() {
+        lock();
+        size_t n = order_count_;
+        unlock();
+        return n;
+    }
+
+    // Segments erased and ready to be opened
+    size_t ready_segments() {
+        lock();
+        size_t n = 0;
+        for (size_t s = 0; s < segment_count_; s++) {
+            if (segments_[s].state == State::Ready) n++;
+        }
+        unlock();
+        return n;
+    }
+
+    uint32_t record_count() {
+        lock();
+        uint32_t n = 0;
+        for (size_t i = 0; i < order_count_; i++) n += segments_[order_at(i)].records;
+        unlock();
+        return n;
+    }
+
+    uint32_t newest_sequence() const { return last_sequence_; }
+    int64_t newest_timestamp_us() const { return last_timestamp_us_; }
+    const SegmentStoreStats& stats() const { return stats_; }
+    const SegmentStoreConfig& config() const { return config_; }
+    bool is_mounted() const { return mounted_; }
+
+private:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    enum class State : uint8_t {
+        Unknown,   // No valid header; blank-checked before use
+        Dirty,     // Holds stale bytes; must be erased
+        Ready,     // Erased
+        Data,      // Has a header (and maybe records)
+    };
+
+    struct Segment {
+        State state = State::Unknown;
+        uint32_t generation = 0;
+        uint32_t records = 0;
+        uint32_t first_sequence = 0;
+        uint32_t last_sequence = 0;
+        int64_t first_timestamp_us = 0;
+        int64_t last_timestamp_us = 0;
+        size_t write_offset = 0;   // Next record position
+    };
+
+    // --- Encoding (little-endian) -----------------------------------------
+
+    static void put32(uint8_t* p, uint32_t v) {
+        for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+    static void put64(uint8_t* p, uint64_t v) {
+        for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+    static uint32_t get32(const uint8_t* p) {
+        uint32_t v = 0;
+        for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+        return v;
+    }
+    static uint64_t get64(const uint8_t* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+        return v;
+    }
+    static size_t align4(size_t v) { return (v + 3) & ~static_cast<size_t>(3); }
+
+    static void encode_record_header(uint8_t* h, uint32_t size, uint32_t sequence,
+                                     int64_t timestamp_us, uint32_t payload_crc) {
+        put32(h, RECORD_MAGIC);
+        put32(h + 4, size);
+        put32(h + 8, sequence);
+        put64(h + 12, static_cast<uint64_t>(timestamp_us));
+        put32(h + 20, payload_crc);
+        put32(h + 24, crc32(h, 24));
+    }
+
+    static bool is_blank(const uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            if (p[i] != 0xFF) return false;
+        }
+        return true;
+    }
+
+    // --- Locking ------------------------------------------------------------
+
+    void lock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+        mutex_.lock();
+#endif
+    }
+
+    void unlock() {
+#ifdef ESP_PLATFORM
+        xSemaphoreGive(mutex_);
+#else
+        mutex_.unlock();
+#endif
+    }
+
+    // --- Index (under lock) -----------------------------------------------
+
+    size_t base(size_t s) const { return s * config_.segment_size; }
+    size_t order_at(size_t i) const { return order_[(order_head_ + i) % segment_count_]; }
+
+    bool holds(size_t s, uint32_t generation) const {
+        return segments_[s].state == State::Data && segments_[s].generation == generation;
+    }
+
+    // Header at offset; also leaves its payload CRC in current_crc_
+    bool read_record_header(size_t s, size_t offset, RecordInfo* out) {
+        if (offset + RECORD_HEADER_SIZE > config_.segment_size) return false;
+        uint8_t h[RECORD_HEADER_SIZE];
+        if (!storage_.read(base(s) + offset, h, sizeof(h))) return false;
+        if (get32(h) != RECORD_MAGIC || get32(h + 24) != crc32(h, 24)) return false;
+        uint32_t size = get32(h + 4);
+        if (size == 0 || offset + RECORD_HEADER_SIZE + size > config_.segment_size) return false;
+        out->segment = s;
+        out->generation = segments_[s].generation;
+        out->offset = offset;
+        out->size = size;
+        out->sequence = get32(h + 8);
+        out->timestamp_us = static_cast<int64_t>(get64(h + 12));
+        current_crc_ = get32(h + 20);
+        return true;
+    }
+
+    bool first_record(size_t s, RecordInfo* out) {
+        if (segments_[s].records == 0) return false;
+        return read_record_header(s, SEGMENT_HEADER_SIZE, out);
+    }
+
+    bool next_in_segment(const RecordInfo& prev, RecordInfo* out) {
+        size_t next = align4(prev.offset + RECORD_HEADER_SIZE + prev.size);
+        if (next >= segments_[prev.segment].write_offset) return false;
+        return read_record_header(prev.segment, next, out);
+    }
+
+    bool oldest_locked(RecordInfo* out) {
+        for (size_t i = 0; i < order_count_; i++) {
+            if (first_record(order_at(i), out)) return true;
+        }
+        return false;
+    }
+
+    void reclaim(size_t s) {
+        // Normally the oldest segment (circular order); anywhere after odd recoveries
+        for (size_t i = 0; i < order_count_; i++) {
+            if (order_at(i) != s) continue;
+            for (size_t j = i; j > 0; j--) {
+                order_[(order_head_ + j) % segment_count_] = order_at(j - 1);
+            }
+            order_head_ = (order_head_ + 1) % segment_count_;
+            order_count_--;
+            break;
+        }
+        stats_.records_reclaimed += segments_[s].records;
+        stats_.segments_reclaimed++;
+        segments_[s] = Segment{};
+        segments_[s].state = State::Dirty;
+    }
+
+    // Bring segment s to Ready (blank-check or erase); true if it erased
+    bool prepare(size_t s) {
+        Segment& seg = segments_[s];
+        if (seg.state == State::Data) reclaim(s);
+        if (seg.state == State::Unknown) {
+            seg.state = blank(s) ? State::Ready : State::Dirty;
+        }
+        if (seg.state != State::Dirty) return false;
+        if (!storage_.erase(base(s), config_.segment_size)) return false;
+        stats_.erases++;
+        stats_.bytes_erased += config_.segment_size;
+        seg.state = State::Ready;
+        return true;
+    }
+
+    bool blank(size_t s) {
+        uint8_t buf[256];
+        for (size_t off = 0; off < config_.segment_size; off += sizeof(buf)) {
+            size_t n = config_.segment_size - off < sizeof(buf) ? config_.segment_size - off : sizeof(buf);
+            if (!storage_.read(base(s) + off, buf, n) || !is_blank(buf, n)) return false;
+        }
+        return true;
+    }
+
+    bool open_next_segment() {
+        size_t s = head_ == NONE ? 0 : (head_ + 1) % segment_count_;
+        if (segments_[s].state != State::Ready) {
+            if (prepare(s)) stats_.erase_stalls++;
+            if (segments_[s].state != State::Ready) return false;
+        }
+        uint8_t h[SEGMENT_HEADER_SIZE];
+        uint32_t generation = next_generation_++;
+        put32(h, SEGMENT_MAGIC);
+        put32(h + 4, generation);
+        put32(h + 8, static_cast<uint32_t>(config_.segment_size));
+        put32(h + 12, crc32(h, 12));
+        Segment& seg = segments_[s];
+        if (!storage_.write(base(s), h, sizeof(h))) {
+            seg.state = State::Dirty;
+            return false;
+        }
+        stats_.bytes_written += sizeof(h);
+        seg = Segment{};
+        seg.state = State::Data;
+        seg.generation = generation;
+        seg.write_offset = SEGMENT_HEADER_SIZE;
+        seg.first_timestamp_us = last_timestamp_us_;   // Keeps segment ranges ordered while empty
+        seg.last_timestamp_us = last_timestamp_us_;
+        order_[(order_head_ + order_count_) % segment_count_] = s;
+        order_count_++;
+        head_ = s;
+        return true;
+    }
+
+    // --- Mount ----------------------------------------------------------------
+
+    bool recover() {
+        // Segment headers
+        for (size_t s = 0; s < segment_count_; s++) {
+            uint8_t h[SEGMENT_HEADER_SIZE];
+            if (!storage_.read(base(s), h, sizeof(h))) return false;
+            Segment& seg = segments_[s];
+            seg = Segment{};
+            if (get32(h) == SEGMENT_MAGIC && get32(h + 12) == crc32(h, 12) &&
+                get32(h + 8) == config_.segment_size) {
+                seg.state = State::Data;
+                seg.generation = get32(h + 4);
+            } else {
+                seg.state = is_blank(h, sizeof(h)) ? State::Unknown : State::Dirty;
+            }
+        }
+
+        // Log order: by generation, which also is circular order from the
+        // oldest data segment
+        order_count_ = 0;
+        order_head_ = 0;
+        for (size_t s = 0; s < segment_count_; s++) {
+            if (segments_[s].state != State::Data) continue;
+            size_t i = order_count_++;
+            while (i > 0 && segments_[order_[i - 1]].generation > segments_[s].generation) {
+                order_[i] = order_[i - 1];
+                i--;
+            }
+            order_[i] = s;
+        }
+        head_ = order_count_ ? order_[order_count_ - 1] : NONE;
+        next_generation_ = head_ == NONE ? 1 : segments_[head_].generation + 1;
+
+        for (size_t i = 0; i < order_count_; i++) {
+            Segment& seg = segments_[order_[i]];
+            if (i > 0) {
+                seg.first_timestamp_us = segments_[order_[i - 1]].last_timestamp_us;
+                seg.last_timestamp_us = seg.first_timestamp_us;
+            }
+            if (!scan_segment(order_[i], order_[i] == head_)) return false;
+        }
+        if (head_ != NONE) {
+            last_sequence_ = segments_[head_].records ? segments_[head_].last_sequence : 0;
+            last_timestamp_us_ = segments_[head_].last_timestamp_us;
+            for (size_t i = order_count_; i-- > 0 && last_sequence_ == 0;) {
+                if (segments_[order_[i]].records) {
+                    last_sequence_ = segments_[order_[i]].last_sequence;
+                    last_timestamp_us_ = segments_[order_[i]].last_timestamp_us;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Summarize a segment from its record headers; the head segment's
+    // payloads are CRC-checked and a torn tail seals it
+    bool scan_segment(size_t s, bool is_head) {
+        Segment& seg = segments_[s];
+        size_t offset = SEGMENT_HEADER_SIZE;
+        RecordInfo rec;
+        uint8_t chunk[256];
+        while (read_record_header(s, offset, &rec)) {
+            if (is_head && !payload_intact(rec, chunk, sizeof(chunk))) break;
+            if (seg.records == 0) {
+                seg.first_sequence = rec.sequence;
+                seg.first_timestamp_us = rec.timestamp_us;
+            }
+            seg.records++;
+            seg.last_sequence = rec.sequence;
+            seg.last_timestamp_us = rec.timestamp_us;
+            offset = align4(offset + RECORD_HEADER_SIZE + rec.size);
+            if (offset >= config_.segment_size) break;
+        }
+        seg.write_offset = offset < config_.segment_size ? offset : config_.segment_size;
+
+        if (is_head && seg.write_offset < config_.segment_size) {
+            // Blank where the next header goes, or something was cut off
+            size_t n = config_.segment_size - seg.write_offset;
+            if (n > RECORD_HEADER_SIZE) n = RECORD_HEADER_SIZE;
+            uint8_t h[RECORD_HEADER_SIZE];
+            if (!storage_.read(base(s) + seg.write_offset, h, n)) return false;
+            if (!is_blank(h, n)) {
+                stats_.torn_records++;
+                seg.write_offset = config_.segment_size;
+            }
+        }
+        return true;
+    }
+
+    bool payload_intact(const RecordInfo& rec, uint8_t* chunk, size_t chunk_size) {
+        uint32_t expected = current_crc_;
+        uint32_t crc = 0;
+        size_t at = base(rec.segment) + rec.offset + RECORD_HEADER_SIZE;
+        for (size_t done = 0; done < rec.size;) {
+            size_t n = rec.size - done < chunk_size ? rec.size - done : chunk_size;
+            if (!storage_.read(at + done, chunk, n)) return false;
+            crc = crc32_update(crc, chunk, n);
+            done += n;
+        }
+        return crc == expected;
+    }
+
+    interfaces::IBlockStorage& storage_;
+    SegmentStoreConfig config_;
+    SegmentStoreStats stats_;
+
+    Segment* segments_ = nullptr;
+    size_t segment_count_ = 0;
+    size_t* order_ = nullptr;        // Data segments, oldest first (ring)
+    size_t order_head_ = 0;
+    size_t order_count_ = 0;
+    size_t head_ = NONE;             // Segment being written
+    uint32_t next_generation_ = 1;
+    uint32_t last_sequence_ = 0;
+    int64_t last_timestamp_us_ = 0;
+    uint32_t current_crc_ = 0;       // Payload CRC of the last header read
+    bool mounted_ = false;
+
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t mutex_ = nullptr;
+#else
+    std::mutex mutex_;
+#endif
+};
+
+} // namespace core
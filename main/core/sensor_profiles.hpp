@@ -0,0 +1,202 @@
+/**
+ * @file sensor_profiles.hpp
+ * @brief Named sensor readout profiles and frame-rate based selection
+ *
+ * Design: A profile fixes the sensor clock, the part of the pixel array read
+ * out (window) and the binning. Frame time is line_length x frame_length
+ * sensor clocks, so max_fps and latency are derived from the timing rather
+ * than maintained by hand, and the table cannot drift from them.
+ *
+ * The built-in table targets the OV2640 (ESP32-S3-EYE) at a 20 MHz XCLK,
+ * with the line/frame lengths of its UXGA, SVGA (2x2 binned) and CIF
+ * (4x4 binned) readouts. Windowed profiles read fewer lines.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include "../interfaces/i_camera.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace core {
+
+using interfaces::GrabMode;
+using interfaces::Resolution;
+using interfaces::SensorProfile;
+using interfaces::SensorWindow;
+
+static constexpr uint16_t OV2640_ARRAY_WIDTH = 1600;
+static constexpr uint16_t OV2640_ARRAY_HEIGHT = 1200;
+static constexpr uint32_t SENSOR_MIN_XCLK_HZ = 6000000;
+static constexpr uint32_t SENSOR_MAX_XCLK_HZ = 24000000;
+static constexpr uint8_t SENSOR_FRAME_BUFFERS = 2;   // Assumed for WhenEmpty latency
+
+constexpr uint16_t resolution_width(Resolution res) {
+    switch (res) {
+        case Resolution::QQVGA: return 160;
+        case Resolution::QVGA:  return 320;
+        case Resolution::VGA:   return 640;
+        case Resolution::SVGA:  return 800;
+        case Resolution::XGA:   return 1024;
+        case Resolution::HD:    return 1280;
+        case Resolution::SXGA:  return 1280;
+        case Resolution::UXGA:  return 1600;
+        default: return 640;
+    }
+}
+
+constexpr uint16_t resolution_height(Resolution res) {
+    switch (res) {
+        case Resolution::QQVGA: return 120;
+        case Resolution::QVGA:  return 240;
+        case Resolution::VGA:   return 480;
+        case Resolution::SVGA:  return 600;
+        case Resolution::XGA:   return 768;
+        case Resolution::HD:    return 720;
+        case Resolution::SXGA:  return 1024;
+        case Resolution::UXGA:  return 1200;
+        default: return 480;
+    }
+}
+
+constexpr uint32_t sensor_clock_hz(const SensorProfile& p) {
+    return p.clock_divider ? p.xclk_hz / p.clock_divider * p.pll_multiplier : 0;
+}
+
+constexpr uint32_t sensor_frame_time_us(const SensorProfile& p) {
+    return sensor_clock_hz(p)
+        ? static_cast<uint32_t>(static_cast<uint64_t>(p.line_length) * p.frame_length * 1000000ULL /
+                                sensor_clock_hz(p))
+        : 0;
+}
+
+constexpr uint8_t sensor_max_fps(const SensorProfile& p) {
+    return p.line_length && p.frame_length
+        ? static_cast<uint8_t>(sensor_clock_hz(p) / (static_cast<uint32_t>(p.line_length) * p.frame_length))
+        : 0;
+}
+
+/**
+ * @brief Worst-case end of exposure to frame in memory
+ *
+ * Readout takes one frame time. With GrabMode::Latest a finished frame
+ * waits at most one more frame; with WhenEmpty every buffer ahead of it
+ * must be consumed first.
+ */
+constexpr uint16_t sensor_latency_ms(const SensorProfile& p) {
+    uint32_t frames = p.grab_mode == GrabMode::Latest ? 2 : 1 + SENSOR_FRAME_BUFFERS;
+    return static_cast<uint16_t>((sensor_frame_time_us(p) * frames + 999) / 1000);
+}
+
+// Fill in max_fps and latency_ms from the timing fields
+constexpr SensorProfile make_sensor_profile(const char* name, Resolution resolution,
+                                            SensorWindow window, uint8_t binning,
+                                            uint16_t line_length, uint16_t frame_length,
+                                            uint8_t clock_divider = 1, uint8_t pll_multiplier = 1,
+                                            uint32_t xclk_hz = 20000000,
+                                            GrabMode grab_mode = GrabMode::Latest) {
+    SensorProfile p;
+    p.name = name;
+    p.resolution = resolution;
+    p.xclk_hz = xclk_hz;
+    p.pll_multiplier = pll_multiplier;
+    p.clock_divider = clock_divider;
+    p.window = window;
+    p.binning = binning;
+    p.grab_mode = grab_mode;
+    p.line_length = line_length;
+    p.frame_length = frame_length;
+    p.max_fps = sensor_max_fps(p);
+    p.latency_ms = sensor_latency_ms(p);
+    return p;
+}
+
+/**
+ * @brief OV2640 profiles, widest field of view first within each speed class
+ */
+inline constexpr SensorProfile OV2640_SENSOR_PROFILES[] = {
+    // Full array, every pixel
+    make_sensor_profile("uxga", Resolution::UXGA, {0, 0, 1600, 1200}, 1, 1922, 1248),
+    // 16:9 band of the array at full detail (narrower vertical field of view)
+    make_sensor_profile("hd-window", Resolution::HD, {160, 240, 1280, 720}, 1, 1922, 736),
+    // Full array, 2x2 binned
+    make_sensor_profile("svga-binned", Resolution::SVGA, {0, 0, 1600, 1200}, 2, 1190, 672),
+    make_sensor_profile("vga-binned", Resolution::VGA, {0, 0, 1600, 1200}, 2, 1190, 672),
+    // Centre 1280x960 of the array, 2x2 binned: 4:3 at 3/4 of the field of view
+    make_sensor_profile("vga-window-binned", Resolution::VGA, {160, 120, 1280, 960}, 2, 1190, 496),
+    // Full array, 4x4 binned; sensor clock halved to stay within DVP/JPEG throughput
+    make_sensor_profile("qvga-fast", Resolution::QVGA, {0, 0, 1600, 1200}, 4, 595, 336, 2),
+};
+
+static constexpr size_t OV2640_SENSOR_PROFILE_COUNT =
+    sizeof(OV2640_SENSOR_PROFILES) / sizeof(OV2640_SENSOR_PROFILES[0]);
+
+/**
+ * @brief Check a profile against the sensor's limits
+ */
+inline bool sensor_profile_valid(const SensorProfile& p,
+                                 uint16_t array_width = OV2640_ARRAY_WIDTH,
+                                 uint16_t array_height = OV2640_ARRAY_HEIGHT) {
+    if (!p.name || !p.name[0]) return false;
+    if (p.xclk_hz < SENSOR_MIN_XCLK_HZ || p.xclk_hz > SENSOR_MAX_XCLK_HZ) return false;
+    if (p.pll_multiplier < 1 || p.pll_multiplier > 2) return false;
+    if (p.clock_divider < 1 || p.clock_divider > 64) return false;
+    if (p.binning != 1 && p.binning != 2 && p.binning != 4) return false;
+
+    const SensorWindow& w = p.window;
+    if (w.width == 0 || w.height == 0) return false;
+    if (w.x + w.width > array_width || w.y + w.height > array_height) return false;
+    if ((w.x | w.y | w.width | w.height) % p.binning) return false;
+
+    // Output is scaled down from the (binned) window, never up
+    uint16_t read_w = w.width / p.binning;
+    uint16_t read_h = w.height / p.binning;
+    if (resolution_width(p.resolution) > read_w || resolution_height(p.resolution) > read_h) return false;
+    if (p.line_length < read_w || p.frame_length < read_h) return false;
+
+    return p.max_fps > 0 && p.max_fps == sensor_max_fps(p);
+}
+
+inline const SensorProfile* find_sensor_profile(const char* name,
+                                                const SensorProfile* table = OV2640_SENSOR_PROFILES,
+                                                size_t count = OV2640_SENSOR_PROFILE_COUNT) {
+    if (!name) return nullptr;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(table[i].name, name) == 0) return &table[i];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Pick the profile that reaches min_fps with the most field of view
+ *
+ * Ties go to the larger output, then the higher frame rate.
+ * @param min_resolution Smallest acceptable output (by pixel count)
+ * @return nullptr if no profile is fast enough
+ */
+inline const SensorProfile* select_sensor_profile(uint8_t min_fps, Resolution min_resolution,
+                                                  const SensorProfile* table = OV2640_SENSOR_PROFILES,
+                                                  size_t count = OV2640_SENSOR_PROFILE_COUNT) {
+    auto pixels = [](Resolution r) {
+        return static_cast<uint32_t>(resolution_width(r)) * resolution_height(r);
+    };
+    auto fov = [](const SensorProfile& p) {
+        return static_cast<uint32_t>(p.window.width) * p.window.height;
+    };
+
+    const SensorProfile* best = nullptr;
+    for (size_t i = 0; i < count; i++) {
+        const SensorProfile& p = table[i];
+        if (p.max_fps < min_fps || pixels(p.resolution) < pixels(min_resolution)) continue;
+        if (!best || fov(p) > fov(*best) ||
+            (fov(p) == fov(*best) && pixels(p.resolution) > pixels(best->resolution)) ||
+            (fov(p) == fov(*best) && pixels(p.resolution) == pixels(best->resolution) &&
+             p.max_fps > best->max_fps)) {
+            best = &p;
+        }
+    }
+    return best;
+}
+
+} // namespace core
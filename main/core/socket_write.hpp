@@ -0,0 +1,24 @@
+/**
+ * @file socket_write.hpp
+ * @brief Non-blocking socket write callback shared by the streaming senders
+ *
+ * The senders (MJPEG parts, SSE events) only ever write what the socket
+ * takes now and keep the rest themselves. On ESP32 the callback wraps
+ * httpd_socket_send(..., MSG_DONTWAIT); host tests pass simulated slow or
+ * stalled sockets.
+ *
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+
+/**
+ * @brief Non-blocking socket write
+ * @return Bytes taken (may be fewer than size), 0 if it would block, <0 if closed
+ */
+using SocketWriteFn = int32_t (*)(void* context, const uint8_t* data, size_t size);
+
+} // namespace core
@@ -0,0 +1,204 @@
+/**
+ * @file soft_jpeg_camera.hpp
+ * @brief ICamera decorator that captures raw frames and JPEG-encodes them in software
+ *
+ * Design: Wraps any ICamera configured for an uncompressed pixel format and
+ * presents it as a JPEG camera, so StreamingService, the web server and the
+ * rest of the pipeline are unchanged. The raw frame goes back to the inner
+ * camera as soon as it is encoded; the returned view points at the
+ * decorator's own output buffer (PSRAM) until release_frame().
+ *
+ * Trade-off vs the sensor's JPEG: costs CPU, but the encoder sees the raw
+ * pixels (room for masking/overlays before compression) and the quality
+ * tables are ours rather than the sensor's.
+ *
+ * Cross-platform: Pure C++, uses heap_caps on ESP32 for PSRAM.
+ */
+#pragma once
+#include "jpeg_encoder.hpp"
+#include "../interfaces/i_camera.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+namespace core {
+
+struct SoftJpegStats {
+    uint32_t frames_encoded;
+    uint32_t encode_errors;     // Raw frame rejected or output buffer too small
+    uint64_t bytes_encoded;
+};
+
+class SoftJpegCamera : public interfaces::ICamera {
+public:
+    static constexpr uint8_t DEFAULT_ENCODER_QUALITY = 80;
+
+    /**
+     * @param raw Camera to capture from (set to raw_format at init)
+     * @param max_jpeg_size Output buffer size; larger frames count as errors
+     */
+    explicit SoftJpegCamera(interfaces::ICamera& raw,
+                            PixelFormat raw_format = PixelFormat::Yuv422,
+                            size_t max_jpeg_size = 100 * 1024,
+                            bool use_psram = true)
+        : raw_(raw), raw_format_(raw_format), capacity_(max_jpeg_size), use_psram_(use_psram) {
+        encoder_.set_quality(DEFAULT_ENCODER_QUALITY);
+    }
+
+    ~SoftJpegCamera() override { deinit(); }
+
+    // Non-copyable
+    SoftJpegCamera(const SoftJpegCamera&) = delete;
+    SoftJpegCamera& operator=(const SoftJpegCamera&) = delete;
+
+    // -------------------------------------------------------------------------
+    // ICamera implementation
+    // -------------------------------------------------------------------------
+
+    bool init(const interfaces::CameraConfig& config) override {
+        if (initialized_) return true;
+        if (interfaces::pixel_format_bytes(raw_format_) == 0 || capacity_ == 0) return false;
+
+        buffer_ = static_cast<uint8_t*>(alloc(capacity_));
+        if (!buffer_) return false;
+
+        interfaces::CameraConfig raw_config = config;
+        raw_config.pixel_format = raw_format_;
+        if (!raw_.init(raw_config)) {
+            release(buffer_);
+            buffer_ = nullptr;
+            return false;
+        }
+        set_quality(config.jpeg_quality);
+        initialized_ = true;
+        return true;
+    }
+
+    void deinit() override {
+        if (!initialized_) return;
+        raw_.deinit();
+        release(buffer_);
+        buffer_ = nullptr;
+        initialized_ = false;
+    }
+
+    bool is_initialized() const override { return initialized_; }
+
+    interfaces::FrameView capture_frame() override {
+        if (!initialized_) return {};
+
+        interfaces::FrameView raw = raw_.capture_frame();
+        if (!raw.valid()) return {};
+
+        size_t size = 0;
+        if (raw.format == raw_format_ && raw.width <= UINT16_MAX && raw.height <= UINT16_MAX) {
+            size = encoder_.encode(raw.data, raw.size, static_cast<uint16_t>(raw.width),
+                                   static_cast<uint16_t>(raw.height), raw_format_,
+                                   buffer_, capacity_);
+        }
+        raw_.release_frame();
+
+        if (size == 0) {
+            encode_errors_.fetch_add(1, std::memory_order_relaxed);
+            return {};
+        }
+        frames_encoded_.fetch_add(1, std::memory_order_relaxed);
+        bytes_encoded_.fetch_add(size, std::memory_order_relaxed);
+
+        interfaces::FrameView view;
+        view.data = buffer_;
+        view.size = size;
+        view.width = raw.width;
+        view.height = raw.height;
+        view.timestamp_us = raw.timestamp_us;
+        view.format = PixelFormat::Jpeg;
+        return view;
+    }
+
+    void release_frame() override {
+        // Raw frame already returned in capture_frame(); the buffer is reused
+    }
+
+    bool reset_sensor() override { return raw_.reset_sensor(); }
+
+    bool set_resolution(interfaces::Resolution res) override { return raw_.set_resolution(res); }
+
+    /**
+     * @brief Quality on the sensor's 10-63 scale, mapped onto encoder quality 95-20
+     */
+    bool set_quality(uint8_t quality) override {
+        if (quality < 10 || quality > 63) return false;
+        quality_ = quality;
+        encoder_.set_quality(95 - (quality - 10) * 75 / 53);
+        return true;
+    }
+
+    interfaces::Resolution get_resolution() const override { return raw_.get_resolution(); }
+    uint8_t get_quality() const override { return quality_; }
+
+    bool set_profile(const interfaces::SensorProfile& profile) override {
+        return raw_.set_profile(profile);
+    }
+
+    const interfaces::SensorProfile* get_profile() const override { return raw_.get_profile(); }
+
+    bool set_exposure(const interfaces::ExposureSettings& settings) override {
+        return raw_.set_exposure(settings);
+    }
+
+    interfaces::ExposureSettings get_exposure() const override { return raw_.get_exposure(); }
+    interfaces::ExposureLimits get_exposure_limits() const override { return raw_.get_exposure_limits(); }
+
+    // -------------------------------------------------------------------------
+    // Software encoder
+    // -------------------------------------------------------------------------
+
+    // Direct control on libjpeg's 1-100 scale (overrides set_quality until the next call)
+    void set_encoder_quality(int quality) { encoder_.set_quality(quality); }
+    int encoder_quality() const { return encoder_.quality(); }
+
+    PixelFormat raw_format() const { return raw_format_; }
+
+    SoftJpegStats stats() const {
+        return {frames_encoded_.load(std::memory_order_relaxed),
+                encode_errors_.load(std::memory_order_relaxed),
+                bytes_encoded_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    void* alloc(size_t size) const {
+#ifdef ESP_PLATFORM
+        return use_psram_ ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM) : malloc(size);
+#else
+        return malloc(size);
+#endif
+    }
+
+    static void release(void* p) {
+#ifdef ESP_PLATFORM
+        heap_caps_free(p);
+#else
+        free(p);
+#endif
+    }
+
+    interfaces::ICamera& raw_;
+    PixelFormat raw_format_;
+    size_t capacity_;
+    bool use_psram_;
+    bool initialized_ = false;
+    uint8_t quality_ = 20;
+    uint8_t* buffer_ = nullptr;
+    JpegEncoder encoder_;
+
+    std::atomic<uint32_t> frames_encoded_{0};
+    std::atomic<uint32_t> encode_errors_{0};
+    std::atomic<uint64_t> bytes_encoded_{0};
+};
+
+} // namespace core
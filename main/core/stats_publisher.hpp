@@ -0,0 +1,327 @@
+/**
+ * @file stats_publisher.hpp
+ * @brief Status snapshots serialized once and fanned out as Server-Sent Events
+ *
+ * Design: The owner samples a StatusSnapshot at a fixed tick and calls
+ * publish(). A new event is produced only when a field changed and at least
+ * min_interval has passed since the last one; changes in between coalesce.
+ * Each event is serialized once (a delta against the previous event, plus a
+ * full snapshot built lazily for subscribers that are new or fell behind)
+ * and the same bytes go to every subscriber. Clients merge both forms the
+ * same way (Object.assign), so a delta is just a snapshot with fewer keys.
+ *
+ * Each subscriber is an SseSubscriber writing with non-blocking sends, so
+ * a stalled one cannot hold up the others: it keeps the unsent tail of its
+ * event, skips newer events until that is out (its next event is then a
+ * full snapshot), and is evicted after the stall budget without progress.
+ *
+ * Not thread-safe: owned by the task that sends the events.
+ * Cross-platform: Pure C++, no platform dependencies.
+ */
+#pragma once
+#include "socket_write.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace core {
+
+enum class StatusField : uint8_t {
+    Captured = 0,
+    Sent,
+    Dropped,
+    Buffered,
+    Heap,
+    Rssi,
+    Resolution,
+    Quality,
+    Streaming,  // Serialized as a JSON boolean
+    Camera,     // CameraHealth (capture_recovery.hpp), 0 = healthy
+    Count
+};
+
+static constexpr size_t STATUS_FIELD_COUNT = static_cast<size_t>(StatusField::Count);
+
+// JSON keys, in StatusField order (shared with the /status endpoint)
+static constexpr const char* STATUS_FIELD_NAMES[STATUS_FIELD_COUNT] = {
+    "captured", "sent", "dropped", "buffered", "heap",
+    "rssi", "resolution", "quality", "streaming", "camera"
+};
+
+struct StatusSnapshot {
+    int64_t values[STATUS_FIELD_COUNT] = {};
+
+    void set(StatusField f, int64_t v) { values[static_cast<size_t>(f)] = v; }
+    int64_t get(StatusField f) const { return values[static_cast<size_t>(f)]; }
+    bool operator==(const StatusSnapshot& o) const {
+        return memcmp(values, o.values, sizeof(values)) == 0;
+    }
+    bool operator!=(const StatusSnapshot& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Serialize a snapshot as a JSON object
+ * @param snap Current values
+ * @param prev If non-null, only fields that differ from prev are written
+ * @param buf Output buffer (NUL-terminated on success)
+ * @param capacity Output buffer size
+ * @return Length written, or 0 if nothing changed or the buffer is too small
+ */
+inline size_t format_status_json(const StatusSnapshot& snap, const StatusSnapshot* prev,
+                                 char* buf, size_t capacity) {
+    if (!buf || capacity < 3) return 0;
+    size_t len = 0;
+    size_t fields = 0;
+    buf[len++] = '{';
+    for (size_t i = 0; i < STATUS_FIELD_COUNT; i++) {
+        if (prev && prev->values[i] == snap.values[i]) continue;
+        int n;
+        const char* sep = fields ? "," : "";
+        if (i == static_cast<size_t>(StatusField::Streaming)) {
+            n = snprintf(buf + len, capacity - len, "%s\"%s\":%s", sep,
+                         STATUS_FIELD_NAMES[i], snap.values[i] ? "true" : "false");
+        } else {
+            n = snprintf(buf + len, capacity - len, "%s\"%s\":%lld", sep,
+                         STATUS_FIELD_NAMES[i], static_cast<long long>(snap.values[i]));
+        }
+        if (n < 0 || static_cast<size_t>(n) >= capacity - len) return 0;
+        len += static_cast<size_t>(n);
+        fields++;
+    }
+    if (fields == 0 && prev) return 0;
+    if (len + 2 > capacity) return 0;
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
+
+struct StatsPublisherStats {
+    uint32_t samples = 0;          // publish() calls
+    uint32_t events = 0;           // New versions produced
+    uint32_t serializations = 0;   // JSON bodies built (delta + full)
+};
+
+/**
+ * @brief Rate-capped, change-driven SSE event source
+ *
+ * Usage (sender task):
+ *   publisher.publish(sample_status(), clock.now_us());
+ *   for (auto& sub : subscribers) {
+ *       if (sub.seen != publisher.version()) {
+ *           size_t len; const char* ev = publisher.event_for(sub.seen, &len);
+ *           send(sub, ev, len);
+ *           sub.seen = publisher.version();
+ *       }
+ *   }
+ */
+class StatsPublisher {
+public:
+    static constexpr size_t MAX_EVENT_SIZE = 384;
+    static constexpr int64_t DEFAULT_MIN_INTERVAL_US = 500 * 1000;
+
+    explicit StatsPublisher(int64_t min_interval_us = DEFAULT_MIN_INTERVAL_US)
+        : min_interval_us_(min_interval_us) {}
+
+    // Non-copyable
+    StatsPublisher(const StatsPublisher&) = delete;
+    StatsPublisher& operator=(const StatsPublisher&) = delete;
+
+    void set_min_interval_us(int64_t us) { min_interval_us_ = us; }
+
+    /**
+     * @brief Offer a new sample
+     * @return true if a new event version was produced
+     */
+    bool publish(const StatusSnapshot& snap, int64_t now_us) {
+        stats_.samples++;
+        if (version_ != 0) {
+            if (snap == current_) return false;
+            if (now_us - last_publish_us_ < min_interval_us_) return false;
+        }
+
+        size_t len = format_status_json(snap, version_ ? &current_ : nullptr,
+                                        delta_json_, sizeof(delta_json_));
+        if (len == 0) return false;
+        stats_.serializations++;
+
+        current_ = snap;
+        version_++;
+        last_publish_us_ = now_us;
+        delta_len_ = frame_event(delta_json_, len, delta_event_, sizeof(delta_event_));
+        full_len_ = 0;  // Rebuilt on demand
+        stats_.events++;
+        return true;
+    }
+
+    /**
+     * @brief Event text for a subscriber that last saw seen_version
+     * @param seen_version 0 for a new subscriber
+     * @param len Output: event length
+     * @return Shared event bytes (valid until the next publish), or nullptr if up to date
+     * @note A subscriber exactly one version behind gets the delta; anyone else
+     *       gets a full snapshot.
+     */
+    const char* event_for(uint32_t seen_version, size_t* len) {
+        if (!len || version_ == 0 || seen_version == version_) return nullptr;
+        if (seen_version + 1 == version_ && seen_version != 0) {
+            *len = delta_len_;
+            return delta_event_;
+        }
+        if (full_len_ == 0) {
+            char json[MAX_EVENT_SIZE];
+            size_t n = format_status_json(current_, nullptr, json, sizeof(json));
+            if (n == 0) return nullptr;
+            stats_.serializations++;
+            full_len_ = frame_event(json, n, full_event_, sizeof(full_event_));
+        }
+        *len = full_len_;
+        return full_event_;
+    }
+
+    // SSE comment line, sent on idle connections so proxies keep them open
+    static const char* keepalive(size_t* len) {
+        static constexpr char KEEPALIVE[] = ": keepalive\n\n";
+        *len = sizeof(KEEPALIVE) - 1;
+        return KEEPALIVE;
+    }
+
+    uint32_t version() const { return version_; }
+    const StatusSnapshot& current() const { return current_; }
+    const StatsPublisherStats& stats() const { return stats_; }
+
+private:
+    size_t frame_event(const char* json, size_t json_len, char* out, size_t capacity) const {
+        int n = snprintf(out, capacity, "id: %lu\nevent: status\ndata: %.*s\n\n",
+                         static_cast<unsigned long>(version_), static_cast<int>(json_len), json);
+        if (n < 0 || static_cast<size_t>(n) >= capacity) return 0;
+        return static_cast<size_t>(n);
+    }
+
+    int64_t min_interval_us_;
+    int64_t last_publish_us_ = 0;
+    uint32_t version_ = 0;
+    StatusSnapshot current_;
+    StatsPublisherStats stats_;
+
+    char delta_json_[MAX_EVENT_SIZE] = {};
+    char delta_event_[MAX_EVENT_SIZE + 48] = {};
+    char full_event_[MAX_EVENT_SIZE + 48] = {};
+    size_t delta_len_ = 0;
+    size_t full_len_ = 0;
+};
+
+enum class SseSend : uint8_t {
+    Idle = 0,     // Up to date, nothing due
+    Sent = 1,     // Event or keepalive fully handed to the socket
+    Blocked = 2,  // Socket full: the rest waits for the next service()
+    Closed = 3,   // Socket error: drop the subscriber
+    Evicted = 4   // No progress for the stall budget: drop the subscriber
+};
+
+/**
+ * @brief One SSE subscriber, written with non-blocking sends
+ *
+ * Usage (sender task, once per tick):
+ *   sub.begin(write, socket, head, now_us, stall_budget_ms);   // Response head
+ *   publisher.publish(sample_status(), now_us);
+ *   SseSend r = sub.service(publisher, now_us, keepalive_us);
+ *   if (r == SseSend::Closed || r == SseSend::Evicted) drop(sub);
+ */
+class SseSubscriber {
+public:
+    static constexpr size_t MAX_PENDING = StatsPublisher::MAX_EVENT_SIZE + 48;
+
+    /**
+     * @brief Start a subscriber; head (response head + preamble) goes out first
+     * @return false if head does not fit MAX_PENDING
+     */
+    bool begin(SocketWriteFn write, void* context, const char* head, int64_t now_us,
+               uint32_t stall_budget_ms) {
+        size_t len = head ? strlen(head) : 0;
+        if (!write || len > sizeof(pending_)) return false;
+        write_ = write;
+        context_ = context;
+        memcpy(pending_, head, len);
+        pending_len_ = len;
+        pending_pos_ = 0;
+        seen_version_ = 0;
+        last_send_us_ = now_us;
+        last_progress_us_ = now_us;
+        stall_budget_us_ = static_cast<int64_t>(stall_budget_ms) * 1000;
+        events_skipped_ = 0;
+        return true;
+    }
+
+    /**
+     * @brief Write what is due (never waits)
+     * @param keepalive_us Idle time after which a keepalive comment is sent
+     */
+    SseSend service(StatsPublisher& publisher, int64_t now_us, int64_t keepalive_us) {
+        bool flushed = false;
+        if (pending_pos_ < pending_len_) {
+            SseSend r = flush(now_us);
+            if (r != SseSend::Sent) {
+                if (r == SseSend::Blocked && seen_version_ != publisher.version() &&
+                    skipped_version_ != publisher.version()) {
+                    skipped_version_ = publisher.version();
+                    events_skipped_++;
+                }
+                return r;
+            }
+            flushed = true;
+        }
+
+        size_t len = 0;
+        const char* event = publisher.event_for(seen_version_, &len);
+        if (event) {
+            seen_version_ = publisher.version();
+        } else {
+            if (now_us - last_send_us_ < keepalive_us) {
+                return flushed ? SseSend::Sent : SseSend::Idle;
+            }
+            event = StatsPublisher::keepalive(&len);
+        }
+        if (len > sizeof(pending_)) return SseSend::Closed;
+        memcpy(pending_, event, len);
+        pending_len_ = len;
+        pending_pos_ = 0;
+        last_send_us_ = now_us;
+        last_progress_us_ = now_us;   // The stall budget runs from the first refused write
+        return flush(now_us);
+    }
+
+    uint32_t seen_version() const { return seen_version_; }
+    uint32_t events_skipped() const { return events_skipped_; }
+    bool pending() const { return pending_pos_ < pending_len_; }
+
+private:
+    SseSend flush(int64_t now_us) {
+        while (pending_pos_ < pending_len_) {
+            int32_t n = write_(context_, reinterpret_cast<const uint8_t*>(pending_) + pending_pos_,
+                               pending_len_ - pending_pos_);
+            if (n < 0) return SseSend::Closed;
+            if (n == 0) {
+                return now_us - last_progress_us_ >= stall_budget_us_ ? SseSend::Evicted
+                                                                        : SseSend::Blocked;
+            }
+            pending_pos_ += static_cast<size_t>(n);
+            last_progress_us_ = now_us;
+        }
+        return SseSend::Sent;
+    }
+
+    SocketWriteFn write_ = nullptr;
+    void* context_ = nullptr;
+    char pending_[MAX_PENDING] = {};   // Event (or head) in flight: copied, the publisher's
+    size_t pending_len_ = 0;           // buffers change on the next publish()
+    size_t pending_pos_ = 0;
+    uint32_t seen_version_ = 0;        // Last version queued
+    uint32_t skipped_version_ = 0;
+    uint32_t events_skipped_ = 0;      // Versions that passed while blocked
+    int64_t last_send_us_ = 0;         // Keepalive timer
+    int64_t last_progress_us_ = 0;     // Stall timer
+    int64_t stall_budget_us_ = 0;
+};
+
+} // namespace core
@@ -0,0 +1,440 @@
+/**
+ * @file stream_admission.hpp
+ * @brief Admission control for stream clients from measured capacity
+ *
+ * A fixed client limit is either too strict (one viewer) or no limit at all
+ * until the link or the heap gives out. StreamAdmission decides each new
+ * stream from what the device is doing right now:
+ *
+ *   EgressMeter ── egress B/s, mean frame size, mean frame send time ──┐
+ *   RSSI → link_estimate_Bps() ── link B/s ────────────────────────────┤→ decide() → Accept
+ *   free heap, open streams, source FPS ───────────────────────────────┘             Degrade (lower FPS)
+ *                                                                                    Reject (Retry-After)
+ *
+ * The FPS a new client can have is the lowest of:
+ * - the source rate,
+ * - the link budget (link_share_pct of the estimate) left over by current
+ *   streams, divided by the mean frame size. Current streams count at the
+ *   larger of the measured egress and the rates admitted so far (release()d
+ *   when a stream ends): the measurement lags new streams by its window, so
+ *   it alone would let a burst of clients in at once. With priority ranks
+ *   (EgressScheduler classes under the strict policy) only streams ranked
+ *   at or above the new one count, since the scheduler takes what it needs
+ *   from those below,
+ * - 1 s divided by the mean time one frame takes to send (a worker cannot
+ *   send frames faster than that).
+ * At the source rate the client is accepted; at min_fps or more it is
+ * degraded to that rate; below it, or with the heap under min_free_heap,
+ * it is rejected and told when to retry. Before any frame has been sent
+ * there is nothing to measure and clients are accepted.
+ *
+ * decide() depends only on its inputs and the admitted rates, so synthetic
+ * load on the host gives the same answers as the device. The last inputs
+ * and verdict are kept for the /admission endpoint.
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <mutex>
+#endif
+
+namespace core {
+
+// ============================================================================
+// Egress measurement
+// ============================================================================
+
+/**
+ * @brief Bytes sent by all streams over a sliding window, and per-frame means
+ *
+ * Streams report each frame they finish (on_frame). The rate counts only
+ * whole buckets, so it is exact for synthetic time and lags by at most one
+ * bucket. Thread-safe.
+ */
+class EgressMeter {
+public:
+    static constexpr size_t BUCKETS = 8;
+    static constexpr int64_t BUCKET_US = 250000;   // 2 s window
+
+    EgressMeter() = default;
+
+    // Non-copyable
+    EgressMeter(const EgressMeter&) = delete;
+    EgressMeter& operator=(const EgressMeter&) = delete;
+
+    /**
+     * @brief A frame went out
+     * @param bytes Bytes sent for it (headers included)
+     * @param send_us First byte to last byte
+     */
+    void on_frame(size_t bytes, uint32_t send_us, int64_t now_us) {
+        int64_t epoch = now_us / BUCKET_US;
+        lock();
+        Bucket& b = buckets_[static_cast<size_t>(epoch) % SLOTS];
+        if (b.epoch != epoch) {
+            b.epoch = epoch;
+            b.bytes = 0;
+        }
+        b.bytes += bytes;
+        frame_bytes_ = ewma(frame_bytes_, static_cast<uint32_t>(bytes));
+        frame_send_us_ = ewma(frame_send_us_, send_us);
+        frames_++;
+        unlock();
+    }
+
+    /**
+     * @brief Bytes per second over the last BUCKETS whole buckets
+     */
+    uint32_t throughput_Bps(int64_t now_us) const {
+        int64_t current = now_us / BUCKET_US;
+        uint64_t total = 0;
+        lock();
+        for (const Bucket& b : buckets_) {
+            if (b.epoch < current && b.epoch >= current - static_cast<int64_t>(BUCKETS)) total += b.bytes;
+        }
+        unlock();
+        return static_cast<uint32_t>(total * 1000000 / (BUCKETS * BUCKET_US));
+    }
+
+    // Running means (1/8 weight per frame); 0 before the first frame
+    uint32_t frame_bytes() const { return frame_bytes_.load(); }
+    uint32_t frame_send_us() const { return frame_send_us_.load(); }
+    uint32_t frames() const { return frames_.load(); }
+
+    void reset() {
+        lock();
+        for (Bucket& b : buckets_) b = Bucket{};
+        frame_bytes_ = 0;
+        frame_send_us_ = 0;
+        frames_ = 0;
+        unlock();
+    }
+
+private:
+    struct Bucket {
+        int64_t epoch = -1;
+        uint64_t bytes = 0;
+    };
+    
+    // The window plus the bucket being filled, so it never overwrites one still counted
+    static constexpr size_t SLOTS = BUCKETS + 1;
+
+    uint32_t ewma(uint32_t mean, uint32_t sample) const {
+        if (frames_.load() == 0) return sample;
+        return static_cast<uint32_t>(static_cast<int64_t>(mean) +
+                                     (static_cast<int64_t>(sample) - static_cast<int64_t>(mean)) / 8);
+    }
+
+#ifdef ESP_PLATFORM
+    void lock() const { taskENTER_CRITICAL(&lock_); }
+    void unlock() const { taskEXIT_CRITICAL(&lock_); }
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+    void lock() const { mutex_.lock(); }
+    void unlock() const { mutex_.unlock(); }
+    mutable std::mutex mutex_;
+#endif
+
+    Bucket buckets_[SLOTS];
+    std::atomic<uint32_t> frame_bytes_{0};
+    std::atomic<uint32_t> frame_send_us_{0};
+    std::atomic<uint32_t> frames_{0};
+};
+
+/**
+ * @brief Usable link rate from signal strength
+ *
+ * Full nominal rate at -55 dBm or better, falling linearly to 10% at
+ * -85 dBm and below. rssi 0 (unknown) gives the nominal rate.
+ */
+inline uint32_t link_estimate_Bps(int8_t rssi, uint32_t nominal_Bps) {
+    if (rssi == 0 || rssi >= -55) return nominal_Bps;
+    if (rssi <= -85) return nominal_Bps / 10;
+    // -55 → 100%, -85 → 10%: 3% per dB
+    uint32_t pct = 100 - static_cast<uint32_t>(-55 - rssi) * 3;
+    return static_cast<uint32_t>(static_cast<uint64_t>(nominal_Bps) * pct / 100);
+}
+
+// ============================================================================
+// Admission
+// ============================================================================
+
+enum class AdmissionDecision : uint8_t { Accept, Degrade, Reject };
+
+enum class AdmissionReason : uint8_t {
+    Capacity,    // Fits at the source rate
+    Unmeasured,  // No frames sent yet: nothing to go on
+    Bandwidth,   // Link budget left by current streams
+    SendTime,    // Mean frame send time
+    Heap         // Free heap under the floor
+};
+
+inline const char* admission_decision_name(AdmissionDecision d) {
+    switch (d) {
+        case AdmissionDecision::Accept: return "accept";
+        case AdmissionDecision::Degrade: return "degrade";
+        case AdmissionDecision::Reject: return "reject";
+    }
+    return "unknown";
+}
+
+inline const char* admission_reason_name(AdmissionReason r) {
+    switch (r) {
+        case AdmissionReason::Capacity: return "capacity";
+        case AdmissionReason::Unmeasured: return "unmeasured";
+        case AdmissionReason::Bandwidth: return "bandwidth";
+        case AdmissionReason::SendTime: return "send_time";
+        case AdmissionReason::Heap: return "heap";
+    }
+    return "unknown";
+}
+
+struct AdmissionConfig {
+    uint8_t link_share_pct = 75;        // Share of the link estimate streams may use
+    uint32_t min_free_heap = 32 * 1024; // Reject below this
+    uint8_t min_fps = 1;                // Degrade no lower; reject instead
+    uint32_t retry_after_s = 10;        // Retry-After on reject
+};
+
+/**
+ * @brief What the decision is based on (sampled by the caller)
+ */
+struct AdmissionInputs {
+    uint32_t egress_Bps = 0;      // EgressMeter::throughput_Bps()
+    uint32_t frame_bytes = 0;     // EgressMeter::frame_bytes()
+    uint32_t frame_send_us = 0;   // EgressMeter::frame_send_us()
+    uint32_t link_Bps = 0;        // link_estimate_Bps() (0 = no bandwidth check)
+    uint32_t free_heap = 0;
+    uint32_t clients = 0;         // Streams already open
+    uint8_t fps = 0;              // Source frame rate
+    uint8_t rank = 0;             // Priority (0 = highest): streams ranked below do not count
+};
+
+struct AdmissionVerdict {
+    AdmissionDecision decision = AdmissionDecision::Accept;
+    AdmissionReason reason = AdmissionReason::Capacity;
+    uint8_t fps = 0;               // Rate to serve (Accept: source rate)
+    uint32_t retry_after_s = 0;    // Reject only
+};
+
+/**
+ * @brief Statistics and the last decision with its inputs (thread-safe reads)
+ */
+struct AdmissionStats {
+    std::atomic<uint32_t> accepted{0};
+    std::atomic<uint32_t> degraded{0};
+    std::atomic<uint32_t> rejected{0};
+    std::atomic<uint32_t> rejected_heap{0};
+    std::atomic<uint32_t> rejected_capacity{0};   // Bandwidth or send time
+    std::atomic<uint32_t> reserved_fps{0};        // Admitted rates of open streams
+    // Last decision
+    std::atomic<uint8_t> last_decision{0};        // AdmissionDecision
+    std::atomic<uint8_t> last_reason{0};          // AdmissionReason
+    std::atomic<uint8_t> last_fps{0};
+    std::atomic<uint32_t> last_egress_Bps{0};
+    std::atomic<uint32_t> last_link_Bps{0};
+    std::atomic<uint32_t> last_frame_bytes{0};
+    std::atomic<uint32_t> last_frame_send_us{0};
+    std::atomic<uint32_t> last_free_heap{0};
+    std::atomic<uint32_t> last_clients{0};
+    std::atomic<uint32_t> last_reserved_Bps{0};   // reserved_fps x frame size at the decision
+
+    void reset() {
+        accepted = 0;
+        degraded = 0;
+        rejected = 0;
+        rejected_heap = 0;
+        rejected_capacity = 0;
+        reserved_fps = 0;
+        last_decision = 0;
+        last_reason = 0;
+        last_fps = 0;
+        last_egress_Bps = 0;
+        last_link_Bps = 0;
+        last_frame_bytes = 0;
+        last_frame_send_us = 0;
+        last_free_heap = 0;
+        last_clients = 0;
+        last_reserved_Bps = 0;
+    }
+};
+
+/**
+ * @brief Decides new stream clients from measured capacity
+ *
+ * Usage:
+ *   AdmissionInputs in;
+ *   in.egress_Bps = meter.throughput_Bps(now);
+ *   ...
+ *   AdmissionVerdict v = admission.decide(in);
+ *   if (v.decision == AdmissionDecision::Reject) { 503 + Retry-After: v.retry_after_s }
+ *   else serve at v.fps, then admission.release(v.fps, in.rank) when the stream ends
+ */
+class StreamAdmission {
+public:
+    static constexpr uint8_t MAX_RANKS = 4;
+
+    explicit StreamAdmission(const AdmissionConfig& config = {}) : config_(config) {}
+
+    void set_config(const AdmissionConfig& config) { config_ = config; }
+    const AdmissionConfig& config() const { return config_; }
+
+    /**
+     * @brief Decide one new client (counts it, records the inputs, and
+     *        reserves its rate unless rejected)
+     */
+    AdmissionVerdict decide(const AdmissionInputs& in) {
+        uint32_t reserved_Bps = reserved_fps_through(in.rank) * in.frame_bytes;
+        AdmissionVerdict v = evaluate(in);
+        if (v.decision != AdmissionDecision::Reject) {
+            reserved_fps_[rank_index(in.rank)] += v.fps;
+            stats_.reserved_fps += v.fps;
+        }
+        switch (v.decision) {
+            case AdmissionDecision::Accept: stats_.accepted++; break;
+            case AdmissionDecision::Degrade: stats_.degraded++; break;
+            case AdmissionDecision::Reject:
+                stats_.rejected++;
+                if (v.reason == AdmissionReason::Heap) stats_.rejected_heap++;
+                else stats_.rejected_capacity++;
+                break;
+        }
+        stats_.last_decision = static_cast<uint8_t>(v.decision);
+        stats_.last_reason = static_cast<uint8_t>(v.reason);
+        stats_.last_fps = v.fps;
+        stats_.last_egress_Bps = in.egress_Bps;
+        stats_.last_link_Bps = in.link_Bps;
+        stats_.last_frame_bytes = in.frame_bytes;
+        stats_.last_frame_send_us = in.frame_send_us;
+        stats_.last_free_heap = in.free_heap;
+        stats_.last_clients = in.clients;
+        stats_.last_reserved_Bps = reserved_Bps;
+        return v;
+    }
+    
+    /**
+     * @brief An admitted stream ended
+     * @param fps Its verdict's fps
+     * @param rank Its inputs' rank
+     */
+    void release(uint8_t fps, uint8_t rank = 0) {
+        take(reserved_fps_[rank_index(rank)], fps);
+        take(stats_.reserved_fps, fps);
+    }
+
+    /**
+     * @brief The verdict for these inputs, without counting or reserving it
+     */
+    AdmissionVerdict evaluate(const AdmissionInputs& in) const {
+        AdmissionVerdict v;
+        if (in.free_heap < config_.min_free_heap) return reject(AdmissionReason::Heap);
+        if (in.frame_bytes == 0) {
+            v.reason = AdmissionReason::Unmeasured;
+            v.fps = in.fps;
+            return v;
+        }
+
+        uint32_t fps = in.fps;
+        AdmissionReason limit = AdmissionReason::Capacity;
+        if (in.link_Bps > 0) {
+            uint64_t budget = static_cast<uint64_t>(in.link_Bps) * config_.link_share_pct / 100;
+            uint64_t in_use = static_cast<uint64_t>(reserved_fps_through(in.rank)) * in.frame_bytes;
+            if (in.egress_Bps > in_use) in_use = in.egress_Bps;
+            uint64_t left = budget > in_use ? budget - in_use : 0;
+            uint64_t bw_fps = left / in.frame_bytes;
+            if (bw_fps < fps) {
+                fps = static_cast<uint32_t>(bw_fps);
+                limit = AdmissionReason::Bandwidth;
+            }
+        }
+        if (in.frame_send_us > 0) {
+            uint32_t time_fps = 1000000 / in.frame_send_us;
+            if (time_fps < fps) {
+                fps = time_fps;
+                limit = AdmissionReason::SendTime;
+            }
+        }
+
+        if (fps >= in.fps) {
+            v.fps = in.fps;
+            return v;
+        }
+        if (fps < config_.min_fps || fps == 0) return reject(limit);
+        v.decision = AdmissionDecision::Degrade;
+        v.reason = limit;
+        v.fps = static_cast<uint8_t>(fps);
+        return v;
+    }
+
+    const AdmissionStats& stats() const { return stats_; }
+    void reset_stats() { stats_.reset(); }
+
+private:
+    static size_t rank_index(uint8_t rank) { return rank < MAX_RANKS ? rank : MAX_RANKS - 1; }
+
+    // Admitted rates of open streams at this rank or above
+    uint32_t reserved_fps_through(uint8_t rank) const {
+        uint32_t total = 0;
+        for (size_t i = 0; i <= rank_index(rank); i++) total += reserved_fps_[i].load();
+        return total;
+    }
+
+    static void take(std::atomic<uint32_t>& counter, uint32_t n) {
+        uint32_t v = counter.load();
+        while (!counter.compare_exchange_weak(v, v > n ? v - n : 0)) {
+        }
+    }
+
+    AdmissionVerdict reject(AdmissionReason reason) const {
+        AdmissionVerdict v;
+        v.decision = AdmissionDecision::Reject;
+        v.reason = reason;
+        v.retry_after_s = config_.retry_after_s;
+        return v;
+    }
+
+    AdmissionConfig config_;
+    AdmissionStats stats_;
+    std::atomic<uint32_t> reserved_fps_[MAX_RANKS] = {};
+};
+
+/**
+ * @brief The last decision, its inputs and the counters as JSON
+ * @return Length written (excluding NUL), or 0 if the buffer is too small
+ */
+inline size_t format_admission_json(const AdmissionStats& s, char* buf, size_t capacity) {
+    if (!buf || capacity == 0) return 0;
+    int n = snprintf(buf, capacity,
+        "{\"decision\":\"%s\",\"reason\":\"%s\",\"fps\":%u,"
+        "\"inputs\":{\"egress_Bps\":%lu,\"link_Bps\":%lu,\"frame_bytes\":%lu,"
+        "\"frame_send_us\":%lu,\"free_heap\":%lu,\"clients\":%lu,\"reserved_Bps\":%lu},"
+        "\"reserved_fps\":%lu,\"accepted\":%lu,\"degraded\":%lu,\"rejected\":%lu,"
+        "\"rejected_heap\":%lu,\"rejected_capacity\":%lu}",
+        admission_decision_name(static_cast<AdmissionDecision>(s.last_decision.load())),
+        admission_reason_name(static_cast<AdmissionReason>(s.last_reason.load())),
+        static_cast<unsigned>(s.last_fps.load()),
+        static_cast<unsigned long>(s.last_egress_Bps.load()),
+        static_cast<unsigned long>(s.last_link_Bps.load()),
+        static_cast<unsigned long>(s.last_frame_bytes.load()),
+        static_cast<unsigned long>(s.last_frame_send_us.load()),
+        static_cast<unsigned long>(s.last_free_heap.load()),
+        static_cast<unsigned long>(s.last_clients.load()),
+        static_cast<unsigned long>(s.last_reserved_Bps.load()),
+        static_cast<unsigned long>(s.reserved_fps.load()),
+        static_cast<unsigned long>(s.accepted.load()),
+        static_cast<unsigned long>(s.degraded.load()),
+        static_cast<unsigned long>(s.rejected.load()),
+        static_cast<unsigned long>(s.rejected_heap.load()),
+        static_cast<unsigned long>(s.rejected_capacity.load()));
+    if (n < 0 || static_cast<size_t>(n) >= capacity) return 0;
+    return static_cast<size_t>(n);
+}
+
+} // namespace core
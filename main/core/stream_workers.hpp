@@ -0,0 +1,361 @@
+/**
+ * @file stream_workers.hpp
+ * @brief Bounded pool of tasks that run long-lived streaming responses
+ *
+ * esp_http_server runs every handler on its one server task, so a handler
+ * that loops for the life of an MJPEG stream holds up every other request
+ * (/status, /capture, /config) until the stream closes. Stream handlers
+ * instead detach the request (httpd_req_async_handler_begin) and hand it to
+ * this pool; the server task returns at once and keeps serving.
+ *
+ *   [httpd task] → parse, validate → submit(job) → return
+ *                                       ↓
+ *   [stream_w0..wN] ← one job each, for as long as the stream lasts
+ *
+ * The pool never queues: a job waiting behind a running stream would wait
+ * for as long as that stream lasts, so submit() fails when every worker is
+ * busy and the caller answers 503. Workers are created once at init() and
+ * sleep between jobs.
+ *
+ * Jobs run until the client goes away or stopping() turns true; deinit()
+ * raises stopping() and waits for every job to return. A job stuck in a
+ * blocking send does not see stopping(): after stop_grace_ms deinit() has
+ * the cut_off hook break the socket it was submitted with, and waits again.
+ * It never returns while a job still runs.
+ *
+ * Cross-platform: FreeRTOS tasks + task notifications on ESP32, std::thread
+ * + condition_variable on host.
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include <cstdio>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace core {
+
+/**
+ * @brief A streaming job: runs on a worker until the stream ends
+ * @param context Caller's state (the job owns and frees it)
+ */
+using StreamJobFn = void (*)(void* context);
+
+/**
+ * @brief Break a running job's socket so its blocked send fails (deinit only)
+ * @param context StreamWorkerConfig::cut_off_context
+ * @param fd Socket the job was submitted with
+ */
+using StreamCutOffFn = void (*)(void* context, int fd);
+
+struct StreamWorkerConfig {
+    size_t workers = 2;            // Concurrent streams (1..MAX_WORKERS)
+    uint32_t stack_size = 8192;    // Per worker (ESP32; same as the httpd task)
+    uint8_t priority = 4;          // Below the producer (5)
+    uint32_t stop_grace_ms = 5000; // deinit: wait this long before cutting off sockets
+    StreamCutOffFn cut_off = nullptr;
+    void* cut_off_context = nullptr;
+};
+
+/**
+ * @brief Statistics (thread-safe reads)
+ */
+struct StreamWorkerStats {
+    std::atomic<uint32_t> submitted{0};
+    std::atomic<uint32_t> rejected{0};     // Every worker busy
+    std::atomic<uint32_t> completed{0};
+    std::atomic<uint32_t> active{0};
+    std::atomic<uint32_t> peak_active{0};
+
+    void reset() {
+        submitted = 0;
+        rejected = 0;
+        completed = 0;
+        active = 0;
+        peak_active = 0;
+    }
+};
+
+/**
+ * @brief Fixed set of worker tasks, one streaming job each
+ *
+ * Usage:
+ *   pool.init({.workers = 2});
+ *   // In a handler (after detaching the request):
+ *   if (!pool.submit(stream_job, job_state, fd)) { ... answer 503, free job_state }
+ *   // In the job loop:
+ *   while (!pool.stopping() && send_ok) { ... }
+ *   pool.deinit();   // Waits for running jobs (cutting off their sockets if need be)
+ */
+class StreamWorkerPool {
+public:
+    static constexpr size_t MAX_WORKERS = 8;
+
+    StreamWorkerPool() = default;
+    ~StreamWorkerPool() { deinit(); }
+
+    // Non-copyable
+    StreamWorkerPool(const StreamWorkerPool&) = delete;
+    StreamWorkerPool& operator=(const StreamWorkerPool&) = delete;
+
+    /**
+     * @brief Create the worker tasks
+     * @return false if workers is 0 or above MAX_WORKERS, or a task cannot be created
+     */
+    bool init(const StreamWorkerConfig& config = {}) {
+        if (initialized_) return true;
+        if (config.workers == 0 || config.workers > MAX_WORKERS) return false;
+        config_ = config;
+        stats_.reset();
+        stop_ = false;
+        running_ = 0;
+
+        for (size_t i = 0; i < config_.workers; i++) {
+            Worker& w = workers_[i];
+            w.pool = this;
+            w.job = nullptr;
+            w.context = nullptr;
+            w.fd = -1;
+            w.busy = false;
+#ifdef ESP_PLATFORM
+            char name[12];
+            snprintf(name, sizeof(name), "stream_w%u", static_cast<unsigned>(i));
+            running_++;
+            if (xTaskCreate(worker_task, name, config_.stack_size, &w, config_.priority,
+                            &w.task) != pdPASS) {
+                running_--;
+                w.task = nullptr;
+                num_workers_ = i;
+                deinit_workers();
+                return false;
+            }
+#else
+            running_++;
+            w.thread = std::thread([&w] { w.pool->worker_loop(w); });
+#endif
+        }
+        num_workers_ = config_.workers;
+        initialized_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Ask running jobs to end, wait for them, stop the workers
+     */
+    void deinit() {
+        if (!initialized_) return;
+        deinit_workers();
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Start a job on an idle worker
+     * @param fd Client socket, cut off if the job outlives deinit's grace (-1 = none)
+     * @return false if not initialized, stopping, or every worker is busy
+     *         (the job did not run: the caller still owns context)
+     */
+    bool submit(StreamJobFn job, void* context, int fd = -1) {
+        if (!initialized_ || !job || stop_) {
+            stats_.rejected++;
+            return false;
+        }
+        Worker* idle = nullptr;
+#ifdef ESP_PLATFORM
+        taskENTER_CRITICAL(&lock_);
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+#endif
+        for (size_t i = 0; i < num_workers_; i++) {
+            if (!workers_[i].busy) {
+                idle = &workers_[i];
+                idle->busy = true;
+                idle->job = job;
+                idle->context = context;
+                idle->fd = fd;
+                break;
+            }
+        }
+#ifdef ESP_PLATFORM
+        taskEXIT_CRITICAL(&lock_);
+#else
+        lock.unlock();
+#endif
+        if (!idle) {
+            stats_.rejected++;
+            return false;
+        }
+
+        stats_.submitted++;
+        uint32_t active = ++stats_.active;
+        if (active > stats_.peak_active.load()) stats_.peak_active = active;
+#ifdef ESP_PLATFORM
+        xTaskNotifyGive(idle->task);
+#else
+        cv_.notify_all();
+#endif
+        return true;
+    }
+
+    // Workers without a job (a hint: submit() decides)
+    size_t idle_workers() const {
+        uint32_t active = stats_.active.load();
+        return active < num_workers_ ? num_workers_ - active : 0;
+    }
+
+    // Jobs poll this and return when it turns true
+    bool stopping() const { return stop_.load(); }
+
+    size_t workers() const { return num_workers_; }
+    bool is_initialized() const { return initialized_; }
+    const StreamWorkerStats& stats() const { return stats_; }
+
+private:
+    struct Worker {
+        StreamWorkerPool* pool = nullptr;
+        StreamJobFn job = nullptr;
+        void* context = nullptr;
+        int fd = -1;                // Socket to cut off at deinit
+        bool busy = false;          // Claimed by submit(), cleared when the job returns
+#ifdef ESP_PLATFORM
+        TaskHandle_t task = nullptr;
+#else
+        std::thread thread;
+#endif
+    };
+
+    void run_job(Worker& w) {
+        w.job(w.context);
+        stats_.completed++;
+        stats_.active--;
+#ifdef ESP_PLATFORM
+        taskENTER_CRITICAL(&lock_);
+        w.job = nullptr;
+        w.context = nullptr;
+        w.fd = -1;
+        w.busy = false;
+        taskEXIT_CRITICAL(&lock_);
+#else
+        std::lock_guard<std::mutex> lock(mutex_);
+        w.job = nullptr;
+        w.context = nullptr;
+        w.fd = -1;
+        w.busy = false;
+#endif
+    }
+
+    // Wait until every job has returned: stopping() first, then the sockets
+    // of jobs still running are cut off, again each grace period
+    void wait_for_jobs() {
+        uint32_t grace_ms = config_.stop_grace_ms ? config_.stop_grace_ms : 1;
+        while (stats_.active.load() > 0) {
+            for (uint32_t waited = 0; waited < grace_ms && stats_.active.load() > 0; waited += 10) {
+#ifdef ESP_PLATFORM
+                vTaskDelay(pdMS_TO_TICKS(10));
+#else
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
+            }
+            if (stats_.active.load() == 0) break;
+
+            int fds[MAX_WORKERS];
+            size_t count = 0;
+#ifdef ESP_PLATFORM
+            taskENTER_CRITICAL(&lock_);
+#else
+            std::unique_lock<std::mutex> lock(mutex_);
+#endif
+            for (size_t i = 0; i < num_workers_; i++) {
+                if (workers_[i].busy && workers_[i].fd >= 0) fds[count++] = workers_[i].fd;
+            }
+#ifdef ESP_PLATFORM
+            taskEXIT_CRITICAL(&lock_);
+            ESP_LOGW("StreamWorkers", "%lu jobs still running at deinit, cutting off %u sockets",
+                     static_cast<unsigned long>(stats_.active.load()), static_cast<unsigned>(count));
+#else
+            lock.unlock();
+#endif
+            if (config_.cut_off) {
+                for (size_t i = 0; i < count; i++) config_.cut_off(config_.cut_off_context, fds[i]);
+            }
+        }
+    }
+
+#ifdef ESP_PLATFORM
+    static void worker_task(void* arg) {
+        auto& w = *static_cast<Worker*>(arg);
+        StreamWorkerPool* pool = w.pool;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (w.job) pool->run_job(w);   // Set before the notification
+            if (pool->stop_) break;
+        }
+        pool->running_--;
+        vTaskDelete(nullptr);
+    }
+
+    void deinit_workers() {
+        stop_ = true;
+        for (size_t i = 0; i < num_workers_; i++) {
+            if (workers_[i].task) xTaskNotifyGive(workers_[i].task);
+        }
+        wait_for_jobs();
+        // Idle workers exit on the notification
+        while (running_.load() > 0) vTaskDelay(pdMS_TO_TICKS(10));
+        for (size_t i = 0; i < num_workers_; i++) workers_[i].task = nullptr;
+        num_workers_ = 0;
+    }
+
+    portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+    void worker_loop(Worker& w) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [&] { return w.job != nullptr || stop_; });
+            if (w.job) {
+                lock.unlock();
+                run_job(w);
+                lock.lock();
+                continue;
+            }
+            if (stop_) break;
+        }
+        running_--;
+    }
+
+    void deinit_workers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        wait_for_jobs();
+        for (size_t i = 0; i < num_workers_; i++) {
+            if (workers_[i].thread.joinable()) workers_[i].thread.join();
+        }
+        num_workers_ = 0;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+
+    StreamWorkerConfig config_;
+    StreamWorkerStats stats_;
+    Worker workers_[MAX_WORKERS];
+    size_t num_workers_ = 0;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint32_t> running_{0};     // Worker tasks alive
+    bool initialized_ = false;
+};
+
+} // namespace core
@@ -10,24 +10,40 @@
  * The buffer absorbs timing variations from camera and network.
  * The consumer blocks until a frame is available.
  * If buffer overflows, oldest frames are dropped (freshness > history).
+ * Pollers can instead wait for the next frame by sequence (acquire_frame_after),
+ * which pins the newest frame without taking it from the consumer.
+ * Network senders lease it instead (lease_frame_after): the producer revokes
+ * leases that made no progress for lease_timeout_ms before each push, so a
+ * stalled client cannot make it drop every new frame.
+ * Frame sinks (history, recorders) see every committed frame from the producer.
+ * An optional frame processor rewrites each frame (masking, overlays) before
+ * it is committed, so every consumer sees the processed frame.
+ * Capture failures escalate from backoff to a sensor reset to a camera
+ * re-init (capture_recovery.hpp); health changes go to a callback.
+ * Consumers and pollers sleep on a FrameNotifier (frame_notifier.hpp) and
+ * re-check the ring itself, so frames committed while nobody was waiting
+ * are never slept through.
  */
 #pragma once
 #include "../interfaces/i_camera.hpp"
 #include "../interfaces/i_clock.hpp"
+#include "../interfaces/i_frame_sink.hpp"
+#include "../interfaces/i_frame_processor.hpp"
 #include "frame_buffer.hpp"
+#include "burst_capture.hpp"
+#include "capture_recovery.hpp"
+#include "frame_notifier.hpp"
 #include <atomic>
 #include <cstdint>
+#include <cstdlib>
 
 #ifdef ESP_PLATFORM
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #else
 #include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <chrono>
 #endif
 
 namespace core {
@@ -37,6 +53,9 @@ struct StreamingConfig {
     size_t buffer_slots = 3;              // Ring buffer depth
     size_t max_frame_size = 100 * 1024;   // 100KB max per frame
     uint32_t consumer_timeout_ms = 1000;  // Max wait for frame
+    uint32_t lease_timeout_ms = 500;      // Revoke stalled senders' leases (0 = never)
+    CaptureRecoveryConfig recovery{};     // Escalation on capture failures
+    interfaces::CameraConfig camera{};    // Buffer count/pixel format for a recovery re-init
 };
 
 struct StreamingStats {
@@ -44,6 +63,8 @@ struct StreamingStats {
     std::atomic<uint32_t> frames_sent{0};
     std::atomic<uint32_t> frames_dropped{0};
     std::atomic<uint32_t> capture_errors{0};
+    std::atomic<uint32_t> processing_errors{0};   // Frames the processor rejected
+    std::atomic<uint32_t> leases_revoked{0};      // Stalled senders' pins taken back
     std::atomic<bool> producer_running{false};
     
     void reset() {
@@ -51,9 +72,17 @@ struct StreamingStats {
         frames_sent = 0;
         frames_dropped = 0;
         capture_errors = 0;
+        processing_errors = 0;
+        leases_revoked = 0;
     }
 };
 
+/**
+ * @brief Called on the producer task when camera health changes
+ */
+using CameraHealthCallback = void (*)(void* context, CameraHealth health,
+                                      const CaptureRecoveryStats& stats);
+
 /**
  * @brief Streaming service with producer-consumer architecture
  * 
@@ -75,6 +104,11 @@ struct StreamingStats {
  */
 class StreamingService {
 public:
+    static constexpr size_t MAX_SINKS = 6;          // history, multicast, upload, MQTT, recorder, quality
+    static constexpr uint8_t MAX_TARGET_FPS = 60;   // Fastest sensor profiles reach 50
+    static constexpr int64_t BURST_POLL_MS = 20;    // Longest wait before a burst request is seen
+    static constexpr int64_t RECOVERY_POLL_MS = 100; // Longest backoff sleep before stop() is seen
+    
     StreamingService(interfaces::ICamera& camera, interfaces::IClock& clock)
         : camera_(camera), clock_(clock) {}
     
@@ -97,19 +131,12 @@ public:
         
         config_ = config;
         frame_interval_us_ = 1000000 / config_.target_fps;
+        recovery_.set_config(config_.recovery);
         
         if (!buffer_.init(config_.buffer_slots, config_.max_frame_size, true)) {
             return false;
         }
         
-#ifdef ESP_PLATFORM
-        frame_ready_ = xSemaphoreCreateBinary();
-        if (!frame_ready_) {
-            buffer_.deinit();
-            return false;
-        }
-#endif
-        
         initialized_ = true;
         return true;
     }
@@ -119,17 +146,79 @@ public:
         
         stop();
         buffer_.deinit();
-        
+        num_sinks_ = 0;
+        processor_ = nullptr;
+        burst_ = nullptr;
+        if (process_buf_) {
 #ifdef ESP_PLATFORM
-        if (frame_ready_) {
-            vSemaphoreDelete(frame_ready_);
-            frame_ready_ = nullptr;
-        }
+            heap_caps_free(process_buf_);
+#else
+            free(process_buf_);
 #endif
+            process_buf_ = nullptr;
+        }
         
         initialized_ = false;
     }
     
+    /**
+     * @brief Register a consumer of every committed frame
+     * @param sink Called from the producer after each push (must not block)
+     * @return false if running or MAX_SINKS already registered
+     * @note Register before start(); sinks are not removed until deinit
+     */
+    bool add_sink(interfaces::IFrameSink* sink) {
+        if (!sink || num_sinks_ >= MAX_SINKS || stats_.producer_running.load()) return false;
+        sinks_[num_sinks_++] = sink;
+        return true;
+    }
+    
+    /**
+     * @brief Install the stage that rewrites frames before they are committed
+     * @param processor Called from the producer for every frame; nullptr removes it
+     * @return false if not initialized, running, or the output buffer
+     *         (max_frame_size, PSRAM) cannot be allocated
+     * @note A frame the processor rejects is dropped, never committed unprocessed
+     */
+    bool set_processor(interfaces::IFrameProcessor* processor) {
+        if (!initialized_ || stats_.producer_running.load()) return false;
+        if (processor && !process_buf_) {
+#ifdef ESP_PLATFORM
+            process_buf_ = static_cast<uint8_t*>(
+                heap_caps_malloc(config_.max_frame_size, MALLOC_CAP_SPIRAM));
+#else
+            process_buf_ = static_cast<uint8_t*>(malloc(config_.max_frame_size));
+#endif
+            if (!process_buf_) return false;
+        }
+        processor_ = processor;
+        return true;
+    }
+    
+    /**
+     * @brief Let bursts take over the producer (see burst_capture.hpp)
+     * @param burst Polled by the producer; nullptr removes it
+     * @return false if running
+     * @note Burst frames bypass the ring and sinks but pass through the processor
+     */
+    bool set_burst(BurstCapture* burst) {
+        if (stats_.producer_running.load()) return false;
+        burst_ = burst;
+        return true;
+    }
+    
+    /**
+     * @brief Be told when capture fails, escalates and recovers
+     * @param callback Called from the producer (must not block); nullptr removes it
+     * @return false if running
+     */
+    bool set_health_callback(CameraHealthCallback callback, void* context) {
+        if (stats_.producer_running.load()) return false;
+        health_callback_ = callback;
+        health_context_ = context;
+        return true;
+    }
+    
     /**
      * @brief Start the producer task
      * @return true on success
@@ -142,6 +231,7 @@ public:
         stats_.reset();
         buffer_.clear();
         buffer_.reset_stats();
+        notifier_.reset_stats();
         
 #ifdef ESP_PLATFORM
         BaseType_t ret = xTaskCreatePinnedToCore(
@@ -169,12 +259,10 @@ public:
     void stop() {
         stop_requested_ = true;
         
-#ifdef ESP_PLATFORM
         // Wake any waiting consumers
-        if (frame_ready_) {
-            xSemaphoreGive(frame_ready_);
-        }
+        notifier_.publish();
         
+#ifdef ESP_PLATFORM
         // Wait for task to finish (with timeout)
         for (int i = 0; i < 50 && stats_.producer_running.load(); i++) {
             vTaskDelay(pdMS_TO_TICKS(20));
@@ -187,9 +275,6 @@ public:
         }
         producer_task_ = nullptr;
 #else
-        // Wake any waiting consumers
-        frame_cv_.notify_all();
-        
         // Always try to join if thread exists (handles race at startup)
         if (producer_thread_.joinable()) {
             producer_thread_.join();
@@ -207,31 +292,21 @@ public:
      * @param data Output: pointer to frame data
      * @param size Output: frame size
      * @param timeout_ms Max time to wait (0 = non-blocking)
+     * @param timestamp_us Output: frame timestamp (optional)
+     * @param sequence Output: frame sequence number (optional)
      * @return true if frame available
      */
-    bool get_frame(const uint8_t** data, size_t* size, uint32_t timeout_ms = 1000) {
+    bool get_frame(const uint8_t** data, size_t* size, uint32_t timeout_ms = 1000,
+                   int64_t* timestamp_us = nullptr, uint32_t* sequence = nullptr) {
         if (!initialized_ || !data || !size) return false;
         
-#ifdef ESP_PLATFORM
-        TickType_t ticks = (timeout_ms == 0) ? 0 : pdMS_TO_TICKS(timeout_ms);
-        if (xSemaphoreTake(frame_ready_, ticks) != pdTRUE) {
-            return false;
-        }
-#else
-        std::unique_lock<std::mutex> lock(frame_mutex_);
-        if (timeout_ms == 0) {
-            if (buffer_.empty()) return false;
-        } else {
-            bool result = frame_cv_.wait_for(
-                lock, 
-                std::chrono::milliseconds(timeout_ms),
-                [this] { return !buffer_.empty() || stop_requested_; }
-            );
-            if (!result || stop_requested_) return false;
-        }
-#endif
+        // Waits on the ring itself: every frame still buffered is returned
+        // without sleeping, however many commits one wakeup covered
+        bool ready = notifier_.wait([this] { return !buffer_.empty() || stop_requested_; },
+                                    timeout_ms);
+        if (!ready) return false;
         
-        return buffer_.peek(data, size);
+        return buffer_.peek(data, size, timestamp_us, sequence);
     }
     
     /**
@@ -242,17 +317,103 @@ public:
         stats_.frames_sent++;
     }
     
+    /**
+     * @brief Wait for a frame newer than a sequence number (long-poll)
+     * 
+     * Returns the newest frame with sequence > after_sequence, pinned until
+     * release_acquired_frame(). Any number of callers may wait at once; each
+     * committed frame wakes all of them. Does not consume frames from get_frame().
+     * If after_sequence is ahead of the ring (e.g. device rebooted), waits for
+     * the next frame instead of the stale sequence.
+     * @param after_sequence Last sequence the caller has seen (0 = any frame)
+     * @param data Output: pointer to frame data
+     * @param size Output: frame size
+     * @param timeout_ms Max time to wait (0 = non-blocking)
+     * @param timestamp_us Output: frame timestamp (optional)
+     * @param sequence Output: frame sequence number (optional)
+     * @return Handle for release_acquired_frame(), or -1 on timeout/stop
+     */
+    int acquire_frame_after(uint32_t after_sequence, const uint8_t** data, size_t* size,
+                            uint32_t timeout_ms = 1000, int64_t* timestamp_us = nullptr,
+                            uint32_t* sequence = nullptr) {
+        if (!initialized_ || !data || !size) return -1;
+        
+        uint32_t last = buffer_.last_sequence();
+        if (after_sequence > last) after_sequence = last;
+        
+        // A pinned-out or cleared newest slot fails the acquire; the next commit retries
+        int handle = -1;
+        notifier_.wait([&] {
+            handle = buffer_.acquire_latest(after_sequence, data, size, timestamp_us, sequence);
+            return handle >= 0 || stop_requested_;
+        }, timeout_ms);
+        return handle;
+    }
+    
+    /**
+     * @brief Release a frame returned by acquire_frame_after()
+     */
+    void release_acquired_frame(int handle) {
+        buffer_.release(handle);
+    }
+    
+    /**
+     * @brief Wait until a frame newer than a sequence is committed (or stop)
+     * @return true if one is (lease it with lease_frame_after())
+     */
+    bool wait_frame_after(uint32_t after_sequence, uint32_t timeout_ms) {
+        if (!initialized_) return false;
+        uint32_t last = buffer_.last_sequence();
+        if (after_sequence > last) after_sequence = last;
+        return notifier_.wait([&] {
+            return buffer_.last_sequence() > after_sequence || stop_requested_;
+        }, timeout_ms) && !stop_requested_;
+    }
+    
+    /**
+     * @brief Lease the newest frame newer than a sequence (non-blocking)
+     * 
+     * Like acquire_frame_after(), but the pin is revoked if the holder makes
+     * no progress for lease_timeout_ms. Touch the data only between
+     * lease_read_begin() and lease_read_end().
+     * @return Lease id, or -1 if there is no newer frame
+     */
+    int lease_frame_after(uint32_t after_sequence, const uint8_t** data, size_t* size,
+                          int64_t* timestamp_us = nullptr, uint32_t* sequence = nullptr) {
+        if (!initialized_) return -1;
+        uint32_t last = buffer_.last_sequence();
+        if (after_sequence > last) after_sequence = last;
+        return buffer_.lease_latest(after_sequence, data, size, clock_.now_us(),
+                                    timestamp_us, sequence);
+    }
+    
+    // false: revoked, the frame data is gone
+    bool lease_read_begin(int lease) { return buffer_.lease_read_begin(lease); }
+    void lease_read_end(int lease, bool progressed) {
+        buffer_.lease_read_end(lease, clock_.now_us(), progressed);
+    }
+    // delivered: the frame went out whole (counts as sent)
+    void release_lease(int lease, bool delivered = false) {
+        buffer_.release_lease(lease);
+        if (delivered) stats_.frames_sent++;
+    }
+    
     // -------------------------------------------------------------------------
     // Status and Configuration
     // -------------------------------------------------------------------------
     
     const StreamingStats& stats() const { return stats_; }
+    const CaptureRecoveryStats& recovery_stats() const { return recovery_.stats(); }
+    CameraHealth health() const { return recovery_.health(); }
+    const FrameNotifierStats& notifier_stats() const { return notifier_.stats(); }
     size_t buffered_frames() const { return buffer_.available(); }
+    uint32_t last_sequence() const { return buffer_.last_sequence(); }
     bool is_running() const { return stats_.producer_running.load(); }
     bool is_initialized() const { return initialized_; }
+    size_t max_frame_size() const { return config_.max_frame_size; }
     
     void set_target_fps(uint8_t fps) {
-        if (fps > 0 && fps <= 30) {
+        if (fps > 0 && fps <= MAX_TARGET_FPS) {
             config_.target_fps = fps;
             frame_interval_us_ = 1000000 / fps;
         }
@@ -268,20 +429,69 @@ private:
     }
 #endif
     
+    // Wake the consumer and every long-poll waiter
+    void notify_frame() {
+        notifier_.publish();
+    }
+    
+    void report_health() {
+        if (health_callback_) health_callback_(health_context_, recovery_.health(), recovery_.stats());
+    }
+    
+    // Soft reset or deinit/init, keeping what was set at runtime
+    // (resolution, quality, profile, manual exposure)
+    void run_recovery(RecoveryAction action) {
+        interfaces::ExposureSettings exposure = camera_.get_exposure();
+        bool ok;
+        if (action == RecoveryAction::ResetSensor) {
+            ok = camera_.reset_sensor();
+#ifdef ESP_PLATFORM
+            ESP_LOGW("StreamSvc", "Capture failing, sensor reset %s", ok ? "done" : "failed");
+#endif
+        } else {
+            interfaces::CameraConfig camera_config = config_.camera;
+            interfaces::SensorProfile profile;
+            if (const interfaces::SensorProfile* current = camera_.get_profile()) {
+                profile = *current;
+                camera_config.profile = &profile;
+            }
+            if (camera_.is_initialized()) {
+                camera_config.resolution = camera_.get_resolution();
+                camera_config.jpeg_quality = camera_.get_quality();
+            }
+            camera_.deinit();
+            ok = camera_.init(camera_config);
+#ifdef ESP_PLATFORM
+            ESP_LOGW("StreamSvc", "Capture failing, camera re-init %s", ok ? "done" : "failed");
+#endif
+        }
+        if (ok && !exposure.auto_exposure) ok = camera_.set_exposure(exposure);
+        if (!ok) recovery_.on_action_failed();
+    }
+    
     void producer_loop() {
         stats_.producer_running = true;
         int64_t next_capture_time = clock_.now_us();
+        recovery_.start(next_capture_time);
         
 #ifdef ESP_PLATFORM
         ESP_LOGI("StreamSvc", "Producer started @ %d FPS", config_.target_fps);
 #endif
         
         while (!stop_requested_) {
+            if (burst_ && burst_->pending()) {
+                burst_->run(camera_, clock_, processor_, config_.max_frame_size, stop_requested_);
+                next_capture_time = clock_.now_us();
+                continue;
+            }
+            
             int64_t now = clock_.now_us();
             
             // Wait until scheduled capture time
             if (now < next_capture_time) {
                 int64_t sleep_ms = (next_capture_time - now) / 1000;
+                if (burst_ && sleep_ms > BURST_POLL_MS) sleep_ms = BURST_POLL_MS;
+                if (!recovery_.healthy() && sleep_ms > RECOVERY_POLL_MS) sleep_ms = RECOVERY_POLL_MS;
                 if (sleep_ms > 0) {
                     clock_.delay_ms(static_cast<uint32_t>(sleep_ms));
                 }
@@ -291,10 +501,36 @@ private:
             // Capture frame from camera
             auto frame = camera_.capture_frame();
             
+            // Rewrite into our own buffer; the camera frame goes back right away
+            bool processed = false;
+            if (frame.valid() && processor_) {
+                size_t size = processor_->process(frame, process_buf_, config_.max_frame_size);
+                camera_.release_frame();
+                frame.data = size ? process_buf_ : nullptr;
+                frame.size = size;
+                processed = true;
+            }
+            
+            if (frame.valid() || processed) {
+                if (recovery_.on_success(clock_.now_us())) report_health();
+            }
+            
             if (frame.valid()) {
+                // Stalled senders must not hold the slot this push needs
+                if (config_.lease_timeout_ms > 0) {
+                    stats_.leases_revoked += static_cast<uint32_t>(buffer_.revoke_stale_leases(
+                        clock_.now_us(), static_cast<int64_t>(config_.lease_timeout_ms) * 1000));
+                }
+                
                 // Push to buffer (may drop oldest if full)
-                bool pushed = buffer_.push(frame.data, frame.size, frame.timestamp_us);
-                camera_.release_frame();
+                uint32_t sequence = 0;
+                bool pushed = buffer_.push(frame.data, frame.size, frame.timestamp_us, &sequence);
+                if (sequence != 0) {
+                    for (size_t i = 0; i < num_sinks_; i++) {
+                        sinks_[i]->on_frame(frame.data, frame.size, frame.timestamp_us, sequence);
+                    }
+                }
+                if (!processed) camera_.release_frame();
                 
                 if (pushed) {
                     stats_.frames_captured++;
@@ -306,12 +542,10 @@ private:
                     }
                     
                     // Signal waiting consumers
-#ifdef ESP_PLATFORM
-                    xSemaphoreGive(frame_ready_);
-#else
-                    frame_cv_.notify_one();
-#endif
+                    notify_frame();
                 }
+            } else if (processed) {
+                stats_.processing_errors++;   // Dropped, never committed unprocessed
             } else {
                 stats_.capture_errors++;
                 camera_.release_frame();  // Ensure cleanup even on failure
@@ -320,6 +554,13 @@ private:
                 ESP_LOGW("StreamSvc", "Capture failed, errors=%lu", 
                          stats_.capture_errors.load());
 #endif
+                
+                CameraHealth before = recovery_.health();
+                RecoveryStep step = recovery_.on_failure(clock_.now_us());
+                if (step.action != RecoveryAction::Retry) run_recovery(step.action);
+                if (recovery_.health() != before) report_health();
+                next_capture_time = clock_.now_us() + static_cast<int64_t>(step.delay_ms) * 1000;
+                continue;
             }
             
             // Schedule next capture
@@ -351,17 +592,25 @@ private:
     StreamingConfig config_;
     StreamingStats stats_;
     
-    int64_t frame_interval_us_ = 333333;  // Default 3 FPS
+    interfaces::IFrameSink* sinks_[MAX_SINKS] = {};
+    size_t num_sinks_ = 0;
+    interfaces::IFrameProcessor* processor_ = nullptr;
+    uint8_t* process_buf_ = nullptr;
+    BurstCapture* burst_ = nullptr;
+    CaptureRecoveryPolicy recovery_;              // Producer only (stats readable anywhere)
+    CameraHealthCallback health_callback_ = nullptr;
+    void* health_context_ = nullptr;
+    
+    FrameNotifier notifier_;                      // Published on every commit and on stop
+    
+    std::atomic<int64_t> frame_interval_us_{333333};  // Default 3 FPS (retimed live)
     std::atomic<bool> stop_requested_{false};
     bool initialized_ = false;
     
 #ifdef ESP_PLATFORM
     TaskHandle_t producer_task_ = nullptr;
-    SemaphoreHandle_t frame_ready_ = nullptr;
 #else
     std::thread producer_thread_;
-    std::mutex frame_mutex_;
-    std::condition_variable frame_cv_;
 #endif
 };
 
@@ -5,8 +5,34 @@
  * Simplified web server that:
  * - Serves HTML page with stream view and controls
  * - Provides /stream endpoint consuming from StreamingService
+ *   (optional ?roi=x,y,w,h crops each frame in the compressed domain,
+ *    ?from=-10s&speed=2 replays recent history before continuing live)
+ * - Splices a sequence/timestamp APP9 segment into every JPEG it sends
+ * - Runs streams (/stream, /delta, /cam/<id>/stream) on a bounded pool of
+ *   worker tasks (stream_workers.hpp), so the server task stays free for
+ *   control requests while streams are open
+ * - Writes plain MJPEG streams with non-blocking sends (mjpeg_sender.hpp):
+ *   a stalled client skips to the newest frame, loses its ring lease, and
+ *   is dropped after stream_stall_budget_ms
+ * - Admits each new stream from measured capacity (stream_admission.hpp):
+ *   accepted, served at a lower FPS, or 503 with Retry-After; the last
+ *   decision and its inputs are at /admission
+ * - Tags streams with a priority class (?class=recorder|operator|dashboard)
+ *   and, with an EgressScheduler attached, drops frames of the lowest
+ *   classes first when the link budget is short; rates and delivery
+ *   ratios per class are at /egress
  * - Provides /capture endpoint for single shots
+ * - Provides /burst?n=&interval= (full-rate frame sequence as multipart/mixed,
+ *   closed by a JSON report part) when a BurstCapture is attached
+ * - Provides /frame?after=<seq>&timeout=<ms> long-poll for the next ring frame
  * - Provides /status endpoint with statistics
+ * - Provides /events SSE endpoint pushing status changes (shared serialization)
+ * - Provides /stream.sdp describing the RTP/JPEG multicast stream (if enabled)
+ * - Provides /delta streaming only the tiles that changed (drawn on a canvas)
+ * - Provides /cam/<id>/stream|frame|status for cameras in a CameraRegistry
+ * - Provides /recordings?from=&to= (clip index), /recordings/<id>.mjpeg
+ *   (Range-capable download), /recordings/<id>.zip|.tar (one JPEG per frame,
+ *   streamed in constant memory) and /recordings/<id>/thumb?n= (if recording)
  * - Removed FPS counter (unreliable, statistics suffice)
  */
 #pragma once
@@ -14,15 +40,34 @@
 #ifdef ESP_PLATFORM
 
 #include "streaming_service.hpp"
+#include "roi_crop.hpp"
+#include "jpeg_metadata.hpp"
+#include "stats_publisher.hpp"
+#include "frame_history.hpp"
+#include "jpeg_delta.hpp"
+#include "sensor_profiles.hpp"
+#include "camera_registry.hpp"
+#include "recording_catalog.hpp"
+#include "burst_capture.hpp"
+#include "stream_workers.hpp"
+#include "mjpeg_sender.hpp"
+#include "stream_admission.hpp"
+#include "egress_scheduler.hpp"
 #include "../interfaces/i_camera.hpp"
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
 #include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 #include <atomic>
+#include <new>
 
 namespace core {
 
@@ -30,15 +75,60 @@ namespace core {
 #define MJPEG_BOUNDARY "frame"
 #define MJPEG_CONTENT_TYPE "multipart/x-mixed-replace; boundary=" MJPEG_BOUNDARY
 
+// Response head for streams written straight to the socket (MjpegSender)
+#define MJPEG_RESPONSE_HEAD \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: " MJPEG_CONTENT_TYPE "\r\n" \
+    "Access-Control-Allow-Origin: *\r\n" \
+    "Cache-Control: no-cache\r\n" \
+    "Connection: close\r\n\r\n"
+
+// Response head and preamble for /events, written straight to the socket (SseSubscriber)
+#define SSE_RESPONSE_HEAD \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: text/event-stream\r\n" \
+    "Access-Control-Allow-Origin: *\r\n" \
+    "Cache-Control: no-cache\r\n" \
+    "Connection: close\r\n\r\n" \
+    "retry: 3000\n\n"
+
+// /burst part boundary
+#define BURST_BOUNDARY "burst"
+
 struct WebServerConfig {
     uint16_t port = 80;
-    bool single_client_stream = true;
+    bool single_client_stream = false;   // One stream at a time (else up to stream_workers)
+    size_t stream_workers = 2;           // Concurrent streams, each on its own task (0 = on the server task)
+    uint32_t stream_stall_budget_ms = 10000;   // Drop MJPEG clients that take nothing this long
+    bool admission_control = true;        // Decide new streams from measured capacity
+    AdmissionConfig admission;
+    uint32_t link_capacity_kbps = 6000;   // Nominal link rate at good RSSI (0 = no bandwidth check)
+    size_t roi_cache_entries = 2;     // Cropped frames cached for /stream?roi= (0 = disabled)
+    bool embed_metadata = true;       // Splice sequence/timestamp APP9 segment into JPEGs
+    uint32_t frame_poll_max_timeout_ms = 10000;  // Upper bound for /frame?timeout=
+    size_t sse_max_clients = 3;           // /events subscribers (0 = disabled)
+    uint32_t sse_min_interval_ms = 500;   // Minimum spacing between status events
+    uint16_t delta_tile_mcus = 0;         // /delta tile size in MCUs (0 = one MCU row)
+    uint16_t delta_key_interval = 100;    // /delta frames between key frames
+    size_t recordings_max_list = 200;     // Clips per /recordings response (continue with from=)
+    uint32_t burst_frame_timeout_ms = 3000;   // /burst wait per frame (plus the interval)
+    uint16_t burst_max_frames = 64;       // Largest /burst n; more is rejected with 400
 };
 
 struct WebServerStats {
     std::atomic<uint32_t> total_requests{0};
     std::atomic<uint32_t> stream_clients{0};
+    std::atomic<uint32_t> stream_evictions{0};        // Stalled past the stall budget
+    std::atomic<uint32_t> stream_frames_skipped{0};   // Newer frame taken while a client lagged
+    std::atomic<uint32_t> stream_frames_truncated{0}; // Lease revoked mid-frame
+    std::atomic<uint32_t> stream_frames_deferred{0};  // Over the client's class rate
     std::atomic<uint32_t> captures_served{0};
+    std::atomic<uint32_t> frames_polled{0};
+    std::atomic<uint32_t> event_clients{0};
+    std::atomic<uint32_t> event_evictions{0};         // Subscriber stalled past the stall budget
+    std::atomic<uint32_t> events_skipped{0};          // Events a lagging subscriber never got
+    std::atomic<uint32_t> bursts_served{0};
+    std::atomic<uint32_t> archives_served{0};
     int64_t start_time_us = 0;
 };
 
@@ -61,11 +151,14 @@ public:
         if (server_) return true;
         
         config_ = config;
+        admission_.set_config(config_.admission);
+        refresh_link_estimate();
         
         httpd_config_t http_config = HTTPD_DEFAULT_CONFIG();
         http_config.server_port = config_.port;
         http_config.stack_size = 8192;
-        http_config.max_uri_handlers = 8;
+        http_config.max_uri_handlers = 15;
+        http_config.uri_match_fn = httpd_uri_match_wildcard;   // /cam/*, /recordings/*
         http_config.recv_wait_timeout = 30;
         http_config.send_wait_timeout = 30;
         
@@ -74,22 +167,146 @@ public:
             return false;
         }
         
+        if (config_.roi_cache_entries > 0 &&
+            !roi_cache_.init(config_.roi_cache_entries, streaming_.max_frame_size(), true)) {
+            ESP_LOGW("WebServer", "ROI cache allocation failed, /stream?roi= disabled");
+        }
+        
+        if (config_.stream_workers > 0) {
+            StreamWorkerConfig workers;
+            workers.workers = config_.stream_workers < StreamWorkerPool::MAX_WORKERS
+                ? config_.stream_workers : StreamWorkerPool::MAX_WORKERS;
+            workers.cut_off = cut_off_socket;
+            if (!stream_pool_.init(workers)) {
+                ESP_LOGW("WebServer", "Stream workers unavailable, streams run on the server task");
+            }
+        }
+        
         register_handlers();
+        start_events();
         ESP_LOGI("WebServer", "Started on port %d", config_.port);
         return true;
     }
     
     void stop() {
+        stop_events();
+        stream_pool_.deinit();   // Streams end and complete their requests first
         if (server_) {
             httpd_stop(server_);
             server_ = nullptr;
         }
+        roi_cache_.deinit();
+    }
+    
+    /**
+     * @brief Enable /stream?from= playback (history must outlive the server)
+     */
+    void set_history(FrameHistory* history) {
+        history_ = history;
+    }
+    
+    /**
+     * @brief Serve a session description at /stream.sdp (text must outlive the server)
+     */
+    void set_multicast_sdp(const char* sdp) {
+        multicast_sdp_ = sdp;
+    }
+    
+    /**
+     * @brief Serve /cam/<id>/... for each registered camera (registry must outlive the server)
+     */
+    void set_cameras(CameraRegistry* cameras) {
+        cameras_ = cameras;
+    }
+    
+    /**
+     * @brief Serve /recordings from a catalog (must outlive the server)
+     */
+    void set_recordings(RecordingCatalog* catalog) {
+        recordings_ = catalog;
+    }
+    
+    /**
+     * @brief Serve /burst (burst must be attached to the streaming service)
+     */
+    void set_burst(BurstCapture* burst) {
+        burst_ = burst;
+    }
+    
+    /**
+     * @brief Schedule stream egress by client class (?class=) and serve /egress
+     *        (scheduler must outlive the server; its capacity is kept at the
+     *        admission link budget by start() and refresh_link_estimate())
+     */
+    void set_egress_scheduler(EgressScheduler* scheduler) {
+        scheduler_ = scheduler;
+    }
+    
+    /**
+     * @brief Re-estimate the link from RSSI and pass the budget to the scheduler
+     * @return Link estimate in bytes/s (0 = no bandwidth limit configured)
+     */
+    uint32_t refresh_link_estimate() {
+        if (!config_.admission_control || config_.link_capacity_kbps == 0) {
+            if (scheduler_) scheduler_->set_capacity_Bps(0);
+            return 0;
+        }
+        wifi_ap_record_t ap_info;
+        int8_t rssi = esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK ? ap_info.rssi : 0;
+        uint32_t link_Bps = link_estimate_Bps(rssi, config_.link_capacity_kbps * 125);
+        if (scheduler_) {
+            scheduler_->set_capacity_Bps(static_cast<uint32_t>(
+                static_cast<uint64_t>(link_Bps) * config_.admission.link_share_pct / 100));
+        }
+        return link_Bps;
     }
     
     const WebServerStats& stats() const { return stats_; }
+    const StreamWorkerStats& stream_worker_stats() const { return stream_pool_.stats(); }
+    const AdmissionStats& admission_stats() const { return admission_.stats(); }
+    const EgressScheduler* egress_scheduler() const { return scheduler_; }
+    
+    /**
+     * @brief The values /status and /events report (for other publishers)
+     */
+    StatusSnapshot status_snapshot() const { return collect_status(); }
 
 private:
     static constexpr const char* TAG = "WebServer";
+    static constexpr size_t MAX_DELTA_TILES = 2048;   // Frames cut into more tiles go out as key frames
+    static constexpr uint32_t INLINE_POLL_MAX_MS = 250;   // /frame wait on the server task (no workers)
+    static constexpr uint32_t CAMERA_POLL_MS = 1000;       // /cam/<id>/frame wait
+    
+    // A stream handed from the server task to a worker. Holds the parsed
+    // request and whatever the handler allocated; freed when the stream ends.
+    struct StreamJob {
+        enum class Kind : uint8_t { Live, Delta, Camera };
+        Kind kind = Kind::Live;
+        WebServer* self = nullptr;
+        httpd_req_t* req = nullptr;            // Async copy when detached
+        bool detached = false;
+        RoiRect roi;                           // Live: ?roi=
+        bool use_roi = false;
+        bool use_history = false;              // Live: ?from= / ?speed=
+        int64_t from_us = 0;
+        float speed = 1.0f;
+        uint8_t* replay_buf = nullptr;         // Live/Delta: frame copy sent off the ring (PSRAM)
+        JpegDeltaEncoder* encoder = nullptr;   // Delta
+        StreamingService* svc = nullptr;       // Camera
+        int close_fd = -1;                     // Response written raw: close once released
+        uint8_t fps = 0;                       // Degraded by admission (0 = source rate)
+        uint8_t reserved_fps = 0;              // Admitted rate, released when the stream ends
+        ConsumerClass cls = ConsumerClass::Operator;   // ?class=
+    };
+    
+    // A request that waits or sends for long (long-poll, download), handed
+    // to a stream worker. fn is the handler body; it answers on the async
+    // copy of the request.
+    using RequestFn = esp_err_t (*)(httpd_req_t* req);
+    struct RequestJob {
+        RequestFn fn = nullptr;
+        httpd_req_t* req = nullptr;
+    };
     
     // =========================================================================
     // Embedded HTML
@@ -109,7 +326,7 @@ private:
         h1 { text-align: center; margin-bottom: 20px; color: #00d9ff; font-size: 1.5rem; }
         .stream-box { background: #16213e; border-radius: 12px; overflow: hidden; 
                       margin-bottom: 20px; position: relative; }
-        .stream-box img { width: 100%; display: block; min-height: 200px; 
+        .stream-box img, .stream-box canvas { width: 100%; display: block; min-height: 200px; 
                           background: #0f0f23; object-fit: contain; }
         .live-badge { position: absolute; top: 10px; left: 10px; background: #ff4444;
                       color: white; padding: 4px 12px; border-radius: 4px; font-size: 0.8rem;
@@ -139,9 +356,11 @@ private:
         <div class="stream-box">
             <span id="live-badge" class="live-badge">LIVE</span>
             <img id="stream" alt="Stream">
+            <canvas id="delta" style="display:none"></canvas>
         </div>
         <div class="controls">
             <button id="btn-stream" onclick="toggleStream()">Start Stream</button>
+            <button id="btn-delta" onclick="toggleDelta()">Delta Stream</button>
             <button onclick="capturePhoto()">Capture</button>
             <button onclick="downloadCapture()">Download</button>
         </div>
@@ -191,6 +410,7 @@ private:
                 badge.style.display = 'none';
                 streaming = false;
             } else {
+                if (deltaAbort) deltaAbort.abort();
                 img.src = '/stream?' + Date.now();
                 btn.textContent = 'Stop Stream';
                 btn.classList.add('stop');
@@ -199,6 +419,77 @@ private:
             }
         }
         
+        // /delta: records of 'D', type, width, height, tile w/h, tile count,
+        // sequence, JPEG length (big-endian), tile indices, then a JPEG.
+        // Key frames are drawn whole; row i of a patch goes to tile index[i].
+        let deltaAbort = null;
+        
+        async function runDelta(signal) {
+            const canvas = document.getElementById('delta');
+            const ctx = canvas.getContext('2d');
+            const response = await fetch('/delta', { signal });
+            if (!response.ok) throw new Error(response.status);
+            const reader = response.body.getReader();
+            let buf = new Uint8Array(0);
+            while (true) {
+                const { done, value } = await reader.read();
+                if (done) break;
+                const merged = new Uint8Array(buf.length + value.length);
+                merged.set(buf);
+                merged.set(value, buf.length);
+                buf = merged;
+                while (buf.length >= 20) {
+                    const v = new DataView(buf.buffer, buf.byteOffset);
+                    const width = v.getUint16(2), height = v.getUint16(4);
+                    const tw = v.getUint16(6), th = v.getUint16(8), count = v.getUint16(10);
+                    const jpegLen = v.getUint32(16);
+                    const total = 20 + 2 * count + jpegLen;
+                    if (buf.length < total) break;
+                    const jpeg = buf.slice(20 + 2 * count, total);
+                    const bmp = await createImageBitmap(new Blob([jpeg], { type: 'image/jpeg' }));
+                    if (buf[1] === 0) {
+                        if (canvas.width !== width || canvas.height !== height) {
+                            canvas.width = width;
+                            canvas.height = height;
+                        }
+                        ctx.drawImage(bmp, 0, 0);
+                    } else {
+                        const perRow = Math.ceil(width / tw);
+                        for (let i = 0; i < count; i++) {
+                            const t = v.getUint16(20 + 2 * i);
+                            ctx.drawImage(bmp, 0, i * th, tw, th,
+                                          (t % perRow) * tw, Math.floor(t / perRow) * th, tw, th);
+                        }
+                    }
+                    bmp.close();
+                    buf = buf.slice(total);
+                }
+            }
+        }
+        
+        function toggleDelta() {
+            const btn = document.getElementById('btn-delta');
+            const canvas = document.getElementById('delta');
+            const img = document.getElementById('stream');
+            if (deltaAbort) {
+                deltaAbort.abort();
+                return;
+            }
+            if (streaming) toggleStream();
+            img.style.display = 'none';
+            canvas.style.display = 'block';
+            btn.textContent = 'Stop Delta';
+            btn.classList.add('stop');
+            deltaAbort = new AbortController();
+            runDelta(deltaAbort.signal).catch(e => console.error('Delta error:', e)).finally(() => {
+                deltaAbort = null;
+                canvas.style.display = 'none';
+                img.style.display = 'block';
+                btn.textContent = 'Delta Stream';
+                btn.classList.remove('stop');
+            });
+        }
+        
         function capturePhoto() {
             document.getElementById('stream').src = '/capture?' + Date.now();
         }
@@ -222,23 +513,40 @@ private:
             } catch (e) { console.error('Config error:', e); }
         }
         
+        // Events carry only changed fields, so update what is present
+        function applyStats(data) {
+            for (const key of ['captured', 'sent', 'dropped', 'buffered']) {
+                if (key in data) document.getElementById(key).textContent = data[key];
+            }
+            if ('heap' in data) document.getElementById('heap').textContent = Math.floor(data.heap / 1024);
+            if ('rssi' in data) document.getElementById('rssi').textContent = data.rssi || '--';
+            if ('resolution' in data) document.getElementById('resolution').value = data.resolution;
+            if ('quality' in data) document.getElementById('quality').value = data.quality;
+        }
+        
         async function updateStats() {
             try {
                 const response = await fetch('/status');
-                const data = await response.json();
-                document.getElementById('captured').textContent = data.captured || 0;
-                document.getElementById('sent').textContent = data.sent || 0;
-                document.getElementById('dropped').textContent = data.dropped || 0;
-                document.getElementById('buffered').textContent = data.buffered || 0;
-                document.getElementById('heap').textContent = Math.floor((data.heap || 0) / 1024);
-                document.getElementById('rssi').textContent = data.rssi || '--';
-                document.getElementById('resolution').value = data.resolution || 2;
-                document.getElementById('quality').value = data.quality || 20;
+                applyStats(await response.json());
             } catch (e) { console.error('Stats error:', e); }
         }
         
-        updateStats();
-        statsInterval = setInterval(updateStats, 2000);
+        function startPolling() {
+            if (statsInterval) return;
+            updateStats();
+            statsInterval = setInterval(updateStats, 2000);
+        }
+        
+        // Push updates over SSE; poll /status if unsupported or refused (503)
+        if (window.EventSource) {
+            const events = new EventSource('/events');
+            events.addEventListener('status', e => applyStats(JSON.parse(e.data)));
+            events.onerror = () => {
+                if (events.readyState === EventSource.CLOSED) startPolling();
+            };
+        } else {
+            startPolling();
+        }
         
         document.getElementById('stream').onerror = function() {
             if (streaming) {
@@ -266,13 +574,53 @@ private:
                                     .handler = capture_handler, .user_ctx = this };
         httpd_register_uri_handler(server_, &uri_capture);
         
+        httpd_uri_t uri_burst = { .uri = "/burst", .method = HTTP_GET,
+                                  .handler = burst_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_burst);
+        
+        httpd_uri_t uri_frame = { .uri = "/frame", .method = HTTP_GET,
+                                  .handler = frame_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_frame);
+        
         httpd_uri_t uri_status = { .uri = "/status", .method = HTTP_GET,
                                    .handler = status_handler, .user_ctx = this };
         httpd_register_uri_handler(server_, &uri_status);
         
+        httpd_uri_t uri_admission = { .uri = "/admission", .method = HTTP_GET,
+                                      .handler = admission_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_admission);
+        
+        httpd_uri_t uri_egress = { .uri = "/egress", .method = HTTP_GET,
+                                   .handler = egress_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_egress);
+        
+        httpd_uri_t uri_events = { .uri = "/events", .method = HTTP_GET,
+                                   .handler = events_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_events);
+        
+        httpd_uri_t uri_sdp = { .uri = "/stream.sdp", .method = HTTP_GET,
+                                .handler = sdp_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_sdp);
+        
+        httpd_uri_t uri_delta = { .uri = "/delta", .method = HTTP_GET,
+                                  .handler = delta_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_delta);
+        
         httpd_uri_t uri_config = { .uri = "/config", .method = HTTP_POST,
                                    .handler = config_handler, .user_ctx = this };
         httpd_register_uri_handler(server_, &uri_config);
+        
+        httpd_uri_t uri_cam = { .uri = "/cam/*", .method = HTTP_GET,
+                                .handler = camera_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_cam);
+        
+        httpd_uri_t uri_recordings = { .uri = "/recordings", .method = HTTP_GET,
+                                       .handler = recordings_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_recordings);
+        
+        httpd_uri_t uri_recording = { .uri = "/recordings/*", .method = HTTP_GET,
+                                      .handler = recording_handler, .user_ctx = this };
+        httpd_register_uri_handler(server_, &uri_recording);
     }
     
     static esp_err_t index_handler(httpd_req_t* req) {
@@ -286,13 +634,74 @@ private:
         auto* self = static_cast<WebServer*>(req->user_ctx);
         self->stats_.total_requests++;
         
-        // Single client check
-        if (self->config_.single_client_stream && self->stats_.stream_clients.load() > 0) {
+        // Optional region of interest: /stream?roi=x,y,w,h
+        // Optional playback: /stream?from=-10s[&speed=2]
+        StreamJob params;
+        params.kind = StreamJob::Kind::Live;
+        char query[96];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+            char value[32];
+            if (httpd_query_key_value(query, "roi", value, sizeof(value)) == ESP_OK) {
+                if (!self->roi_cache_.is_initialized() || !parse_roi(value, &params.roi)) {
+                    httpd_resp_set_status(req, "400 Bad Request");
+                    return httpd_resp_send(req, "Invalid roi", HTTPD_RESP_USE_STRLEN);
+                }
+                params.use_roi = true;
+            }
+            if (httpd_query_key_value(query, "from", value, sizeof(value)) == ESP_OK) {
+                if (!self->history_ || !parse_time_offset(value, &params.from_us)) {
+                    httpd_resp_set_status(req, "400 Bad Request");
+                    return httpd_resp_send(req, "Invalid from", HTTPD_RESP_USE_STRLEN);
+                }
+                params.use_history = true;
+            }
+            if (httpd_query_key_value(query, "speed", value, sizeof(value)) == ESP_OK) {
+                params.speed = strtof(value, nullptr);
+                if (!(params.speed >= MIN_PLAYBACK_SPEED && params.speed <= MAX_PLAYBACK_SPEED)) {
+                    httpd_resp_set_status(req, "400 Bad Request");
+                    return httpd_resp_send(req, "Invalid speed", HTTPD_RESP_USE_STRLEN);
+                }
+            }
+        }
+        if (!parse_class_query(req, &params.cls)) {
+            httpd_resp_set_status(req, "400 Bad Request");
+            return httpd_resp_send(req, "Invalid class", HTTPD_RESP_USE_STRLEN);
+        }
+        
+        if (!self->stream_slot_free()) {
             httpd_resp_set_status(req, "503 Service Unavailable");
             return httpd_resp_send(req, "Stream busy", HTTPD_RESP_USE_STRLEN);
         }
         
-        self->stats_.stream_clients++;
+        // Playback and ROI streams send blocking, so every frame they do not
+        // send from the crop cache is first copied into a per-client buffer
+        if (params.use_history || params.use_roi) {
+            params.replay_buf = static_cast<uint8_t*>(
+                heap_caps_malloc(self->streaming_.max_frame_size(), MALLOC_CAP_SPIRAM));
+            if (!params.replay_buf) {
+                httpd_resp_set_status(req, "503 Service Unavailable");
+                return httpd_resp_send(req, "No memory for stream", HTTPD_RESP_USE_STRLEN);
+            }
+        }
+        return self->dispatch_stream(req, params);
+    }
+    
+    // /stream body, on a stream worker (or the server task without workers)
+    void serve_live_stream(StreamJob& job) {
+        if (!job.use_roi && !job.use_history) {
+            serve_mjpeg(job, streaming_);
+            return;
+        }
+        httpd_req_t* req = job.req;
+        HistoryPlayer player;
+        size_t replay_cap = streaming_.max_frame_size();
+        bool use_history = job.use_history &&
+                           player.start(*history_, job.from_us, job.speed, esp_timer_get_time());
+        // After playback catches up, continue live from its last sequence
+        // via pinned reads so no frame is skipped or repeated
+        bool follow_sequence = false;
+        uint32_t last_sequence = 0;
+        
         ESP_LOGI(TAG, "Stream client connected");
         
         httpd_resp_set_type(req, MJPEG_CONTENT_TYPE);
@@ -300,40 +709,230 @@ private:
         httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
         
         char part_header[128];
+        int64_t next_frame_us = 0;
         
-        while (true) {
+        while (!stream_pool_.stopping()) {
+            pace_stream(job, &next_frame_us);
             const uint8_t* data = nullptr;
             size_t size = 0;
+            int64_t timestamp_us = 0;
+            uint32_t sequence = 0;
+            FrameSource source = FrameSource::Stream;
+            bool frame_held = false;   // Ring slot from get_frame()
+            int pin_handle = -1;       // Ring slot from acquire_frame_after()
             
-            // Get frame from streaming service (blocks until available)
-            if (!self->streaming_.get_frame(&data, &size, 500)) {
-                // Timeout - check if we should continue
-                if (!self->streaming_.is_running()) break;
-                continue;
+            if (use_history) {
+                HistoryEntry entry;
+                int64_t wait_us = 0;
+                auto step = player.poll(esp_timer_get_time(), &entry, &wait_us);
+                if (step == HistoryPlayer::Step::Wait) {
+                    uint32_t wait_ms = static_cast<uint32_t>(wait_us / 1000);
+                    vTaskDelay(pdMS_TO_TICKS(wait_ms < 100 ? (wait_ms ? wait_ms : 1) : 100));
+                    continue;
+                }
+                if (step == HistoryPlayer::Step::Live) {
+                    use_history = false;
+                    follow_sequence = true;
+                    last_sequence = player.last_sequence();
+                    continue;
+                }
+                if (!history_->read(entry, job.replay_buf, replay_cap)) continue;  // Evicted
+                data = job.replay_buf;
+                size = entry.size;
+                timestamp_us = entry.timestamp_us;
+                sequence = entry.sequence;
+                source = FrameSource::History;
+            } else if (follow_sequence) {
+                pin_handle = streaming_.acquire_frame_after(last_sequence, &data, &size, 500,
+                                                            &timestamp_us, &sequence);
+                if (pin_handle < 0) {
+                    if (!streaming_.is_running()) break;
+                    continue;
+                }
+                last_sequence = sequence;
+            } else {
+                // Get frame from streaming service (blocks until available)
+                if (!streaming_.get_frame(&data, &size, 500, &timestamp_us, &sequence)) {
+                    // Timeout - check if we should continue
+                    if (!streaming_.is_running()) break;
+                    continue;
+                }
+                frame_held = true;
+            }
+            
+            // Swap in the shared crop (keyed by ring sequence, so replayed
+            // frames reuse it too). If cropping fails the full frame is sent
+            // instead, from a copy: either way the ring slot is freed before
+            // the blocking send, so a stalled client cannot hold it.
+            int crop_handle = -1;
+            if (job.use_roi) {
+                const uint8_t* crop_data = nullptr;
+                size_t crop_size = 0;
+                crop_handle = roi_cache_.acquire(sequence, job.roi, data, size,
+                                                 &crop_data, &crop_size);
+                if (crop_handle >= 0) {
+                    if (frame_held) streaming_.release_frame();
+                    if (pin_handle >= 0) streaming_.release_acquired_frame(pin_handle);
+                    frame_held = false;
+                    pin_handle = -1;
+                    data = crop_data;
+                    size = crop_size;
+                }
+            }
+            if (frame_held || pin_handle >= 0) {
+                bool fits = size <= replay_cap;
+                if (fits) memcpy(job.replay_buf, data, size);
+                if (frame_held) streaming_.release_frame();
+                if (pin_handle >= 0) streaming_.release_acquired_frame(pin_handle);
+                if (!fits) continue;
+                data = job.replay_buf;
             }
             
+            uint8_t meta_segment[JPEG_METADATA_SEGMENT_SIZE];
+            JpegSplice splice = make_splice(data, size,
+                {sequence, timestamp_us, source}, meta_segment);
+            
             // Send MJPEG part header
             int hdr_len = snprintf(part_header, sizeof(part_header),
                 "\r\n--" MJPEG_BOUNDARY "\r\n"
                 "Content-Type: image/jpeg\r\n"
-                "Content-Length: %zu\r\n\r\n", size);
+                "Content-Length: %zu\r\n\r\n", splice.total());
             
-            esp_err_t res = httpd_resp_send_chunk(req, part_header, hdr_len);
-            if (res != ESP_OK) {
-                self->streaming_.release_frame();
-                break;
-            }
+            // Over the class's rate: drop this frame, take the next
+            esp_err_t res = ESP_OK;
+            bool send = schedule_frame(job, hdr_len + splice.total());
+            int64_t send_start_us = esp_timer_get_time();
+            if (send) res = httpd_resp_send_chunk(req, part_header, hdr_len);
             
             // Send frame data
-            res = httpd_resp_send_chunk(req, reinterpret_cast<const char*>(data), size);
-            self->streaming_.release_frame();
+            if (send && res == ESP_OK) {
+                res = send_splice(req, splice);
+            }
+            if (send && res == ESP_OK) {
+                int64_t now = esp_timer_get_time();
+                egress_.on_frame(hdr_len + splice.total(), static_cast<uint32_t>(now - send_start_us), now);
+            }
+            
+            if (crop_handle >= 0) roi_cache_.release(crop_handle);
             
             if (res != ESP_OK) break;
         }
         
-        self->stats_.stream_clients--;
         ESP_LOGI(TAG, "Stream client disconnected");
-        return ESP_OK;
+    }
+    
+    // Live stream of delta records (see jpeg_delta.hpp). Each client has its
+    // own encoder: it tracks which tiles that client's canvas shows.
+    static esp_err_t delta_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        
+        if (!self->stream_slot_free()) {
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            return httpd_resp_send(req, "Stream busy", HTTPD_RESP_USE_STRLEN);
+        }
+        
+        JpegDeltaConfig delta_config;
+        delta_config.tile_mcus = self->config_.delta_tile_mcus;
+        delta_config.key_interval = self->config_.delta_key_interval;
+        StreamJob params;
+        params.kind = StreamJob::Kind::Delta;
+        if (!parse_class_query(req, &params.cls)) {
+            httpd_resp_set_status(req, "400 Bad Request");
+            return httpd_resp_send(req, "Invalid class", HTTPD_RESP_USE_STRLEN);
+        }
+        params.encoder = new (std::nothrow) JpegDeltaEncoder();
+        if (!params.encoder || !params.encoder->init(self->streaming_.max_frame_size(),
+                                                     MAX_DELTA_TILES, delta_config, true)) {
+            delete params.encoder;
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            return httpd_resp_send(req, "No memory for delta stream", HTTPD_RESP_USE_STRLEN);
+        }
+        // Key records are the source frame: copied here before sending
+        params.replay_buf = static_cast<uint8_t*>(
+            heap_caps_malloc(self->streaming_.max_frame_size(), MALLOC_CAP_SPIRAM));
+        if (!params.replay_buf) {
+            free_stream_job_buffers(params);
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            return httpd_resp_send(req, "No memory for delta stream", HTTPD_RESP_USE_STRLEN);
+        }
+        return self->dispatch_stream(req, params);
+    }
+    
+    void serve_delta_stream(StreamJob& job) {
+        httpd_req_t* req = job.req;
+        JpegDeltaEncoder* encoder = job.encoder;
+        ESP_LOGI(TAG, "Delta client connected");
+        
+        httpd_resp_set_type(req, "application/octet-stream");
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+        
+        // Pinned reads: every frame is compared against what the client shows,
+        // so none may be skipped between acquire and release
+        uint32_t last_sequence = streaming_.last_sequence();
+        int64_t next_frame_us = 0;
+        size_t last_record_bytes = 0;
+        esp_err_t res = ESP_OK;
+        while (res == ESP_OK && !stream_pool_.stopping()) {
+            pace_stream(job, &next_frame_us);
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            int64_t timestamp_us = 0;
+            uint32_t sequence = 0;
+            int handle = streaming_.acquire_frame_after(last_sequence, &data, &size, 500,
+                                                        &timestamp_us, &sequence);
+            if (handle < 0) {
+                if (!streaming_.is_running()) break;
+                continue;
+            }
+            last_sequence = sequence;
+            
+            // Asked before encoding (the encoder tracks what the client
+            // shows, so a record cannot be dropped once made): at the size
+            // of the previous record, or of the frame for the first
+            if (!schedule_frame(job, last_record_bytes ? last_record_bytes : size)) {
+                streaming_.release_acquired_frame(handle);
+                continue;
+            }
+            
+            // The ring slot is freed before the blocking send, so a stalled
+            // client cannot hold it: patches live in the encoder, key
+            // records point into the frame and are copied out first
+            DeltaRecord record;
+            bool encoded = encoder->encode(data, size, sequence, &record) && !record.empty();
+            if (encoded && record.jpeg == data) {
+                encoded = record.jpeg_size <= streaming_.max_frame_size();
+                if (encoded) {
+                    memcpy(job.replay_buf, data, record.jpeg_size);
+                    record.jpeg = job.replay_buf;
+                } else {
+                    encoder->reset();   // Not sent: the client needs the next key
+                }
+            }
+            streaming_.release_acquired_frame(handle);
+            if (encoded) {
+                last_record_bytes = record.header_size + record.jpeg_size;
+                int64_t send_start_us = esp_timer_get_time();
+                res = httpd_resp_send_chunk(req, reinterpret_cast<const char*>(record.header),
+                                            record.header_size);
+                if (res == ESP_OK) {
+                    res = httpd_resp_send_chunk(req, reinterpret_cast<const char*>(record.jpeg),
+                                                record.jpeg_size);
+                }
+                if (res == ESP_OK) {
+                    int64_t now = esp_timer_get_time();
+                    egress_.on_frame(record.header_size + record.jpeg_size,
+                                     static_cast<uint32_t>(now - send_start_us), now);
+                }
+            }
+        }
+        
+        const auto& ds = encoder->stats();
+        ESP_LOGI(TAG, "Delta client disconnected (%lu keys, %lu patches, %llu of %llu bytes)",
+                 static_cast<unsigned long>(ds.keys), static_cast<unsigned long>(ds.patches),
+                 static_cast<unsigned long long>(ds.sent_bytes),
+                 static_cast<unsigned long long>(ds.source_bytes));
     }
     
     static esp_err_t capture_handler(httpd_req_t* req) {
@@ -345,71 +944,1127 @@ private:
             return httpd_resp_send_500(req);
         }
         
-        httpd_resp_set_type(req, "image/jpeg");
-        httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=capture.jpg");
-        esp_err_t res = httpd_resp_send(req, reinterpret_cast<const char*>(frame.data), frame.size);
+        uint8_t meta_segment[JPEG_METADATA_SEGMENT_SIZE];
+        JpegSplice splice = self->make_splice(frame.data, frame.size,
+            {++self->snapshot_sequence_, frame.timestamp_us, FrameSource::Snapshot}, meta_segment);
+        esp_err_t res = send_splice_response(req, splice,
+            "Content-Disposition: inline; filename=capture.jpg\r\n");
         
         self->camera_.release_frame();
         self->stats_.captures_served++;
         return res;
     }
     
-    static esp_err_t status_handler(httpd_req_t* req) {
+    // /burst?n=<frames>&interval=<ms>: takes over the producer for n frames
+    // (interval 0 = sensor rate) and streams each one out of the burst arena
+    // as soon as it is captured, on a stream worker. The last part is the
+    // JSON report.
+    static esp_err_t burst_handler(httpd_req_t* req) {
         auto* self = static_cast<WebServer*>(req->user_ctx);
         self->stats_.total_requests++;
         
-        // Get RSSI
-        wifi_ap_record_t ap_info;
-        int rssi = 0;
-        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-            rssi = ap_info.rssi;
+        if (!self->burst_ || !self->streaming_.is_running()) {
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            return httpd_resp_send(req, "Burst capture unavailable", HTTPD_RESP_USE_STRLEN);
+        }
+        return self->dispatch_request(req, serve_burst);
+    }
+    
+    // /burst body (RequestFn)
+    static esp_err_t serve_burst(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        uint16_t count = self->config_.burst_max_frames < 10 ? self->config_.burst_max_frames : 10;
+        uint32_t interval_ms = 0;
+        char query[48];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+            char value[12];
+            if (httpd_query_key_value(query, "n", value, sizeof(value)) == ESP_OK &&
+                !parse_burst_count(value, self->config_.burst_max_frames, &count)) {
+                char msg[48];
+                snprintf(msg, sizeof(msg), "n must be 1-%u",
+                         static_cast<unsigned>(self->config_.burst_max_frames));
+                httpd_resp_set_status(req, "400 Bad Request");
+                return httpd_resp_send(req, msg, HTTPD_RESP_USE_STRLEN);
+            }
+            if (httpd_query_key_value(query, "interval", value, sizeof(value)) == ESP_OK) {
+                interval_ms = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            }
+        }
+        if (!self->burst_->begin(count, interval_ms)) {
+            httpd_resp_set_status(req, "409 Conflict");
+            return httpd_resp_send(req, "Burst in progress", HTTPD_RESP_USE_STRLEN);
+        }
+        
+        httpd_resp_set_type(req, "multipart/mixed; boundary=" BURST_BOUNDARY);
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+        
+        uint32_t timeout_ms = self->config_.burst_frame_timeout_ms +
+                              self->burst_->report().interval_ms;
+        char part_header[160];
+        esp_err_t res = ESP_OK;
+        BurstFrame frame;
+        for (uint16_t i = 0; res == ESP_OK; i++) {
+            if (self->burst_->wait_frame(i, &frame, timeout_ms) != BurstWait::Frame) break;
+            
+            uint8_t meta_segment[JPEG_METADATA_SEGMENT_SIZE];
+            JpegSplice splice = self->make_splice(frame.data, frame.size,
+                {static_cast<uint32_t>(i) + 1, frame.timestamp_us, FrameSource::Burst}, meta_segment);
+            int hdr_len = snprintf(part_header, sizeof(part_header),
+                "--" BURST_BOUNDARY "\r\n"
+                "Content-Type: image/jpeg\r\n"
+                "Content-Length: %zu\r\n"
+                "X-Frame-Index: %u\r\n"
+                "X-Frame-Timestamp: %lld\r\n\r\n",
+                splice.total(), i, static_cast<long long>(frame.timestamp_us));
+            res = httpd_resp_send_chunk(req, part_header, hdr_len);
+            if (res == ESP_OK) res = send_splice(req, splice);
+            if (res == ESP_OK) res = httpd_resp_send_chunk(req, "\r\n", 2);
+        }
+        
+        // A client that went away ends the burst early (end() cancels it)
+        BurstReport report = self->burst_->report();
+        self->burst_->end();
+        ESP_LOGI(TAG, "Burst: %u/%u frames, interval %lld..%lld us (mean %lld), arena %zu/%zu bytes%s",
+                 report.frames, report.requested,
+                 static_cast<long long>(report.interval_min_us),
+                 static_cast<long long>(report.interval_max_us),
+                 static_cast<long long>(report.interval_mean_us),
+                 report.arena_used, report.arena_size, report.truncated ? " (truncated)" : "");
+        if (res != ESP_OK) return res;
+        
+        char json[384];
+        size_t json_len = format_burst_report_json(report, json, sizeof(json));
+        int hdr_len = snprintf(part_header, sizeof(part_header),
+            "--" BURST_BOUNDARY "\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: %zu\r\n\r\n", json_len);
+        res = httpd_resp_send_chunk(req, part_header, hdr_len);
+        if (res == ESP_OK) res = httpd_resp_send_chunk(req, json, json_len);
+        if (res == ESP_OK) res = httpd_resp_send_chunk(req, "\r\n--" BURST_BOUNDARY "--\r\n", HTTPD_RESP_USE_STRLEN);
+        if (res == ESP_OK) res = httpd_resp_send_chunk(req, nullptr, 0);
+        self->stats_.bursts_served++;
+        return res;
+    }
+    
+    // Long-poll: /frame?after=<seq>&timeout=<ms> returns the newest ring frame
+    // with sequence > after, waiting up to timeout for one. 204 on timeout.
+    // A waiting poll is served by a stream worker so the server task keeps
+    // answering; without workers the wait is cut to INLINE_POLL_MAX_MS.
+    static esp_err_t frame_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        
+        uint32_t after = 0;
+        uint32_t timeout_ms = 0;
+        self->parse_frame_poll(req, &after, &timeout_ms);
+        if (timeout_ms == 0) return serve_frame_poll(req);
+        return self->dispatch_request(req, serve_frame_poll);
+    }
+    
+    void parse_frame_poll(httpd_req_t* req, uint32_t* after, uint32_t* timeout_ms) const {
+        char query[64];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+            char value[16];
+            if (httpd_query_key_value(query, "after", value, sizeof(value)) == ESP_OK) {
+                *after = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            }
+            if (httpd_query_key_value(query, "timeout", value, sizeof(value)) == ESP_OK) {
+                *timeout_ms = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            }
+        }
+        uint32_t max_ms = stream_pool_.is_initialized() ? config_.frame_poll_max_timeout_ms
+                                                        : INLINE_POLL_MAX_MS;
+        if (*timeout_ms > max_ms) *timeout_ms = max_ms;
+    }
+    
+    // /frame body (RequestFn)
+    static esp_err_t serve_frame_poll(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        uint32_t after = 0;
+        uint32_t timeout_ms = 0;
+        self->parse_frame_poll(req, &after, &timeout_ms);
+        
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        int64_t timestamp_us = 0;
+        uint32_t sequence = 0;
+        int handle = self->streaming_.acquire_frame_after(after, &data, &size, timeout_ms,
+                                                          &timestamp_us, &sequence);
+        
+        if (handle < 0) {
+            // Let the client resume from where the ring is now
+            char seq_hdr[12];
+            snprintf(seq_hdr, sizeof(seq_hdr), "%lu",
+                     static_cast<unsigned long>(self->streaming_.last_sequence()));
+            httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+            httpd_resp_set_hdr(req, "Access-Control-Expose-Headers", "X-Frame-Sequence, X-Frame-Timestamp");
+            httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+            httpd_resp_set_hdr(req, "X-Frame-Sequence", seq_hdr);
+            httpd_resp_set_status(req, "204 No Content");
+            return httpd_resp_send(req, nullptr, 0);
+        }
+        
+        char headers[192];
+        snprintf(headers, sizeof(headers),
+            "Access-Control-Allow-Origin: *\r\n"
+            "Access-Control-Expose-Headers: X-Frame-Sequence, X-Frame-Timestamp\r\n"
+            "Cache-Control: no-store\r\n"
+            "X-Frame-Sequence: %lu\r\n"
+            "X-Frame-Timestamp: %lld\r\n",
+            static_cast<unsigned long>(sequence), static_cast<long long>(timestamp_us));
+        
+        uint8_t meta_segment[JPEG_METADATA_SEGMENT_SIZE];
+        JpegSplice splice = self->make_splice(data, size,
+            {sequence, timestamp_us, FrameSource::Stream}, meta_segment);
+        esp_err_t res = send_splice_response(req, splice, headers);
+        
+        self->streaming_.release_acquired_frame(handle);
+        self->stats_.frames_polled++;
+        return res;
+    }
+    
+    // /cam/<id>/stream: MJPEG from one registry camera. Pinned reads, so
+    // several viewers of the same camera each see every frame.
+    // /cam/<id>/frame?after=<seq>: newest frame after seq (1 s wait on a
+    // stream worker, 204 on timeout)
+    // /cam/<id>/status: that pipeline's counters
+    static esp_err_t camera_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        
+        char id[CAMERA_ID_MAX_LENGTH + 1];
+        char endpoint[16];
+        StreamingService* svc = nullptr;
+        if (self->cameras_ &&
+            parse_camera_path(req->uri, id, sizeof(id), endpoint, sizeof(endpoint))) {
+            svc = self->cameras_->find(id);
+        }
+        if (!svc) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown camera");
+        }
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        
+        if (strcmp(endpoint, "status") == 0) {
+            const StreamingStats& st = svc->stats();
+            const CaptureRecoveryStats& rs = svc->recovery_stats();
+            char json[384];
+            int len = snprintf(json, sizeof(json),
+                "{\"id\":\"%s\",\"running\":%s,\"fps\":%u,\"captured\":%lu,"
+                "\"sent\":%lu,\"dropped\":%lu,\"errors\":%lu,\"buffered\":%u,"
+                "\"health\":\"%s\",\"outages\":%lu,\"resets\":%lu,\"reinits\":%lu,"
+                "\"recovery_ms\":%lu,\"mtbf_s\":%lu}",
+                id, svc->is_running() ? "true" : "false", svc->get_target_fps(),
+                static_cast<unsigned long>(st.frames_captured.load()),
+                static_cast<unsigned long>(st.frames_sent.load()),
+                static_cast<unsigned long>(st.frames_dropped.load()),
+                static_cast<unsigned long>(st.capture_errors.load()),
+                static_cast<unsigned>(svc->buffered_frames()),
+                camera_health_name(svc->health()),
+                static_cast<unsigned long>(rs.episodes.load()),
+                static_cast<unsigned long>(rs.sensor_resets.load()),
+                static_cast<unsigned long>(rs.reinits.load()),
+                static_cast<unsigned long>(rs.recovery_us_last.load() / 1000),
+                static_cast<unsigned long>(rs.mtbf_us() / 1000000));
+            httpd_resp_set_type(req, "application/json");
+            return httpd_resp_send(req, json, len);
+        }
+        
+        if (strcmp(endpoint, "stream") == 0) {
+            StreamJob params;
+            params.kind = StreamJob::Kind::Camera;
+            params.svc = svc;
+            if (!parse_class_query(req, &params.cls)) {
+                httpd_resp_set_status(req, "400 Bad Request");
+                return httpd_resp_send(req, "Invalid class", HTTPD_RESP_USE_STRLEN);
+            }
+            return self->dispatch_stream(req, params);
+        }
+        if (strcmp(endpoint, "frame") != 0) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown endpoint");
+        }
+        return self->dispatch_request(req, serve_camera_frame);
+    }
+    
+    // /cam/<id>/frame body (RequestFn); the camera is looked up again, as
+    // the handler's lookup does not travel with the request
+    static esp_err_t serve_camera_frame(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        char id[CAMERA_ID_MAX_LENGTH + 1];
+        char endpoint[16];
+        StreamingService* svc = nullptr;
+        if (parse_camera_path(req->uri, id, sizeof(id), endpoint, sizeof(endpoint))) {
+            svc = self->cameras_->find(id);
+        }
+        if (!svc) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown camera");
+        }
+        
+        uint32_t last_sequence = 0;
+        char query[32];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+            char value[16];
+            if (httpd_query_key_value(query, "after", value, sizeof(value)) == ESP_OK) {
+                last_sequence = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            }
+        }
+        uint32_t timeout_ms = self->stream_pool_.is_initialized() ? CAMERA_POLL_MS : INLINE_POLL_MAX_MS;
+        
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        int64_t timestamp_us = 0;
+        uint32_t sequence = 0;
+        int handle = svc->acquire_frame_after(last_sequence, &data, &size, timeout_ms,
+                                              &timestamp_us, &sequence);
+        if (handle < 0) {
+            httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+            httpd_resp_set_status(req, "204 No Content");
+            return httpd_resp_send(req, nullptr, 0);
+        }
+        uint8_t meta_segment[JPEG_METADATA_SEGMENT_SIZE];
+        JpegSplice splice = self->make_splice(data, size,
+            {sequence, timestamp_us, FrameSource::Stream}, meta_segment);
+        esp_err_t res = send_splice_response(req, splice, "Access-Control-Allow-Origin: *\r\n");
+        svc->release_acquired_frame(handle);
+        self->stats_.frames_polled++;
+        return res;
+    }
+    
+    // /cam/<id>/stream body
+    void serve_camera_stream(StreamJob& job) {
+        serve_mjpeg(job, *job.svc);
+    }
+    
+    // Socket of a stream served by MjpegSender
+    struct StreamSocket {
+        httpd_handle_t server;
+        int fd;
+    };
+    
+    // SocketWriteFn: send what the socket takes now, never wait
+    static int32_t stream_socket_write(void* context, const uint8_t* data, size_t size) {
+        auto* sock = static_cast<StreamSocket*>(context);
+        int sent = httpd_socket_send(sock->server, sock->fd, reinterpret_cast<const char*>(data),
+                                     size, MSG_DONTWAIT);
+        if (sent >= 0) return sent;
+        return sent == HTTPD_SOCK_ERR_TIMEOUT ? 0 : -1;   // EAGAIN maps to TIMEOUT
+    }
+    
+    static void wait_writable(int fd, uint32_t timeout_ms) {
+        fd_set writable;
+        FD_ZERO(&writable);
+        FD_SET(fd, &writable);
+        struct timeval tv = {0, static_cast<long>(timeout_ms * 1000)};
+        select(fd + 1, nullptr, &writable, nullptr, &tv);
+    }
+    
+    // Plain MJPEG from a ring: the response is written straight to the
+    // socket without blocking, so a stalled client holds neither this task
+    // for send_wait_timeout nor a ring slot past the service's lease timeout
+    void serve_mjpeg(StreamJob& job, StreamingService& svc) {
+        StreamSocket sock = {server_, httpd_req_to_sockfd(job.req)};
+        MjpegSenderConfig sender_config;
+        sender_config.stall_budget_ms = config_.stream_stall_budget_ms;
+        sender_config.embed_metadata = config_.embed_metadata;
+        sender_config.min_interval_ms = job.fps ? 1000 / job.fps : 0;
+        sender_config.meter = &egress_;
+        sender_config.scheduler = scheduler_;
+        sender_config.consumer_class = job.cls;
+        MjpegSender sender;
+        sender.begin(svc, stream_socket_write, &sock, MJPEG_RESPONSE_HEAD, sender_config,
+                     esp_timer_get_time());
+        
+        ESP_LOGI(TAG, "Stream client connected");
+        SendStep step = SendStep::Sent;
+        while (!stream_pool_.stopping()) {
+            step = sender.poll(esp_timer_get_time());
+            if (step == SendStep::Closed || step == SendStep::Evicted) break;
+            if (step == SendStep::Blocked) {
+                wait_writable(sock.fd, 50);
+            } else if (step == SendStep::Idle) {
+                int64_t pace_us = sender.resume_at_us() - esp_timer_get_time();
+                if (pace_us > 0) {
+                    vTaskDelay(pdMS_TO_TICKS(pace_us / 1000 + 1));
+                } else if (!svc.wait_frame_after(sender.last_sequence(), 500) && !svc.is_running()) {
+                    break;
+                }
+            }
+        }
+        sender.end();
+        
+        const auto& ss = sender.stats();
+        stats_.stream_frames_skipped += ss.frames_skipped.load();
+        stats_.stream_frames_truncated += ss.frames_truncated.load();
+        stats_.stream_frames_deferred += ss.frames_deferred.load();
+        if (step == SendStep::Evicted) {
+            stats_.stream_evictions++;
+            ESP_LOGW(TAG, "Stream client evicted: no progress for %lu ms",
+                     static_cast<unsigned long>(config_.stream_stall_budget_ms));
+        }
+        ESP_LOGI(TAG, "Stream client disconnected (%s, sent=%lu skipped=%lu deferred=%lu)",
+                 consumer_class_name(job.cls),
+                 static_cast<unsigned long>(ss.frames_sent.load()),
+                 static_cast<unsigned long>(ss.frames_skipped.load()),
+                 static_cast<unsigned long>(ss.frames_deferred.load()));
+        // The response was not framed by httpd: the connection ends with it
+        job.close_fd = sock.fd;
+    }
+    
+    // /recordings?from=<s>&to=<s>: clips overlapping the range (Unix seconds
+    // of the store's clock), oldest first, answered from the catalog index.
+    // "more" means the list was cut at recordings_max_list: ask again from
+    // the last end.
+    static esp_err_t recordings_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        if (!self->recordings_) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Recording disabled");
+        }
+        
+        int64_t from_us = 0;
+        int64_t to_us = INT64_MAX;
+        char query[64];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+            char value[24];
+            if ((httpd_query_key_value(query, "from", value, sizeof(value)) == ESP_OK &&
+                 !parse_unix_seconds(value, &from_us)) ||
+                (httpd_query_key_value(query, "to", value, sizeof(value)) == ESP_OK &&
+                 !parse_unix_seconds(value, &to_us))) {
+                httpd_resp_set_status(req, "400 Bad Request");
+                return httpd_resp_send(req, "Invalid from/to", HTTPD_RESP_USE_STRLEN);
+            }
+        }
+        
+        size_t max = self->config_.recordings_max_list;
+        auto* clips = new (std::nothrow) ClipSummary[max ? max : 1];
+        if (!clips) return httpd_resp_send_500(req);
+        bool more = false;
+        size_t n = self->recordings_->query(from_us, to_us, clips, max, &more);
+        
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        esp_err_t res = httpd_resp_send_chunk(req, "{\"clips\":[", HTTPD_RESP_USE_STRLEN);
+        char json[192];
+        for (size_t i = 0; i < n && res == ESP_OK; i++) {
+            json[0] = ',';
+            size_t len = format_clip_json(clips[i], json + 1, sizeof(json) - 1);
+            res = httpd_resp_send_chunk(req, i ? json : json + 1, i ? len + 1 : len);
         }
+        delete[] clips;
+        if (res == ESP_OK) {
+            res = httpd_resp_send_chunk(req, more ? "],\"more\":true}" : "],\"more\":false}",
+                                        HTTPD_RESP_USE_STRLEN);
+        }
+        if (res == ESP_OK) res = httpd_resp_send_chunk(req, nullptr, 0);
+        return res;
+    }
+    
+    // /recordings/<id>.mjpeg: the clip's frames back to back (plays in
+    // ffplay/VLC), honouring a single-range Range header.
+    // /recordings/<id>.zip|.tar: the clip's frames as numbered JPEG files.
+    // /recordings/<id>/thumb?n=<i>: the clip's i-th thumbnail.
+    // Downloads are sent from a stream worker.
+    static esp_err_t recording_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
         
-        auto& stream_stats = self->streaming_.stats();
+        uint32_t id = 0;
+        char name[16];
+        ClipSummary clip;
+        if (!self->recordings_ || !parse_recording_path(req->uri, &id, name, sizeof(name)) ||
+            !self->recordings_->find(id, &clip)) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown recording");
+        }
+        
+        if (strcmp(name, "thumb") == 0) {
+            httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+            uint16_t index = 0;
+            char query[32];
+            if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+                char value[8];
+                if (httpd_query_key_value(query, "n", value, sizeof(value)) == ESP_OK) {
+                    index = static_cast<uint16_t>(atoi(value));
+                }
+            }
+            size_t cap = CATALOG_THUMBNAIL_HEADER_SIZE + self->recordings_->config().max_thumbnail_size;
+            auto* buf = static_cast<uint8_t*>(heap_caps_malloc(cap, MALLOC_CAP_SPIRAM));
+            if (!buf) return httpd_resp_send_500(req);
+            size_t n = self->recordings_->thumbnail(clip, index, buf, cap);
+            esp_err_t res;
+            if (n == 0) {
+                res = httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No such thumbnail");
+            } else {
+                httpd_resp_set_type(req, "image/jpeg");
+                httpd_resp_set_hdr(req, "Cache-Control", "max-age=86400");   // Never changes
+                res = httpd_resp_send(req, reinterpret_cast<const char*>(buf), n);
+            }
+            heap_caps_free(buf);
+            return res;
+        }
+        if (strcmp(name, "mjpeg") != 0 && strcmp(name, "zip") != 0 && strcmp(name, "tar") != 0) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown format");
+        }
+        return self->dispatch_request(req, serve_recording_download);
+    }
+    
+    // /recordings/<id>.mjpeg|.zip|.tar body (RequestFn). The clip is looked
+    // up again: it may have been reclaimed since the handler saw it.
+    static esp_err_t serve_recording_download(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        uint32_t id = 0;
+        char name[16];
+        ClipSummary clip;
+        if (!parse_recording_path(req->uri, &id, name, sizeof(name)) ||
+            !self->recordings_->find(id, &clip)) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown recording");
+        }
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        if (strcmp(name, "mjpeg") != 0) {
+            return send_recording_archive(req, self, clip, name);
+        }
         
-        char json[256];
-        int len = snprintf(json, sizeof(json),
-            "{\"captured\":%lu,\"sent\":%lu,\"dropped\":%lu,\"buffered\":%zu,"
-            "\"heap\":%lu,\"rssi\":%d,\"resolution\":%d,\"quality\":%d,\"streaming\":%s}",
-            stream_stats.frames_captured.load(),
-            stream_stats.frames_sent.load(),
-            stream_stats.frames_dropped.load(),
-            self->streaming_.buffered_frames(),
-            esp_get_free_heap_size(),
-            rssi,
-            static_cast<int>(self->camera_.get_resolution()),
-            self->camera_.get_quality(),
-            self->streaming_.is_running() ? "true" : "false"
-        );
+        ClipReader reader(self->recordings_->frames(), self->config_.embed_metadata);
+        if (!reader.open(clip)) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Recording reclaimed");
+        }
+        uint64_t first = 0;
+        uint64_t last = reader.size() - 1;
+        ByteRange range = ByteRange::Full;
+        char range_hdr[64];
+        if (httpd_req_get_hdr_value_str(req, "Range", range_hdr, sizeof(range_hdr)) == ESP_OK) {
+            range = parse_byte_range(range_hdr, reader.size(), &first, &last);
+        }
+        
+        char content_range[64];
+        httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+        if (range == ByteRange::Unsatisfiable) {
+            snprintf(content_range, sizeof(content_range), "bytes */%llu",
+                     static_cast<unsigned long long>(reader.size()));
+            httpd_resp_set_hdr(req, "Content-Range", content_range);
+            httpd_resp_set_status(req, "416 Range Not Satisfiable");
+            return httpd_resp_send(req, nullptr, 0);
+        }
+        if (range == ByteRange::Partial) {
+            snprintf(content_range, sizeof(content_range), "bytes %llu-%llu/%llu",
+                     static_cast<unsigned long long>(first), static_cast<unsigned long long>(last),
+                     static_cast<unsigned long long>(reader.size()));
+            httpd_resp_set_hdr(req, "Content-Range", content_range);
+            httpd_resp_set_status(req, "206 Partial Content");
+        }
+        char disposition[48];
+        snprintf(disposition, sizeof(disposition), "attachment; filename=clip_%lu.mjpeg",
+                 static_cast<unsigned long>(id));
+        httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+        httpd_resp_set_type(req, "video/x-motion-jpeg");
+        
+        size_t cap = reader.buffer_size();
+        auto* buf = static_cast<uint8_t*>(heap_caps_malloc(cap, MALLOC_CAP_SPIRAM));
+        if (!buf) return httpd_resp_send_500(req);
+        
+        // Frames are read whole (the store verifies their CRC); only the
+        // requested part of each is sent
+        esp_err_t res = reader.seek(first) ? ESP_OK : ESP_FAIL;
+        uint64_t remaining = last - first + 1;
+        while (res == ESP_OK && remaining > 0) {
+            const uint8_t* data = nullptr;
+            size_t n = reader.read(buf, cap, &data);
+            if (n == 0) {
+                res = ESP_FAIL;   // Reclaimed mid-download: cut the response short
+                break;
+            }
+            if (n > remaining) n = static_cast<size_t>(remaining);
+            res = httpd_resp_send_chunk(req, reinterpret_cast<const char*>(data), n);
+            remaining -= n;
+        }
+        heap_caps_free(buf);
+        if (res == ESP_OK) res = httpd_resp_send_chunk(req, nullptr, 0);
+        return res;
+    }
+    
+    static bool archive_sink(void* context, const uint8_t* data, size_t size) {
+        auto* req = static_cast<httpd_req_t*>(context);
+        return httpd_resp_send_chunk(req, reinterpret_cast<const char*>(data), size) == ESP_OK;
+    }
+    
+    // Streams the clip as clip_<id>/<n>.jpg entries. Memory is one record
+    // buffer plus the writer's table (20 B per frame for ZIP, none for TAR);
+    // the archive is only finalised if every frame made it out, so a clip
+    // reclaimed mid-download yields a truncated (detectably broken) file.
+    static esp_err_t send_recording_archive(httpd_req_t* req, WebServer* self,
+                                            const ClipSummary& clip, const char* extension) {
+        ClipReader reader(self->recordings_->frames(), self->config_.embed_metadata);
+        if (!reader.open(clip)) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Recording reclaimed");
+        }
+        bool zip = strcmp(extension, "zip") == 0;
+        auto* writer = new (std::nothrow) ArchiveWriter();
+        size_t cap = reader.buffer_size();
+        auto* buf = static_cast<uint8_t*>(heap_caps_malloc(cap, MALLOC_CAP_SPIRAM));
+        ArchiveConfig config{.format = zip ? ArchiveFormat::Zip : ArchiveFormat::Tar,
+                             .max_entries = reader.frames() ? reader.frames() : 1};
+        if (!writer || !buf || !writer->init(config, true)) {
+            delete writer;
+            heap_caps_free(buf);
+            return httpd_resp_send_500(req);
+        }
+        
+        char disposition[48];
+        snprintf(disposition, sizeof(disposition), "attachment; filename=clip_%lu.%s",
+                 static_cast<unsigned long>(clip.id), extension);
+        httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+        httpd_resp_set_type(req, zip ? "application/zip" : "application/x-tar");
+        
+        char prefix[24];
+        snprintf(prefix, sizeof(prefix), "clip_%lu/", static_cast<unsigned long>(clip.id));
+        bool ok = writer->begin(archive_sink, req, prefix, ".jpg") &&
+                  write_clip_archive(reader, *writer, buf, cap) == reader.frames() &&
+                  writer->finish();
+        if (ok) self->stats_.archives_served++;
+        writer->deinit();
+        delete writer;
+        heap_caps_free(buf);
+        return ok ? httpd_resp_send_chunk(req, nullptr, 0) : ESP_FAIL;
+    }
+    
+    static esp_err_t status_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        
+        char json[StatsPublisher::MAX_EVENT_SIZE];
+        size_t len = format_status_json(self->collect_status(), nullptr, json, sizeof(json));
+        if (len == 0) return httpd_resp_send_500(req);
         
         httpd_resp_set_type(req, "application/json");
         return httpd_resp_send(req, json, len);
     }
     
+    // Last stream admission decision, its inputs, and the counters
+    static esp_err_t admission_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        
+        char json[448];
+        size_t len = format_admission_json(self->admission_.stats(), json, sizeof(json));
+        if (len == 0) return httpd_resp_send_500(req);
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        return httpd_resp_send(req, json, len);
+    }
+    
+    // Per-class egress: rates, delivery ratios
+    static esp_err_t egress_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        if (!self->scheduler_) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Egress scheduling disabled");
+        }
+        
+        char json[768];
+        size_t len = format_egress_json(self->scheduler_->stats(), self->scheduler_->config().policy,
+                                        json, sizeof(json));
+        if (len == 0) return httpd_resp_send_500(req);
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        return httpd_resp_send(req, json, len);
+    }
+    
+    static esp_err_t sdp_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        
+        if (!self->multicast_sdp_) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Multicast disabled");
+        }
+        httpd_resp_set_type(req, "application/sdp");
+        return httpd_resp_send(req, self->multicast_sdp_, HTTPD_RESP_USE_STRLEN);
+    }
+    
+    // Subscribes to status events. The request is handed to the events task
+    // (async handler), so the connection does not tie up the server task.
+    static esp_err_t events_handler(httpd_req_t* req) {
+        auto* self = static_cast<WebServer*>(req->user_ctx);
+        self->stats_.total_requests++;
+        
+        if (!self->events_task_) {
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            return httpd_resp_send(req, "Events disabled", HTTPD_RESP_USE_STRLEN);
+        }
+        
+        xSemaphoreTake(self->events_mutex_, portMAX_DELAY);
+        SseClient* slot = nullptr;
+        for (size_t i = 0; i < self->config_.sse_max_clients; i++) {
+            if (!self->sse_clients_[i].req) {
+                slot = &self->sse_clients_[i];
+                break;
+            }
+        }
+        xSemaphoreGive(self->events_mutex_);
+        
+        if (!slot) {
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            return httpd_resp_send(req, "Too many event clients", HTTPD_RESP_USE_STRLEN);
+        }
+        
+        httpd_req_t* async_req = nullptr;
+        if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+            return httpd_resp_send_500(req);
+        }
+        
+        // The head goes out with the first fan-out, non-blocking like the events.
+        // Only this handler fills free slots; only the events task empties them
+        slot->sock = {self->server_, httpd_req_to_sockfd(async_req)};
+        slot->sub.begin(stream_socket_write, &slot->sock, SSE_RESPONSE_HEAD,
+                        esp_timer_get_time(), self->config_.stream_stall_budget_ms);
+        xSemaphoreTake(self->events_mutex_, portMAX_DELAY);
+        slot->req = async_req;
+        xSemaphoreGive(self->events_mutex_);
+        self->stats_.event_clients++;
+        ESP_LOGI(TAG, "Event client connected (%lu)",
+                 static_cast<unsigned long>(self->stats_.event_clients.load()));
+        return ESP_OK;
+    }
+    
     static esp_err_t config_handler(httpd_req_t* req) {
         auto* self = static_cast<WebServer*>(req->user_ctx);
         self->stats_.total_requests++;
         
-        char buf[64];
+        char buf[128];
         int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
         if (ret <= 0) return httpd_resp_send_500(req);
         buf[ret] = '\0';
         
-        int res = 2, qual = 20;
-        sscanf(buf, "resolution=%d&quality=%d", &res, &qual);
+        // Form fields: resolution, quality, profile=<name> (replaces the
+        // resolution), fps (capped at the active profile's maximum)
+        char value[32];
+        if (httpd_query_key_value(buf, "profile", value, sizeof(value)) == ESP_OK) {
+            const auto* profile = find_sensor_profile(value);
+            if (!profile || !self->camera_.set_profile(*profile)) {
+                httpd_resp_set_status(req, "400 Bad Request");
+                return httpd_resp_send(req, "Invalid profile", HTTPD_RESP_USE_STRLEN);
+            }
+        } else if (httpd_query_key_value(buf, "resolution", value, sizeof(value)) == ESP_OK) {
+            self->camera_.set_resolution(static_cast<interfaces::Resolution>(atoi(value)));
+        }
+        if (httpd_query_key_value(buf, "quality", value, sizeof(value)) == ESP_OK) {
+            self->camera_.set_quality(static_cast<uint8_t>(atoi(value)));
+        }
         
-        self->camera_.set_resolution(static_cast<interfaces::Resolution>(res));
-        self->camera_.set_quality(static_cast<uint8_t>(qual));
+        int fps = self->streaming_.get_target_fps();
+        if (httpd_query_key_value(buf, "fps", value, sizeof(value)) == ESP_OK) {
+            fps = atoi(value);
+        }
+        if (const auto* active = self->camera_.get_profile()) {
+            if (fps > active->max_fps) fps = active->max_fps;
+        }
+        if (fps > 0 && fps <= UINT8_MAX) {
+            self->streaming_.set_target_fps(static_cast<uint8_t>(fps));  // Ignores unsupported rates
+        }
         
         return httpd_resp_send(req, "OK", 2);
     }
     
+    // =========================================================================
+    // Helpers
+    // =========================================================================
+    
+    StatusSnapshot collect_status() const {
+        wifi_ap_record_t ap_info;
+        int rssi = 0;
+        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+            rssi = ap_info.rssi;
+        }
+        
+        auto& stream_stats = streaming_.stats();
+        StatusSnapshot snap;
+        snap.set(StatusField::Captured, stream_stats.frames_captured.load());
+        snap.set(StatusField::Sent, stream_stats.frames_sent.load());
+        snap.set(StatusField::Dropped, stream_stats.frames_dropped.load());
+        snap.set(StatusField::Buffered, static_cast<int64_t>(streaming_.buffered_frames()));
+        // KB granularity: byte-level heap jitter would defeat change detection
+        snap.set(StatusField::Heap, esp_get_free_heap_size() & ~static_cast<uint32_t>(1023));
+        snap.set(StatusField::Rssi, rssi);
+        snap.set(StatusField::Resolution, static_cast<int64_t>(camera_.get_resolution()));
+        snap.set(StatusField::Quality, camera_.get_quality());
+        snap.set(StatusField::Streaming, streaming_.is_running() ? 1 : 0);
+        snap.set(StatusField::Camera, static_cast<int64_t>(streaming_.health()));
+        return snap;
+    }
+    
+    static constexpr float MIN_PLAYBACK_SPEED = 0.25f;
+    static constexpr float MAX_PLAYBACK_SPEED = 8.0f;
+    
+    // =========================================================================
+    // Status events (SSE)
+    // =========================================================================
+    
+    static constexpr size_t MAX_SSE_CLIENTS = 6;
+    static constexpr uint32_t EVENTS_SAMPLE_MS = 100;
+    static constexpr int64_t EVENTS_KEEPALIVE_US = 15 * 1000 * 1000;
+    
+    // Another stream may start (single_client_stream and free workers)
+    bool stream_slot_free() const {
+        if (config_.single_client_stream && stats_.stream_clients.load() > 0) return false;
+        return !stream_pool_.is_initialized() || stream_pool_.idle_workers() > 0;
+    }
+    
+    // Hand the stream to a worker and return to serve other requests; with
+    // no workers, stream here on the server task as before. Takes ownership
+    // of what params holds.
+    esp_err_t dispatch_stream(httpd_req_t* req, const StreamJob& params) {
+        AdmissionVerdict verdict = admit_stream(params.svc ? *params.svc : streaming_, params.cls);
+        if (verdict.decision == AdmissionDecision::Reject) {
+            free_stream_job_buffers(params);
+            char retry_after[12];
+            snprintf(retry_after, sizeof(retry_after), "%lu",
+                     static_cast<unsigned long>(verdict.retry_after_s));
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            httpd_resp_set_hdr(req, "Retry-After", retry_after);
+            return httpd_resp_send(req, "Stream capacity reached", HTTPD_RESP_USE_STRLEN);
+        }
+        
+        uint8_t reserved_fps = config_.admission_control ? verdict.fps : 0;
+        auto* job = new (std::nothrow) StreamJob(params);
+        if (!job) {
+            admission_.release(reserved_fps, admission_rank(params.cls));
+            free_stream_job_buffers(params);
+            return httpd_resp_send_500(req);
+        }
+        job->self = this;
+        job->reserved_fps = reserved_fps;
+        if (verdict.decision == AdmissionDecision::Degrade) job->fps = verdict.fps;
+        stats_.stream_clients++;
+        
+        if (!stream_pool_.is_initialized()) {
+            job->req = req;
+            run_stream_job(job);
+            return ESP_OK;
+        }
+        
+        httpd_req_t* async_req = nullptr;
+        if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+            stats_.stream_clients--;
+            admission_.release(job->reserved_fps, admission_rank(job->cls));
+            free_stream_job_buffers(*job);
+            delete job;
+            return httpd_resp_send_500(req);
+        }
+        job->req = async_req;
+        job->detached = true;
+        if (!stream_pool_.submit(run_stream_job, job, httpd_req_to_sockfd(async_req))) {
+            httpd_resp_set_status(async_req, "503 Service Unavailable");
+            httpd_resp_send(async_req, "Stream busy", HTTPD_RESP_USE_STRLEN);
+            httpd_req_async_handler_complete(async_req);
+            stats_.stream_clients--;
+            admission_.release(job->reserved_fps, admission_rank(job->cls));
+            free_stream_job_buffers(*job);
+            delete job;
+        }
+        return ESP_OK;
+    }
+    
+    // Run fn on a stream worker and return to serve other requests; 503 when
+    // every worker is busy. With no workers, run it here.
+    esp_err_t dispatch_request(httpd_req_t* req, RequestFn fn) {
+        if (!stream_pool_.is_initialized()) return fn(req);
+        if (stream_pool_.idle_workers() == 0) return send_server_busy(req);
+        
+        auto* job = new (std::nothrow) RequestJob();
+        if (!job) return httpd_resp_send_500(req);
+        job->fn = fn;
+        if (httpd_req_async_handler_begin(req, &job->req) != ESP_OK) {
+            delete job;
+            return httpd_resp_send_500(req);
+        }
+        if (!stream_pool_.submit(run_request_job, job, httpd_req_to_sockfd(job->req))) {
+            send_server_busy(job->req);
+            httpd_req_async_handler_complete(job->req);
+            delete job;
+        }
+        return ESP_OK;
+    }
+    
+    // StreamJobFn for dispatch_request()
+    static void run_request_job(void* context) {
+        auto* job = static_cast<RequestJob*>(context);
+        job->fn(job->req);
+        httpd_req_async_handler_complete(job->req);
+        delete job;
+    }
+    
+    static esp_err_t send_server_busy(httpd_req_t* req) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, "Server busy", HTTPD_RESP_USE_STRLEN);
+    }
+    
+    // Under strict egress priority a new stream only competes with its own
+    // class and those above; the scheduler takes the rest from below
+    uint8_t admission_rank(ConsumerClass cls) const {
+        if (!scheduler_ || scheduler_->config().policy != EgressPolicy::Strict) return 0;
+        return static_cast<uint8_t>(cls);
+    }
+    
+    // Sample what the device is doing and decide a new stream
+    AdmissionVerdict admit_stream(StreamingService& svc, ConsumerClass cls) {
+        if (!config_.admission_control) {
+            AdmissionVerdict accept;
+            accept.fps = svc.get_target_fps();
+            return accept;
+        }
+        int64_t now = esp_timer_get_time();
+        bool ranked = scheduler_ && scheduler_->config().policy == EgressPolicy::Strict;
+        AdmissionInputs in;
+        in.rank = admission_rank(cls);
+        in.egress_Bps = ranked ? scheduler_->delivered_Bps(cls, now) : egress_.throughput_Bps(now);
+        in.frame_bytes = egress_.frame_bytes();
+        in.frame_send_us = egress_.frame_send_us();
+        in.link_Bps = refresh_link_estimate();
+        in.free_heap = esp_get_free_heap_size();
+        in.clients = stats_.stream_clients.load();
+        in.fps = svc.get_target_fps();
+        
+        AdmissionVerdict verdict = admission_.decide(in);
+        if (verdict.decision != AdmissionDecision::Accept || verdict.reason != AdmissionReason::Capacity) {
+            ESP_LOGI(TAG, "Stream admission (%s): %s (%s) fps=%u egress=%lu link=%lu B/s send=%lu us heap=%lu",
+                     consumer_class_name(cls),
+                     admission_decision_name(verdict.decision), admission_reason_name(verdict.reason),
+                     static_cast<unsigned>(verdict.fps), static_cast<unsigned long>(in.egress_Bps),
+                     static_cast<unsigned long>(in.link_Bps), static_cast<unsigned long>(in.frame_send_us),
+                     static_cast<unsigned long>(in.free_heap));
+        }
+        return verdict;
+    }
+    
+    // Degraded stream on the blocking path: sleep off the rest of its frame interval
+    static void pace_stream(const StreamJob& job, int64_t* next_us) {
+        if (job.fps == 0) return;
+        int64_t now = esp_timer_get_time();
+        if (*next_us > now) {
+            vTaskDelay(pdMS_TO_TICKS((*next_us - now) / 1000));
+            now = *next_us;
+        }
+        *next_us = now + 1000000 / job.fps;
+    }
+    
+    // StreamCutOffFn: fail a job's blocked send at stop. shutdown() rather than
+    // httpd_sess_trigger_close(): the session must stay valid until the job
+    // completes its async request; the server closes it after that.
+    static void cut_off_socket(void*, int fd) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    
+    // StreamJobFn: serve until the client leaves, then release the request
+    static void run_stream_job(void* context) {
+        auto* job = static_cast<StreamJob*>(context);
+        WebServer* self = job->self;
+        switch (job->kind) {
+            case StreamJob::Kind::Live: self->serve_live_stream(*job); break;
+            case StreamJob::Kind::Delta: self->serve_delta_stream(*job); break;
+            case StreamJob::Kind::Camera: self->serve_camera_stream(*job); break;
+        }
+        if (job->detached) httpd_req_async_handler_complete(job->req);
+        if (job->close_fd >= 0) httpd_sess_trigger_close(self->server_, job->close_fd);
+        self->admission_.release(job->reserved_fps, self->admission_rank(job->cls));
+        free_stream_job_buffers(*job);
+        delete job;
+        self->stats_.stream_clients--;
+    }
+    
+    // May this frame of the stream go out? (no scheduler: always)
+    bool schedule_frame(const StreamJob& job, size_t bytes) {
+        if (!scheduler_) return true;
+        if (scheduler_->offer(job.cls, bytes, esp_timer_get_time())) return true;
+        stats_.stream_frames_deferred++;
+        return false;
+    }
+    
+    // ?class=recorder|operator|dashboard (absent: keep the default)
+    static bool parse_class_query(httpd_req_t* req, ConsumerClass* cls) {
+        char query[96];
+        char value[16];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+            httpd_query_key_value(query, "class", value, sizeof(value)) != ESP_OK) {
+            return true;
+        }
+        return parse_consumer_class(value, cls);
+    }
+    
+    static void free_stream_job_buffers(const StreamJob& job) {
+        if (job.replay_buf) heap_caps_free(job.replay_buf);
+        delete job.encoder;
+    }
+    
+    struct SseClient {
+        httpd_req_t* req = nullptr;      // Async request copy, owned by the events task
+        StreamSocket sock = {};
+        SseSubscriber sub;
+    };
+    
+    void start_events() {
+        if (config_.sse_max_clients == 0) return;
+        if (config_.sse_max_clients > MAX_SSE_CLIENTS) config_.sse_max_clients = MAX_SSE_CLIENTS;
+        
+        publisher_.set_min_interval_us(static_cast<int64_t>(config_.sse_min_interval_ms) * 1000);
+        events_mutex_ = xSemaphoreCreateMutex();
+        if (!events_mutex_) return;
+        
+        events_stop_ = false;
+        events_running_ = true;
+        if (xTaskCreatePinnedToCore(events_task, "http_events", 4096, this, 3,
+                                    &events_task_, 0) != pdPASS) {
+            events_running_ = false;
+            events_task_ = nullptr;
+            ESP_LOGW(TAG, "Events task start failed, /events disabled");
+        }
+    }
+    
+    void stop_events() {
+        if (events_task_) {
+            events_stop_ = true;
+            for (int i = 0; i < 50 && events_running_.load(); i++) {
+                vTaskDelay(pdMS_TO_TICKS(20));
+            }
+            events_task_ = nullptr;
+        }
+        for (auto& client : sse_clients_) {
+            if (client.req) {
+                httpd_req_async_handler_complete(client.req);
+                httpd_sess_trigger_close(server_, client.sock.fd);
+                client.req = nullptr;
+                stats_.event_clients--;
+            }
+        }
+        if (events_mutex_) {
+            vSemaphoreDelete(events_mutex_);
+            events_mutex_ = nullptr;
+        }
+    }
+    
+    static void events_task(void* arg) {
+        auto* self = static_cast<WebServer*>(arg);
+        while (!self->events_stop_) {
+            vTaskDelay(pdMS_TO_TICKS(EVENTS_SAMPLE_MS));
+            if (self->stats_.event_clients.load() == 0) continue;
+            int64_t now = esp_timer_get_time();
+            self->publisher_.publish(self->collect_status(), now);
+            self->fan_out_events(now);
+        }
+        self->events_running_ = false;
+        vTaskDelete(nullptr);
+    }
+    
+    // Send the shared event bytes to each subscriber that has not seen them.
+    // Writes never wait: a subscriber whose socket is full keeps its unsent
+    // tail for the next tick and skips events meanwhile, so it cannot hold
+    // up the others; one that takes nothing for the stall budget is dropped.
+    void fan_out_events(int64_t now_us) {
+        for (size_t i = 0; i < config_.sse_max_clients; i++) {
+            SseClient& client = sse_clients_[i];
+            xSemaphoreTake(events_mutex_, portMAX_DELAY);
+            httpd_req_t* req = client.req;
+            xSemaphoreGive(events_mutex_);
+            if (!req) continue;
+            
+            uint32_t skipped = client.sub.events_skipped();
+            SseSend r = client.sub.service(publisher_, now_us, EVENTS_KEEPALIVE_US);
+            stats_.events_skipped += client.sub.events_skipped() - skipped;
+            if (r != SseSend::Closed && r != SseSend::Evicted) continue;
+            
+            xSemaphoreTake(events_mutex_, portMAX_DELAY);
+            client.req = nullptr;
+            xSemaphoreGive(events_mutex_);
+            httpd_req_async_handler_complete(req);
+            // The response was not framed by httpd: the connection ends with it
+            httpd_sess_trigger_close(server_, client.sock.fd);
+            stats_.event_clients--;
+            if (r == SseSend::Evicted) {
+                stats_.event_evictions++;
+                ESP_LOGW(TAG, "Event client evicted: no progress for %lu ms",
+                         static_cast<unsigned long>(config_.stream_stall_budget_ms));
+            } else {
+                ESP_LOGI(TAG, "Event client disconnected");
+            }
+        }
+    }
+    
+    // Describe a frame with the metadata segment spliced in (no copy of the frame)
+    JpegSplice make_splice(const uint8_t* data, size_t size, const FrameMetadata& meta,
+                           uint8_t (&segment)[JPEG_METADATA_SEGMENT_SIZE]) const {
+        JpegSplice splice;
+        size_t seg_len = config_.embed_metadata
+            ? jpeg_build_metadata_segment(meta, segment, sizeof(segment)) : 0;
+        if (!jpeg_splice_segment(data, size, segment, seg_len, &splice)) {
+            // Not a JPEG: send untouched
+            splice = JpegSplice{};
+            splice.data[0] = data;
+            splice.size[0] = size;
+        }
+        return splice;
+    }
+    
+    // Whole image/jpeg response with Content-Length. httpd_resp_send() only
+    // takes one contiguous body, so the status line and headers are written
+    // here and the splice parts follow as-is; extra_headers holds further
+    // "Name: value\r\n" lines (headers set with httpd_resp_set_hdr are not sent).
+    static esp_err_t send_splice_response(httpd_req_t* req, const JpegSplice& splice,
+                                          const char* extra_headers) {
+        char header[320];
+        int len = snprintf(header, sizeof(header),
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: image/jpeg\r\n"
+            "Content-Length: %zu\r\n"
+            "%s\r\n", splice.total(), extra_headers);
+        if (len < 0 || static_cast<size_t>(len) >= sizeof(header)) return ESP_FAIL;
+        esp_err_t res = send_raw(req, header, static_cast<size_t>(len));
+        for (size_t i = 0; i < JpegSplice::NUM_PARTS && res == ESP_OK; i++) {
+            res = send_raw(req, reinterpret_cast<const char*>(splice.data[i]), splice.size[i]);
+        }
+        return res;
+    }
+    
+    static esp_err_t send_raw(httpd_req_t* req, const char* data, size_t size) {
+        while (size > 0) {
+            int sent = httpd_send(req, data, size);
+            if (sent <= 0) return ESP_FAIL;
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return ESP_OK;
+    }
+    
+    static esp_err_t send_splice(httpd_req_t* req, const JpegSplice& splice) {
+        for (size_t i = 0; i < JpegSplice::NUM_PARTS; i++) {
+            if (splice.size[i] == 0) continue;
+            esp_err_t res = httpd_resp_send_chunk(req,
+                reinterpret_cast<const char*>(splice.data[i]), splice.size[i]);
+            if (res != ESP_OK) return res;
+        }
+        return ESP_OK;
+    }
+    
     // Members
     interfaces::ICamera& camera_;
     StreamingService& streaming_;
+    RoiCropCache roi_cache_;
+    StreamWorkerPool stream_pool_;
+    EgressMeter egress_;
+    StreamAdmission admission_;
+    EgressScheduler* scheduler_ = nullptr;
     httpd_handle_t server_ = nullptr;
     WebServerConfig config_;
     WebServerStats stats_;
+    uint32_t snapshot_sequence_ = 0;
+    FrameHistory* history_ = nullptr;
+    const char* multicast_sdp_ = nullptr;
+    CameraRegistry* cameras_ = nullptr;
+    RecordingCatalog* recordings_ = nullptr;
+    BurstCapture* burst_ = nullptr;
+    StatsPublisher publisher_;
+    SseClient sse_clients_[MAX_SSE_CLIENTS];
+    SemaphoreHandle_t events_mutex_ = nullptr;
+    TaskHandle_t events_task_ = nullptr;
+    std::atomic<bool> events_stop_{false};
+    std::atomic<bool> events_running_{false};
     char ip_address_[16] = {0};
     char hostname_[32] = {0};
     char mac_address_[18] = {0};
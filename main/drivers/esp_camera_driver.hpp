@@ -8,6 +8,7 @@
 
 #include "../interfaces/i_camera.hpp"
 #include "esp_camera.h"
+#include "sensor.h"
 #include "esp_log.h"
 #include <atomic>
 
@@ -55,15 +56,24 @@ public:
         cam_cfg.pin_href = pins_.href;
         cam_cfg.pin_pclk = pins_.pclk;
         
-        cam_cfg.xclk_freq_hz = 20000000;
+        // Clocking and grab mode can only be chosen here; the rest of a
+        // profile is applied once the sensor is up
+        const interfaces::SensorProfile* profile = config_.profile;
+        config_.profile = nullptr;
+        if (profile) config_.resolution = profile->resolution;
+        xclk_hz_ = profile ? profile->xclk_hz : DEFAULT_XCLK_HZ;
+        grab_mode_ = profile ? profile->grab_mode : interfaces::GrabMode::Latest;
+        
+        cam_cfg.xclk_freq_hz = static_cast<int>(xclk_hz_);
         cam_cfg.ledc_timer = LEDC_TIMER_0;
         cam_cfg.ledc_channel = LEDC_CHANNEL_0;
-        cam_cfg.pixel_format = PIXFORMAT_JPEG;
+        cam_cfg.pixel_format = pixel_format_to_esp(config_.pixel_format);
         cam_cfg.frame_size = resolution_to_framesize(config_.resolution);
         cam_cfg.jpeg_quality = config_.jpeg_quality;
         cam_cfg.fb_count = config_.frame_buffer_count;
         cam_cfg.fb_location = CAMERA_FB_IN_PSRAM;
-        cam_cfg.grab_mode = CAMERA_GRAB_LATEST;
+        cam_cfg.grab_mode = grab_mode_ == interfaces::GrabMode::Latest
+            ? CAMERA_GRAB_LATEST : CAMERA_GRAB_WHEN_EMPTY;
         
         esp_err_t err = esp_camera_init(&cam_cfg);
         if (err != ESP_OK) {
@@ -72,6 +82,9 @@ public:
         }
         
         initialized_ = true;
+        if (profile && !set_profile(*profile)) {
+            ESP_LOGW("CamDriver", "Profile %s rejected, using plain resolution", profile->name);
+        }
         ESP_LOGI("CamDriver", "Initialized: %dx%d, Q=%d",
                  get_width(), get_height(), config_.jpeg_quality);
         return true;
@@ -85,6 +98,7 @@ public:
             }
             esp_camera_deinit();
             initialized_ = false;
+            has_profile_ = false;
         }
     }
     
@@ -112,6 +126,7 @@ public:
         view.height = current_fb_->height;
         view.timestamp_us = current_fb_->timestamp.tv_sec * 1000000LL + 
                            current_fb_->timestamp.tv_usec;
+        view.format = config_.pixel_format;
         return view;
     }
     
@@ -122,20 +137,168 @@ public:
         }
     }
     
+    bool reset_sensor() override {
+        if (!initialized_) return false;
+        
+        sensor_t* sensor = esp_camera_sensor_get();
+        if (!sensor || !sensor->reset) return false;
+        if (sensor->reset(sensor) != 0) return false;
+        
+        // reset() restores the register defaults; put the current mode back
+        if (sensor->set_pixformat(sensor, pixel_format_to_esp(config_.pixel_format)) != 0) {
+            return false;
+        }
+        if (has_profile_) {
+            interfaces::SensorProfile profile = profile_;
+            if (!set_profile(profile)) return false;
+        } else if (sensor->set_framesize(sensor, resolution_to_framesize(config_.resolution)) != 0) {
+            return false;
+        }
+        return config_.pixel_format != interfaces::PixelFormat::Jpeg ||
+               sensor->set_quality(sensor, config_.jpeg_quality) == 0;
+    }
+    
     bool set_resolution(interfaces::Resolution res) override {
         if (!initialized_) return false;
         
         sensor_t* sensor = esp_camera_sensor_get();
         if (!sensor) return false;
         
+        // set_framesize() restores the sensor's own window and clock divider
+        if (xclk_hz_ != DEFAULT_XCLK_HZ &&
+            sensor->set_xclk(sensor, LEDC_TIMER_0, DEFAULT_XCLK_HZ / 1000000) != 0) {
+            return false;
+        }
+        xclk_hz_ = DEFAULT_XCLK_HZ;
         if (sensor->set_framesize(sensor, resolution_to_framesize(res)) != 0) {
             return false;
         }
         
         config_.resolution = res;
+        has_profile_ = false;
+        return true;
+    }
+    
+    bool set_profile(const interfaces::SensorProfile& profile) override {
+        if (!initialized_) return false;
+        
+        // The DMA buffers are allocated for one grab mode at init
+        if (profile.grab_mode != grab_mode_) {
+            ESP_LOGW("CamDriver", "Profile %s needs a different grab mode (re-init)", profile.name);
+            return false;
+        }
+        
+        // OV2640 readout modes: 0 = CIF (4x4 binned), 1 = SVGA (2x2), 2 = UXGA
+        int mode;
+        switch (profile.binning) {
+            case 4: mode = 0; break;
+            case 2: mode = 1; break;
+            case 1: mode = 2; break;
+            default: return false;
+        }
+        
+        sensor_t* sensor = esp_camera_sensor_get();
+        if (!sensor || sensor->id.PID != OV2640_PID) return false;
+        
+        if (profile.xclk_hz != xclk_hz_) {
+            if (sensor->set_xclk(sensor, LEDC_TIMER_0, static_cast<int>(profile.xclk_hz / 1000000)) != 0) {
+                return false;
+            }
+            xclk_hz_ = profile.xclk_hz;
+        }
+        
+        // For the OV2640, set_res_raw() takes the readout mode first and the
+        // window in that mode's (binned) pixels
+        const auto& w = profile.window;
+        uint8_t b = profile.binning;
+        framesize_t fs = resolution_to_framesize(profile.resolution);
+        if (sensor->set_res_raw(sensor, mode, 0, 0, 0, w.x / b, w.y / b, w.width / b, w.height / b,
+                                resolution[fs].width, resolution[fs].height, false, false) != 0) {
+            return false;
+        }
+        
+        // CLKRC (sensor bank 0x11): bit 7 doubles the clock, bits 5:0 divide by n + 1
+        uint8_t clkrc = static_cast<uint8_t>((profile.pll_multiplier == 2 ? 0x80 : 0x00) |
+                                             ((profile.clock_divider - 1) & 0x3F));
+        if (sensor->set_reg(sensor, 0x100 | 0x11, 0xFF, clkrc) != 0) {
+            return false;
+        }
+        
+        profile_ = profile;
+        has_profile_ = true;
+        config_.resolution = profile.resolution;
+        ESP_LOGI("CamDriver", "Profile %s: %dx%d, up to %d FPS", profile.name,
+                 get_width(), get_height(), profile.max_fps);
         return true;
     }
     
+    const interfaces::SensorProfile* get_profile() const override {
+        return has_profile_ ? &profile_ : nullptr;
+    }
+    
+    bool set_exposure(const interfaces::ExposureSettings& settings) override {
+        if (!initialized_) return false;
+        
+        sensor_t* sensor = esp_camera_sensor_get();
+        if (!sensor || sensor->id.PID != OV2640_PID) return false;
+        
+        // COM8 (0x13): bit 0 AEC, bit 2 AGC, bit 5 banding filter;
+        // COM3 (0x0C) bit 2 picks 50 Hz banding over 60 Hz
+        bool banding = settings.anti_flicker != interfaces::AntiFlicker::Off;
+        uint8_t com8 = static_cast<uint8_t>((banding ? 0x20 : 0x00) | (settings.auto_exposure ? 0x05 : 0x00));
+        uint8_t com3 = settings.anti_flicker == interfaces::AntiFlicker::Hz50 ? 0x04 : 0x00;
+        if (sensor->set_reg(sensor, 0x100 | 0x13, 0x25, com8) != 0 ||
+            sensor->set_reg(sensor, 0x100 | 0x0C, 0x04, com3) != 0) {
+            return false;
+        }
+        if (settings.auto_exposure) return true;
+        
+        // Exposure in lines, 16 bits over REG45[5:0], AEC[7:0] and REG04[1:0]
+        uint64_t lines = static_cast<uint64_t>(settings.exposure_us) * 1000 / line_time_ns();
+        if (lines < 1) lines = 1;
+        if (lines > 0xFFFF) lines = 0xFFFF;
+        if (sensor->set_reg(sensor, 0x100 | 0x04, 0x03, static_cast<int>(lines & 0x03)) != 0 ||
+            sensor->set_reg(sensor, 0x100 | 0x10, 0xFF, static_cast<int>((lines >> 2) & 0xFF)) != 0 ||
+            sensor->set_reg(sensor, 0x100 | 0x45, 0x3F, static_cast<int>((lines >> 10) & 0x3F)) != 0 ||
+            sensor->set_reg(sensor, 0x100 | 0x00, 0xFF, gain_to_reg(settings.gain_x16)) != 0) {
+            return false;
+        }
+        return true;
+    }
+    
+    interfaces::ExposureSettings get_exposure() const override {
+        interfaces::ExposureSettings settings;
+        sensor_t* sensor = initialized_ ? esp_camera_sensor_get() : nullptr;
+        if (!sensor || sensor->id.PID != OV2640_PID) return settings;
+        
+        int com8 = sensor->get_reg(sensor, 0x100 | 0x13, 0xFF);
+        int com3 = sensor->get_reg(sensor, 0x100 | 0x0C, 0xFF);
+        int reg04 = sensor->get_reg(sensor, 0x100 | 0x04, 0x03);
+        int aec = sensor->get_reg(sensor, 0x100 | 0x10, 0xFF);
+        int reg45 = sensor->get_reg(sensor, 0x100 | 0x45, 0x3F);
+        int gain = sensor->get_reg(sensor, 0x100 | 0x00, 0xFF);
+        if (com8 < 0 || com3 < 0 || reg04 < 0 || aec < 0 || reg45 < 0 || gain < 0) return settings;
+        
+        uint32_t lines = (static_cast<uint32_t>(reg45) << 10) | (static_cast<uint32_t>(aec) << 2) |
+                         static_cast<uint32_t>(reg04);
+        settings.auto_exposure = (com8 & 0x01) != 0;
+        settings.exposure_us = static_cast<uint32_t>(static_cast<uint64_t>(lines) * line_time_ns() / 1000);
+        settings.gain_x16 = reg_to_gain(static_cast<uint8_t>(gain));
+        settings.anti_flicker = !(com8 & 0x20) ? interfaces::AntiFlicker::Off
+                              : (com3 & 0x04) ? interfaces::AntiFlicker::Hz50
+                              : interfaces::AntiFlicker::Hz60;
+        return settings;
+    }
+    
+    interfaces::ExposureLimits get_exposure_limits() const override {
+        interfaces::ExposureLimits limits;
+        limits.min_exposure_us = (line_time_ns() + 999) / 1000;
+        limits.max_exposure_us = static_cast<uint32_t>(static_cast<uint64_t>(frame_lines()) * line_time_ns() / 1000);
+        limits.min_gain_x16 = 16;
+        limits.max_gain_x16 = MAX_GAIN_X16;
+        return limits;
+    }
+    
     bool set_quality(uint8_t quality) override {
         if (!initialized_ || quality < 10 || quality > 63) return false;
         
@@ -159,6 +322,15 @@ public:
     }
 
 private:
+    static pixformat_t pixel_format_to_esp(interfaces::PixelFormat format) {
+        switch (format) {
+            case interfaces::PixelFormat::Yuv422:    return PIXFORMAT_YUV422;
+            case interfaces::PixelFormat::Grayscale: return PIXFORMAT_GRAYSCALE;
+            case interfaces::PixelFormat::Rgb565:    return PIXFORMAT_RGB565;
+            default: return PIXFORMAT_JPEG;
+        }
+    }
+    
     static framesize_t resolution_to_framesize(interfaces::Resolution res) {
         switch (res) {
             case interfaces::Resolution::QQVGA: return FRAMESIZE_QQVGA;
@@ -173,6 +345,43 @@ private:
         }
     }
     
+    // OV2640 GAIN (0x00): bits 7:4 each double, bits 3:0 add sixteenths
+    static uint8_t gain_to_reg(uint16_t gain_x16) {
+        if (gain_x16 < 16) gain_x16 = 16;
+        uint8_t doublings = 0;
+        while (gain_x16 >= 32 && doublings < 0x0F) {
+            gain_x16 /= 2;
+            doublings = static_cast<uint8_t>((doublings << 1) | 1);
+        }
+        uint16_t fraction = gain_x16 - 16;
+        return static_cast<uint8_t>((doublings << 4) | (fraction > 15 ? 15 : fraction));
+    }
+    
+    static uint16_t reg_to_gain(uint8_t reg) {
+        uint16_t gain = 16 + (reg & 0x0F);
+        for (uint8_t bit = 0x10; bit; bit = static_cast<uint8_t>(bit << 1)) {
+            if (reg & bit) gain *= 2;
+        }
+        return gain;
+    }
+    
+    // Profiles carry their line timing; plain modes use the sensor's own
+    // SVGA (2x2 binned) or UXGA readout at the current XCLK (approximate:
+    // esp32-camera may divide the clock further for JPEG)
+    uint32_t line_time_ns() const {
+        if (has_profile_ && profile_.line_length && profile_.clock_divider) {
+            uint32_t clock = xclk_hz_ / profile_.clock_divider * profile_.pll_multiplier;
+            return static_cast<uint32_t>(static_cast<uint64_t>(profile_.line_length) * 1000000000ULL / clock);
+        }
+        uint16_t line_length = config_.resolution > interfaces::Resolution::SVGA ? 1922 : 1190;
+        return static_cast<uint32_t>(static_cast<uint64_t>(line_length) * 1000000000ULL / xclk_hz_);
+    }
+    
+    uint32_t frame_lines() const {
+        if (has_profile_ && profile_.frame_length) return profile_.frame_length;
+        return config_.resolution > interfaces::Resolution::SVGA ? 1248 : 672;
+    }
+    
     uint32_t get_width() const {
         switch (config_.resolution) {
             case interfaces::Resolution::QQVGA: return 160;
@@ -201,8 +410,15 @@ private:
         }
     }
     
+    static constexpr uint32_t DEFAULT_XCLK_HZ = 20000000;
+    static constexpr uint16_t MAX_GAIN_X16 = 496;   // 16 x (1 + 15/16)
+    
     CameraPins pins_;
     interfaces::CameraConfig config_;
+    interfaces::SensorProfile profile_;
+    bool has_profile_ = false;
+    uint32_t xclk_hz_ = DEFAULT_XCLK_HZ;
+    interfaces::GrabMode grab_mode_ = interfaces::GrabMode::Latest;
     camera_fb_t* current_fb_ = nullptr;
     bool initialized_ = false;
 };
@@ -0,0 +1,76 @@
+/**
+ * @file esp_http_uploader_client.hpp
+ * @brief esp_http_client with keep-alive implementing IHttpClient
+ */
+#pragma once
+
+#ifdef ESP_PLATFORM
+
+#include "../interfaces/i_http_client.hpp"
+#include "esp_http_client.h"
+#include "esp_log.h"
+
+namespace drivers {
+
+class EspHttpUploaderClient : public interfaces::IHttpClient {
+public:
+    EspHttpUploaderClient() = default;
+    ~EspHttpUploaderClient() override { deinit(); }
+
+    // Non-copyable
+    EspHttpUploaderClient(const EspHttpUploaderClient&) = delete;
+    EspHttpUploaderClient& operator=(const EspHttpUploaderClient&) = delete;
+
+    /**
+     * @brief Create the client for a collector URL (connects on first post)
+     * @param url e.g. "http://collector.local:8080/ingest" (must outlive the client)
+     */
+    bool init(const char* url, int timeout_ms = 10000) {
+        if (client_) return true;
+        esp_http_client_config_t config = {};
+        config.url = url;
+        config.method = HTTP_METHOD_POST;
+        config.timeout_ms = timeout_ms;
+        config.keep_alive_enable = true;
+        client_ = esp_http_client_init(&config);
+        if (!client_) {
+            ESP_LOGE(TAG, "esp_http_client_init failed for %s", url);
+            return false;
+        }
+        return true;
+    }
+
+    void deinit() {
+        if (client_) {
+            esp_http_client_cleanup(client_);
+            client_ = nullptr;
+        }
+    }
+
+    int post(const char* content_type, const uint8_t* body, size_t size) override {
+        if (!client_) return -1;
+        esp_http_client_set_method(client_, HTTP_METHOD_POST);
+        esp_http_client_set_header(client_, "Content-Type", content_type);
+        esp_http_client_set_post_field(client_, reinterpret_cast<const char*>(body),
+                                       static_cast<int>(size));
+        esp_err_t err = esp_http_client_perform(client_);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "POST failed: %s", esp_err_to_name(err));
+            return -1;
+        }
+        return esp_http_client_get_status_code(client_);
+    }
+
+    void disconnect() override {
+        if (client_) esp_http_client_close(client_);
+    }
+
+private:
+    static constexpr const char* TAG = "HttpUpload";
+
+    esp_http_client_handle_t client_ = nullptr;
+};
+
+} // namespace drivers
+
+#endif // ESP_PLATFORM
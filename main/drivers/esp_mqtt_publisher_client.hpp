@@ -0,0 +1,107 @@
+/**
+ * @file esp_mqtt_publisher_client.hpp
+ * @brief esp-mqtt client implementing IMqttClient
+ */
+#pragma once
+
+#ifdef ESP_PLATFORM
+
+#include "../interfaces/i_mqtt_client.hpp"
+#include "mqtt_client.h"
+#include "esp_log.h"
+#include <atomic>
+
+namespace drivers {
+
+class EspMqttPublisherClient : public interfaces::IMqttClient {
+public:
+    EspMqttPublisherClient() = default;
+    ~EspMqttPublisherClient() override { deinit(); }
+
+    // Non-copyable
+    EspMqttPublisherClient(const EspMqttPublisherClient&) = delete;
+    EspMqttPublisherClient& operator=(const EspMqttPublisherClient&) = delete;
+
+    /**
+     * @brief Create the client and start connecting (reconnects on its own)
+     * @param uri e.g. "mqtt://broker.local:1883" (must outlive the client)
+     * @param client_id Broker-side identity (must outlive the client)
+     */
+    bool init(const char* uri, const char* client_id) {
+        if (client_) return true;
+        esp_mqtt_client_config_t config = {};
+        config.broker.address.uri = uri;
+        config.credentials.client_id = client_id;
+        config.network.reconnect_timeout_ms = 5000;
+        client_ = esp_mqtt_client_init(&config);
+        if (!client_) {
+            ESP_LOGE(TAG, "esp_mqtt_client_init failed for %s", uri);
+            return false;
+        }
+        esp_mqtt_client_register_event(client_, MQTT_EVENT_ANY, &EspMqttPublisherClient::on_event, this);
+        if (esp_mqtt_client_start(client_) != ESP_OK) {
+            ESP_LOGE(TAG, "esp_mqtt_client_start failed");
+            deinit();
+            return false;
+        }
+        return true;
+    }
+
+    void deinit() {
+        if (client_) {
+            esp_mqtt_client_stop(client_);
+            esp_mqtt_client_destroy(client_);
+            client_ = nullptr;
+        }
+        connected_ = false;
+    }
+
+    bool connected() const override { return connected_.load(); }
+
+    int publish(const char* topic, const uint8_t* payload, size_t size,
+                uint8_t qos, bool retain) override {
+        if (!client_ || !connected_.load()) return -1;
+        return esp_mqtt_client_publish(client_, topic, reinterpret_cast<const char*>(payload),
+                                       static_cast<int>(size), qos, retain ? 1 : 0);
+    }
+
+    // Set before init(); called from the esp-mqtt task
+    void set_ack_handler(AckHandler handler, void* ctx) override {
+        ack_ctx_ = ctx;
+        ack_handler_ = handler;
+    }
+
+private:
+    static constexpr const char* TAG = "MqttClient";
+
+    static void on_event(void* arg, esp_event_base_t, int32_t event_id, void* event_data) {
+        auto* self = static_cast<EspMqttPublisherClient*>(arg);
+        auto* event = static_cast<esp_mqtt_event_handle_t>(event_data);
+        switch (static_cast<esp_mqtt_event_id_t>(event_id)) {
+            case MQTT_EVENT_CONNECTED:
+                ESP_LOGI(TAG, "Connected to broker");
+                self->connected_ = true;
+                break;
+            case MQTT_EVENT_DISCONNECTED:
+                ESP_LOGW(TAG, "Disconnected from broker");
+                self->connected_ = false;
+                break;
+            case MQTT_EVENT_PUBLISHED: {
+                AckHandler handler = self->ack_handler_;
+                if (handler) handler(self->ack_ctx_, event->msg_id);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    esp_mqtt_client_handle_t client_ = nullptr;
+    std::atomic<bool> connected_{false};
+    AckHandler ack_handler_ = nullptr;
+    void* ack_ctx_ = nullptr;
+};
+
+} // namespace drivers
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,62 @@
+/**
+ * @file esp_partition_storage.hpp
+ * @brief Flash data partition implementing IBlockStorage
+ */
+#pragma once
+
+#ifdef ESP_PLATFORM
+
+#include "../interfaces/i_block_storage.hpp"
+#include "esp_partition.h"
+#include "esp_log.h"
+
+namespace drivers {
+
+class EspPartitionStorage : public interfaces::IBlockStorage {
+public:
+    EspPartitionStorage() = default;
+
+    // Non-copyable
+    EspPartitionStorage(const EspPartitionStorage&) = delete;
+    EspPartitionStorage& operator=(const EspPartitionStorage&) = delete;
+
+    /**
+     * @brief Find a data partition by label (see partitions.csv)
+     */
+    bool init(const char* label) {
+        partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                              ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!partition_) {
+            ESP_LOGE(TAG, "Partition '%s' not found", label);
+            return false;
+        }
+        ESP_LOGI(TAG, "Partition '%s': %lu KB at 0x%lx", label,
+                 static_cast<unsigned long>(partition_->size / 1024),
+                 static_cast<unsigned long>(partition_->address));
+        return true;
+    }
+
+    size_t size() const override { return partition_ ? partition_->size : 0; }
+    size_t erase_size() const override { return partition_ ? partition_->erase_size : 0; }
+
+    bool read(size_t offset, void* out, size_t size) override {
+        return partition_ && esp_partition_read(partition_, offset, out, size) == ESP_OK;
+    }
+
+    bool write(size_t offset, const void* data, size_t size) override {
+        return partition_ && esp_partition_write(partition_, offset, data, size) == ESP_OK;
+    }
+
+    bool erase(size_t offset, size_t size) override {
+        return partition_ && esp_partition_erase_range(partition_, offset, size) == ESP_OK;
+    }
+
+private:
+    static constexpr const char* TAG = "Partition";
+
+    const esp_partition_t* partition_ = nullptr;
+};
+
+} // namespace drivers
+
+#endif // ESP_PLATFORM
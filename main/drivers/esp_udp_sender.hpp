@@ -0,0 +1,81 @@
+/**
+ * @file esp_udp_sender.hpp
+ * @brief lwIP UDP socket implementing IDatagramSender for multicast groups
+ */
+#pragma once
+
+#ifdef ESP_PLATFORM
+
+#include "../interfaces/i_datagram_sender.hpp"
+#include "lwip/sockets.h"
+#include "lwip/inet.h"
+#include "esp_log.h"
+#include <cerrno>
+#include <cstring>
+
+namespace drivers {
+
+class EspUdpSender : public interfaces::IDatagramSender {
+public:
+    EspUdpSender() = default;
+    ~EspUdpSender() override { deinit(); }
+
+    // Non-copyable
+    EspUdpSender(const EspUdpSender&) = delete;
+    EspUdpSender& operator=(const EspUdpSender&) = delete;
+
+    /**
+     * @brief Open a socket sending to the given group
+     * @param group Destination IPv4 address (e.g. "239.255.0.1")
+     * @param ttl Multicast hop limit (1 = local subnet only)
+     */
+    bool init(const char* group, uint8_t ttl) {
+        if (sock_ >= 0) return true;
+        memset(&dest_, 0, sizeof(dest_));
+        dest_.sin_family = AF_INET;
+        if (inet_aton(group, &dest_.sin_addr) == 0) {
+            ESP_LOGE(TAG, "Invalid group address: %s", group);
+            return false;
+        }
+
+        sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock_ < 0) {
+            ESP_LOGE(TAG, "socket() failed: errno %d", errno);
+            return false;
+        }
+        if (setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
+            ESP_LOGW(TAG, "IP_MULTICAST_TTL failed: errno %d", errno);
+        }
+        uint8_t loop = 0;
+        setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+        ESP_LOGI(TAG, "Multicast to %s (ttl=%u)", group, ttl);
+        return true;
+    }
+
+    void deinit() {
+        if (sock_ >= 0) {
+            close(sock_);
+            sock_ = -1;
+        }
+    }
+
+    bool send(const uint8_t* data, size_t size, uint16_t port) override {
+        if (sock_ < 0) return false;
+        dest_.sin_port = htons(port);
+        // ENOMEM means lwIP ran out of buffers: the datagram is lost like any
+        // other and receivers repair it from parity when they can
+        return sendto(sock_, data, size, 0, reinterpret_cast<const sockaddr*>(&dest_),
+                      sizeof(dest_)) == static_cast<int>(size);
+    }
+
+private:
+    static constexpr const char* TAG = "UdpSender";
+
+    int sock_ = -1;
+    sockaddr_in dest_ = {};
+};
+
+} // namespace drivers
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,35 @@
+/**
+ * @file i_block_storage.hpp
+ * @brief Raw erase-before-write storage (NOR flash semantics)
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace interfaces {
+
+/**
+ * @brief Byte-addressable medium that must be erased (to 0xFF) in blocks
+ *        before it can be written
+ *
+ * Writing over bytes that are not erased is undefined (flash can only
+ * clear bits); callers keep track of what is erased.
+ *
+ * Production: a data partition in the SPI flash
+ * Testing: a file emulating NOR flash, with wear counters and power cuts
+ */
+class IBlockStorage {
+public:
+    virtual ~IBlockStorage() = default;
+
+    virtual size_t size() const = 0;
+
+    // Erase granularity; erase() offsets and lengths are multiples of it
+    virtual size_t erase_size() const = 0;
+
+    virtual bool read(size_t offset, void* out, size_t size) = 0;
+    virtual bool write(size_t offset, const void* data, size_t size) = 0;
+    virtual bool erase(size_t offset, size_t size) = 0;
+};
+
+} // namespace interfaces
@@ -19,6 +19,20 @@ enum class Resolution : uint8_t {
     UXGA = 7    // 1600x1200
 };
 
+enum class PixelFormat : uint8_t {
+    Jpeg = 0,       // Compressed by the sensor
+    Yuv422 = 1,     // YUYV: Y0 U Y1 V per pixel pair
+    Grayscale = 2,  // One byte per pixel
+    Rgb565 = 3      // Big-endian, 2 bytes per pixel
+};
+
+// Bytes per pixel of an uncompressed format (0 for JPEG)
+inline constexpr size_t pixel_format_bytes(PixelFormat format) {
+    return format == PixelFormat::Grayscale ? 1
+         : format == PixelFormat::Yuv422 || format == PixelFormat::Rgb565 ? 2
+         : 0;
+}
+
 // Immutable view of a captured frame
 struct FrameView {
     const uint8_t* data = nullptr;
@@ -26,14 +40,83 @@ struct FrameView {
     uint32_t width = 0;
     uint32_t height = 0;
     int64_t timestamp_us = 0;
+    PixelFormat format = PixelFormat::Jpeg;
     
     bool valid() const { return data != nullptr && size > 0; }
 };
 
+enum class GrabMode : uint8_t {
+    Latest = 0,     // Newest frame; older buffered frames are dropped
+    WhenEmpty = 1   // Oldest buffered frame (no drops, but may be stale)
+};
+
+// Region of the full sensor pixel array, in unbinned pixels
+struct SensorWindow {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+/**
+ * @brief Sensor readout mode: clocking, window and binning
+ *
+ * Smaller windows and binned readouts shorten the frame, trading field of
+ * view (windowing) or detail (binning) for frame rate. max_fps and
+ * latency_ms follow from the timing fields (see core/sensor_profiles.hpp).
+ */
+struct SensorProfile {
+    const char* name = "";
+    Resolution resolution = Resolution::VGA;  // Output frame size
+    uint32_t xclk_hz = 20000000;
+    uint8_t pll_multiplier = 1;   // Sensor clock = XCLK x multiplier / divider
+    uint8_t clock_divider = 1;
+    SensorWindow window;
+    uint8_t binning = 1;          // 1 = every pixel, 2 = 2x2 binned, 4 = 4x4
+    GrabMode grab_mode = GrabMode::Latest;
+    uint16_t line_length = 0;     // Sensor clocks per line, including blanking
+    uint16_t frame_length = 0;    // Lines per frame, including blanking
+    uint8_t max_fps = 0;
+    uint16_t latency_ms = 0;      // End of exposure to frame in memory (worst case)
+};
+
+// Mains flicker to avoid (lights flicker at twice the mains frequency)
+enum class AntiFlicker : uint8_t {
+    Off = 0,
+    Hz50 = 1,   // 10 ms light period
+    Hz60 = 2    // 8.33 ms light period
+};
+
+/**
+ * @brief Exposure, gain and anti-flicker
+ *
+ * With auto_exposure the sensor's AEC/AGC choose exposure and gain (and
+ * set_exposure() ignores the two fields); anti_flicker then selects the
+ * sensor's banding filter. Manual control is meant for a closed loop such
+ * as core/exposure_controller.hpp, which keeps exposure to whole light
+ * periods itself.
+ */
+struct ExposureSettings {
+    bool auto_exposure = true;
+    uint32_t exposure_us = 10000;
+    uint16_t gain_x16 = 16;       // Analog gain in 1/16 steps (16 = 1x)
+    AntiFlicker anti_flicker = AntiFlicker::Off;
+};
+
+// Range set_exposure() accepts at the current readout
+struct ExposureLimits {
+    uint32_t min_exposure_us = 0;
+    uint32_t max_exposure_us = 0;   // About one frame time
+    uint16_t min_gain_x16 = 16;
+    uint16_t max_gain_x16 = 16;
+};
+
 struct CameraConfig {
     Resolution resolution = Resolution::VGA;
     uint8_t jpeg_quality = 20;        // 10-63 (lower = better quality, larger files)
     uint8_t frame_buffer_count = 2;   // Number of frame buffers in DMA
+    PixelFormat pixel_format = PixelFormat::Jpeg;
+    const SensorProfile* profile = nullptr;  // Initial readout profile (overrides resolution)
 };
 
 /**
@@ -51,6 +134,11 @@ public:
     virtual void deinit() = 0;
     virtual bool is_initialized() const = 0;
     
+    // Soft-reset the sensor (registers back to defaults, then the current
+    // format, resolution/profile and quality re-applied); cheaper than
+    // deinit()/init(), which also restarts the capture DMA
+    virtual bool reset_sensor() = 0;
+    
     // Frame capture
     virtual FrameView capture_frame() = 0;
     virtual void release_frame() = 0;
@@ -60,6 +148,17 @@ public:
     virtual bool set_quality(uint8_t quality) = 0;
     virtual Resolution get_resolution() const = 0;
     virtual uint8_t get_quality() const = 0;
+    
+    // Sensor readout profile (replaces the plain resolution mode until
+    // set_resolution() is called; get_profile() is nullptr in plain mode)
+    virtual bool set_profile(const SensorProfile& profile) = 0;
+    virtual const SensorProfile* get_profile() const = 0;
+    
+    // Exposure control (get_exposure() reports what the sensor is using,
+    // also under its own AEC)
+    virtual bool set_exposure(const ExposureSettings& settings) = 0;
+    virtual ExposureSettings get_exposure() const = 0;
+    virtual ExposureLimits get_exposure_limits() const = 0;
 };
 
 } // namespace interfaces
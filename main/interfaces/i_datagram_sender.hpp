@@ -0,0 +1,28 @@
+/**
+ * @file i_datagram_sender.hpp
+ * @brief Datagram transport interface for multicast distribution
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace interfaces {
+
+/**
+ * @brief Sends UDP datagrams to a fixed destination address
+ *
+ * Production: lwIP socket bound to a multicast group
+ * Testing: in-memory link with injected loss
+ */
+class IDatagramSender {
+public:
+    virtual ~IDatagramSender() = default;
+
+    /**
+     * @brief Send one datagram to the destination address on the given port
+     * @return false if the stack dropped it (e.g. out of buffers)
+     */
+    virtual bool send(const uint8_t* data, size_t size, uint16_t port) = 0;
+};
+
+} // namespace interfaces
@@ -0,0 +1,31 @@
+/**
+ * @file i_frame_processor.hpp
+ * @brief Frame rewriting stage between capture and the ring buffer
+ */
+#pragma once
+#include "i_camera.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace interfaces {
+
+/**
+ * @brief Rewrites each captured frame before it is committed
+ *
+ * Called from the producer task with the camera frame still held. Whatever
+ * is written to out replaces the frame for every consumer (stream, sinks,
+ * history), so privacy edits cannot be bypassed by any endpoint.
+ */
+class IFrameProcessor {
+public:
+    virtual ~IFrameProcessor() = default;
+
+    /**
+     * @param frame Captured frame (valid until return)
+     * @param out Output buffer (the stream's max frame size)
+     * @return Bytes written to out, or 0 to drop the frame
+     */
+    virtual size_t process(const FrameView& frame, uint8_t* out, size_t capacity) = 0;
+};
+
+} // namespace interfaces
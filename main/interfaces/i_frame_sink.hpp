@@ -0,0 +1,26 @@
+/**
+ * @file i_frame_sink.hpp
+ * @brief Consumer interface for frames committed by the streaming producer
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace interfaces {
+
+/**
+ * @brief Receives every frame the producer commits to the ring buffer
+ *
+ * Called from the producer task right after the frame is pushed, with the
+ * ring sequence number it was assigned. Implementations must copy what they
+ * need and return quickly: blocking here stalls capture.
+ */
+class IFrameSink {
+public:
+    virtual ~IFrameSink() = default;
+
+    virtual void on_frame(const uint8_t* data, size_t size,
+                          int64_t timestamp_us, uint32_t sequence) = 0;
+};
+
+} // namespace interfaces
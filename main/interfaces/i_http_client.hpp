@@ -0,0 +1,33 @@
+/**
+ * @file i_http_client.hpp
+ * @brief HTTP POST transport for uploading frames to a remote collector
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace interfaces {
+
+/**
+ * @brief Posts request bodies to a fixed collector URL over a persistent connection
+ *
+ * Production: esp_http_client with keep-alive
+ * Testing: plain socket client against a loopback stand-in server
+ */
+class IHttpClient {
+public:
+    virtual ~IHttpClient() = default;
+
+    /**
+     * @brief POST a body, (re)connecting first if there is no open connection
+     * @return HTTP status code, or a negative value on transport failure
+     */
+    virtual int post(const char* content_type, const uint8_t* body, size_t size) = 0;
+
+    /**
+     * @brief Drop the connection so the next post() starts a fresh one
+     */
+    virtual void disconnect() = 0;
+};
+
+} // namespace interfaces
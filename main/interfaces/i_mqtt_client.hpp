@@ -0,0 +1,38 @@
+/**
+ * @file i_mqtt_client.hpp
+ * @brief MQTT publish transport for frames, events and status
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace interfaces {
+
+/**
+ * @brief Publishes messages to a broker connection managed by the client
+ *
+ * Production: esp-mqtt (reconnects on its own)
+ * Testing: socket client against a loopback broker stand-in
+ */
+class IMqttClient {
+public:
+    /**
+     * @brief Called (from the client's task) when the broker acknowledges a QoS 1 message
+     */
+    using AckHandler = void (*)(void* ctx, int msg_id);
+
+    virtual ~IMqttClient() = default;
+
+    virtual bool connected() const = 0;
+
+    /**
+     * @brief Hand a message to the client
+     * @return Message id (> 0 for QoS 1, 0 for QoS 0), or -1 if not accepted
+     */
+    virtual int publish(const char* topic, const uint8_t* payload, size_t size,
+                        uint8_t qos, bool retain) = 0;
+
+    virtual void set_ack_handler(AckHandler handler, void* ctx) = 0;
+};
+
+} // namespace interfaces
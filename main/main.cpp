@@ -11,9 +11,26 @@
 
 #include "drivers/esp_camera_driver.hpp"
 #include "drivers/esp_clock_driver.hpp"
+#include "drivers/esp_udp_sender.hpp"
+#include "drivers/esp_http_uploader_client.hpp"
+#include "drivers/esp_mqtt_publisher_client.hpp"
+#include "drivers/esp_partition_storage.hpp"
 #include "core/wifi_manager.hpp"
 #include "core/streaming_service.hpp"
+#include "core/camera_registry.hpp"
 #include "core/web_server.hpp"
+#include "core/frame_history.hpp"
+#include "core/multicast_streamer.hpp"
+#include "core/frame_uploader.hpp"
+#include "core/mqtt_publisher.hpp"
+#include "core/flash_recorder.hpp"
+#include "core/recording_catalog.hpp"
+#include "core/burst_capture.hpp"
+#include "core/image_quality.hpp"
+#include "core/exposure_controller.hpp"
+#include "core/sensor_profiles.hpp"
+#include "core/soft_jpeg_camera.hpp"
+#include "core/jpeg_overlay.hpp"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -47,6 +64,10 @@ static const char* TAG = "main";
 #define CONFIG_CAMERA_FRAME_BUFFERS 2
 #endif
 
+#ifndef CONFIG_CAMERA_SENSOR_PROFILE
+#define CONFIG_CAMERA_SENSOR_PROFILE ""
+#endif
+
 #ifndef CONFIG_STREAM_BUFFER_SLOTS
 #define CONFIG_STREAM_BUFFER_SLOTS 4
 #endif
@@ -55,6 +76,264 @@ static const char* TAG = "main";
 #define CONFIG_STREAM_MAX_FRAME_SIZE 102400
 #endif
 
+#ifndef CONFIG_STREAM_CAMERA_MEMORY_BUDGET_KB
+#define CONFIG_STREAM_CAMERA_MEMORY_BUDGET_KB 2048
+#endif
+
+#ifndef CONFIG_STREAM_CAMERA_FPS_BUDGET
+#define CONFIG_STREAM_CAMERA_FPS_BUDGET 30
+#endif
+
+#ifndef CONFIG_STREAM_ROI_CACHE_ENTRIES
+#define CONFIG_STREAM_ROI_CACHE_ENTRIES 2
+#endif
+
+#ifndef CONFIG_STREAM_PRIVACY_MASKS
+#define CONFIG_STREAM_PRIVACY_MASKS ""
+#endif
+
+#ifndef CONFIG_STREAM_POLL_MAX_TIMEOUT_MS
+#define CONFIG_STREAM_POLL_MAX_TIMEOUT_MS 10000
+#endif
+
+#ifndef CONFIG_STREAM_HTTP_STREAM_WORKERS
+#define CONFIG_STREAM_HTTP_STREAM_WORKERS 2
+#endif
+
+#ifndef CONFIG_STREAM_HTTP_STALL_BUDGET_MS
+#define CONFIG_STREAM_HTTP_STALL_BUDGET_MS 10000
+#endif
+
+#ifndef CONFIG_STREAM_LEASE_TIMEOUT_MS
+#define CONFIG_STREAM_LEASE_TIMEOUT_MS 500
+#endif
+
+#ifndef CONFIG_STREAM_ADMISSION_LINK_KBPS
+#define CONFIG_STREAM_ADMISSION_LINK_KBPS 6000
+#endif
+
+#ifndef CONFIG_STREAM_ADMISSION_LINK_SHARE_PCT
+#define CONFIG_STREAM_ADMISSION_LINK_SHARE_PCT 75
+#endif
+
+#ifndef CONFIG_STREAM_ADMISSION_MIN_HEAP_KB
+#define CONFIG_STREAM_ADMISSION_MIN_HEAP_KB 32
+#endif
+
+#ifndef CONFIG_STREAM_ADMISSION_RETRY_AFTER_S
+#define CONFIG_STREAM_ADMISSION_RETRY_AFTER_S 10
+#endif
+
+#ifndef CONFIG_STREAM_EGRESS_WEIGHT_RECORDER
+#define CONFIG_STREAM_EGRESS_WEIGHT_RECORDER 6
+#endif
+
+#ifndef CONFIG_STREAM_EGRESS_WEIGHT_OPERATOR
+#define CONFIG_STREAM_EGRESS_WEIGHT_OPERATOR 3
+#endif
+
+#ifndef CONFIG_STREAM_EGRESS_WEIGHT_DASHBOARD
+#define CONFIG_STREAM_EGRESS_WEIGHT_DASHBOARD 1
+#endif
+
+#ifndef CONFIG_STREAM_SSE_MAX_CLIENTS
+#define CONFIG_STREAM_SSE_MAX_CLIENTS 3
+#endif
+
+#ifndef CONFIG_STREAM_SSE_MIN_INTERVAL_MS
+#define CONFIG_STREAM_SSE_MIN_INTERVAL_MS 500
+#endif
+
+#ifndef CONFIG_STREAM_HISTORY_KB
+#define CONFIG_STREAM_HISTORY_KB 1024
+#endif
+
+#ifndef CONFIG_STREAM_HISTORY_SECONDS
+#define CONFIG_STREAM_HISTORY_SECONDS 30
+#endif
+
+#ifndef CONFIG_STREAM_MULTICAST_GROUP
+#define CONFIG_STREAM_MULTICAST_GROUP "239.255.0.1"
+#endif
+
+#ifndef CONFIG_STREAM_MULTICAST_PORT
+#define CONFIG_STREAM_MULTICAST_PORT 5004
+#endif
+
+#ifndef CONFIG_STREAM_MULTICAST_TTL
+#define CONFIG_STREAM_MULTICAST_TTL 1
+#endif
+
+#ifndef CONFIG_STREAM_MULTICAST_RATE_KBPS
+#define CONFIG_STREAM_MULTICAST_RATE_KBPS 8000
+#endif
+
+#ifndef CONFIG_STREAM_MULTICAST_PARITY_GROUP
+#define CONFIG_STREAM_MULTICAST_PARITY_GROUP 4
+#endif
+
+#ifndef CONFIG_STREAM_UPLOAD_URL
+#define CONFIG_STREAM_UPLOAD_URL ""
+#endif
+
+#ifndef CONFIG_STREAM_UPLOAD_SPOOL_KB
+#define CONFIG_STREAM_UPLOAD_SPOOL_KB 1024
+#endif
+
+#ifndef CONFIG_STREAM_UPLOAD_BATCH_FRAMES
+#define CONFIG_STREAM_UPLOAD_BATCH_FRAMES 8
+#endif
+
+#ifndef CONFIG_STREAM_UPLOAD_RATE_KBPS
+#define CONFIG_STREAM_UPLOAD_RATE_KBPS 4000
+#endif
+
+#ifndef CONFIG_STREAM_MQTT_BROKER_URI
+#define CONFIG_STREAM_MQTT_BROKER_URI ""
+#endif
+
+#ifndef CONFIG_STREAM_MQTT_TOPIC_PREFIX
+#define CONFIG_STREAM_MQTT_TOPIC_PREFIX "espcam"
+#endif
+
+#ifndef CONFIG_STREAM_MQTT_FRAME_INTERVAL_MS
+#define CONFIG_STREAM_MQTT_FRAME_INTERVAL_MS 1000
+#endif
+
+#ifndef CONFIG_STREAM_RECORDING_INTERVAL_MS
+#define CONFIG_STREAM_RECORDING_INTERVAL_MS 1000
+#endif
+
+#ifndef CONFIG_STREAM_RECORDING_SEGMENT_KB
+#define CONFIG_STREAM_RECORDING_SEGMENT_KB 64
+#endif
+
+#ifndef CONFIG_STREAM_RECORDING_CLIP_S
+#define CONFIG_STREAM_RECORDING_CLIP_S 60
+#endif
+
+#ifndef CONFIG_STREAM_RECORDING_THUMBNAIL_S
+#define CONFIG_STREAM_RECORDING_THUMBNAIL_S 10
+#endif
+
+#ifndef CONFIG_STREAM_BURST_ARENA_KB
+#define CONFIG_STREAM_BURST_ARENA_KB 1024
+#endif
+
+#ifndef CONFIG_STREAM_RECOVERY_FAILURES_PER_STEP
+#define CONFIG_STREAM_RECOVERY_FAILURES_PER_STEP 4
+#endif
+
+#ifndef CONFIG_STREAM_RECOVERY_BACKOFF_MAX_MS
+#define CONFIG_STREAM_RECOVERY_BACKOFF_MAX_MS 2000
+#endif
+
+#ifndef CONFIG_STREAM_BURST_MAX_FRAMES
+#define CONFIG_STREAM_BURST_MAX_FRAMES 30
+#endif
+
+#ifndef CONFIG_STREAM_QUALITY_SAMPLE_FRAMES
+#define CONFIG_STREAM_QUALITY_SAMPLE_FRAMES 30
+#endif
+
+#ifndef CONFIG_STREAM_QUALITY_MIN_SHARPNESS
+#define CONFIG_STREAM_QUALITY_MIN_SHARPNESS 100
+#endif
+
+#ifndef CONFIG_STREAM_QUALITY_MIN_CONTRAST
+#define CONFIG_STREAM_QUALITY_MIN_CONTRAST 12
+#endif
+
+#ifndef CONFIG_STREAM_EXPOSURE_SAMPLE_FRAMES
+#define CONFIG_STREAM_EXPOSURE_SAMPLE_FRAMES 2
+#endif
+
+#ifndef CONFIG_STREAM_EXPOSURE_TARGET_LUMA
+#define CONFIG_STREAM_EXPOSURE_TARGET_LUMA 110
+#endif
+
+#ifndef CONFIG_STREAM_ANTI_FLICKER_HZ
+#define CONFIG_STREAM_ANTI_FLICKER_HZ 0
+#endif
+
+#ifndef CONFIG_STREAM_DELTA_TILE_MCUS
+#define CONFIG_STREAM_DELTA_TILE_MCUS 0
+#endif
+
+#ifndef CONFIG_STREAM_DELTA_KEY_INTERVAL
+#define CONFIG_STREAM_DELTA_KEY_INTERVAL 100
+#endif
+
+#ifdef CONFIG_STREAM_MULTICAST
+#define STREAM_MULTICAST true
+#else
+#define STREAM_MULTICAST false
+#endif
+
+#ifdef CONFIG_STREAM_UPLOAD
+#define STREAM_UPLOAD true
+#else
+#define STREAM_UPLOAD false
+#endif
+
+#ifdef CONFIG_STREAM_MQTT
+#define STREAM_MQTT true
+#else
+#define STREAM_MQTT false
+#endif
+
+#ifdef CONFIG_STREAM_MQTT_FRAMES
+#define STREAM_MQTT_FRAMES true
+#else
+#define STREAM_MQTT_FRAMES false
+#endif
+
+#ifdef CONFIG_STREAM_RECORDING
+#define STREAM_RECORDING true
+#else
+#define STREAM_RECORDING false
+#endif
+
+#ifdef CONFIG_CAMERA_SOFTWARE_JPEG
+#define CAMERA_SOFTWARE_JPEG true
+#else
+#define CAMERA_SOFTWARE_JPEG false
+#endif
+
+#ifdef CONFIG_CAMERA_SOFTWARE_JPEG_GRAYSCALE
+#define CAMERA_RAW_FORMAT interfaces::PixelFormat::Grayscale
+#else
+#define CAMERA_RAW_FORMAT interfaces::PixelFormat::Yuv422
+#endif
+
+#ifdef CONFIG_STREAM_EXPOSURE_ASSIST
+#define STREAM_EXPOSURE_ASSIST true
+#else
+#define STREAM_EXPOSURE_ASSIST false
+#endif
+
+#define STREAM_ANTI_FLICKER (CONFIG_STREAM_ANTI_FLICKER_HZ == 50 ? interfaces::AntiFlicker::Hz50 \
+                           : CONFIG_STREAM_ANTI_FLICKER_HZ == 60 ? interfaces::AntiFlicker::Hz60 \
+                           : interfaces::AntiFlicker::Off)
+
+#ifdef CONFIG_STREAM_TIMESTAMP_OVERLAY
+#define STREAM_TIMESTAMP_OVERLAY true
+#else
+#define STREAM_TIMESTAMP_OVERLAY false
+#endif
+
+#ifdef CONFIG_STREAM_EMBED_METADATA
+#define STREAM_EMBED_METADATA true
+#else
+#define STREAM_EMBED_METADATA false
+#endif
+
+#ifdef CONFIG_STREAM_EGRESS_WEIGHTED
+#define STREAM_EGRESS_WEIGHTED true
+#else
+#define STREAM_EGRESS_WEIGHTED false
+#endif
+
 extern "C" void app_main() {
     ESP_LOGI(TAG, "=== ESP32-S3 WiFi Camera ===");
     ESP_LOGI(TAG, "Architecture: Dependency Injection + Producer-Consumer");
@@ -63,9 +342,15 @@ extern "C" void app_main() {
     // 1. Create drivers (hardware abstraction)
     // =========================================================================
     drivers::CameraPins pins;  // Uses default ESP32-S3-EYE pins
-    drivers::EspCameraDriver camera(pins);
+    drivers::EspCameraDriver sensor(pins);
     drivers::EspClockDriver clock;
     
+    // Optionally capture raw frames and JPEG-encode them in software
+    // (static: the encoder's tables are too large for the app_main stack)
+    static core::SoftJpegCamera soft_jpeg(sensor, CAMERA_RAW_FORMAT, CONFIG_STREAM_MAX_FRAME_SIZE);
+    interfaces::ICamera& camera = CAMERA_SOFTWARE_JPEG
+        ? static_cast<interfaces::ICamera&>(soft_jpeg) : sensor;
+    
     // =========================================================================
     // 2. Initialize camera
     // =========================================================================
@@ -73,12 +358,31 @@ extern "C" void app_main() {
     cam_config.resolution = interfaces::Resolution::VGA;
     cam_config.jpeg_quality = CONFIG_CAMERA_JPEG_QUALITY;
     cam_config.frame_buffer_count = CONFIG_CAMERA_FRAME_BUFFERS;
+    if (CONFIG_CAMERA_SENSOR_PROFILE[0]) {
+        cam_config.profile = core::find_sensor_profile(CONFIG_CAMERA_SENSOR_PROFILE);
+        if (!cam_config.profile) {
+            ESP_LOGW(TAG, "Unknown sensor profile: %s", CONFIG_CAMERA_SENSOR_PROFILE);
+        }
+    }
     
     if (!camera.init(cam_config)) {
         ESP_LOGE(TAG, "Camera init failed!");
         return;
     }
     ESP_LOGI(TAG, "Camera initialized");
+    if (const auto* profile = camera.get_profile()) {
+        if (CONFIG_STREAM_FPS > profile->max_fps) {
+            ESP_LOGW(TAG, "Profile %s delivers at most %d FPS", profile->name, profile->max_fps);
+        }
+    }
+    if (!STREAM_EXPOSURE_ASSIST && STREAM_ANTI_FLICKER != interfaces::AntiFlicker::Off) {
+        // The sensor's AEC with its banding filter
+        interfaces::ExposureSettings exposure_settings;
+        exposure_settings.anti_flicker = STREAM_ANTI_FLICKER;
+        if (!camera.set_exposure(exposure_settings)) {
+            ESP_LOGW(TAG, "Sensor rejected the anti-flicker setting");
+        }
+    }
     
     // =========================================================================
     // 3. Connect to WiFi
@@ -99,17 +403,251 @@ extern "C" void app_main() {
     // =========================================================================
     // 4. Initialize streaming service (producer-consumer pipeline)
     // =========================================================================
-    core::StreamingService streaming(camera, clock);
+    // Every pipeline comes from the registry so ring memory and producer
+    // rates stay within one budget; the on-board sensor is camera "0"
+    // (esp_camera is a singleton, further sources are network/USB cameras)
+    core::CameraRegistryConfig registry_config;
+    registry_config.memory_budget_bytes = static_cast<size_t>(CONFIG_STREAM_CAMERA_MEMORY_BUDGET_KB) * 1024;
+    registry_config.total_fps_budget = CONFIG_STREAM_CAMERA_FPS_BUDGET;
+    core::CameraRegistry cameras(registry_config);
     
     core::StreamingConfig stream_config;
     stream_config.target_fps = CONFIG_STREAM_FPS;
     stream_config.buffer_slots = CONFIG_STREAM_BUFFER_SLOTS;
     stream_config.max_frame_size = CONFIG_STREAM_MAX_FRAME_SIZE;
+    stream_config.lease_timeout_ms = CONFIG_STREAM_LEASE_TIMEOUT_MS;
+    stream_config.recovery.failures_before_reset = CONFIG_STREAM_RECOVERY_FAILURES_PER_STEP;
+    stream_config.recovery.backoff_max_ms = CONFIG_STREAM_RECOVERY_BACKOFF_MAX_MS;
+    stream_config.camera = cam_config;   // For a re-init during capture recovery
     
-    if (!streaming.init(stream_config)) {
-        ESP_LOGE(TAG, "Streaming service init failed!");
+    core::StreamingService* primary = cameras.add_camera("0", camera, clock, stream_config);
+    if (!primary) {
+        ESP_LOGE(TAG, "Streaming service init failed (ring exceeds camera memory budget?)");
         return;
     }
+    core::StreamingService& streaming = *primary;
+    
+    // Privacy masks / timestamp, applied before frames reach the ring buffer
+    static core::JpegOverlayProcessor overlay;   // ~10 KB of tables, off the stack
+    core::OverlayConfig overlay_config;
+    overlay_config.timestamp = STREAM_TIMESTAMP_OVERLAY;
+    if (!core::parse_overlay_masks(CONFIG_STREAM_PRIVACY_MASKS, &overlay_config)) {
+        // Fail closed: a typo must not silently disable masking
+        ESP_LOGE(TAG, "Invalid privacy masks: %s", CONFIG_STREAM_PRIVACY_MASKS);
+        return;
+    }
+    if (overlay_config.num_masks > 0 || overlay_config.timestamp) {
+        if (!overlay.init(overlay_config) || !streaming.set_processor(&overlay)) {
+            ESP_LOGE(TAG, "Frame overlay setup failed!");
+            return;
+        }
+        ESP_LOGI(TAG, "Overlay: %zu privacy masks, timestamp %s", overlay_config.num_masks,
+                 overlay_config.timestamp ? "on" : "off");
+    }
+    
+    // Recent-frame history for /stream?from= (optional, PSRAM)
+    core::FrameHistory history;
+    if (CONFIG_STREAM_HISTORY_KB > 0) {
+        size_t max_entries = static_cast<size_t>(CONFIG_STREAM_HISTORY_SECONDS) * CONFIG_STREAM_FPS + 1;
+        if (!history.init(static_cast<size_t>(CONFIG_STREAM_HISTORY_KB) * 1024, max_entries,
+                          static_cast<int64_t>(CONFIG_STREAM_HISTORY_SECONDS) * 1000 * 1000) ||
+            !streaming.add_sink(&history)) {
+            history.deinit();
+            ESP_LOGW(TAG, "History setup failed, /stream?from= disabled");
+        }
+    }
+    
+    // One paced RTP/JPEG multicast for any number of viewers (optional)
+    drivers::EspUdpSender udp;
+    core::MulticastStreamer multicast(udp, clock);
+    if (STREAM_MULTICAST) {
+        core::MulticastConfig mcast_config;
+        mcast_config.port = CONFIG_STREAM_MULTICAST_PORT;
+        mcast_config.max_frame_size = CONFIG_STREAM_MAX_FRAME_SIZE;
+        mcast_config.rate_kbps = CONFIG_STREAM_MULTICAST_RATE_KBPS;
+        mcast_config.parity_group = CONFIG_STREAM_MULTICAST_PARITY_GROUP;
+        if (!udp.init(CONFIG_STREAM_MULTICAST_GROUP, CONFIG_STREAM_MULTICAST_TTL) ||
+            !multicast.init(mcast_config) || !multicast.start() || !streaming.add_sink(&multicast)) {
+            multicast.deinit();
+            ESP_LOGW(TAG, "Multicast setup failed, multicast disabled");
+        }
+    }
+    
+    // Uploader (recorder class) and stream clients share the link by priority
+    core::EgressScheduler egress;
+    core::EgressSchedulerConfig egress_config;
+    egress_config.policy = STREAM_EGRESS_WEIGHTED ? core::EgressPolicy::Weighted : core::EgressPolicy::Strict;
+    egress_config.weights[static_cast<size_t>(core::ConsumerClass::Recorder)] = CONFIG_STREAM_EGRESS_WEIGHT_RECORDER;
+    egress_config.weights[static_cast<size_t>(core::ConsumerClass::Operator)] = CONFIG_STREAM_EGRESS_WEIGHT_OPERATOR;
+    egress_config.weights[static_cast<size_t>(core::ConsumerClass::Dashboard)] = CONFIG_STREAM_EGRESS_WEIGHT_DASHBOARD;
+    egress.set_config(egress_config);
+    
+    // Batched upload to a remote collector, spooled across outages (optional)
+    drivers::EspHttpUploaderClient upload_client;
+    core::FrameUploader uploader(upload_client, clock);
+    if (STREAM_UPLOAD) {
+        core::UploaderConfig upload_config;
+        upload_config.camera_id = wifi.hostname();
+        upload_config.spool_bytes = static_cast<size_t>(CONFIG_STREAM_UPLOAD_SPOOL_KB) * 1024;
+        upload_config.spool_frames = CONFIG_STREAM_UPLOAD_SPOOL_KB;   // >= 1 KB per frame
+        upload_config.max_batch_frames = CONFIG_STREAM_UPLOAD_BATCH_FRAMES;
+        upload_config.max_batch_bytes = 2 * CONFIG_STREAM_MAX_FRAME_SIZE;   // Any frame fits
+        upload_config.rate_kbps = CONFIG_STREAM_UPLOAD_RATE_KBPS;
+        upload_config.scheduler = &egress;
+        if (upload_client.init(CONFIG_STREAM_UPLOAD_URL) &&
+            uploader.init(upload_config) && uploader.start() && streaming.add_sink(&uploader)) {
+            ESP_LOGI(TAG, "Uploading to %s", CONFIG_STREAM_UPLOAD_URL);
+        } else {
+            uploader.deinit();
+            ESP_LOGW(TAG, "Uploader setup failed, upload disabled");
+        }
+    }
+    
+    // Status, events and (optionally) frames to an MQTT broker
+    static char mqtt_topics[3][96];
+    snprintf(mqtt_topics[0], sizeof(mqtt_topics[0]), "%s/%s/frame",
+             CONFIG_STREAM_MQTT_TOPIC_PREFIX, wifi.hostname());
+    snprintf(mqtt_topics[1], sizeof(mqtt_topics[1]), "%s/%s/event",
+             CONFIG_STREAM_MQTT_TOPIC_PREFIX, wifi.hostname());
+    snprintf(mqtt_topics[2], sizeof(mqtt_topics[2]), "%s/%s/status",
+             CONFIG_STREAM_MQTT_TOPIC_PREFIX, wifi.hostname());
+    drivers::EspMqttPublisherClient mqtt_client;
+    core::MqttPublisher mqtt(mqtt_client, clock);
+    if (STREAM_MQTT) {
+        core::MqttPublisherConfig mqtt_config;
+        mqtt_config.frame_topic = mqtt_topics[0];
+        mqtt_config.event_topic = mqtt_topics[1];
+        mqtt_config.status_topic = mqtt_topics[2];
+        mqtt_config.publish_frames = STREAM_MQTT_FRAMES;
+        mqtt_config.max_frame_size = CONFIG_STREAM_MAX_FRAME_SIZE;
+        mqtt_config.frame_interval_ms = CONFIG_STREAM_MQTT_FRAME_INTERVAL_MS;
+        // Publisher first: it registers the ack handler the client calls
+        if (mqtt.init(mqtt_config) && mqtt_client.init(CONFIG_STREAM_MQTT_BROKER_URI, wifi.hostname()) &&
+            mqtt.start()) {
+            if (STREAM_MQTT_FRAMES && !streaming.add_sink(&mqtt)) {
+                ESP_LOGW(TAG, "No frame sink slot left, MQTT frames disabled");
+            }
+            mqtt.publish_event("{\"type\":\"online\"}");
+            ESP_LOGI(TAG, "Publishing to %s as %s/%s", CONFIG_STREAM_MQTT_BROKER_URI,
+                     CONFIG_STREAM_MQTT_TOPIC_PREFIX, wifi.hostname());
+        } else {
+            ESP_LOGW(TAG, "MQTT setup failed, MQTT disabled");
+        }
+    }
+    
+    // Continuous recording into the flash partition (optional). The last
+    // 1/16 holds the clip index and thumbnails for /recordings.
+    size_t segment_size = static_cast<size_t>(CONFIG_STREAM_RECORDING_SEGMENT_KB) * 1024;
+    drivers::EspPartitionStorage recording_flash;
+    size_t index_bytes = 0;
+    if (STREAM_RECORDING && recording_flash.init("recording")) {
+        size_t segments = recording_flash.size() / segment_size;
+        index_bytes = (segments / 16 > 4 ? segments / 16 : 4) * segment_size;
+    }
+    size_t frame_bytes = recording_flash.size() > index_bytes ? recording_flash.size() - index_bytes : 0;
+    core::BlockStorageRegion frame_region(recording_flash, 0, frame_bytes);
+    core::BlockStorageRegion index_region(recording_flash, frame_bytes, index_bytes);
+    core::SegmentStore recording_store(frame_region);
+    core::SegmentStore recording_index(index_region);
+    static core::RecordingCatalog catalog(recording_store, recording_index);   // Codec tables, off the stack
+    core::FlashRecorder recorder(recording_store);
+    if (STREAM_RECORDING && frame_bytes > 0) {
+        core::SegmentStoreConfig store_config;
+        store_config.segment_size = segment_size;
+        store_config.spare_segments = 2;
+        core::SegmentStoreConfig index_config;
+        index_config.segment_size = segment_size;
+        index_config.spare_segments = 1;
+        core::RecordingCatalogConfig catalog_config;
+        catalog_config.clip_gap_ms = CONFIG_STREAM_RECORDING_INTERVAL_MS * 3 > 5000
+            ? CONFIG_STREAM_RECORDING_INTERVAL_MS * 3 : 5000;
+        catalog_config.max_clip_duration_ms = CONFIG_STREAM_RECORDING_CLIP_S * 1000;
+        catalog_config.thumbnail_interval_ms = CONFIG_STREAM_RECORDING_THUMBNAIL_S * 1000;
+        core::FlashRecorderConfig recorder_config;
+        recorder_config.max_frame_size = CONFIG_STREAM_MAX_FRAME_SIZE;
+        recorder_config.frame_interval_ms = CONFIG_STREAM_RECORDING_INTERVAL_MS;
+        int64_t mount_start = clock.now_us();
+        if (recording_store.mount(store_config) && recording_index.mount(index_config) &&
+            recorder.init(recorder_config)) {
+            if (catalog.init(catalog_config)) {
+                recorder.set_catalog(&catalog);
+            } else {
+                ESP_LOGW(TAG, "Recording catalog setup failed, /recordings disabled");
+            }
+            if (recorder.start() && streaming.add_sink(&recorder)) {
+                ESP_LOGI(TAG, "Recording: %lu frames in %zu/%zu segments, %zu clips, mounted in %lld ms",
+                         static_cast<unsigned long>(recording_store.record_count()),
+                         recording_store.data_segments(), recording_store.segment_count(),
+                         catalog.clip_count(),
+                         static_cast<long long>((clock.now_us() - mount_start) / 1000));
+            } else {
+                recorder.deinit();
+            }
+        }
+        if (!recorder.is_running()) {
+            ESP_LOGW(TAG, "Recording setup failed, recording disabled");
+        }
+    }
+    
+    // Full-rate sequences for /burst, captured by the producer (optional, PSRAM)
+    core::BurstCapture burst;
+    if (CONFIG_STREAM_BURST_ARENA_KB > 0) {
+        core::BurstConfig burst_config;
+        burst_config.arena_size = static_cast<size_t>(CONFIG_STREAM_BURST_ARENA_KB) * 1024;
+        burst_config.max_frames = CONFIG_STREAM_BURST_MAX_FRAMES;
+        if (!burst.init(burst_config) || !streaming.set_burst(&burst)) {
+            ESP_LOGW(TAG, "Burst arena allocation failed, /burst disabled");
+            burst.deinit();
+        }
+    }
+    
+    // Sampled image quality (blur, fog, glare, darkness) with alerts over MQTT
+    static core::QualityMonitor quality;   // Codec tables, off the stack
+    static core::ExposureController exposure;
+    if (CONFIG_STREAM_QUALITY_SAMPLE_FRAMES > 0) {
+        core::QualityMonitorConfig quality_config;
+        quality_config.max_frame_size = CONFIG_STREAM_MAX_FRAME_SIZE;
+        quality_config.sample_interval = STREAM_EXPOSURE_ASSIST ? CONFIG_STREAM_EXPOSURE_SAMPLE_FRAMES
+                                                                : CONFIG_STREAM_QUALITY_SAMPLE_FRAMES;
+        quality_config.thresholds.min_sharpness = CONFIG_STREAM_QUALITY_MIN_SHARPNESS;
+        quality_config.thresholds.min_contrast = CONFIG_STREAM_QUALITY_MIN_CONTRAST;
+        auto on_alert = [](void* ctx, uint8_t alerts, const core::ImageQualityMetrics& m) {
+            char json[256];
+            if (core::format_quality_json(m, alerts, json, sizeof(json)) == 0) return;
+            ESP_LOGW(TAG, "Quality: %s", json);
+            auto* publisher = static_cast<core::MqttPublisher*>(ctx);
+            if (publisher->is_running()) publisher->publish_event(json);
+        };
+        quality.set_alert_callback(on_alert, &mqtt);
+        if (STREAM_EXPOSURE_ASSIST) {
+            core::ExposureControllerConfig exposure_config;
+            exposure_config.target_luma = CONFIG_STREAM_EXPOSURE_TARGET_LUMA;
+            exposure_config.anti_flicker = STREAM_ANTI_FLICKER;
+            if (exposure.init(&camera, exposure_config)) {
+                quality.set_metrics_callback(core::ExposureController::on_metrics, &exposure);
+            } else {
+                ESP_LOGW(TAG, "Manual exposure rejected, leaving it to the sensor");
+            }
+        }
+        if (!quality.init(quality_config) || !quality.start() || !streaming.add_sink(&quality)) {
+            quality.deinit();
+            exposure.deinit();   // No metrics would reach it: back to the sensor's AEC
+            ESP_LOGW(TAG, "Quality monitor setup failed, quality alerts and exposure assist disabled");
+        }
+    }
+    
+    // Capture failures and recoveries go out as MQTT events
+    auto on_health = [](void* ctx, core::CameraHealth health, const core::CaptureRecoveryStats& rs) {
+        char json[160];
+        snprintf(json, sizeof(json),
+                 "{\"type\":\"camera\",\"health\":\"%s\",\"failures\":%lu,\"recovery_ms\":%lu}",
+                 core::camera_health_name(health), rs.consecutive_failures.load(),
+                 health == core::CameraHealth::Healthy ? rs.recovery_us_last.load() / 1000 : 0UL);
+        ESP_LOGW(TAG, "Camera: %s", json);
+        auto* publisher = static_cast<core::MqttPublisher*>(ctx);
+        if (publisher->is_running()) publisher->publish_event(json);
+    };
+    streaming.set_health_callback(on_health, &mqtt);
     
     // Start the producer task
     if (!streaming.start()) {
@@ -117,15 +655,52 @@ extern "C" void app_main() {
         return;
     }
     ESP_LOGI(TAG, "Streaming service started @ %d FPS (buffer=%zu)", 
-             stream_config.target_fps, stream_config.buffer_slots);
+             streaming.get_target_fps(), stream_config.buffer_slots);
     
     // =========================================================================
     // 5. Start web server
     // =========================================================================
     core::WebServer server(camera, streaming);
     server.set_device_info(wifi.ip_address(), wifi.hostname(), wifi.mac_address());
+    server.set_cameras(&cameras);
+    if (history.is_initialized()) {
+        server.set_history(&history);
+    }
+    if (catalog.is_initialized()) {
+        server.set_recordings(&catalog);
+    }
+    if (burst.is_initialized()) {
+        server.set_burst(&burst);
+    }
+    server.set_egress_scheduler(&egress);
+    static char multicast_sdp[512];
+    if (multicast.is_running() &&
+        core::rtp_jpeg_format_sdp(multicast_sdp, sizeof(multicast_sdp), wifi.ip_address(),
+                                  CONFIG_STREAM_MULTICAST_GROUP, CONFIG_STREAM_MULTICAST_PORT,
+                                  CONFIG_STREAM_MULTICAST_TTL, multicast.config().ssrc)) {
+        server.set_multicast_sdp(multicast_sdp);
+        ESP_LOGI(TAG, "Multicast RTP/JPEG on %s:%d", CONFIG_STREAM_MULTICAST_GROUP,
+                 CONFIG_STREAM_MULTICAST_PORT);
+    }
+    
+    core::WebServerConfig server_config;
+    server_config.roi_cache_entries = CONFIG_STREAM_ROI_CACHE_ENTRIES;
+    server_config.embed_metadata = STREAM_EMBED_METADATA;
+    server_config.frame_poll_max_timeout_ms = CONFIG_STREAM_POLL_MAX_TIMEOUT_MS;
+    server_config.stream_workers = CONFIG_STREAM_HTTP_STREAM_WORKERS;
+    server_config.single_client_stream = CONFIG_STREAM_HTTP_STREAM_WORKERS == 0;
+    server_config.stream_stall_budget_ms = CONFIG_STREAM_HTTP_STALL_BUDGET_MS;
+    server_config.link_capacity_kbps = CONFIG_STREAM_ADMISSION_LINK_KBPS;
+    server_config.admission.link_share_pct = CONFIG_STREAM_ADMISSION_LINK_SHARE_PCT;
+    server_config.admission.min_free_heap = CONFIG_STREAM_ADMISSION_MIN_HEAP_KB * 1024;
+    server_config.admission.retry_after_s = CONFIG_STREAM_ADMISSION_RETRY_AFTER_S;
+    server_config.sse_max_clients = CONFIG_STREAM_SSE_MAX_CLIENTS;
+    server_config.sse_min_interval_ms = CONFIG_STREAM_SSE_MIN_INTERVAL_MS;
+    server_config.delta_tile_mcus = CONFIG_STREAM_DELTA_TILE_MCUS;
+    server_config.delta_key_interval = CONFIG_STREAM_DELTA_KEY_INTERVAL;
+    server_config.burst_max_frames = CONFIG_STREAM_BURST_MAX_FRAMES;
     
-    if (!server.start()) {
+    if (!server.start(server_config)) {
         ESP_LOGE(TAG, "Web server start failed!");
         return;
     }
@@ -139,9 +714,14 @@ extern "C" void app_main() {
     ESP_LOGI(TAG, "  http://%s.local/", wifi.hostname());
     ESP_LOGI(TAG, "========================================");
     
-    // Keep main task alive and log stats periodically
-    while (true) {
-        vTaskDelay(pdMS_TO_TICKS(30000));  // Every 30 seconds
+    // Keep main task alive, feed MQTT status and log stats periodically
+    for (uint32_t tick = 1;; tick++) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        server.refresh_link_estimate();   // Egress capacity follows RSSI
+        if (mqtt.is_running()) {
+            mqtt.publish_status(server.status_snapshot());   // Sent only when changed
+        }
+        if (tick % 30 != 0) continue;  // Log every 30 seconds
         
         auto& stats = streaming.stats();
         ESP_LOGI(TAG, "Stats: captured=%lu sent=%lu dropped=%lu errors=%lu heap=%lu",
@@ -150,5 +730,68 @@ extern "C" void app_main() {
                  stats.frames_dropped.load(),
                  stats.capture_errors.load(),
                  esp_get_free_heap_size());
+        auto& rs = streaming.recovery_stats();
+        if (rs.episodes.load() > 0) {
+            ESP_LOGI(TAG, "Camera: %s outages=%lu resets=%lu reinits=%lu recovery=%lu/%lu ms (mean/max) MTBF=%llu s",
+                     core::camera_health_name(streaming.health()), rs.episodes.load(),
+                     rs.sensor_resets.load(), rs.reinits.load(), rs.recovery_us_mean() / 1000,
+                     rs.recovery_us_max.load() / 1000, rs.mtbf_us() / 1000000);
+        }
+        auto& sw = server.stream_worker_stats();
+        if (sw.submitted.load() > 0) {
+            auto& ws = server.stats();
+            auto& adm = server.admission_stats();
+            ESP_LOGI(TAG, "Streams: active=%lu peak=%lu served=%lu busy=%lu evicted=%lu skipped=%lu revoked=%lu",
+                     sw.active.load(), sw.peak_active.load(), sw.completed.load(),
+                     sw.rejected.load(), ws.stream_evictions.load(),
+                     ws.stream_frames_skipped.load(), streaming.stats().leases_revoked.load());
+            ESP_LOGI(TAG, "Admission: accepted=%lu degraded=%lu rejected=%lu (heap=%lu capacity=%lu)",
+                     adm.accepted.load(), adm.degraded.load(), adm.rejected.load(),
+                     adm.rejected_heap.load(), adm.rejected_capacity.load());
+        }
+        auto& eg = egress.stats();
+        if (eg.allocations.load() > 0) {
+            auto& rec = eg.of(core::ConsumerClass::Recorder);
+            auto& op = eg.of(core::ConsumerClass::Operator);
+            auto& dash = eg.of(core::ConsumerClass::Dashboard);
+            ESP_LOGI(TAG, "Egress (%s, %lu B/s): delivered recorder=%lu%% operator=%lu%% dashboard=%lu%%",
+                     core::egress_policy_name(egress.config().policy), eg.capacity_Bps.load(),
+                     rec.delivery_permille() / 10, op.delivery_permille() / 10,
+                     dash.delivery_permille() / 10);
+        }
+        if (uploader.is_running()) {
+            auto& up = uploader.stats();
+            ESP_LOGI(TAG, "Upload: frames=%lu batches=%lu %lu B/s queued=%lu retries=%lu lost=%lu",
+                     up.frames_uploaded.load(), up.batches_sent.load(), up.throughput_bps(),
+                     up.queue_depth.load(), up.retries.load(), up.frames_lost.load());
+        }
+        if (mqtt.is_running()) {
+            auto& mq = mqtt.stats();
+            ESP_LOGI(TAG, "MQTT: frames=%lu superseded=%lu events=%lu dropped=%lu inflight=%lu timeouts=%lu",
+                     mq.frames_published.load(), mq.frames_superseded.load(),
+                     mq.events_published.load(), mq.events_dropped.load(),
+                     mq.inflight.load(), mq.ack_timeouts.load());
+        }
+        if (quality.is_running()) {
+            auto& q = quality.stats();
+            ESP_LOGI(TAG, "Quality: sharpness=%u contrast=%u noise=%u luma=%u clipped=%u%% alerts=0x%02x (%lu us/frame)",
+                     q.sharpness.load(), q.contrast.load(), q.noise.load(), q.mean_luma.load(),
+                     q.bright_pct.load(), q.alerts_active.load(), q.analyze_us_mean());
+        }
+        if (exposure.is_initialized()) {
+            auto& ex = exposure.stats();
+            ESP_LOGI(TAG, "Exposure: %lu us x%u.%02u luma=%u %s changes=%lu reversals=%lu",
+                     ex.exposure_us.load(), ex.gain_x16.load() / 16, ex.gain_x16.load() % 16 * 100 / 16,
+                     ex.mean_luma.load(), ex.converged.load() ? "settled" : ex.limited.load() ? "limited" : "adjusting",
+                     ex.adjustments.load(), ex.reversals.load());
+        }
+        if (recorder.is_running()) {
+            auto& rec = recorder.stats();
+            auto& st = recording_store.stats();
+            ESP_LOGI(TAG, "Recording: frames=%lu superseded=%lu errors=%lu WA=%.3f erases=%lu stalls=%lu clips=%zu",
+                     rec.frames_recorded.load(), rec.frames_superseded.load(), rec.write_errors.load(),
+                     st.write_amplification(), st.erases.load(), st.erase_stalls.load(),
+                     catalog.clip_count());
+        }
     }
 }
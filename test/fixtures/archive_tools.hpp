@@ -0,0 +1,76 @@
+/**
+ * @file archive_tools.hpp
+ * @brief Runs the system's unzip/tar on generated archives
+ *
+ * Only available when the host build found the tools (HAVE_UNZIP, HAVE_TAR;
+ * UNZIP_EXECUTABLE and TAR_EXECUTABLE hold their paths).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fixtures {
+
+/**
+ * @brief Archive bytes in a temporary file, removed on destruction
+ */
+class TempArchive {
+public:
+    TempArchive(const std::vector<uint8_t>& bytes, const char* extension) {
+        char path[] = "/tmp/archive_test_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) return;
+        bool ok = write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size());
+        close(fd);
+        base_ = path;
+        path_ = base_ + extension;
+        if (!ok || rename(base_.c_str(), path_.c_str()) != 0) {
+            unlink(base_.c_str());
+            path_.clear();
+        }
+    }
+
+    ~TempArchive() {
+        if (!path_.empty()) unlink(path_.c_str());
+    }
+
+    TempArchive(const TempArchive&) = delete;
+    TempArchive& operator=(const TempArchive&) = delete;
+
+    bool valid() const { return !path_.empty(); }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string base_;
+    std::string path_;
+};
+
+/**
+ * @brief Run a shell command, capturing stdout (stderr is discarded)
+ * @return The command's exit status, -1 if it could not be run
+ */
+inline int run_tool(const std::string& command, std::vector<uint8_t>* output) {
+    std::string full = command + " 2>/dev/null";
+    FILE* pipe = popen(full.c_str(), "r");
+    if (!pipe) return -1;
+    if (output) output->clear();
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), pipe)) > 0) {
+        if (output) output->insert(output->end(), chunk, chunk + n);
+    }
+    int status = pclose(pipe);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+inline std::string as_text(const std::vector<uint8_t>& bytes) {
+    return std::string(bytes.begin(), bytes.end());
+}
+
+} // namespace fixtures
@@ -0,0 +1,130 @@
+/**
+ * @file file_flash.hpp
+ * @brief IBlockStorage backed by a host file, emulating NOR flash
+ *
+ * Programming can only clear bits (new = old & data), like real flash;
+ * writes that would need an erase are counted as violations. Per-block
+ * erase counters show wear, and a power cut can be scheduled after a given
+ * number of programmed bytes: the write in progress stops part-way and
+ * every later operation fails until power is restored. The file survives
+ * for remounting until the object is destroyed.
+ */
+#pragma once
+
+#include "../../main/interfaces/i_block_storage.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace fixtures {
+
+class FileFlash : public interfaces::IBlockStorage {
+public:
+    FileFlash(size_t size, size_t erase_size = 4096)
+        : size_(size), erase_size_(erase_size), erase_counts_(size / erase_size, 0) {
+        char path[] = "/tmp/espcam_flash_XXXXXX";
+        fd_ = mkstemp(path);
+        path_ = path;
+        if (fd_ >= 0) {
+            std::vector<uint8_t> blank(erase_size_, 0xFF);   // Factory-fresh flash is erased
+            for (size_t off = 0; off < size_; off += erase_size_) {
+                if (pwrite(fd_, blank.data(), blank.size(), static_cast<off_t>(off)) < 0) break;
+            }
+        }
+    }
+
+    ~FileFlash() override {
+        if (fd_ >= 0) close(fd_);
+        unlink(path_.c_str());
+    }
+
+    FileFlash(const FileFlash&) = delete;
+    FileFlash& operator=(const FileFlash&) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+
+    size_t size() const override { return size_; }
+    size_t erase_size() const override { return erase_size_; }
+
+    bool read(size_t offset, void* out, size_t size) override {
+        reads_++;
+        if (!powered_ || offset + size > size_) return false;
+        return pread(fd_, out, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+    }
+
+    bool write(size_t offset, const void* data, size_t size) override {
+        if (!powered_ || offset + size > size_) return false;
+        bool complete = true;
+        if (cut_after_ >= 0) {
+            if (static_cast<int64_t>(size) > cut_after_) {
+                size = static_cast<size_t>(cut_after_);
+                complete = false;
+                powered_ = false;
+            }
+            cut_after_ -= static_cast<int64_t>(size);
+        }
+        std::vector<uint8_t> cell(size);
+        if (size && pread(fd_, cell.data(), size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size)) {
+            return false;
+        }
+        const uint8_t* in = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            if ((cell[i] & in[i]) != in[i]) violations_++;   // Needs a 0 -> 1 transition
+            cell[i] &= in[i];
+        }
+        if (size && pwrite(fd_, cell.data(), size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size)) {
+            return false;
+        }
+        bytes_written_ += size;
+        return complete;
+    }
+
+    bool erase(size_t offset, size_t size) override {
+        if (!powered_ || offset % erase_size_ || size % erase_size_ || offset + size > size_) return false;
+        std::vector<uint8_t> blank(erase_size_, 0xFF);
+        for (size_t off = offset; off < offset + size; off += erase_size_) {
+            if (pwrite(fd_, blank.data(), blank.size(), static_cast<off_t>(off)) < 0) return false;
+            erase_counts_[off / erase_size_]++;
+        }
+        bytes_erased_ += size;
+        return true;
+    }
+
+    // Lose power after this many more programmed bytes (-1 = never)
+    void cut_power_after(int64_t bytes) { cut_after_ = bytes; }
+
+    void restore_power() {
+        powered_ = true;
+        cut_after_ = -1;
+    }
+
+    // Overwrite raw bytes, bypassing flash semantics (bit rot)
+    void corrupt(size_t offset, uint8_t value) {
+        if (pwrite(fd_, &value, 1, static_cast<off_t>(offset)) != 1) return;
+    }
+
+    bool powered() const { return powered_; }
+    uint64_t bytes_written() const { return bytes_written_; }
+    uint64_t bytes_erased() const { return bytes_erased_; }
+    uint64_t reads() const { return reads_; }
+    uint64_t violations() const { return violations_; }
+    const std::vector<uint32_t>& erase_counts() const { return erase_counts_; }
+
+private:
+    size_t size_;
+    size_t erase_size_;
+    int fd_ = -1;
+    std::string path_;
+    bool powered_ = true;
+    int64_t cut_after_ = -1;
+    uint64_t bytes_written_ = 0;
+    uint64_t bytes_erased_ = 0;
+    uint64_t reads_ = 0;
+    uint64_t violations_ = 0;
+    std::vector<uint32_t> erase_counts_;
+};
+
+} // namespace fixtures
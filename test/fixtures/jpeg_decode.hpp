@@ -0,0 +1,81 @@
+/**
+ * @file jpeg_decode.hpp
+ * @brief libjpeg reference decoder used to check that outputs are valid JPEGs
+ *
+ * Only available when the host build found libjpeg (HAVE_LIBJPEG).
+ */
+#pragma once
+
+#ifdef HAVE_LIBJPEG
+
+#include <cstdint>
+#include <cstdio>
+#include <csetjmp>
+#include <vector>
+#include <jpeglib.h>
+
+namespace fixtures {
+
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    std::vector<uint8_t> pixels;  // Interleaved, row-major
+
+    const uint8_t* at(int x, int y) const {
+        return &pixels[(static_cast<size_t>(y) * width + x) * components];
+    }
+};
+
+/**
+ * @brief Decode with libjpeg (box upsampling, integer IDCT for exact comparisons)
+ * @return false if libjpeg rejects the data
+ */
+inline bool decode_jpeg(const uint8_t* data, size_t size, DecodedImage* out) {
+    struct ErrorMgr {
+        jpeg_error_mgr pub;
+        jmp_buf jump;
+    };
+
+    jpeg_decompress_struct cinfo;
+    ErrorMgr err;
+    cinfo.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = [](j_common_ptr c) {
+        longjmp(reinterpret_cast<ErrorMgr*>(c->err)->jump, 1);
+    };
+    err.pub.emit_message = [](j_common_ptr c, int level) {
+        // Corrupt-data warnings count as failures
+        if (level < 0) longjmp(reinterpret_cast<ErrorMgr*>(c->err)->jump, 1);
+    };
+
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    cinfo.do_fancy_upsampling = FALSE;
+    cinfo.dct_method = JDCT_ISLOW;
+    jpeg_start_decompress(&cinfo);
+
+    out->width = static_cast<int>(cinfo.output_width);
+    out->height = static_cast<int>(cinfo.output_height);
+    out->components = cinfo.output_components;
+    out->pixels.resize(static_cast<size_t>(out->width) * out->height * out->components);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = &out->pixels[static_cast<size_t>(cinfo.output_scanline) * out->width * out->components];
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+} // namespace fixtures
+
+#endif // HAVE_LIBJPEG
@@ -0,0 +1,303 @@
+/**
+ * @file loopback_http.hpp
+ * @brief Stand-in HTTP collector on 127.0.0.1 and a keep-alive socket client
+ *
+ * The server handles one connection at a time (HTTP/1.1 keep-alive), records
+ * every POST body, and can be switched offline (connections are dropped
+ * without a response) or made to answer with a fixed status code.
+ */
+#pragma once
+
+#include "../../main/interfaces/i_http_client.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fixtures {
+
+struct HttpRequest {
+    std::string content_type;
+    std::vector<uint8_t> body;
+};
+
+// Read until "\r\n\r\n"; returns header text (without terminator) and any
+// bytes already read past it in extra
+inline bool read_http_head(int fd, std::string* head, std::string* extra) {
+    std::string buf;
+    char chunk[1024];
+    while (true) {
+        size_t end = buf.find("\r\n\r\n");
+        if (end != std::string::npos) {
+            *head = buf.substr(0, end);
+            *extra = buf.substr(end + 4);
+            return true;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buf.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+inline std::string http_header_value(const std::string& head, const char* name) {
+    std::string lower = head;
+    for (auto& c : lower) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    std::string key = std::string("\r\n") + name + ":";
+    for (auto& c : key) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    size_t pos = lower.find(key);
+    if (pos == std::string::npos) return {};
+    pos += key.size();
+    size_t end = head.find("\r\n", pos);
+    std::string value = head.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    while (!value.empty() && value[0] == ' ') value.erase(0, 1);
+    return value;
+}
+
+inline bool read_http_body(int fd, std::string extra, size_t length, std::vector<uint8_t>* body) {
+    body->assign(extra.begin(), extra.end());
+    char chunk[4096];
+    while (body->size() < length) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        body->insert(body->end(), chunk, chunk + n);
+    }
+    body->resize(length);
+    return true;
+}
+
+inline bool send_all(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+class LoopbackHttpServer {
+public:
+    ~LoopbackHttpServer() { stop(); }
+
+    bool start() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) return false;
+        int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listen_fd_, 4) < 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        stop_ = false;
+        thread_ = std::thread(&LoopbackHttpServer::serve, this);
+        return true;
+    }
+
+    void stop() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+        if (listen_fd_ >= 0) close(listen_fd_);
+        listen_fd_ = -1;
+    }
+
+    // Offline: drop connections without answering (client sees a transport error)
+    void set_offline(bool offline) { offline_ = offline; }
+    void set_status(int status) { status_ = status; }
+
+    uint16_t port() const { return port_; }
+    uint32_t connections() const { return connections_.load(); }
+
+    std::vector<HttpRequest> requests() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_;
+    }
+
+private:
+    // Poll until readable; gives up on stop (or on going offline, if asked)
+    bool wait_readable(int fd, bool while_online) {
+        while (!stop_) {
+            pollfd p{fd, POLLIN, 0};
+            int r = poll(&p, 1, 20);
+            if (r > 0) return true;
+            if (r < 0) return false;
+            if (while_online && offline_) return false;
+        }
+        return false;
+    }
+
+    void serve() {
+        while (!stop_) {
+            if (!wait_readable(listen_fd_, false)) continue;
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) continue;
+            if (offline_) {
+                close(fd);
+                continue;
+            }
+            connections_++;
+            handle(fd);
+            close(fd);
+        }
+    }
+
+    // Requests on one keep-alive connection until it closes or we go offline
+    void handle(int fd) {
+        while (!stop_ && !offline_ && wait_readable(fd, true)) {
+            std::string head, extra;
+            if (!read_http_head(fd, &head, &extra)) return;
+            size_t length = strtoul(http_header_value(head, "Content-Length").c_str(), nullptr, 10);
+            HttpRequest req;
+            req.content_type = http_header_value(head, "Content-Type");
+            if (!read_http_body(fd, extra, length, &req.body)) return;
+            if (offline_) return;   // Went down mid-request: no response
+
+            int status = status_.load();
+            if (status >= 200 && status < 300) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                requests_.push_back(std::move(req));
+            }
+            char resp[128];
+            int n = snprintf(resp, sizeof(resp),
+                "HTTP/1.1 %d X\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n", status);
+            if (!send_all(fd, resp, static_cast<size_t>(n))) return;
+        }
+    }
+
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> offline_{false};
+    std::atomic<int> status_{200};
+    std::atomic<uint32_t> connections_{0};
+    std::mutex mutex_;
+    std::vector<HttpRequest> requests_;
+};
+
+/**
+ * @brief IHttpClient over a plain keep-alive TCP connection to 127.0.0.1
+ */
+class SocketHttpClient : public interfaces::IHttpClient {
+public:
+    explicit SocketHttpClient(uint16_t port) : port_(port) {}
+    ~SocketHttpClient() override { disconnect(); }
+
+    int post(const char* content_type, const uint8_t* body, size_t size) override {
+        posts_++;
+        if (fd_ < 0 && !connect_now()) return -1;
+        char head[256];
+        int n = snprintf(head, sizeof(head),
+            "POST /ingest HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: %s\r\n"
+            "Content-Length: %zu\r\nConnection: keep-alive\r\n\r\n", content_type, size);
+        if (!send_all(fd_, head, static_cast<size_t>(n)) || !send_all(fd_, body, size)) {
+            disconnect();
+            return -1;
+        }
+        std::string resp, extra;
+        if (!read_http_head(fd_, &resp, &extra)) {
+            disconnect();
+            return -1;
+        }
+        int status = 0;
+        if (sscanf(resp.c_str(), "HTTP/1.1 %d", &status) != 1) {
+            disconnect();
+            return -1;
+        }
+        return status;
+    }
+
+    void disconnect() override {
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+    }
+
+    uint32_t posts() const { return posts_.load(); }
+    uint32_t connects() const { return connects_.load(); }
+
+private:
+    bool connect_now() {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) return false;
+        timeval tv{1, 0};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port_);
+        if (connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            disconnect();
+            return false;
+        }
+        connects_++;
+        return true;
+    }
+
+    uint16_t port_;
+    int fd_ = -1;
+    std::atomic<uint32_t> posts_{0};
+    std::atomic<uint32_t> connects_{0};
+};
+
+/**
+ * @brief One part of a multipart/mixed upload body
+ */
+struct UploadPart {
+    uint32_t sequence = 0;
+    int64_t timestamp_us = 0;
+    std::string camera_id;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Split an uploader body into parts (false if malformed)
+ */
+inline bool parse_upload_parts(const std::vector<uint8_t>& body, const std::string& boundary,
+                               std::vector<UploadPart>* parts) {
+    std::string text(body.begin(), body.end());
+    std::string delim = "--" + boundary;
+    size_t pos = 0;
+    while (true) {
+        if (text.compare(pos, delim.size(), delim) != 0) return false;
+        pos += delim.size();
+        if (text.compare(pos, 4, "--\r\n") == 0) return pos + 4 == text.size();
+        if (text.compare(pos, 2, "\r\n") != 0) return false;
+        size_t head_end = text.find("\r\n\r\n", pos);
+        if (head_end == std::string::npos) return false;
+        std::string head = "\r\n" + text.substr(pos, head_end - pos);   // Header lookup expects a leading CRLF
+        UploadPart part;
+        size_t length = strtoul(http_header_value(head, "Content-Length").c_str(), nullptr, 10);
+        part.sequence = static_cast<uint32_t>(
+            strtoul(http_header_value(head, "X-Frame-Sequence").c_str(), nullptr, 10));
+        part.timestamp_us = strtoll(http_header_value(head, "X-Frame-Timestamp").c_str(), nullptr, 10);
+        part.camera_id = http_header_value(head, "X-Camera-Id");
+        pos = head_end + 4;
+        if (pos + length + 2 > text.size()) return false;
+        part.data.assign(body.begin() + pos, body.begin() + pos + length);
+        pos += length;
+        if (text.compare(pos, 2, "\r\n") != 0) return false;
+        pos += 2;
+        parts->push_back(std::move(part));
+    }
+}
+
+} // namespace fixtures
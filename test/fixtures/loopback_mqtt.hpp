@@ -0,0 +1,387 @@
+/**
+ * @file loopback_mqtt.hpp
+ * @brief Stand-in MQTT 3.1.1 broker on 127.0.0.1 and a socket client
+ *
+ * The broker serves one client connection at a time and only does what the
+ * publisher needs: CONNECT/CONNACK, PUBLISH at QoS 0/1 (recorded, PUBACK
+ * sent or held back), PINGREQ and DISCONNECT. It can hold acknowledgements
+ * (slow broker), stop reading altogether (stalled broker) or drop the
+ * client.
+ */
+#pragma once
+
+#include "../../main/interfaces/i_mqtt_client.hpp"
+#include "loopback_http.hpp"   // send_all
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fixtures {
+
+struct MqttMessage {
+    std::string topic;
+    uint8_t qos = 0;
+    uint16_t packet_id = 0;
+    std::vector<uint8_t> payload;
+};
+
+inline bool recv_exact(int fd, uint8_t* out, size_t size) {
+    while (size > 0) {
+        ssize_t n = recv(fd, out, size, 0);
+        if (n <= 0) return false;
+        out += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// One control packet: first byte and body (variable header + payload)
+inline bool read_mqtt_packet(int fd, uint8_t* type, std::vector<uint8_t>* body) {
+    if (!recv_exact(fd, type, 1)) return false;
+    size_t length = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        uint8_t b;
+        if (!recv_exact(fd, &b, 1)) return false;
+        length |= static_cast<size_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    body->resize(length);
+    return length == 0 || recv_exact(fd, body->data(), length);
+}
+
+inline void append_remaining_length(std::vector<uint8_t>* out, size_t length) {
+    do {
+        uint8_t b = length & 0x7F;
+        length >>= 7;
+        if (length) b |= 0x80;
+        out->push_back(b);
+    } while (length);
+}
+
+class LoopbackMqttBroker {
+public:
+    ~LoopbackMqttBroker() { stop(); }
+
+    bool start() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) return false;
+        int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listen_fd_, 4) < 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        stop_ = false;
+        thread_ = std::thread(&LoopbackMqttBroker::serve, this);
+        return true;
+    }
+
+    void stop() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+        if (listen_fd_ >= 0) close(listen_fd_);
+        listen_fd_ = -1;
+    }
+
+    // Hold PUBACKs until release_acks() (a broker that is slow to confirm)
+    void set_hold_acks(bool hold) { hold_acks_ = hold; }
+
+    // Stop reading from the client (its send buffer fills and publish blocks)
+    void set_paused(bool paused) { paused_ = paused; }
+
+    void release_acks() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint16_t id : held_) send_puback(id);
+        held_.clear();
+    }
+
+    // Close the current client connection
+    void drop_client() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (client_fd_ >= 0) shutdown(client_fd_, SHUT_RDWR);
+    }
+
+    uint16_t port() const { return port_; }
+    uint32_t connections() const { return connections_.load(); }
+    size_t max_unacked() const { return max_unacked_.load(); }
+
+    size_t held_acks() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return held_.size();
+    }
+
+    std::vector<MqttMessage> messages() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return messages_;
+    }
+
+    std::vector<MqttMessage> messages(const std::string& topic) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<MqttMessage> out;
+        for (const auto& m : messages_) {
+            if (m.topic == topic) out.push_back(m);
+        }
+        return out;
+    }
+
+private:
+    // Poll until readable (and not paused); gives up on stop
+    bool wait_readable(int fd) {
+        while (!stop_) {
+            if (paused_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                continue;
+            }
+            pollfd p{fd, POLLIN, 0};
+            int r = poll(&p, 1, 20);
+            if (r > 0) return true;
+            if (r < 0) return false;
+        }
+        return false;
+    }
+
+    void serve() {
+        while (!stop_) {
+            if (!wait_readable(listen_fd_)) continue;
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) continue;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                client_fd_ = fd;
+                held_.clear();   // Session state is not kept across connections
+            }
+            connections_++;
+            handle(fd);
+            std::lock_guard<std::mutex> lock(mutex_);
+            client_fd_ = -1;
+            close(fd);
+        }
+    }
+
+    void handle(int fd) {
+        while (wait_readable(fd)) {
+            uint8_t type;
+            std::vector<uint8_t> body;
+            if (!read_mqtt_packet(fd, &type, &body)) return;
+
+            switch (type >> 4) {
+                case 1: {   // CONNECT
+                    const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    send_all(fd, connack, sizeof(connack));
+                    break;
+                }
+                case 3:     // PUBLISH
+                    if (!on_publish(type, body)) return;
+                    break;
+                case 12: {  // PINGREQ
+                    const uint8_t pingresp[] = {0xD0, 0x00};
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    send_all(fd, pingresp, sizeof(pingresp));
+                    break;
+                }
+                case 14:    // DISCONNECT
+                    return;
+                default:
+                    break;
+            }
+        }
+    }
+
+    bool on_publish(uint8_t type, const std::vector<uint8_t>& body) {
+        MqttMessage msg;
+        msg.qos = (type >> 1) & 0x03;
+        if (body.size() < 2) return false;
+        size_t topic_len = (static_cast<size_t>(body[0]) << 8) | body[1];
+        size_t pos = 2 + topic_len;
+        if (pos > body.size()) return false;
+        msg.topic.assign(body.begin() + 2, body.begin() + static_cast<long>(pos));
+        if (msg.qos > 0) {
+            if (pos + 2 > body.size()) return false;
+            msg.packet_id = static_cast<uint16_t>((body[pos] << 8) | body[pos + 1]);
+            pos += 2;
+        }
+        msg.payload.assign(body.begin() + static_cast<long>(pos), body.end());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint16_t id = msg.packet_id;
+        uint8_t qos = msg.qos;
+        messages_.push_back(std::move(msg));
+        if (qos == 0) return true;
+        if (hold_acks_) {
+            held_.push_back(id);
+            if (held_.size() > max_unacked_) max_unacked_ = held_.size();
+            return true;
+        }
+        if (max_unacked_ == 0) max_unacked_ = 1;
+        send_puback(id);
+        return true;
+    }
+
+    // Caller holds mutex_
+    void send_puback(uint16_t id) {
+        if (client_fd_ < 0) return;
+        const uint8_t puback[] = {0x40, 0x02, static_cast<uint8_t>(id >> 8),
+                                  static_cast<uint8_t>(id)};
+        send_all(client_fd_, puback, sizeof(puback));
+    }
+
+    int listen_fd_ = -1;
+    int client_fd_ = -1;
+    uint16_t port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> hold_acks_{false};
+    std::atomic<bool> paused_{false};
+    std::atomic<uint32_t> connections_{0};
+    std::atomic<size_t> max_unacked_{0};
+    std::mutex mutex_;
+    std::vector<uint16_t> held_;
+    std::vector<MqttMessage> messages_;
+};
+
+/**
+ * @brief IMqttClient over a plain TCP connection to 127.0.0.1
+ *
+ * connect() is explicit (tests decide when the link comes back); a reader
+ * thread delivers PUBACKs to the ack handler and notices disconnects.
+ */
+class SocketMqttClient : public interfaces::IMqttClient {
+public:
+    explicit SocketMqttClient(uint16_t port) : port_(port) {}
+    ~SocketMqttClient() override { disconnect(); }
+
+    bool connect() {
+        disconnect();
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        timeval tv{2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port_);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(fd);
+            return false;
+        }
+
+        // CONNECT: protocol "MQTT" level 4, clean session, keepalive 60 s
+        const char* client_id = "espcam-test";
+        std::vector<uint8_t> vh = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02, 0x00, 60};
+        vh.push_back(0);
+        vh.push_back(static_cast<uint8_t>(strlen(client_id)));
+        vh.insert(vh.end(), client_id, client_id + strlen(client_id));
+        std::vector<uint8_t> packet = {0x10};
+        append_remaining_length(&packet, vh.size());
+        packet.insert(packet.end(), vh.begin(), vh.end());
+
+        uint8_t type;
+        std::vector<uint8_t> body;
+        if (!send_all(fd, packet.data(), packet.size()) ||
+            !read_mqtt_packet(fd, &type, &body) || type != 0x20 ||
+            body.size() != 2 || body[1] != 0) {
+            close(fd);
+            return false;
+        }
+
+        timeval none{0, 0};   // Reader blocks until the connection closes
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &none, sizeof(none));
+        fd_ = fd;
+        connected_ = true;
+        reader_ = std::thread(&SocketMqttClient::read_loop, this);
+        return true;
+    }
+
+    void disconnect() {
+        if (fd_ >= 0) shutdown(fd_, SHUT_RDWR);
+        if (reader_.joinable()) reader_.join();
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+        connected_ = false;
+    }
+
+    bool connected() const override { return connected_.load(); }
+
+    int publish(const char* topic, const uint8_t* payload, size_t size,
+                uint8_t qos, bool retain) override {
+        if (!connected_.load()) return -1;
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        int id = 0;
+        size_t topic_len = strlen(topic);
+        std::vector<uint8_t> packet;
+        packet.reserve(size + topic_len + 8);
+        packet.push_back(static_cast<uint8_t>(0x30 | (qos << 1) | (retain ? 1 : 0)));
+        append_remaining_length(&packet, 2 + topic_len + (qos ? 2 : 0) + size);
+        packet.push_back(static_cast<uint8_t>(topic_len >> 8));
+        packet.push_back(static_cast<uint8_t>(topic_len));
+        packet.insert(packet.end(), topic, topic + topic_len);
+        if (qos) {
+            if (++next_id_ == 0) next_id_ = 1;
+            id = next_id_;
+            packet.push_back(static_cast<uint8_t>(id >> 8));
+            packet.push_back(static_cast<uint8_t>(id));
+        }
+        packet.insert(packet.end(), payload, payload + size);
+        if (!send_all(fd_, packet.data(), packet.size())) {
+            connected_ = false;
+            return -1;
+        }
+        publishes_++;
+        return id;
+    }
+
+    void set_ack_handler(AckHandler handler, void* ctx) override {
+        std::lock_guard<std::mutex> lock(handler_mutex_);
+        handler_ = handler;
+        handler_ctx_ = ctx;
+    }
+
+    uint32_t publishes() const { return publishes_.load(); }
+
+private:
+    void read_loop() {
+        while (true) {
+            uint8_t type;
+            std::vector<uint8_t> body;
+            if (!read_mqtt_packet(fd_, &type, &body)) break;
+            if ((type >> 4) == 4 && body.size() == 2) {   // PUBACK
+                int id = (body[0] << 8) | body[1];
+                std::lock_guard<std::mutex> lock(handler_mutex_);
+                if (handler_) handler_(handler_ctx_, id);
+            }
+        }
+        connected_ = false;
+    }
+
+    uint16_t port_;
+    int fd_ = -1;
+    uint16_t next_id_ = 0;
+    std::atomic<bool> connected_{false};
+    std::atomic<uint32_t> publishes_{0};
+    std::thread reader_;
+    std::mutex send_mutex_;
+    std::mutex handler_mutex_;
+    AckHandler handler_ = nullptr;
+    void* handler_ctx_ = nullptr;
+};
+
+} // namespace fixtures
@@ -0,0 +1,108 @@
+/**
+ * @file synthetic_jpeg.hpp
+ * @brief Deterministic baseline JPEG generator for tests and benchmarks
+ *
+ * Produces real, decodable JPEGs directly from quantized coefficients using
+ * the production entropy coder, so tests need no image files on disk.
+ */
+#pragma once
+
+#include "../../main/core/jpeg_codec.hpp"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace fixtures {
+
+struct SyntheticJpegSpec {
+    uint16_t width = 640;
+    uint16_t height = 480;
+    uint8_t components = 3;         // 1 = grayscale, 3 = YCbCr
+    uint8_t luma_h = 2;             // OV2640 emits 4:2:2 (2x1)
+    uint8_t luma_v = 1;
+    uint16_t restart_interval = 0;
+    uint32_t seed = 1;
+    uint8_t ac_terms = 6;           // Non-zero AC coefficients per luma block
+};
+
+// Fills blocks_per_mcu blocks (zigzag order) for the given MCU index
+using BlockGenerator = std::function<void(const core::JpegInfo&, uint32_t mcu, int16_t (*blocks)[64])>;
+
+inline core::JpegInfo make_synthetic_info(const SyntheticJpegSpec& spec) {
+    core::JpegInfo info;
+    info.width = spec.width;
+    info.height = spec.height;
+    info.num_components = spec.components;
+    for (uint8_t c = 0; c < spec.components; c++) {
+        info.components[c].id = static_cast<uint8_t>(c + 1);
+        info.components[c].h = c == 0 ? spec.luma_h : 1;
+        info.components[c].v = c == 0 ? spec.luma_v : 1;
+        info.components[c].tq = c == 0 ? 0 : 1;
+    }
+    for (int k = 0; k < 64; k++) {
+        info.quant[0][k] = static_cast<uint16_t>(4 + k / 4);
+        info.quant[1][k] = static_cast<uint16_t>(6 + k / 3);
+    }
+    info.quant_present[0] = true;
+    info.quant_present[1] = spec.components > 1;
+    info.restart_interval = spec.restart_interval;
+    core::jpeg_compute_layout(info);
+    return info;
+}
+
+/**
+ * @brief Pseudo-random but smooth content: DC gradient plus a few AC terms
+ */
+inline BlockGenerator default_generator(const SyntheticJpegSpec& spec) {
+    return [spec](const core::JpegInfo& info, uint32_t mcu, int16_t (*blocks)[64]) {
+        uint32_t state = spec.seed * 2654435761u + mcu * 40503u + 1;
+        auto rnd = [&state]() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        };
+        uint32_t mx = mcu % info.mcus_x;
+        uint32_t my = mcu / info.mcus_x;
+        for (uint8_t b = 0; b < info.blocks_per_mcu; b++) {
+            int16_t* blk = blocks[b];
+            for (int k = 0; k < 64; k++) blk[k] = 0;
+            if (info.block_component[b] == 0) {
+                blk[0] = static_cast<int16_t>(static_cast<int>((mx * 7 + my * 5 + b * 3) % 120) - 60);
+                for (uint8_t t = 0; t < spec.ac_terms; t++) {
+                    int k = 1 + static_cast<int>(rnd() % 40);
+                    blk[k] = static_cast<int16_t>(static_cast<int>(rnd() % 31) - 15);
+                }
+            } else {
+                blk[0] = static_cast<int16_t>(static_cast<int>((mx + my) % 20) - 10);
+                blk[1] = static_cast<int16_t>(static_cast<int>(rnd() % 5) - 2);
+            }
+        }
+    };
+}
+
+/**
+ * @brief Encode a JPEG from generated coefficient blocks
+ */
+inline std::vector<uint8_t> encode_blocks(const core::JpegInfo& info, const BlockGenerator& gen) {
+    std::vector<uint8_t> out(static_cast<size_t>(info.width) * info.height * 3 + 4096);
+    core::JpegByteWriter w(out.data(), out.size());
+    core::jpeg_write_headers(w, info);
+    core::JpegScanEncoder enc;
+    enc.begin(w, info);
+    int16_t blocks[core::JPEG_MAX_BLOCKS_PER_MCU][64];
+    for (uint32_t m = 0; m < info.total_mcus(); m++) {
+        gen(info, m, blocks);
+        enc.encode_mcu(blocks);
+    }
+    enc.finish();
+    w.marker(core::jpeg_marker::EOI);
+    out.resize(w.size());
+    return out;
+}
+
+inline std::vector<uint8_t> make_synthetic_jpeg(const SyntheticJpegSpec& spec = {}) {
+    return encode_blocks(make_synthetic_info(spec), default_generator(spec));
+}
+
+} // namespace fixtures
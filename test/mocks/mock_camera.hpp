@@ -5,12 +5,30 @@
 #pragma once
 
 #include "../../main/interfaces/i_camera.hpp"
+#include "../../main/core/jpeg_encoder.hpp"
 #include <vector>
 #include <cstring>
+#include <cmath>
 #include <functional>
 
 namespace mocks {
 
+/**
+ * @brief Synthetic scene rendered through the mock's exposure settings
+ *
+ * A fixed grayscale pattern (reflectance 0.02-0.35, mean about 0.19) lit by
+ * a light that may flicker. Pixel = 255 x signal^(1/2.2), clipped, with
+ * signal = reflectance x luminance x light x exposure / 10 ms x gain: a
+ * luminance of 1 at 10 ms and 1x gives a mean luma around 110.
+ */
+struct MockScene {
+    float luminance = 1.0f;
+    float flicker_depth = 0.0f;   // Light = 1 + depth x cos(2 pi f t)
+    uint16_t flicker_hz = 100;    // Twice the mains frequency
+    uint16_t width = 160;
+    uint16_t height = 120;
+};
+
 /**
  * @brief Configurable mock camera for testing
  * 
@@ -18,6 +36,11 @@ namespace mocks {
  * - Configurable capture success/failure
  * - Configurable frame data
  * - Capture delay simulation
+ * - Sensor profiles (frame timestamps spaced by the profile's frame time)
+ * - Failure injection: a number of failed captures, or a sensor wedged
+ *   until reset_sensor() or until deinit()/init()
+ * - Exposure control, applied exposure_latency frames after set_exposure()
+ * - Synthetic scene: real JPEG frames that respond to exposure and gain
  * - Call tracking
  */
 class MockCamera : public interfaces::ICamera {
@@ -41,13 +64,17 @@ public:
         if (!should_init_succeed_) return false;
         
         config_ = config;
+        config_.profile = nullptr;
         initialized_ = true;
+        if (config.profile) set_profile(*config.profile);
         return true;
     }
     
     void deinit() override {
         deinit_calls_++;
         initialized_ = false;
+        if (wedge_ == Wedge::UntilReinit) wedge_ = Wedge::None;
+        has_profile_ = false;
         if (current_frame_held_) {
             current_frame_held_ = false;
         }
@@ -60,7 +87,11 @@ public:
     interfaces::FrameView capture_frame() override {
         capture_calls_++;
         
-        if (!initialized_ || !should_capture_succeed_) {
+        if (!initialized_ || !should_capture_succeed_ || wedge_ != Wedge::None) {
+            return {};
+        }
+        if (failures_left_ > 0) {
+            failures_left_--;
             return {};
         }
         
@@ -72,7 +103,23 @@ public:
         current_frame_held_ = true;
         frame_counter_++;
         
+        // ~30ms per frame, or the active profile's frame time
+        int64_t frame_us = has_profile_ && profile_.max_fps ? 1000000 / profile_.max_fps : 33333;
+        int64_t exposure_start_us = timestamp_us_;
+        timestamp_us_ += frame_us;
+        apply_due_exposure();
+        
         interfaces::FrameView view;
+        if (has_scene_) {
+            render_scene(exposure_start_us);
+            view.data = scene_frame_.data();
+            view.size = scene_frame_.size();
+            view.width = scene_.width;
+            view.height = scene_.height;
+            view.timestamp_us = timestamp_us_;
+            view.format = interfaces::PixelFormat::Jpeg;
+            return view;
+        }
         if (custom_frame_data_.empty()) {
             view.data = default_frame_.data();
             view.size = default_frame_.size();
@@ -82,7 +129,8 @@ public:
         }
         view.width = get_width_for_resolution(config_.resolution);
         view.height = get_height_for_resolution(config_.resolution);
-        view.timestamp_us = frame_counter_ * 33333;  // ~30ms per frame
+        view.timestamp_us = timestamp_us_;
+        view.format = config_.pixel_format;
         
         return view;
     }
@@ -92,9 +140,17 @@ public:
         current_frame_held_ = false;
     }
     
+    bool reset_sensor() override {
+        reset_sensor_calls_++;
+        if (!initialized_ || !should_reset_succeed_) return false;
+        if (wedge_ == Wedge::UntilReset) wedge_ = Wedge::None;
+        return true;
+    }
+    
     bool set_resolution(interfaces::Resolution res) override {
         if (!initialized_ || !should_set_resolution_succeed_) return false;
         config_.resolution = res;
+        has_profile_ = false;
         return true;
     }
     
@@ -113,6 +169,49 @@ public:
         return config_.jpeg_quality; 
     }
     
+    bool set_profile(const interfaces::SensorProfile& profile) override {
+        set_profile_calls_++;
+        if (!initialized_ || !should_set_profile_succeed_) return false;
+        profile_ = profile;
+        has_profile_ = true;
+        config_.resolution = profile.resolution;
+        return true;
+    }
+    
+    const interfaces::SensorProfile* get_profile() const override {
+        return has_profile_ ? &profile_ : nullptr;
+    }
+    
+    bool set_exposure(const interfaces::ExposureSettings& settings) override {
+        set_exposure_calls_++;
+        if (!initialized_) return false;
+        interfaces::ExposureSettings s = settings;
+        if (s.auto_exposure) {
+            // The mock's "AEC" just holds the current exposure
+            s.exposure_us = requested_.exposure_us;
+            s.gain_x16 = requested_.gain_x16;
+        } else {
+            auto limits = get_exposure_limits();
+            if (s.exposure_us < limits.min_exposure_us || s.exposure_us > limits.max_exposure_us) return false;
+            if (s.gain_x16 < limits.min_gain_x16 || s.gain_x16 > limits.max_gain_x16) return false;
+        }
+        requested_ = s;
+        pending_exposure_.push_back({frame_counter_ + exposure_latency_, s});
+        apply_due_exposure();
+        return true;
+    }
+    
+    interfaces::ExposureSettings get_exposure() const override { return requested_; }
+    
+    interfaces::ExposureLimits get_exposure_limits() const override {
+        interfaces::ExposureLimits limits;
+        limits.min_exposure_us = 100;
+        limits.max_exposure_us = has_profile_ && profile_.max_fps ? 1000000 / profile_.max_fps : 33333;
+        limits.min_gain_x16 = 16;
+        limits.max_gain_x16 = 256;
+        return limits;
+    }
+    
     // -------------------------------------------------------------------------
     // Test configuration
     // -------------------------------------------------------------------------
@@ -121,6 +220,16 @@ public:
     void set_capture_result(bool success) { should_capture_succeed_ = success; }
     void set_resolution_result(bool success) { should_set_resolution_succeed_ = success; }
     void set_quality_result(bool success) { should_set_quality_succeed_ = success; }
+    void set_profile_result(bool success) { should_set_profile_succeed_ = success; }
+    void set_reset_result(bool success) { should_reset_succeed_ = success; }
+    
+    // Fail the next n captures, then recover on its own
+    void fail_captures(uint32_t n) { failures_left_ = n; }
+    
+    // Fail every capture until reset_sensor() (UntilReset) or deinit() (UntilReinit)
+    enum class Wedge : uint8_t { None, UntilReset, UntilReinit };
+    void wedge(Wedge mode) { wedge_ = mode; }
+    bool is_wedged() const { return wedge_ != Wedge::None; }
     
     void set_custom_frame(const std::vector<uint8_t>& data) {
         custom_frame_data_ = data;
@@ -134,6 +243,20 @@ public:
         custom_frame_data_.clear();
     }
     
+    // Frames from here on are rendered from the scene (see MockScene)
+    void set_scene(const MockScene& scene) {
+        scene_ = scene;
+        has_scene_ = true;
+    }
+    
+    void clear_scene() { has_scene_ = false; }
+    
+    // Frames captured before a set_exposure() takes effect (0 = next frame)
+    void set_exposure_latency(uint32_t frames) { exposure_latency_ = frames; }
+    
+    // Settings the last captured frame was exposed with
+    const interfaces::ExposureSettings& applied_exposure() const { return applied_; }
+    
     // Set callback for simulating capture delay
     void set_capture_delay_callback(std::function<void()> cb) {
         capture_delay_callback_ = cb;
@@ -147,15 +270,60 @@ public:
     uint32_t deinit_calls() const { return deinit_calls_; }
     uint32_t capture_calls() const { return capture_calls_; }
     uint32_t release_calls() const { return release_calls_; }
+    uint32_t set_profile_calls() const { return set_profile_calls_; }
+    uint32_t set_exposure_calls() const { return set_exposure_calls_; }
+    uint32_t reset_sensor_calls() const { return reset_sensor_calls_; }
     uint32_t frame_counter() const { return frame_counter_; }
     bool is_frame_held() const { return current_frame_held_; }
     
     void reset_counters() {
-        init_calls_ = deinit_calls_ = capture_calls_ = release_calls_ = 0;
+        init_calls_ = deinit_calls_ = capture_calls_ = release_calls_ = set_profile_calls_ = 0;
+        set_exposure_calls_ = reset_sensor_calls_ = 0;
         frame_counter_ = 0;
+        timestamp_us_ = 0;
     }
 
 private:
+    void apply_due_exposure() {
+        size_t kept = 0;
+        for (const auto& p : pending_exposure_) {
+            if (p.first <= frame_counter_) applied_ = p.second;
+            else pending_exposure_[kept++] = p;
+        }
+        pending_exposure_.resize(kept);
+    }
+    
+    // Light averaged over the exposure window starting at start_us
+    float light_level(int64_t start_us) const {
+        if (scene_.flicker_depth <= 0.0f || scene_.flicker_hz == 0) return 1.0f;
+        const double w = 2.0 * 3.14159265358979 * scene_.flicker_hz;
+        double t0 = start_us * 1e-6;
+        double e = applied_.exposure_us * 1e-6;
+        double avg = (std::sin(w * (t0 + e)) - std::sin(w * t0)) / (w * e);
+        return static_cast<float>(1.0 + scene_.flicker_depth * avg);
+    }
+    
+    void render_scene(int64_t start_us) {
+        size_t n = static_cast<size_t>(scene_.width) * scene_.height;
+        scene_pixels_.resize(n);
+        float signal = scene_.luminance * light_level(start_us) *
+                       (applied_.exposure_us / 10000.0f) * (applied_.gain_x16 / 16.0f);
+        for (uint32_t y = 0; y < scene_.height; y++) {
+            for (uint32_t x = 0; x < scene_.width; x++) {
+                // Blocky pattern plus a gradient: a spread histogram with texture
+                uint32_t cell = ((x / 8) * 7 + (y / 8) * 13) % 11;
+                float reflectance = 0.02f + 0.025f * cell + 0.08f * x / scene_.width;
+                float v = 255.0f * std::pow(std::fmin(reflectance * signal, 1.0f), 1.0f / 2.2f);
+                scene_pixels_[y * scene_.width + x] = static_cast<uint8_t>(v + 0.5f);
+            }
+        }
+        scene_frame_.resize(n + 4096);
+        size_t size = encoder_.encode(scene_pixels_.data(), n, scene_.width, scene_.height,
+                                      interfaces::PixelFormat::Grayscale,
+                                      scene_frame_.data(), scene_frame_.size());
+        scene_frame_.resize(size);
+    }
+    
     static uint32_t get_width_for_resolution(interfaces::Resolution res) {
         switch (res) {
             case interfaces::Resolution::QQVGA: return 160;
@@ -185,6 +353,8 @@ private:
     }
     
     interfaces::CameraConfig config_;
+    interfaces::SensorProfile profile_;
+    bool has_profile_ = false;
     bool initialized_ = false;
     bool current_frame_held_ = false;
     
@@ -193,11 +363,26 @@ private:
     bool should_capture_succeed_ = true;
     bool should_set_resolution_succeed_ = true;
     bool should_set_quality_succeed_ = true;
+    bool should_set_profile_succeed_ = true;
+    bool should_reset_succeed_ = true;
+    uint32_t failures_left_ = 0;
+    Wedge wedge_ = Wedge::None;
     
     // Frame data
     std::vector<uint8_t> default_frame_;
     std::vector<uint8_t> custom_frame_data_;
     
+    // Exposure and scene model
+    interfaces::ExposureSettings requested_{true, 10000, 16, interfaces::AntiFlicker::Off};
+    interfaces::ExposureSettings applied_{true, 10000, 16, interfaces::AntiFlicker::Off};
+    std::vector<std::pair<uint32_t, interfaces::ExposureSettings>> pending_exposure_;
+    uint32_t exposure_latency_ = 2;
+    MockScene scene_;
+    bool has_scene_ = false;
+    core::JpegEncoder encoder_;
+    std::vector<uint8_t> scene_pixels_;
+    std::vector<uint8_t> scene_frame_;
+    
     // Callback for simulating delays
     std::function<void()> capture_delay_callback_;
     
@@ -207,6 +392,10 @@ private:
     uint32_t capture_calls_ = 0;
     uint32_t release_calls_ = 0;
     uint32_t frame_counter_ = 0;
+    uint32_t set_profile_calls_ = 0;
+    uint32_t set_exposure_calls_ = 0;
+    uint32_t reset_sensor_calls_ = 0;
+    int64_t timestamp_us_ = 0;
 };
 
 } // namespace mocks
@@ -0,0 +1,564 @@
+/**
+ * @file test_archive_writer.cpp
+ * @brief Unit tests for the streaming ZIP/TAR writer and clip export
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/archive_writer.hpp"
+#include "../main/core/recording_catalog.hpp"
+#include "fixtures/archive_tools.hpp"
+#include "fixtures/file_flash.hpp"
+#include "fixtures/loopback_http.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace fixtures;
+
+namespace {
+
+struct Collector {
+    std::vector<uint8_t> bytes;
+    size_t calls = 0;
+    std::vector<const uint8_t*> pointers;   // Every buffer handed to the sink
+    size_t fail_after = SIZE_MAX;           // Calls before the sink starts refusing
+
+    static bool sink(void* context, const uint8_t* data, size_t size) {
+        auto* self = static_cast<Collector*>(context);
+        if (self->calls++ >= self->fail_after) return false;
+        self->pointers.push_back(data);
+        self->bytes.insert(self->bytes.end(), data, data + size);
+        return true;
+    }
+};
+
+std::vector<uint8_t> make_payload(size_t size, uint32_t seed) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = static_cast<uint8_t>(seed >> 16);
+    }
+    return data;
+}
+
+uint16_t get16(const std::vector<uint8_t>& b, size_t at) {
+    return static_cast<uint16_t>(b[at] | b[at + 1] << 8);
+}
+
+uint32_t get32(const std::vector<uint8_t>& b, size_t at) {
+    return get16(b, at) | static_cast<uint32_t>(get16(b, at + 2)) << 16;
+}
+
+struct ParsedEntry {
+    std::string name;
+    uint32_t crc = 0;
+    uint32_t size = 0;
+    uint32_t offset = 0;
+    std::vector<uint8_t> data;
+};
+
+// Minimal reader: EOCD → central directory → local headers + descriptors
+bool parse_zip(const std::vector<uint8_t>& zip, std::vector<ParsedEntry>* entries,
+               std::string* comment) {
+    if (zip.size() < 22) return false;
+    size_t eocd = zip.size() - 22;
+    while (get32(zip, eocd) != 0x06054b50) {
+        if (eocd == 0) return false;
+        eocd--;
+    }
+    uint16_t count = get16(zip, eocd + 10);
+    uint32_t dir_size = get32(zip, eocd + 12);
+    uint32_t dir_offset = get32(zip, eocd + 16);
+    uint16_t comment_len = get16(zip, eocd + 20);
+    if (dir_offset + dir_size != eocd || eocd + 22 + comment_len != zip.size()) return false;
+    comment->assign(zip.begin() + eocd + 22, zip.end());
+
+    size_t at = dir_offset;
+    entries->clear();
+    for (uint16_t i = 0; i < count; i++) {
+        if (get32(zip, at) != 0x02014b50) return false;
+        ParsedEntry e;
+        e.crc = get32(zip, at + 16);
+        e.size = get32(zip, at + 24);
+        uint16_t name_len = get16(zip, at + 28);
+        e.offset = get32(zip, at + 42);
+        e.name.assign(zip.begin() + at + 46, zip.begin() + at + 46 + name_len);
+        if (get16(zip, at + 10) != 0 || get32(zip, at + 20) != e.size) return false;
+        at += 46 + name_len;
+
+        size_t local = e.offset;
+        if (get32(zip, local) != 0x04034b50 || get16(zip, local + 6) != 0x0008) return false;
+        if (get16(zip, local + 26) != name_len) return false;
+        size_t data = local + 30 + name_len;
+        e.data.assign(zip.begin() + data, zip.begin() + data + e.size);
+        size_t descriptor = data + e.size;
+        if (get32(zip, descriptor) != 0x08074b50 || get32(zip, descriptor + 4) != e.crc ||
+            get32(zip, descriptor + 8) != e.size || get32(zip, descriptor + 12) != e.size) return false;
+        entries->push_back(std::move(e));
+    }
+    return at == eocd;
+}
+
+// Frames appended to a flash-backed store, described as one clip
+struct ClipRig {
+    static constexpr size_t SEGMENT = 64 * 1024;
+    FileFlash flash;
+    SegmentStore store;
+    std::vector<std::vector<uint8_t>> frames;
+    ClipSummary clip;
+
+    ClipRig(size_t count, size_t frame_size, size_t flash_size = 4 * 1024 * 1024)
+        : flash(flash_size), store(flash) {
+        store.mount({.segment_size = SEGMENT, .spare_segments = 1});
+        int64_t t0 = 1700000000LL * 1000000;
+        for (size_t i = 0; i < count; i++) {
+            frames.push_back(make_payload(frame_size + i % 7, static_cast<uint32_t>(i)));
+            uint32_t seq = store.append(frames.back().data(), frames.back().size(),
+                                        t0 + static_cast<int64_t>(i) * 500000);
+            while (store.service()) {}
+            if (i == 0) clip.first_sequence = seq;
+            clip.last_sequence = seq;
+        }
+        clip.id = 1;
+        clip.start_us = t0;
+        clip.end_us = t0 + static_cast<int64_t>(count - 1) * 500000;
+        clip.frames = static_cast<uint32_t>(count);
+    }
+};
+
+} // namespace
+
+//=============================================================================
+// ZIP Tests
+//=============================================================================
+
+TEST_CASE("DOS timestamps", "[archive][zip]") {
+    // 2024-02-29 13:45:58 UTC
+    uint32_t dt = zip_dos_datetime(1709214358);
+    REQUIRE((dt >> 25) == 2024 - 1980);
+    REQUIRE(((dt >> 21) & 0xF) == 2);
+    REQUIRE(((dt >> 16) & 0x1F) == 29);
+    REQUIRE(((dt >> 11) & 0x1F) == 13);
+    REQUIRE(((dt >> 5) & 0x3F) == 45);
+    REQUIRE((dt & 0x1F) == 29);   // Two-second units
+
+    // Before 1980 clamps to the DOS epoch (1980-01-01 00:00)
+    REQUIRE(zip_dos_datetime(0) == ((1u << 5 | 1u) << 16));
+}
+
+TEST_CASE("ArchiveWriter ZIP layout", "[archive][zip]") {
+    ArchiveWriter zip;
+    REQUIRE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 16}));
+    Collector out;
+    std::vector<std::vector<uint8_t>> payloads = {
+        make_payload(1000, 1), make_payload(0, 2), make_payload(70000, 3)};
+
+    REQUIRE(zip.begin(&Collector::sink, &out, "clip_7/", ".jpg"));
+    for (size_t i = 0; i < payloads.size(); i++) {
+        REQUIRE(zip.add_entry(static_cast<uint32_t>(i + 1), 1709214358, payloads[i].size()));
+        // Two writes per entry: the CRC continues across them
+        size_t half = payloads[i].size() / 2;
+        REQUIRE(zip.write(payloads[i].data(), half));
+        REQUIRE(zip.write(payloads[i].data() + half, payloads[i].size() - half));
+        REQUIRE(zip.end_entry());
+    }
+    REQUIRE(zip.finish("{\"frames\":3}"));
+    REQUIRE(zip.entries() == 3);
+    REQUIRE(zip.bytes_written() == out.bytes.size());
+
+    std::vector<ParsedEntry> entries;
+    std::string comment;
+    REQUIRE(parse_zip(out.bytes, &entries, &comment));
+    REQUIRE(comment == "{\"frames\":3}");
+    REQUIRE(entries.size() == 3);
+    for (size_t i = 0; i < entries.size(); i++) {
+        REQUIRE(entries[i].name == "clip_7/00000" + std::to_string(i + 1) + ".jpg");
+        REQUIRE(entries[i].data == payloads[i]);
+        REQUIRE(entries[i].crc == crc32(payloads[i].data(), payloads[i].size()));
+    }
+
+    SECTION("entry data reaches the sink without being copied") {
+        bool seen = false;
+        for (const uint8_t* p : out.pointers) seen |= p == payloads[2].data();
+        REQUIRE(seen);
+    }
+
+    SECTION("headers between entries go out in few sink calls") {
+        // Per entry: header + two data writes; the directory and end
+        // record share one more call
+        REQUIRE(out.calls <= 3 * 3 + 2);
+    }
+
+    SECTION("the writer can be reused") {
+        Collector again;
+        REQUIRE(zip.begin(&Collector::sink, &again));
+        REQUIRE(zip.add_entry(42, 0, 3));
+        REQUIRE(zip.write(payloads[0].data(), 3));
+        REQUIRE(zip.end_entry());
+        REQUIRE(zip.finish());
+        REQUIRE(parse_zip(again.bytes, &entries, &comment));
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].name == "000042");
+    }
+}
+
+TEST_CASE("ArchiveWriter rejects misuse", "[archive][errors]") {
+    ArchiveWriter zip;
+    Collector out;
+    auto payload = make_payload(100, 9);
+
+    SECTION("begin requires init and short names") {
+        REQUIRE_FALSE(zip.begin(&Collector::sink, &out));
+        REQUIRE_FALSE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 0}));
+        REQUIRE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 2}));
+        std::string long_prefix(ARCHIVE_MAX_PREFIX + 1, 'x');
+        REQUIRE_FALSE(zip.begin(&Collector::sink, &out, long_prefix.c_str()));
+        REQUIRE_FALSE(zip.begin(nullptr, &out));
+        REQUIRE(zip.begin(&Collector::sink, &out));
+    }
+
+    SECTION("writing more or less than declared breaks the archive") {
+        REQUIRE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 2}));
+        REQUIRE(zip.begin(&Collector::sink, &out));
+        REQUIRE(zip.add_entry(1, 0, 50));
+        REQUIRE_FALSE(zip.write(payload.data(), 100));
+        REQUIRE(zip.failed());
+        REQUIRE_FALSE(zip.finish());
+
+        REQUIRE(zip.begin(&Collector::sink, &out));
+        REQUIRE(zip.add_entry(1, 0, 100));
+        REQUIRE(zip.write(payload.data(), 60));
+        REQUIRE_FALSE(zip.end_entry());
+        REQUIRE(zip.failed());
+    }
+
+    SECTION("calls out of order break the archive") {
+        REQUIRE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 2}));
+        REQUIRE(zip.begin(&Collector::sink, &out));
+        REQUIRE_FALSE(zip.write(payload.data(), 10));   // No entry open
+        REQUIRE(zip.failed());
+    }
+
+    SECTION("the entry table bounds the archive") {
+        REQUIRE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 2}));
+        REQUIRE(zip.begin(&Collector::sink, &out));
+        for (uint32_t i = 0; i < 2; i++) {
+            REQUIRE(zip.add_entry(i, 0, 10));
+            REQUIRE(zip.write(payload.data(), 10));
+            REQUIRE(zip.end_entry());
+        }
+        REQUIRE_FALSE(zip.add_entry(2, 0, 10));
+    }
+
+    SECTION("a refusing sink aborts") {
+        REQUIRE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 2}));
+        out.fail_after = 2;
+        REQUIRE(zip.begin(&Collector::sink, &out));
+        REQUIRE(zip.add_entry(1, 0, 100));
+        REQUIRE(zip.write(payload.data(), 100));    // Header, then the data
+        REQUIRE(zip.end_entry());
+        REQUIRE_FALSE(zip.finish());
+        REQUIRE(zip.failed());
+    }
+}
+
+//=============================================================================
+// TAR Tests
+//=============================================================================
+
+TEST_CASE("ArchiveWriter TAR layout", "[archive][tar]") {
+    ArchiveWriter tar;
+    REQUIRE(tar.init({.format = ArchiveFormat::Tar}));
+    Collector out;
+    auto a = make_payload(512, 4);
+    auto b = make_payload(1300, 5);
+
+    REQUIRE(tar.begin(&Collector::sink, &out, "burst/", ".jpg"));
+    REQUIRE(tar.add_entry(1, 1709214358, a.size()));
+    REQUIRE(tar.write(a.data(), a.size()));
+    REQUIRE(tar.end_entry());
+    REQUIRE(tar.add_entry(2, 1709214358, b.size()));
+    REQUIRE(tar.write(b.data(), b.size()));
+    REQUIRE(tar.end_entry());
+    REQUIRE(tar.finish());
+
+    // Header + 1 block, header + 3 blocks, 2 end blocks
+    REQUIRE(out.bytes.size() == 512 * (2 + 4 + 2));
+    REQUIRE(tar.bytes_written() == out.bytes.size());
+
+    const uint8_t* h = out.bytes.data() + 1024;
+    REQUIRE(std::string(reinterpret_cast<const char*>(h)) == "burst/000002.jpg");
+    REQUIRE(std::string(reinterpret_cast<const char*>(h + 124)) == "00000002424");   // 1300 octal
+    REQUIRE(memcmp(h + 257, "ustar", 6) == 0);
+    uint32_t sum = 0;
+    for (size_t i = 0; i < 512; i++) sum += (i >= 148 && i < 156) ? ' ' : h[i];
+    REQUIRE(strtoul(reinterpret_cast<const char*>(h + 148), nullptr, 8) == sum);
+    REQUIRE(memcmp(h + 512, b.data(), b.size()) == 0);
+    for (size_t i = out.bytes.size() - 1024; i < out.bytes.size(); i++) REQUIRE(out.bytes[i] == 0);
+}
+
+//=============================================================================
+// Standard Reader Tests
+//=============================================================================
+
+TEST_CASE("Archives open in standard readers", "[archive][readers]") {
+    std::vector<std::vector<uint8_t>> payloads;
+    for (uint32_t i = 0; i < 12; i++) payloads.push_back(make_payload(3000 + i * 517, i));
+
+    auto build = [&](ArchiveFormat format, const char* comment) {
+        ArchiveWriter writer;
+        Collector out;
+        REQUIRE(writer.init({.format = format}));
+        REQUIRE(writer.begin(&Collector::sink, &out, "clip_3/", ".jpg"));
+        for (uint32_t i = 0; i < payloads.size(); i++) {
+            REQUIRE(writer.add_entry(i + 1, 1700000000 + i, payloads[i].size()));
+            REQUIRE(writer.write(payloads[i].data(), payloads[i].size()));
+            REQUIRE(writer.end_entry());
+        }
+        REQUIRE(writer.finish(comment));
+        return out.bytes;
+    };
+
+    SECTION("unzip verifies every CRC and extracts the frames byte-exact") {
+#ifdef HAVE_UNZIP
+        TempArchive zip(build(ArchiveFormat::Zip, "burst report"), ".zip");
+        REQUIRE(zip.valid());
+        std::vector<uint8_t> output;
+        REQUIRE(run_tool(std::string(UNZIP_EXECUTABLE) + " -tq " + zip.path(), &output) == 0);
+        REQUIRE(run_tool(std::string(UNZIP_EXECUTABLE) + " -Z1 " + zip.path(), &output) == 0);
+        REQUIRE(as_text(output).find("clip_3/000012.jpg") != std::string::npos);
+        REQUIRE(run_tool(std::string(UNZIP_EXECUTABLE) + " -z " + zip.path(), &output) == 0);
+        REQUIRE(as_text(output).find("burst report") != std::string::npos);
+        for (uint32_t i : {0u, 5u, 11u}) {
+            char name[32];
+            snprintf(name, sizeof(name), "clip_3/%06u.jpg", i + 1);
+            REQUIRE(run_tool(std::string(UNZIP_EXECUTABLE) + " -p " + zip.path() + " " + name,
+                             &output) == 0);
+            REQUIRE(output == payloads[i]);
+        }
+#else
+        WARN("unzip not found, ZIP reader check skipped");
+#endif
+    }
+
+    SECTION("tar lists and extracts the frames byte-exact") {
+#ifdef HAVE_TAR
+        TempArchive tar(build(ArchiveFormat::Tar, nullptr), ".tar");
+        REQUIRE(tar.valid());
+        std::vector<uint8_t> output;
+        REQUIRE(run_tool(std::string(TAR_EXECUTABLE) + " -tf " + tar.path(), &output) == 0);
+        std::string listing = as_text(output);
+        REQUIRE(listing.find("clip_3/000001.jpg\n") == 0);
+        REQUIRE(listing.find("clip_3/000012.jpg") != std::string::npos);
+        for (uint32_t i : {0u, 7u, 11u}) {
+            char name[32];
+            snprintf(name, sizeof(name), "clip_3/%06u.jpg", i + 1);
+            REQUIRE(run_tool(std::string(TAR_EXECUTABLE) + " -xOf " + tar.path() + " " + name,
+                             &output) == 0);
+            REQUIRE(output == payloads[i]);
+        }
+#else
+        WARN("tar not found, TAR reader check skipped");
+#endif
+    }
+}
+
+//=============================================================================
+// Clip Export Tests
+//=============================================================================
+
+TEST_CASE("Recorded clips export as archives", "[archive][clip]") {
+    ClipRig rig(40, 20000);
+    std::vector<uint8_t> buf(rig.store.max_record_size());
+    ArchiveWriter zip;
+    REQUIRE(zip.init({.format = ArchiveFormat::Zip, .max_entries = 64}));
+
+    SECTION("every frame, in order, stamped with its store time") {
+        ClipReader reader(rig.store);
+        REQUIRE(reader.open(rig.clip));
+        Collector out;
+        REQUIRE(zip.begin(&Collector::sink, &out, "clip_1/", ".jpg"));
+        REQUIRE(write_clip_archive(reader, zip, buf.data(), buf.size()) == 40);
+        REQUIRE(zip.finish());
+
+        std::vector<ParsedEntry> entries;
+        std::string comment;
+        REQUIRE(parse_zip(out.bytes, &entries, &comment));
+        REQUIRE(entries.size() == 40);
+        for (size_t i = 0; i < entries.size(); i++) REQUIRE(entries[i].data == rig.frames[i]);
+        uint32_t t0 = get32(out.bytes, entries[0].offset + 10);
+        REQUIRE(t0 == zip_dos_datetime(1700000000));
+    }
+
+    SECTION("a refusing sink stops the export") {
+        ClipReader reader(rig.store);
+        REQUIRE(reader.open(rig.clip));
+        Collector out;
+        out.fail_after = 10;
+        REQUIRE(zip.begin(&Collector::sink, &out, "clip_1/", ".jpg"));
+        REQUIRE(write_clip_archive(reader, zip, buf.data(), buf.size()) < 40);
+        REQUIRE(zip.failed());
+    }
+
+    SECTION("read_frame walks whole frames with their timestamps") {
+        ClipReader reader(rig.store);
+        REQUIRE(reader.open(rig.clip));
+        int64_t ts = 0;
+        REQUIRE(reader.read_frame(buf.data(), buf.size(), &ts) == rig.frames[0].size());
+        REQUIRE(ts == rig.clip.start_us);
+        REQUIRE(reader.read_frame(buf.data(), buf.size(), &ts) == rig.frames[1].size());
+        REQUIRE(ts == rig.clip.start_us + 500000);
+        REQUIRE(reader.seek(100));
+        REQUIRE(reader.read_frame(buf.data(), buf.size(), &ts) == 0);   // Mid-frame
+    }
+}
+
+//=============================================================================
+// Benchmarks
+//=============================================================================
+
+namespace {
+
+// Serves /frame/<i> (one frame per request) and /clip.zip over loopback,
+// one connection per request as a browser fetching files would see it
+class FrameServer {
+public:
+    explicit FrameServer(ClipRig& rig) : rig_(rig), buf_(rig.store.max_record_size()) {
+        zip_.init({.format = ArchiveFormat::Zip, .max_entries = 1024});
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        listen(listen_fd_, 16);
+        thread_ = std::thread([this] { serve(); });
+    }
+
+    ~FrameServer() {
+        stop_ = true;
+        shutdown(listen_fd_, SHUT_RDWR);
+        close(listen_fd_);
+        thread_.join();
+    }
+
+    // GET path; returns body bytes received
+    size_t fetch(const std::string& path) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port_);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return 0;
+        }
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+        send_all(fd, request.data(), request.size());
+        std::string head, extra;
+        size_t total = 0;
+        if (read_http_head(fd, &head, &extra)) {
+            total = extra.size();
+            char chunk[16384];
+            ssize_t n;
+            while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) total += static_cast<size_t>(n);
+        }
+        close(fd);
+        return total;
+    }
+
+private:
+    static bool send_sink(void* context, const uint8_t* data, size_t size) {
+        return send_all(*static_cast<int*>(context), data, size);
+    }
+
+    void serve() {
+        while (!stop_) {
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) continue;
+            std::string head, extra;
+            if (read_http_head(fd, &head, &extra)) handle(fd, head);
+            shutdown(fd, SHUT_WR);
+            close(fd);
+        }
+    }
+
+    void handle(int fd, const std::string& head) {
+        static const char ok[] = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n";
+        if (head.compare(0, 15, "GET /clip.zip H") == 0) {
+            ClipReader reader(rig_.store);
+            reader.open(rig_.clip);
+            send_all(fd, ok, sizeof(ok) - 1);
+            zip_.begin(&FrameServer::send_sink, &fd, "clip_1/", ".jpg");
+            if (write_clip_archive(reader, zip_, buf_.data(), buf_.size()) == reader.frames()) {
+                zip_.finish();
+            }
+            return;
+        }
+        unsigned long index = strtoul(head.c_str() + 11, nullptr, 10);   // "GET /frame/<i>"
+        RecordInfo rec;
+        size_t n = 0;
+        if (rig_.store.find_time(rig_.clip.start_us + static_cast<int64_t>(index) * 500000, &rec)) {
+            n = rig_.store.read(rec, buf_.data(), buf_.size());
+        }
+        send_all(fd, ok, sizeof(ok) - 1);
+        send_all(fd, buf_.data(), n);
+    }
+
+    ClipRig& rig_;
+    std::vector<uint8_t> buf_;
+    ArchiveWriter zip_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+} // namespace
+
+TEST_CASE("ArchiveWriter benchmarks", "[.][benchmark][archive]") {
+    ClipRig rig(100, 20000);
+    FrameServer server(rig);
+
+    BENCHMARK("100 x 20 KB frames: one request per frame") {
+        size_t total = 0;
+        for (int i = 0; i < 100; i++) total += server.fetch("/frame/" + std::to_string(i));
+        return total;
+    };
+
+    BENCHMARK("100 x 20 KB frames: one /clip.zip request") {
+        return server.fetch("/clip.zip");
+    };
+
+    // Writer alone: CRC + headers over frames already in RAM
+    std::vector<uint8_t> frame = make_payload(40 * 1024, 1);
+    ArchiveWriter zip;
+    zip.init({.format = ArchiveFormat::Zip, .max_entries = 1024});
+    uint64_t sunk = 0;
+    auto count_sink = [](void* context, const uint8_t*, size_t size) {
+        *static_cast<uint64_t*>(context) += size;
+        return true;
+    };
+    auto start = std::chrono::steady_clock::now();
+    zip.begin(count_sink, &sunk);
+    for (uint32_t i = 0; i < 1000; i++) {
+        zip.add_entry(i, 0, frame.size());
+        zip.write(frame.data(), frame.size());
+        zip.end_entry();
+    }
+    zip.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mb_per_s = sunk / seconds / 1e6;
+    WARN("ZIP writer throughput: " << mb_per_s << " MB/s (" << sunk << " bytes)");
+}
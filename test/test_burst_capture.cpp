@@ -0,0 +1,416 @@
+/**
+ * @file test_burst_capture.cpp
+ * @brief Unit tests for BurstCapture and its producer takeover
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/burst_capture.hpp"
+#include "../main/core/streaming_service.hpp"
+#include "mocks/mock_camera.hpp"
+#include "mocks/mock_clock.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace mocks;
+
+namespace {
+
+std::vector<uint8_t> make_frame(size_t size, uint8_t marker) {
+    std::vector<uint8_t> frame(size, marker);
+    frame[0] = 0xFF;
+    frame[1] = 0xD8;
+    frame[size - 2] = 0xFF;
+    frame[size - 1] = 0xD9;
+    return frame;
+}
+
+// Keeps the first half of every frame; rejects every reject_every-th call
+struct HalvingProcessor : interfaces::IFrameProcessor {
+    uint32_t calls = 0;
+    uint32_t reject_every = 0;
+    std::vector<uint8_t*> outputs;
+
+    size_t process(const interfaces::FrameView& frame, uint8_t* out, size_t capacity) override {
+        calls++;
+        outputs.push_back(out);
+        if (reject_every && calls % reject_every == 0) return 0;
+        size_t size = frame.size / 2;
+        if (size > capacity) return 0;
+        memcpy(out, frame.data, size);
+        return size;
+    }
+};
+
+const std::atomic<bool> no_stop{false};
+
+} // namespace
+
+//=============================================================================
+// Request Lifecycle Tests
+//=============================================================================
+
+TEST_CASE("BurstCapture request lifecycle", "[burst][lifecycle]") {
+    BurstCapture burst;
+    BurstFrame frame;
+
+    SECTION("begin requires init and a frame count") {
+        REQUIRE_FALSE(burst.begin(5, 0));
+        REQUIRE_FALSE(burst.init({.arena_size = 0}));
+        REQUIRE(burst.init({.arena_size = 64 * 1024, .max_frames = 8}));
+        REQUIRE_FALSE(burst.begin(0, 0));
+        REQUIRE_FALSE(burst.is_busy());
+    }
+
+    SECTION("only one burst at a time") {
+        REQUIRE(burst.init({.arena_size = 64 * 1024}));
+        REQUIRE(burst.begin(5, 0));
+        REQUIRE(burst.pending());
+        REQUIRE_FALSE(burst.begin(5, 0));
+        burst.end();
+        REQUIRE_FALSE(burst.is_busy());
+        REQUIRE(burst.stats().cancelled.load() == 1);
+        REQUIRE(burst.begin(5, 0));
+    }
+
+    SECTION("count and interval are clamped") {
+        REQUIRE(burst.init({.arena_size = 64 * 1024, .max_frames = 8, .max_interval_ms = 200}));
+        REQUIRE(burst.begin(100, 5000));
+        BurstReport report = burst.report();
+        REQUIRE(report.requested == 8);
+        REQUIRE(report.interval_ms == 200);
+        REQUIRE(report.arena_size == 64 * 1024);
+    }
+
+    SECTION("waiting on a pending burst times out; an idle one is done") {
+        REQUIRE(burst.init({.arena_size = 64 * 1024}));
+        REQUIRE(burst.wait_frame(0, &frame, 0) == BurstWait::Done);
+        REQUIRE(burst.begin(3, 0));
+        REQUIRE(burst.wait_frame(0, &frame, 10) == BurstWait::Timeout);
+    }
+}
+
+//=============================================================================
+// Capture Tests
+//=============================================================================
+
+TEST_CASE("BurstCapture captures into the arena", "[burst][capture]") {
+    MockCamera camera;
+    MockClock clock;
+    camera.init({});
+    clock.set_auto_advance_us(100);
+    auto source = make_frame(1000, 0x5A);
+    camera.set_custom_frame(source);
+
+    BurstCapture burst;
+    REQUIRE(burst.init({.arena_size = 64 * 1024}));
+
+    SECTION("frames are packed back to back, in capture order") {
+        REQUIRE(burst.begin(5, 0));
+        REQUIRE(burst.run(camera, clock, nullptr, 100 * 1024, no_stop) == 5);
+        REQUIRE(camera.capture_calls() == 5);
+        REQUIRE(camera.capture_calls() == camera.release_calls());
+        REQUIRE(clock.delay_ms_calls() == 0);   // No pacing at interval 0
+
+        BurstFrame frames[5];
+        for (uint16_t i = 0; i < 5; i++) {
+            REQUIRE(burst.wait_frame(i, &frames[i], 0) == BurstWait::Frame);
+            REQUIRE(frames[i].size == 1000);
+            REQUIRE(memcmp(frames[i].data, source.data(), source.size()) == 0);
+        }
+        REQUIRE(frames[1].data == frames[0].data + 1000);   // 1000 is 4-aligned
+        REQUIRE(frames[4].timestamp_us - frames[0].timestamp_us == 4 * 33333);
+
+        BurstFrame after;
+        REQUIRE(burst.wait_frame(5, &after, 1000) == BurstWait::Done);
+    }
+
+    SECTION("report gives the achieved interval and arena use") {
+        REQUIRE(burst.begin(5, 0));
+        burst.run(camera, clock, nullptr, 100 * 1024, no_stop);
+        BurstReport report = burst.report();
+        REQUIRE(report.requested == 5);
+        REQUIRE(report.frames == 5);
+        REQUIRE(report.interval_min_us == 33333);   // Mock sensor spacing
+        REQUIRE(report.interval_max_us == 33333);
+        REQUIRE(report.interval_mean_us == 33333);
+        REQUIRE(report.arena_used == 5000);
+        REQUIRE(report.capture_us > 0);
+        REQUIRE_FALSE(report.truncated);
+        REQUIRE(burst.stats().bursts.load() == 1);
+        REQUIRE(burst.stats().frames.load() == 5);
+        REQUIRE(burst.stats().peak_arena_bytes.load() == 5000);
+    }
+
+    SECTION("frame starts stay aligned") {
+        camera.set_custom_frame(make_frame(1001, 0x11));
+        REQUIRE(burst.begin(3, 0));
+        burst.run(camera, clock, nullptr, 100 * 1024, no_stop);
+        BurstFrame a, b;
+        REQUIRE(burst.wait_frame(0, &a, 0) == BurstWait::Frame);
+        REQUIRE(burst.wait_frame(1, &b, 0) == BurstWait::Frame);
+        REQUIRE(b.data == a.data + 1004);
+        REQUIRE(burst.report().arena_used == 3 * 1004);
+    }
+
+    SECTION("interval paces the captures") {
+        REQUIRE(burst.begin(4, 100));
+        REQUIRE(burst.run(camera, clock, nullptr, 100 * 1024, no_stop) == 4);
+        REQUIRE(clock.total_delay_ms() >= 3 * 99);
+        REQUIRE(burst.report().interval_ms == 100);
+    }
+
+    SECTION("a burst that would overflow the arena stops early") {
+        BurstCapture small;
+        REQUIRE(small.init({.arena_size = 2500}));
+        REQUIRE(small.begin(10, 0));
+        REQUIRE(small.run(camera, clock, nullptr, 100 * 1024, no_stop) == 2);
+        BurstReport report = small.report();
+        REQUIRE(report.truncated);
+        REQUIRE(report.frames == 2);
+        REQUIRE(report.arena_used == 2000);
+        REQUIRE(small.stats().truncated.load() == 1);
+        REQUIRE(camera.capture_calls() == camera.release_calls());
+    }
+
+    SECTION("capture failures end the burst") {
+        camera.set_capture_result(false);
+        REQUIRE(burst.begin(10, 0));
+        REQUIRE(burst.run(camera, clock, nullptr, 100 * 1024, no_stop) == 0);
+        REQUIRE(camera.capture_calls() == BurstCapture::MAX_CONSECUTIVE_ERRORS);
+        REQUIRE(burst.report().capture_errors == BurstCapture::MAX_CONSECUTIVE_ERRORS);
+        BurstFrame frame;
+        REQUIRE(burst.wait_frame(0, &frame, 0) == BurstWait::Done);
+    }
+
+    SECTION("run does nothing without a pending request") {
+        REQUIRE(burst.run(camera, clock, nullptr, 100 * 1024, no_stop) == 0);
+        REQUIRE(camera.capture_calls() == 0);
+    }
+
+    SECTION("the producer's stop flag ends the burst") {
+        std::atomic<bool> stop{false};
+        camera.set_capture_delay_callback([&] {
+            if (camera.capture_calls() == 3) stop = true;
+        });
+        REQUIRE(burst.begin(10, 0));
+        REQUIRE(burst.run(camera, clock, nullptr, 100 * 1024, stop) == 3);
+        REQUIRE(burst.is_busy());   // Done; the consumer still owns the frames
+        burst.end();
+        REQUIRE_FALSE(burst.is_busy());
+    }
+
+    SECTION("end() while capturing cancels and frees the arena") {
+        camera.set_capture_delay_callback([&] {
+            if (camera.capture_calls() == 2) burst.end();
+        });
+        REQUIRE(burst.begin(10, 0));
+        REQUIRE(burst.run(camera, clock, nullptr, 100 * 1024, no_stop) == 2);
+        REQUIRE_FALSE(burst.is_busy());
+        REQUIRE(burst.stats().cancelled.load() == 1);
+        REQUIRE(burst.begin(1, 0));
+    }
+}
+
+//=============================================================================
+// Frame Processor Tests
+//=============================================================================
+
+TEST_CASE("BurstCapture frame processor", "[burst][processor]") {
+    MockCamera camera;
+    MockClock clock;
+    camera.init({});
+    camera.set_custom_frame(make_frame(1000, 0x33));
+    HalvingProcessor processor;
+
+    BurstCapture burst;
+    REQUIRE(burst.init({.arena_size = 64 * 1024}));
+
+    SECTION("processor output is written straight into the arena") {
+        REQUIRE(burst.begin(3, 0));
+        REQUIRE(burst.run(camera, clock, &processor, 8 * 1024, no_stop) == 3);
+        BurstFrame frame;
+        for (uint16_t i = 0; i < 3; i++) {
+            REQUIRE(burst.wait_frame(i, &frame, 0) == BurstWait::Frame);
+            REQUIRE(frame.data == processor.outputs[i]);
+            REQUIRE(frame.size == 500);
+        }
+        REQUIRE(burst.report().arena_used == 1500);
+    }
+
+    SECTION("rejected frames are dropped, not stored unprocessed") {
+        processor.reject_every = 2;
+        REQUIRE(burst.begin(3, 0));
+        REQUIRE(burst.run(camera, clock, &processor, 8 * 1024, no_stop) == 3);
+        REQUIRE(processor.calls == 5);
+        REQUIRE(burst.report().frames_rejected == 2);
+        REQUIRE_FALSE(burst.report().truncated);
+    }
+
+    SECTION("running out of room for a full frame truncates") {
+        BurstCapture small;
+        REQUIRE(small.init({.arena_size = 1200}));
+        REQUIRE(small.begin(5, 0));
+        // The first 500-byte output leaves 700 bytes, less than the
+        // 1000 this processor needs to work with
+        struct : interfaces::IFrameProcessor {
+            size_t process(const interfaces::FrameView& frame, uint8_t* out, size_t capacity) override {
+                if (capacity < frame.size) return 0;
+                memcpy(out, frame.data, frame.size / 2);
+                return frame.size / 2;
+            }
+        } needs_full_frame;
+        REQUIRE(small.run(camera, clock, &needs_full_frame, 1000, no_stop) == 1);
+        REQUIRE(small.report().truncated);
+        REQUIRE(small.report().frames_rejected == 0);
+    }
+}
+
+//=============================================================================
+// Report Formatting Tests
+//=============================================================================
+
+TEST_CASE("Burst report JSON", "[burst][json]") {
+    BurstReport report;
+    report.requested = 20;
+    report.frames = 18;
+    report.interval_ms = 0;
+    report.interval_min_us = 33000;
+    report.interval_mean_us = 33400;
+    report.interval_max_us = 40100;
+    report.capture_us = 600000;
+    report.truncated = true;
+    report.arena_used = 900000;
+    report.arena_size = 1048576;
+
+    char json[320];
+    size_t len = format_burst_report_json(report, json, sizeof(json));
+    REQUIRE(len == strlen(json));
+    std::string s(json);
+    REQUIRE(s.find("\"requested\":20,\"frames\":18") != std::string::npos);
+    REQUIRE(s.find("\"interval_mean_us\":33400") != std::string::npos);
+    REQUIRE(s.find("\"truncated\":true") != std::string::npos);
+    REQUIRE(s.find("\"arena_used\":900000,\"arena_size\":1048576}") != std::string::npos);
+
+    REQUIRE(format_burst_report_json(report, json, 40) == 0);
+    REQUIRE(format_burst_report_json(report, nullptr, 0) == 0);
+}
+
+TEST_CASE("Burst count parsing", "[burst][parse]") {
+    uint16_t count = 7;
+
+    SECTION("accepts 1 through the limit") {
+        REQUIRE(parse_burst_count("1", 64, &count));
+        REQUIRE(count == 1);
+        REQUIRE(parse_burst_count("64", 64, &count));
+        REQUIRE(count == 64);
+    }
+
+    SECTION("rejects values above the limit") {
+        REQUIRE_FALSE(parse_burst_count("65", 64, &count));
+        REQUIRE_FALSE(parse_burst_count("65535", 64, &count));
+        REQUIRE_FALSE(parse_burst_count("99999999999", 64, &count));
+        REQUIRE(count == 7);
+    }
+
+    SECTION("rejects zero and non-numeric text") {
+        REQUIRE_FALSE(parse_burst_count("0", 64, &count));
+        REQUIRE_FALSE(parse_burst_count("", 64, &count));
+        REQUIRE_FALSE(parse_burst_count("-5", 64, &count));
+        REQUIRE_FALSE(parse_burst_count("10x", 64, &count));
+        REQUIRE_FALSE(parse_burst_count(nullptr, 64, &count));
+        REQUIRE(count == 7);
+    }
+}
+
+//=============================================================================
+// Producer Takeover Tests
+//=============================================================================
+
+TEST_CASE("StreamingService runs bursts on the producer", "[burst][integration]") {
+    MockCamera camera;
+    MockClock clock;
+    camera.init({});
+    camera.set_custom_frame(make_frame(2000, 0x77));
+    clock.set_auto_advance_us(1000);
+
+    BurstCapture burst;
+    REQUIRE(burst.init({.arena_size = 256 * 1024}));
+    StreamingService svc(camera, clock);
+    REQUIRE(svc.init({.target_fps = 1}));
+
+    SECTION("set_burst only while stopped") {
+        REQUIRE(svc.set_burst(&burst));
+        REQUIRE(svc.start());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE_FALSE(svc.set_burst(nullptr));
+        svc.stop();
+    }
+
+    SECTION("a 1 FPS stream delivers a full-rate burst, streamed as captured") {
+        REQUIRE(svc.set_burst(&burst));
+        REQUIRE(svc.start());
+
+        REQUIRE(burst.begin(20, 0));
+        BurstFrame frame;
+        uint16_t received = 0;
+        while (burst.wait_frame(received, &frame, 2000) == BurstWait::Frame) {
+            REQUIRE(frame.size == 2000);
+            REQUIRE(frame.data[1000] == 0x77);
+            received++;
+        }
+        BurstReport report = burst.report();
+        burst.end();
+
+        REQUIRE(received == 20);
+        REQUIRE(report.frames == 20);
+        REQUIRE(report.interval_mean_us == 33333);
+
+        // Burst frames bypass the ring; the stream carries on afterwards
+        REQUIRE(svc.is_running());
+        svc.stop();
+        REQUIRE(camera.capture_calls() ==
+                svc.stats().frames_captured.load() + burst.stats().frames.load());
+        REQUIRE(camera.capture_calls() == camera.release_calls());
+    }
+
+    SECTION("stopping the service ends a burst in progress") {
+        camera.set_capture_delay_callback([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        });
+        REQUIRE(svc.set_burst(&burst));
+        REQUIRE(svc.start());
+        REQUIRE(burst.begin(30, 50));
+        BurstFrame frame;
+        REQUIRE(burst.wait_frame(0, &frame, 2000) == BurstWait::Frame);
+        svc.stop();
+        uint16_t last = burst.report().frames;
+        REQUIRE(burst.wait_frame(last, &frame, 2000) == BurstWait::Done);
+        REQUIRE(last < 30);
+        burst.end();
+    }
+}
+
+//=============================================================================
+// Benchmarks
+//=============================================================================
+
+TEST_CASE("BurstCapture benchmarks", "[.][benchmark][burst]") {
+    MockCamera camera;
+    MockClock clock;
+    camera.init({});
+    camera.set_custom_frame(make_frame(40 * 1024, 0x42));   // VGA-sized JPEG
+    BurstCapture burst;
+    REQUIRE(burst.init({.arena_size = 2 * 1024 * 1024}));
+
+    BENCHMARK("30-frame burst of 40 KB frames into the arena") {
+        burst.begin(30, 0);
+        uint16_t n = burst.run(camera, clock, nullptr, 100 * 1024, no_stop);
+        burst.end();
+        return n;
+    };
+}
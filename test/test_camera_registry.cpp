@@ -0,0 +1,244 @@
+/**
+ * @file test_camera_registry.cpp
+ * @brief Unit tests for CameraRegistry (multi-camera pipelines)
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/camera_registry.hpp"
+#include "mocks/mock_camera.hpp"
+#include "mocks/mock_clock.hpp"
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <cstring>
+
+using namespace core;
+using namespace mocks;
+
+//=============================================================================
+// FPS Allocation Tests
+//=============================================================================
+
+TEST_CASE("allocate_fps splits the budget fairly", "[camera_registry][fps]") {
+    uint8_t granted[4];
+
+    SECTION("requests under budget are granted in full") {
+        const uint8_t requested[] = {5, 10, 3};
+        allocate_fps(requested, granted, 3, 30);
+        REQUIRE(granted[0] == 5);
+        REQUIRE(granted[1] == 10);
+        REQUIRE(granted[2] == 3);
+    }
+
+    SECTION("oversubscribed budget is shared equally") {
+        const uint8_t requested[] = {30, 30, 30, 30};
+        allocate_fps(requested, granted, 4, 20);
+        for (uint8_t g : granted) REQUIRE(g == 5);
+    }
+
+    SECTION("small requests leave more for the rest") {
+        const uint8_t requested[] = {25, 2, 25};
+        allocate_fps(requested, granted, 3, 20);
+        REQUIRE(granted[1] == 2);
+        REQUIRE(granted[0] + granted[2] == 18);
+        REQUIRE(granted[0] == 9);
+    }
+
+    SECTION("rounding remainder is not lost") {
+        const uint8_t requested[] = {30, 30, 30};
+        allocate_fps(requested, granted, 3, 10);
+        REQUIRE(granted[0] + granted[1] + granted[2] == 10);
+    }
+
+    SECTION("every camera keeps at least 1 FPS") {
+        const uint8_t requested[] = {10, 10, 10};
+        allocate_fps(requested, granted, 3, 2);
+        for (size_t i = 0; i < 3; i++) REQUIRE(granted[i] >= 1);
+    }
+}
+
+//=============================================================================
+// Path Parsing Tests
+//=============================================================================
+
+TEST_CASE("parse_camera_path", "[camera_registry][path]") {
+    char id[CAMERA_ID_MAX_LENGTH + 1];
+    char endpoint[16];
+
+    SECTION("id and endpoint") {
+        REQUIRE(parse_camera_path("/cam/front/stream", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE(strcmp(id, "front") == 0);
+        REQUIRE(strcmp(endpoint, "stream") == 0);
+    }
+
+    SECTION("query string is not part of the endpoint") {
+        REQUIRE(parse_camera_path("/cam/2/frame?after=5", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE(strcmp(id, "2") == 0);
+        REQUIRE(strcmp(endpoint, "frame") == 0);
+    }
+
+    SECTION("malformed paths rejected") {
+        REQUIRE_FALSE(parse_camera_path("/stream", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE_FALSE(parse_camera_path("/cam/front", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE_FALSE(parse_camera_path("/cam//stream", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE_FALSE(parse_camera_path("/cam/front/", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE_FALSE(parse_camera_path("/cam/front/stream/x", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE_FALSE(parse_camera_path("/cam/a.b/stream", id, sizeof(id), endpoint, sizeof(endpoint)));
+        REQUIRE_FALSE(parse_camera_path("/cam/0123456789abcdef/stream", id, sizeof(id),
+                                        endpoint, sizeof(endpoint)));
+    }
+
+    SECTION("endpoint longer than the buffer rejected") {
+        char small[4];
+        REQUIRE_FALSE(parse_camera_path("/cam/0/status", id, sizeof(id), small, sizeof(small)));
+    }
+}
+
+//=============================================================================
+// Registration Tests
+//=============================================================================
+
+TEST_CASE("CameraRegistry registration", "[camera_registry][init]") {
+    MockCamera cam_a, cam_b;
+    MockClock clock;
+    cam_a.init({});
+    cam_b.init({});
+
+    SECTION("cameras are found by id") {
+        CameraRegistry reg;
+        StreamingService* a = reg.add_camera("a", cam_a, clock);
+        StreamingService* b = reg.add_camera("b", cam_b, clock);
+        REQUIRE(a != nullptr);
+        REQUIRE(b != nullptr);
+        REQUIRE(a->is_initialized());
+        REQUIRE(reg.count() == 2);
+        REQUIRE(reg.find("a") == a);
+        REQUIRE(reg.find("b") == b);
+        REQUIRE(reg.find_camera("b") == &cam_b);
+        REQUIRE(reg.find("c") == nullptr);
+    }
+
+    SECTION("duplicate and invalid ids rejected") {
+        CameraRegistry reg;
+        REQUIRE(reg.add_camera("a", cam_a, clock) != nullptr);
+        REQUIRE(reg.add_camera("a", cam_b, clock) == nullptr);
+        REQUIRE(reg.add_camera("", cam_b, clock) == nullptr);
+        REQUIRE(reg.add_camera("x/y", cam_b, clock) == nullptr);
+        REQUIRE(reg.count() == 1);
+    }
+
+    SECTION("memory budget bounds ring allocation") {
+        CameraRegistry reg({.memory_budget_bytes = 100 * 1024, .total_fps_budget = 30});
+        StreamingConfig cfg{.target_fps = 5, .buffer_slots = 2, .max_frame_size = 32 * 1024};
+        REQUIRE(reg.add_camera("a", cam_a, clock, cfg) != nullptr);
+        REQUIRE(reg.memory_used() == 64 * 1024);
+        REQUIRE(reg.add_camera("b", cam_b, clock, cfg) == nullptr);   // 128K > 100K
+
+        cfg.buffer_slots = 1;
+        REQUIRE(reg.add_camera("b", cam_b, clock, cfg) != nullptr);   // 96K fits
+        REQUIRE(reg.memory_used() == 96 * 1024);
+    }
+
+    SECTION("removing a camera frees its memory and FPS share") {
+        CameraRegistry reg({.memory_budget_bytes = 1024 * 1024, .total_fps_budget = 10});
+        REQUIRE(reg.add_camera("a", cam_a, clock, {.target_fps = 10}) != nullptr);
+        REQUIRE(reg.add_camera("b", cam_b, clock, {.target_fps = 10}) != nullptr);
+        REQUIRE(reg.granted_fps(0) == 5);
+        REQUIRE(reg.find("a")->get_target_fps() == 5);
+
+        size_t used = reg.memory_used();
+        REQUIRE(reg.remove_camera("b"));
+        REQUIRE_FALSE(reg.remove_camera("b"));
+        REQUIRE(reg.memory_used() < used);
+        REQUIRE(reg.granted_fps(0) == 10);
+        REQUIRE(reg.find("a")->get_target_fps() == 10);
+    }
+
+    SECTION("FPS budget caps the number of producers") {
+        CameraRegistry reg({.memory_budget_bytes = 1024 * 1024, .total_fps_budget = 1});
+        REQUIRE(reg.add_camera("a", cam_a, clock, {.target_fps = 5}) != nullptr);
+        REQUIRE(reg.add_camera("b", cam_b, clock, {.target_fps = 5}) == nullptr);
+    }
+
+    SECTION("requested rate change re-splits the budget") {
+        CameraRegistry reg({.memory_budget_bytes = 1024 * 1024, .total_fps_budget = 12});
+        REQUIRE(reg.add_camera("a", cam_a, clock, {.target_fps = 10}) != nullptr);
+        REQUIRE(reg.add_camera("b", cam_b, clock, {.target_fps = 10}) != nullptr);
+        REQUIRE(reg.set_requested_fps("a", 2));
+        REQUIRE(reg.granted_fps(0) == 2);
+        REQUIRE(reg.granted_fps(1) == 10);
+        REQUIRE_FALSE(reg.set_requested_fps("a", 0));
+        REQUIRE_FALSE(reg.set_requested_fps("zz", 5));
+    }
+}
+
+//=============================================================================
+// Concurrent Pipeline Tests
+//=============================================================================
+
+TEST_CASE("CameraRegistry runs four pipelines concurrently", "[camera_registry][concurrent]") {
+    constexpr size_t NUM = 4;
+    MockCamera cameras[NUM];
+    MockClock clocks[NUM];
+    std::vector<uint8_t> frames[NUM];
+
+    for (size_t i = 0; i < NUM; i++) {
+        // Each camera's frames carry its index so cross-talk is visible
+        frames[i].assign(512 + i * 64, static_cast<uint8_t>(0xA0 + i));
+        cameras[i].set_custom_frame(frames[i]);
+        cameras[i].init({});
+        clocks[i].set_auto_advance_us(1000);
+    }
+
+    CameraRegistry reg({.memory_budget_bytes = 256 * 1024, .total_fps_budget = 40});
+    const char* ids[NUM] = {"0", "1", "2", "3"};
+    const uint8_t requested[NUM] = {30, 30, 5, 30};
+    for (size_t i = 0; i < NUM; i++) {
+        StreamingConfig cfg{.target_fps = requested[i], .buffer_slots = 3,
+                            .max_frame_size = 16 * 1024};
+        REQUIRE(reg.add_camera(ids[i], cameras[i], clocks[i], cfg) != nullptr);
+    }
+
+    // 5 FPS camera keeps its rate, the others share the remaining 35
+    uint32_t total = 0;
+    for (size_t i = 0; i < NUM; i++) total += reg.granted_fps(i);
+    REQUIRE(total <= 40);
+    REQUIRE(reg.granted_fps(2) == 5);
+    REQUIRE(reg.granted_fps(0) >= 11);
+
+    REQUIRE(reg.start_all());
+
+    // One consumer per camera, all running at once
+    std::atomic<bool> crosstalk{false};
+    std::atomic<uint32_t> consumed[NUM];
+    std::thread consumers[NUM];
+    for (size_t i = 0; i < NUM; i++) {
+        consumed[i] = 0;
+        consumers[i] = std::thread([&, i] {
+            StreamingService* svc = reg.find(ids[i]);
+            while (consumed[i].load() < 5) {
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+                if (!svc->get_frame(&data, &size, 200)) continue;
+                if (size != frames[i].size() || data[0] != frames[i][0]) crosstalk = true;
+                svc->release_frame();
+                consumed[i]++;
+            }
+        });
+    }
+    for (auto& t : consumers) t.join();
+
+    reg.stop_all();
+
+    REQUIRE_FALSE(crosstalk.load());
+    for (size_t i = 0; i < NUM; i++) {
+        const StreamingStats& stats = reg.service_at(i)->stats();
+        REQUIRE_FALSE(stats.producer_running.load());
+        REQUIRE(stats.frames_captured.load() >= 5);
+        REQUIRE(stats.capture_errors.load() == 0);
+
+        // Each producer is paced at its granted rate on its own clock
+        double elapsed_s = static_cast<double>(clocks[i].now_us()) / 1e6;
+        REQUIRE(cameras[i].capture_calls() <= reg.granted_fps(i) * elapsed_s + 2);
+    }
+}
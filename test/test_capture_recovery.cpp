@@ -0,0 +1,277 @@
+/**
+ * @file test_capture_recovery.cpp
+ * @brief Unit tests for CaptureRecoveryPolicy and the StreamingService recovery path
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/capture_recovery.hpp"
+#include "../main/core/streaming_service.hpp"
+#include "mocks/mock_camera.hpp"
+#include "mocks/mock_clock.hpp"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace mocks;
+
+namespace {
+
+constexpr int64_t MS = 1000;
+
+struct HealthLog {
+    std::mutex mutex;
+    std::vector<CameraHealth> changes;
+    std::vector<uint32_t> recovery_us;
+
+    static void on_health(void* ctx, CameraHealth health, const CaptureRecoveryStats& stats) {
+        auto* self = static_cast<HealthLog*>(ctx);
+        std::lock_guard<std::mutex> lock(self->mutex);
+        self->changes.push_back(health);
+        self->recovery_us.push_back(health == CameraHealth::Healthy ? stats.recovery_us_last.load() : 0);
+    }
+
+    std::vector<CameraHealth> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return changes;
+    }
+};
+
+// Wait (real time) for the producer to get somewhere
+template <typename Pred>
+bool wait_for(Pred pred, int timeout_ms = 2000) {
+    for (int i = 0; i < timeout_ms && !pred(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return pred();
+}
+
+} // namespace
+
+//=============================================================================
+// Policy
+//=============================================================================
+
+TEST_CASE("CaptureRecoveryPolicy escalation", "[recovery][policy]") {
+    CaptureRecoveryPolicy policy;
+    policy.start(0);
+
+    SECTION("backoff doubles up to the cap, with resets and a re-init") {
+        // Defaults: 50 ms doubling to 2 s, escalate every 4th failure, 2 resets per re-init
+        const RecoveryAction R = RecoveryAction::Retry;
+        const RecoveryAction S = RecoveryAction::ResetSensor;
+        const RecoveryAction I = RecoveryAction::Reinit;
+        const RecoveryAction actions[] = {R, R, R, S, R, R, R, S, R, R, R, I, R, R, R, S};
+        const uint32_t delays[] = {50, 100, 200, 400, 800, 1600, 2000, 2000,
+                                   2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000};
+        int64_t now = 1000 * MS;
+        for (size_t i = 0; i < 16; i++) {
+            RecoveryStep step = policy.on_failure(now);
+            INFO("failure " << i + 1);
+            CHECK(step.action == actions[i]);
+            CHECK(step.delay_ms == delays[i]);
+            now += step.delay_ms * MS;
+        }
+        const auto& stats = policy.stats();
+        CHECK(stats.episodes == 1);
+        CHECK(stats.consecutive_failures == 16);
+        CHECK(stats.sensor_resets == 3);
+        CHECK(stats.reinits == 1);
+        CHECK(policy.health() == CameraHealth::Reinitialized);
+        CHECK_FALSE(policy.healthy());
+    }
+
+    SECTION("health names") {
+        CHECK(std::string(camera_health_name(CameraHealth::Healthy)) == "healthy");
+        CHECK(std::string(camera_health_name(CameraHealth::Retrying)) == "retrying");
+        CHECK(std::string(camera_health_name(CameraHealth::SensorReset)) == "sensor_reset");
+        CHECK(std::string(camera_health_name(CameraHealth::Reinitialized)) == "reinitialized");
+    }
+
+    SECTION("a good frame ends the episode and starts escalation over") {
+        policy.on_failure(0);
+        policy.on_failure(50 * MS);
+        CHECK(policy.health() == CameraHealth::Retrying);
+        CHECK(policy.on_success(100 * MS));
+        CHECK(policy.health() == CameraHealth::Healthy);
+        CHECK_FALSE(policy.on_success(200 * MS));   // Already healthy: no change
+
+        RecoveryStep step = policy.on_failure(300 * MS);
+        CHECK(step.delay_ms == 50);
+        CHECK(step.action == RecoveryAction::Retry);
+        CHECK(policy.stats().episodes == 2);
+    }
+
+    SECTION("escalation can be turned off or go straight to re-init") {
+        CaptureRecoveryConfig config;
+        config.failures_before_reset = 0;
+        policy.set_config(config);
+        for (int i = 0; i < 20; i++) CHECK(policy.on_failure(i * MS).action == RecoveryAction::Retry);
+
+        config.failures_before_reset = 2;
+        config.resets_before_reinit = 0;
+        CaptureRecoveryPolicy reinit_only(config);
+        reinit_only.start(0);
+        CHECK(reinit_only.on_failure(0).action == RecoveryAction::Retry);
+        CHECK(reinit_only.on_failure(MS).action == RecoveryAction::Reinit);
+        CHECK(reinit_only.on_failure(2 * MS).action == RecoveryAction::Retry);
+        CHECK(reinit_only.on_failure(3 * MS).action == RecoveryAction::Reinit);
+        CHECK(reinit_only.stats().sensor_resets == 0);
+    }
+
+    SECTION("long outages do not overflow the backoff") {
+        RecoveryStep step;
+        for (int i = 0; i < 100; i++) step = policy.on_failure(i * MS);
+        CHECK(step.delay_ms == 2000);
+    }
+}
+
+TEST_CASE("CaptureRecoveryPolicy latency and MTBF", "[recovery][stats]") {
+    CaptureRecoveryPolicy policy;
+    policy.start(0);
+    const auto& stats = policy.stats();
+    CHECK(stats.mtbf_us() == 0);
+    CHECK(stats.recovery_us_mean() == 0);
+
+    // Healthy 10 s, down 0.3 s; healthy 20 s, down 1.5 s; healthy 30 s, down (still)
+    policy.on_failure(10000 * MS);
+    policy.on_failure(10100 * MS);
+    REQUIRE(policy.on_success(10300 * MS));
+    CHECK(stats.recovery_us_last == 300 * MS);
+
+    policy.on_failure(30300 * MS);
+    REQUIRE(policy.on_success(31800 * MS));
+    CHECK(stats.recovery_us_last == 1500 * MS);
+    CHECK(stats.recovery_us_max == 1500 * MS);
+    CHECK(stats.recovery_us_mean() == 900 * MS);
+
+    policy.on_failure(61800 * MS);
+    CHECK(stats.episodes == 3);
+    CHECK(stats.recoveries == 2);
+    CHECK(stats.mtbf_us() == 20000000);   // (10 + 20 + 30) s / 3
+
+    policy.start(0);
+    CHECK(stats.episodes == 0);
+    CHECK(policy.healthy());
+}
+
+//=============================================================================
+// StreamingService with a failing MockCamera (mock time: exact latencies)
+//=============================================================================
+
+TEST_CASE("StreamingService recovers a wedged camera", "[recovery][streaming]") {
+    MockCamera camera;
+    MockClock clock;
+    REQUIRE(camera.init({}));
+    HealthLog log;
+    StreamingService svc(camera, clock);
+    StreamingConfig config;
+    config.target_fps = 10;
+    REQUIRE(svc.init(config));
+    REQUIRE(svc.set_health_callback(&HealthLog::on_health, &log));
+
+    SECTION("transient failures only back off") {
+        camera.fail_captures(2);
+        REQUIRE(svc.start());
+        REQUIRE(wait_for([&] { return svc.stats().frames_captured.load() > 0; }));
+        svc.stop();
+
+        CHECK(svc.stats().capture_errors == 2);
+        CHECK(camera.reset_sensor_calls() == 0);
+        CHECK(camera.deinit_calls() == 0);
+        // Failures at 0 and 50 ms, good frame at 150 ms
+        CHECK(svc.recovery_stats().recovery_us_last == 150 * MS);
+        CHECK(log.snapshot() == std::vector<CameraHealth>{CameraHealth::Retrying, CameraHealth::Healthy});
+        CHECK(svc.health() == CameraHealth::Healthy);
+    }
+
+    SECTION("a sensor reset clears a wedge") {
+        camera.wedge(MockCamera::Wedge::UntilReset);
+        REQUIRE(svc.start());
+        REQUIRE(wait_for([&] { return svc.stats().frames_captured.load() > 0; }));
+        svc.stop();
+
+        CHECK(svc.stats().capture_errors == 4);
+        CHECK(camera.reset_sensor_calls() == 1);
+        CHECK(camera.deinit_calls() == 0);
+        // Failures at 0, 50, 150, 350 ms (reset), good frame at 750 ms
+        const auto& rs = svc.recovery_stats();
+        CHECK(rs.recovery_us_last == 750 * MS);
+        CHECK(rs.sensor_resets == 1);
+        CHECK(rs.recoveries == 1);
+        CHECK(log.snapshot() == std::vector<CameraHealth>{CameraHealth::Retrying, CameraHealth::SensorReset,
+                                                          CameraHealth::Healthy});
+        CHECK(log.recovery_us.back() == 750 * MS);
+    }
+
+    SECTION("a re-init clears what resets cannot, keeping runtime settings") {
+        REQUIRE(camera.set_resolution(interfaces::Resolution::QVGA));
+        REQUIRE(camera.set_quality(30));
+        interfaces::ExposureSettings manual;
+        manual.auto_exposure = false;
+        manual.exposure_us = 20000;
+        manual.gain_x16 = 32;
+        REQUIRE(camera.set_exposure(manual));
+        camera.wedge(MockCamera::Wedge::UntilReinit);
+        REQUIRE(svc.start());
+        REQUIRE(wait_for([&] { return svc.stats().frames_captured.load() > 0; }));
+        svc.stop();
+
+        CHECK(svc.stats().capture_errors == 12);
+        CHECK(camera.reset_sensor_calls() == 2);
+        CHECK(camera.deinit_calls() == 1);
+        CHECK(camera.init_calls() == 2);
+        CHECK(camera.get_resolution() == interfaces::Resolution::QVGA);
+        CHECK(camera.get_quality() == 30);
+        CHECK_FALSE(camera.get_exposure().auto_exposure);
+        CHECK(camera.get_exposure().exposure_us == 20000);
+        // 50+100+200+400+800+1600+2000x5 ms of failures, then 2 s after the re-init
+        CHECK(svc.recovery_stats().recovery_us_last == 15150 * MS);
+        CHECK(log.snapshot() == std::vector<CameraHealth>{CameraHealth::Retrying, CameraHealth::SensorReset,
+                                                          CameraHealth::Reinitialized, CameraHealth::Healthy});
+    }
+
+    SECTION("refused resets are counted and escalation continues") {
+        camera.set_reset_result(false);
+        camera.wedge(MockCamera::Wedge::UntilReinit);
+        REQUIRE(svc.start());
+        REQUIRE(wait_for([&] { return svc.stats().frames_captured.load() > 0; }));
+        svc.stop();
+        CHECK(svc.recovery_stats().action_failures == 2);
+        CHECK(svc.recovery_stats().reinits == 1);
+    }
+
+    SECTION("a re-init with a profile keeps the profile") {
+        interfaces::SensorProfile profile;
+        profile.name = "test";
+        profile.resolution = interfaces::Resolution::SVGA;
+        profile.max_fps = 25;
+        REQUIRE(camera.set_profile(profile));
+        camera.wedge(MockCamera::Wedge::UntilReinit);
+        REQUIRE(svc.start());
+        REQUIRE(wait_for([&] { return svc.stats().frames_captured.load() > 0; }));
+        svc.stop();
+        REQUIRE(camera.get_profile() != nullptr);
+        CHECK(camera.get_profile()->max_fps == 25);
+        CHECK(camera.get_resolution() == interfaces::Resolution::SVGA);
+    }
+
+    SECTION("the backoff spares the camera") {
+        // Down for 16 s of mock time at 10 FPS: 160 attempts without backoff
+        camera.set_capture_result(false);
+        REQUIRE(svc.start());
+        REQUIRE(wait_for([&] { return clock.current_time() >= 16000 * MS; }));
+        svc.stop();
+        CHECK(camera.capture_calls() <= 15);
+        CHECK(svc.health() == CameraHealth::Reinitialized);
+    }
+
+    SECTION("callback can only be set while stopped") {
+        REQUIRE(svc.start());
+        REQUIRE(wait_for([&] { return svc.is_running(); }));
+        CHECK_FALSE(svc.set_health_callback(nullptr, nullptr));
+        svc.stop();
+        CHECK(svc.set_health_callback(nullptr, nullptr));
+    }
+}
@@ -0,0 +1,281 @@
+/**
+ * @file test_egress_scheduler.cpp
+ * @brief Unit tests for EgressScheduler priority classes on a simulated link
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/egress_scheduler.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace core;
+
+namespace {
+
+constexpr int64_t MS = 1000;
+constexpr int64_t SEC = 1000000;
+
+constexpr size_t REC = static_cast<size_t>(ConsumerClass::Recorder);
+constexpr size_t OP = static_cast<size_t>(ConsumerClass::Operator);
+constexpr size_t DASH = static_cast<size_t>(ConsumerClass::Dashboard);
+
+/**
+ * Synthetic link: each consumer produces a frame every 1/fps (phases
+ * staggered so they do not all land on the same millisecond) and asks the
+ * scheduler, or charges it when it cannot skip (the uploader). What goes
+ * out is measured on the link, all in synthetic time.
+ */
+struct SimLink {
+    struct Consumer {
+        ConsumerClass cls;
+        uint8_t fps;
+        uint32_t frame_bytes;
+        int64_t phase_us;
+        bool charged;
+    };
+
+    EgressScheduler scheduler;
+    EgressMeter link;   // Everything delivered
+    std::vector<Consumer> consumers;
+    int64_t now = 0;
+
+    SimLink(uint32_t capacity_Bps, EgressPolicy policy = EgressPolicy::Strict) {
+        EgressSchedulerConfig config;
+        config.policy = policy;
+        scheduler.set_config(config);
+        scheduler.set_capacity_Bps(capacity_Bps);
+    }
+
+    void add(ConsumerClass cls, uint8_t fps, uint32_t frame_bytes, bool charged = false) {
+        int64_t phase = static_cast<int64_t>(consumers.size()) * 7 * MS;
+        consumers.push_back({cls, fps, frame_bytes, now + phase, charged});
+    }
+
+    void run(int64_t duration_us) {
+        int64_t end = now + duration_us;
+        for (; now < end; now += MS) {
+            for (const Consumer& c : consumers) {
+                if (now < c.phase_us || (now - c.phase_us) % (SEC / c.fps) != 0) continue;
+                if (c.charged) {
+                    scheduler.charge(c.cls, c.frame_bytes, 1, now);
+                    link.on_frame(c.frame_bytes, 0, now);
+                } else if (scheduler.offer(c.cls, c.frame_bytes, now)) {
+                    link.on_frame(c.frame_bytes, 0, now);
+                }
+            }
+        }
+    }
+
+    uint32_t permille(ConsumerClass cls) const { return scheduler.stats().of(cls).delivery_permille(); }
+};
+
+} // namespace
+
+//=============================================================================
+// Allocation
+//=============================================================================
+
+TEST_CASE("egress_allocate", "[egress]") {
+    EgressSchedulerConfig config;
+    uint32_t alloc[NUM_CONSUMER_CLASSES];
+
+    SECTION("strict: in priority order until the capacity runs out") {
+        uint32_t demand[] = {150000, 150000, 300000};
+        egress_allocate(config, 375000, demand, alloc);
+        CHECK(alloc[REC] == 150000);
+        CHECK(alloc[OP] == 150000);
+        CHECK(alloc[DASH] == 75000);
+
+        uint32_t heavy[] = {400000, 100000, 100000};
+        egress_allocate(config, 375000, heavy, alloc);
+        CHECK(alloc[REC] == 375000);
+        CHECK(alloc[OP] == 0);
+        CHECK(alloc[DASH] == 0);
+    }
+
+    SECTION("under capacity every class gets its demand") {
+        uint32_t demand[] = {100000, 0, 50000};
+        egress_allocate(config, 375000, demand, alloc);
+        CHECK(alloc[REC] == 100000);
+        CHECK(alloc[OP] == 0);
+        CHECK(alloc[DASH] == 50000);
+        config.policy = EgressPolicy::Weighted;
+        egress_allocate(config, 375000, demand, alloc);
+        CHECK(alloc[REC] == 100000);
+        CHECK(alloc[OP] == 0);
+        CHECK(alloc[DASH] == 50000);
+    }
+
+    SECTION("weighted: shares by weight when all want more") {
+        config.policy = EgressPolicy::Weighted;   // 6:3:1
+        uint32_t demand[] = {200000, 200000, 200000};
+        egress_allocate(config, 300000, demand, alloc);
+        CHECK(alloc[REC] == 180000);
+        CHECK(alloc[OP] == 90000);
+        CHECK(alloc[DASH] == 30000);
+    }
+
+    SECTION("weighted: what a light class leaves is split among the rest") {
+        config.policy = EgressPolicy::Weighted;
+        uint32_t demand[] = {50000, 400000, 400000};
+        egress_allocate(config, 300000, demand, alloc);
+        CHECK(alloc[REC] == 50000);
+        CHECK(alloc[OP] == 187500);   // 250000 x 3/4
+        CHECK(alloc[DASH] == 62500);
+    }
+
+    SECTION("no capacity, nothing allocated") {
+        uint32_t demand[] = {1000, 1000, 1000};
+        egress_allocate(config, 0, demand, alloc);
+        CHECK(alloc[REC] + alloc[OP] + alloc[DASH] == 0);
+    }
+}
+
+TEST_CASE("Consumer class names", "[egress]") {
+    ConsumerClass cls = ConsumerClass::Operator;
+    CHECK(parse_consumer_class("dashboard", &cls));
+    CHECK(cls == ConsumerClass::Dashboard);
+    CHECK(parse_consumer_class("recorder", &cls));
+    CHECK(cls == ConsumerClass::Recorder);
+    CHECK_FALSE(parse_consumer_class("vip", &cls));
+    CHECK(cls == ConsumerClass::Recorder);
+    CHECK(std::string(consumer_class_name(ConsumerClass::Operator)) == "operator");
+    CHECK(std::string(egress_policy_name(EgressPolicy::Weighted)) == "weighted");
+}
+
+//=============================================================================
+// Scheduling on the simulated link
+//=============================================================================
+
+TEST_CASE("EgressScheduler without pressure delivers everything", "[egress][sim]") {
+    SECTION("capacity 0: scheduling off") {
+        SimLink sim(0);
+        sim.add(ConsumerClass::Dashboard, 10, 100000);
+        sim.add(ConsumerClass::Operator, 10, 100000);
+        sim.run(3 * SEC);
+        CHECK(sim.permille(ConsumerClass::Dashboard) == 1000);
+        CHECK(sim.permille(ConsumerClass::Operator) == 1000);
+        CHECK(sim.scheduler.stats().of(ConsumerClass::Dashboard).offered == 30);
+    }
+
+    SECTION("demand under capacity") {
+        SimLink sim(1000000);
+        sim.add(ConsumerClass::Recorder, 10, 15000, true);
+        sim.add(ConsumerClass::Operator, 10, 15000);
+        sim.add(ConsumerClass::Dashboard, 10, 15000);
+        sim.add(ConsumerClass::Dashboard, 10, 15000);
+        sim.run(10 * SEC);
+        CHECK(sim.permille(ConsumerClass::Recorder) == 1000);
+        CHECK(sim.permille(ConsumerClass::Operator) == 1000);
+        CHECK(sim.permille(ConsumerClass::Dashboard) == 1000);
+        CHECK(sim.scheduler.stats().spare_Bps > 0);
+    }
+}
+
+TEST_CASE("EgressScheduler strict priority degrades the lowest class first", "[egress][sim]") {
+    // 375 KB/s shared by the uploader (150 KB/s, charged), an operator
+    // (150 KB/s) and two dashboards (300 KB/s): the dashboards get the 75 KB/s left
+    SimLink sim(375000);
+    sim.add(ConsumerClass::Recorder, 10, 15000, true);
+    sim.add(ConsumerClass::Operator, 10, 15000);
+    sim.add(ConsumerClass::Dashboard, 10, 15000);
+    sim.add(ConsumerClass::Dashboard, 10, 15000);
+    sim.run(3 * SEC);
+    sim.scheduler.reset_stats();
+    sim.run(10 * SEC);
+
+    const auto& s = sim.scheduler.stats();
+    CHECK(sim.permille(ConsumerClass::Recorder) == 1000);
+    CHECK(sim.permille(ConsumerClass::Operator) >= 950);
+    uint32_t dash = sim.permille(ConsumerClass::Dashboard);
+    CHECK(dash >= 200);
+    CHECK(dash <= 300);
+    CHECK(s.of(ConsumerClass::Dashboard).skipped > 0);
+    CHECK(s.of(ConsumerClass::Operator).alloc_Bps == 150000);
+    CHECK(s.of(ConsumerClass::Dashboard).demand_Bps == 300000);
+    CHECK(s.of(ConsumerClass::Dashboard).alloc_Bps == 75000);
+    CHECK(sim.link.throughput_Bps(sim.now) <= 375000 * 105 / 100);
+}
+
+TEST_CASE("EgressScheduler weighted shares", "[egress][sim]") {
+    // Three classes each offering 200 KB/s over 300 KB/s at 6:3:1
+    SimLink sim(300000, EgressPolicy::Weighted);
+    sim.add(ConsumerClass::Recorder, 10, 20000);
+    sim.add(ConsumerClass::Operator, 10, 20000);
+    sim.add(ConsumerClass::Dashboard, 10, 20000);
+    sim.run(3 * SEC);
+    sim.scheduler.reset_stats();
+    sim.run(10 * SEC);
+
+    uint32_t rec = sim.permille(ConsumerClass::Recorder);
+    uint32_t op = sim.permille(ConsumerClass::Operator);
+    uint32_t dash = sim.permille(ConsumerClass::Dashboard);
+    INFO("recorder " << rec << " operator " << op << " dashboard " << dash);
+    CHECK(rec >= 850);
+    CHECK(rec <= 950);
+    CHECK(op >= 400);
+    CHECK(op <= 500);
+    CHECK(dash >= 100);
+    CHECK(dash <= 200);
+    CHECK(dash > 0);   // Not starved, unlike strict
+    CHECK(sim.link.throughput_Bps(sim.now) <= 300000 * 105 / 100);
+}
+
+TEST_CASE("EgressScheduler: a higher class takes over from a lower one", "[egress][sim]") {
+    SimLink sim(375000);
+    sim.add(ConsumerClass::Dashboard, 10, 25000);   // 250 KB/s
+    sim.run(3 * SEC);
+    CHECK(sim.permille(ConsumerClass::Dashboard) == 1000);
+
+    // An operator asking for another 250 KB/s: within a window it has all
+    // of it, and the dashboard is cut to the 125 KB/s left
+    sim.add(ConsumerClass::Operator, 10, 25000);
+    sim.run(2500 * MS);
+    sim.scheduler.reset_stats();
+    sim.run(10 * SEC);
+    uint32_t op = sim.permille(ConsumerClass::Operator);
+    uint32_t dash = sim.permille(ConsumerClass::Dashboard);
+    INFO("operator " << op << " dashboard " << dash);
+    CHECK(op >= 950);
+    CHECK(dash >= 400);
+    CHECK(dash <= 600);
+
+    // Capacity follows the link estimate
+    sim.scheduler.set_capacity_Bps(250000);
+    sim.run(3 * SEC);
+    sim.scheduler.reset_stats();
+    sim.run(5 * SEC);
+    CHECK(sim.permille(ConsumerClass::Operator) >= 950);
+    CHECK(sim.permille(ConsumerClass::Dashboard) <= 100);
+}
+
+TEST_CASE("EgressScheduler delivered rate by class", "[egress]") {
+    SimLink sim(0);
+    sim.add(ConsumerClass::Recorder, 10, 10000, true);
+    sim.add(ConsumerClass::Operator, 10, 20000);
+    sim.add(ConsumerClass::Dashboard, 10, 40000);
+    sim.run(3 * SEC);
+    CHECK(sim.scheduler.delivered_Bps(ConsumerClass::Recorder, sim.now) == 100000);
+    CHECK(sim.scheduler.delivered_Bps(ConsumerClass::Operator, sim.now) == 300000);
+    CHECK(sim.scheduler.delivered_Bps(ConsumerClass::Dashboard, sim.now) == 700000);
+}
+
+TEST_CASE("Egress JSON", "[egress]") {
+    SimLink sim(375000);
+    sim.add(ConsumerClass::Operator, 10, 15000);
+    sim.add(ConsumerClass::Dashboard, 10, 50000);
+    sim.run(5 * SEC);
+
+    char json[768];
+    size_t len = format_egress_json(sim.scheduler.stats(), EgressPolicy::Strict, json, sizeof(json));
+    REQUIRE(len > 0);
+    CHECK(len == strlen(json));
+    std::string text(json);
+    CHECK(text.find("\"policy\":\"strict\"") != std::string::npos);
+    CHECK(text.find("\"capacity_Bps\":375000") != std::string::npos);
+    CHECK(text.find("\"operator\":{\"offered\":50,\"delivered\":50,\"skipped\":0,\"delivery_permille\":1000")
+          != std::string::npos);
+    CHECK(text.find("\"dashboard\":{") != std::string::npos);
+    CHECK(text.find("\"recorder\":{\"offered\":0") != std::string::npos);
+    CHECK(format_egress_json(sim.scheduler.stats(), EgressPolicy::Strict, json, 64) == 0);
+}
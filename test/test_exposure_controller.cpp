@@ -0,0 +1,409 @@
+/**
+ * @file test_exposure_controller.cpp
+ * @brief Unit tests for ExposureController against MockCamera's synthetic scene
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/exposure_controller.hpp"
+#include "mocks/mock_camera.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using interfaces::AntiFlicker;
+using interfaces::ExposureSettings;
+
+namespace {
+
+// Camera → analyzer → controller, one frame at a time
+struct Loop {
+    mocks::MockCamera camera;
+    ImageQualityAnalyzer analyzer;
+    ExposureController controller;
+    std::vector<uint8_t> luma;      // Mean luma of every frame
+    uint32_t sequence = 0;
+
+    explicit Loop(const mocks::MockScene& scene) {
+        camera.init({});
+        camera.set_scene(scene);
+    }
+
+    bool start(const ExposureControllerConfig& config) { return controller.init(&camera, config); }
+
+    void run(int frames) {
+        for (int i = 0; i < frames; i++) {
+            interfaces::FrameView frame = camera.capture_frame();
+            ImageQualityMetrics m;
+            REQUIRE(analyzer.analyze(frame.data, frame.size, &m));
+            camera.release_frame();
+            luma.push_back(m.mean_luma);
+            controller.update(m, sequence++);
+        }
+    }
+
+    // Frames until luma stays within target +/- tolerance for good (-1 if never)
+    int settled_after(size_t from, uint8_t target, uint8_t tolerance) const {
+        int last_out = -1;
+        for (size_t i = from; i < luma.size(); i++) {
+            if (std::abs(luma[i] - target) > tolerance) last_out = static_cast<int>(i - from);
+        }
+        return last_out + 1 < static_cast<int>(luma.size() - from) ? last_out + 1 : -1;
+    }
+
+    double spread(size_t from) const {
+        auto mm = std::minmax_element(luma.begin() + from, luma.end());
+        return *mm.second - *mm.first;
+    }
+};
+
+ImageQualityMetrics metrics(uint8_t mean_luma, uint8_t bright_pct = 0) {
+    ImageQualityMetrics m;
+    m.mean_luma = mean_luma;
+    m.bright_pct = bright_pct;
+    m.blocks = 300;
+    return m;
+}
+
+} // namespace
+
+// =============================================================================
+// Exposure/gain split
+// =============================================================================
+
+TEST_CASE("ExposureController splits exposure and gain", "[exposure][split]") {
+    mocks::MockCamera camera;
+    REQUIRE(camera.init({}));
+    ExposureControllerConfig config;
+
+    SECTION("exposure first, gain once exposure is at its limit") {
+        ExposureController controller;
+        REQUIRE(controller.init(&camera, config));
+        ExposureSettings s = controller.split(20000);
+        CHECK_FALSE(s.auto_exposure);
+        CHECK(s.exposure_us == 20000);
+        CHECK(s.gain_x16 == 16);
+
+        s = controller.split(33333.0f * 4);
+        CHECK(s.exposure_us == 33333);
+        CHECK(s.gain_x16 == 64);
+
+        s = controller.split(1e9f);
+        CHECK(s.exposure_us == 33333);
+        CHECK(s.gain_x16 == camera.get_exposure_limits().max_gain_x16);
+
+        s = controller.split(1.0f);
+        CHECK(s.exposure_us == camera.get_exposure_limits().min_exposure_us);
+        CHECK(s.gain_x16 == 16);
+    }
+
+    SECTION("configured limits take over from the sensor's") {
+        config.max_exposure_us = 8000;
+        config.max_gain_x16 = 32;
+        ExposureController controller;
+        REQUIRE(controller.init(&camera, config));
+        ExposureSettings s = controller.split(40000);
+        CHECK(s.exposure_us == 8000);
+        CHECK(s.gain_x16 == 32);
+    }
+
+    SECTION("anti-flicker holds exposure to whole light periods") {
+        CHECK(flicker_period_us(AntiFlicker::Off) == 0);
+        CHECK(flicker_period_us(AntiFlicker::Hz50) == 10000);
+        CHECK(flicker_period_us(AntiFlicker::Hz60) == 8333);
+
+        config.anti_flicker = AntiFlicker::Hz50;
+        ExposureController controller;
+        REQUIRE(controller.init(&camera, config));
+        ExposureSettings s = controller.split(25000);
+        CHECK(s.anti_flicker == AntiFlicker::Hz50);
+        CHECK(s.exposure_us == 20000);
+        CHECK(s.gain_x16 == 20);            // 1.25x makes up the rest
+        CHECK(controller.split(6000).exposure_us == 6000);   // Below one period: unavoidable
+
+        config.anti_flicker = AntiFlicker::Hz60;
+        ExposureController sixty;
+        REQUIRE(sixty.init(&camera, config));
+        CHECK(sixty.split(30000).exposure_us == 3 * 8333);
+    }
+}
+
+// =============================================================================
+// Control law
+// =============================================================================
+
+TEST_CASE("ExposureController control law", "[exposure][control]") {
+    mocks::MockCamera camera;
+    REQUIRE(camera.init({}));
+    ExposureControllerConfig config;
+    config.settle_frames = 0;
+    ExposureController controller;
+
+    SECTION("takes over from the sensor's AEC and hands back on deinit") {
+        REQUIRE(camera.get_exposure().auto_exposure);
+        REQUIRE(controller.init(&camera, config));
+        CHECK_FALSE(camera.get_exposure().auto_exposure);
+        CHECK(camera.get_exposure().exposure_us == 10000);
+        CHECK(controller.stats().exposure_us == 10000);
+        controller.deinit();
+        CHECK(camera.get_exposure().auto_exposure);
+        CHECK_FALSE(controller.is_initialized());
+    }
+
+    SECTION("rejects a missing or uninitialised camera") {
+        CHECK_FALSE(controller.init(nullptr, config));
+        mocks::MockCamera off;
+        CHECK_FALSE(controller.init(&off, config));
+    }
+
+    SECTION("no change inside the deadband") {
+        REQUIRE(controller.init(&camera, config));
+        uint32_t calls = camera.set_exposure_calls();
+        CHECK_FALSE(controller.update(metrics(config.target_luma + config.tolerance), 0));
+        CHECK_FALSE(controller.update(metrics(config.target_luma - config.tolerance), 1));
+        CHECK(camera.set_exposure_calls() == calls);
+        CHECK(controller.stats().converged);
+        CHECK(controller.stats().samples == 2);
+    }
+
+    SECTION("damped and limited steps") {
+        REQUIRE(controller.init(&camera, config));
+        // Full correction would be (110 / 80)^2.2 = 2.0x; damped to 60% in log terms, 1.5x
+        REQUIRE(controller.update(metrics(80), 0));
+        float ratio = controller.settings().exposure_us / 10000.0f;
+        CHECK(ratio > 1.45f);
+        CHECK(ratio < 1.6f);
+
+        // Black frame: limited to one doubling
+        uint32_t before = controller.settings().exposure_us;
+        REQUIRE(controller.update(metrics(0), 1));
+        CHECK(controller.settings().exposure_us == std::min<uint32_t>(before * 2, 33333));
+    }
+
+    SECTION("reversals halve the damping") {
+        REQUIRE(controller.init(&camera, config));
+        REQUIRE(controller.update(metrics(80), 0));
+        uint32_t e1 = controller.settings().exposure_us;
+        REQUIRE(controller.update(metrics(140), 1));   // Overshot: reversal
+        uint32_t e2 = controller.settings().exposure_us;
+        CHECK(controller.stats().reversals == 1);
+        // 140 → 110 at full damping would be a 41% cut; halved, about 16%
+        CHECK(e2 < e1);
+        CHECK(e2 > e1 * 0.8f);
+    }
+
+    SECTION("clipped highlights pull exposure down with the mean on target") {
+        REQUIRE(controller.init(&camera, config));
+        REQUIRE(controller.update(metrics(config.target_luma, 20), 0));
+        CHECK(controller.settings().exposure_us < 10000);
+        CHECK_FALSE(controller.stats().converged);
+    }
+
+    SECTION("samples exposed before a change are ignored") {
+        config.settle_frames = 2;
+        REQUIRE(controller.init(&camera, config));
+        REQUIRE(controller.update(metrics(60), 10));
+        uint32_t calls = camera.set_exposure_calls();
+        CHECK_FALSE(controller.update(metrics(60), 11));
+        CHECK_FALSE(controller.update(metrics(60), 12));
+        CHECK(controller.stats().samples_settling == 2);
+        CHECK(controller.update(metrics(60), 13));
+        CHECK(camera.set_exposure_calls() == calls + 1);
+    }
+
+    SECTION("at the limits nothing is sent") {
+        config.max_gain_x16 = 16;
+        REQUIRE(controller.init(&camera, config));
+        for (uint32_t i = 0; i < 10; i++) controller.update(metrics(20), i);
+        CHECK(controller.settings().exposure_us == 33333);
+        uint32_t calls = camera.set_exposure_calls();
+        CHECK_FALSE(controller.update(metrics(20), 10));
+        CHECK(controller.stats().limited);
+        CHECK(camera.set_exposure_calls() == calls);
+    }
+}
+
+// =============================================================================
+// Closed loop on the synthetic scene
+// =============================================================================
+
+TEST_CASE("ExposureController converges on a synthetic scene", "[exposure][loop]") {
+    ExposureControllerConfig config;
+
+    SECTION("mock scene is calibrated around the default target") {
+        Loop loop({});
+        loop.run(3);
+        CHECK(loop.luma.back() > 95);
+        CHECK(loop.luma.back() < 125);
+    }
+
+    SECTION("from a dark start") {
+        mocks::MockScene scene;
+        scene.luminance = 0.1f;
+        Loop loop(scene);
+        REQUIRE(loop.start(config));
+        loop.run(40);
+        CHECK(loop.luma.front() < 50);
+        int settled = loop.settled_after(0, config.target_luma, config.tolerance + 2);
+        INFO("settled after " << settled << " frames");
+        CHECK(settled >= 0);
+        CHECK(settled <= 20);
+        CHECK(loop.controller.stats().reversals <= 1);
+        CHECK(loop.controller.stats().converged);
+    }
+
+    SECTION("from a bright start") {
+        mocks::MockScene scene;
+        scene.luminance = 6.0f;
+        Loop loop(scene);
+        REQUIRE(loop.start(config));
+        loop.run(40);
+        CHECK(loop.luma.front() > 200);
+        int settled = loop.settled_after(0, config.target_luma, config.tolerance + 2);
+        INFO("settled after " << settled << " frames");
+        CHECK(settled >= 0);
+        CHECK(settled <= 20);
+        CHECK(loop.controller.settings().exposure_us < 3000);
+    }
+
+    SECTION("scene changes: lights off, lights on") {
+        Loop loop({});
+        REQUIRE(loop.start(config));
+        loop.run(10);
+
+        mocks::MockScene dim;
+        dim.luminance = 0.125f;
+        loop.camera.set_scene(dim);
+        size_t change = loop.luma.size();
+        loop.run(40);
+        int settled = loop.settled_after(change, config.target_luma, config.tolerance + 2);
+        INFO("dimmed: settled after " << settled << " frames");
+        CHECK(settled >= 0);
+        CHECK(settled <= 20);
+        CHECK(loop.controller.settings().gain_x16 > 16);   // 80 ms of light needs gain at 30 FPS
+
+        loop.camera.set_scene({});
+        change = loop.luma.size();
+        loop.run(40);
+        settled = loop.settled_after(change, config.target_luma, config.tolerance + 2);
+        INFO("restored: settled after " << settled << " frames");
+        CHECK(settled >= 0);
+        CHECK(settled <= 20);
+        CHECK(loop.controller.settings().gain_x16 == 16);  // Gain goes before exposure
+    }
+
+    SECTION("without settling the loop overshoots") {
+        // The mock applies settings two frames late; a controller that
+        // does not wait for them double-counts its own corrections
+        mocks::MockScene scene;
+        scene.luminance = 0.1f;
+        Loop patient(scene);
+        REQUIRE(patient.start(config));
+        patient.run(40);
+
+        config.settle_frames = 0;
+        Loop eager(scene);
+        REQUIRE(eager.start(config));
+        eager.run(40);
+        CHECK(eager.controller.stats().reversals > patient.controller.stats().reversals);
+    }
+}
+
+TEST_CASE("ExposureController under flickering light", "[exposure][flicker]") {
+    mocks::MockScene scene;
+    scene.luminance = 0.6f;        // About 17 ms: not a whole number of light periods
+    scene.flicker_depth = 1.0f;
+    scene.flicker_hz = 100;
+    ExposureControllerConfig config;
+
+    Loop plain(scene);
+    REQUIRE(plain.start(config));
+    plain.run(90);
+
+    config.anti_flicker = AntiFlicker::Hz50;
+    Loop guarded(scene);
+    REQUIRE(guarded.start(config));
+    guarded.run(90);
+
+    INFO("luma spread over the last 60 frames: " << plain.spread(30) << " without, "
+         << guarded.spread(30) << " with anti-flicker; "
+         << plain.controller.stats().adjustments.load() << " vs "
+         << guarded.controller.stats().adjustments.load() << " adjustments");
+    CHECK(guarded.controller.settings().exposure_us % 10000 == 0);
+    CHECK(guarded.spread(30) <= 4);
+    CHECK(guarded.settled_after(0, config.target_luma, config.tolerance + 2) <= 30);
+    CHECK(plain.spread(30) > 2 * guarded.spread(30));
+    // Without it the loop chases the beat between frame rate and light
+    CHECK(guarded.controller.stats().adjustments * 4 < plain.controller.stats().adjustments);
+}
+
+// =============================================================================
+// Driven by QualityMonitor
+// =============================================================================
+
+TEST_CASE("ExposureController fed by QualityMonitor", "[exposure][monitor]") {
+    mocks::MockScene scene;
+    scene.luminance = 0.2f;
+    mocks::MockCamera camera;
+    REQUIRE(camera.init({}));
+    camera.set_scene(scene);
+
+    ExposureControllerConfig config;
+    ExposureController controller;
+    REQUIRE(controller.init(&camera, config));
+
+    static QualityMonitor monitor;
+    QualityMonitorConfig quality_config;
+    quality_config.max_frame_size = 64 * 1024;
+    quality_config.sample_interval = 3;
+    REQUIRE(monitor.init(quality_config, false));
+    monitor.set_metrics_callback(&ExposureController::on_metrics, &controller);
+    REQUIRE(monitor.start());
+
+    for (uint32_t i = 0; i < 90; i++) {
+        interfaces::FrameView frame = camera.capture_frame();
+        monitor.on_frame(frame.data, frame.size, frame.timestamp_us, i);
+        camera.release_frame();
+        if (i % 3 == 0) {
+            // Let the quality task finish the sample (and the controller its update)
+            for (int wait = 0; wait < 200 && controller.stats().samples < i / 3 + 1; wait++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+    monitor.deinit();
+
+    const auto& stats = controller.stats();
+    CHECK(stats.samples == 30);
+    CHECK(stats.adjustments > 0);
+    CHECK(stats.converged);
+    CHECK(std::abs(stats.mean_luma.load() - config.target_luma) <= config.tolerance);
+}
+
+// =============================================================================
+// Convergence table (run with "[benchmark]")
+// =============================================================================
+
+TEST_CASE("ExposureController convergence by step size", "[.][benchmark][exposure]") {
+    ExposureControllerConfig config;
+    printf("\n  Frames to settle within +/-%u of %u after a brightness step (30 FPS)\n",
+           config.tolerance + 2, config.target_luma);
+    printf("  %-10s %-10s %-10s %-12s\n", "step", "frames", "changes", "reversals");
+    for (float step : {0.03125f, 0.125f, 0.5f, 2.0f, 8.0f}) {
+        Loop loop({});
+        REQUIRE(loop.start(config));
+        loop.run(10);
+        uint32_t before = loop.controller.stats().adjustments;
+        mocks::MockScene scene;
+        scene.luminance = step;
+        loop.camera.set_scene(scene);
+        size_t change = loop.luma.size();
+        loop.run(60);
+        printf("  x%-9.3g %-10d %-10u %-12u\n", step,
+               loop.settled_after(change, config.target_luma, config.tolerance + 2),
+               loop.controller.stats().adjustments.load() - before,
+               loop.controller.stats().reversals.load());
+    }
+}
@@ -336,6 +336,146 @@ TEST_CASE("FrameBuffer clear operation", "[frame_buffer][clear]") {
     }
 }
 
+//=============================================================================
+// Pinned Reader Tests (acquire_latest/release)
+//=============================================================================
+
+TEST_CASE("FrameBuffer pinned readers", "[frame_buffer][pin]") {
+    FrameBuffer buffer;
+    REQUIRE(buffer.init(3, 4096, false));
+    
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int64_t ts = 0;
+    uint32_t seq = 0;
+    
+    SECTION("empty buffer has nothing to acquire") {
+        REQUIRE(buffer.acquire_latest(0, &data, &size) == -1);
+    }
+    
+    SECTION("acquire returns newest frame, not oldest") {
+        auto f1 = make_test_frame(100, 0x11);
+        auto f2 = make_test_frame(200, 0x22);
+        REQUIRE(buffer.push(f1.data(), f1.size(), 1000));
+        REQUIRE(buffer.push(f2.data(), f2.size(), 2000));
+        
+        int h = buffer.acquire_latest(0, &data, &size, &ts, &seq);
+        REQUIRE(h >= 0);
+        REQUIRE(size == 200);
+        REQUIRE(data[50] == 0x22);
+        REQUIRE(ts == 2000);
+        REQUIRE(seq == 2);
+        buffer.release(h);
+    }
+    
+    SECTION("acquire only returns frames newer than after_sequence") {
+        auto frame = make_test_frame(100);
+        REQUIRE(buffer.push(frame.data(), frame.size(), 1));
+        REQUIRE(buffer.push(frame.data(), frame.size(), 2));
+        
+        REQUIRE(buffer.acquire_latest(2, &data, &size) == -1);
+        REQUIRE(buffer.acquire_latest(5, &data, &size) == -1);
+        int h = buffer.acquire_latest(1, &data, &size, nullptr, &seq);
+        REQUIRE(h >= 0);
+        REQUIRE(seq == 2);
+        buffer.release(h);
+    }
+    
+    SECTION("acquire does not consume the frame") {
+        auto frame = make_test_frame(100);
+        REQUIRE(buffer.push(frame.data(), frame.size(), 1));
+        
+        int h = buffer.acquire_latest(0, &data, &size);
+        REQUIRE(h >= 0);
+        REQUIRE(buffer.available() == 1);
+        REQUIRE(buffer.peek(&data, &size, nullptr, &seq));
+        REQUIRE(seq == 1);
+        buffer.pop();
+        buffer.release(h);
+    }
+    
+    SECTION("newest frame stays readable after pop") {
+        auto frame = make_test_frame(100, 0x33);
+        REQUIRE(buffer.push(frame.data(), frame.size(), 1));
+        REQUIRE(buffer.peek(&data, &size));
+        buffer.pop();
+        REQUIRE(buffer.empty());
+        
+        int h = buffer.acquire_latest(0, &data, &size, nullptr, &seq);
+        REQUIRE(h >= 0);
+        REQUIRE(seq == 1);
+        REQUIRE(data[50] == 0x33);
+        buffer.release(h);
+    }
+    
+    SECTION("multiple readers can pin the same frame") {
+        auto frame = make_test_frame(100);
+        REQUIRE(buffer.push(frame.data(), frame.size(), 1));
+        
+        const uint8_t* data2 = nullptr;
+        int h1 = buffer.acquire_latest(0, &data, &size);
+        int h2 = buffer.acquire_latest(0, &data2, &size);
+        REQUIRE(h1 >= 0);
+        REQUIRE(h1 == h2);
+        REQUIRE(data == data2);
+        buffer.release(h1);
+        buffer.release(h2);
+    }
+    
+    SECTION("pinned slot is never overwritten") {
+        auto pinned = make_test_frame(100, 0x44);
+        auto other = make_test_frame(100, 0x55);
+        REQUIRE(buffer.push(pinned.data(), pinned.size(), 1));
+        int h = buffer.acquire_latest(0, &data, &size, nullptr, &seq);
+        REQUIRE(h >= 0);
+        
+        // Fill the ring and keep pushing: the pinned oldest slot must survive
+        for (int i = 0; i < 5; i++) {
+            REQUIRE(buffer.push(other.data(), other.size(), 2 + i));
+        }
+        REQUIRE(data[50] == 0x44);
+        REQUIRE(seq == 1);
+        REQUIRE(buffer.frames_dropped() > 0);
+        
+        // Once released, the slot is reused again
+        buffer.release(h);
+        uint32_t before = buffer.last_sequence();
+        REQUIRE(buffer.push(other.data(), other.size(), 10));
+        REQUIRE(buffer.last_sequence() == before + 1);
+    }
+    
+    SECTION("pinned slot freed by consumer is not reused") {
+        auto pinned = make_test_frame(100, 0x66);
+        auto other = make_test_frame(100, 0x77);
+        REQUIRE(buffer.push(pinned.data(), pinned.size(), 1));
+        int h = buffer.acquire_latest(0, &data, &size);
+        REQUIRE(buffer.peek(&data, &size));
+        buffer.pop();
+        
+        const uint8_t* pinned_data = nullptr;
+        REQUIRE(buffer.acquire_latest(0, &pinned_data, &size) == h);
+        for (int i = 0; i < 5; i++) {
+            REQUIRE(buffer.push(other.data(), other.size(), 2 + i));
+        }
+        REQUIRE(pinned_data[50] == 0x66);
+        buffer.release(h);
+        buffer.release(h);
+    }
+    
+    SECTION("clear forgets the newest frame") {
+        auto frame = make_test_frame(100);
+        REQUIRE(buffer.push(frame.data(), frame.size(), 1));
+        buffer.clear();
+        REQUIRE(buffer.acquire_latest(0, &data, &size) == -1);
+    }
+    
+    SECTION("invalid release is safe") {
+        buffer.release(-1);
+        buffer.release(99);
+        buffer.release(0);  // Not pinned
+    }
+}
+
 //=============================================================================
 // Thread Safety Tests
 //=============================================================================
@@ -0,0 +1,422 @@
+/**
+ * @file test_frame_history.cpp
+ * @brief Unit tests and benchmarks for FrameHistory and HistoryPlayer
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/frame_history.hpp"
+#include "../main/core/streaming_service.hpp"
+#include "mocks/mock_camera.hpp"
+#include "mocks/mock_clock.hpp"
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+using namespace core;
+using namespace mocks;
+
+// Frame whose bytes encode its sequence (to detect torn or mixed-up reads)
+static std::vector<uint8_t> make_frame(size_t size, uint32_t sequence) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<uint8_t>(sequence * 31 + i);
+    }
+    return data;
+}
+
+static bool frame_matches(const uint8_t* data, size_t size, uint32_t sequence) {
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != static_cast<uint8_t>(sequence * 31 + i)) return false;
+    }
+    return true;
+}
+
+static constexpr int64_t FRAME_US = 125 * 1000;  // 8 FPS
+
+// Append frames 1..n of the given size, FRAME_US apart
+static void fill(FrameHistory& history, uint32_t first, uint32_t last, size_t size) {
+    for (uint32_t seq = first; seq <= last; seq++) {
+        auto frame = make_frame(size, seq);
+        REQUIRE(history.append(frame.data(), frame.size(), seq * FRAME_US, seq));
+    }
+}
+
+//=============================================================================
+// Initialization Tests
+//=============================================================================
+
+TEST_CASE("FrameHistory initialization", "[history][init]") {
+    FrameHistory history;
+
+    SECTION("zero budgets fail") {
+        REQUIRE_FALSE(history.init(0, 10));
+        REQUIRE_FALSE(history.init(1024, 0));
+        REQUIRE_FALSE(history.is_initialized());
+    }
+
+    SECTION("init and deinit") {
+        REQUIRE(history.init(4096, 16, 0, false));
+        REQUIRE(history.is_initialized());
+        REQUIRE(history.frames() == 0);
+        history.deinit();
+        REQUIRE_FALSE(history.is_initialized());
+    }
+
+    SECTION("uninitialized history is inert") {
+        auto frame = make_frame(10, 1);
+        HistoryEntry e;
+        REQUIRE_FALSE(history.append(frame.data(), frame.size(), 0, 1));
+        REQUIRE_FALSE(history.find_time(0, &e));
+        REQUIRE_FALSE(history.next_after(0, &e));
+    }
+}
+
+//=============================================================================
+// Append / Eviction Tests
+//=============================================================================
+
+TEST_CASE("FrameHistory eviction", "[history][evict]") {
+    FrameHistory history;
+
+    SECTION("byte budget evicts oldest") {
+        REQUIRE(history.init(1000, 100, 0, false));
+        fill(history, 1, 10, 300);
+        REQUIRE(history.bytes_used() <= 1000);
+        REQUIRE(history.frames() == 3);
+        HistoryEntry e;
+        REQUIRE(history.next_after(0, &e));
+        REQUIRE(e.sequence == 8);
+    }
+
+    SECTION("entry budget evicts oldest") {
+        REQUIRE(history.init(100000, 4, 0, false));
+        fill(history, 1, 10, 100);
+        REQUIRE(history.frames() == 4);
+        HistoryEntry e;
+        REQUIRE(history.next_after(0, &e));
+        REQUIRE(e.sequence == 7);
+    }
+
+    SECTION("age budget evicts oldest") {
+        REQUIRE(history.init(100000, 100, 1000 * 1000, false));
+        fill(history, 1, 40, 100);  // 5 s at 8 FPS
+        REQUIRE(history.duration_us() <= 1000 * 1000);
+        REQUIRE(history.frames() == 9);
+    }
+
+    SECTION("frames stay intact across arena wrap-around") {
+        REQUIRE(history.init(1000, 100, 0, false));
+        std::vector<uint8_t> out(1000);
+        for (uint32_t seq = 1; seq <= 50; seq++) {
+            size_t size = 150 + (seq * 37) % 200;  // Varying sizes force uneven wraps
+            auto frame = make_frame(size, seq);
+            REQUIRE(history.append(frame.data(), frame.size(), seq * FRAME_US, seq));
+
+            // Every indexed frame must still read back correctly
+            HistoryEntry e;
+            uint32_t after = 0;
+            while (history.next_after(after, &e)) {
+                REQUIRE(history.read(e, out.data(), out.size()));
+                REQUIRE(frame_matches(out.data(), e.size, e.sequence));
+                after = e.sequence;
+            }
+            REQUIRE(after == seq);
+        }
+    }
+
+    SECTION("oversize and out-of-order frames are rejected") {
+        REQUIRE(history.init(1000, 100, 0, false));
+        auto big = make_frame(1001, 1);
+        REQUIRE_FALSE(history.append(big.data(), big.size(), 0, 1));
+        fill(history, 5, 5, 100);
+        auto old = make_frame(100, 4);
+        REQUIRE_FALSE(history.append(old.data(), old.size(), 6 * FRAME_US, 4));
+        REQUIRE(history.stats().rejected.load() == 2);
+    }
+}
+
+//=============================================================================
+// Lookup Tests
+//=============================================================================
+
+TEST_CASE("FrameHistory lookup", "[history][lookup]") {
+    FrameHistory history;
+    REQUIRE(history.init(100000, 100, 0, false));
+    fill(history, 1, 20, 100);
+    HistoryEntry e;
+
+    SECTION("find_time returns first frame at or after timestamp") {
+        REQUIRE(history.find_time(5 * FRAME_US, &e));
+        REQUIRE(e.sequence == 5);
+        REQUIRE(history.find_time(5 * FRAME_US + 1, &e));
+        REQUIRE(e.sequence == 6);
+    }
+
+    SECTION("find_time before history returns oldest") {
+        REQUIRE(history.find_time(-1000000, &e));
+        REQUIRE(e.sequence == 1);
+    }
+
+    SECTION("find_time past newest finds nothing") {
+        REQUIRE_FALSE(history.find_time(21 * FRAME_US, &e));
+    }
+
+    SECTION("next_after walks sequences and skips gaps") {
+        fill(history, 25, 25, 100);  // Gap 21..24
+        REQUIRE(history.next_after(19, &e));
+        REQUIRE(e.sequence == 20);
+        REQUIRE(history.next_after(20, &e));
+        REQUIRE(e.sequence == 25);
+        REQUIRE_FALSE(history.next_after(25, &e));
+    }
+
+    SECTION("read returns the frame bytes") {
+        std::vector<uint8_t> out(100);
+        REQUIRE(history.next_after(9, &e));
+        REQUIRE(history.read(e, out.data(), out.size()));
+        REQUIRE(frame_matches(out.data(), e.size, 10));
+    }
+
+    SECTION("read of evicted or oversize entry fails") {
+        std::vector<uint8_t> out(100);
+        REQUIRE(history.next_after(0, &e));
+        REQUIRE_FALSE(history.read(e, out.data(), 50));
+        HistoryEntry stale = e;
+        FrameHistory small;
+        REQUIRE(small.init(300, 100, 0, false));
+        fill(small, 1, 1, 100);
+        REQUIRE(small.next_after(0, &stale));
+        fill(small, 2, 6, 100);
+        REQUIRE_FALSE(small.read(stale, out.data(), out.size()));
+    }
+}
+
+//=============================================================================
+// Concurrency Tests
+//=============================================================================
+
+TEST_CASE("FrameHistory concurrent reader never sees torn frames", "[history][threading]") {
+    FrameHistory history;
+    REQUIRE(history.init(4000, 64, 0, false));
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> good_reads{0};
+    std::atomic<uint32_t> bad_reads{0};
+
+    std::thread producer([&] {
+        for (uint32_t seq = 1; seq <= 3000; seq++) {
+            auto frame = make_frame(300 + seq % 500, seq);
+            history.append(frame.data(), frame.size(), seq * FRAME_US, seq);
+        }
+        done = true;
+    });
+
+    std::thread reader([&] {
+        std::vector<uint8_t> out(1000);
+        uint32_t after = 0;
+        while (!done) {
+            HistoryEntry e;
+            if (!history.next_after(after, &e)) {
+                after = 0;
+                continue;
+            }
+            if (history.read(e, out.data(), out.size())) {
+                if (frame_matches(out.data(), e.size, e.sequence)) good_reads++;
+                else bad_reads++;
+            }
+            after = e.sequence;
+        }
+    });
+
+    producer.join();
+    reader.join();
+    REQUIRE(bad_reads.load() == 0);
+    REQUIRE(good_reads.load() > 0);
+}
+
+//=============================================================================
+// Playback Tests
+//=============================================================================
+
+TEST_CASE("HistoryPlayer pacing", "[history][player]") {
+    FrameHistory history;
+    REQUIRE(history.init(100000, 200, 0, false));
+    fill(history, 1, 80, 100);  // 10 s at 8 FPS, newest at 80 * FRAME_US
+
+    MockClock clock;
+    clock.set_real_sleep(false);
+    clock.set_time_ms(1000000);
+    HistoryPlayer player;
+    HistoryEntry e;
+    int64_t wait_us = 0;
+
+    SECTION("empty history cannot start") {
+        FrameHistory empty;
+        REQUIRE(empty.init(1000, 10, 0, false));
+        REQUIRE_FALSE(player.start(empty, -1000000, 1.0f, clock.now_us()));
+    }
+
+    SECTION("starts at the requested offset") {
+        REQUIRE(player.start(history, -5 * 1000 * 1000, 1.0f, clock.now_us()));
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Frame);
+        REQUIRE(e.sequence == 40);  // 80 - 5 s * 8 FPS
+    }
+
+    SECTION("offset beyond history starts at oldest") {
+        REQUIRE(player.start(history, -60 * 1000 * 1000, 1.0f, clock.now_us()));
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Frame);
+        REQUIRE(e.sequence == 1);
+    }
+
+    SECTION("real-time speed paces frames at capture spacing") {
+        REQUIRE(player.start(history, -1000 * 1000, 1.0f, clock.now_us()));
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Frame);
+        uint32_t first = e.sequence;
+
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Wait);
+        REQUIRE(wait_us == FRAME_US);
+
+        clock.advance_us(FRAME_US - 1);
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Wait);
+        clock.advance_us(1);
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Frame);
+        REQUIRE(e.sequence == first + 1);
+    }
+
+    SECTION("accelerated speed shortens waits") {
+        REQUIRE(player.start(history, -1000 * 1000, 4.0f, clock.now_us()));
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Frame);
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Wait);
+        REQUIRE(wait_us == FRAME_US / 4);
+    }
+
+    SECTION("every frame is played once, in order, then Live") {
+        REQUIRE(player.start(history, -2 * 1000 * 1000, 2.0f, clock.now_us()));
+        std::vector<uint32_t> played;
+        for (int i = 0; i < 1000; i++) {
+            auto step = player.poll(clock.now_us(), &e, &wait_us);
+            if (step == HistoryPlayer::Step::Live) break;
+            if (step == HistoryPlayer::Step::Frame) played.push_back(e.sequence);
+            else clock.advance_us(wait_us);
+        }
+        REQUIRE(played.size() == 17);  // 64..80
+        for (size_t i = 0; i < played.size(); i++) {
+            REQUIRE(played[i] == 64 + i);
+        }
+        REQUIRE(player.last_sequence() == 80);
+    }
+
+    SECTION("frames appended during playback are picked up") {
+        REQUIRE(player.start(history, 0, 1.0f, clock.now_us()));
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Frame);
+        REQUIRE(e.sequence == 80);
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Live);
+    }
+
+    SECTION("timeline gaps are skipped instead of waited out") {
+        fill(history, 200, 200, 100);  // ~15 s after frame 80
+        REQUIRE(player.start(history, -125 * 1000, 1.0f, clock.now_us()));
+        REQUIRE(player.poll(clock.now_us(), &e, &wait_us) == HistoryPlayer::Step::Frame);
+        REQUIRE(e.sequence == 200);
+    }
+}
+
+TEST_CASE("HistoryPlayer hands over to live ring without gaps", "[history][player][integration]") {
+    MockCamera camera;
+    MockClock clock;
+    camera.init({});
+    clock.set_auto_advance_us(1000);
+    // Keep the producer slow enough that history is not evicted mid-test
+    camera.set_capture_delay_callback([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    });
+
+    StreamingService svc(camera, clock);
+    REQUIRE(svc.init({.target_fps = 30}));
+    FrameHistory history;
+    REQUIRE(history.init(200000, 256, 0, false));
+    REQUIRE(svc.add_sink(&history));
+    REQUIRE(svc.start());
+
+    for (int i = 0; i < 200 && svc.last_sequence() < 10; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(svc.last_sequence() >= 10);
+
+    // Replay as fast as possible, then continue on the live ring
+    HistoryPlayer player;
+    REQUIRE(player.start(history, -1000 * 1000 * 1000, 8.0f, 0));
+    std::vector<uint32_t> replayed;
+    HistoryEntry e;
+    int64_t wait_us = 0;
+    int64_t wall = 0;
+    while (true) {
+        auto step = player.poll(wall, &e, &wait_us);
+        if (step == HistoryPlayer::Step::Live) break;
+        if (step == HistoryPlayer::Step::Frame) replayed.push_back(e.sequence);
+        else wall += wait_us;
+    }
+    REQUIRE(replayed.front() == 1);
+    for (size_t i = 1; i < replayed.size(); i++) {
+        REQUIRE(replayed[i] == replayed[i - 1] + 1);  // Every recorded frame, once
+    }
+
+    std::vector<uint32_t> seen = replayed;
+    uint32_t last = player.last_sequence();
+    for (int i = 0; i < 3; i++) {
+        const uint8_t* data; size_t size; uint32_t seq = 0;
+        int h = svc.acquire_frame_after(last, &data, &size, 2000, nullptr, &seq);
+        REQUIRE(h >= 0);
+        svc.release_acquired_frame(h);
+        seen.push_back(seq);
+        last = seq;
+    }
+    svc.stop();
+
+    for (size_t i = replayed.size(); i < seen.size(); i++) {
+        REQUIRE(seen[i] > seen[i - 1]);  // Live continues after replay, nothing repeated
+    }
+}
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+TEST_CASE("FrameHistory seek latency and memory", "[.][benchmark][history]") {
+    constexpr size_t FRAME_SIZE = 25 * 1024;  // Typical VGA JPEG at quality 12
+    constexpr uint32_t FPS = 8;
+    constexpr uint32_t SECONDS = 30;
+    FrameHistory history;
+    REQUIRE(history.init(FRAME_SIZE * FPS * SECONDS, FPS * SECONDS + 1, 0, false));
+    auto frame = make_frame(FRAME_SIZE, 0);
+    for (uint32_t seq = 1; seq <= FPS * SECONDS; seq++) {
+        history.append(frame.data(), frame.size(), seq * (1000000 / FPS), seq);
+    }
+
+    double seconds = static_cast<double>(history.duration_us()) / 1e6;
+    double bytes_per_second = (static_cast<double>(history.bytes_used()) +
+                               history.frames() * sizeof(HistoryEntry)) / seconds;
+    WARN("History: " << history.frames() << " frames over " << seconds << " s, "
+         << bytes_per_second / 1024.0 << " KB per retained second (frames + index)");
+
+    std::vector<uint8_t> out(FRAME_SIZE);
+    int64_t target = 0;
+    BENCHMARK("seek by timestamp (binary search)") {
+        HistoryEntry e;
+        target = (target + 7919 * 1000) % history.duration_us();
+        return history.find_time(target, &e);
+    };
+
+    BENCHMARK("seek + first frame copy-out") {
+        HistoryEntry e;
+        target = (target + 7919 * 1000) % history.duration_us();
+        history.find_time(target, &e);
+        return history.read(e, out.data(), out.size());
+    };
+
+    BENCHMARK("append (producer cost)") {
+        static uint32_t seq = FPS * SECONDS;
+        seq++;
+        return history.append(frame.data(), frame.size(), seq * (1000000 / FPS), seq);
+    };
+}
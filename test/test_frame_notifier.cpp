@@ -0,0 +1,272 @@
+/**
+ * @file test_frame_notifier.cpp
+ * @brief Unit tests for FrameNotifier and the StreamingService wakeup path
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/frame_notifier.hpp"
+#include "../main/core/streaming_service.hpp"
+#include "mocks/mock_camera.hpp"
+#include "mocks/mock_clock.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace mocks;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t elapsed_us(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count();
+}
+
+// Holds the producer inside capture_frame() once `allowed` frames have been taken
+struct CaptureGate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int allowed = 0;
+    int taken = 0;
+    bool open = false;
+
+    void on_capture() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return open || taken < allowed; });
+        taken++;
+    }
+
+    void release() {
+        { std::lock_guard<std::mutex> lock(mutex); open = true; }
+        cv.notify_all();
+    }
+};
+
+// Publish-to-wake latencies (us) of a waiter on another thread
+std::vector<int64_t> measure_wake_latency(FrameNotifier& notifier, int rounds) {
+    std::atomic<uint32_t> published{0};
+    std::atomic<int64_t> publish_at{0};
+    std::vector<int64_t> latencies;
+    std::atomic<size_t> woken{0};
+    auto origin = Clock::now();
+
+    std::thread waiter([&] {
+        for (int i = 1; i <= rounds; i++) {
+            uint32_t want = static_cast<uint32_t>(i);
+            if (!notifier.wait([&] { return published.load() >= want; }, 1000)) return;
+            latencies.push_back(elapsed_us(origin) - publish_at.load());
+            woken = latencies.size();
+        }
+    });
+    for (int i = 1; i <= rounds; i++) {
+        // Let the waiter get to sleep most of the time
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        publish_at = elapsed_us(origin);
+        published = static_cast<uint32_t>(i);
+        notifier.publish();
+        while (woken.load() < static_cast<size_t>(i) && elapsed_us(origin) - publish_at.load() < 1000000) {
+            std::this_thread::yield();
+        }
+    }
+    waiter.join();
+    return latencies;
+}
+
+} // namespace
+
+//=============================================================================
+// FrameNotifier
+//=============================================================================
+
+TEST_CASE("FrameNotifier waits", "[notifier]") {
+    FrameNotifier notifier;
+
+    SECTION("a true condition returns without sleeping") {
+        CHECK(notifier.wait([] { return true; }, 1000));
+        CHECK(notifier.stats().ready_on_entry == 1);
+        CHECK(notifier.stats().wakeups == 0);
+    }
+
+    SECTION("a false condition times out, or is checked once with no timeout") {
+        auto start = Clock::now();
+        CHECK_FALSE(notifier.wait([] { return false; }, 20));
+        CHECK(elapsed_us(start) >= 20000);
+        CHECK_FALSE(notifier.wait([] { return false; }, 0));
+        CHECK(notifier.stats().timeouts == 1);
+    }
+
+    SECTION("a publish between the check and the sleep is not lost") {
+        // The 'producer' commits and publishes right after the waiter's check
+        // said no: exactly the window a binary semaphore or a pulsed bit loses
+        bool committed = false;
+        int checks = 0;
+        auto start = Clock::now();
+        bool ok = notifier.wait([&] {
+            checks++;
+            if (!committed) {
+                committed = true;
+                notifier.publish();
+                return false;
+            }
+            return true;
+        }, 1000);
+        CHECK(ok);
+        CHECK(checks == 2);
+        CHECK(elapsed_us(start) < 100000);
+        CHECK(notifier.stats().timeouts == 0);
+    }
+
+    SECTION("publishes that do not satisfy the condition keep the waiter asleep") {
+        std::atomic<int> frames{0};
+        std::thread producer([&] {
+            for (int i = 0; i < 3; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                frames++;
+                notifier.publish();
+            }
+        });
+        CHECK(notifier.wait([&] { return frames.load() >= 3; }, 2000));
+        producer.join();
+        CHECK(notifier.stats().publishes == 3);
+        CHECK(notifier.stats().wakeups + notifier.stats().ready_on_entry == 1);
+    }
+
+    SECTION("every waiter wakes on one publish") {
+        std::atomic<bool> ready{false};
+        std::atomic<int> woken{0};
+        std::vector<std::thread> waiters;
+        for (int i = 0; i < 4; i++) {
+            waiters.emplace_back([&] {
+                if (notifier.wait([&] { return ready.load(); }, 2000)) woken++;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ready = true;
+        notifier.publish();
+        for (auto& t : waiters) t.join();
+        CHECK(woken == 4);
+    }
+
+    SECTION("wake latency is scheduling time, not a timeout") {
+        auto latencies = measure_wake_latency(notifier, 200);
+        REQUIRE(latencies.size() == 200);
+        std::sort(latencies.begin(), latencies.end());
+        CHECK(latencies[100] < 5000);       // Median under 5 ms even on a loaded CI box
+        CHECK(latencies.back() < 500000);   // Never the 1 s timeout
+        CHECK(notifier.stats().timeouts == 0);
+    }
+}
+
+//=============================================================================
+// StreamingService: frames committed while nobody waits
+//=============================================================================
+
+TEST_CASE("StreamingService never sleeps through buffered frames", "[notifier][streaming]") {
+    MockCamera camera;
+    MockClock clock;
+    clock.set_auto_advance_us(1000);
+    REQUIRE(camera.init({}));
+    CaptureGate gate;
+    gate.allowed = 2;
+    camera.set_capture_delay_callback([&gate] { gate.on_capture(); });
+
+    StreamingService svc(camera, clock);
+    StreamingConfig config;
+    config.target_fps = 30;
+    config.buffer_slots = 3;
+    REQUIRE(svc.init(config));
+    REQUIRE(svc.start());
+
+    // Two commits before the consumer ever waits; the producer then stalls
+    // in capture, so nothing else will wake the consumer
+    for (int i = 0; i < 2000 && svc.buffered_frames() < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(svc.buffered_frames() == 2);
+
+    const uint8_t* data;
+    size_t size;
+    uint32_t sequence = 0;
+    for (uint32_t expected = 1; expected <= 2; expected++) {
+        auto start = Clock::now();
+        REQUIRE(svc.get_frame(&data, &size, 500, nullptr, &sequence));
+        int64_t wait_us = elapsed_us(start);
+        INFO("frame " << expected << " waited " << wait_us << " us");
+        CHECK(sequence == expected);
+        CHECK(wait_us < 100000);   // Not the 500 ms timeout
+        svc.release_frame();
+    }
+
+    // Ring empty: now the wait is real
+    CHECK_FALSE(svc.get_frame(&data, &size, 20));
+    CHECK(svc.notifier_stats().timeouts == 1);
+
+    // And a commit wakes it
+    bool ok = false;
+    int64_t wait_us = 0;
+    std::thread consumer([&] {
+        auto start = Clock::now();
+        ok = svc.get_frame(&data, &size, 2000, nullptr, &sequence);
+        wait_us = elapsed_us(start);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate.release();
+    consumer.join();
+    CHECK(ok);
+    CHECK(wait_us < 1500000);
+    CHECK(sequence == 3);
+    svc.release_frame();
+
+    svc.stop();
+    CHECK(svc.notifier_stats().ready_on_entry >= 2);
+}
+
+TEST_CASE("StreamingService stop wakes waiters", "[notifier][streaming]") {
+    MockCamera camera;
+    MockClock clock;
+    REQUIRE(camera.init({}));
+    CaptureGate gate;   // Never opened: no frames
+    camera.set_capture_delay_callback([&gate] { gate.on_capture(); });
+    StreamingService svc(camera, clock);
+    REQUIRE(svc.init());
+    REQUIRE(svc.start());
+
+    std::atomic<bool> done{false};
+    int handle = 0;
+    std::thread poller([&] {
+        const uint8_t* data;
+        size_t size;
+        handle = svc.acquire_frame_after(0, &data, &size, 5000);
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto start = Clock::now();
+    std::thread stopper([&] { svc.stop(); });
+    while (!done && elapsed_us(start) < 3000000) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(done);
+    CHECK(elapsed_us(start) < 1000000);
+    gate.release();
+    stopper.join();
+    poller.join();
+    CHECK(handle == -1);
+}
+
+//=============================================================================
+// Benchmarks
+//=============================================================================
+
+TEST_CASE("FrameNotifier wake latency", "[.][benchmark][notifier]") {
+    FrameNotifier notifier;
+    auto latencies = measure_wake_latency(notifier, 2000);
+    REQUIRE_FALSE(latencies.empty());
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](size_t p) { return latencies[latencies.size() * p / 100 - (p == 100)]; };
+    printf("FrameNotifier publish->wake: p50=%lld us p99=%lld us max=%lld us (%zu wakes)\n",
+           static_cast<long long>(pct(50)), static_cast<long long>(pct(99)),
+           static_cast<long long>(pct(100)), latencies.size());
+}
@@ -0,0 +1,515 @@
+/**
+ * @file test_image_quality.cpp
+ * @brief Unit tests for ImageQualityAnalyzer, QualityAlerts and QualityMonitor
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/image_quality.hpp"
+#include "../main/core/jpeg_encoder.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace fixtures;
+
+namespace {
+
+struct Scene {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    std::vector<uint8_t> luma;
+
+    double mean() const {
+        double sum = 0;
+        for (uint8_t v : luma) sum += v;
+        return sum / luma.size();
+    }
+};
+
+// Gradient plus overlapping flat rectangles: hard edges at many scales
+Scene make_scene(uint16_t width, uint16_t height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<float> f(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) f[y * width + x] = 60.0f + 80.0f * x / width + 40.0f * y / height;
+    }
+    for (int i = 0; i < 120; i++) {
+        int x0 = rng() % width, y0 = rng() % height;
+        int w = 8 + rng() % 80, h = 8 + rng() % 80;
+        float delta = static_cast<float>(static_cast<int>(rng() % 120) - 60);
+        for (int y = y0; y < std::min<int>(height, y0 + h); y++) {
+            for (int x = x0; x < std::min<int>(width, x0 + w); x++) f[y * width + x] += delta;
+        }
+    }
+    Scene s{width, height, std::vector<uint8_t>(f.size())};
+    for (size_t i = 0; i < f.size(); i++) s.luma[i] = static_cast<uint8_t>(std::clamp(f[i], 0.0f, 255.0f));
+    return s;
+}
+
+Scene make_flat(uint16_t width, uint16_t height, uint8_t level) {
+    return Scene{width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height, level)};
+}
+
+// Three box passes (close to a Gaussian): a lens out of focus
+Scene defocus(const Scene& in, int radius) {
+    Scene out = in;
+    if (radius == 0) return out;
+    std::vector<int> tmp(in.luma.size());
+    int w = in.width, h = in.height;
+    for (int pass = 0; pass < 3; pass++) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                int sum = 0;
+                for (int d = -radius; d <= radius; d++) sum += out.luma[y * w + std::clamp(x + d, 0, w - 1)];
+                tmp[y * w + x] = sum / (2 * radius + 1);
+            }
+        }
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                int sum = 0;
+                for (int d = -radius; d <= radius; d++) sum += tmp[std::clamp(y + d, 0, h - 1) * w + x];
+                out.luma[y * w + x] = static_cast<uint8_t>(sum / (2 * radius + 1));
+            }
+        }
+    }
+    return out;
+}
+
+// Gain/offset (fog, glare, darkness) plus Gaussian noise, clipped
+Scene remap(const Scene& in, float gain, float offset, float sigma = 0, uint32_t seed = 1) {
+    Scene out = in;
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, sigma > 0 ? sigma : 1.0f);
+    for (auto& v : out.luma) {
+        float f = v * gain + offset + (sigma > 0 ? noise(rng) : 0.0f);
+        v = static_cast<uint8_t>(std::clamp(f, 0.0f, 255.0f));
+    }
+    return out;
+}
+
+std::vector<uint8_t> encode(const Scene& s, int quality = 85, bool color = false) {
+    JpegEncoder encoder;
+    encoder.set_quality(quality);
+    std::vector<uint8_t> pixels;
+    PixelFormat format = PixelFormat::Grayscale;
+    if (color) {
+        // YUYV with neutral chroma: the 4:2:2 layout the sensor produces
+        format = PixelFormat::Yuv422;
+        pixels.resize(s.luma.size() * 2);
+        for (size_t i = 0; i < s.luma.size(); i++) {
+            pixels[i * 2] = s.luma[i];
+            pixels[i * 2 + 1] = 128;
+        }
+    } else {
+        pixels = s.luma;
+    }
+    std::vector<uint8_t> out(s.luma.size() * 3 + 4096);
+    size_t n = encoder.encode(pixels.data(), pixels.size(), s.width, s.height, format, out.data(), out.size());
+    out.resize(n);
+    return out;
+}
+
+ImageQualityMetrics analyze(const std::vector<uint8_t>& jpeg, const ImageQualityConfig& config = {}) {
+    static ImageQualityAnalyzer analyzer;   // Codec tables, off the stack
+    analyzer.set_config(config);
+    ImageQualityMetrics m;
+    REQUIRE(analyzer.analyze(jpeg.data(), jpeg.size(), &m));
+    return m;
+}
+
+struct AlertLog {
+    std::vector<uint8_t> changes;
+
+    static void on_alert(void* context, uint8_t alerts, const ImageQualityMetrics&) {
+        static_cast<AlertLog*>(context)->changes.push_back(alerts);
+    }
+};
+
+bool wait_analyzed(const QualityMonitor& monitor, uint32_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (monitor.stats().frames_analyzed.load() + monitor.stats().decode_errors.load() < count) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace
+
+//=============================================================================
+// Exposure Tests
+//=============================================================================
+
+TEST_CASE("ImageQualityAnalyzer exposure and contrast", "[quality][exposure]") {
+    Scene scene = make_scene(320, 240, 1);
+
+    SECTION("mean luma and histogram follow the pixels") {
+        ImageQualityMetrics m = analyze(encode(scene));
+        CHECK(m.blocks == 40 * 30);
+        CHECK(std::abs(m.mean_luma - scene.mean()) < 2.0);
+        uint32_t total = 0;
+        for (uint32_t bin : m.histogram) total += bin;
+        CHECK(total == m.blocks);
+        CHECK(m.contrast > 25);
+        CHECK(m.dark_pct < 5);
+        CHECK(m.bright_pct < 5);
+
+        ImageQualityMetrics flat = analyze(encode(make_flat(320, 240, 128)));
+        CHECK(flat.mean_luma == 128);
+        CHECK(flat.contrast == 0);
+        CHECK(flat.histogram[8] == flat.blocks);
+    }
+
+    SECTION("glare, darkness and fog") {
+        ImageQualityMetrics glare = analyze(encode(remap(scene, 3.0f, 0.0f)));
+        CHECK(glare.bright_pct > 60);
+        CHECK(glare.mean_luma > 230);
+
+        ImageQualityMetrics dark = analyze(encode(remap(scene, 0.08f, 0.0f)));
+        CHECK(dark.dark_pct > 90);
+        CHECK(dark.mean_luma < 16);
+
+        ImageQualityMetrics fog = analyze(encode(remap(scene, 0.2f, 150.0f)));
+        CHECK(fog.contrast < 12);
+        CHECK(fog.mean_luma > 160);
+        CHECK(fog.bright_pct == 0);
+    }
+
+    SECTION("4:2:2 frames and partial edge MCUs count luma blocks only") {
+        Scene odd = make_scene(100, 60, 2);
+        ImageQualityMetrics gray = analyze(encode(odd));
+        ImageQualityMetrics color = analyze(encode(odd, 85, true));
+        CHECK(gray.blocks == 13 * 8);
+        CHECK(color.blocks == 13 * 8);
+        CHECK(color.mean_luma == gray.mean_luma);
+        CHECK(std::abs(static_cast<int>(color.sharpness) - gray.sharpness) < 20);
+    }
+}
+
+//=============================================================================
+// Sharpness Tests
+//=============================================================================
+
+TEST_CASE("ImageQualityAnalyzer sharpness", "[quality][sharpness]") {
+    const int radii[] = {0, 1, 2, 3, 5};
+
+    SECTION("falls with defocus on every scene, contrast does not") {
+        for (uint32_t seed = 1; seed <= 4; seed++) {
+            Scene scene = make_scene(320, 240, seed);
+            uint16_t previous = UINT16_MAX;
+            uint16_t sharp_contrast = 0;
+            for (int radius : radii) {
+                ImageQualityMetrics m = analyze(encode(defocus(scene, radius)));
+                CHECK(m.sharpness < previous);
+                previous = m.sharpness;
+                if (radius == 0) {
+                    sharp_contrast = m.contrast;
+                    CHECK(m.sharpness > 250);
+                } else {
+                    CHECK(m.sharpness < QualityThresholds{}.min_sharpness);
+                    CHECK(m.contrast + sharp_contrast / 8 >= sharp_contrast);   // Same scene, only softer
+                }
+            }
+        }
+    }
+
+    SECTION("independent of the scene's contrast") {
+        Scene scene = make_scene(320, 240, 3);
+        ImageQualityMetrics full = analyze(encode(scene, 95));
+        ImageQualityMetrics half = analyze(encode(remap(scene, 0.5f, 64.0f), 95));
+        CHECK(std::abs(static_cast<int>(full.sharpness) - half.sharpness) < 60);
+        CHECK(half.contrast * 2 <= full.contrast + 2);
+    }
+
+    SECTION("noise does not pass for detail") {
+        Scene blurred = defocus(make_scene(320, 240, 1), 3);
+        ImageQualityMetrics clean = analyze(encode(blurred));
+        ImageQualityMetrics noisy = analyze(encode(remap(blurred, 1.0f, 0.0f, 4.0f)));
+        CHECK(noisy.noise > 20);
+        CHECK(noisy.sharpness < QualityThresholds{}.min_sharpness);
+        CHECK(noisy.sharpness < clean.sharpness + 40);
+    }
+
+#ifdef HAVE_LIBJPEG
+    SECTION("ranks frames like pixel-domain Laplacian variance") {
+        // Reference: variance of the 4-neighbour Laplacian of the decoded frame
+        auto laplacian_variance = [](const std::vector<uint8_t>& jpeg) {
+            DecodedImage img;
+            REQUIRE(decode_jpeg(jpeg.data(), jpeg.size(), &img));
+            double sum = 0, sq = 0;
+            size_t n = 0;
+            for (int y = 1; y < img.height - 1; y++) {
+                for (int x = 1; x < img.width - 1; x++) {
+                    double l = 4.0 * img.at(x, y)[0] - img.at(x - 1, y)[0] - img.at(x + 1, y)[0] -
+                               img.at(x, y - 1)[0] - img.at(x, y + 1)[0];
+                    sum += l;
+                    sq += l * l;
+                    n++;
+                }
+            }
+            return sq / n - (sum / n) * (sum / n);
+        };
+        Scene scene = make_scene(320, 240, 2);
+        std::vector<std::pair<double, uint16_t>> samples;
+        for (int radius : radii) {
+            std::vector<uint8_t> jpeg = encode(defocus(scene, radius));
+            samples.push_back({laplacian_variance(jpeg), analyze(jpeg).sharpness});
+        }
+        std::sort(samples.begin(), samples.end());
+        for (size_t i = 1; i < samples.size(); i++) {
+            CHECK(samples[i].second > samples[i - 1].second);
+        }
+    }
+#endif
+}
+
+//=============================================================================
+// Noise Tests
+//=============================================================================
+
+TEST_CASE("ImageQualityAnalyzer noise estimate", "[quality][noise]") {
+    Scene scene = make_scene(320, 240, 1);
+
+    SECTION("tracks added noise at high quality") {
+        CHECK(analyze(encode(scene, 95)).noise < 5);
+        uint16_t previous = 0;
+        for (float sigma : {4.0f, 8.0f, 16.0f}) {
+            ImageQualityMetrics m = analyze(encode(remap(scene, 1.0f, 0.0f, sigma), 95));
+            double estimate = m.noise / 10.0;
+            CHECK(estimate > sigma * 0.7);
+            CHECK(estimate < sigma * 1.4);
+            CHECK(m.noise > previous);
+            previous = m.noise;
+        }
+    }
+
+    SECTION("quantization hides faint noise") {
+        Scene faint = remap(scene, 1.0f, 0.0f, 2.0f);
+        CHECK(analyze(encode(faint, 75)).noise < analyze(encode(faint, 95)).noise);
+    }
+}
+
+//=============================================================================
+// Partial Decode Tests
+//=============================================================================
+
+TEST_CASE("ImageQualityAnalyzer partial decode", "[quality][partial]") {
+    SyntheticJpegSpec spec;
+    spec.width = 640;
+    spec.height = 480;
+    spec.restart_interval = 40;   // One MCU row
+    std::vector<uint8_t> jpeg = make_synthetic_jpeg(spec);
+
+    SECTION("interval_step decodes a share of the restart intervals") {
+        ImageQualityMetrics all = analyze(jpeg);
+        ImageQualityMetrics half = analyze(jpeg, {.interval_step = 2});
+        ImageQualityMetrics quarter = analyze(jpeg, {.interval_step = 4});
+        CHECK(all.blocks == 80 * 60);
+        CHECK(half.blocks == all.blocks / 2);
+        CHECK(quarter.blocks == all.blocks / 4);
+        CHECK(std::abs(static_cast<int>(half.mean_luma) - all.mean_luma) <= 3);
+        CHECK(std::abs(static_cast<int>(quarter.mean_luma) - all.mean_luma) <= 5);
+    }
+
+    SECTION("interval_step is ignored without restart markers") {
+        std::vector<uint8_t> plain = encode(make_scene(320, 240, 1));
+        CHECK(analyze(plain, {.interval_step = 4}).blocks == 40 * 30);
+    }
+
+    SECTION("truncated or foreign data is rejected") {
+        ImageQualityAnalyzer analyzer;
+        ImageQualityMetrics m;
+        CHECK_FALSE(analyzer.analyze(jpeg.data(), jpeg.size() / 2, &m));
+        std::vector<uint8_t> garbage(1000, 0x55);
+        CHECK_FALSE(analyzer.analyze(garbage.data(), garbage.size(), &m));
+        CHECK_FALSE(analyzer.analyze(jpeg.data(), jpeg.size(), nullptr));
+    }
+}
+
+//=============================================================================
+// Alert Tests
+//=============================================================================
+
+TEST_CASE("QualityAlerts debounce", "[quality][alerts]") {
+    ImageQualityMetrics good;
+    good.sharpness = 300;
+    good.contrast = 30;
+    good.mean_luma = 120;
+    ImageQualityMetrics blurred = good;
+    blurred.sharpness = 20;
+    ImageQualityMetrics blinded = good;
+    blinded.bright_pct = 90;
+
+    SECTION("a run of samples raises and clears an alert") {
+        QualityAlerts alerts({}, 3);
+        CHECK_FALSE(alerts.update(blurred));
+        CHECK_FALSE(alerts.update(blurred));
+        CHECK(alerts.update(blurred));
+        CHECK(alerts.active() == QUALITY_ALERT_BLUR);
+        CHECK_FALSE(alerts.update(blurred));
+        CHECK_FALSE(alerts.update(good));
+        CHECK_FALSE(alerts.update(good));
+        CHECK(alerts.update(good));
+        CHECK(alerts.active() == 0);
+    }
+
+    SECTION("interrupted runs never fire") {
+        QualityAlerts alerts({}, 3);
+        for (int i = 0; i < 20; i++) {
+            CHECK_FALSE(alerts.update(i % 3 == 2 ? good : blurred));
+        }
+        CHECK(alerts.active() == 0);
+    }
+
+    SECTION("alerts are independent") {
+        QualityAlerts alerts({}, 2);
+        ImageQualityMetrics both = blurred;
+        both.bright_pct = 90;
+        alerts.update(both);
+        CHECK(alerts.update(both));
+        CHECK(alerts.active() == (QUALITY_ALERT_BLUR | QUALITY_ALERT_OVEREXPOSED));
+        alerts.update(blinded);
+        CHECK(alerts.update(blinded));
+        CHECK(alerts.active() == QUALITY_ALERT_OVEREXPOSED);
+    }
+
+    SECTION("zero thresholds disable checks") {
+        QualityThresholds off{.min_sharpness = 0, .min_contrast = 0, .max_bright_pct = 0,
+                              .max_dark_pct = 0, .max_noise = 0};
+        ImageQualityMetrics awful;
+        awful.dark_pct = 100;
+        awful.noise = 500;
+        CHECK(QualityAlerts::violations(awful, off) == 0);
+        CHECK(QualityAlerts::violations(awful, {}) ==
+              (QUALITY_ALERT_BLUR | QUALITY_ALERT_LOW_CONTRAST | QUALITY_ALERT_UNDEREXPOSED));
+        CHECK(QualityAlerts::violations(awful, {.max_noise = 80}) & QUALITY_ALERT_NOISE);
+    }
+
+    SECTION("JSON event") {
+        ImageQualityMetrics m = blurred;
+        m.noise = 37;
+        m.bright_pct = 90;
+        char json[256];
+        size_t len = format_quality_json(m, QUALITY_ALERT_BLUR | QUALITY_ALERT_OVEREXPOSED, json, sizeof(json));
+        REQUIRE(len > 0);
+        CHECK(std::string(json, len) ==
+              "{\"type\":\"quality\",\"sharpness\":20,\"contrast\":30,\"noise\":3.7,\"mean_luma\":120,"
+              "\"dark_pct\":0,\"bright_pct\":90,\"alerts\":[\"blur\",\"overexposed\"]}");
+        CHECK(format_quality_json(m, 0, json, sizeof(json)) > 0);
+        CHECK(std::string(json).find("\"alerts\":[]}") != std::string::npos);
+        CHECK(format_quality_json(m, 0, json, 40) == 0);
+    }
+}
+
+//=============================================================================
+// Monitor Tests
+//=============================================================================
+
+TEST_CASE("QualityMonitor samples replayed frames", "[quality][monitor]") {
+    Scene scene = make_scene(320, 240, 4);
+    std::vector<uint8_t> sharp = encode(scene, 85, true);
+    std::vector<uint8_t> soft = encode(defocus(scene, 3), 85, true);
+
+    static QualityMonitor monitor;
+    AlertLog log;
+    QualityMonitorConfig config;
+    config.max_frame_size = 64 * 1024;
+    config.sample_interval = 3;
+    config.alert_samples = 3;
+    REQUIRE(monitor.init(config, false));
+    monitor.set_alert_callback(&AlertLog::on_alert, &log);
+    REQUIRE(monitor.start());
+
+    SECTION("defocus raises one alert, refocus clears it") {
+        // 30 sharp, 30 defocused, 30 sharp frames: 10 samples each
+        uint32_t sampled = 0;
+        for (int i = 0; i < 90; i++) {
+            const std::vector<uint8_t>& frame = i >= 30 && i < 60 ? soft : sharp;
+            monitor.on_frame(frame.data(), frame.size(), i * 100000, i);
+            if (i % 3 == 0) REQUIRE(wait_analyzed(monitor, ++sampled));
+        }
+        const auto& stats = monitor.stats();
+        CHECK(stats.frames_seen == 90);
+        CHECK(stats.frames_analyzed == 30);
+        CHECK(stats.frames_superseded == 0);
+        CHECK(stats.alerts_raised == 1);
+        REQUIRE(log.changes.size() == 2);
+        CHECK(log.changes[0] == QUALITY_ALERT_BLUR);
+        CHECK(log.changes[1] == 0);
+        CHECK(monitor.alerts() == 0);
+        CHECK(stats.sharpness > 250);
+        CHECK(stats.analyze_us_max >= stats.analyze_us_mean());
+
+        ImageQualityMetrics latest;
+        REQUIRE(monitor.latest(&latest));
+        CHECK(latest.blocks == 40 * 30);
+        CHECK(latest.sharpness == stats.sharpness);
+    }
+
+    SECTION("oversized and undecodable frames are counted, not analysed") {
+        std::vector<uint8_t> huge(config.max_frame_size + 1, 0xFF);
+        std::vector<uint8_t> garbage(1000, 0x55);
+        monitor.on_frame(huge.data(), huge.size(), 0, 0);
+        monitor.on_frame(sharp.data(), sharp.size(), 1, 1);   // Frames 1 and 2 are not samples
+        monitor.on_frame(sharp.data(), sharp.size(), 2, 2);
+        monitor.on_frame(garbage.data(), garbage.size(), 3, 3);
+        REQUIRE(wait_analyzed(monitor, 1));
+        CHECK(monitor.stats().frames_rejected == 1);
+        CHECK(monitor.stats().decode_errors == 1);
+        CHECK(monitor.stats().frames_analyzed == 0);
+        CHECK_FALSE(monitor.latest(nullptr));
+    }
+
+    monitor.deinit();
+}
+
+//=============================================================================
+// Benchmarks
+//=============================================================================
+
+TEST_CASE("ImageQualityAnalyzer cost per frame", "[.][benchmark][quality]") {
+    static ImageQualityAnalyzer analyzer;
+    ImageQualityMetrics m;
+    std::vector<uint8_t> vga = encode(make_scene(640, 480, 1), 85, true);
+    std::vector<uint8_t> uxga = encode(make_scene(1600, 1200, 1), 85, true);
+    SyntheticJpegSpec spec;
+    spec.restart_interval = 40;
+    std::vector<uint8_t> restart = make_synthetic_jpeg(spec);
+
+    BENCHMARK("VGA 4:2:2 analyze") {
+        return analyzer.analyze(vga.data(), vga.size(), &m);
+    };
+    BENCHMARK("UXGA 4:2:2 analyze") {
+        return analyzer.analyze(uxga.data(), uxga.size(), &m);
+    };
+    BENCHMARK("VGA restart rows, every interval") {
+        analyzer.set_config({});
+        return analyzer.analyze(restart.data(), restart.size(), &m);
+    };
+    BENCHMARK("VGA restart rows, interval_step = 4") {
+        analyzer.set_config({.interval_step = 4});
+        return analyzer.analyze(restart.data(), restart.size(), &m);
+    };
+    analyzer.set_config({});
+#ifdef HAVE_LIBJPEG
+    BENCHMARK("VGA 4:2:2 full libjpeg decode (reference)") {
+        DecodedImage img;
+        return decode_jpeg(vga.data(), vga.size(), &img);
+    };
+#endif
+
+    // Accuracy at a glance: defocus radius vs sharpness on one scene
+    Scene scene = make_scene(640, 480, 5);
+    for (int radius : {0, 1, 2, 3, 5}) {
+        std::vector<uint8_t> jpeg = encode(defocus(scene, radius), 85, true);
+        analyzer.analyze(jpeg.data(), jpeg.size(), &m);
+        WARN("defocus radius " << radius << ": sharpness " << m.sharpness << " contrast " << m.contrast);
+    }
+}
@@ -0,0 +1,200 @@
+/**
+ * @file test_jpeg_codec.cpp
+ * @brief Unit tests for the coefficient-domain JPEG codec
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/jpeg_codec.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <vector>
+#include <cstring>
+
+using namespace core;
+using namespace fixtures;
+
+//=============================================================================
+// Header Parsing Tests
+//=============================================================================
+
+TEST_CASE("JPEG header parsing", "[jpeg][parse]") {
+    SECTION("parses 4:2:2 colour frame") {
+        auto jpg = make_synthetic_jpeg({.width = 640, .height = 480});
+        JpegInfo info;
+        REQUIRE(jpeg_parse(jpg.data(), jpg.size(), &info));
+        REQUIRE(info.width == 640);
+        REQUIRE(info.height == 480);
+        REQUIRE(info.num_components == 3);
+        REQUIRE(info.mcu_width == 16);
+        REQUIRE(info.mcu_height == 8);
+        REQUIRE(info.blocks_per_mcu == 4);
+        REQUIRE(info.mcus_x == 40);
+        REQUIRE(info.mcus_y == 60);
+        REQUIRE(info.quant_present[0]);
+        REQUIRE(info.quant_present[1]);
+        REQUIRE(info.scan_offset > 0);
+        REQUIRE(info.scan_offset + info.scan_size + 2 == jpg.size());
+    }
+
+    SECTION("parses grayscale frame with partial MCUs") {
+        auto jpg = make_synthetic_jpeg({.width = 100, .height = 50, .components = 1});
+        JpegInfo info;
+        REQUIRE(jpeg_parse(jpg.data(), jpg.size(), &info));
+        REQUIRE(info.blocks_per_mcu == 1);
+        REQUIRE(info.mcus_x == 13);
+        REQUIRE(info.mcus_y == 7);
+    }
+
+    SECTION("parses restart interval") {
+        auto jpg = make_synthetic_jpeg({.width = 320, .height = 240, .restart_interval = 20});
+        JpegInfo info;
+        REQUIRE(jpeg_parse(jpg.data(), jpg.size(), &info));
+        REQUIRE(info.restart_interval == 20);
+    }
+
+    SECTION("tolerates trailing padding after EOI") {
+        auto jpg = make_synthetic_jpeg({.width = 64, .height = 64});
+        size_t real_size = jpg.size();
+        jpg.resize(real_size + 100, 0);
+        JpegInfo info;
+        REQUIRE(jpeg_parse(jpg.data(), jpg.size(), &info));
+        REQUIRE(info.scan_offset + info.scan_size + 2 == real_size);
+    }
+
+    SECTION("rejects non-JPEG data") {
+        std::vector<uint8_t> junk(256, 0xAA);
+        JpegInfo info;
+        REQUIRE_FALSE(jpeg_parse(junk.data(), junk.size(), &info));
+        REQUIRE_FALSE(jpeg_parse(nullptr, 10, &info));
+    }
+
+    SECTION("rejects progressive frames") {
+        auto jpg = make_synthetic_jpeg({.width = 64, .height = 64});
+        for (size_t i = 2; i + 1 < jpg.size(); i++) {
+            if (jpg[i] == 0xFF && jpg[i + 1] == jpeg_marker::SOF0) {
+                jpg[i + 1] = 0xC2;
+                break;
+            }
+        }
+        JpegInfo info;
+        REQUIRE_FALSE(jpeg_parse(jpg.data(), jpg.size(), &info));
+    }
+
+    SECTION("rejects truncated headers") {
+        auto jpg = make_synthetic_jpeg({.width = 64, .height = 64});
+        JpegInfo info;
+        REQUIRE_FALSE(jpeg_parse(jpg.data(), 40, &info));
+    }
+}
+
+//=============================================================================
+// Entropy Coding Round-Trip Tests
+//=============================================================================
+
+static void require_roundtrip(const SyntheticJpegSpec& spec) {
+    JpegInfo gen_info = make_synthetic_info(spec);
+    auto gen = default_generator(spec);
+    auto jpg = encode_blocks(gen_info, gen);
+
+    JpegInfo info;
+    REQUIRE(jpeg_parse(jpg.data(), jpg.size(), &info));
+    JpegScanDecoder dec;
+    REQUIRE(dec.begin(jpg.data(), jpg.size(), info));
+
+    int16_t expected[JPEG_MAX_BLOCKS_PER_MCU][64];
+    int16_t actual[JPEG_MAX_BLOCKS_PER_MCU][64];
+    for (uint32_t m = 0; m < info.total_mcus(); m++) {
+        gen(gen_info, m, expected);
+        REQUIRE(dec.decode_mcu(actual));
+        REQUIRE(memcmp(expected, actual, sizeof(int16_t) * 64 * info.blocks_per_mcu) == 0);
+    }
+    REQUIRE_FALSE(dec.decode_mcu(actual));  // Past the end
+}
+
+TEST_CASE("JPEG entropy round trip", "[jpeg][entropy]") {
+    SECTION("4:2:2 colour") {
+        require_roundtrip({.width = 320, .height = 240});
+    }
+
+    SECTION("4:2:0 colour") {
+        require_roundtrip({.width = 320, .height = 240, .luma_v = 2});
+    }
+
+    SECTION("grayscale") {
+        require_roundtrip({.width = 120, .height = 72, .components = 1});
+    }
+
+    SECTION("with restart markers") {
+        require_roundtrip({.width = 320, .height = 240, .restart_interval = 7});
+    }
+
+    SECTION("dense coefficients exercise long codes and byte stuffing") {
+        require_roundtrip({.width = 256, .height = 128, .seed = 9, .ac_terms = 40});
+    }
+}
+
+TEST_CASE("JPEG scan decoder restart skipping", "[jpeg][restart]") {
+    SyntheticJpegSpec spec{.width = 320, .height = 240, .restart_interval = 20};
+    JpegInfo gen_info = make_synthetic_info(spec);
+    auto gen = default_generator(spec);
+    auto jpg = encode_blocks(gen_info, gen);
+
+    JpegInfo info;
+    REQUIRE(jpeg_parse(jpg.data(), jpg.size(), &info));
+    JpegScanDecoder dec;
+    REQUIRE(dec.begin(jpg.data(), jpg.size(), info));
+
+    int16_t expected[JPEG_MAX_BLOCKS_PER_MCU][64];
+    int16_t actual[JPEG_MAX_BLOCKS_PER_MCU][64];
+
+    SECTION("skip from start lands on interval boundary") {
+        REQUIRE(dec.skip_intervals(3));
+        REQUIRE(dec.mcus_decoded() == 60);
+        gen(gen_info, 60, expected);
+        REQUIRE(dec.decode_mcu(actual));
+        REQUIRE(memcmp(expected, actual, sizeof(int16_t) * 64 * info.blocks_per_mcu) == 0);
+    }
+
+    SECTION("skip after decoding a full interval") {
+        for (int i = 0; i < 20; i++) REQUIRE(dec.decode_mcu(actual));
+        REQUIRE(dec.skip_intervals(2));
+        gen(gen_info, 60, expected);
+        REQUIRE(dec.decode_mcu(actual));
+        REQUIRE(memcmp(expected, actual, sizeof(int16_t) * 64 * info.blocks_per_mcu) == 0);
+    }
+
+    SECTION("skip mid-interval is rejected") {
+        REQUIRE(dec.decode_mcu(actual));
+        REQUIRE_FALSE(dec.skip_intervals(1));
+    }
+}
+
+TEST_CASE("JPEG byte writer bounds", "[jpeg][writer]") {
+    uint8_t buf[4];
+    JpegByteWriter w(buf, sizeof(buf));
+    w.put16(0x1234);
+    w.put16(0x5678);
+    REQUIRE_FALSE(w.overflow());
+    w.put(0x9A);
+    REQUIRE(w.overflow());
+    REQUIRE(w.size() == 4);
+}
+
+#ifdef HAVE_LIBJPEG
+TEST_CASE("JPEG encoder output decodes with libjpeg", "[jpeg][libjpeg]") {
+    SECTION("colour with restart markers") {
+        auto jpg = make_synthetic_jpeg({.width = 200, .height = 120, .restart_interval = 5});
+        DecodedImage img;
+        REQUIRE(decode_jpeg(jpg.data(), jpg.size(), &img));
+        REQUIRE(img.width == 200);
+        REQUIRE(img.height == 120);
+        REQUIRE(img.components == 3);
+    }
+
+    SECTION("grayscale") {
+        auto jpg = make_synthetic_jpeg({.width = 64, .height = 40, .components = 1});
+        DecodedImage img;
+        REQUIRE(decode_jpeg(jpg.data(), jpg.size(), &img));
+        REQUIRE(img.components == 1);
+    }
+}
+#endif
@@ -0,0 +1,509 @@
+/**
+ * @file test_jpeg_delta.cpp
+ * @brief Unit tests and benchmarks for tile-level delta updates
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/jpeg_delta.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace core;
+using namespace fixtures;
+
+/**
+ * @brief Synthetic "replayed scene": static background, an object moving one
+ *        MCU per frame, and sensor noise flipping a coefficient in random MCUs
+ */
+struct SceneSpec {
+    uint16_t width = 640;
+    uint16_t height = 480;
+    uint16_t restart_interval = 0;
+    uint16_t object_mcus = 4;        // Side of the moving square (0 = none)
+    uint32_t noise_permille = 0;     // MCUs touched by noise per frame
+};
+
+static std::vector<uint8_t> scene_frame(const SceneSpec& scene, int frame) {
+    SyntheticJpegSpec spec{.width = scene.width, .height = scene.height,
+                           .restart_interval = scene.restart_interval};
+    JpegInfo info = make_synthetic_info(spec);
+    auto background = default_generator(spec);
+    return encode_blocks(info, [&](const JpegInfo& inf, uint32_t mcu, int16_t (*blocks)[64]) {
+        background(inf, mcu, blocks);
+        uint32_t mx = mcu % inf.mcus_x;
+        uint32_t my = mcu / inf.mcus_x;
+        if (scene.object_mcus) {
+            uint32_t ox = static_cast<uint32_t>(frame) % (inf.mcus_x - scene.object_mcus);
+            uint32_t oy = inf.mcus_y / 3;
+            if (mx >= ox && mx < ox + scene.object_mcus && my >= oy && my < oy + scene.object_mcus) {
+                for (uint8_t b = 0; b < inf.blocks_per_mcu; b++) {
+                    if (inf.block_component[b] == 0) blocks[b][0] = 90;
+                }
+            }
+        }
+        uint32_t h = (static_cast<uint32_t>(frame) * 2654435761u) ^ (mcu * 2246822519u);
+        h ^= h >> 15;
+        h *= 2246822519u;
+        h ^= h >> 13;
+        if (h % 1000 < scene.noise_permille) blocks[0][2] ^= 1;
+    });
+}
+
+static std::vector<uint8_t> patch_bytes(const DeltaRecord& rec) {
+    return std::vector<uint8_t>(rec.jpeg, rec.jpeg + rec.jpeg_size);
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return (static_cast<uint32_t>(get16(p)) << 16) | get16(p + 2);
+}
+
+/**
+ * @brief Client model working on coefficients: applies records the way the
+ *        web UI does and holds what the canvas would show
+ */
+struct CoefficientCanvas {
+    JpegInfo info;
+    std::vector<int16_t> coefs;   // blocks_per_mcu x 64 per MCU, raster order
+
+    bool apply(const DeltaRecord& rec) {
+        if (rec.empty() || rec.header[0] != DELTA_RECORD_MAGIC) return false;
+        JpegInfo src;
+        if (!jpeg_parse(rec.jpeg, rec.jpeg_size, &src)) return false;
+        JpegScanDecoder dec;
+        if (!dec.begin(rec.jpeg, rec.jpeg_size, src)) return false;
+        int16_t blocks[JPEG_MAX_BLOCKS_PER_MCU][64];
+        size_t mcu_coefs = static_cast<size_t>(src.blocks_per_mcu) * 64;
+
+        if (rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key)) {
+            info = src;
+            coefs.assign(src.total_mcus() * mcu_coefs, 0);
+            for (uint32_t m = 0; m < src.total_mcus(); m++) {
+                if (!dec.decode_mcu(blocks)) return false;
+                memcpy(&coefs[m * mcu_coefs], blocks, mcu_coefs * sizeof(int16_t));
+            }
+            return true;
+        }
+
+        // Row i of the patch replaces tile index[i]
+        uint16_t tiles = get16(rec.header + 10);
+        uint16_t tile_mcus = src.mcus_x;
+        if (src.mcus_y != tiles || get16(rec.header + 6) != tile_mcus * src.mcu_width) return false;
+        for (uint16_t i = 0; i < tiles; i++) {
+            uint32_t first = get16(rec.header + DELTA_RECORD_HEADER_SIZE + 2 * i) * tile_mcus;
+            for (uint16_t j = 0; j < tile_mcus; j++) {
+                if (!dec.decode_mcu(blocks)) return false;
+                if ((first + j) * mcu_coefs >= coefs.size()) return false;
+                memcpy(&coefs[(first + j) * mcu_coefs], blocks, mcu_coefs * sizeof(int16_t));
+            }
+        }
+        return true;
+    }
+
+    // Coefficients of a full frame, for comparison
+    static std::vector<int16_t> of(const std::vector<uint8_t>& jpeg) {
+        JpegInfo src;
+        std::vector<int16_t> out;
+        if (!jpeg_parse(jpeg.data(), jpeg.size(), &src)) return out;
+        JpegScanDecoder dec;
+        dec.begin(jpeg.data(), jpeg.size(), src);
+        int16_t blocks[JPEG_MAX_BLOCKS_PER_MCU][64];
+        size_t mcu_coefs = static_cast<size_t>(src.blocks_per_mcu) * 64;
+        out.resize(src.total_mcus() * mcu_coefs);
+        for (uint32_t m = 0; m < src.total_mcus(); m++) {
+            dec.decode_mcu(blocks);
+            memcpy(&out[m * mcu_coefs], blocks, mcu_coefs * sizeof(int16_t));
+        }
+        return out;
+    }
+};
+
+//=============================================================================
+// Segment Split Tests
+//=============================================================================
+
+TEST_CASE("Restart segments split the scan", "[delta][split]") {
+    auto jpeg = make_synthetic_jpeg({.width = 320, .height = 240, .restart_interval = 20});
+    JpegInfo info;
+    REQUIRE(jpeg_parse(jpeg.data(), jpeg.size(), &info));
+    const uint8_t* scan = jpeg.data() + info.scan_offset;
+
+    SECTION("One segment per restart interval") {
+        std::vector<JpegSegment> segs(64);
+        size_t n = jpeg_split_restart_segments(scan, info.scan_size, segs.data(), segs.size());
+        REQUIRE(n == info.total_mcus() / 20);
+
+        size_t covered = 0;
+        for (size_t i = 0; i < n; i++) {
+            REQUIRE(segs[i].size > 0);
+            covered += segs[i].size;
+            if (i > 0) {
+                // Preceded by the marker numbered (i - 1) mod 8
+                REQUIRE(scan[segs[i].offset - 2] == 0xFF);
+                REQUIRE(scan[segs[i].offset - 1] == jpeg_marker::RST0 + ((i - 1) & 7));
+            }
+        }
+        REQUIRE(covered + 2 * (n - 1) == info.scan_size);
+    }
+
+    SECTION("Stuffed 0xFF bytes do not split") {
+        const uint8_t data[] = {0x12, 0xFF, 0x00, 0x34, 0xFF, 0xD0, 0x56, 0xFF, 0x00};
+        JpegSegment segs[4];
+        REQUIRE(jpeg_split_restart_segments(data, sizeof(data), segs, 4) == 2);
+        REQUIRE(segs[0].offset == 0);
+        REQUIRE(segs[0].size == 4);
+        REQUIRE(segs[1].offset == 6);
+        REQUIRE(segs[1].size == 3);
+    }
+
+    SECTION("Too many segments") {
+        JpegSegment segs[4];
+        REQUIRE(jpeg_split_restart_segments(scan, info.scan_size, segs, 4) == 0);
+    }
+}
+
+//=============================================================================
+// Record Tests
+//=============================================================================
+
+TEST_CASE("JpegDeltaEncoder produces key, patch and empty records", "[delta][encoder]") {
+    SceneSpec scene{.width = 320, .height = 240, .restart_interval = 20, .object_mcus = 0};
+    auto frame0 = scene_frame(scene, 0);
+    JpegInfo info;
+    REQUIRE(jpeg_parse(frame0.data(), frame0.size(), &info));
+
+    JpegDeltaEncoder enc;
+    REQUIRE(enc.init(64 * 1024, 64, {}, false));
+    DeltaRecord rec;
+
+    SECTION("First frame is the source JPEG, unchanged") {
+        REQUIRE(enc.encode(frame0.data(), frame0.size(), 7, &rec));
+        REQUIRE(rec.header_size == DELTA_RECORD_HEADER_SIZE);
+        REQUIRE(rec.header[0] == 'D');
+        REQUIRE(rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key));
+        REQUIRE(get16(rec.header + 2) == 320);
+        REQUIRE(get16(rec.header + 4) == 240);
+        REQUIRE(get16(rec.header + 10) == 0);
+        REQUIRE(get32(rec.header + 12) == 7);
+        REQUIRE(get32(rec.header + 16) == frame0.size());
+        REQUIRE(rec.jpeg == frame0.data());
+        REQUIRE(rec.jpeg_size == frame0.size());
+        REQUIRE(enc.stats().transcoded == 0);
+    }
+
+    SECTION("Identical frame produces nothing") {
+        REQUIRE(enc.encode(frame0.data(), frame0.size(), 1, &rec));
+        auto copy = frame0;
+        REQUIRE(enc.encode(copy.data(), copy.size(), 2, &rec));
+        REQUIRE(rec.empty());
+        REQUIRE(enc.stats().unchanged == 1);
+        REQUIRE(enc.stats().sent_bytes == frame0.size() + DELTA_RECORD_HEADER_SIZE);
+    }
+
+    SECTION("Changed MCU produces a one-row patch") {
+        REQUIRE(enc.encode(frame0.data(), frame0.size(), 1, &rec));
+
+        uint32_t changed_mcu = 5 * info.mcus_x + 3;   // MCU row 5
+        auto gen = default_generator({.width = 320, .height = 240, .restart_interval = 20});
+        auto frame1 = encode_blocks(info, [&](const JpegInfo& inf, uint32_t m, int16_t (*b)[64]) {
+            gen(inf, m, b);
+            if (m == changed_mcu) b[0][0] = 77;
+        });
+        REQUIRE(enc.encode(frame1.data(), frame1.size(), 2, &rec));
+        REQUIRE(rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Patch));
+        REQUIRE(get16(rec.header + 6) == info.mcus_x * info.mcu_width);
+        REQUIRE(get16(rec.header + 8) == info.mcu_height);
+        REQUIRE(get16(rec.header + 10) == 1);
+        REQUIRE(rec.header_size == DELTA_RECORD_HEADER_SIZE + 2);
+        REQUIRE(get16(rec.header + DELTA_RECORD_HEADER_SIZE) == 5);
+        REQUIRE(get32(rec.header + 16) == rec.jpeg_size);
+        REQUIRE(rec.jpeg_size < frame1.size() / 10);
+
+        JpegInfo patch;
+        auto bytes = patch_bytes(rec);
+        REQUIRE(jpeg_parse(bytes.data(), bytes.size(), &patch));
+        REQUIRE(patch.width == info.mcus_x * info.mcu_width);
+        REQUIRE(patch.height == info.mcu_height);
+        REQUIRE(enc.stats().patches == 1);
+        REQUIRE(enc.stats().tiles_sent == 1);
+    }
+
+    SECTION("Reset forces a key frame") {
+        REQUIRE(enc.encode(frame0.data(), frame0.size(), 1, &rec));
+        enc.reset();
+        REQUIRE(enc.encode(frame0.data(), frame0.size(), 2, &rec));
+        REQUIRE(rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key));
+    }
+
+    SECTION("Invalid input") {
+        const uint8_t junk[] = {0x00, 0x01, 0x02};
+        REQUIRE_FALSE(enc.encode(junk, sizeof(junk), 1, &rec));
+        REQUIRE(rec.empty());
+        JpegDeltaEncoder uninit;
+        REQUIRE_FALSE(uninit.encode(frame0.data(), frame0.size(), 1, &rec));
+    }
+}
+
+//=============================================================================
+// Compositing Tests
+//=============================================================================
+
+TEST_CASE("Composited records equal the source frames", "[delta][composite]") {
+    struct Case {
+        const char* name;
+        uint16_t restart_interval;
+        uint16_t tile_mcus;
+        bool transcoded;
+    };
+    // 320x240 4:2:2 = 20x30 MCUs
+    const Case cases[] = {
+        {"rows, sensor restart interval", 20, 0, false},
+        {"rows, no restart markers", 0, 0, true},
+        {"4-MCU tiles, sensor restart interval", 4, 4, false},
+        {"tiles rounded to a row divisor", 0, 6, true},   // 6 -> 5
+    };
+
+    for (const auto& c : cases) {
+        SECTION(c.name) {
+            SceneSpec scene{.width = 320, .height = 240, .restart_interval = c.restart_interval,
+                            .object_mcus = 3, .noise_permille = 5};
+            JpegDeltaConfig config;
+            config.tile_mcus = c.tile_mcus;
+            config.key_interval = 0;
+            JpegDeltaEncoder enc;
+            REQUIRE(enc.init(64 * 1024, 600, config, false));
+            CoefficientCanvas canvas;
+
+            for (int f = 0; f < 12; f++) {
+                auto frame = scene_frame(scene, f);
+                DeltaRecord rec;
+                REQUIRE(enc.encode(frame.data(), frame.size(), static_cast<uint32_t>(f), &rec));
+                if (!rec.empty()) REQUIRE(canvas.apply(rec));
+                REQUIRE(canvas.coefs == CoefficientCanvas::of(frame));
+            }
+            REQUIRE(enc.stats().keys == 1);
+            REQUIRE(enc.stats().patches >= 10);
+            REQUIRE((enc.stats().transcoded > 0) == c.transcoded);
+            REQUIRE(enc.stats().sent_bytes < enc.stats().source_bytes / 2);
+        }
+    }
+
+    // /delta frees the ring slot before sending: only key records need a copy
+    SECTION("records outlive the source frame once keys are copied") {
+        SceneSpec scene{.width = 320, .height = 240, .restart_interval = 20,
+                        .object_mcus = 3, .noise_permille = 5};
+        JpegDeltaConfig config;
+        config.key_interval = 4;
+        JpegDeltaEncoder enc;
+        REQUIRE(enc.init(64 * 1024, 600, config, false));
+        CoefficientCanvas canvas;
+        std::vector<uint8_t> slot(64 * 1024);
+        std::vector<uint8_t> copy(64 * 1024);
+
+        for (int f = 0; f < 12; f++) {
+            auto frame = scene_frame(scene, f);
+            std::copy(frame.begin(), frame.end(), slot.begin());
+            DeltaRecord rec;
+            REQUIRE(enc.encode(slot.data(), frame.size(), static_cast<uint32_t>(f), &rec));
+            if (rec.jpeg == slot.data()) {
+                std::copy(slot.begin(), slot.begin() + rec.jpeg_size, copy.begin());
+                rec.jpeg = copy.data();
+            }
+            std::fill(slot.begin(), slot.end(), 0xA5);   // Producer reuses the slot
+            if (!rec.empty()) REQUIRE(canvas.apply(rec));
+            REQUIRE(canvas.coefs == CoefficientCanvas::of(frame));
+        }
+        REQUIRE(enc.stats().keys == 3);
+    }
+}
+
+//=============================================================================
+// Key Frame Tests
+//=============================================================================
+
+TEST_CASE("JpegDeltaEncoder key frame triggers", "[delta][key]") {
+    SceneSpec scene{.width = 320, .height = 240, .object_mcus = 2};
+    DeltaRecord rec;
+
+    SECTION("Key interval") {
+        JpegDeltaConfig config;
+        config.key_interval = 5;
+        JpegDeltaEncoder enc;
+        REQUIRE(enc.init(64 * 1024, 64, config, false));
+        std::vector<int> keys;
+        for (int f = 0; f < 12; f++) {
+            auto frame = scene_frame(scene, f);
+            REQUIRE(enc.encode(frame.data(), frame.size(), 0, &rec));
+            if (rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key)) keys.push_back(f);
+        }
+        REQUIRE(keys == std::vector<int>{0, 5, 10});
+    }
+
+    SECTION("Too many changed tiles") {
+        JpegDeltaConfig config;
+        config.max_patch_percent = 50;
+        JpegDeltaEncoder enc;
+        REQUIRE(enc.init(64 * 1024, 64, config, false));
+        auto a = make_synthetic_jpeg({.width = 320, .height = 240, .seed = 1});
+        auto b = make_synthetic_jpeg({.width = 320, .height = 240, .seed = 2});
+        REQUIRE(enc.encode(a.data(), a.size(), 1, &rec));
+        REQUIRE(enc.encode(b.data(), b.size(), 2, &rec));
+        REQUIRE(rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key));
+        REQUIRE(rec.jpeg == b.data());
+        REQUIRE(enc.stats().keys == 2);
+    }
+
+    SECTION("Layout change") {
+        JpegDeltaEncoder enc;
+        REQUIRE(enc.init(128 * 1024, 128, {}, false));
+        auto vga = scene_frame({.width = 640, .height = 480, .object_mcus = 0}, 0);
+        auto qvga = scene_frame({.width = 320, .height = 240, .object_mcus = 0}, 0);
+        REQUIRE(enc.encode(qvga.data(), qvga.size(), 1, &rec));
+        REQUIRE(enc.encode(vga.data(), vga.size(), 2, &rec));
+        REQUIRE(rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key));
+        REQUIRE(get16(rec.header + 2) == 640);
+
+        // Same size, different quantization: every tile is re-keyed even if
+        // its entropy-coded bytes happen to match
+        JpegInfo info = make_synthetic_info({.width = 640, .height = 480});
+        for (int k = 0; k < 64; k++) info.quant[0][k]++;
+        auto requant = encode_blocks(info, default_generator({.width = 640, .height = 480}));
+        REQUIRE(enc.encode(requant.data(), requant.size(), 3, &rec));
+        REQUIRE(rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key));
+    }
+
+    SECTION("More tiles than tracked") {
+        JpegDeltaConfig config;
+        config.tile_mcus = 1;
+        JpegDeltaEncoder enc;
+        REQUIRE(enc.init(64 * 1024, 64, config, false));   // 600 MCUs > 64 tiles
+        auto frame = scene_frame(scene, 0);
+        for (int i = 0; i < 3; i++) {
+            REQUIRE(enc.encode(frame.data(), frame.size(), 0, &rec));
+            REQUIRE(rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key));
+        }
+    }
+}
+
+#ifdef HAVE_LIBJPEG
+TEST_CASE("Composited patches match decoded source pixels", "[delta][libjpeg]") {
+    SceneSpec scene{.width = 320, .height = 240, .object_mcus = 3, .noise_permille = 10};
+    for (uint16_t tile_mcus : {static_cast<uint16_t>(0), static_cast<uint16_t>(4)}) {
+        JpegDeltaConfig config;
+        config.tile_mcus = tile_mcus;
+        JpegDeltaEncoder enc;
+        REQUIRE(enc.init(64 * 1024, 600, config, false));
+        DecodedImage canvas;
+
+        for (int f = 0; f < 6; f++) {
+            auto frame = scene_frame(scene, f);
+            DeltaRecord rec;
+            REQUIRE(enc.encode(frame.data(), frame.size(), 0, &rec));
+            REQUIRE_FALSE(rec.empty());
+
+            DecodedImage img;
+            REQUIRE(decode_jpeg(rec.jpeg, rec.jpeg_size, &img));
+            if (rec.header[1] == static_cast<uint8_t>(DeltaRecordType::Key)) {
+                canvas = img;
+            } else {
+                int tw = get16(rec.header + 6);
+                int th = get16(rec.header + 8);
+                int per_row = (canvas.width + tw - 1) / tw;
+                for (int i = 0; i < get16(rec.header + 10); i++) {
+                    int t = get16(rec.header + DELTA_RECORD_HEADER_SIZE + 2 * i);
+                    int dx = (t % per_row) * tw;
+                    int dy = (t / per_row) * th;
+                    for (int y = 0; y < th; y++) {
+                        memcpy(const_cast<uint8_t*>(canvas.at(dx, dy + y)), img.at(0, i * th + y),
+                               static_cast<size_t>(tw) * 3);
+                    }
+                }
+            }
+
+            DecodedImage expected;
+            REQUIRE(decode_jpeg(frame.data(), frame.size(), &expected));
+            REQUIRE(canvas.pixels == expected.pixels);
+        }
+    }
+}
+#endif
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+// Real footage: DELTA_SCENE_DIR=<dir of *.jpg frames, sorted by name>
+static std::vector<std::vector<uint8_t>> load_scene_dir() {
+    std::vector<std::vector<uint8_t>> frames;
+    const char* dir = getenv("DELTA_SCENE_DIR");
+    if (!dir) return frames;
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().extension() == ".jpg") paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    for (const auto& p : paths) {
+        std::ifstream in(p, std::ios::binary);
+        frames.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    return frames;
+}
+
+static void report_bytes(const char* scene, const std::vector<std::vector<uint8_t>>& frames) {
+    for (uint16_t tile_mcus : {static_cast<uint16_t>(0), static_cast<uint16_t>(4)}) {
+        JpegDeltaConfig config;
+        config.tile_mcus = tile_mcus;
+        JpegDeltaEncoder enc;
+        if (!enc.init(512 * 1024, 8192, config, false)) return;
+        for (size_t f = 0; f < frames.size(); f++) {
+            DeltaRecord rec;
+            enc.encode(frames[f].data(), frames[f].size(), static_cast<uint32_t>(f), &rec);
+        }
+        const auto& s = enc.stats();
+        WARN(scene << (tile_mcus ? ", 4-MCU tiles" : ", MCU rows") << ": MJPEG "
+             << s.source_bytes / 1024 << " KB, delta " << s.sent_bytes / 1024 << " KB ("
+             << s.sent_bytes * 100 / (s.source_bytes ? s.source_bytes : 1) << "%), "
+             << s.keys << " keys, " << s.patches << " patches, " << s.unchanged << " unchanged");
+    }
+}
+
+TEST_CASE("Delta stream bytes vs MJPEG", "[.][benchmark][delta]") {
+    constexpr int FRAMES = 200;
+    for (uint32_t noise : {0u, 5u, 20u}) {
+        std::vector<std::vector<uint8_t>> frames;
+        for (int f = 0; f < FRAMES; f++) {
+            frames.push_back(scene_frame({.object_mcus = 4, .noise_permille = noise}, f));
+        }
+        std::string name = "VGA synthetic, noise " + std::to_string(noise) + "/1000 MCUs";
+        report_bytes(name.c_str(), frames);
+    }
+    auto recorded = load_scene_dir();
+    if (!recorded.empty()) report_bytes("DELTA_SCENE_DIR", recorded);
+
+    JpegDeltaEncoder direct, recode;
+    JpegDeltaConfig config;
+    config.key_interval = 0;
+    direct.init(256 * 1024, 1024, config, false);
+    recode.init(256 * 1024, 1024, config, false);
+    auto rst = scene_frame({.restart_interval = 40, .noise_permille = 5}, 1);
+    auto plain = scene_frame({.noise_permille = 5}, 1);
+    DeltaRecord rec;
+    uint32_t seq = 0;
+
+    BENCHMARK("VGA frame, sensor restart markers") {
+        return direct.encode(rst.data(), rst.size(), ++seq, &rec);
+    };
+    BENCHMARK("VGA frame, re-coded to MCU rows") {
+        return recode.encode(plain.data(), plain.size(), ++seq, &rec);
+    };
+}
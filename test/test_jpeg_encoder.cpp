@@ -0,0 +1,436 @@
+/**
+ * @file test_jpeg_encoder.cpp
+ * @brief Unit tests and benchmarks for the software JPEG encoder and SoftJpegCamera
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/jpeg_encoder.hpp"
+#include "../main/core/soft_jpeg_camera.hpp"
+#include "mocks/mock_camera.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace core;
+using namespace mocks;
+
+namespace {
+
+// Smooth gradients plus a few sharp edges and some texture
+uint8_t test_pixel(int x, int y, int channel) {
+    int v = (x * (3 + channel) + y * (5 - channel)) / 2;
+    if (((x / 24) + (y / 24)) % 3 == channel) v += 60;
+    v += ((x * 7919 + y * 104729 + channel * 31) >> 3) % 9;
+    return static_cast<uint8_t>(v & 0xFF);
+}
+
+std::vector<uint8_t> make_rgb888(int w, int h) {
+    std::vector<uint8_t> rgb(static_cast<size_t>(w) * h * 3);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            for (int c = 0; c < 3; c++) rgb[(static_cast<size_t>(y) * w + x) * 3 + c] = test_pixel(x, y, c);
+        }
+    }
+    return rgb;
+}
+
+std::vector<uint8_t> make_gray(int w, int h) {
+    std::vector<uint8_t> gray(static_cast<size_t>(w) * h);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) gray[static_cast<size_t>(y) * w + x] = test_pixel(x, y, 0);
+    }
+    return gray;
+}
+
+// Big-endian RGB565, plus the exact RGB888 it expands to
+std::vector<uint8_t> to_rgb565(std::vector<uint8_t>& rgb) {
+    std::vector<uint8_t> out(rgb.size() / 3 * 2);
+    for (size_t i = 0; i < rgb.size() / 3; i++) {
+        uint8_t* p = &rgb[i * 3];
+        uint16_t v = static_cast<uint16_t>(((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3));
+        out[i * 2] = static_cast<uint8_t>(v >> 8);
+        out[i * 2 + 1] = static_cast<uint8_t>(v & 0xFF);
+        int r5 = v >> 11, g6 = (v >> 5) & 0x3F, b5 = v & 0x1F;
+        p[0] = static_cast<uint8_t>((r5 << 3) | (r5 >> 2));
+        p[1] = static_cast<uint8_t>((g6 << 2) | (g6 >> 4));
+        p[2] = static_cast<uint8_t>((b5 << 3) | (b5 >> 2));
+    }
+    return out;
+}
+
+// YUYV from full-resolution YCbCr (chroma of the left pixel of each pair)
+std::vector<uint8_t> make_yuyv(int w, int h) {
+    std::vector<uint8_t> out(static_cast<size_t>(w) * h * 2);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x += 2) {
+            uint8_t* p = &out[(static_cast<size_t>(y) * w + x) * 2];
+            p[0] = test_pixel(x, y, 0);
+            p[1] = test_pixel(x, y, 1);
+            p[2] = test_pixel(x + 1, y, 0);
+            p[3] = test_pixel(x, y, 2);
+        }
+    }
+    return out;
+}
+
+double psnr(const uint8_t* a, const uint8_t* b, size_t n) {
+    double mse = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = static_cast<double>(a[i]) - b[i];
+        mse += d * d;
+    }
+    mse /= static_cast<double>(n);
+    return mse == 0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+#ifdef HAVE_LIBJPEG
+/**
+ * @brief Reference encode: ISLOW DCT, standard Huffman tables, 2x1 luma sampling
+ */
+std::vector<uint8_t> libjpeg_encode(const uint8_t* pixels, int w, int h, int components, int quality) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr err;
+    cinfo.err = jpeg_std_error(&err);
+    jpeg_create_compress(&cinfo);
+    unsigned char* buf = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buf, &size);
+    cinfo.image_width = static_cast<JDIMENSION>(w);
+    cinfo.image_height = static_cast<JDIMENSION>(h);
+    cinfo.input_components = components;
+    cinfo.in_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    cinfo.dct_method = JDCT_ISLOW;
+    cinfo.optimize_coding = FALSE;
+    if (components == 3) {
+        cinfo.comp_info[0].h_samp_factor = 2;
+        cinfo.comp_info[0].v_samp_factor = 1;
+    }
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = const_cast<JSAMPROW>(&pixels[static_cast<size_t>(cinfo.next_scanline) * w * components]);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    std::vector<uint8_t> out(buf, buf + size);
+    jpeg_destroy_compress(&cinfo);
+    free(buf);
+    return out;
+}
+
+std::vector<uint8_t> scan_bytes(const uint8_t* data, size_t size) {
+    JpegInfo info;
+    if (!jpeg_parse(data, size, &info)) return {};
+    return std::vector<uint8_t>(data + info.scan_offset, data + info.scan_offset + info.scan_size);
+}
+#endif
+
+} // namespace
+
+//=============================================================================
+// Building Block Tests
+//=============================================================================
+
+TEST_CASE("Reciprocal quantization matches division", "[encoder][quantize]") {
+    SECTION("every divisor, every magnitude") {
+        for (uint32_t q = 1; q <= 255; q++) {
+            uint16_t table[64];
+            for (auto& t : table) t = static_cast<uint16_t>(q);
+            JpegDivisors div;
+            div.build(table);
+            uint32_t d = q * 8;
+            uint32_t m = div.mul[0][0];
+            uint32_t s = div.shift[0][0];
+            for (uint32_t n = 0; n < 32768; n++) {
+                if ((n * m) >> s != n / d) {
+                    FAIL("q=" << q << " n=" << n);
+                }
+            }
+        }
+    }
+
+    SECTION("signed rounding like libjpeg") {
+        uint16_t table[64];
+        for (int i = 0; i < 64; i++) table[i] = static_cast<uint16_t>(1 + i * 4);
+        JpegDivisors div;
+        div.build(table);
+        JpegLanes rows[8];
+        srand(7);
+        int32_t raw[64];
+        for (int i = 0; i < 64; i++) {
+            raw[i] = rand() % 16001 - 8000;
+            rows[i / 8][i % 8] = raw[i];
+        }
+        int16_t zz[64];
+        jpeg_quantize(rows, div, zz);
+        for (int k = 0; k < 64; k++) {
+            int n = JPEG_NATURAL_ORDER[k];
+            int32_t d = table[n] * 8;
+            int32_t mag = (std::abs(raw[n]) + d / 2) / d;
+            REQUIRE(zz[k] == (raw[n] < 0 ? -mag : mag));
+        }
+    }
+}
+
+TEST_CASE("Forward DCT", "[encoder][dct]") {
+    int32_t samples[64];
+    JpegLanes rows[8];
+
+    SECTION("flat block has only DC") {
+        for (auto& s : samples) s = 100;
+        jpeg_fdct_islow(samples, rows);
+        REQUIRE(rows[0][0] == 100 * 64);
+        for (int i = 1; i < 64; i++) REQUIRE(rows[i / 8][i % 8] == 0);
+    }
+
+    SECTION("horizontal ramp stays in the first row") {
+        for (int i = 0; i < 64; i++) samples[i] = (i % 8) * 16 - 56;
+        jpeg_fdct_islow(samples, rows);
+        REQUIRE(rows[0][1] < 0);
+        for (int u = 1; u < 8; u++) {
+            for (int k = 0; k < 8; k++) REQUIRE(rows[u][k] == 0);
+        }
+    }
+}
+
+TEST_CASE("Quality scaling", "[encoder][quality]") {
+    uint16_t q[64];
+    jpeg_scale_quant_table(JPEG_STD_LUMA_QUANT, 50, q);
+    REQUIRE(q[0] == 16);
+    jpeg_scale_quant_table(JPEG_STD_LUMA_QUANT, 100, q);
+    for (auto v : q) REQUIRE(v == 1);
+    jpeg_scale_quant_table(JPEG_STD_LUMA_QUANT, 1, q);
+    for (auto v : q) REQUIRE(v == 255);
+}
+
+//=============================================================================
+// Encoder Tests
+//=============================================================================
+
+TEST_CASE("JpegEncoder output", "[encoder][encode]") {
+    JpegEncoder enc;
+    std::vector<uint8_t> out(256 * 1024);
+
+    SECTION("headers describe the frame") {
+        auto yuyv = make_yuyv(64, 48);
+        size_t n = enc.encode(yuyv.data(), yuyv.size(), 64, 48, PixelFormat::Yuv422,
+                              out.data(), out.size());
+        REQUIRE(n > 0);
+        REQUIRE(out[0] == 0xFF);
+        REQUIRE(out[1] == 0xD8);
+        REQUIRE(out[n - 2] == 0xFF);
+        REQUIRE(out[n - 1] == 0xD9);
+
+        JpegInfo info;
+        REQUIRE(jpeg_parse(out.data(), n, &info));
+        REQUIRE(info.width == 64);
+        REQUIRE(info.height == 48);
+        REQUIRE(info.num_components == 3);
+        REQUIRE(info.components[0].h == 2);
+        REQUIRE(info.components[0].v == 1);
+        REQUIRE(jpeg_uses_standard_huffman(info));
+    }
+
+    SECTION("grayscale is single-component") {
+        auto gray = make_gray(40, 24);
+        size_t n = enc.encode(gray.data(), gray.size(), 40, 24, PixelFormat::Grayscale,
+                              out.data(), out.size());
+        REQUIRE(n > 0);
+        JpegInfo info;
+        REQUIRE(jpeg_parse(out.data(), n, &info));
+        REQUIRE(info.num_components == 1);
+    }
+
+    SECTION("higher quality means larger output") {
+        auto yuyv = make_yuyv(128, 96);
+        enc.set_quality(30);
+        size_t low = enc.encode(yuyv.data(), yuyv.size(), 128, 96, PixelFormat::Yuv422,
+                                out.data(), out.size());
+        enc.set_quality(95);
+        size_t high = enc.encode(yuyv.data(), yuyv.size(), 128, 96, PixelFormat::Yuv422,
+                                 out.data(), out.size());
+        REQUIRE(low > 0);
+        REQUIRE(high > low);
+    }
+
+    SECTION("invalid input") {
+        auto yuyv = make_yuyv(64, 48);
+        REQUIRE(enc.encode(nullptr, 0, 64, 48, PixelFormat::Yuv422, out.data(), out.size()) == 0);
+        REQUIRE(enc.encode(yuyv.data(), yuyv.size() - 1, 64, 48, PixelFormat::Yuv422,
+                           out.data(), out.size()) == 0);
+        REQUIRE(enc.encode(yuyv.data(), yuyv.size(), 63, 48, PixelFormat::Yuv422,
+                           out.data(), out.size()) == 0);   // YUYV needs pixel pairs
+        REQUIRE(enc.encode(yuyv.data(), yuyv.size(), 64, 48, PixelFormat::Jpeg,
+                           out.data(), out.size()) == 0);
+        REQUIRE(enc.encode(yuyv.data(), yuyv.size(), 64, 48, PixelFormat::Yuv422,
+                           out.data(), 200) == 0);           // Does not fit
+    }
+}
+
+#ifdef HAVE_LIBJPEG
+TEST_CASE("JpegEncoder matches libjpeg", "[encoder][reference]") {
+    JpegEncoder enc;
+    std::vector<uint8_t> out(256 * 1024);
+
+    SECTION("grayscale scan is bit-identical, including partial blocks") {
+        for (int quality : {25, 75, 90}) {
+            auto gray = make_gray(50, 30);
+            enc.set_quality(quality);
+            size_t n = enc.encode(gray.data(), gray.size(), 50, 30, PixelFormat::Grayscale,
+                                  out.data(), out.size());
+            REQUIRE(n > 0);
+            auto ref = libjpeg_encode(gray.data(), 50, 30, 1, quality);
+            INFO("quality " << quality);
+            REQUIRE(scan_bytes(out.data(), n) == scan_bytes(ref.data(), ref.size()));
+        }
+    }
+
+    SECTION("RGB565 color conversion and 4:2:2 downsampling are bit-identical") {
+        auto rgb = make_rgb888(96, 40);   // 12 luma blocks wide: no dummy blocks
+        auto rgb565 = to_rgb565(rgb);
+        enc.set_quality(80);
+        size_t n = enc.encode(rgb565.data(), rgb565.size(), 96, 40, PixelFormat::Rgb565,
+                              out.data(), out.size());
+        REQUIRE(n > 0);
+        auto ref = libjpeg_encode(rgb.data(), 96, 40, 3, 80);
+        REQUIRE(scan_bytes(out.data(), n) == scan_bytes(ref.data(), ref.size()));
+    }
+
+    SECTION("decoded YUYV frame is close to the source") {
+        auto yuyv = make_yuyv(160, 120);
+        for (size_t i = 1; i < yuyv.size(); i += 2) yuyv[i] = 128;   // Neutral chroma: RGB == Y
+        enc.set_quality(90);
+        size_t n = enc.encode(yuyv.data(), yuyv.size(), 160, 120, PixelFormat::Yuv422,
+                              out.data(), out.size());
+        REQUIRE(n > 0);
+        fixtures::DecodedImage img;
+        REQUIRE(fixtures::decode_jpeg(out.data(), n, &img));
+        REQUIRE(img.width == 160);
+        REQUIRE(img.height == 120);
+
+        std::vector<uint8_t> src(160 * 120), dec(160 * 120);
+        for (int i = 0; i < 160 * 120; i++) {
+            src[i] = yuyv[i * 2];
+            dec[i] = img.pixels[i * 3 + 1];
+        }
+        REQUIRE(psnr(src.data(), dec.data(), src.size()) > 32.0);
+    }
+}
+#endif
+
+//=============================================================================
+// SoftJpegCamera Tests
+//=============================================================================
+
+TEST_CASE("SoftJpegCamera", "[encoder][camera]") {
+    MockCamera raw;
+    SoftJpegCamera camera(raw, PixelFormat::Yuv422, 256 * 1024, false);
+    interfaces::CameraConfig config;
+    config.resolution = interfaces::Resolution::QVGA;
+    auto yuyv = make_yuyv(320, 240);
+    raw.set_custom_frame(yuyv);
+
+    SECTION("captures raw and returns JPEG") {
+        REQUIRE(camera.init(config));
+        auto frame = camera.capture_frame();
+        REQUIRE(frame.valid());
+        REQUIRE(frame.format == PixelFormat::Jpeg);
+        REQUIRE(frame.width == 320);
+        REQUIRE(frame.height == 240);
+        REQUIRE(frame.data[0] == 0xFF);
+        REQUIRE(frame.data[1] == 0xD8);
+        // Raw buffer goes back to the driver before the JPEG is consumed
+        REQUIRE_FALSE(raw.is_frame_held());
+        REQUIRE(raw.release_calls() == 1);
+        camera.release_frame();
+
+        auto s = camera.stats();
+        REQUIRE(s.frames_encoded == 1);
+        REQUIRE(s.bytes_encoded == frame.size);
+#ifdef HAVE_LIBJPEG
+        fixtures::DecodedImage img;
+        REQUIRE(fixtures::decode_jpeg(frame.data, frame.size, &img));
+#endif
+    }
+
+    SECTION("raw frame of the wrong size is an error") {
+        REQUIRE(camera.init(config));
+        raw.set_custom_frame(std::vector<uint8_t>(100));
+        REQUIRE_FALSE(camera.capture_frame().valid());
+        REQUIRE(camera.stats().encode_errors == 1);
+        REQUIRE_FALSE(raw.is_frame_held());
+    }
+
+    SECTION("quality maps onto the encoder scale") {
+        REQUIRE(camera.init(config));
+        REQUIRE(camera.set_quality(10));
+        REQUIRE(camera.encoder_quality() == 95);
+        REQUIRE(camera.set_quality(63));
+        REQUIRE(camera.encoder_quality() == 20);
+        REQUIRE(camera.get_quality() == 63);
+        REQUIRE_FALSE(camera.set_quality(5));
+    }
+
+    SECTION("resolution and lifecycle forward to the raw camera") {
+        REQUIRE_FALSE(camera.capture_frame().valid());
+        REQUIRE(camera.init(config));
+        REQUIRE(raw.is_initialized());
+        REQUIRE(camera.set_resolution(interfaces::Resolution::VGA));
+        REQUIRE(raw.get_resolution() == interfaces::Resolution::VGA);
+        camera.deinit();
+        REQUIRE_FALSE(raw.is_initialized());
+    }
+
+    SECTION("raw camera init failure") {
+        raw.set_init_result(false);
+        REQUIRE_FALSE(camera.init(config));
+        REQUIRE_FALSE(camera.is_initialized());
+    }
+}
+
+//=============================================================================
+// Benchmarks
+//=============================================================================
+
+TEST_CASE("Software JPEG encode throughput", "[.][benchmark][encoder]") {
+    constexpr int W = 640, H = 480;
+    JpegEncoder enc;
+    std::vector<uint8_t> out(512 * 1024);
+    auto yuyv = make_yuyv(W, H);
+    auto gray = make_gray(W, H);
+    auto rgb = make_rgb888(W, H);
+    auto rgb565 = to_rgb565(rgb);
+
+#ifdef HAVE_LIBJPEG
+    for (int quality : {50, 80, 90}) {
+        enc.set_quality(quality);
+        size_t n = enc.encode(rgb565.data(), rgb565.size(), W, H, PixelFormat::Rgb565,
+                              out.data(), out.size());
+        auto ref = libjpeg_encode(rgb.data(), W, H, 3, quality);
+        fixtures::DecodedImage a, b;
+        fixtures::decode_jpeg(out.data(), n, &a);
+        fixtures::decode_jpeg(ref.data(), ref.size(), &b);
+        WARN("VGA RGB565 q" << quality << ": " << n / 1024 << " KB, PSNR "
+             << psnr(rgb.data(), a.pixels.data(), rgb.size()) << " dB; libjpeg "
+             << ref.size() / 1024 << " KB, PSNR " << psnr(rgb.data(), b.pixels.data(), rgb.size()) << " dB");
+    }
+#endif
+
+    enc.set_quality(80);
+    BENCHMARK("VGA YUYV") {
+        return enc.encode(yuyv.data(), yuyv.size(), W, H, PixelFormat::Yuv422, out.data(), out.size());
+    };
+    BENCHMARK("VGA RGB565") {
+        return enc.encode(rgb565.data(), rgb565.size(), W, H, PixelFormat::Rgb565, out.data(), out.size());
+    };
+    BENCHMARK("VGA grayscale") {
+        return enc.encode(gray.data(), gray.size(), W, H, PixelFormat::Grayscale, out.data(), out.size());
+    };
+#ifdef HAVE_LIBJPEG
+    BENCHMARK("VGA RGB, libjpeg reference") {
+        return libjpeg_encode(rgb.data(), W, H, 3, 80).size();
+    };
+#endif
+}
@@ -0,0 +1,163 @@
+/**
+ * @file test_jpeg_metadata.cpp
+ * @brief Unit tests and benchmarks for zero-copy metadata splicing
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/jpeg_metadata.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <vector>
+#include <cstring>
+
+using namespace core;
+using namespace fixtures;
+
+// Gather a splice into one buffer (what the client receives)
+static std::vector<uint8_t> flatten(const JpegSplice& splice) {
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i < JpegSplice::NUM_PARTS; i++) {
+        out.insert(out.end(), splice.data[i], splice.data[i] + splice.size[i]);
+    }
+    return out;
+}
+
+//=============================================================================
+// Segment Encoding Tests
+//=============================================================================
+
+TEST_CASE("Metadata segment encoding", "[metadata][segment]") {
+    uint8_t seg[JPEG_METADATA_SEGMENT_SIZE];
+
+    SECTION("segment has APP9 marker and length") {
+        FrameMetadata meta{42, 1234567890123LL, FrameSource::Stream};
+        REQUIRE(jpeg_build_metadata_segment(meta, seg, sizeof(seg)) == JPEG_METADATA_SEGMENT_SIZE);
+        REQUIRE(seg[0] == 0xFF);
+        REQUIRE(seg[1] == JPEG_METADATA_MARKER);
+        REQUIRE(((seg[2] << 8) | seg[3]) == JPEG_METADATA_SEGMENT_SIZE - 2);
+        REQUIRE(memcmp(seg + 4, "ESPCAM", 7) == 0);
+    }
+
+    SECTION("too-small buffer fails") {
+        REQUIRE(jpeg_build_metadata_segment({}, seg, sizeof(seg) - 1) == 0);
+        REQUIRE(jpeg_build_metadata_segment({}, nullptr, 100) == 0);
+    }
+}
+
+//=============================================================================
+// Splice Tests
+//=============================================================================
+
+TEST_CASE("Metadata splice is zero-copy", "[metadata][splice]") {
+    auto frame = make_synthetic_jpeg({.width = 160, .height = 120});
+    const std::vector<uint8_t> original = frame;
+    uint8_t seg[JPEG_METADATA_SEGMENT_SIZE];
+    FrameMetadata meta{7, 987654321, FrameSource::Snapshot};
+    size_t seg_len = jpeg_build_metadata_segment(meta, seg, sizeof(seg));
+
+    SECTION("parts reference the original slot") {
+        JpegSplice splice;
+        REQUIRE(jpeg_splice_segment(frame.data(), frame.size(), seg, seg_len, &splice));
+        REQUIRE(splice.data[0] == frame.data());
+        REQUIRE(splice.size[0] == 2);  // SOI
+        REQUIRE(splice.data[1] == seg);
+        REQUIRE(splice.data[2] == frame.data() + 2);
+        REQUIRE(splice.total() == frame.size() + seg_len);
+        REQUIRE(frame == original);  // Slot untouched
+    }
+
+    SECTION("metadata reads back from spliced output") {
+        JpegSplice splice;
+        REQUIRE(jpeg_splice_segment(frame.data(), frame.size(), seg, seg_len, &splice));
+        auto out = flatten(splice);
+        FrameMetadata read;
+        REQUIRE(jpeg_read_metadata(out.data(), out.size(), &read));
+        REQUIRE(read.sequence == 7);
+        REQUIRE(read.timestamp_us == 987654321);
+        REQUIRE(read.source == FrameSource::Snapshot);
+    }
+
+    SECTION("output without metadata has none") {
+        FrameMetadata read;
+        REQUIRE_FALSE(jpeg_read_metadata(frame.data(), frame.size(), &read));
+    }
+
+    SECTION("spliced output still parses as baseline JPEG") {
+        JpegSplice splice;
+        REQUIRE(jpeg_splice_segment(frame.data(), frame.size(), seg, seg_len, &splice));
+        auto out = flatten(splice);
+        JpegInfo info;
+        REQUIRE(jpeg_parse(out.data(), out.size(), &info));
+        REQUIRE(info.width == 160);
+        REQUIRE(info.height == 120);
+    }
+
+    SECTION("leading JFIF APP0 stays first") {
+        static const uint8_t jfif[] = {0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+                                       0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+        std::vector<uint8_t> with_jfif(frame.begin(), frame.begin() + 2);
+        with_jfif.insert(with_jfif.end(), jfif, jfif + sizeof(jfif));
+        with_jfif.insert(with_jfif.end(), frame.begin() + 2, frame.end());
+
+        JpegSplice splice;
+        REQUIRE(jpeg_splice_segment(with_jfif.data(), with_jfif.size(), seg, seg_len, &splice));
+        REQUIRE(splice.size[0] == 2 + sizeof(jfif));
+        auto out = flatten(splice);
+        REQUIRE(out[2] == 0xFF);
+        REQUIRE(out[3] == 0xE0);
+        FrameMetadata read;
+        REQUIRE(jpeg_read_metadata(out.data(), out.size(), &read));
+        REQUIRE(read.sequence == 7);
+    }
+
+    SECTION("non-JPEG input is rejected") {
+        std::vector<uint8_t> junk(64, 0x11);
+        JpegSplice splice;
+        REQUIRE_FALSE(jpeg_splice_segment(junk.data(), junk.size(), seg, seg_len, &splice));
+    }
+}
+
+#ifdef HAVE_LIBJPEG
+TEST_CASE("Spliced JPEGs decode identically", "[metadata][libjpeg]") {
+    auto frame = make_synthetic_jpeg({.width = 320, .height = 240, .restart_interval = 8});
+    uint8_t seg[JPEG_METADATA_SEGMENT_SIZE];
+    size_t seg_len = jpeg_build_metadata_segment({1, 2, FrameSource::Stream}, seg, sizeof(seg));
+    JpegSplice splice;
+    REQUIRE(jpeg_splice_segment(frame.data(), frame.size(), seg, seg_len, &splice));
+    auto out = flatten(splice);
+
+    DecodedImage plain, spliced;
+    REQUIRE(decode_jpeg(frame.data(), frame.size(), &plain));
+    REQUIRE(decode_jpeg(out.data(), out.size(), &spliced));
+    REQUIRE(plain.width == spliced.width);
+    REQUIRE(plain.height == spliced.height);
+    REQUIRE(plain.pixels == spliced.pixels);
+}
+#endif
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+TEST_CASE("Metadata splice cost", "[.][benchmark][metadata]") {
+    auto frame = make_synthetic_jpeg({.width = 1024, .height = 768});
+    std::vector<uint8_t> copy(frame.size() + JPEG_METADATA_SEGMENT_SIZE);
+    uint32_t seq = 0;
+
+    BENCHMARK("splice (segment build + scatter view)") {
+        uint8_t seg[JPEG_METADATA_SEGMENT_SIZE];
+        size_t n = jpeg_build_metadata_segment({++seq, 123456, FrameSource::Stream}, seg, sizeof(seg));
+        JpegSplice splice;
+        jpeg_splice_segment(frame.data(), frame.size(), seg, n, &splice);
+        return splice.total();
+    };
+
+    BENCHMARK("baseline: rewrite frame with copy") {
+        uint8_t seg[JPEG_METADATA_SEGMENT_SIZE];
+        size_t n = jpeg_build_metadata_segment({++seq, 123456, FrameSource::Stream}, seg, sizeof(seg));
+        memcpy(copy.data(), frame.data(), 2);
+        memcpy(copy.data() + 2, seg, n);
+        memcpy(copy.data() + 2 + n, frame.data() + 2, frame.size() - 2);
+        return copy[100];
+    };
+}
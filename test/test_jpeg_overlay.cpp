@@ -0,0 +1,299 @@
+/**
+ * @file test_jpeg_overlay.cpp
+ * @brief Unit tests and benchmarks for DCT-domain privacy masks and timestamp overlay
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/jpeg_overlay.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <string>
+#include <vector>
+#include <cstring>
+
+using namespace core;
+using namespace fixtures;
+
+namespace {
+
+struct Coefficients {
+    JpegInfo info;
+    std::vector<int16_t> blocks;   // total_mcus x blocks_per_mcu x 64
+
+    const int16_t* block(uint32_t mx, uint32_t my, uint8_t b) const {
+        size_t mcu = static_cast<size_t>(my) * info.mcus_x + mx;
+        return &blocks[(mcu * info.blocks_per_mcu + b) * 64];
+    }
+};
+
+bool decode_coefficients(const uint8_t* data, size_t size, Coefficients* out) {
+    if (!jpeg_parse(data, size, &out->info)) return false;
+    JpegScanDecoder dec;
+    if (!dec.begin(data, size, out->info)) return false;
+    out->blocks.resize(static_cast<size_t>(out->info.total_mcus()) * out->info.blocks_per_mcu * 64);
+    for (uint32_t m = 0; m < out->info.total_mcus(); m++) {
+        if (!dec.decode_mcu(reinterpret_cast<int16_t(*)[64]>(&out->blocks[m * out->info.blocks_per_mcu * 64]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+interfaces::FrameView view_of(const std::vector<uint8_t>& jpeg, int64_t timestamp_us = 0) {
+    interfaces::FrameView v;
+    v.data = jpeg.data();
+    v.size = jpeg.size();
+    v.width = 640;
+    v.height = 480;
+    v.timestamp_us = timestamp_us;
+    return v;
+}
+
+bool flat(const int16_t* blk, int16_t dc) {
+    if (blk[0] != dc) return false;
+    for (int k = 1; k < 64; k++) {
+        if (blk[k] != 0) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+//=============================================================================
+// Parsing and Formatting Tests
+//=============================================================================
+
+TEST_CASE("Overlay mask parsing", "[overlay][parse]") {
+    OverlayConfig config;
+
+    SECTION("several rectangles") {
+        REQUIRE(parse_overlay_masks("0,0,64,48;320,100,50,60", &config));
+        REQUIRE(config.num_masks == 2);
+        REQUIRE(config.masks[1].x == 320);
+        REQUIRE(config.masks[1].h == 60);
+    }
+
+    SECTION("empty string clears the list") {
+        config.num_masks = 3;
+        REQUIRE(parse_overlay_masks("", &config));
+        REQUIRE(config.num_masks == 0);
+    }
+
+    SECTION("malformed input") {
+        REQUIRE_FALSE(parse_overlay_masks("0,0,64", &config));
+        REQUIRE_FALSE(parse_overlay_masks("0,0,64,48;", &config));
+        REQUIRE_FALSE(parse_overlay_masks("0,0,64,48;;1,1,1,1", &config));
+        REQUIRE_FALSE(parse_overlay_masks("1,1,1,1;1,1,1,1;1,1,1,1;1,1,1,1;1,1,1,1;"
+                                          "1,1,1,1;1,1,1,1;1,1,1,1;1,1,1,1", &config));
+    }
+}
+
+TEST_CASE("Overlay timestamp formatting", "[overlay][time]") {
+    char text[OVERLAY_TIMESTAMP_LENGTH + 1];
+    format_overlay_timestamp(0, text);
+    REQUIRE(std::string(text) == "1970-01-01 00:00:00");
+    format_overlay_timestamp(951782400, text);
+    REQUIRE(std::string(text) == "2000-02-29 00:00:00");
+    format_overlay_timestamp(1700000000, text);
+    REQUIRE(std::string(text) == "2023-11-14 22:13:20");
+    format_overlay_timestamp(-5, text);
+    REQUIRE(std::string(text) == "1970-01-01 00:00:00");
+}
+
+//=============================================================================
+// Processor Tests
+//=============================================================================
+
+TEST_CASE("JpegOverlayProcessor masks", "[overlay][mask]") {
+    auto jpeg = make_synthetic_jpeg();
+    Coefficients src;
+    REQUIRE(decode_coefficients(jpeg.data(), jpeg.size(), &src));
+    std::vector<uint8_t> out(jpeg.size() * 2);
+    JpegOverlayProcessor overlay;
+
+    OverlayConfig config;
+    config.timestamp = false;
+    REQUIRE(parse_overlay_masks("10,10,40,20;600,440,40,40", &config));
+    REQUIRE(overlay.init(config));
+
+    size_t n = overlay.process(view_of(jpeg), out.data(), out.size());
+    REQUIRE(n > 0);
+    Coefficients dst;
+    REQUIRE(decode_coefficients(out.data(), n, &dst));
+    REQUIRE(dst.info.width == 640);
+
+    // Black luma: (16 - 128) * 8 / q0 = -896 / 4
+    const int16_t black_dc = -224;
+    uint32_t masked = 0;
+    for (uint32_t my = 0; my < src.info.mcus_y; my++) {
+        for (uint32_t mx = 0; mx < src.info.mcus_x; mx++) {
+            // 4:2:2 MCUs are 16x8: first mask covers MCU columns 0-3, rows 1-3
+            bool in_mask = (mx < 4 && my >= 1 && my < 4) || (mx >= 37 && my >= 55);
+            for (uint8_t b = 0; b < src.info.blocks_per_mcu; b++) {
+                if (in_mask) {
+                    bool luma = src.info.block_component[b] == 0;
+                    REQUIRE(flat(dst.block(mx, my, b), luma ? black_dc : 0));
+                } else {
+                    REQUIRE(memcmp(dst.block(mx, my, b), src.block(mx, my, b), 64 * sizeof(int16_t)) == 0);
+                }
+            }
+            masked += in_mask;
+        }
+    }
+    REQUIRE(overlay.stats().masked_mcus == masked);
+    REQUIRE(overlay.stats().frames == 1);
+}
+
+TEST_CASE("JpegOverlayProcessor timestamp", "[overlay][timestamp]") {
+    auto jpeg = make_synthetic_jpeg();
+    Coefficients src;
+    REQUIRE(decode_coefficients(jpeg.data(), jpeg.size(), &src));
+    std::vector<uint8_t> out(jpeg.size() * 2);
+    JpegOverlayProcessor overlay;
+
+    OverlayConfig config;
+    config.timestamp_x = 20;   // Snaps to 16
+    config.timestamp_y = 20;   // Snaps to 16
+    REQUIRE(overlay.init(config));
+    overlay.set_clock_offset_us(1700000000LL * 1000000);
+
+    SECTION("text MCUs change, the rest is untouched") {
+        size_t n = overlay.process(view_of(jpeg, 500000), out.data(), out.size());
+        REQUIRE(n > 0);
+        Coefficients dst;
+        REQUIRE(decode_coefficients(out.data(), n, &dst));
+
+        // 19 glyphs x 16 px from x=16, two 8-px MCU rows from y=16
+        uint32_t texted = 0;
+        for (uint32_t my = 0; my < src.info.mcus_y; my++) {
+            for (uint32_t mx = 0; mx < src.info.mcus_x; mx++) {
+                bool in_text = mx >= 1 && mx < 20 && my >= 2 && my < 4;
+                for (uint8_t b = 0; b < src.info.blocks_per_mcu; b++) {
+                    bool same = memcmp(dst.block(mx, my, b), src.block(mx, my, b), 64 * sizeof(int16_t)) == 0;
+                    if (!in_text) REQUIRE(same);
+                    else if (src.info.block_component[b] != 0) REQUIRE(flat(dst.block(mx, my, b), 0));
+                }
+                texted += in_text;
+            }
+        }
+        REQUIRE(overlay.stats().text_mcus == texted);
+    }
+
+    SECTION("text follows the frame timestamp") {
+        size_t a = overlay.process(view_of(jpeg, 0), out.data(), out.size());
+        std::vector<uint8_t> first(out.begin(), out.begin() + static_cast<long>(a));
+        size_t b = overlay.process(view_of(jpeg, 900000), out.data(), out.size());
+        REQUIRE(std::vector<uint8_t>(out.begin(), out.begin() + static_cast<long>(b)) == first);
+        b = overlay.process(view_of(jpeg, 1000000), out.data(), out.size());
+        REQUIRE(std::vector<uint8_t>(out.begin(), out.begin() + static_cast<long>(b)) != first);
+    }
+
+#ifdef HAVE_LIBJPEG
+    SECTION("glyphs decode as bright strokes on a dark band") {
+        size_t n = overlay.process(view_of(jpeg, 0), out.data(), out.size());
+        DecodedImage img;
+        REQUIRE(decode_jpeg(out.data(), n, &img));
+
+        const char* stamp = "2023-11-14 22:13:20";
+        static const uint8_t font_one[7] = {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E};
+        uint64_t on_sum = 0, on_count = 0, off_sum = 0, off_count = 0;
+        // Background everywhere, strokes of every '1' checked against the font
+        for (int ch = 0; ch < 19; ch++) {
+            for (int cy = 0; cy < 16; cy++) {
+                for (int cx = 0; cx < 16; cx++) {
+                    int gx = cx / 2 - 1, gy = cy / 2;
+                    bool stroke = stamp[ch] == '1' && gx >= 0 && gx < 5 && gy < 7 &&
+                                  ((font_one[gy] >> (4 - gx)) & 1);
+                    bool blank = stamp[ch] == ' ';
+                    uint8_t y = img.at(16 + ch * 16 + cx, 16 + cy)[1];
+                    if (stroke) { on_sum += y; on_count++; }
+                    if (blank) { off_sum += y; off_count++; }
+                }
+            }
+        }
+        REQUIRE(on_count > 0);
+        REQUIRE(off_count > 0);
+        REQUIRE(on_sum / on_count > 180);
+        REQUIRE(off_sum / off_count < 40);
+    }
+#endif
+}
+
+TEST_CASE("JpegOverlayProcessor failures", "[overlay][errors]") {
+    auto jpeg = make_synthetic_jpeg();
+    std::vector<uint8_t> out(jpeg.size() * 2);
+    JpegOverlayProcessor overlay;
+
+    SECTION("not initialized") {
+        REQUIRE(overlay.process(view_of(jpeg), out.data(), out.size()) == 0);
+    }
+
+    SECTION("invalid config") {
+        OverlayConfig config;
+        config.text_scale = 3;
+        REQUIRE_FALSE(overlay.init(config));
+        config.text_scale = 1;
+        config.num_masks = 1;   // Empty rectangle
+        REQUIRE_FALSE(overlay.init(config));
+    }
+
+    SECTION("corrupt frame, raw frame and small output are rejected") {
+        REQUIRE(overlay.init({}));
+        std::vector<uint8_t> junk(jpeg.begin(), jpeg.begin() + 100);
+        REQUIRE(overlay.process(view_of(junk), out.data(), out.size()) == 0);
+        auto raw = view_of(jpeg);
+        raw.format = interfaces::PixelFormat::Yuv422;
+        REQUIRE(overlay.process(raw, out.data(), out.size()) == 0);
+        REQUIRE(overlay.process(view_of(jpeg), out.data(), 1000) == 0);
+        REQUIRE(overlay.stats().rejected == 3);
+    }
+
+    SECTION("grayscale and 4:2:0 frames") {
+        REQUIRE(overlay.init({}));
+        auto gray = make_synthetic_jpeg({.components = 1});
+        REQUIRE(overlay.process(view_of(gray), out.data(), out.size()) > 0);
+        auto yuv420 = make_synthetic_jpeg({.luma_v = 2});
+        size_t n = overlay.process(view_of(yuv420), out.data(), out.size());
+        REQUIRE(n > 0);
+#ifdef HAVE_LIBJPEG
+        DecodedImage img;
+        REQUIRE(decode_jpeg(out.data(), n, &img));
+#endif
+    }
+}
+
+//=============================================================================
+// Benchmarks
+//=============================================================================
+
+TEST_CASE("Overlay per-frame cost", "[.][benchmark][overlay]") {
+    auto vga = make_synthetic_jpeg();
+    auto xga = make_synthetic_jpeg({.width = 1024, .height = 768});
+    std::vector<uint8_t> out(xga.size() * 2);
+
+    OverlayConfig config;
+    REQUIRE(parse_overlay_masks("0,0,160,120;480,0,160,240", &config));
+    JpegOverlayProcessor overlay;
+    REQUIRE(overlay.init(config));
+
+    auto xga_view = view_of(xga);
+    xga_view.width = 1024;
+    xga_view.height = 768;
+
+    BENCHMARK("VGA, 2 masks + timestamp") {
+        return overlay.process(view_of(vga), out.data(), out.size());
+    };
+    BENCHMARK("XGA, 2 masks + timestamp") {
+        return overlay.process(xga_view, out.data(), out.size());
+    };
+#ifdef HAVE_LIBJPEG
+    // Lower bound for any pixel-domain overlay (decode only, no re-encode)
+    DecodedImage img;
+    BENCHMARK("VGA, libjpeg decode only") {
+        return decode_jpeg(vga.data(), vga.size(), &img);
+    };
+    BENCHMARK("XGA, libjpeg decode only") {
+        return decode_jpeg(xga.data(), xga.size(), &img);
+    };
+#endif
+}
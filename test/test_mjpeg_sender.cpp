@@ -0,0 +1,455 @@
+/**
+ * @file test_mjpeg_sender.cpp
+ * @brief Unit tests for MjpegSender against simulated slow and stalled sockets
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/mjpeg_sender.hpp"
+#include "../main/core/streaming_service.hpp"
+#include "mocks/mock_camera.hpp"
+#include "mocks/mock_clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace mocks;
+
+namespace {
+
+constexpr int64_t MS = 1000;
+const char* const HEAD = "HTTP/1.1 200 OK\r\nContent-Type: multipart/x-mixed-replace; boundary=frame\r\n\r\n";
+
+// Lets the producer take one capture per allow(); it waits inside capture_frame()
+struct CaptureGate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int allowed = 0;
+    int taken = 0;
+    bool waiting = false;
+
+    void on_capture() {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting = true;
+        cv.notify_all();
+        cv.wait(lock, [this] { return taken < allowed; });
+        waiting = false;
+        taken++;
+    }
+
+    // Let n captures through and wait until the producer has committed them
+    // and is back waiting for the next
+    bool allow(int n) {
+        std::unique_lock<std::mutex> lock(mutex);
+        allowed += n;
+        cv.notify_all();
+        return cv.wait_for(lock, std::chrono::seconds(2), [this] { return taken == allowed && waiting; });
+    }
+};
+
+// Simulated socket: takes at most max_write bytes per call and budget bytes
+// in total; then it would block until the test raises the budget
+struct FakeSocket {
+    std::string out;
+    size_t budget = SIZE_MAX;
+    size_t max_write = SIZE_MAX;
+    bool closed = false;
+    int calls = 0;
+
+    static int32_t write(void* context, const uint8_t* data, size_t size) {
+        auto* self = static_cast<FakeSocket*>(context);
+        self->calls++;
+        if (self->closed) return -1;
+        size_t take = std::min({size, self->max_write, self->budget});
+        if (take == 0) return 0;
+        self->out.append(reinterpret_cast<const char*>(data), take);
+        self->budget -= take;
+        return static_cast<int32_t>(take);
+    }
+};
+
+// Split an MJPEG body into part payloads by Content-Length; false if the
+// framing does not hold up to the end of the data
+bool parse_parts(const std::string& data, std::vector<std::string>* parts) {
+    size_t pos = 0;
+    const std::string prefix = "\r\n--frame\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+    while (pos < data.size()) {
+        if (data.compare(pos, prefix.size(), prefix) != 0) return false;
+        pos += prefix.size();
+        size_t end = data.find("\r\n\r\n", pos);
+        if (end == std::string::npos) return false;
+        size_t length = std::stoul(data.substr(pos, end - pos));
+        pos = end + 4;
+        if (pos + length > data.size()) return false;
+        parts->push_back(data.substr(pos, length));
+        pos += length;
+    }
+    return true;
+}
+
+uint32_t part_sequence(const std::string& part) {
+    FrameMetadata meta;
+    if (!jpeg_read_metadata(reinterpret_cast<const uint8_t*>(part.data()), part.size(), &meta)) return 0;
+    return meta.sequence;
+}
+
+// Poll until the sender stops making parts; returns the last step
+SendStep drain(MjpegSender& sender, int64_t now_us) {
+    SendStep step;
+    for (int i = 0; i < 100; i++) {
+        step = sender.poll(now_us);
+        if (step != SendStep::Sent) break;
+    }
+    return step;
+}
+
+// Streaming service whose producer commits one frame per gate.allow()
+struct Rig {
+    MockCamera camera;
+    MockClock clock;
+    CaptureGate gate;
+    StreamingService svc{camera, clock};
+    std::vector<uint8_t> frame;
+
+    explicit Rig(uint32_t lease_timeout_ms, size_t slots = 2) {
+        // A recognizable body: revoked leases show up as zeros
+        frame.assign(2000, 0xAB);
+        frame[0] = 0xFF;
+        frame[1] = 0xD8;
+        frame[frame.size() - 2] = 0xFF;
+        frame[frame.size() - 1] = 0xD9;
+        camera.init({});
+        camera.set_custom_frame(frame);
+        camera.set_capture_delay_callback([this] { gate.on_capture(); });
+        StreamingConfig config;
+        config.target_fps = 10;
+        config.buffer_slots = slots;
+        config.lease_timeout_ms = lease_timeout_ms;
+        svc.init(config);
+        svc.start();
+    }
+
+    ~Rig() {
+        // Unblock the producer for good so stop() can join it
+        {
+            std::lock_guard<std::mutex> lock(gate.mutex);
+            gate.allowed = 1 << 30;
+        }
+        gate.cv.notify_all();
+        svc.stop();
+    }
+
+    int64_t now() const { return clock.current_time(); }
+};
+
+} // namespace
+
+//=============================================================================
+// FrameBuffer leases
+//=============================================================================
+
+TEST_CASE("FrameBuffer leases", "[mjpeg_sender][frame_buffer]") {
+    FrameBuffer buffer;
+    REQUIRE(buffer.init(2, 64, false));
+    uint8_t frame[16] = {0xFF, 0xD8};
+    const uint8_t* data;
+    size_t size;
+    uint32_t sequence = 0;
+    REQUIRE(buffer.push(frame, sizeof(frame), 0));
+
+    SECTION("a lease pins the newest frame like acquire_latest") {
+        int lease = buffer.lease_latest(0, &data, &size, 0, nullptr, &sequence);
+        REQUIRE(lease >= 0);
+        CHECK(sequence == 1);
+        CHECK(buffer.lease_latest(1, &data, &size, 0) == -1);   // Nothing newer
+        REQUIRE(buffer.push(frame, sizeof(frame), 0));          // Slot 1
+        REQUIRE(buffer.push(frame, sizeof(frame), 0));          // Slot 0: leased
+        CHECK(buffer.last_sequence() == 2);
+        buffer.release_lease(lease);
+        REQUIRE(buffer.push(frame, sizeof(frame), 0));
+        CHECK(buffer.last_sequence() == 3);
+    }
+
+    SECTION("only idle, stale leases are revoked") {
+        int stale = buffer.lease_latest(0, &data, &size, 0);
+        int fresh = buffer.lease_latest(0, &data, &size, 400 * MS);
+        int busy = buffer.lease_latest(0, &data, &size, 0);
+        REQUIRE(buffer.lease_read_begin(busy));
+        CHECK(buffer.revoke_stale_leases(499 * MS, 500 * MS) == 0);
+        CHECK(buffer.revoke_stale_leases(500 * MS, 500 * MS) == 1);
+        CHECK(buffer.leases_revoked() == 1);
+        CHECK_FALSE(buffer.lease_read_begin(stale));
+
+        // Progress restarts the timeout; a read in progress is never revoked
+        REQUIRE(buffer.lease_read_begin(fresh));
+        buffer.lease_read_end(fresh, 800 * MS, true);
+        CHECK(buffer.revoke_stale_leases(1000 * MS, 500 * MS) == 0);
+        buffer.lease_read_end(busy, 1000 * MS, false);
+        CHECK(buffer.revoke_stale_leases(1000 * MS, 500 * MS) == 1);
+        CHECK(buffer.revoke_stale_leases(1300 * MS, 500 * MS) == 1);
+
+        // All revoked: the slot is free even before the holders release
+        REQUIRE(buffer.push(frame, sizeof(frame), 0));
+        REQUIRE(buffer.push(frame, sizeof(frame), 0));
+        CHECK(buffer.last_sequence() == 3);
+        buffer.release_lease(stale);
+        buffer.release_lease(fresh);
+        buffer.release_lease(busy);
+    }
+
+    SECTION("releasing a revoked lease leaves other pins alone") {
+        int lease = buffer.lease_latest(0, &data, &size, 0);
+        int pin = buffer.acquire_latest(0, &data, &size);
+        REQUIRE(buffer.revoke_stale_leases(1000 * MS, 500 * MS) == 1);
+        buffer.release_lease(lease);
+        REQUIRE(buffer.push(frame, sizeof(frame), 0));   // Slot 1
+        REQUIRE(buffer.push(frame, sizeof(frame), 0));   // Slot 0: still pinned
+        CHECK(buffer.last_sequence() == 2);
+        buffer.release(pin);
+    }
+
+    SECTION("the lease table is bounded and invalid ids are safe") {
+        std::vector<int> leases;
+        for (size_t i = 0; i < FrameBuffer::MAX_LEASES; i++) {
+            leases.push_back(buffer.lease_latest(0, &data, &size, 0));
+            REQUIRE(leases.back() >= 0);
+        }
+        CHECK(buffer.lease_latest(0, &data, &size, 0) == -1);
+        for (int lease : leases) buffer.release_lease(lease);
+        CHECK_FALSE(buffer.lease_read_begin(-1));
+        CHECK_FALSE(buffer.lease_read_begin(static_cast<int>(FrameBuffer::MAX_LEASES)));
+        buffer.release_lease(-1);
+        buffer.lease_read_end(99, 0, true);
+    }
+}
+
+//=============================================================================
+// MjpegSender
+//=============================================================================
+
+TEST_CASE("MjpegSender output", "[mjpeg_sender]") {
+    Rig rig(0, 4);
+    FakeSocket sock;
+    MjpegSender sender;
+    REQUIRE(sender.begin(rig.svc, &FakeSocket::write, &sock, HEAD, {}, rig.now()));
+
+    SECTION("partial writes add up to exact parts") {
+        sock.max_write = 7;
+        CHECK(sender.poll(rig.now()) == SendStep::Sent);   // Head alone
+        CHECK(sender.poll(rig.now()) == SendStep::Idle);
+        REQUIRE(rig.gate.allow(2));
+        CHECK(drain(sender, rig.now()) == SendStep::Idle);
+
+        REQUIRE(sock.out.compare(0, strlen(HEAD), HEAD) == 0);
+        std::vector<std::string> parts;
+        REQUIRE(parse_parts(sock.out.substr(strlen(HEAD)), &parts));
+        REQUIRE(parts.size() == 1);   // Both commits before the poll: the newest only
+        CHECK(part_sequence(parts[0]) == 2);
+        CHECK(parts[0].size() == rig.frame.size() + JPEG_METADATA_SEGMENT_SIZE);
+        CHECK(parts[0].substr(parts[0].size() - 100) == std::string(98, '\xAB') + "\xFF\xD9");
+        CHECK(sender.stats().frames_sent == 1);
+        CHECK(rig.svc.stats().frames_sent == 1);
+        CHECK(sender.stats().frames_skipped == 0);   // Nothing was sent before frame 2
+        CHECK(sender.stats().partial_writes > 0);
+        CHECK(sender.stats().bytes_sent == sock.out.size());
+    }
+
+    SECTION("a stalled client resumes where it stopped, then skips to the newest") {
+        REQUIRE(rig.gate.allow(1));
+        sock.budget = strlen(HEAD) + 50;
+        CHECK(sender.poll(rig.now()) == SendStep::Sent);
+        CHECK(sender.poll(rig.now()) == SendStep::Blocked);
+        CHECK(sender.pending());
+        int calls = sock.calls;
+        CHECK(sender.poll(rig.now()) == SendStep::Blocked);
+        CHECK(sock.calls == calls + 1);   // One try per poll, no spinning
+
+        REQUIRE(rig.gate.allow(3));
+        sock.budget = SIZE_MAX;
+        CHECK(sender.poll(rig.now()) == SendStep::Sent);   // Rest of frame 1
+        CHECK(sender.poll(rig.now()) == SendStep::Sent);   // Frame 4
+        CHECK(sender.poll(rig.now()) == SendStep::Idle);
+
+        std::vector<std::string> parts;
+        REQUIRE(parse_parts(sock.out.substr(strlen(HEAD)), &parts));
+        REQUIRE(parts.size() == 2);
+        CHECK(part_sequence(parts[0]) == 1);
+        CHECK(part_sequence(parts[1]) == 4);
+        CHECK(parts[0].find(std::string(64, '\0')) == std::string::npos);   // Intact
+        CHECK(sender.stats().frames_skipped == 2);
+        CHECK(sender.stats().frames_truncated == 0);
+        CHECK(sender.last_sequence() == 4);
+    }
+
+    SECTION("metadata can be left out") {
+        MjpegSenderConfig config;
+        config.embed_metadata = false;
+        REQUIRE(sender.begin(rig.svc, &FakeSocket::write, &sock, nullptr, config, rig.now()));
+        REQUIRE(rig.gate.allow(1));
+        CHECK(drain(sender, rig.now()) == SendStep::Idle);
+        std::vector<std::string> parts;
+        REQUIRE(parse_parts(sock.out, &parts));
+        REQUIRE(parts.size() == 1);
+        CHECK(parts[0] == std::string(rig.frame.begin(), rig.frame.end()));
+    }
+
+    SECTION("a degraded client is paced, and finished parts are metered") {
+        EgressMeter meter;
+        MjpegSenderConfig config;
+        config.min_interval_ms = 200;
+        config.meter = &meter;
+        REQUIRE(sender.begin(rig.svc, &FakeSocket::write, &sock, nullptr, config, rig.now()));
+        CHECK(sender.resume_at_us() == 0);
+        REQUIRE(rig.gate.allow(1));
+        int64_t first = rig.now();
+        CHECK(drain(sender, first) == SendStep::Idle);
+        CHECK(sender.resume_at_us() == first + 200 * MS);
+
+        REQUIRE(rig.gate.allow(1));
+        CHECK(rig.now() < first + 200 * MS);
+        CHECK(sender.poll(rig.now()) == SendStep::Idle);   // Too soon
+        CHECK(sender.poll(first + 200 * MS) == SendStep::Sent);
+        CHECK(sender.last_sequence() == 2);
+
+        CHECK(meter.frames() == 2);
+        CHECK(meter.frame_bytes() == sock.out.size() / 2);
+        CHECK(meter.frame_send_us() == 0);   // Each went out in one poll
+    }
+
+    SECTION("a part over the class's rate is not sent") {
+        EgressScheduler scheduler;
+        scheduler.set_capacity_Bps(1000);   // Far less than one part per second
+        MjpegSenderConfig config;
+        config.scheduler = &scheduler;
+        config.consumer_class = ConsumerClass::Dashboard;
+        REQUIRE(sender.begin(rig.svc, &FakeSocket::write, &sock, nullptr, config, rig.now()));
+        REQUIRE(rig.gate.allow(1));
+        CHECK(drain(sender, rig.now()) == SendStep::Idle);   // The first may overdraw
+        size_t sent = sock.out.size();
+        CHECK(sent > 0);
+
+        REQUIRE(rig.gate.allow(1));
+        CHECK(sender.poll(rig.now()) == SendStep::Idle);
+        CHECK(sock.out.size() == sent);
+        CHECK(sender.last_sequence() == 2);   // Waits for the next frame, not this one
+        CHECK_FALSE(sender.pending());
+        CHECK(sender.stats().frames_sent == 1);
+        CHECK(sender.stats().frames_deferred == 1);
+
+        const auto& dash = scheduler.stats().of(ConsumerClass::Dashboard);
+        CHECK(dash.offered == 2);
+        CHECK(dash.delivered == 1);
+        CHECK(dash.bytes_delivered == sent);
+    }
+
+    SECTION("a closed socket ends the stream and frees the frame") {
+        REQUIRE(rig.gate.allow(1));
+        sock.closed = true;
+        CHECK(sender.poll(rig.now()) == SendStep::Closed);
+        CHECK(sender.poll(rig.now()) == SendStep::Closed);
+        CHECK_FALSE(sender.pending());
+    }
+}
+
+TEST_CASE("MjpegSender with a stalled client", "[mjpeg_sender][stall]") {
+    SECTION("without revocation one stalled client starves every other") {
+        Rig rig(0);
+        FakeSocket stalled_sock, fast_sock;
+        MjpegSender stalled, fast;
+        REQUIRE(stalled.begin(rig.svc, &FakeSocket::write, &stalled_sock, HEAD, {}, rig.now()));
+        REQUIRE(fast.begin(rig.svc, &FakeSocket::write, &fast_sock, HEAD, {}, rig.now()));
+        REQUIRE(rig.gate.allow(1));
+        stalled_sock.budget = strlen(HEAD) + 50;
+        CHECK(drain(stalled, rig.now()) == SendStep::Blocked);
+
+        for (int i = 0; i < 10; i++) {
+            REQUIRE(rig.gate.allow(1));
+            drain(fast, rig.now());
+        }
+        // Two slots: frame 2 went into the other one, then every push hit the lease
+        CHECK(rig.svc.last_sequence() == 2);
+        CHECK(fast.last_sequence() == 2);
+    }
+
+    SECTION("a stale lease is revoked: other clients keep their frames, the framing survives") {
+        Rig rig(500);
+        FakeSocket stalled_sock, fast_sock;
+        MjpegSender stalled, fast;
+        REQUIRE(stalled.begin(rig.svc, &FakeSocket::write, &stalled_sock, HEAD, {}, rig.now()));
+        REQUIRE(fast.begin(rig.svc, &FakeSocket::write, &fast_sock, HEAD, {}, rig.now()));
+        REQUIRE(rig.gate.allow(1));
+        stalled_sock.budget = strlen(HEAD) + 50;
+        CHECK(drain(stalled, rig.now()) == SendStep::Blocked);
+
+        std::vector<uint32_t> fast_seen;
+        for (int i = 0; i < 10; i++) {
+            REQUIRE(rig.gate.allow(1));
+            drain(fast, rig.now());
+            fast_seen.push_back(fast.last_sequence());
+        }
+        // 10 fps: the stalled lease is revoked ~500 ms in, then nothing is lost
+        CHECK(rig.svc.stats().leases_revoked == 1);
+        CHECK(rig.svc.last_sequence() >= 6);
+        CHECK(fast.last_sequence() == rig.svc.last_sequence());
+        CHECK(std::is_sorted(fast_seen.begin(), fast_seen.end()));
+
+        // The client wakes up: the revoked part is padded out, then the newest frame
+        stalled_sock.budget = SIZE_MAX;
+        CHECK(stalled.poll(rig.now()) == SendStep::Sent);
+        CHECK(stalled.poll(rig.now()) == SendStep::Sent);
+        CHECK(stalled.poll(rig.now()) == SendStep::Idle);
+        CHECK(stalled.stats().frames_truncated == 1);
+        CHECK(stalled.last_sequence() == rig.svc.last_sequence());
+
+        std::vector<std::string> parts;
+        REQUIRE(parse_parts(stalled_sock.out.substr(strlen(HEAD)), &parts));
+        REQUIRE(parts.size() == 2);
+        CHECK(parts[0].size() == rig.frame.size() + JPEG_METADATA_SEGMENT_SIZE);
+        CHECK(parts[0].substr(parts[0].size() - 100) == std::string(100, '\0'));
+        CHECK(part_sequence(parts[1]) == rig.svc.last_sequence());
+        CHECK(parts[1].find(std::string(64, '\0')) == std::string::npos);
+    }
+
+    SECTION("a client that takes nothing for the stall budget is evicted") {
+        Rig rig(0);
+        FakeSocket sock;
+        MjpegSender sender;
+        MjpegSenderConfig config;
+        config.stall_budget_ms = 2000;
+        REQUIRE(sender.begin(rig.svc, &FakeSocket::write, &sock, HEAD, config, rig.now()));
+        REQUIRE(rig.gate.allow(1));
+        sock.budget = strlen(HEAD) + 50;
+        int64_t start = rig.now();
+        CHECK(drain(sender, start) == SendStep::Blocked);
+
+        // Progress restarts the budget
+        sock.budget = 10;
+        CHECK(sender.poll(start + 1500 * MS) == SendStep::Blocked);
+        CHECK(sender.poll(start + 3499 * MS) == SendStep::Blocked);
+        CHECK(sender.poll(start + 3500 * MS) == SendStep::Evicted);
+        CHECK(sender.poll(start + 3600 * MS) == SendStep::Closed);
+
+        // Its frame is free again: the ring keeps turning
+        REQUIRE(rig.gate.allow(3));
+        CHECK(rig.svc.last_sequence() == 4);
+    }
+
+    SECTION("idle time does not count against the budget") {
+        Rig rig(0);
+        FakeSocket sock;
+        MjpegSender sender;
+        MjpegSenderConfig config;
+        config.stall_budget_ms = 1000;
+        REQUIRE(sender.begin(rig.svc, &FakeSocket::write, &sock, HEAD, config, rig.now()));
+        CHECK(drain(sender, 0) == SendStep::Idle);
+        REQUIRE(rig.gate.allow(1));
+        sock.budget = 0;
+        CHECK(sender.poll(60000 * MS) == SendStep::Blocked);
+        sock.budget = SIZE_MAX;
+        CHECK(sender.poll(60500 * MS) == SendStep::Sent);
+    }
+}
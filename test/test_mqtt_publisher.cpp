@@ -0,0 +1,485 @@
+/**
+ * @file test_mqtt_publisher.cpp
+ * @brief Unit tests for MqttPublisher against a loopback stand-in broker
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/mqtt_publisher.hpp"
+#include "mocks/mock_clock.hpp"
+#include "fixtures/loopback_mqtt.hpp"
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace mocks;
+using namespace fixtures;
+
+namespace {
+
+std::vector<uint8_t> make_frame(uint32_t sequence, size_t size) {
+    std::vector<uint8_t> frame(size);
+    for (size_t i = 0; i < size; i++) frame[i] = static_cast<uint8_t>(sequence * 31 + i);
+    return frame;
+}
+
+bool wait_until(const std::function<bool()>& done, int timeout_ms = 5000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (done()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return done();
+}
+
+// Publishes are counted once handed to the socket; wait for the broker to read them
+bool wait_received(LoopbackMqttBroker& broker, const char* topic, size_t count) {
+    return wait_until([&] { return broker.messages(topic).size() >= count; });
+}
+
+struct Reassembled {
+    uint32_t sequence = 0;
+    int64_t timestamp_us = 0;
+    std::vector<uint8_t> data;
+};
+
+// Complete frames from the chunks on the frame topic, in arrival order;
+// REQUIREs that chunks of one frame arrive in order and agree on the header
+std::vector<Reassembled> reassemble(const std::vector<MqttMessage>& chunks) {
+    std::vector<Reassembled> frames;
+    Reassembled current;
+    uint16_t expected = 0;
+    uint32_t total = 0;
+    for (const auto& msg : chunks) {
+        MqttChunkHeader h;
+        REQUIRE(mqtt_parse_chunk_header(msg.payload.data(), msg.payload.size(), &h));
+        if (h.index == 0) {
+            current = {h.sequence, h.timestamp_us, {}};
+            total = h.total_size;
+            expected = 0;
+        }
+        REQUIRE(h.index == expected);
+        REQUIRE(h.sequence == current.sequence);
+        current.data.insert(current.data.end(), msg.payload.begin() + MQTT_CHUNK_HEADER_SIZE,
+                            msg.payload.end());
+        expected++;
+        if (expected == h.count) {
+            REQUIRE(current.data.size() == total);
+            frames.push_back(current);
+        }
+    }
+    return frames;
+}
+
+MqttPublisherConfig test_config() {
+    MqttPublisherConfig cfg;
+    cfg.frame_topic = "cam/frame";
+    cfg.event_topic = "cam/event";
+    cfg.status_topic = "cam/status";
+    cfg.max_frame_size = 64 * 1024;
+    cfg.chunk_size = 4 * 1024;
+    cfg.max_inflight = 4;
+    cfg.ack_timeout_ms = 60000;
+    return cfg;
+}
+
+} // namespace
+
+//=============================================================================
+// Chunk Header Tests
+//=============================================================================
+
+TEST_CASE("MQTT chunk header", "[mqtt][chunk]") {
+    SECTION("round trip is big-endian") {
+        MqttChunkHeader h;
+        h.sequence = 0x01020304;
+        h.index = 2;
+        h.count = 5;
+        h.total_size = 70000;
+        h.timestamp_us = 0x0000000A0B0C0D0ELL;
+        uint8_t buf[MQTT_CHUNK_HEADER_SIZE];
+        mqtt_write_chunk_header(h, buf);
+        REQUIRE(buf[0] == 0x01);
+        REQUIRE(buf[3] == 0x04);
+        REQUIRE(buf[19] == 0x0E);
+
+        MqttChunkHeader out;
+        REQUIRE(mqtt_parse_chunk_header(buf, sizeof(buf), &out));
+        REQUIRE(out.sequence == h.sequence);
+        REQUIRE(out.index == 2);
+        REQUIRE(out.count == 5);
+        REQUIRE(out.total_size == 70000);
+        REQUIRE(out.timestamp_us == h.timestamp_us);
+    }
+
+    SECTION("short or inconsistent headers rejected") {
+        uint8_t buf[MQTT_CHUNK_HEADER_SIZE] = {};
+        MqttChunkHeader out;
+        REQUIRE_FALSE(mqtt_parse_chunk_header(buf, sizeof(buf) - 1, &out));
+        REQUIRE_FALSE(mqtt_parse_chunk_header(buf, sizeof(buf), &out));   // count 0
+
+        MqttChunkHeader h;
+        h.index = 3;
+        h.count = 3;
+        mqtt_write_chunk_header(h, buf);
+        REQUIRE_FALSE(mqtt_parse_chunk_header(buf, sizeof(buf), &out));
+    }
+}
+
+//=============================================================================
+// Lifecycle Tests
+//=============================================================================
+
+TEST_CASE("MqttPublisher lifecycle", "[mqtt][init]") {
+    SocketMqttClient client(1);
+    MockClock clock;
+
+    SECTION("invalid config rejected") {
+        MqttPublisher pub(client, clock);
+        MqttPublisherConfig cfg = test_config();
+        cfg.max_inflight = 0;
+        REQUIRE_FALSE(pub.init(cfg));
+        cfg = test_config();
+        cfg.max_inflight = MqttPublisher::MAX_INFLIGHT + 1;
+        REQUIRE_FALSE(pub.init(cfg));
+        cfg = test_config();
+        cfg.event_qos = 2;
+        REQUIRE_FALSE(pub.init(cfg));
+        cfg = test_config();
+        cfg.chunk_size = 1;
+        cfg.max_frame_size = 0x10000 + 1;
+        REQUIRE_FALSE(pub.init(cfg));
+    }
+
+    SECTION("start and stop without a broker") {
+        MqttPublisher pub(client, clock);
+        REQUIRE(pub.init(test_config(), false));
+        REQUIRE(pub.start());
+        REQUIRE(pub.is_running());
+        pub.stop();
+        REQUIRE_FALSE(pub.is_running());
+    }
+
+    SECTION("oversized frames and events rejected") {
+        MqttPublisher pub(client, clock);
+        REQUIRE(pub.init(test_config(), false));
+        REQUIRE(pub.start());
+        auto big = make_frame(1, 64 * 1024 + 1);
+        pub.on_frame(big.data(), big.size(), 0, 1);
+        REQUIRE(pub.stats().frames_rejected.load() == 1);
+
+        std::string event(MqttPublisher::MAX_EVENT_SIZE, 'x');
+        REQUIRE_FALSE(pub.publish_event(event.c_str()));
+        REQUIRE_FALSE(pub.publish_event(""));
+    }
+}
+
+//=============================================================================
+// Publishing Tests
+//=============================================================================
+
+TEST_CASE("MqttPublisher chunks frames", "[mqtt][frames]") {
+    LoopbackMqttBroker broker;
+    REQUIRE(broker.start());
+    SocketMqttClient client(broker.port());
+    REQUIRE(client.connect());
+    MockClock clock;
+    MqttPublisher pub(client, clock);
+
+    SECTION("frames are reassembled byte-exact") {
+        REQUIRE(pub.init(test_config(), false));
+        REQUIRE(pub.start());
+
+        // 10000 bytes at 4K chunks: 3 messages, last one short
+        auto frame = make_frame(7, 10000);
+        pub.on_frame(frame.data(), frame.size(), 123456, 7);
+        REQUIRE(wait_until([&] { return pub.stats().frames_published.load() == 1; }));
+        REQUIRE(wait_received(broker, "cam/frame", 3));
+        pub.stop();
+
+        auto chunks = broker.messages("cam/frame");
+        REQUIRE(chunks.size() == 3);
+        REQUIRE(chunks[2].payload.size() == MQTT_CHUNK_HEADER_SIZE + 10000 - 2 * 4096);
+        auto frames = reassemble(chunks);
+        REQUIRE(frames.size() == 1);
+        REQUIRE(frames[0].sequence == 7);
+        REQUIRE(frames[0].timestamp_us == 123456);
+        REQUIRE(frames[0].data == frame);
+        REQUIRE(pub.stats().chunks_published.load() == 3);
+    }
+
+    SECTION("consecutive frames keep their identity") {
+        REQUIRE(pub.init(test_config(), false));
+        REQUIRE(pub.start());
+        std::vector<std::vector<uint8_t>> sent;
+        for (uint32_t seq = 1; seq <= 5; seq++) {
+            sent.push_back(make_frame(seq, 3000 + seq * 1500));
+            pub.on_frame(sent.back().data(), sent.back().size(), seq * 1000, seq);
+            REQUIRE(wait_until([&] { return pub.stats().frames_published.load() == seq; }));
+        }
+        REQUIRE(wait_received(broker, "cam/frame", pub.stats().chunks_published.load()));
+        pub.stop();
+
+        auto frames = reassemble(broker.messages("cam/frame"));
+        REQUIRE(frames.size() == 5);
+        for (size_t i = 0; i < 5; i++) {
+            REQUIRE(frames[i].sequence == i + 1);
+            REQUIRE(frames[i].data == sent[i]);
+        }
+    }
+
+    SECTION("frames disabled publishes nothing on the frame topic") {
+        MqttPublisherConfig cfg = test_config();
+        cfg.publish_frames = false;
+        REQUIRE(pub.init(cfg, false));
+        REQUIRE(pub.start());
+        auto frame = make_frame(1, 1000);
+        pub.on_frame(frame.data(), frame.size(), 0, 1);
+        REQUIRE(pub.publish_event("{\"type\":\"test\"}"));
+        REQUIRE(wait_until([&] { return pub.stats().events_published.load() == 1; }));
+        pub.stop();
+        REQUIRE(broker.messages("cam/frame").empty());
+        REQUIRE(pub.stats().frames_offered.load() == 0);
+    }
+}
+
+TEST_CASE("MqttPublisher events", "[mqtt][events]") {
+    LoopbackMqttBroker broker;
+    REQUIRE(broker.start());
+    SocketMqttClient client(broker.port());
+    REQUIRE(client.connect());
+    MockClock clock;
+    MqttPublisher pub(client, clock);
+    REQUIRE(pub.init(test_config(), false));
+
+    SECTION("single event is published as-is at QoS 1") {
+        REQUIRE(pub.start());
+        REQUIRE(pub.publish_event("{\"type\":\"motion\",\"score\":42}"));
+        REQUIRE(wait_until([&] { return pub.stats().acks.load() == 1; }));
+        pub.stop();
+
+        auto msgs = broker.messages("cam/event");
+        REQUIRE(msgs.size() == 1);
+        REQUIRE(msgs[0].qos == 1);
+        REQUIRE(std::string(msgs[0].payload.begin(), msgs[0].payload.end()) ==
+                "{\"type\":\"motion\",\"score\":42}");
+        REQUIRE(pub.stats().inflight.load() == 0);
+    }
+
+    SECTION("queued events are batched into one array") {
+        // Queue before start so the task sees them all at once
+        REQUIRE(pub.publish_event("{\"n\":1}"));
+        REQUIRE(pub.publish_event("{\"n\":2}"));
+        REQUIRE(pub.publish_event("{\"n\":3}"));
+        REQUIRE(pub.start());
+        REQUIRE(wait_until([&] { return pub.stats().events_published.load() == 3; }));
+        REQUIRE(wait_received(broker, "cam/event", 1));
+        pub.stop();
+
+        auto msgs = broker.messages("cam/event");
+        REQUIRE(msgs.size() == 1);
+        REQUIRE(std::string(msgs[0].payload.begin(), msgs[0].payload.end()) ==
+                "[{\"n\":1},{\"n\":2},{\"n\":3}]");
+        REQUIRE(pub.stats().event_batches.load() == 1);
+    }
+
+    SECTION("full queue drops the oldest event") {
+        for (size_t i = 0; i < MqttPublisher::MAX_QUEUED_EVENTS + 3; i++) {
+            char json[32];
+            snprintf(json, sizeof(json), "{\"n\":%zu}", i);
+            REQUIRE(pub.publish_event(json));
+        }
+        REQUIRE(pub.stats().events_dropped.load() == 3);
+        REQUIRE(pub.start());
+        REQUIRE(wait_until([&] {
+            return pub.stats().events_published.load() == MqttPublisher::MAX_QUEUED_EVENTS;
+        }));
+        REQUIRE(wait_received(broker, "cam/event", pub.stats().event_batches.load()));
+        pub.stop();
+
+        std::string all;
+        for (const auto& m : broker.messages("cam/event")) all.append(m.payload.begin(), m.payload.end());
+        REQUIRE(all.find("{\"n\":2}") == std::string::npos);
+        REQUIRE(all.find("{\"n\":3}") != std::string::npos);
+        REQUIRE(all.find("{\"n\":18}") != std::string::npos);
+    }
+}
+
+TEST_CASE("MqttPublisher status deltas", "[mqtt][status]") {
+    LoopbackMqttBroker broker;
+    REQUIRE(broker.start());
+    SocketMqttClient client(broker.port());
+    REQUIRE(client.connect());
+    MockClock clock;
+    MqttPublisher pub(client, clock);
+    REQUIRE(pub.init(test_config(), false));
+    REQUIRE(pub.start());
+
+    auto status_text = [&](size_t i) {
+        REQUIRE(wait_received(broker, "cam/status", i + 1));
+        auto msgs = broker.messages("cam/status");
+        return std::string(msgs[i].payload.begin(), msgs[i].payload.end());
+    };
+
+    StatusSnapshot snap;
+    snap.set(StatusField::Captured, 10);
+    snap.set(StatusField::Heap, 50000);
+    pub.publish_status(snap);
+    REQUIRE(wait_until([&] { return pub.stats().status_published.load() == 1; }));
+    REQUIRE(status_text(0).find("\"heap\":50000") != std::string::npos);
+    REQUIRE(status_text(0).find("\"rssi\":0") != std::string::npos);   // Full snapshot first
+
+    SECTION("only changed fields follow") {
+        snap.set(StatusField::Captured, 11);
+        pub.publish_status(snap);
+        REQUIRE(wait_until([&] { return pub.stats().status_published.load() == 2; }));
+        REQUIRE(status_text(1) == "{\"captured\":11}");
+
+        pub.publish_status(snap);   // Unchanged: nothing sent
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        REQUIRE(pub.stats().status_published.load() == 2);
+    }
+
+    SECTION("reconnect resends a full snapshot") {
+        broker.drop_client();
+        REQUIRE(wait_until([&] { return !client.connected(); }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));   // Task notices
+        REQUIRE(client.connect());
+        REQUIRE(wait_until([&] { return pub.stats().status_published.load() == 2; }));
+        REQUIRE(status_text(1).find("\"heap\":50000") != std::string::npos);
+    }
+    pub.stop();
+}
+
+//=============================================================================
+// Flow Control Tests
+//=============================================================================
+
+TEST_CASE("MqttPublisher bounds in-flight messages", "[mqtt][inflight]") {
+    LoopbackMqttBroker broker;
+    REQUIRE(broker.start());
+    SocketMqttClient client(broker.port());
+    REQUIRE(client.connect());
+    MockClock clock;
+    MqttPublisher pub(client, clock);
+    MqttPublisherConfig cfg = test_config();
+    cfg.frame_qos = 1;
+    cfg.max_inflight = 3;
+
+    SECTION("slow broker never sees more than max_inflight unacked") {
+        REQUIRE(pub.init(cfg, false));
+        REQUIRE(pub.start());
+        broker.set_hold_acks(true);
+
+        // 8 chunks per frame; only 3 may go out before acks come back
+        auto frame = make_frame(1, 32 * 1024);
+        pub.on_frame(frame.data(), frame.size(), 0, 1);
+        REQUIRE(wait_until([&] { return broker.held_acks() == 3; }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        REQUIRE(broker.held_acks() == 3);
+        REQUIRE(pub.stats().inflight.load() == 3);
+
+        // Acks trickle in; the frame completes without exceeding the window
+        while (pub.stats().frames_published.load() == 0) {
+            broker.release_acks();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        broker.release_acks();
+        pub.stop();
+
+        REQUIRE(broker.max_unacked() == 3);
+        auto frames = reassemble(broker.messages("cam/frame"));
+        REQUIRE(frames.size() == 1);
+        REQUIRE(frames[0].data == frame);
+    }
+
+    SECTION("unacknowledged slots are reclaimed after the timeout") {
+        cfg.ack_timeout_ms = 2;
+        REQUIRE(pub.init(cfg, false));
+        clock.set_auto_advance_us(1000);
+        REQUIRE(pub.start());
+        broker.set_hold_acks(true);
+
+        auto frame = make_frame(1, 32 * 1024);
+        pub.on_frame(frame.data(), frame.size(), 0, 1);
+        REQUIRE(wait_until([&] { return pub.stats().frames_published.load() == 1; }));
+        REQUIRE(wait_received(broker, "cam/frame", 8));
+        pub.stop();
+
+        REQUIRE(pub.stats().ack_timeouts.load() >= 5);
+        REQUIRE(broker.messages("cam/frame").size() == 8);
+    }
+}
+
+TEST_CASE("MqttPublisher never stalls the producer", "[mqtt][backpressure]") {
+    LoopbackMqttBroker broker;
+    REQUIRE(broker.start());
+    SocketMqttClient client(broker.port());
+    REQUIRE(client.connect());
+    MockClock clock;
+    MqttPublisher pub(client, clock);
+    MqttPublisherConfig cfg = test_config();
+    cfg.chunk_size = 16 * 1024;
+    REQUIRE(pub.init(cfg, false));
+    REQUIRE(pub.start());
+
+    SECTION("stalled broker: frames superseded, events bounded") {
+        broker.set_paused(true);
+
+        // Enough data to fill the socket buffers and block the task in publish()
+        auto frame = make_frame(1, 60 * 1024);
+        auto worst = std::chrono::nanoseconds(0);
+        for (uint32_t seq = 1; seq <= 400; seq++) {
+            auto t0 = std::chrono::steady_clock::now();
+            pub.on_frame(frame.data(), frame.size(), seq, seq);
+            pub.publish_event("{\"type\":\"tick\"}");
+            auto dt = std::chrono::steady_clock::now() - t0;
+            if (dt > worst) worst = dt;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        REQUIRE(worst < std::chrono::milliseconds(50));
+        REQUIRE(pub.stats().frames_offered.load() == 400);
+        REQUIRE(pub.stats().frames_superseded.load() > 0);
+        REQUIRE(pub.stats().events_dropped.load() > 0);
+
+        broker.set_paused(false);
+        REQUIRE(wait_until([&] {
+            return pub.stats().frames_published.load() + pub.stats().frames_superseded.load() +
+                   pub.stats().frames_abandoned.load() == 400;
+        }));
+        REQUIRE(wait_received(broker, "cam/frame", pub.stats().chunks_published.load()));
+        pub.stop();
+
+        // Everything that made it out is intact
+        auto frames = reassemble(broker.messages("cam/frame"));
+        REQUIRE(frames.size() == pub.stats().frames_published.load());
+        for (const auto& f : frames) REQUIRE(f.data == frame);
+    }
+
+    SECTION("disconnected: producer keeps going, nothing is sent") {
+        client.disconnect();
+        auto frame = make_frame(1, 8 * 1024);
+        for (uint32_t seq = 1; seq <= 50; seq++) {
+            pub.on_frame(frame.data(), frame.size(), seq, seq);
+            pub.publish_event("{\"type\":\"tick\"}");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        REQUIRE(pub.stats().frames_published.load() == 0);
+        REQUIRE(pub.stats().frames_superseded.load() == 49);
+        REQUIRE(pub.stats().events_dropped.load() == 50 - MqttPublisher::MAX_QUEUED_EVENTS);
+
+        // On reconnect the newest frame and the queued events go out
+        REQUIRE(client.connect());
+        REQUIRE(wait_until([&] {
+            return pub.stats().frames_published.load() == 1 &&
+                   pub.stats().events_published.load() == MqttPublisher::MAX_QUEUED_EVENTS;
+        }));
+        REQUIRE(wait_received(broker, "cam/frame", 1));
+        pub.stop();
+        auto frames = reassemble(broker.messages("cam/frame"));
+        REQUIRE(frames.size() == 1);
+        REQUIRE(frames[0].sequence == 50);
+    }
+}
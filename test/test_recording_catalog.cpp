@@ -0,0 +1,667 @@
+/**
+ * @file test_recording_catalog.cpp
+ * @brief Unit tests and benchmarks for RecordingCatalog and ClipReader
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/recording_catalog.hpp"
+#include "../main/core/flash_recorder.hpp"
+#include "fixtures/file_flash.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace fixtures;
+
+namespace {
+
+constexpr size_t SEGMENT = 16 * 1024;
+constexpr int64_t SECOND = 1000 * 1000;
+
+// Grayscale scene: flat background (mean luma 128) with a bright 2x2-block
+// square at block column `square_x` (-1 = none)
+std::vector<uint8_t> make_scene(int square_x, uint16_t width = 64, uint16_t height = 48) {
+    SyntheticJpegSpec spec;
+    spec.width = width;
+    spec.height = height;
+    spec.components = 1;
+    JpegInfo info = make_synthetic_info(spec);   // Luma DC quantizer 4: mean = 128 + DC / 2
+    return encode_blocks(info, [square_x](const JpegInfo& inf, uint32_t mcu, int16_t (*blocks)[64]) {
+        for (int k = 0; k < 64; k++) blocks[0][k] = 0;
+        int bx = static_cast<int>(mcu % inf.mcus_x);
+        int by = static_cast<int>(mcu / inf.mcus_x);
+        if (square_x >= 0 && bx >= square_x && bx < square_x + 2 && by >= 2 && by < 4) {
+            blocks[0][0] = 120;   // Mean luma 188
+        }
+    });
+}
+
+// Frame store + index store on one flash, split like the device does
+struct Rig {
+    FileFlash flash;
+    BlockStorageRegion frame_region;
+    BlockStorageRegion index_region;
+    SegmentStore frames;
+    SegmentStore index;
+
+    Rig(size_t frame_bytes, size_t index_bytes)
+        : flash(frame_bytes + index_bytes),
+          frame_region(flash, 0, frame_bytes),
+          index_region(flash, frame_bytes, index_bytes),
+          frames(frame_region),
+          index(index_region) {
+        mount();
+    }
+
+    bool mount() {
+        return frames.mount({.segment_size = SEGMENT, .spare_segments = 1}) &&
+               index.mount({.segment_size = SEGMENT, .spare_segments = 1});
+    }
+
+    void unmount() {
+        frames.unmount();
+        index.unmount();
+    }
+
+    // What FlashRecorder does per frame
+    uint32_t record(RecordingCatalog& catalog, const std::vector<uint8_t>& jpeg, int64_t ts) {
+        uint32_t seq = frames.append(jpeg.data(), jpeg.size(), ts);
+        if (seq) catalog.on_record(seq, ts, jpeg.data(), jpeg.size());
+        while (frames.service() || catalog.service()) {}
+        return seq;
+    }
+};
+
+std::vector<ClipSummary> query_all(RecordingCatalog& catalog, int64_t from, int64_t to) {
+    std::vector<ClipSummary> out(catalog.config().max_clips);
+    out.resize(catalog.query(from, to, out.data(), out.size()));
+    return out;
+}
+
+bool wait_until(const std::function<bool()>& done, int timeout_ms = 5000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (done()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return done();
+}
+
+} // namespace
+
+//=============================================================================
+// Parsing Tests
+//=============================================================================
+
+TEST_CASE("Recording paths and byte ranges", "[recording_catalog][parse]") {
+    uint32_t id = 0;
+    char name[16];
+
+    SECTION("recording paths") {
+        REQUIRE(parse_recording_path("/recordings/42.mjpeg", &id, name, sizeof(name)));
+        REQUIRE(id == 42);
+        REQUIRE(std::string(name) == "mjpeg");
+        REQUIRE(parse_recording_path("/recordings/7/thumb?n=2", &id, name, sizeof(name)));
+        REQUIRE(id == 7);
+        REQUIRE(std::string(name) == "thumb");
+
+        REQUIRE_FALSE(parse_recording_path("/recordings/", &id, name, sizeof(name)));
+        REQUIRE_FALSE(parse_recording_path("/recordings/0.mjpeg", &id, name, sizeof(name)));
+        REQUIRE_FALSE(parse_recording_path("/recordings/x.mjpeg", &id, name, sizeof(name)));
+        REQUIRE_FALSE(parse_recording_path("/recordings/42", &id, name, sizeof(name)));
+        REQUIRE_FALSE(parse_recording_path("/recordings/42.", &id, name, sizeof(name)));
+        REQUIRE_FALSE(parse_recording_path("/recordings/42/thumb/x", &id, name, sizeof(name)));
+        REQUIRE_FALSE(parse_recording_path("/recordings/99999999999.mjpeg", &id, name, sizeof(name)));
+        REQUIRE_FALSE(parse_recording_path("/recordings/1.averyveryverylongname", &id, name, sizeof(name)));
+    }
+
+    SECTION("from/to seconds") {
+        int64_t us = -1;
+        REQUIRE(parse_unix_seconds("1700000000", &us));
+        REQUIRE(us == 1700000000LL * 1000000);
+        REQUIRE(parse_unix_seconds("0", &us));
+        REQUIRE(us == 0);
+        REQUIRE(parse_unix_seconds("9223372036854", &us));   // Largest that fits
+        REQUIRE(us == 9223372036854LL * 1000000);
+
+        us = 7;
+        REQUIRE_FALSE(parse_unix_seconds("9223372036855", &us));   // Would overflow
+        REQUIRE_FALSE(parse_unix_seconds("99999999999999999999999", &us));
+        REQUIRE_FALSE(parse_unix_seconds("-5", &us));
+        REQUIRE_FALSE(parse_unix_seconds("12x", &us));
+        REQUIRE_FALSE(parse_unix_seconds("", &us));
+        REQUIRE(us == 7);
+    }
+
+    SECTION("byte ranges") {
+        uint64_t first = 0, last = 0;
+        REQUIRE(parse_byte_range("bytes=0-99", 1000, &first, &last) == ByteRange::Partial);
+        REQUIRE((first == 0 && last == 99));
+        REQUIRE(parse_byte_range("bytes=900-", 1000, &first, &last) == ByteRange::Partial);
+        REQUIRE((first == 900 && last == 999));
+        REQUIRE(parse_byte_range("bytes=500-5000", 1000, &first, &last) == ByteRange::Partial);
+        REQUIRE(last == 999);
+        REQUIRE(parse_byte_range("bytes=-100", 1000, &first, &last) == ByteRange::Partial);
+        REQUIRE((first == 900 && last == 999));
+        REQUIRE(parse_byte_range("bytes=-5000", 1000, &first, &last) == ByteRange::Partial);
+        REQUIRE(first == 0);
+
+        REQUIRE(parse_byte_range("bytes=1000-", 1000, &first, &last) == ByteRange::Unsatisfiable);
+        REQUIRE(parse_byte_range("bytes=-0", 1000, &first, &last) == ByteRange::Unsatisfiable);
+
+        REQUIRE(parse_byte_range(nullptr, 1000, &first, &last) == ByteRange::Full);
+        REQUIRE(parse_byte_range("items=0-1", 1000, &first, &last) == ByteRange::Full);
+        REQUIRE(parse_byte_range("bytes=0-1,5-6", 1000, &first, &last) == ByteRange::Full);
+        REQUIRE(parse_byte_range("bytes=5-1", 1000, &first, &last) == ByteRange::Full);
+        REQUIRE(parse_byte_range("bytes=abc", 1000, &first, &last) == ByteRange::Full);
+    }
+
+    SECTION("clip JSON") {
+        ClipSummary clip;
+        clip.id = 3;
+        clip.start_us = 1500 * SECOND;
+        clip.end_us = 1510 * SECOND;
+        clip.frames = 4;
+        clip.motion_sum = 30;
+        clip.motion_max = 20;
+        clip.thumbnails = 2;
+        char json[256];
+        REQUIRE(format_clip_json(clip, json, sizeof(json)) > 0);
+        REQUIRE(std::string(json) ==
+                "{\"id\":3,\"start_ms\":1500000,\"end_ms\":1510000,\"frames\":4,"
+                "\"motion_max\":20,\"motion_mean\":7,\"thumbnails\":2,\"open\":false}");
+        REQUIRE(format_clip_json(clip, json, 16) == 0);
+    }
+}
+
+//=============================================================================
+// Clip Tests
+//=============================================================================
+
+TEST_CASE("RecordingCatalog groups frames into clips", "[recording_catalog][clips]") {
+    Rig rig(64 * SEGMENT, 16 * SEGMENT);
+    RecordingCatalog catalog(rig.frames, rig.index);
+    REQUIRE(catalog.init({.max_clips = 64, .clip_gap_ms = 3000, .max_clip_duration_ms = 10000,
+                          .thumbnail_interval_ms = 0}, false));
+    auto scene = make_scene(-1);
+
+    SECTION("a pause or the length limit ends a clip") {
+        for (int s = 0; s < 5; s++) rig.record(catalog, scene, (100 + s) * SECOND);    // Clip 1
+        for (int s = 0; s < 25; s++) rig.record(catalog, scene, (200 + s) * SECOND);   // 2, 3, 4 (split)
+
+        auto clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(clips.size() == 4);
+        REQUIRE(clips[0].id == 1);
+        REQUIRE(clips[0].start_us == 100 * SECOND);
+        REQUIRE(clips[0].end_us == 104 * SECOND);
+        REQUIRE(clips[0].frames == 5);
+        REQUIRE((clips[0].first_sequence == 1 && clips[0].last_sequence == 5));
+        REQUIRE_FALSE(clips[0].open);
+        REQUIRE(clips[1].start_us == 200 * SECOND);
+        REQUIRE(clips[1].frames == 10);
+        REQUIRE(clips[2].start_us == 210 * SECOND);
+        REQUIRE(clips[3].frames == 5);
+        REQUIRE(clips[3].open);
+        REQUIRE(catalog.stats().clips_closed.load() == 3);
+        for (const auto& clip : clips) REQUIRE(clip.thumbnails == 1);
+    }
+
+    SECTION("range queries return the overlapping clips") {
+        for (int c = 0; c < 10; c++) {
+            for (int s = 0; s < 3; s++) rig.record(catalog, scene, (c * 100 + s) * SECOND);
+        }
+        auto clips = query_all(catalog, 150 * SECOND, 401 * SECOND);
+        REQUIRE(clips.size() == 3);   // Clip at 100 ends before 150; clip at 400 overlaps
+        REQUIRE(clips[0].start_us == 200 * SECOND);
+        REQUIRE(clips[2].start_us == 400 * SECOND);
+
+        REQUIRE(query_all(catalog, 101 * SECOND, 101 * SECOND).size() == 1);   // Inside a clip
+        REQUIRE(query_all(catalog, 50 * SECOND, 60 * SECOND).empty());         // Between clips
+        REQUIRE(query_all(catalog, 5000 * SECOND, INT64_MAX).empty());
+        REQUIRE(query_all(catalog, 300 * SECOND, 200 * SECOND).empty());
+
+        ClipSummary page[4];
+        bool more = false;
+        REQUIRE(catalog.query(0, INT64_MAX, page, 4, &more) == 4);
+        REQUIRE(more);
+        REQUIRE(catalog.query(page[3].end_us + 1, INT64_MAX, page, 4, &more) == 4);
+        REQUIRE(page[0].id == 5);
+        REQUIRE(catalog.query(page[3].end_us + 1, INT64_MAX, page, 4, &more) == 2);
+        REQUIRE_FALSE(more);
+
+        ClipSummary found;
+        REQUIRE(catalog.find(7, &found));
+        REQUIRE(found.start_us == 600 * SECOND);
+        REQUIRE_FALSE(catalog.find(11, &found));
+    }
+
+    SECTION("the index keeps the newest max_clips") {
+        for (int c = 0; c < 80; c++) rig.record(catalog, scene, c * 10 * SECOND);
+        REQUIRE(catalog.clip_count() == 64);
+        auto clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(clips.front().id == 17);
+        REQUIRE(clips.back().id == 80);
+    }
+
+    SECTION("the recorder feeds the catalog") {
+        FlashRecorder recorder(rig.frames);
+        REQUIRE(recorder.init({.max_frame_size = 8 * 1024, .frame_interval_ms = 0}, false));
+        recorder.set_catalog(&catalog);
+        REQUIRE(recorder.start());
+        for (uint32_t n = 1; n <= 6; n++) {
+            int64_t ts = (n <= 3 ? n : 100 + n) * SECOND;
+            recorder.on_frame(scene.data(), scene.size(), ts, n);
+            REQUIRE(wait_until([&] { return recorder.stats().frames_recorded.load() == n; }));
+        }
+        recorder.stop();
+        auto clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(clips.size() == 2);
+        REQUIRE(clips[0].frames == 3);
+        REQUIRE(clips[1].frames == 3);
+        REQUIRE(catalog.stats().frames_indexed.load() == 6);
+    }
+}
+
+//=============================================================================
+// Scale Tests
+//=============================================================================
+
+TEST_CASE("RecordingCatalog over thousands of clips", "[recording_catalog][scale]") {
+    constexpr int CLIPS = 3000;
+    Rig rig(256 * SEGMENT, 128 * SEGMENT);
+    RecordingCatalog catalog(rig.frames, rig.index);
+    REQUIRE(catalog.init({.max_clips = 4096, .clip_gap_ms = 5000, .max_clip_duration_ms = 60000,
+                          .thumbnail_interval_ms = 0}, false));
+
+    // Clip c: 1-3 frames a second apart, starting at irregular times
+    std::mt19937 rng(7);
+    std::vector<std::pair<int64_t, int64_t>> truth;
+    int64_t t = 1700000000LL * SECOND;
+    auto scene = make_scene(-1);
+    for (int c = 0; c < CLIPS; c++) {
+        t += (10 + rng() % 600) * SECOND;
+        int frames = 1 + static_cast<int>(rng() % 3);
+        for (int f = 0; f < frames; f++) REQUIRE(rig.record(catalog, scene, t + f * SECOND));
+        truth.emplace_back(t, t + (frames - 1) * SECOND);
+        t += (frames - 1) * SECOND;
+    }
+    REQUIRE(catalog.clip_count() == CLIPS);
+    REQUIRE(rig.frames.stats().records_reclaimed.load() == 0);
+
+    SECTION("random ranges match a linear scan") {
+        std::vector<ClipSummary> out(CLIPS);
+        for (int q = 0; q < 500; q++) {
+            int64_t a = truth.front().first - 1000 * SECOND +
+                        static_cast<int64_t>(rng() % static_cast<uint64_t>(t - truth.front().first + 2000 * SECOND));
+            int64_t b = a + static_cast<int64_t>(rng() % 7200) * SECOND;
+            size_t n = catalog.query(a, b, out.data(), out.size());
+            size_t expected_first = 0, expected = 0;
+            for (size_t i = 0; i < truth.size(); i++) {
+                if (truth[i].second >= a && truth[i].first <= b) {
+                    if (expected == 0) expected_first = i;
+                    expected++;
+                }
+            }
+            REQUIRE(n == expected);
+            if (n > 0) {
+                REQUIRE(out[0].id == expected_first + 1);
+                REQUIRE(out[0].start_us == truth[expected_first].first);
+                REQUIRE(out[n - 1].end_us == truth[expected_first + n - 1].second);
+            }
+        }
+    }
+
+    SECTION("the index reloads from flash") {
+        catalog.close_clip();
+        catalog.deinit();
+        rig.unmount();
+        REQUIRE(rig.mount());
+        RecordingCatalog again(rig.frames, rig.index);
+        REQUIRE(again.init(catalog.config(), false));
+        REQUIRE(again.clip_count() == CLIPS);
+        REQUIRE(again.stats().clips_recovered.load() == 0);
+        auto clips = query_all(again, 0, INT64_MAX);
+        for (size_t i = 0; i < clips.size(); i++) {
+            REQUIRE(clips[i].id == i + 1);
+            REQUIRE(clips[i].start_us == truth[i].first);
+            REQUIRE(clips[i].end_us == truth[i].second);
+        }
+    }
+}
+
+//=============================================================================
+// Motion / Thumbnail Tests
+//=============================================================================
+
+TEST_CASE("RecordingCatalog motion and thumbnails", "[recording_catalog][motion]") {
+    Rig rig(64 * SEGMENT, 16 * SEGMENT);
+    RecordingCatalog catalog(rig.frames, rig.index);
+    REQUIRE(catalog.init({.max_clips = 16, .clip_gap_ms = 5000, .max_clip_duration_ms = 600000,
+                          .thumbnail_interval_ms = 10000}, false));
+
+    SECTION("static scene has no motion, a moving square does") {
+        for (int s = 0; s < 5; s++) rig.record(catalog, make_scene(2), s * SECOND);
+        for (int s = 0; s < 5; s++) rig.record(catalog, make_scene(2 + s), (100 + s) * SECOND);
+        auto clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(clips.size() == 2);
+        REQUIRE(clips[0].motion_max == 0);
+        // 8x6 blocks; a 2x2 square moving one block changes 4 of 48
+        REQUIRE(clips[1].motion_max == 4 * 100 / 48);
+        REQUIRE(clips[1].motion_mean() == 4 * 100 / 48 * 4 / 5);
+    }
+
+    SECTION("thumbnails every interval, at 1/8 scale") {
+        for (int s = 0; s < 25; s++) rig.record(catalog, make_scene(s == 0 ? 3 : -1), s * SECOND);
+        ClipSummary clip;
+        REQUIRE(catalog.find(1, &clip));
+        REQUIRE(clip.thumbnails == 3);   // 0 s, 10 s, 20 s
+        REQUIRE(catalog.stats().thumbnails_written.load() == 3);
+
+        std::vector<uint8_t> buf(CATALOG_THUMBNAIL_HEADER_SIZE + catalog.config().max_thumbnail_size);
+        size_t n = catalog.thumbnail(clip, 0, buf.data(), buf.size());
+        REQUIRE(n > 0);
+        JpegInfo info;
+        REQUIRE(jpeg_parse(buf.data(), n, &info));
+        REQUIRE((info.width == 8 && info.height == 6 && info.num_components == 1));
+        REQUIRE(catalog.thumbnail(clip, 2, buf.data(), buf.size()) > 0);
+        REQUIRE(catalog.thumbnail(clip, 3, buf.data(), buf.size()) == 0);
+#ifdef HAVE_LIBJPEG
+        REQUIRE(catalog.thumbnail(clip, 0, buf.data(), buf.size()) == n);
+        DecodedImage img;
+        REQUIRE(decode_jpeg(buf.data(), n, &img));
+        REQUIRE(std::abs(img.at(0, 0)[0] - 128) <= 4);
+        REQUIRE(img.at(3, 2)[0] > 170);   // The square (188, softened by re-encoding)
+#endif
+    }
+
+    SECTION("frames that are not JPEG still count") {
+        std::vector<uint8_t> junk(500, 0x55);
+        rig.record(catalog, junk, SECOND);
+        auto clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(clips.size() == 1);
+        REQUIRE(clips[0].frames == 1);
+        REQUIRE(clips[0].thumbnails == 0);
+        REQUIRE(catalog.stats().decode_errors.load() == 1);
+    }
+}
+
+//=============================================================================
+// Recovery / Reclamation Tests
+//=============================================================================
+
+TEST_CASE("RecordingCatalog recovery", "[recording_catalog][recovery]") {
+    Rig rig(32 * SEGMENT, 8 * SEGMENT);
+    RecordingCatalogConfig config{.max_clips = 256, .clip_gap_ms = 5000, .max_clip_duration_ms = 60000,
+                                  .thumbnail_interval_ms = 2000};
+    auto scene = make_scene(1);
+
+    SECTION("the clip open at power loss is rebuilt from frame headers") {
+        {
+            RecordingCatalog catalog(rig.frames, rig.index);
+            REQUIRE(catalog.init(config, false));
+            for (int s = 0; s < 3; s++) rig.record(catalog, scene, (10 + s) * SECOND);
+            for (int s = 0; s < 5; s++) rig.record(catalog, scene, (100 + s) * SECOND);   // Open
+        }
+        rig.unmount();
+        REQUIRE(rig.mount());
+        RecordingCatalog catalog(rig.frames, rig.index);
+        REQUIRE(catalog.init(config, false));
+        REQUIRE(catalog.stats().clips_recovered.load() == 1);
+        auto clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(clips.size() == 2);
+        REQUIRE(clips[0].thumbnails == 2);
+        REQUIRE(clips[1].id == 2);
+        REQUIRE(clips[1].frames == 5);
+        REQUIRE(clips[1].start_us == 100 * SECOND);
+        REQUIRE(clips[1].end_us == 104 * SECOND);
+        REQUIRE(clips[1].thumbnails == 3);   // 100, 102, 104 s
+        REQUIRE(clips[1].open);
+
+        // Recording resumes after the reboot in a new clip
+        rig.record(catalog, scene, 500 * SECOND);
+        clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(clips.size() == 3);
+        REQUIRE(clips[2].id == 3);
+        REQUIRE_FALSE(clips[1].open);
+    }
+
+    SECTION("clips leave the index as their frames are reclaimed") {
+        RecordingCatalog catalog(rig.frames, rig.index);
+        REQUIRE(catalog.init(config, false));
+        std::vector<uint8_t> big(3000, 0xAA);   // ~5 per segment: the log wraps quickly
+        for (int c = 0; c < 60; c++) {
+            for (int s = 0; s < 4; s++) rig.record(catalog, big, (c * 100 + s) * SECOND);
+        }
+        REQUIRE(rig.frames.stats().records_reclaimed.load() > 0);
+        RecordInfo oldest;
+        REQUIRE(rig.frames.oldest(&oldest));
+        auto clips = query_all(catalog, 0, INT64_MAX);
+        REQUIRE(catalog.stats().clips_expired.load() > 0);
+        REQUIRE(clips.front().first_sequence == oldest.sequence);
+        REQUIRE(clips.front().start_us == oldest.timestamp_us);
+        REQUIRE(clips.front().frames == clips.front().last_sequence - oldest.sequence + 1);
+        REQUIRE(clips.back().id == 60);
+
+        // And after a remount
+        catalog.deinit();
+        rig.unmount();
+        REQUIRE(rig.mount());
+        RecordingCatalog again(rig.frames, rig.index);
+        REQUIRE(again.init(config, false));
+        auto reloaded = query_all(again, 0, INT64_MAX);
+        REQUIRE(reloaded.size() == clips.size());
+        REQUIRE(reloaded.front().first_sequence == oldest.sequence);
+    }
+}
+
+//=============================================================================
+// Download Tests
+//=============================================================================
+
+TEST_CASE("ClipReader serves clips as byte ranges", "[recording_catalog][download]") {
+    Rig rig(64 * SEGMENT, 16 * SEGMENT);
+    RecordingCatalog catalog(rig.frames, rig.index);
+    REQUIRE(catalog.init({.max_clips = 16, .clip_gap_ms = 5000, .max_clip_duration_ms = 60000,
+                          .thumbnail_interval_ms = 0}, false));
+
+    // Clip 2 is the middle one; its concatenation is the expected file
+    std::vector<uint8_t> expected;
+    rig.record(catalog, make_scene(0), SECOND);
+    for (int s = 0; s < 6; s++) {
+        auto scene = make_scene(s);
+        expected.insert(expected.end(), scene.begin(), scene.end());
+        rig.record(catalog, scene, (100 + s) * SECOND);
+    }
+    rig.record(catalog, make_scene(0), 300 * SECOND);
+    ClipSummary clip;
+    REQUIRE(catalog.find(2, &clip));
+
+    ClipReader reader(rig.frames);
+    REQUIRE(reader.open(clip));
+    REQUIRE(reader.frames() == 6);
+    REQUIRE(reader.size() == expected.size());
+
+    std::vector<uint8_t> buf(rig.frames.max_record_size());
+    auto read_range = [&](uint64_t first, uint64_t last) {
+        std::vector<uint8_t> got;
+        REQUIRE(reader.seek(first));
+        while (got.size() < last - first + 1) {
+            const uint8_t* data = nullptr;
+            size_t n = reader.read(buf.data(), buf.size(), &data);
+            if (n == 0) break;
+            size_t want = static_cast<size_t>(last - first + 1 - got.size());
+            got.insert(got.end(), data, data + (n < want ? n : want));
+        }
+        return got;
+    };
+
+    SECTION("whole file") {
+        auto got = read_range(0, reader.size() - 1);
+        REQUIRE(got == expected);
+    }
+
+    SECTION("ranges inside and across frames") {
+        std::mt19937 rng(3);
+        for (int i = 0; i < 50; i++) {
+            uint64_t a = rng() % expected.size();
+            uint64_t b = a + rng() % (expected.size() - a);
+            auto got = read_range(a, b);
+            REQUIRE(got == std::vector<uint8_t>(expected.begin() + a, expected.begin() + b + 1));
+        }
+        REQUIRE_FALSE(reader.seek(reader.size()));
+    }
+}
+
+TEST_CASE("ClipReader embeds recording metadata", "[recording_catalog][download][metadata]") {
+    Rig rig(64 * SEGMENT, 16 * SEGMENT);
+    RecordingCatalog catalog(rig.frames, rig.index);
+    REQUIRE(catalog.init({.max_clips = 16, .clip_gap_ms = 5000, .max_clip_duration_ms = 60000,
+                          .thumbnail_interval_ms = 0}, false));
+
+    std::vector<std::vector<uint8_t>> scenes;
+    for (int s = 0; s < 4; s++) {
+        scenes.push_back(make_scene(s));
+        rig.record(catalog, scenes.back(), (100 + s) * SECOND);
+    }
+    ClipSummary clip;
+    REQUIRE(catalog.find(1, &clip));
+
+    ClipReader reader(rig.frames, true);
+    REQUIRE(reader.open(clip));
+    uint64_t stored = 0;
+    for (const auto& scene : scenes) stored += scene.size();
+    REQUIRE(reader.size() == stored + scenes.size() * JPEG_METADATA_SEGMENT_SIZE);
+    REQUIRE(reader.buffer_size() == rig.frames.max_record_size() + JPEG_METADATA_SEGMENT_SIZE);
+    std::vector<uint8_t> buf(reader.buffer_size());
+
+    SECTION("every downloaded frame carries its store sequence and time") {
+        std::vector<uint8_t> file;
+        REQUIRE(reader.seek(0));
+        const uint8_t* data = nullptr;
+        for (size_t n; (n = reader.read(buf.data(), buf.size(), &data)) > 0;) {
+            file.insert(file.end(), data, data + n);
+        }
+        REQUIRE(file.size() == reader.size());
+
+        size_t offset = 0;
+        for (size_t i = 0; i < scenes.size(); i++) {
+            size_t size = scenes[i].size() + JPEG_METADATA_SEGMENT_SIZE;
+            FrameMetadata meta;
+            REQUIRE(jpeg_read_metadata(file.data() + offset, size, &meta));
+            REQUIRE(meta.source == FrameSource::Recording);
+            REQUIRE(meta.sequence == clip.first_sequence + i);
+            REQUIRE(meta.timestamp_us == static_cast<int64_t>(100 + i) * SECOND);
+#ifdef HAVE_LIBJPEG
+            DecodedImage spliced, original;
+            REQUIRE(decode_jpeg(file.data() + offset, size, &spliced));
+            REQUIRE(decode_jpeg(scenes[i].data(), scenes[i].size(), &original));
+            REQUIRE(spliced.pixels == original.pixels);
+#endif
+            offset += size;
+        }
+    }
+
+    SECTION("ranges count the segment") {
+        std::vector<uint8_t> file(reader.size());
+        REQUIRE(reader.seek(0));
+        const uint8_t* data = nullptr;
+        size_t pos = 0;
+        for (size_t n; (n = reader.read(buf.data(), buf.size(), &data)) > 0; pos += n) {
+            memcpy(file.data() + pos, data, n);
+        }
+        // Second frame's segment onwards, and a range ending inside it
+        uint64_t second = scenes[0].size() + JPEG_METADATA_SEGMENT_SIZE;
+        for (uint64_t first : {second, second + 2, second + 10, reader.size() - 3}) {
+            REQUIRE(reader.seek(first));
+            REQUIRE(reader.read(buf.data(), buf.size(), &data) > 0);
+            REQUIRE(*data == file[first]);
+        }
+        FrameMetadata meta;
+        REQUIRE(jpeg_read_metadata(file.data() + second, scenes[1].size() + JPEG_METADATA_SEGMENT_SIZE,
+                                   &meta));
+        REQUIRE(meta.sequence == clip.first_sequence + 1);
+    }
+
+    SECTION("archive entries carry it too") {
+        struct Sink {
+            std::vector<uint8_t> bytes;
+            static bool write(void* context, const uint8_t* data, size_t size) {
+                auto& out = static_cast<Sink*>(context)->bytes;
+                out.insert(out.end(), data, data + size);
+                return true;
+            }
+        } sink;
+        ArchiveWriter tar;
+        REQUIRE(tar.init({.format = ArchiveFormat::Tar, .max_entries = 8}));
+        REQUIRE(tar.begin(&Sink::write, &sink, "clip_1/", ".jpg"));
+        REQUIRE(write_clip_archive(reader, tar, buf.data(), buf.size()) == scenes.size());
+        REQUIRE(tar.finish());
+
+        // First entry: 512-byte header, then the frame
+        size_t size = strtoul(reinterpret_cast<const char*>(sink.bytes.data()) + 124, nullptr, 8);
+        REQUIRE(size == scenes[0].size() + JPEG_METADATA_SEGMENT_SIZE);
+        FrameMetadata meta;
+        REQUIRE(jpeg_read_metadata(sink.bytes.data() + 512, size, &meta));
+        REQUIRE(meta.source == FrameSource::Recording);
+        REQUIRE(meta.sequence == clip.first_sequence);
+    }
+
+    SECTION("frames that are not JPEG end the stream") {
+        std::vector<uint8_t> junk(500, 0x55);
+        rig.record(catalog, junk, 200 * SECOND);
+        ClipSummary last;
+        REQUIRE(catalog.find(2, &last));
+        ClipReader junk_reader(rig.frames, true);
+        REQUIRE(junk_reader.open(last));
+        const uint8_t* data = nullptr;
+        REQUIRE(junk_reader.read(buf.data(), buf.size(), &data) == 0);
+    }
+}
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+TEST_CASE("RecordingCatalog query and indexing cost", "[.][benchmark][recording_catalog]") {
+    Rig rig(512 * SEGMENT, 256 * SEGMENT);
+    RecordingCatalog catalog(rig.frames, rig.index);
+    REQUIRE(catalog.init({.max_clips = 16384, .clip_gap_ms = 5000, .max_clip_duration_ms = 60000,
+                          .thumbnail_interval_ms = 0}, false));
+    auto scene = make_scene(-1);
+    int64_t t = 0;
+    auto fill = [&](int clips) {
+        for (int c = 0; c < clips; c++) {
+            t += 60 * SECOND;
+            rig.record(catalog, scene, t);
+        }
+    };
+
+    std::vector<ClipSummary> out(64);
+    fill(1000);
+    BENCHMARK("query 5 min out of 1000 clips") {
+        return catalog.query(t / 2, t / 2 + 300 * SECOND, out.data(), out.size());
+    };
+    fill(9000);
+    BENCHMARK("query 5 min out of 10000 clips") {
+        return catalog.query(t / 2, t / 2 + 300 * SECOND, out.data(), out.size());
+    };
+
+    auto vga = make_synthetic_jpeg();
+    BENCHMARK("index a VGA frame (luma DC decode + motion)") {
+        t += SECOND;
+        catalog.on_record(rig.frames.newest_sequence(), t, vga.data(), vga.size());
+    };
+
+    catalog.deinit();
+    RecordingCatalog again(rig.frames, rig.index);
+    auto t0 = std::chrono::steady_clock::now();
+    REQUIRE(again.init(catalog.config(), false));
+    double ms = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() * 1000.0;
+    WARN("Reloaded " << again.clip_count() << " clips in " << ms << " ms");
+}
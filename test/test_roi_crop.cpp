@@ -0,0 +1,283 @@
+/**
+ * @file test_roi_crop.cpp
+ * @brief Unit tests and benchmarks for compressed-domain ROI cropping
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/roi_crop.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "fixtures/jpeg_decode.hpp"
+#include <vector>
+#include <cstring>
+
+using namespace core;
+using namespace fixtures;
+
+//=============================================================================
+// ROI Parsing Tests
+//=============================================================================
+
+TEST_CASE("ROI query parsing", "[roi][parse]") {
+    RoiRect roi;
+
+    SECTION("valid rectangle") {
+        REQUIRE(parse_roi("16,32,320,240", &roi));
+        REQUIRE(roi.x == 16);
+        REQUIRE(roi.y == 32);
+        REQUIRE(roi.w == 320);
+        REQUIRE(roi.h == 240);
+    }
+
+    SECTION("rejects malformed input") {
+        REQUIRE_FALSE(parse_roi("", &roi));
+        REQUIRE_FALSE(parse_roi("1,2,3", &roi));
+        REQUIRE_FALSE(parse_roi("1,2,3,4,5", &roi));
+        REQUIRE_FALSE(parse_roi("a,b,c,d", &roi));
+        REQUIRE_FALSE(parse_roi("-1,0,10,10", &roi));
+        REQUIRE_FALSE(parse_roi(nullptr, &roi));
+    }
+
+    SECTION("rejects empty rectangle") {
+        REQUIRE_FALSE(parse_roi("0,0,0,10", &roi));
+        REQUIRE_FALSE(parse_roi("0,0,10,0", &roi));
+    }
+}
+
+//=============================================================================
+// Cropper Tests
+//=============================================================================
+
+// Decode every MCU of a JPEG into a flat coefficient list
+static std::vector<int16_t> all_blocks(const std::vector<uint8_t>& jpg, JpegInfo* info) {
+    REQUIRE(jpeg_parse(jpg.data(), jpg.size(), info));
+    JpegScanDecoder dec;
+    REQUIRE(dec.begin(jpg.data(), jpg.size(), *info));
+    std::vector<int16_t> out(static_cast<size_t>(info->total_mcus()) * info->blocks_per_mcu * 64);
+    for (uint32_t m = 0; m < info->total_mcus(); m++) {
+        REQUIRE(dec.decode_mcu(reinterpret_cast<int16_t(*)[64]>(&out[m * info->blocks_per_mcu * 64])));
+    }
+    return out;
+}
+
+static void require_crop_matches_source(const std::vector<uint8_t>& src,
+                                        const std::vector<uint8_t>& crop,
+                                        const RoiRect& applied) {
+    JpegInfo si, ci;
+    auto src_blocks = all_blocks(src, &si);
+    auto crop_blocks = all_blocks(crop, &ci);
+    REQUIRE(ci.width == applied.w);
+    REQUIRE(ci.height == applied.h);
+
+    size_t per_mcu = static_cast<size_t>(si.blocks_per_mcu) * 64;
+    uint32_t mx0 = applied.x / si.mcu_width;
+    uint32_t my0 = applied.y / si.mcu_height;
+    for (uint32_t y = 0; y < ci.mcus_y; y++) {
+        for (uint32_t x = 0; x < ci.mcus_x; x++) {
+            const int16_t* a = &crop_blocks[(y * ci.mcus_x + x) * per_mcu];
+            const int16_t* b = &src_blocks[((my0 + y) * si.mcus_x + mx0 + x) * per_mcu];
+            REQUIRE(memcmp(a, b, per_mcu * sizeof(int16_t)) == 0);
+        }
+    }
+}
+
+TEST_CASE("JpegRoiCropper crops in the compressed domain", "[roi][crop]") {
+    JpegRoiCropper cropper;
+    std::vector<uint8_t> out(200 * 1024);
+    size_t out_size = 0;
+    RoiRect applied;
+
+    SECTION("aligned ROI keeps exact coefficients") {
+        auto src = make_synthetic_jpeg({.width = 640, .height = 480});
+        REQUIRE(cropper.crop(src.data(), src.size(), {64, 48, 160, 96},
+                             out.data(), out.size(), &out_size, &applied));
+        out.resize(out_size);
+        REQUIRE(applied == RoiRect{64, 48, 160, 96});
+        REQUIRE(out_size < src.size());
+        require_crop_matches_source(src, out, applied);
+    }
+
+    SECTION("unaligned ROI snaps outward to the MCU grid") {
+        auto src = make_synthetic_jpeg({.width = 640, .height = 480});
+        REQUIRE(cropper.crop(src.data(), src.size(), {70, 50, 100, 30},
+                             out.data(), out.size(), &out_size, &applied));
+        REQUIRE(applied.x == 64);
+        REQUIRE(applied.y == 48);
+        REQUIRE(applied.w == 112);   // 64..176
+        REQUIRE(applied.h == 32);    // 48..80
+    }
+
+    SECTION("ROI past the frame edge keeps partial MCUs") {
+        auto src = make_synthetic_jpeg({.width = 100, .height = 60});
+        REQUIRE(cropper.crop(src.data(), src.size(), {80, 40, 500, 500},
+                             out.data(), out.size(), &out_size, &applied));
+        out.resize(out_size);
+        REQUIRE(applied == RoiRect{80, 40, 20, 20});
+        require_crop_matches_source(src, out, applied);
+    }
+
+    SECTION("restart markers give identical output") {
+        auto plain = make_synthetic_jpeg({.width = 640, .height = 480});
+        auto rst = make_synthetic_jpeg({.width = 640, .height = 480, .restart_interval = 40});
+        std::vector<uint8_t> out2(out.size());
+        size_t size2 = 0;
+        RoiRect roi{320, 240, 200, 120};
+        REQUIRE(cropper.crop(plain.data(), plain.size(), roi, out.data(), out.size(), &out_size));
+        REQUIRE(cropper.crop(rst.data(), rst.size(), roi, out2.data(), out2.size(), &size2));
+        REQUIRE(out_size == size2);
+        REQUIRE(memcmp(out.data(), out2.data(), out_size) == 0);
+    }
+
+    SECTION("grayscale and 4:2:0 sources") {
+        auto gray = make_synthetic_jpeg({.width = 160, .height = 120, .components = 1});
+        REQUIRE(cropper.crop(gray.data(), gray.size(), {8, 8, 40, 40},
+                             out.data(), out.size(), &out_size, &applied));
+        out.resize(out_size);
+        require_crop_matches_source(gray, out, applied);
+
+        auto yuv420 = make_synthetic_jpeg({.width = 160, .height = 120, .luma_v = 2});
+        out.resize(200 * 1024);
+        REQUIRE(cropper.crop(yuv420.data(), yuv420.size(), {16, 16, 64, 32},
+                             out.data(), out.size(), &out_size, &applied));
+        out.resize(out_size);
+        require_crop_matches_source(yuv420, out, applied);
+    }
+
+    SECTION("ROI outside frame fails") {
+        auto src = make_synthetic_jpeg({.width = 320, .height = 240});
+        REQUIRE_FALSE(cropper.crop(src.data(), src.size(), {400, 0, 10, 10},
+                                   out.data(), out.size(), &out_size));
+    }
+
+    SECTION("output larger than buffer fails") {
+        auto src = make_synthetic_jpeg({.width = 320, .height = 240});
+        REQUIRE_FALSE(cropper.crop(src.data(), src.size(), {0, 0, 320, 240},
+                                   out.data(), 512, &out_size));
+    }
+
+    SECTION("non-JPEG input fails") {
+        std::vector<uint8_t> junk(1024, 0x42);
+        REQUIRE_FALSE(cropper.crop(junk.data(), junk.size(), {0, 0, 8, 8},
+                                   out.data(), out.size(), &out_size));
+    }
+}
+
+#ifdef HAVE_LIBJPEG
+TEST_CASE("JpegRoiCropper output matches decoded source pixels", "[roi][libjpeg]") {
+    JpegRoiCropper cropper;
+    std::vector<uint8_t> out(200 * 1024);
+    size_t out_size = 0;
+    RoiRect applied;
+
+    auto src = make_synthetic_jpeg({.width = 320, .height = 240, .restart_interval = 10});
+    REQUIRE(cropper.crop(src.data(), src.size(), {48, 40, 96, 64},
+                         out.data(), out.size(), &out_size, &applied));
+
+    DecodedImage full, crop;
+    REQUIRE(decode_jpeg(src.data(), src.size(), &full));
+    REQUIRE(decode_jpeg(out.data(), out_size, &crop));
+    REQUIRE(crop.width == applied.w);
+    REQUIRE(crop.height == applied.h);
+
+    for (int y = 0; y < crop.height; y++) {
+        for (int x = 0; x < crop.width; x++) {
+            REQUIRE(memcmp(crop.at(x, y), full.at(applied.x + x, applied.y + y), 3) == 0);
+        }
+    }
+}
+#endif
+
+//=============================================================================
+// Cache Tests
+//=============================================================================
+
+TEST_CASE("RoiCropCache shares crops per frame", "[roi][cache]") {
+    RoiCropCache cache;
+    REQUIRE(cache.init(2, 64 * 1024, false));
+
+    auto frame = make_synthetic_jpeg({.width = 320, .height = 240});
+    RoiRect roi{0, 0, 64, 64};
+    const uint8_t* d1 = nullptr;
+    const uint8_t* d2 = nullptr;
+    size_t s1 = 0, s2 = 0;
+
+    SECTION("same frame and ROI hits") {
+        int h1 = cache.acquire(1, roi, frame.data(), frame.size(), &d1, &s1);
+        int h2 = cache.acquire(1, roi, frame.data(), frame.size(), &d2, &s2);
+        REQUIRE(h1 >= 0);
+        REQUIRE(h1 == h2);
+        REQUIRE(d1 == d2);
+        REQUIRE(s1 == s2);
+        REQUIRE(cache.stats().misses.load() == 1);
+        REQUIRE(cache.stats().hits.load() == 1);
+        cache.release(h1);
+        cache.release(h2);
+    }
+
+    SECTION("new frame sequence misses") {
+        int h1 = cache.acquire(1, roi, frame.data(), frame.size(), &d1, &s1);
+        cache.release(h1);
+        int h2 = cache.acquire(2, roi, frame.data(), frame.size(), &d2, &s2);
+        cache.release(h2);
+        REQUIRE(cache.stats().misses.load() == 2);
+        REQUIRE(cache.stats().hits.load() == 0);
+    }
+
+    SECTION("referenced entries are not recycled") {
+        int h1 = cache.acquire(1, roi, frame.data(), frame.size(), &d1, &s1);
+        int h2 = cache.acquire(1, {64, 0, 64, 64}, frame.data(), frame.size(), &d2, &s2);
+        REQUIRE(h1 >= 0);
+        REQUIRE(h2 >= 0);
+        REQUIRE(h1 != h2);
+
+        const uint8_t* d3 = nullptr;
+        size_t s3 = 0;
+        REQUIRE(cache.acquire(1, {128, 0, 64, 64}, frame.data(), frame.size(), &d3, &s3) < 0);
+        REQUIRE(cache.stats().failures.load() == 1);
+
+        cache.release(h1);
+        int h3 = cache.acquire(1, {128, 0, 64, 64}, frame.data(), frame.size(), &d3, &s3);
+        REQUIRE(h3 == h1);
+        cache.release(h2);
+        cache.release(h3);
+    }
+
+    SECTION("failed crop is not cached") {
+        std::vector<uint8_t> junk(100, 0);
+        REQUIRE(cache.acquire(5, roi, junk.data(), junk.size(), &d1, &s1) < 0);
+        REQUIRE(cache.stats().failures.load() == 1);
+    }
+
+    SECTION("uninitialized cache fails") {
+        RoiCropCache uninit;
+        REQUIRE(uninit.acquire(1, roi, frame.data(), frame.size(), &d1, &s1) < 0);
+    }
+}
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+TEST_CASE("ROI crop throughput", "[.][benchmark][roi]") {
+    JpegRoiCropper cropper;
+    std::vector<uint8_t> out(512 * 1024);
+    size_t out_size = 0;
+
+    auto vga = make_synthetic_jpeg({.width = 640, .height = 480});
+    auto xga = make_synthetic_jpeg({.width = 1024, .height = 768});
+    auto xga_rst = make_synthetic_jpeg({.width = 1024, .height = 768, .restart_interval = 64});
+    RoiRect door{640, 384, 256, 256};
+
+    BENCHMARK("VGA 160x120 centre crop") {
+        return cropper.crop(vga.data(), vga.size(), {240, 180, 160, 120},
+                            out.data(), out.size(), &out_size);
+    };
+    BENCHMARK("XGA 256x256 lower-right crop") {
+        return cropper.crop(xga.data(), xga.size(), door, out.data(), out.size(), &out_size);
+    };
+    BENCHMARK("XGA 256x256 lower-right crop (restart markers)") {
+        return cropper.crop(xga_rst.data(), xga_rst.size(), door, out.data(), out.size(), &out_size);
+    };
+    BENCHMARK("XGA full-frame transcode") {
+        return cropper.crop(xga.data(), xga.size(), {0, 0, 1024, 768}, out.data(), out.size(), &out_size);
+    };
+}
@@ -0,0 +1,501 @@
+/**
+ * @file test_rtp_jpeg.cpp
+ * @brief Unit tests and benchmarks for RTP/JPEG multicast with parity packets
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/rtp_jpeg.hpp"
+#include "../main/core/multicast_streamer.hpp"
+#include "fixtures/synthetic_jpeg.hpp"
+#include "mocks/mock_clock.hpp"
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace fixtures;
+using namespace mocks;
+
+struct Datagram {
+    std::vector<uint8_t> bytes;
+    RtpPacketKind kind;
+};
+
+static std::vector<Datagram> packetize(RtpJpegPacketizer& pkt, const std::vector<uint8_t>& jpeg,
+                                       int64_t timestamp_us) {
+    std::vector<Datagram> out;
+    if (!pkt.begin(jpeg.data(), jpeg.size(), timestamp_us)) return out;
+    uint8_t buf[RTP_MAX_DATAGRAM];
+    RtpPacketKind kind;
+    while (size_t n = pkt.next(buf, sizeof(buf), &kind)) {
+        out.push_back({std::vector<uint8_t>(buf, buf + n), kind});
+    }
+    return out;
+}
+
+/**
+ * @brief In-memory "loopback" network: drops datagrams at random, delivers
+ *        the rest to a receiver in order
+ */
+class LossyLink : public interfaces::IDatagramSender {
+public:
+    LossyLink(RtpJpegReceiver& rx, double loss, uint32_t seed, const MockClock* clock = nullptr)
+        : rx_(rx), loss_(loss), rng_(seed), clock_(clock) {}
+
+    bool send(const uint8_t* data, size_t size, uint16_t port) override {
+        sent++;
+        bytes += size;
+        ports.push_back(port);
+        if (clock_) send_times_us.push_back(clock_->now_us());
+        if (std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < loss_) {
+            dropped++;
+            return true;  // Lost in the air, not by the stack
+        }
+        if (rx_.on_packet(data, size)) {
+            frames.emplace_back(rx_.frame(), rx_.frame() + rx_.frame_size());
+        }
+        return true;
+    }
+
+    uint32_t sent = 0;
+    uint32_t dropped = 0;
+    uint64_t bytes = 0;
+    std::vector<uint16_t> ports;
+    std::vector<int64_t> send_times_us;
+    std::vector<std::vector<uint8_t>> frames;
+
+private:
+    RtpJpegReceiver& rx_;
+    double loss_;
+    std::mt19937 rng_;
+    const MockClock* clock_;
+};
+
+//=============================================================================
+// RTP Header Tests
+//=============================================================================
+
+TEST_CASE("RTP header round trip", "[rtp][header]") {
+    uint8_t buf[RTP_HEADER_SIZE];
+    RtpHeader h;
+    h.marker = true;
+    h.payload_type = RTP_JPEG_PAYLOAD_TYPE;
+    h.sequence = 0xBEEF;
+    h.timestamp = 0x12345678;
+    h.ssrc = 0xCAFEF00D;
+    rtp_write_header(buf, h);
+
+    RtpHeader r;
+    REQUIRE(rtp_read_header(buf, sizeof(buf), &r) == RTP_HEADER_SIZE);
+    REQUIRE(r.marker);
+    REQUIRE(r.payload_type == RTP_JPEG_PAYLOAD_TYPE);
+    REQUIRE(r.sequence == 0xBEEF);
+    REQUIRE(r.timestamp == 0x12345678);
+    REQUIRE(r.ssrc == 0xCAFEF00D);
+
+    SECTION("rejects wrong version and short packets") {
+        buf[0] = 0x40;
+        REQUIRE(rtp_read_header(buf, sizeof(buf), &r) == 0);
+        REQUIRE(rtp_read_header(buf, 8, &r) == 0);
+    }
+
+    SECTION("timestamps use the 90 kHz video clock") {
+        REQUIRE(rtp_jpeg_timestamp(1000 * 1000) == 90000);
+        REQUIRE(rtp_jpeg_timestamp(125 * 1000) == 11250);
+    }
+}
+
+//=============================================================================
+// Packetizer Tests
+//=============================================================================
+
+TEST_CASE("RtpJpegPacketizer", "[rtp][packetizer]") {
+    RtpJpegPacketizer pkt;
+    REQUIRE(pkt.configure(1400, 4, 0x1234));
+    auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+
+    SECTION("packets fit the datagram size with parity after every group") {
+        auto dgrams = packetize(pkt, jpeg, 0);
+        REQUIRE(dgrams.size() > 8);
+        size_t media_run = 0;
+        size_t media = 0;
+        for (const auto& d : dgrams) {
+            REQUIRE(d.bytes.size() <= 1400);
+            if (d.kind == RtpPacketKind::Media) {
+                media_run++;
+                media++;
+                REQUIRE(media_run <= 4);
+            } else {
+                REQUIRE(media_run > 0);
+                media_run = 0;
+            }
+        }
+        REQUIRE(dgrams.back().kind == RtpPacketKind::Parity);
+        REQUIRE(dgrams.size() - media == (media + 3) / 4);
+    }
+
+    SECTION("only the last media packet carries the marker") {
+        auto dgrams = packetize(pkt, jpeg, 0);
+        RtpHeader h;
+        size_t markers = 0;
+        const Datagram* last_media = nullptr;
+        for (const auto& d : dgrams) {
+            if (d.kind != RtpPacketKind::Media) continue;
+            rtp_read_header(d.bytes.data(), d.bytes.size(), &h);
+            REQUIRE(h.payload_type == RTP_JPEG_PAYLOAD_TYPE);
+            if (h.marker) markers++;
+            last_media = &d;
+        }
+        REQUIRE(markers == 1);
+        rtp_read_header(last_media->bytes.data(), last_media->bytes.size(), &h);
+        REQUIRE(h.marker);
+    }
+
+    SECTION("first packet carries dimensions and in-band tables") {
+        auto dgrams = packetize(pkt, jpeg, 0);
+        const uint8_t* p = dgrams[0].bytes.data() + RTP_HEADER_SIZE;
+        REQUIRE(p[4] == 0);                    // 4:2:2
+        REQUIRE(p[5] == RTP_JPEG_Q_DYNAMIC);
+        REQUIRE(p[6] == 640 / 8);
+        REQUIRE(p[7] == 480 / 8);
+        REQUIRE(((p[10] << 8) | p[11]) == 128);  // Two 8-bit tables
+    }
+
+    SECTION("sequence numbers continue across frames") {
+        auto a = packetize(pkt, jpeg, 0);
+        uint16_t next = pkt.media_sequence();
+        auto b = packetize(pkt, jpeg, 125000);
+        RtpHeader h;
+        rtp_read_header(b[0].bytes.data(), b[0].bytes.size(), &h);
+        REQUIRE(h.sequence == next);
+        REQUIRE(h.timestamp == rtp_jpeg_timestamp(125000));
+    }
+
+    SECTION("no parity when the group is 0") {
+        REQUIRE(pkt.configure(1400, 0, 1));
+        for (const auto& d : packetize(pkt, jpeg, 0)) {
+            REQUIRE(d.kind == RtpPacketKind::Media);
+            REQUIRE(d.bytes.size() <= 1400);
+        }
+    }
+
+    SECTION("restart intervals use the restart header") {
+        auto rst = make_synthetic_jpeg({.width = 320, .height = 240, .restart_interval = 20});
+        auto dgrams = packetize(pkt, rst, 0);
+        REQUIRE_FALSE(dgrams.empty());
+        REQUIRE(pkt.jpeg_type() == 64);
+    }
+
+    SECTION("rejects what RFC 2435 cannot carry") {
+        auto gray = make_synthetic_jpeg({.width = 160, .height = 120, .components = 1});
+        REQUIRE_FALSE(pkt.begin(gray.data(), gray.size(), 0));
+        auto odd = make_synthetic_jpeg({.width = 100, .height = 60});
+        REQUIRE_FALSE(pkt.begin(odd.data(), odd.size(), 0));
+        std::vector<uint8_t> junk(512, 0x42);
+        REQUIRE_FALSE(pkt.begin(junk.data(), junk.size(), 0));
+    }
+
+    SECTION("invalid configuration") {
+        REQUIRE_FALSE(pkt.configure(100, 4, 0));
+        REQUIRE_FALSE(pkt.configure(4000, 4, 0));
+        REQUIRE_FALSE(pkt.configure(1400, RTP_MAX_PARITY_GROUP + 1, 0));
+    }
+}
+
+//=============================================================================
+// Receiver Tests
+//=============================================================================
+
+TEST_CASE("RtpJpegReceiver reassembly", "[rtp][receiver]") {
+    RtpJpegPacketizer pkt;
+    REQUIRE(pkt.configure(1400, 4, 0x1234));
+    RtpJpegReceiver rx;
+    REQUIRE(rx.init(256 * 1024));
+
+    auto deliver = [&rx](const std::vector<Datagram>& dgrams, std::vector<size_t> drop = {}) {
+        int completed = 0;
+        for (size_t i = 0; i < dgrams.size(); i++) {
+            bool dropped = false;
+            for (size_t d : drop) dropped |= d == i;
+            if (!dropped && rx.on_packet(dgrams[i].bytes.data(), dgrams[i].bytes.size())) completed++;
+        }
+        return completed;
+    };
+    auto frame = [&rx]() { return std::vector<uint8_t>(rx.frame(), rx.frame() + rx.frame_size()); };
+
+    SECTION("lossless frame is rebuilt byte for byte") {
+        auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+        REQUIRE(deliver(packetize(pkt, jpeg, 0)) == 1);
+        REQUIRE(frame() == jpeg);
+        REQUIRE(rx.stats().frames_complete == 1);
+        REQUIRE(rx.stats().recovered_packets == 0);
+    }
+
+    SECTION("4:2:0 and restart intervals are rebuilt byte for byte") {
+        auto yuv420 = make_synthetic_jpeg({.width = 320, .height = 240, .luma_v = 2});
+        REQUIRE(deliver(packetize(pkt, yuv420, 0)) == 1);
+        REQUIRE(frame() == yuv420);
+
+        auto rst = make_synthetic_jpeg({.width = 320, .height = 240, .restart_interval = 20});
+        REQUIRE(deliver(packetize(pkt, rst, 125000)) == 1);
+        REQUIRE(frame() == rst);
+    }
+
+    SECTION("one loss per group is repaired") {
+        auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+        auto dgrams = packetize(pkt, jpeg, 0);
+        // Drop the first media packet (quant tables) and the last one (marker)
+        size_t last_media = dgrams.size() - 2;
+        REQUIRE(dgrams[last_media].kind == RtpPacketKind::Media);
+        REQUIRE(deliver(dgrams, {0, last_media}) == 1);
+        REQUIRE(frame() == jpeg);
+        REQUIRE(rx.stats().recovered_packets == 2);
+        REQUIRE(rx.stats().frames_recovered == 1);
+    }
+
+    SECTION("lost parity packets do no harm") {
+        auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+        auto dgrams = packetize(pkt, jpeg, 0);
+        std::vector<size_t> parity;
+        for (size_t i = 0; i < dgrams.size(); i++) {
+            if (dgrams[i].kind == RtpPacketKind::Parity) parity.push_back(i);
+        }
+        REQUIRE(deliver(dgrams, parity) == 1);
+        REQUIRE(frame() == jpeg);
+    }
+
+    SECTION("two losses in one group lose the frame") {
+        auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+        REQUIRE(deliver(packetize(pkt, jpeg, 0), {1, 2}) == 0);
+        // The next frame arriving abandons the broken one
+        REQUIRE(deliver(packetize(pkt, jpeg, 125000)) == 1);
+        REQUIRE(rx.stats().frames_incomplete == 1);
+        REQUIRE(rx.stats().frames_complete == 1);
+    }
+
+    SECTION("duplicates and late packets do not redeliver") {
+        auto jpeg = make_synthetic_jpeg({.width = 320, .height = 240});
+        auto first = packetize(pkt, jpeg, 0);
+        auto second = packetize(pkt, jpeg, 125000);
+        REQUIRE(deliver(first) == 1);
+        REQUIRE(deliver(first) == 0);
+        REQUIRE(deliver(second) == 1);
+        REQUIRE(deliver(first) == 0);
+        REQUIRE(rx.stats().frames_complete == 2);
+    }
+
+    SECTION("garbage is counted, not fatal") {
+        uint8_t junk[64] = {0x80, 26};
+        REQUIRE_FALSE(rx.on_packet(junk, 4));
+        REQUIRE_FALSE(rx.on_packet(junk, sizeof(junk)));
+        REQUIRE(rx.stats().malformed >= 1);
+    }
+}
+
+//=============================================================================
+// Pacer Tests
+//=============================================================================
+
+TEST_CASE("RtpPacer token bucket", "[rtp][pacer]") {
+    RtpPacer pacer(100 * 1000, 3000);  // 100 KB/s, 3 KB burst
+
+    SECTION("burst goes out immediately") {
+        REQUIRE(pacer.reserve(1400, 0) == 0);
+        REQUIRE(pacer.reserve(1400, 0) == 0);
+        REQUIRE(pacer.reserve(1400, 0) > 0);
+    }
+
+    SECTION("sustained rate is honoured") {
+        int64_t now = 0;
+        for (int i = 0; i < 100; i++) now += pacer.reserve(1000, now);
+        // 100 KB minus the 3 KB burst at 100 KB/s
+        REQUIRE(now >= 970 * 1000);
+        REQUIRE(now <= 980 * 1000);
+    }
+
+    SECTION("idle time refills only up to the burst") {
+        pacer.reserve(3000, 0);
+        REQUIRE(pacer.reserve(3000, 10 * 1000 * 1000) == 0);
+        REQUIRE(pacer.reserve(1000, 10 * 1000 * 1000) == 10 * 1000);
+    }
+
+    SECTION("waiting less than asked carries over as debt") {
+        pacer.reserve(3000, 0);
+        int64_t wait = pacer.reserve(1000, 0);
+        REQUIRE(wait == 10 * 1000);
+        REQUIRE(pacer.reserve(1000, wait / 2) == wait / 2 + 10 * 1000);
+    }
+}
+
+//=============================================================================
+// Loopback: streamer → lossy link → receiver
+//=============================================================================
+
+// Send `frames` frames through a streamer over a lossy link
+static RtpJpegReceiverStats run_loopback(double loss, uint8_t parity_group, int frames,
+                                         uint32_t seed = 7) {
+    MockClock clock;
+    clock.set_real_sleep(false);
+    RtpJpegReceiver rx;
+    REQUIRE(rx.init(256 * 1024));
+    LossyLink link(rx, loss, seed);
+    MulticastStreamer mcast(link, clock);
+    MulticastConfig config;
+    config.parity_group = parity_group;
+    REQUIRE(mcast.init(config, false));
+
+    auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+    for (int i = 0; i < frames; i++) {
+        REQUIRE(mcast.send_frame(jpeg.data(), jpeg.size(), i * 125000LL));
+    }
+    return rx.stats();
+}
+
+TEST_CASE("Multicast loopback under injected loss", "[rtp][loopback]") {
+    constexpr int FRAMES = 200;
+
+    SECTION("lossless link delivers every frame") {
+        auto stats = run_loopback(0.0, 4, FRAMES);
+        REQUIRE(stats.frames_complete == FRAMES);
+        REQUIRE(stats.recovered_packets == 0);
+    }
+
+    SECTION("parity turns 2% packet loss into near-complete frames") {
+        auto with_parity = run_loopback(0.02, 4, FRAMES);
+        auto without = run_loopback(0.02, 0, FRAMES);
+        REQUIRE(with_parity.recovered_packets > 0);
+        REQUIRE(with_parity.frames_complete >= FRAMES * 90 / 100);
+        REQUIRE(without.frames_complete < FRAMES * 70 / 100);
+    }
+
+    SECTION("parity overhead matches the group size") {
+        MockClock clock;
+        clock.set_real_sleep(false);
+        RtpJpegReceiver rx;
+        REQUIRE(rx.init(256 * 1024));
+        LossyLink link(rx, 0.0, 1);
+        MulticastStreamer mcast(link, clock);
+        REQUIRE(mcast.init(MulticastConfig{}, false));
+        auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+        REQUIRE(mcast.send_frame(jpeg.data(), jpeg.size(), 0));
+
+        const auto& s = mcast.stats();
+        REQUIRE(s.parity_sent.load() == (s.packets_sent.load() + 3) / 4);
+        for (size_t i = 0; i < link.ports.size(); i++) {
+            REQUIRE((link.ports[i] == 5004 || link.ports[i] == 5006));
+        }
+    }
+}
+
+TEST_CASE("MulticastStreamer pacing and hand-over", "[rtp][streamer]") {
+    MockClock clock;
+    clock.set_real_sleep(false);
+    RtpJpegReceiver rx;
+    REQUIRE(rx.init(256 * 1024));
+    LossyLink link(rx, 0.0, 1, &clock);
+    MulticastStreamer mcast(link, clock);
+
+    SECTION("a frame is spread over time at the configured rate") {
+        MulticastConfig config;
+        config.rate_kbps = 2000;          // 250 KB/s
+        config.burst_bytes = 2800;
+        REQUIRE(mcast.init(config, false));
+        auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+        REQUIRE(mcast.send_frame(jpeg.data(), jpeg.size(), 0));
+
+        int64_t elapsed = link.send_times_us.back() - link.send_times_us.front();
+        int64_t expected = static_cast<int64_t>(link.bytes - config.burst_bytes) * 1000 * 1000 / 250000;
+        REQUIRE(elapsed >= expected - 2000);
+        // No 10 ms window holds more than the burst plus 10 ms worth of bytes
+        for (size_t i = 0; i < link.send_times_us.size(); i++) {
+            size_t window_bytes = 0;
+            for (size_t j = i; j < link.send_times_us.size() &&
+                               link.send_times_us[j] < link.send_times_us[i] + 10000; j++) {
+                window_bytes += 1400;
+            }
+            REQUIRE(window_bytes <= config.burst_bytes + 2500 + 2 * 1400);
+        }
+    }
+
+    SECTION("producer hand-over sends frames from the sender task") {
+        REQUIRE(mcast.init(MulticastConfig{}, false));
+        auto jpeg = make_synthetic_jpeg({.width = 320, .height = 240});
+        mcast.on_frame(jpeg.data(), jpeg.size(), 0, 1);  // Ignored until started
+        REQUIRE(mcast.stats().frames_offered == 0);
+
+        REQUIRE(mcast.start());
+        for (int i = 0; i < 5; i++) {
+            mcast.on_frame(jpeg.data(), jpeg.size(), (i + 1) * 125000LL, static_cast<uint32_t>(i + 1));
+            for (int w = 0; w < 200 && mcast.stats().frames_sent + mcast.stats().frames_superseded < static_cast<uint32_t>(i + 1); w++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        mcast.stop();
+
+        const auto& s = mcast.stats();
+        REQUIRE(s.frames_offered == 5);
+        REQUIRE(s.frames_sent + s.frames_superseded == 5);
+        REQUIRE(link.frames.size() == s.frames_sent);
+        REQUIRE(link.frames.back() == jpeg);
+    }
+
+    SECTION("oversized and incompatible frames are rejected") {
+        MulticastConfig config;
+        config.max_frame_size = 1024;
+        REQUIRE(mcast.init(config, false));
+        REQUIRE(mcast.start());
+        auto jpeg = make_synthetic_jpeg({.width = 320, .height = 240});
+        mcast.on_frame(jpeg.data(), jpeg.size(), 0, 1);
+        auto gray = make_synthetic_jpeg({.width = 16, .height = 16, .components = 1});
+        REQUIRE_FALSE(mcast.send_frame(gray.data(), gray.size(), 0));
+        mcast.stop();
+        REQUIRE(mcast.stats().frames_rejected == 2);
+        REQUIRE(link.sent == 0);
+    }
+}
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+TEST_CASE("Multicast reassembly vs loss", "[.][benchmark][rtp]") {
+    constexpr int FRAMES = 500;
+    for (double loss : {0.01, 0.02, 0.05, 0.10}) {
+        for (uint8_t group : {static_cast<uint8_t>(0), static_cast<uint8_t>(8), static_cast<uint8_t>(4),
+                              static_cast<uint8_t>(2)}) {
+            auto stats = run_loopback(loss, group, FRAMES);
+            WARN("loss " << loss * 100 << "%, parity 1/" << static_cast<int>(group)
+                 << (group ? "" : " (none)") << ": " << stats.frames_complete * 100 / FRAMES
+                 << "% frames complete, " << stats.recovered_packets << " packets repaired");
+        }
+    }
+
+    RtpJpegPacketizer pkt;
+    pkt.configure(1400, 4, 1);
+    RtpJpegReceiver rx;
+    rx.init(256 * 1024);
+    auto jpeg = make_synthetic_jpeg({.width = 640, .height = 480});
+    uint8_t buf[RTP_MAX_DATAGRAM];
+    int64_t ts = 0;
+
+    BENCHMARK("packetize VGA frame") {
+        pkt.begin(jpeg.data(), jpeg.size(), ts += 125000);
+        RtpPacketKind kind;
+        size_t total = 0;
+        while (size_t n = pkt.next(buf, sizeof(buf), &kind)) total += n;
+        return total;
+    };
+
+    auto dgrams = packetize(pkt, jpeg, 0);
+    BENCHMARK("reassemble VGA frame (one loss per group)") {
+        rx.reset();
+        size_t done = 0;
+        for (size_t i = 0; i < dgrams.size(); i++) {
+            if (i % 5 == 1) continue;
+            done += rx.on_packet(dgrams[i].bytes.data(), dgrams[i].bytes.size());
+        }
+        return done;
+    };
+}
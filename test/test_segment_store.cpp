@@ -0,0 +1,448 @@
+/**
+ * @file test_segment_store.cpp
+ * @brief Unit tests and benchmarks for SegmentStore and FlashRecorder
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/segment_store.hpp"
+#include "../main/core/flash_recorder.hpp"
+#include "fixtures/file_flash.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace core;
+using namespace fixtures;
+
+namespace {
+
+constexpr size_t SEGMENT = 16 * 1024;
+
+std::vector<uint8_t> make_frame(uint32_t n, size_t size) {
+    std::vector<uint8_t> frame(size);
+    for (size_t i = 0; i < size; i++) frame[i] = static_cast<uint8_t>(n * 31 + i * 7);
+    return frame;
+}
+
+// Record n is 1000..4000 bytes at 100 ms intervals
+size_t frame_size(uint32_t n) { return 1000 + (n * 577) % 3000; }
+int64_t frame_time(uint32_t n) { return static_cast<int64_t>(n) * 100000; }
+
+bool wait_until(const std::function<bool()>& done, int timeout_ms = 5000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (done()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return done();
+}
+
+// Every record from the oldest on, in log order
+std::vector<RecordInfo> walk(SegmentStore& store) {
+    std::vector<RecordInfo> records;
+    RecordInfo rec;
+    for (bool ok = store.oldest(&rec); ok; ok = store.next_after(rec, &rec)) {
+        records.push_back(rec);
+    }
+    return records;
+}
+
+} // namespace
+
+//=============================================================================
+// Geometry Tests
+//=============================================================================
+
+TEST_CASE("SegmentStore geometry", "[segment_store][init]") {
+    FileFlash flash(8 * SEGMENT);
+    REQUIRE(flash.ok());
+    SegmentStore store(flash);
+
+    SECTION("segment size must be a multiple of the erase block") {
+        REQUIRE_FALSE(store.mount({.segment_size = 6000, .spare_segments = 1}));
+    }
+
+    SECTION("spares must leave room for data") {
+        REQUIRE_FALSE(store.mount({.segment_size = SEGMENT, .spare_segments = 0}));
+        REQUIRE_FALSE(store.mount({.segment_size = SEGMENT, .spare_segments = 8}));
+    }
+
+    SECTION("blank medium mounts empty") {
+        REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+        REQUIRE(store.segment_count() == 8);
+        REQUIRE(store.record_count() == 0);
+        RecordInfo rec;
+        REQUIRE_FALSE(store.oldest(&rec));
+        REQUIRE_FALSE(store.find_time(0, &rec));
+        REQUIRE(flash.bytes_erased() == 0);   // Factory-blank: nothing to erase
+    }
+}
+
+//=============================================================================
+// Append / Read Tests
+//=============================================================================
+
+TEST_CASE("SegmentStore append and read", "[segment_store][append]") {
+    FileFlash flash(8 * SEGMENT);
+    SegmentStore store(flash);
+    REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+
+    for (uint32_t n = 1; n <= 20; n++) {
+        auto frame = make_frame(n, frame_size(n));
+        REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+    }
+
+    SECTION("records read back byte-exact across segments") {
+        auto records = walk(store);
+        REQUIRE(records.size() == 20);
+        REQUIRE(store.data_segments() > 1);
+        std::vector<uint8_t> buf(store.max_record_size());
+        for (uint32_t n = 1; n <= 20; n++) {
+            const RecordInfo& rec = records[n - 1];
+            REQUIRE(rec.sequence == n);
+            REQUIRE(rec.timestamp_us == frame_time(n));
+            REQUIRE(store.read(rec, buf.data(), buf.size()) == frame_size(n));
+            REQUIRE(std::equal(buf.begin(), buf.begin() + rec.size, make_frame(n, frame_size(n)).begin()));
+        }
+    }
+
+    SECTION("find_time seeks to the first record at or after the time") {
+        RecordInfo rec;
+        REQUIRE(store.find_time(frame_time(7), &rec));
+        REQUIRE(rec.sequence == 7);
+        REQUIRE(store.find_time(frame_time(7) + 1, &rec));
+        REQUIRE(rec.sequence == 8);
+        REQUIRE(store.find_time(-5, &rec));
+        REQUIRE(rec.sequence == 1);
+        REQUIRE_FALSE(store.find_time(frame_time(20) + 1, &rec));
+    }
+
+    SECTION("out-of-order, oversized and empty records rejected") {
+        auto frame = make_frame(0, 100);
+        REQUIRE(store.append(frame.data(), frame.size(), frame_time(19)) == 0);
+        auto big = make_frame(0, store.max_record_size() + 1);
+        REQUIRE(store.append(big.data(), big.size(), frame_time(21)) == 0);
+        REQUIRE(store.append(frame.data(), 0, frame_time(21)) == 0);
+        REQUIRE(store.stats().records_rejected.load() == 2);
+
+        // Largest record fills a segment exactly
+        auto max = make_frame(0, store.max_record_size());
+        REQUIRE(store.append(max.data(), max.size(), frame_time(21)) == 21);
+    }
+
+    SECTION("corrupted payload is detected on read") {
+        RecordInfo rec;
+        REQUIRE(store.find_time(frame_time(3), &rec));
+        flash.corrupt(rec.segment * SEGMENT + rec.offset + RECORD_HEADER_SIZE + 10, 0x00);
+        std::vector<uint8_t> buf(store.max_record_size());
+        REQUIRE(store.read(rec, buf.data(), buf.size()) == 0);
+        REQUIRE(store.stats().crc_errors.load() == 1);
+    }
+
+    SECTION("write amplification is headers and padding only") {
+        REQUIRE(store.stats().write_amplification() > 1.0);
+        REQUIRE(store.stats().write_amplification() < 1.02);
+    }
+
+    REQUIRE(flash.violations() == 0);
+}
+
+//=============================================================================
+// Reclamation / Wear Tests
+//=============================================================================
+
+TEST_CASE("SegmentStore reclaims the oldest segment", "[segment_store][reclaim]") {
+    FileFlash flash(8 * SEGMENT);
+    SegmentStore store(flash);
+    REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 2}));
+
+    SECTION("many laps: bounded, contiguous, evenly worn") {
+        uint32_t n = 0;
+        for (int lap = 0; lap < 10; lap++) {
+            for (int i = 0; i < 40; i++) {
+                n++;
+                auto frame = make_frame(n, frame_size(n));
+                REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+                while (store.service()) {}
+            }
+        }
+        REQUIRE(flash.violations() == 0);
+        REQUIRE(store.stats().erase_stalls.load() == 0);
+        REQUIRE(store.stats().records_reclaimed.load() > 0);
+        REQUIRE(store.data_segments() <= 8 - 2);
+        REQUIRE(store.ready_segments() == 2);
+
+        // What is left is the newest, contiguous run
+        auto records = walk(store);
+        REQUIRE(records.back().sequence == n);
+        for (size_t i = 1; i < records.size(); i++) {
+            REQUIRE(records[i].sequence == records[i - 1].sequence + 1);
+        }
+        REQUIRE(records.size() + store.stats().records_reclaimed.load() == n);
+
+        // Every erase block worn the same to within one lap
+        auto counts = flash.erase_counts();
+        auto [lo, hi] = std::minmax_element(counts.begin(), counts.end());
+        REQUIRE(*lo > 0);
+        REQUIRE(*hi - *lo <= 1);
+    }
+
+    SECTION("without service() append erases inline") {
+        uint32_t n = 0;
+        for (int i = 0; i < 200; i++) {
+            n++;
+            auto frame = make_frame(n, frame_size(n));
+            REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        }
+        REQUIRE(store.stats().erase_stalls.load() > 0);
+        REQUIRE(store.stats().erase_stalls.load() == store.stats().erases.load());
+        REQUIRE(flash.violations() == 0);
+    }
+
+    SECTION("reader holding a reclaimed record skips ahead") {
+        auto first = make_frame(1, 1000);
+        REQUIRE(store.append(first.data(), first.size(), frame_time(1)) == 1);
+        RecordInfo held;
+        REQUIRE(store.oldest(&held));
+        for (uint32_t n = 2; n <= 200; n++) {
+            auto frame = make_frame(n, frame_size(n));
+            REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        }
+        std::vector<uint8_t> buf(store.max_record_size());
+        REQUIRE(store.read(held, buf.data(), buf.size()) == 0);
+
+        RecordInfo next;
+        REQUIRE(store.next_after(held, &next));
+        RecordInfo oldest;
+        REQUIRE(store.oldest(&oldest));
+        REQUIRE(next.sequence == oldest.sequence);
+        REQUIRE(next.sequence > 1);
+    }
+}
+
+//=============================================================================
+// Recovery Tests
+//=============================================================================
+
+TEST_CASE("SegmentStore remount", "[segment_store][recovery]") {
+    FileFlash flash(8 * SEGMENT);
+    uint32_t n = 0;
+    {
+        SegmentStore store(flash);
+        REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+        for (; n < 150;) {
+            n++;
+            auto frame = make_frame(n, frame_size(n));
+            REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        }
+    }
+
+    SegmentStore store(flash);
+    REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+    REQUIRE(store.newest_sequence() == n);
+    REQUIRE(store.newest_timestamp_us() == frame_time(n));
+    REQUIRE(store.stats().torn_records.load() == 0);
+
+    auto records = walk(store);
+    REQUIRE(records.back().sequence == n);
+    RecordInfo rec;
+    REQUIRE(store.find_time(frame_time(140), &rec));
+    REQUIRE(rec.sequence == 140);
+
+    // Appending continues the sequence in the same segment
+    auto frame = make_frame(0, 500);
+    REQUIRE(store.append(frame.data(), frame.size(), frame_time(n + 1)) == n + 1);
+    REQUIRE(flash.violations() == 0);
+}
+
+TEST_CASE("SegmentStore survives power loss at any byte", "[segment_store][recovery]") {
+    // Cut power at every offset across the write of a record that also
+    // opens a new segment (segment header + record header + payload)
+    constexpr size_t RECORD = 9000;   // Two fit per 16 KB segment
+    const size_t span = SEGMENT_HEADER_SIZE + RECORD_HEADER_SIZE + RECORD;
+    const size_t step = 97;
+
+    for (size_t cut = 0; cut <= span + step; cut += step) {
+        FileFlash flash(4 * SEGMENT);
+        {
+            SegmentStore store(flash);
+            REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+            for (uint32_t n = 1; n <= 2; n++) {
+                auto frame = make_frame(n, RECORD);
+                REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+            }
+            flash.cut_power_after(static_cast<int64_t>(cut));
+            auto frame = make_frame(3, RECORD);
+            bool appended = store.append(frame.data(), frame.size(), frame_time(3)) == 3;
+            REQUIRE(appended == (cut >= span));
+        }
+        flash.restore_power();
+
+        SegmentStore store(flash);
+        REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+        uint32_t expected = cut >= span ? 3 : 2;
+        REQUIRE(store.newest_sequence() == expected);
+        auto records = walk(store);
+        REQUIRE(records.size() == expected);
+        std::vector<uint8_t> buf(RECORD);
+        for (const auto& rec : records) {
+            REQUIRE(store.read(rec, buf.data(), buf.size()) == RECORD);
+            REQUIRE(buf == make_frame(rec.sequence, RECORD));
+        }
+
+        // The log goes on without ever programming over unerased bytes
+        for (uint32_t n = expected + 1; n <= expected + 4; n++) {
+            auto frame = make_frame(n, RECORD);
+            REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        }
+        REQUIRE(walk(store).back().sequence == expected + 4);
+        REQUIRE(flash.violations() == 0);
+    }
+}
+
+TEST_CASE("SegmentStore survives power loss during erase", "[segment_store][recovery]") {
+    FileFlash flash(4 * SEGMENT);
+    {
+        SegmentStore store(flash);
+        REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+        for (uint32_t n = 1; n <= 20; n++) {
+            auto frame = make_frame(n, frame_size(n));
+            REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        }
+    }
+    // Half-erased segment: header gone, stale records behind it
+    RecordInfo victim;
+    {
+        SegmentStore store(flash);
+        REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+        REQUIRE(store.oldest(&victim));
+    }
+    for (size_t i = 0; i < SEGMENT_HEADER_SIZE; i++) flash.corrupt(victim.segment * SEGMENT + i, 0xFF);
+
+    SegmentStore store(flash);
+    REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+    RecordInfo oldest;
+    REQUIRE(store.oldest(&oldest));
+    REQUIRE(oldest.segment != victim.segment);
+    for (uint32_t n = 21; n <= 80; n++) {
+        auto frame = make_frame(n, frame_size(n));
+        REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        while (store.service()) {}
+    }
+    REQUIRE(flash.violations() == 0);
+    REQUIRE(walk(store).back().sequence == 80);
+}
+
+//=============================================================================
+// FlashRecorder Tests
+//=============================================================================
+
+TEST_CASE("FlashRecorder records the live stream", "[segment_store][recorder]") {
+    FileFlash flash(8 * SEGMENT);
+    SegmentStore store(flash);
+    REQUIRE(store.mount({.segment_size = SEGMENT, .spare_segments = 1}));
+
+    SECTION("frames thinned to the interval and appended") {
+        FlashRecorder recorder(store);
+        REQUIRE(recorder.init({.max_frame_size = 8 * 1024, .frame_interval_ms = 500}, false));
+        REQUIRE(recorder.start());
+        for (uint32_t n = 1; n <= 20; n++) {   // 100 ms apart: every 5th kept
+            auto frame = make_frame(n, frame_size(n));
+            recorder.on_frame(frame.data(), frame.size(), frame_time(n), n);
+            REQUIRE(wait_until([&] {
+                return recorder.stats().frames_recorded.load() + recorder.stats().frames_superseded.load() +
+                       recorder.stats().frames_thinned.load() == n;
+            }));
+        }
+        recorder.stop();
+        REQUIRE(recorder.stats().frames_recorded.load() == 4);
+        REQUIRE(recorder.stats().frames_thinned.load() == 16);
+
+        auto records = walk(store);
+        REQUIRE(records.size() == 4);
+        std::vector<uint8_t> buf(8 * 1024);
+        REQUIRE(store.read(records[1], buf.data(), buf.size()) == frame_size(6));
+        REQUIRE(records[1].timestamp_us == frame_time(6));
+    }
+
+    SECTION("idle time is spent erasing ahead") {
+        for (uint32_t n = 1; n <= 60; n++) {   // Fill past one lap, no spares erased
+            auto frame = make_frame(n, frame_size(n));
+            REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        }
+        REQUIRE(store.ready_segments() == 0);
+        FlashRecorder recorder(store);
+        REQUIRE(recorder.init({.max_frame_size = 8 * 1024, .frame_interval_ms = 0}, false));
+        REQUIRE(recorder.start());
+        REQUIRE(wait_until([&] { return store.ready_segments() == 1; }));
+        recorder.stop();
+        REQUIRE(recorder.stats().erases_ahead.load() == 1);
+    }
+
+    SECTION("timestamps stay monotonic across a reboot") {
+        auto frame = make_frame(1, 1000);
+        REQUIRE(store.append(frame.data(), frame.size(), 50 * 1000000LL) == 1);
+
+        // New boot: frame timestamps restart near zero
+        FlashRecorder recorder(store);
+        REQUIRE(recorder.init({.max_frame_size = 8 * 1024, .frame_interval_ms = 0}, false));
+        REQUIRE(recorder.start());
+        recorder.on_frame(frame.data(), frame.size(), 1000, 1);
+        REQUIRE(wait_until([&] { return recorder.stats().frames_recorded.load() == 1; }));
+        recorder.on_frame(frame.data(), frame.size(), 201000, 2);
+        REQUIRE(wait_until([&] { return recorder.stats().frames_recorded.load() == 2; }));
+        recorder.stop();
+
+        auto records = walk(store);
+        REQUIRE(records.size() == 3);
+        REQUIRE(records[1].timestamp_us > 50 * 1000000LL);
+        REQUIRE(records[2].timestamp_us - records[1].timestamp_us == 200000);   // Spacing kept
+    }
+}
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+TEST_CASE("SegmentStore throughput, write amplification and recovery",
+          "[.][benchmark][segment_store]") {
+    constexpr size_t FRAME_SIZE = 25 * 1024;   // Typical VGA JPEG at quality 12
+    constexpr size_t SEG = 64 * 1024;
+    FileFlash flash(4 * 1024 * 1024);          // Recording partition size
+    SegmentStore store(flash);
+    REQUIRE(store.mount({.segment_size = SEG, .spare_segments = 2}));
+    auto frame = make_frame(1, FRAME_SIZE);
+
+    // Two laps with erase-ahead between frames, as the recorder does
+    uint32_t n = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (store.stats().payload_bytes.load() < 2 * flash.size()) {
+        n++;
+        REQUIRE(store.append(frame.data(), frame.size(), frame_time(n)) == n);
+        while (store.service()) {}
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double payload = static_cast<double>(store.stats().payload_bytes.load());
+    WARN("Sustained: " << payload / seconds / (1024.0 * 1024.0) << " MB/s on host file, "
+         << "write amplification " << store.stats().write_amplification()
+         << " (programmed), erased/payload " << store.stats().bytes_erased.load() / payload
+         << ", erase stalls " << store.stats().erase_stalls.load()
+         << ", records kept " << store.record_count());
+
+    BENCHMARK("remount (recovery scan of a full 4 MB log)") {
+        SegmentStore again(flash);
+        return again.mount({.segment_size = SEG, .spare_segments = 2});
+    };
+
+    RecordInfo rec;
+    BENCHMARK("seek by timestamp") {
+        return store.find_time(frame_time(n - 50), &rec);
+    };
+
+    BENCHMARK("append 25 KB frame") {
+        n++;
+        return store.append(frame.data(), frame.size(), frame_time(n));
+    };
+}
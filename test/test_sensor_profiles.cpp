@@ -0,0 +1,210 @@
+/**
+ * @file test_sensor_profiles.cpp
+ * @brief Unit tests for sensor readout profiles and their selection
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/sensor_profiles.hpp"
+#include "../main/core/streaming_service.hpp"
+#include "mocks/mock_camera.hpp"
+#include "mocks/mock_clock.hpp"
+#include <cstring>
+#include <string>
+
+using namespace core;
+using namespace mocks;
+
+//=============================================================================
+// Profile Table Tests
+//=============================================================================
+
+TEST_CASE("OV2640 profile table", "[sensor_profile][table]") {
+    SECTION("every profile is valid and uniquely named") {
+        for (size_t i = 0; i < OV2640_SENSOR_PROFILE_COUNT; i++) {
+            const auto& p = OV2640_SENSOR_PROFILES[i];
+            INFO(p.name);
+            REQUIRE(sensor_profile_valid(p));
+            for (size_t j = i + 1; j < OV2640_SENSOR_PROFILE_COUNT; j++) {
+                REQUIRE(strcmp(p.name, OV2640_SENSOR_PROFILES[j].name) != 0);
+            }
+        }
+    }
+
+    SECTION("frame rate follows from the sensor timing") {
+        // UXGA readout: 1922 x 1248 clocks at 20 MHz = 119.9 ms
+        const auto* uxga = find_sensor_profile("uxga");
+        REQUIRE(uxga != nullptr);
+        REQUIRE(sensor_clock_hz(*uxga) == 20000000);
+        REQUIRE(sensor_frame_time_us(*uxga) == 119932);
+        REQUIRE(uxga->max_fps == 8);
+        REQUIRE(uxga->latency_ms == 240);   // Readout + up to one waiting frame
+
+        REQUIRE(find_sensor_profile("svga-binned")->max_fps == 25);
+        REQUIRE(find_sensor_profile("qvga-fast")->max_fps == 50);
+    }
+
+    SECTION("binning and windowing are faster than the full readout") {
+        uint8_t full = find_sensor_profile("uxga")->max_fps;
+        REQUIRE(find_sensor_profile("hd-window")->max_fps > full);
+        REQUIRE(find_sensor_profile("vga-binned")->max_fps > find_sensor_profile("hd-window")->max_fps);
+        REQUIRE(find_sensor_profile("vga-window-binned")->max_fps >
+                find_sensor_profile("vga-binned")->max_fps);
+    }
+
+    SECTION("grab mode changes the latency bound") {
+        auto latest = make_sensor_profile("a", Resolution::VGA, {0, 0, 1600, 1200}, 2, 1190, 672);
+        auto queued = make_sensor_profile("b", Resolution::VGA, {0, 0, 1600, 1200}, 2, 1190, 672,
+                                          1, 1, 20000000, GrabMode::WhenEmpty);
+        REQUIRE(latest.max_fps == queued.max_fps);
+        REQUIRE(latest.latency_ms == 80);
+        REQUIRE(queued.latency_ms == 120);
+    }
+
+    SECTION("unknown names") {
+        REQUIRE(find_sensor_profile("nope") == nullptr);
+        REQUIRE(find_sensor_profile(nullptr) == nullptr);
+    }
+}
+
+TEST_CASE("Sensor profile validation", "[sensor_profile][validate]") {
+    auto base = make_sensor_profile("test", Resolution::VGA, {0, 0, 1600, 1200}, 2, 1190, 672);
+    REQUIRE(sensor_profile_valid(base));
+
+    SECTION("window outside the array") {
+        auto p = base;
+        p.window = {200, 0, 1600, 1200};
+        REQUIRE_FALSE(sensor_profile_valid(p));
+    }
+
+    SECTION("window not aligned to the binning") {
+        auto p = base;
+        p.window = {1, 0, 1598, 1200};
+        REQUIRE_FALSE(sensor_profile_valid(p));
+    }
+
+    SECTION("output larger than the readout") {
+        auto p = make_sensor_profile("big", Resolution::UXGA, {0, 0, 1600, 1200}, 2, 1190, 672);
+        REQUIRE_FALSE(sensor_profile_valid(p));
+    }
+
+    SECTION("unsupported binning and clocking") {
+        auto p = base;
+        p.binning = 3;
+        REQUIRE_FALSE(sensor_profile_valid(p));
+        p = base;
+        p.xclk_hz = 40000000;
+        REQUIRE_FALSE(sensor_profile_valid(p));
+        p = base;
+        p.pll_multiplier = 3;
+        REQUIRE_FALSE(sensor_profile_valid(p));
+    }
+
+    SECTION("stale derived fields") {
+        auto p = base;
+        p.frame_length = 336;   // Timing edited without re-deriving max_fps
+        REQUIRE_FALSE(sensor_profile_valid(p));
+    }
+}
+
+//=============================================================================
+// Selection Tests
+//=============================================================================
+
+TEST_CASE("Sensor profile selection", "[sensor_profile][select]") {
+    SECTION("slow rate keeps the full array at full detail") {
+        const auto* p = select_sensor_profile(5, Resolution::VGA);
+        REQUIRE(p != nullptr);
+        REQUIRE(std::string(p->name) == "uxga");
+    }
+
+    SECTION("faster rates trade detail, then field of view") {
+        REQUIRE(std::string(select_sensor_profile(20, Resolution::VGA)->name) == "svga-binned");
+        REQUIRE(std::string(select_sensor_profile(30, Resolution::VGA)->name) == "vga-window-binned");
+        REQUIRE(std::string(select_sensor_profile(30, Resolution::QVGA)->name) == "qvga-fast");
+    }
+
+    SECTION("minimum output size is respected") {
+        const auto* p = select_sensor_profile(12, Resolution::HD);
+        REQUIRE(p != nullptr);
+        REQUIRE(std::string(p->name) == "hd-window");
+    }
+
+    SECTION("nothing fast enough") {
+        REQUIRE(select_sensor_profile(60, Resolution::QQVGA) == nullptr);
+        REQUIRE(select_sensor_profile(20, Resolution::UXGA) == nullptr);
+    }
+
+    SECTION("custom table") {
+        const SensorProfile table[] = {
+            make_sensor_profile("narrow", Resolution::VGA, {480, 360, 640, 480}, 1, 1922, 496),
+            make_sensor_profile("wide", Resolution::VGA, {0, 0, 1600, 1200}, 2, 1190, 672),
+        };
+        REQUIRE(select_sensor_profile(20, Resolution::VGA, table, 2) == &table[1]);
+    }
+}
+
+//=============================================================================
+// Camera Tests
+//=============================================================================
+
+TEST_CASE("Sensor profiles through ICamera", "[sensor_profile][camera]") {
+    MockCamera camera;
+    const auto* fast = find_sensor_profile("qvga-fast");
+    REQUIRE(fast != nullptr);
+
+    SECTION("set_profile switches output size and frame timing") {
+        REQUIRE(camera.init({}));
+        REQUIRE(camera.get_profile() == nullptr);
+        REQUIRE(camera.set_profile(*fast));
+        REQUIRE(camera.get_profile() != nullptr);
+        REQUIRE(std::string(camera.get_profile()->name) == "qvga-fast");
+        REQUIRE(camera.get_resolution() == Resolution::QVGA);
+
+        auto a = camera.capture_frame();
+        camera.release_frame();
+        auto b = camera.capture_frame();
+        camera.release_frame();
+        REQUIRE(a.width == 320);
+        REQUIRE(a.height == 240);
+        REQUIRE(b.timestamp_us - a.timestamp_us == 1000000 / fast->max_fps);
+    }
+
+    SECTION("set_resolution returns to the plain mode") {
+        REQUIRE(camera.init({}));
+        REQUIRE(camera.set_profile(*fast));
+        REQUIRE(camera.set_resolution(Resolution::SVGA));
+        REQUIRE(camera.get_profile() == nullptr);
+        REQUIRE(camera.capture_frame().width == 800);
+    }
+
+    SECTION("initial profile from the camera config") {
+        interfaces::CameraConfig config;
+        config.profile = find_sensor_profile("hd-window");
+        REQUIRE(camera.init(config));
+        REQUIRE(camera.get_profile() != nullptr);
+        REQUIRE(camera.get_resolution() == Resolution::HD);
+    }
+
+    SECTION("rejected before init or by the driver") {
+        REQUIRE_FALSE(camera.set_profile(*fast));
+        REQUIRE(camera.init({}));
+        camera.set_profile_result(false);
+        REQUIRE_FALSE(camera.set_profile(*fast));
+        REQUIRE(camera.get_profile() == nullptr);
+    }
+
+    SECTION("stream rate follows the selected profile") {
+        MockClock clock;
+        REQUIRE(camera.init({}));
+        StreamingService svc(camera, clock);
+        REQUIRE(svc.init({.target_fps = 8}));
+
+        const auto* p = select_sensor_profile(40, Resolution::QVGA);
+        REQUIRE(p == fast);
+        REQUIRE(camera.set_profile(*p));
+        svc.set_target_fps(p->max_fps);
+        REQUIRE(svc.get_target_fps() == 50);
+
+        svc.set_target_fps(StreamingService::MAX_TARGET_FPS + 1);
+        REQUIRE(svc.get_target_fps() == 50);
+    }
+}
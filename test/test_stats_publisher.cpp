@@ -0,0 +1,447 @@
+/**
+ * @file test_stats_publisher.cpp
+ * @brief Unit tests and benchmarks for SSE status publishing
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../main/core/stats_publisher.hpp"
+#include "mocks/mock_clock.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace core;
+using namespace mocks;
+
+static StatusSnapshot make_snapshot(int64_t captured, int64_t sent = 0) {
+    StatusSnapshot s;
+    s.set(StatusField::Captured, captured);
+    s.set(StatusField::Sent, sent);
+    s.set(StatusField::Heap, 200 * 1024);
+    s.set(StatusField::Rssi, -55);
+    s.set(StatusField::Resolution, 2);
+    s.set(StatusField::Quality, 12);
+    s.set(StatusField::Streaming, 1);
+    return s;
+}
+
+// Extract the JSON body from an SSE event ("...data: {json}\n\n")
+static std::string event_data(const char* event, size_t len) {
+    std::string text(event, len);
+    size_t start = text.find("data: ");
+    size_t end = text.find("\n\n");
+    if (start == std::string::npos || end == std::string::npos) return {};
+    return text.substr(start + 6, end - start - 6);
+}
+
+// Merge a flat JSON object into a key/value map (what the UI's applyStats does)
+static void merge_json(const std::string& json, std::map<std::string, std::string>* state) {
+    size_t pos = 1;
+    while (pos < json.size() && json[pos] != '}') {
+        size_t key_end = json.find('"', pos + 1);
+        std::string key = json.substr(pos + 1, key_end - pos - 1);
+        size_t value_start = key_end + 2;
+        size_t value_end = json.find_first_of(",}", value_start);
+        (*state)[key] = json.substr(value_start, value_end - value_start);
+        pos = value_end + (json[value_end] == ',' ? 1 : 0);
+    }
+}
+
+//=============================================================================
+// Serialization Tests
+//=============================================================================
+
+TEST_CASE("Status JSON serialization", "[stats_publisher][json]") {
+    char buf[StatsPublisher::MAX_EVENT_SIZE];
+
+    SECTION("full snapshot has every field") {
+        size_t len = format_status_json(make_snapshot(10, 8), nullptr, buf, sizeof(buf));
+        REQUIRE(len > 0);
+        std::string json(buf, len);
+        for (const char* name : STATUS_FIELD_NAMES) {
+            REQUIRE(json.find(std::string("\"") + name + "\":") != std::string::npos);
+        }
+        REQUIRE(json.find("\"streaming\":true") != std::string::npos);
+        REQUIRE(json.front() == '{');
+        REQUIRE(json.back() == '}');
+    }
+
+    SECTION("delta has only changed fields") {
+        auto prev = make_snapshot(10, 8);
+        auto next = make_snapshot(11, 8);
+        size_t len = format_status_json(next, &prev, buf, sizeof(buf));
+        REQUIRE(std::string(buf, len) == "{\"captured\":11}");
+    }
+
+    SECTION("unchanged delta is empty") {
+        auto snap = make_snapshot(10);
+        REQUIRE(format_status_json(snap, &snap, buf, sizeof(buf)) == 0);
+    }
+
+    SECTION("too-small buffer fails") {
+        REQUIRE(format_status_json(make_snapshot(1), nullptr, buf, 16) == 0);
+    }
+}
+
+//=============================================================================
+// Publisher Tests
+//=============================================================================
+
+TEST_CASE("StatsPublisher events", "[stats_publisher][events]") {
+    StatsPublisher pub(500 * 1000);
+    size_t len = 0;
+
+    SECTION("nothing to send before the first sample") {
+        REQUIRE(pub.version() == 0);
+        REQUIRE(pub.event_for(0, &len) == nullptr);
+    }
+
+    SECTION("first sample always publishes") {
+        REQUIRE(pub.publish(make_snapshot(1), 0));
+        REQUIRE(pub.version() == 1);
+        const char* ev = pub.event_for(0, &len);
+        REQUIRE(ev != nullptr);
+        std::string text(ev, len);
+        REQUIRE(text.rfind("id: 1\nevent: status\ndata: {", 0) == 0);
+        REQUIRE(text.substr(text.size() - 2) == "\n\n");
+    }
+
+    SECTION("unchanged samples publish nothing") {
+        REQUIRE(pub.publish(make_snapshot(1), 0));
+        REQUIRE_FALSE(pub.publish(make_snapshot(1), 1000 * 1000));
+        REQUIRE_FALSE(pub.publish(make_snapshot(1), 5000 * 1000));
+        REQUIRE(pub.version() == 1);
+    }
+
+    SECTION("changes within the interval are coalesced") {
+        REQUIRE(pub.publish(make_snapshot(1), 0));
+        REQUIRE_FALSE(pub.publish(make_snapshot(2), 100 * 1000));
+        REQUIRE_FALSE(pub.publish(make_snapshot(3, 1), 300 * 1000));
+        REQUIRE(pub.publish(make_snapshot(3, 1), 500 * 1000));
+        REQUIRE(pub.version() == 2);
+
+        // Delta is against the last published snapshot, so it covers both changes
+        const char* ev = pub.event_for(1, &len);
+        REQUIRE(event_data(ev, len) == "{\"captured\":3,\"sent\":1}");
+    }
+
+    SECTION("up-to-date subscriber gets nothing") {
+        REQUIRE(pub.publish(make_snapshot(1), 0));
+        REQUIRE(pub.event_for(1, &len) == nullptr);
+    }
+
+    SECTION("lagging or new subscriber gets a full snapshot") {
+        REQUIRE(pub.publish(make_snapshot(1), 0));
+        REQUIRE(pub.publish(make_snapshot(2), 1000 * 1000));
+        REQUIRE(pub.publish(make_snapshot(3), 2000 * 1000));
+
+        const char* delta = pub.event_for(2, &len);
+        REQUIRE(event_data(delta, len) == "{\"captured\":3}");
+
+        for (uint32_t seen : {0u, 1u}) {
+            const char* full = pub.event_for(seen, &len);
+            std::string data = event_data(full, len);
+            REQUIRE(data.find("\"captured\":3") != std::string::npos);
+            REQUIRE(data.find("\"quality\":12") != std::string::npos);
+        }
+    }
+
+    SECTION("merged deltas reproduce the full snapshot") {
+        std::map<std::string, std::string> merged;
+        uint32_t seen = 0;
+        for (int i = 0; i < 20; i++) {
+            StatusSnapshot snap = make_snapshot(i / 2, i / 3);
+            snap.set(StatusField::Rssi, -50 - (i % 4));
+            if (pub.publish(snap, i * 600 * 1000)) {
+                const char* ev = pub.event_for(seen, &len);
+                merge_json(event_data(ev, len), &merged);
+                seen = pub.version();
+            }
+        }
+        std::map<std::string, std::string> full;
+        char buf[StatsPublisher::MAX_EVENT_SIZE];
+        size_t n = format_status_json(pub.current(), nullptr, buf, sizeof(buf));
+        merge_json(std::string(buf, n), &full);
+        REQUIRE(merged == full);
+    }
+
+    SECTION("keepalive is an SSE comment") {
+        const char* ka = StatsPublisher::keepalive(&len);
+        REQUIRE(std::string(ka, len) == ": keepalive\n\n");
+    }
+}
+
+//=============================================================================
+// Subscriber Tests
+//=============================================================================
+
+// Socket stand-in: takes up to budget bytes in pieces of at most max_write
+struct FakeSocket {
+    std::string out;
+    size_t budget = SIZE_MAX;
+    size_t max_write = SIZE_MAX;
+    bool closed = false;
+
+    static int32_t write(void* context, const uint8_t* data, size_t size) {
+        auto* self = static_cast<FakeSocket*>(context);
+        if (self->closed) return -1;
+        size_t take = std::min({size, self->max_write, self->budget});
+        if (take == 0) return 0;
+        self->out.append(reinterpret_cast<const char*>(data), take);
+        self->budget -= take;
+        return static_cast<int32_t>(take);
+    }
+};
+
+// Split an SSE body into its blocks (events, comments, preamble)
+static std::vector<std::string> sse_blocks(const std::string& body) {
+    std::vector<std::string> blocks;
+    size_t pos = 0;
+    size_t end;
+    while ((end = body.find("\n\n", pos)) != std::string::npos) {
+        blocks.push_back(body.substr(pos, end + 2 - pos));
+        pos = end + 2;
+    }
+    return blocks;
+}
+
+TEST_CASE("SseSubscriber sends without blocking", "[stats_publisher][subscriber]") {
+    static constexpr char HEAD[] = "HTTP/1.1 200 OK\r\n\r\nretry: 3000\n\n";
+    static constexpr int64_t KEEPALIVE_US = 15 * 1000 * 1000;
+    static constexpr uint32_t STALL_BUDGET_MS = 10000;
+    StatsPublisher pub(0);
+    int64_t now = 0;
+    FakeSocket fast_sock;
+    SseSubscriber fast;
+    REQUIRE(fast.begin(&FakeSocket::write, &fast_sock, HEAD, now, STALL_BUDGET_MS));
+
+    SECTION("a stalled subscriber does not hold up the others") {
+        FakeSocket stalled_sock;
+        stalled_sock.budget = 0;
+        SseSubscriber stalled;
+        REQUIRE(stalled.begin(&FakeSocket::write, &stalled_sock, HEAD, now, STALL_BUDGET_MS));
+        for (int i = 1; i <= 5; i++) {
+            now += 100 * 1000;
+            REQUIRE(pub.publish(make_snapshot(i), now));
+            REQUIRE(stalled.service(pub, now, KEEPALIVE_US) == SseSend::Blocked);
+            REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Sent);
+            REQUIRE(fast.seen_version() == pub.version());
+        }
+        REQUIRE(stalled_sock.out.empty());
+        REQUIRE(stalled.events_skipped() == 5);
+        REQUIRE(sse_blocks(fast_sock.out.substr(sizeof(HEAD) - 1)).size() == 5);
+    }
+
+    SECTION("partial writes reassemble into exact events") {
+        fast_sock.max_write = 7;
+        fast_sock.budget = 20;
+        std::string expected = HEAD;
+        for (int i = 1; i <= 4; i++) {
+            now += 100 * 1000;
+            REQUIRE(pub.publish(make_snapshot(i), now));
+            size_t len = 0;
+            uint32_t seen = fast.seen_version();
+            const char* ev = pub.event_for(seen, &len);
+            SseSend r;
+            while ((r = fast.service(pub, now, KEEPALIVE_US)) == SseSend::Blocked) {
+                fast_sock.budget = 20;   // The socket drains a little each tick
+            }
+            REQUIRE(r == SseSend::Sent);
+            if (fast.seen_version() != seen) expected.append(ev, len);
+        }
+        REQUIRE(fast_sock.out == expected);
+    }
+
+    SECTION("a subscriber that fell behind gets a full snapshot") {
+        fast_sock.budget = sizeof(HEAD) - 1 + 10;   // Head and part of the first event
+        now += 100 * 1000;
+        REQUIRE(pub.publish(make_snapshot(1), now));
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Blocked);
+        for (int i = 2; i <= 4; i++) {
+            now += 100 * 1000;
+            REQUIRE(pub.publish(make_snapshot(i, i), now));
+            REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Blocked);
+        }
+        REQUIRE(fast.events_skipped() == 3);
+
+        fast_sock.budget = SIZE_MAX;
+        now += 100 * 1000;
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Sent);
+        REQUIRE(fast.seen_version() == pub.version());
+        auto blocks = sse_blocks(fast_sock.out.substr(sizeof(HEAD) - 1));
+        REQUIRE(blocks.size() == 2);   // Version 1, then a full snapshot of version 4
+        REQUIRE(blocks[0].find("id: 1\n") == 0);
+        REQUIRE(blocks[1].find("id: 4\n") == 0);
+        char full[StatsPublisher::MAX_EVENT_SIZE];
+        size_t n = format_status_json(pub.current(), nullptr, full, sizeof(full));
+        REQUIRE(event_data(blocks[1].data(), blocks[1].size()) == std::string(full, n));
+    }
+
+    SECTION("no progress for the stall budget evicts") {
+        fast_sock.budget = sizeof(HEAD) - 1;
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Sent);     // Head
+        now += 20 * 1000 * 1000;   // Idle time does not count against the budget
+        now += 100 * 1000;
+        REQUIRE(pub.publish(make_snapshot(1), now));
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Blocked);
+        now += (STALL_BUDGET_MS - 1) * 1000LL;
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Blocked);
+        now += 1000;
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Evicted);
+    }
+
+    SECTION("progress resets the stall budget") {
+        fast_sock.max_write = 1;
+        fast_sock.budget = 0;
+        now += 100 * 1000;
+        REQUIRE(pub.publish(make_snapshot(1), now));
+        for (int i = 0; i < 30; i++) {
+            now += (STALL_BUDGET_MS / 2) * 1000LL;
+            fast_sock.budget = 1;
+            REQUIRE(fast.service(pub, now, KEEPALIVE_US) != SseSend::Evicted);
+        }
+        REQUIRE(fast_sock.out.size() == 30);
+    }
+
+    SECTION("idle subscribers get a keepalive") {
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Sent);     // Head
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Idle);
+        REQUIRE(fast_sock.out == HEAD);
+        now += KEEPALIVE_US;
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Sent);
+        REQUIRE(fast_sock.out == std::string(HEAD) + ": keepalive\n\n");
+    }
+
+    SECTION("a closed socket ends the subscriber") {
+        fast_sock.closed = true;
+        REQUIRE(fast.service(pub, now, KEEPALIVE_US) == SseSend::Closed);
+    }
+}
+
+//=============================================================================
+// Fan-out: polling vs SSE on a simulated host transport
+//=============================================================================
+
+struct TransportCounts {
+    uint32_t requests = 0;        // HTTP requests handled
+    uint32_t serializations = 0;  // JSON bodies built
+    uint64_t bytes = 0;           // Payload bytes sent
+};
+
+// Before: every dashboard fetches /status every 2 s
+static TransportCounts simulate_polling(int dashboards, int64_t duration_us,
+                                        const std::vector<StatusSnapshot>& timeline) {
+    TransportCounts counts;
+    char buf[StatsPublisher::MAX_EVENT_SIZE];
+    for (int64_t t = 0; t < duration_us; t += 2000 * 1000) {
+        const StatusSnapshot& snap = timeline[static_cast<size_t>(t / (100 * 1000))];
+        for (int d = 0; d < dashboards; d++) {
+            counts.requests++;
+            counts.serializations++;
+            counts.bytes += format_status_json(snap, nullptr, buf, sizeof(buf));
+        }
+    }
+    return counts;
+}
+
+// After: one connection per dashboard, events sampled every 100 ms
+static TransportCounts simulate_sse(int dashboards, int64_t duration_us,
+                                    const std::vector<StatusSnapshot>& timeline,
+                                    MockClock& clock) {
+    TransportCounts counts;
+    StatsPublisher pub(500 * 1000);
+    std::vector<uint32_t> seen(static_cast<size_t>(dashboards), 0);
+    counts.requests = static_cast<uint32_t>(dashboards);  // One subscribe each
+    clock.set_time_us(0);
+    while (clock.now_us() < duration_us) {
+        int64_t now = clock.now_us();
+        pub.publish(timeline[static_cast<size_t>(now / (100 * 1000))], now);
+        for (auto& s : seen) {
+            size_t len = 0;
+            if (pub.event_for(s, &len)) {
+                counts.bytes += len;
+                s = pub.version();
+            }
+        }
+        clock.advance_ms(100);
+    }
+    counts.serializations = pub.stats().serializations;
+    return counts;
+}
+
+// Camera at 8 FPS with one stream client: counters change every sample
+static std::vector<StatusSnapshot> busy_timeline(int64_t duration_us) {
+    std::vector<StatusSnapshot> timeline;
+    for (int64_t t = 0; t <= duration_us; t += 100 * 1000) {
+        int64_t frames = t * 8 / (1000 * 1000);
+        timeline.push_back(make_snapshot(frames, frames));
+    }
+    return timeline;
+}
+
+// Idle camera: nothing changes
+static std::vector<StatusSnapshot> idle_timeline(int64_t duration_us) {
+    return std::vector<StatusSnapshot>(static_cast<size_t>(duration_us / (100 * 1000)) + 1,
+                                       make_snapshot(100, 100));
+}
+
+TEST_CASE("Status fan-out polling vs SSE", "[stats_publisher][fanout]") {
+    MockClock clock;
+    clock.set_real_sleep(false);
+    constexpr int64_t MINUTE_US = 60LL * 1000 * 1000;
+
+    SECTION("SSE serializes once per event regardless of dashboards") {
+        auto timeline = busy_timeline(MINUTE_US);
+        auto one = simulate_sse(1, MINUTE_US, timeline, clock);
+        auto many = simulate_sse(8, MINUTE_US, timeline, clock);
+        REQUIRE(one.serializations == many.serializations);
+        // Rate cap: at most one event per 500 ms (+ one full snapshot body)
+        REQUIRE(many.serializations <= 120 + 1);
+    }
+
+    SECTION("SSE replaces per-dashboard polling requests") {
+        auto timeline = busy_timeline(MINUTE_US);
+        auto polling = simulate_polling(4, MINUTE_US, timeline);
+        auto sse = simulate_sse(4, MINUTE_US, timeline, clock);
+        REQUIRE(polling.requests == 4 * 30);
+        REQUIRE(sse.requests == 4);
+    }
+
+    SECTION("idle camera sends one snapshot and then nothing") {
+        auto timeline = idle_timeline(MINUTE_US);
+        auto polling = simulate_polling(4, MINUTE_US, timeline);
+        auto sse = simulate_sse(4, MINUTE_US, timeline, clock);
+        REQUIRE(sse.serializations == 2);  // First delta body + shared full snapshot
+        REQUIRE(sse.bytes < polling.bytes / 10);
+    }
+}
+
+//=============================================================================
+// Benchmarks (run with: make bench)
+//=============================================================================
+
+TEST_CASE("Status fan-out cost per minute", "[.][benchmark][stats_publisher]") {
+    MockClock clock;
+    clock.set_real_sleep(false);
+    constexpr int64_t MINUTE_US = 60LL * 1000 * 1000;
+    auto timeline = busy_timeline(MINUTE_US);
+
+    for (int dashboards : {1, 4}) {
+        auto polling = simulate_polling(dashboards, MINUTE_US, timeline);
+        auto sse = simulate_sse(dashboards, MINUTE_US, timeline, clock);
+        WARN(dashboards << " dashboard(s), 1 min @ 8 FPS: polling "
+             << polling.requests << " req / " << polling.serializations << " JSON / "
+             << polling.bytes << " B; SSE " << sse.requests << " req / "
+             << sse.serializations << " JSON / " << sse.bytes << " B");
+    }
+
+    BENCHMARK("polling, 4 dashboards") {
+        return simulate_polling(4, MINUTE_US, timeline).bytes;
+    };
+
+    BENCHMARK("SSE, 4 dashboards") {
+        return simulate_sse(4, MINUTE_US, timeline, clock).bytes;
+    };
+}
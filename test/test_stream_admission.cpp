@@ -0,0 +1,346 @@
+/**
+ * @file test_stream_admission.cpp
+ * @brief Unit tests for EgressMeter and StreamAdmission under synthetic load
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/stream_admission.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace core;
+
+namespace {
+
+constexpr int64_t MS = 1000;
+constexpr int64_t SEC = 1000000;
+
+AdmissionInputs measured(uint32_t egress_Bps, uint32_t link_Bps, uint32_t frame_bytes = 25000,
+                         uint32_t frame_send_us = 20000) {
+    AdmissionInputs in;
+    in.egress_Bps = egress_Bps;
+    in.link_Bps = link_Bps;
+    in.frame_bytes = frame_bytes;
+    in.frame_send_us = frame_send_us;
+    in.free_heap = 200 * 1024;
+    in.fps = 10;
+    return in;
+}
+
+/**
+ * Synthetic link: every open client sends frame_bytes at its admitted rate;
+ * a frame takes as long as its share of the link allows (the link is split
+ * evenly between open clients). Frames go into the EgressMeter with
+ * synthetic time, exactly as the stream workers report them.
+ */
+struct SimLink {
+    uint32_t link_Bps;
+    uint32_t frame_bytes;
+    EgressMeter meter;
+    StreamAdmission admission;
+    std::vector<uint8_t> clients;   // Admitted FPS, 0 = left
+    int64_t now = 0;
+
+    SimLink(uint32_t link, uint32_t frame) : link_Bps(link), frame_bytes(frame) {}
+
+    size_t open() const {
+        size_t n = 0;
+        for (uint8_t fps : clients) n += fps ? 1 : 0;
+        return n;
+    }
+
+    void leave(size_t i) {
+        admission.release(clients[i]);
+        clients[i] = 0;
+    }
+
+    AdmissionVerdict join() {
+        AdmissionInputs in;
+        in.egress_Bps = meter.throughput_Bps(now);
+        in.frame_bytes = meter.frame_bytes();
+        in.frame_send_us = meter.frame_send_us();
+        in.link_Bps = link_Bps;
+        in.free_heap = 100 * 1024;
+        in.clients = static_cast<uint32_t>(open());
+        in.fps = 10;
+        AdmissionVerdict v = admission.decide(in);
+        if (v.decision != AdmissionDecision::Reject) clients.push_back(v.fps);
+        return v;
+    }
+
+    // Advance time, sending every open client's frames
+    void run(int64_t duration_us) {
+        int64_t end = now + duration_us;
+        for (; now < end; now += MS) {
+            size_t n = open();
+            for (uint8_t fps : clients) {
+                if (fps == 0 || now % (SEC / fps) != 0) continue;
+                uint32_t send_us = static_cast<uint32_t>(
+                    static_cast<uint64_t>(frame_bytes) * SEC * n / link_Bps);
+                meter.on_frame(frame_bytes, send_us, now);
+            }
+        }
+    }
+};
+
+} // namespace
+
+//=============================================================================
+// EgressMeter
+//=============================================================================
+
+TEST_CASE("EgressMeter", "[admission][meter]") {
+    EgressMeter meter;
+    CHECK(meter.throughput_Bps(10 * SEC) == 0);
+    CHECK(meter.frame_bytes() == 0);
+
+    SECTION("rate over the window counts whole buckets only") {
+        // 10 frames/s of 20 KB for 3 s
+        for (int64_t t = 0; t < 3 * SEC; t += 100 * MS) meter.on_frame(20000, 15000, t);
+        CHECK(meter.throughput_Bps(3 * SEC) == 200000);
+        // The current bucket is not counted: a burst shows up one bucket later
+        meter.on_frame(500000, 15000, 3 * SEC + 10 * MS);
+        CHECK(meter.throughput_Bps(3 * SEC + 20 * MS) == 200000);
+        // 1.25-3.0 s held 17 frames (buckets alternate 3 and 2)
+        CHECK(meter.throughput_Bps(3 * SEC + 250 * MS) == (17 * 20000 + 500000) / 2);
+    }
+
+    SECTION("old traffic ages out") {
+        for (int64_t t = 0; t < SEC; t += 100 * MS) meter.on_frame(20000, 15000, t);
+        CHECK(meter.throughput_Bps(SEC) == 100000);   // 1 s of 200 KB/s over a 2 s window
+        CHECK(meter.throughput_Bps(2 * SEC) == 100000);
+        CHECK(meter.throughput_Bps(2 * SEC + 250 * MS) == 70000);   // 0-250 ms (3 frames) gone
+        CHECK(meter.throughput_Bps(3 * SEC) == 0);
+        CHECK(meter.throughput_Bps(60 * SEC) == 0);
+    }
+
+    SECTION("frame size and send time are running means") {
+        meter.on_frame(8000, 10000, 0);
+        CHECK(meter.frame_bytes() == 8000);
+        CHECK(meter.frame_send_us() == 10000);
+        meter.on_frame(16000, 50000, 0);
+        CHECK(meter.frame_bytes() == 9000);
+        CHECK(meter.frame_send_us() == 15000);
+        for (int i = 0; i < 100; i++) meter.on_frame(16000, 50000, 0);
+        CHECK(meter.frame_bytes() > 15900);
+        CHECK(meter.frames() == 102);
+        meter.reset();
+        CHECK(meter.frames() == 0);
+        CHECK(meter.frame_send_us() == 0);
+    }
+}
+
+TEST_CASE("Link estimate from RSSI", "[admission]") {
+    CHECK(link_estimate_Bps(0, 1000000) == 1000000);     // Unknown
+    CHECK(link_estimate_Bps(-40, 1000000) == 1000000);
+    CHECK(link_estimate_Bps(-55, 1000000) == 1000000);
+    CHECK(link_estimate_Bps(-65, 1000000) == 700000);
+    CHECK(link_estimate_Bps(-75, 1000000) == 400000);
+    CHECK(link_estimate_Bps(-85, 1000000) == 100000);
+    CHECK(link_estimate_Bps(-95, 1000000) == 100000);
+}
+
+//=============================================================================
+// Decisions
+//=============================================================================
+
+TEST_CASE("StreamAdmission decisions", "[admission]") {
+    StreamAdmission admission;   // 75% of the link, 32 KB heap floor, min 1 FPS
+
+    SECTION("fits at the source rate: accept") {
+        // 1 MB/s link, 750 KB/s budget, 250 KB/s in use, 250 KB/s wanted
+        AdmissionVerdict v = admission.decide(measured(250000, 1000000));
+        CHECK(v.decision == AdmissionDecision::Accept);
+        CHECK(v.reason == AdmissionReason::Capacity);
+        CHECK(v.fps == 10);
+        CHECK(v.retry_after_s == 0);
+    }
+
+    SECTION("nothing measured yet: accept") {
+        AdmissionVerdict v = admission.decide(measured(0, 1000000, 0, 0));
+        CHECK(v.decision == AdmissionDecision::Accept);
+        CHECK(v.reason == AdmissionReason::Unmeasured);
+    }
+
+    SECTION("bandwidth left for fewer frames: degrade to what fits") {
+        // 750 KB/s budget - 650 KB/s in use = 100 KB/s = 4 frames of 25 KB
+        AdmissionVerdict v = admission.decide(measured(650000, 1000000));
+        CHECK(v.decision == AdmissionDecision::Degrade);
+        CHECK(v.reason == AdmissionReason::Bandwidth);
+        CHECK(v.fps == 4);
+    }
+
+    SECTION("slow frame sends cap the rate") {
+        // Plenty of budget, but each frame takes 160 ms to send
+        AdmissionVerdict v = admission.decide(measured(0, 10000000, 25000, 160000));
+        CHECK(v.decision == AdmissionDecision::Degrade);
+        CHECK(v.reason == AdmissionReason::SendTime);
+        CHECK(v.fps == 6);
+    }
+
+    SECTION("below the minimum rate: reject with Retry-After") {
+        AdmissionConfig config;
+        config.min_fps = 5;
+        config.retry_after_s = 30;
+        admission.set_config(config);
+        AdmissionVerdict v = admission.decide(measured(650000, 1000000));
+        CHECK(v.decision == AdmissionDecision::Reject);
+        CHECK(v.reason == AdmissionReason::Bandwidth);
+        CHECK(v.retry_after_s == 30);
+
+        v = admission.decide(measured(900000, 1000000));   // Over budget already
+        CHECK(v.decision == AdmissionDecision::Reject);
+    }
+
+    SECTION("low heap: reject whatever the link says") {
+        AdmissionInputs in = measured(0, 1000000);
+        in.free_heap = 20 * 1024;
+        AdmissionVerdict v = admission.decide(in);
+        CHECK(v.decision == AdmissionDecision::Reject);
+        CHECK(v.reason == AdmissionReason::Heap);
+        CHECK(admission.stats().rejected_heap == 1);
+    }
+
+    SECTION("admitted rates count before the measurement catches up") {
+        // Nothing measured in the window yet, but each client just let in
+        // takes 250 KB/s (10 x 25 KB) of the 750 KB/s budget
+        AdmissionVerdict a = admission.decide(measured(0, 1000000));
+        AdmissionVerdict b = admission.decide(measured(0, 1000000));
+        AdmissionVerdict c = admission.decide(measured(0, 1000000));
+        CHECK(a.decision == AdmissionDecision::Accept);
+        CHECK(b.decision == AdmissionDecision::Accept);
+        CHECK(c.decision == AdmissionDecision::Accept);
+        CHECK(admission.stats().reserved_fps == 30);
+        CHECK(admission.stats().last_reserved_Bps == 500000);
+        AdmissionVerdict d = admission.decide(measured(0, 1000000));
+        CHECK(d.decision == AdmissionDecision::Reject);
+        CHECK(d.reason == AdmissionReason::Bandwidth);
+
+        // Ends give the rate back (never below zero)
+        admission.release(a.fps);
+        admission.release(b.fps);
+        CHECK(admission.stats().reserved_fps == 10);
+        admission.release(50);
+        CHECK(admission.stats().reserved_fps == 0);
+        CHECK(admission.decide(measured(0, 1000000)).decision == AdmissionDecision::Accept);
+    }
+
+    SECTION("streams ranked below a new one do not count against it") {
+        // Three dashboards (rank 2) fill the 750 KB/s budget
+        AdmissionInputs dash = measured(0, 1000000);
+        dash.rank = 2;
+        for (int i = 0; i < 3; i++) CHECK(admission.decide(dash).decision == AdmissionDecision::Accept);
+        CHECK(admission.decide(dash).decision == AdmissionDecision::Reject);
+
+        // An operator (rank 1) only sees what ranks 0-1 use
+        AdmissionInputs op = measured(0, 1000000);
+        op.rank = 1;
+        AdmissionVerdict v = admission.decide(op);
+        CHECK(v.decision == AdmissionDecision::Accept);
+        CHECK(admission.stats().last_reserved_Bps == 0);
+        CHECK(admission.stats().reserved_fps == 40);
+
+        // ... but counts against the dashboards
+        admission.release(10, 2);
+        CHECK(admission.decide(dash).decision == AdmissionDecision::Reject);
+        admission.release(10, 2);
+        CHECK(admission.decide(dash).decision == AdmissionDecision::Accept);
+        CHECK(admission.stats().reserved_fps == 30);
+    }
+
+    SECTION("no link estimate: only send time and heap apply") {
+        AdmissionVerdict v = admission.decide(measured(5000000, 0));
+        CHECK(v.decision == AdmissionDecision::Accept);
+    }
+
+    SECTION("evaluate does not count; decide records inputs and verdict") {
+        admission.evaluate(measured(650000, 1000000));
+        CHECK(admission.stats().degraded == 0);
+
+        admission.decide(measured(250000, 1000000));
+        AdmissionInputs in = measured(650000, 1000000);
+        in.clients = 3;
+        admission.decide(in);
+        const auto& s = admission.stats();
+        CHECK(s.accepted == 1);
+        CHECK(s.degraded == 1);
+        CHECK(s.last_decision == static_cast<uint8_t>(AdmissionDecision::Degrade));
+        CHECK(s.last_fps == 4);
+        CHECK(s.last_egress_Bps == 650000);
+        CHECK(s.last_link_Bps == 1000000);
+        CHECK(s.last_clients == 3);
+
+        char json[448];
+        size_t len = format_admission_json(s, json, sizeof(json));
+        REQUIRE(len > 0);
+        CHECK(len == strlen(json));
+        std::string text(json);
+        CHECK(text.find("\"decision\":\"degrade\"") != std::string::npos);
+        CHECK(text.find("\"reason\":\"bandwidth\"") != std::string::npos);
+        CHECK(text.find("\"egress_Bps\":650000") != std::string::npos);
+        CHECK(text.find("\"clients\":3") != std::string::npos);
+        CHECK(text.find("\"degraded\":1") != std::string::npos);
+        CHECK(format_admission_json(s, json, 32) == 0);
+    }
+}
+
+//=============================================================================
+// Synthetic load
+//=============================================================================
+
+TEST_CASE("StreamAdmission under synthetic load", "[admission][load]") {
+    // 4 Mbit/s link (500 KB/s, 375 KB/s budget), 25 KB frames at 10 FPS = 250 KB/s per client
+    SimLink sim(500000, 25000);
+
+    AdmissionVerdict v = sim.join();
+    CHECK(v.decision == AdmissionDecision::Accept);
+    CHECK(v.reason == AdmissionReason::Unmeasured);
+    sim.run(3 * SEC);
+    CHECK(sim.meter.throughput_Bps(sim.now) == 250000);
+
+    // 125 KB/s left: 5 FPS
+    v = sim.join();
+    CHECK(v.decision == AdmissionDecision::Degrade);
+    CHECK(v.fps == 5);
+    sim.run(3 * SEC);
+    CHECK(sim.meter.throughput_Bps(sim.now) == 375000);
+
+    // Budget used up
+    v = sim.join();
+    CHECK(v.decision == AdmissionDecision::Reject);
+    CHECK(v.retry_after_s == 10);
+    sim.run(3 * SEC);
+    CHECK(sim.meter.throughput_Bps(sim.now) <= 375000);
+
+    // The full-rate client leaves; once the window has seen it go, a
+    // retry fits at full rate again
+    sim.leave(0);
+    sim.run(3 * SEC);
+    CHECK(sim.meter.throughput_Bps(sim.now) == 125000);
+    v = sim.join();
+    CHECK(v.decision == AdmissionDecision::Accept);
+    CHECK(v.fps == 10);
+
+    const auto& s = sim.admission.stats();
+    CHECK(s.accepted == 2);
+    CHECK(s.degraded == 1);
+    CHECK(s.rejected == 1);
+    CHECK(s.rejected_capacity == 1);
+    CHECK(s.reserved_fps == 15);
+}
+
+TEST_CASE("StreamAdmission keeps egress within the budget", "[admission][load]") {
+    // Clients keep arriving every second; whatever gets in, the measured
+    // egress never exceeds the link share
+    SimLink sim(500000, 20000);
+    for (int i = 0; i < 12; i++) {
+        sim.join();
+        sim.run(SEC);
+        INFO("after client " << i + 1);
+        CHECK(sim.meter.throughput_Bps(sim.now) <= 375000);
+    }
+    CHECK(sim.admission.stats().rejected > 0);
+    uint32_t total = 0;
+    for (uint8_t fps : sim.clients) total += fps;
+    CHECK(total * 20000 <= 375000);
+}
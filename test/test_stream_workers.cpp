@@ -0,0 +1,664 @@
+/**
+ * @file test_stream_workers.cpp
+ * @brief Unit tests for StreamWorkerPool and control latency with open streams
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "../main/core/stream_workers.hpp"
+#include "../main/core/streaming_service.hpp"
+#include "mocks/mock_camera.hpp"
+#include "fixtures/loopback_http.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace core;
+using namespace mocks;
+using namespace fixtures;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t elapsed_us(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count();
+}
+
+template <typename Pred>
+bool wait_for(Pred pred, int timeout_ms = 2000) {
+    for (int i = 0; i < timeout_ms && !pred(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return pred();
+}
+
+// Job that runs until released or the pool stops
+struct HeldJob {
+    StreamWorkerPool* pool = nullptr;
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    std::atomic<bool> saw_stop{false};
+    std::thread::id thread;
+
+    static void run(void* context) {
+        auto* self = static_cast<HeldJob*>(context);
+        self->thread = std::this_thread::get_id();
+        self->started = true;
+        while (!self->release && !self->pool->stopping()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        self->saw_stop = self->pool->stopping();
+    }
+};
+
+// Job stuck in a blocking send to a client that reads nothing: it never
+// looks at stopping(), only a cut-off socket ends it
+struct StuckSendJob {
+    int fd = -1;
+    std::atomic<bool> started{false};
+    std::atomic<bool> finished{false};
+
+    static void run(void* context) {
+        auto* self = static_cast<StuckSendJob*>(context);
+        self->started = true;
+        char chunk[4096] = {};
+        while (send(self->fd, chunk, sizeof(chunk), MSG_NOSIGNAL) > 0) {}
+        self->finished = true;
+    }
+};
+
+struct CutOffLog {
+    std::atomic<int> calls{0};
+    std::atomic<int> last_fd{-1};
+    std::atomic<int> ignore{0};    // Calls that do nothing (socket stays open)
+
+    static void cut_off(void* context, int fd) {
+        auto* self = static_cast<CutOffLog*>(context);
+        self->last_fd = fd;
+        if (self->calls++ >= self->ignore) shutdown(fd, SHUT_RDWR);
+    }
+};
+
+/**
+ * Stand-in for esp_http_server on 127.0.0.1: one server thread runs every
+ * handler in turn. /stream sends MJPEG parts from a StreamingService until
+ * the client leaves, either on the server thread (inline, as before) or on
+ * a StreamWorkerPool worker; /frame?after=&timeout= long-polls the ring the
+ * same way (the wait capped at INLINE_POLL_MAX_MS inline) and
+ * /recordings/<n>.mjpeg stands in for a clip download, sending the next n
+ * ring frames; /status answers a small JSON body.
+ */
+class StreamServer {
+public:
+    StreamServer(StreamingService& svc, size_t workers) : svc_(svc) {
+        if (workers) {
+            StreamWorkerConfig config;
+            config.workers = workers;
+            pool_.init(config);
+        }
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        listen(listen_fd_, 16);
+        thread_ = std::thread([this] { serve(); });
+    }
+
+    ~StreamServer() {
+        pool_.deinit();   // Streams end first, as in WebServer::stop()
+        stop_ = true;
+        thread_.join();
+        close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+    const StreamWorkerStats& worker_stats() const { return pool_.stats(); }
+    uint32_t stream_clients() const { return stream_clients_.load(); }
+
+    static constexpr uint32_t INLINE_POLL_MAX_MS = 250;   // As WebServer
+
+private:
+    using RequestFn = void (StreamServer::*)(int fd, const std::string& head);
+
+    struct Job {
+        StreamServer* server;
+        int fd;
+        std::string head;          // Requests: parsed again on the worker
+        RequestFn fn = nullptr;
+    };
+
+    void serve() {
+        while (!stop_) {
+            pollfd p{listen_fd_, POLLIN, 0};
+            if (poll(&p, 1, 20) <= 0) continue;
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) continue;
+            std::string head, extra;
+            if (!read_http_head(fd, &head, &extra)) {
+                close(fd);
+                continue;
+            }
+            if (head.compare(0, 12, "GET /stream ") == 0) {
+                dispatch_stream(fd);
+            } else if (head.compare(0, 11, "GET /frame?") == 0) {
+                dispatch_request(fd, head, &StreamServer::serve_frame_poll);
+            } else if (head.compare(0, 16, "GET /recordings/") == 0) {
+                dispatch_request(fd, head, &StreamServer::serve_download);
+            } else {
+                static const char status[] =
+                    "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                    "Content-Length: 15\r\nConnection: close\r\n\r\n{\"running\":true}";
+                send_all(fd, status, sizeof(status) - 1);
+                close(fd);
+            }
+        }
+    }
+
+    void dispatch_stream(int fd) {
+        static const char busy[] =
+            "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 11\r\nConnection: close\r\n\r\nStream busy";
+        if (!pool_.is_initialized()) {
+            serve_stream(fd);   // Holds the server thread until the client leaves
+            close(fd);
+            return;
+        }
+        auto* job = new Job{this, fd, {}};
+        if (!pool_.submit(&StreamServer::run_job, job)) {
+            send_all(fd, busy, sizeof(busy) - 1);
+            close(fd);
+            delete job;
+        }
+    }
+
+    static void run_job(void* context) {
+        auto* job = static_cast<Job*>(context);
+        job->server->serve_stream(job->fd);
+        close(job->fd);
+        delete job;
+    }
+
+    // WebServer::dispatch_request(): a worker, or 503 when none is idle
+    void dispatch_request(int fd, const std::string& head, RequestFn fn) {
+        static const char busy[] =
+            "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 1\r\nContent-Length: 11\r\n"
+            "Connection: close\r\n\r\nServer busy";
+        if (!pool_.is_initialized()) {
+            (this->*fn)(fd, head);
+            close(fd);
+            return;
+        }
+        auto* job = new Job{this, fd, head, fn};
+        if (pool_.idle_workers() == 0 || !pool_.submit(&StreamServer::run_request, job)) {
+            send_all(fd, busy, sizeof(busy) - 1);
+            close(fd);
+            delete job;
+        }
+    }
+
+    static void run_request(void* context) {
+        auto* job = static_cast<Job*>(context);
+        (job->server->*job->fn)(job->fd, job->head);
+        close(job->fd);
+        delete job;
+    }
+
+    void serve_frame_poll(int fd, const std::string& head) {
+        unsigned long after = 0, timeout_ms = 0;
+        size_t q = head.find('?');
+        sscanf(head.c_str() + q, "?after=%lu&timeout=%lu", &after, &timeout_ms);
+        if (!pool_.is_initialized() && timeout_ms > INLINE_POLL_MAX_MS) timeout_ms = INLINE_POLL_MAX_MS;
+        const uint8_t* data;
+        size_t size;
+        int handle = svc_.acquire_frame_after(static_cast<uint32_t>(after), &data, &size,
+                                              static_cast<uint32_t>(timeout_ms));
+        if (handle < 0) {
+            static const char none[] = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+            send_all(fd, none, sizeof(none) - 1);
+            return;
+        }
+        char resp[128];
+        int n = snprintf(resp, sizeof(resp),
+                         "HTTP/1.1 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n"
+                         "Connection: close\r\n\r\n", size);
+        if (send_all(fd, resp, static_cast<size_t>(n))) send_all(fd, data, size);
+        svc_.release_acquired_frame(handle);
+    }
+
+    void serve_download(int fd, const std::string& head) {
+        unsigned long frames = 0;
+        sscanf(head.c_str(), "GET /recordings/%lu.mjpeg", &frames);
+        static const char ok[] =
+            "HTTP/1.1 200 OK\r\nContent-Type: video/x-motion-jpeg\r\nConnection: close\r\n\r\n";
+        bool sending = send_all(fd, ok, sizeof(ok) - 1);
+        uint32_t last_sequence = svc_.last_sequence();
+        for (unsigned long i = 0; sending && i < frames && !pool_.stopping() && !stop_; ) {
+            const uint8_t* data;
+            size_t size;
+            uint32_t sequence = 0;
+            int handle = svc_.acquire_frame_after(last_sequence, &data, &size, 100, nullptr, &sequence);
+            if (handle < 0) continue;
+            last_sequence = sequence;
+            sending = send_all(fd, data, size);
+            svc_.release_acquired_frame(handle);
+            i++;
+        }
+    }
+
+    void serve_stream(int fd) {
+        stream_clients_++;
+        static const char head[] =
+            "HTTP/1.1 200 OK\r\nContent-Type: multipart/x-mixed-replace; boundary=frame\r\n\r\n";
+        bool ok = send_all(fd, head, sizeof(head) - 1);
+        uint32_t last_sequence = svc_.last_sequence();
+        while (ok && !pool_.stopping() && !stop_) {
+            const uint8_t* data;
+            size_t size;
+            uint32_t sequence = 0;
+            int handle = svc_.acquire_frame_after(last_sequence, &data, &size, 100, nullptr, &sequence);
+            if (handle < 0) continue;
+            last_sequence = sequence;
+            char part[96];
+            int n = snprintf(part, sizeof(part),
+                             "\r\n--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n", size);
+            ok = send_all(fd, part, static_cast<size_t>(n)) && send_all(fd, data, size);
+            svc_.release_acquired_frame(handle);
+        }
+        stream_clients_--;
+    }
+
+    StreamingService& svc_;
+    StreamWorkerPool pool_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint32_t> stream_clients_{0};
+    std::thread thread_;
+};
+
+int connect_to(uint16_t port, int recv_timeout_ms) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    timeval tv{recv_timeout_ms / 1000, (recv_timeout_ms % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// GET /status; returns the latency in microseconds, or -1 if no answer in time
+int64_t status_latency_us(uint16_t port, int timeout_ms) {
+    auto start = Clock::now();
+    int fd = connect_to(port, timeout_ms);
+    if (fd < 0) return -1;
+    static const char request[] = "GET /status HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    send_all(fd, request, sizeof(request) - 1);
+    std::string head, extra;
+    bool ok = read_http_head(fd, &head, &extra) && head.compare(0, 12, "HTTP/1.1 200") == 0;
+    close(fd);
+    return ok ? elapsed_us(start) : -1;
+}
+
+// GET path; returns the status code, or -1 if no answer in time
+int http_status(uint16_t port, const std::string& path, int timeout_ms) {
+    int fd = connect_to(port, timeout_ms);
+    if (fd < 0) return -1;
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    send_all(fd, request.data(), request.size());
+    std::string head, extra;
+    bool ok = read_http_head(fd, &head, &extra);
+    close(fd);
+    return ok ? atoi(head.c_str() + 9) : -1;
+}
+
+// GET path and read the body to the end; returns the status code, or -1
+int http_download(uint16_t port, const std::string& path, size_t* body_bytes) {
+    int fd = connect_to(port, 3000);
+    if (fd < 0) return -1;
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    send_all(fd, request.data(), request.size());
+    std::string head, extra;
+    int status = -1;
+    if (read_http_head(fd, &head, &extra)) {
+        status = atoi(head.c_str() + 9);
+        *body_bytes = extra.size();
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) *body_bytes += static_cast<size_t>(n);
+    }
+    close(fd);
+    return status;
+}
+
+// A browser watching /stream: reads until closed
+class StreamClient {
+public:
+    explicit StreamClient(uint16_t port) {
+        fd_ = connect_to(port, 200);
+        static const char request[] = "GET /stream HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+        if (fd_ >= 0) send_all(fd_, request, sizeof(request) - 1);
+        thread_ = std::thread([this] {
+            char buf[4096];
+            std::string head;
+            while (!stop_) {
+                ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+                if (n == 0) break;
+                if (n < 0) continue;   // Receive timeout: keep watching
+                if (head.size() < 12) head.append(buf, static_cast<size_t>(std::min<ssize_t>(n, 12)));
+                if (head.size() >= 12) status_ = atoi(head.c_str() + 9);
+                bytes_ += static_cast<size_t>(n);
+            }
+        });
+    }
+
+    ~StreamClient() { leave(); }
+
+    void leave() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+    }
+
+    int status() const { return status_.load(); }
+    size_t bytes() const { return bytes_.load(); }
+
+private:
+    int fd_ = -1;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> status_{0};
+    std::atomic<size_t> bytes_{0};
+    std::thread thread_;
+};
+
+// Wall-clock IClock: streams here are paced in real time
+class SteadyClock : public interfaces::IClock {
+public:
+    int64_t now_us() const override { return elapsed_us(origin_); }
+    void delay_ms(uint32_t ms) override { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+    void delay_us(uint32_t us) override { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+    void yield() override { std::this_thread::yield(); }
+
+private:
+    Clock::time_point origin_ = Clock::now();
+};
+
+// A 30 FPS MockCamera pipeline (not started: no frame ever arrives)
+struct Pipeline {
+    MockCamera camera;
+    SteadyClock clock;
+    StreamingService svc{camera, clock};
+
+    explicit Pipeline(bool start = true) {
+        camera.init({});
+        StreamingConfig config;
+        config.target_fps = 30;
+        svc.init(config);
+        if (start) svc.start();
+    }
+};
+
+std::vector<int64_t> status_latencies(uint16_t port, int requests, int timeout_ms) {
+    std::vector<int64_t> latencies;
+    for (int i = 0; i < requests; i++) {
+        latencies.push_back(status_latency_us(port, timeout_ms));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return latencies;
+}
+
+} // namespace
+
+//=============================================================================
+// StreamWorkerPool
+//=============================================================================
+
+TEST_CASE("StreamWorkerPool runs jobs on its own workers", "[workers]") {
+    StreamWorkerPool pool;
+
+    SECTION("worker count is bounded") {
+        StreamWorkerConfig config;
+        config.workers = 0;
+        CHECK_FALSE(pool.init(config));
+        config.workers = StreamWorkerPool::MAX_WORKERS + 1;
+        CHECK_FALSE(pool.init(config));
+        CHECK_FALSE(pool.submit(&HeldJob::run, nullptr));
+        config.workers = 3;
+        REQUIRE(pool.init(config));
+        CHECK(pool.workers() == 3);
+        CHECK(pool.idle_workers() == 3);
+    }
+
+    SECTION("submit returns at once; the job runs elsewhere") {
+        REQUIRE(pool.init());
+        HeldJob job;
+        job.pool = &pool;
+        auto start = Clock::now();
+        REQUIRE(pool.submit(&HeldJob::run, &job));
+        CHECK(elapsed_us(start) < 50000);
+        REQUIRE(wait_for([&] { return job.started.load(); }));
+        CHECK(job.thread != std::this_thread::get_id());
+        job.release = true;
+        REQUIRE(wait_for([&] { return pool.stats().completed.load() == 1; }));
+        CHECK(pool.idle_workers() == 2);
+    }
+
+    SECTION("no queueing: a full pool rejects, a finished job frees its worker") {
+        REQUIRE(pool.init());
+        HeldJob a, b, c;
+        a.pool = b.pool = c.pool = &pool;
+        REQUIRE(pool.submit(&HeldJob::run, &a));
+        REQUIRE(pool.submit(&HeldJob::run, &b));
+        CHECK(pool.idle_workers() == 0);
+        CHECK_FALSE(pool.submit(&HeldJob::run, &c));
+        CHECK(pool.stats().rejected == 1);
+
+        a.release = true;
+        REQUIRE(wait_for([&] { return pool.stats().completed.load() == 1; }));
+        REQUIRE(pool.submit(&HeldJob::run, &c));
+        REQUIRE(wait_for([&] { return c.started.load(); }));
+        CHECK(pool.stats().peak_active == 2);
+        b.release = true;
+        c.release = true;
+    }
+
+    SECTION("deinit stops running jobs and waits for them") {
+        REQUIRE(pool.init());
+        HeldJob a, b;
+        a.pool = b.pool = &pool;
+        REQUIRE(pool.submit(&HeldJob::run, &a));
+        REQUIRE(pool.submit(&HeldJob::run, &b));
+        REQUIRE(wait_for([&] { return a.started.load() && b.started.load(); }));
+        pool.deinit();
+        CHECK(a.saw_stop);
+        CHECK(b.saw_stop);
+        CHECK(pool.stats().completed == 2);
+        CHECK_FALSE(pool.submit(&HeldJob::run, &a));
+    }
+
+    SECTION("deinit cuts off a job stuck in a send and does not return before it ends") {
+        int fds[2];
+        REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        CutOffLog log;
+        log.ignore = 1;   // First round does not help: deinit must keep waiting
+        StreamWorkerConfig config;
+        config.stop_grace_ms = 50;
+        config.cut_off = &CutOffLog::cut_off;
+        config.cut_off_context = &log;
+        REQUIRE(pool.init(config));
+        StuckSendJob stuck;
+        stuck.fd = fds[0];
+        HeldJob held;
+        held.pool = &pool;
+        REQUIRE(pool.submit(&StuckSendJob::run, &stuck, fds[0]));
+        REQUIRE(pool.submit(&HeldJob::run, &held));   // No socket: ends on stopping()
+        REQUIRE(wait_for([&] { return stuck.started.load() && held.started.load(); }));
+
+        pool.deinit();
+        CHECK(stuck.finished);
+        CHECK(held.saw_stop);
+        CHECK(log.calls == 2);
+        CHECK(log.last_fd == fds[0]);
+        CHECK(pool.stats().completed == 2);
+        CHECK(pool.stats().active == 0);
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+//=============================================================================
+// Control requests while streams are open (loopback HTTP)
+//=============================================================================
+
+TEST_CASE("Open streams no longer block control requests", "[workers][http]") {
+    Pipeline pipeline;
+
+    SECTION("inline: a stream holds the server thread") {
+        StreamServer server(pipeline.svc, 0);
+        REQUIRE(status_latency_us(server.port(), 1000) > 0);
+        StreamClient stream(server.port());
+        REQUIRE(wait_for([&] { return stream.bytes() > 1000; }));
+        CHECK(status_latency_us(server.port(), 300) == -1);   // Queued behind the stream
+        stream.leave();
+    }
+
+    SECTION("pooled: status answers while every worker streams") {
+        StreamServer server(pipeline.svc, 2);
+        StreamClient a(server.port());
+        StreamClient b(server.port());
+        REQUIRE(wait_for([&] { return a.bytes() > 1000 && b.bytes() > 1000; }));
+        CHECK(a.status() == 200);
+        CHECK(b.status() == 200);
+
+        auto latencies = status_latencies(server.port(), 20, 1000);
+        std::sort(latencies.begin(), latencies.end());
+        CHECK(latencies.front() > 0);           // None timed out
+        CHECK(latencies[10] < 50000);          // Median well under a frame period
+
+        // A third stream is turned away rather than queued behind the others
+        StreamClient c(server.port());
+        REQUIRE(wait_for([&] { return c.status() != 0; }));
+        CHECK(c.status() == 503);
+        CHECK(server.worker_stats().rejected == 1);
+
+        // A leaving client frees its worker for the next one
+        a.leave();
+        REQUIRE(wait_for([&] { return server.stream_clients() == 1; }));
+        StreamClient d(server.port());
+        REQUIRE(wait_for([&] { return d.bytes() > 1000; }));
+        CHECK(d.status() == 200);
+        CHECK(b.bytes() > 0);
+    }
+
+    SECTION("pooled: a waiting /frame poll holds a worker, not the server") {
+        Pipeline idle(false);
+        StreamServer server(idle.svc, 2);
+        std::atomic<int> poll_status{0};
+        std::thread poller([&] {
+            poll_status = http_status(server.port(), "/frame?after=0&timeout=1000", 3000);
+        });
+        REQUIRE(wait_for([&] { return server.worker_stats().active.load() == 1; }));
+
+        auto latencies = status_latencies(server.port(), 10, 500);
+        std::sort(latencies.begin(), latencies.end());
+        CHECK(latencies.front() > 0);          // None waited for the poll
+        CHECK(latencies[5] < 50000);
+        poller.join();
+        CHECK(poll_status == 204);
+        REQUIRE(wait_for([&] { return server.worker_stats().active.load() == 0; }));
+
+        // Every worker streaming: the poll is turned away, not queued
+        StreamClient a(server.port());
+        StreamClient b(server.port());
+        REQUIRE(wait_for([&] { return server.stream_clients() == 2; }));
+        CHECK(http_status(server.port(), "/frame?after=0&timeout=1000", 1000) == 503);
+    }
+
+    SECTION("pooled: /frame and a recording download answer beside a download") {
+        StreamServer server(pipeline.svc, 2);
+        // About 1.5 s of frames at 30 FPS: one worker stays busy throughout
+        std::atomic<int> download_status{0};
+        size_t download_bytes = 0;
+        std::thread downloader([&] {
+            download_status = http_download(server.port(), "/recordings/45.mjpeg", &download_bytes);
+        });
+        REQUIRE(wait_for([&] { return server.worker_stats().active.load() == 1; }));
+
+        auto latencies = status_latencies(server.port(), 10, 500);
+        std::sort(latencies.begin(), latencies.end());
+        CHECK(latencies.front() > 0);
+        CHECK(latencies[5] < 50000);
+        CHECK(http_status(server.port(), "/frame?after=0&timeout=1000", 1000) == 200);
+        REQUIRE(wait_for([&] { return server.worker_stats().active.load() == 1; }));
+        size_t short_bytes = 0;
+        CHECK(http_download(server.port(), "/recordings/2.mjpeg", &short_bytes) == 200);
+        CHECK(short_bytes > 0);
+        CHECK(download_status == 0);   // The long one is still going
+
+        downloader.join();
+        CHECK(download_status == 200);
+        CHECK(download_bytes > short_bytes);
+        REQUIRE(wait_for([&] { return server.worker_stats().active.load() == 0; }));
+
+        // Both workers streaming: a download is turned away, not queued
+        StreamClient a(server.port());
+        StreamClient b(server.port());
+        REQUIRE(wait_for([&] { return server.stream_clients() == 2; }));
+        size_t busy_bytes = 0;
+        CHECK(http_download(server.port(), "/recordings/2.mjpeg", &busy_bytes) == 503);
+    }
+
+    SECTION("inline: a /frame wait is capped") {
+        Pipeline idle(false);
+        StreamServer server(idle.svc, 0);
+        auto start = Clock::now();
+        CHECK(http_status(server.port(), "/frame?after=0&timeout=5000", 3000) == 204);
+        CHECK(elapsed_us(start) < 1000000);
+    }
+}
+
+//=============================================================================
+// Benchmarks
+//=============================================================================
+
+TEST_CASE("Control latency with open streams", "[.][benchmark][workers]") {
+    Pipeline pipeline;
+    StreamServer server(pipeline.svc, StreamWorkerPool::MAX_WORKERS);
+    std::vector<std::unique_ptr<StreamClient>> streams;
+    printf("%-8s %10s %10s %10s\n", "streams", "p50 (us)", "p99 (us)", "timeouts");
+    for (size_t n = 0; n <= StreamWorkerPool::MAX_WORKERS; n += 2) {
+        while (streams.size() < n) streams.emplace_back(new StreamClient(server.port()));
+        wait_for([&] { return server.stream_clients() == n; });
+        auto latencies = status_latencies(server.port(), 200, 1000);
+        size_t timeouts = static_cast<size_t>(std::count(latencies.begin(), latencies.end(), -1));
+        std::sort(latencies.begin(), latencies.end());
+        printf("%-8zu %10lld %10lld %10zu\n", n, static_cast<long long>(latencies[100]),
+               static_cast<long long>(latencies[198]), timeouts);
+    }
+    streams.clear();
+
+    // Before: the stream runs on the server thread
+    StreamServer inline_server(pipeline.svc, 0);
+    StreamClient stream(inline_server.port());
+    wait_for([&] { return inline_server.stream_clients() == 1; });
+    auto latencies = status_latencies(inline_server.port(), 10, 200);
+    printf("%-8s %10s %10s %10zu  (inline, 1 stream, 200 ms timeout)\n", "1", "-", "-",
+           static_cast<size_t>(std::count(latencies.begin(), latencies.end(), -1)));
+    stream.leave();
+}
@@ -9,6 +9,10 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <cstring>
 
 using namespace core;
 using namespace mocks;
@@ -193,6 +197,76 @@ TEST_CASE("StreamingService frame capture", "[streaming][capture]") {
     }
 }
 
+namespace {
+
+// Appends a marker byte, or rejects every frame
+class TestProcessor : public interfaces::IFrameProcessor {
+public:
+    size_t process(const interfaces::FrameView& frame, uint8_t* out, size_t capacity) override {
+        calls++;
+        if (reject || frame.size + 1 > capacity) return 0;
+        memcpy(out, frame.data, frame.size);
+        out[frame.size] = 0xAB;
+        return frame.size + 1;
+    }
+    std::atomic<uint32_t> calls{0};
+    bool reject = false;
+};
+
+} // namespace
+
+TEST_CASE("StreamingService frame processor", "[streaming][processor]") {
+    MockCamera camera;
+    MockClock clock;
+    camera.init({});
+    clock.set_auto_advance_us(10000);
+    TestProcessor processor;
+    StreamingService svc(camera, clock);
+    
+    SECTION("requires init and a stopped producer") {
+        REQUIRE_FALSE(svc.set_processor(&processor));
+        REQUIRE(svc.init({.target_fps = 30}));
+        REQUIRE(svc.set_processor(&processor));
+        REQUIRE(svc.start());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE_FALSE(svc.set_processor(nullptr));
+        svc.stop();
+    }
+    
+    SECTION("consumers see the processed frame") {
+        REQUIRE(svc.init({.target_fps = 30}));
+        REQUIRE(svc.set_processor(&processor));
+        REQUIRE(svc.start());
+        
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        REQUIRE(svc.get_frame(&data, &size, 1000));
+        REQUIRE(size == 1025);
+        REQUIRE(data[1024] == 0xAB);
+        svc.release_frame();
+        svc.stop();
+        
+        REQUIRE(processor.calls.load() > 0);
+        REQUIRE(camera.capture_calls() == camera.release_calls());
+        REQUIRE_FALSE(camera.is_frame_held());
+    }
+    
+    SECTION("rejected frames are dropped, not committed unprocessed") {
+        processor.reject = true;
+        REQUIRE(svc.init({.target_fps = 30}));
+        REQUIRE(svc.set_processor(&processor));
+        REQUIRE(svc.start());
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        svc.stop();
+        
+        REQUIRE(svc.stats().processing_errors.load() > 0);
+        REQUIRE(svc.stats().capture_errors.load() == 0);
+        REQUIRE(svc.stats().frames_captured.load() == 0);
+        REQUIRE(svc.buffered_frames() == 0);
+        REQUIRE(camera.capture_calls() == camera.release_calls());
+    }
+}
+
 //=============================================================================
 // Consumer API Tests
 //=============================================================================
@@ -392,7 +466,7 @@ TEST_CASE("StreamingService configuration", "[streaming][config]") {
         svc.set_target_fps(0);   // Invalid
         REQUIRE(svc.get_target_fps() == 10);  // Unchanged
         
-        svc.set_target_fps(31);  // Too high
+        svc.set_target_fps(StreamingService::MAX_TARGET_FPS + 1);  // Too high
         REQUIRE(svc.get_target_fps() == 10);  // Unchanged
     }
     
@@ -478,6 +552,13 @@ TEST_CASE("StreamingService producer-consumer flow", "[streaming][integration]")
 // Edge Cases
 //=============================================================================
 
+// Counts the frames it is handed
+class CountingSink : public interfaces::IFrameSink {
+public:
+    void on_frame(const uint8_t*, size_t, int64_t, uint32_t) override { frames++; }
+    std::atomic<uint32_t> frames{0};
+};
+
 TEST_CASE("StreamingService edge cases", "[streaming][edge]") {
     MockCamera camera;
     MockClock clock;
@@ -532,6 +613,25 @@ TEST_CASE("StreamingService edge cases", "[streaming][edge]") {
         REQUIRE(true);
     }
     
+    SECTION("every sink the firmware can attach is fed") {
+        StreamingService svc(camera, clock);
+        REQUIRE(svc.init({.target_fps = 30}));
+        // main.cpp: history, multicast, uploader, MQTT frames, recorder, quality
+        CountingSink sinks[StreamingService::MAX_SINKS];
+        REQUIRE(StreamingService::MAX_SINKS >= 6);
+        for (auto& sink : sinks) REQUIRE(svc.add_sink(&sink));
+        CountingSink extra;
+        REQUIRE_FALSE(svc.add_sink(&extra));
+        
+        REQUIRE(svc.start());
+        while (sinks[StreamingService::MAX_SINKS - 1].frames.load() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        svc.stop();
+        REQUIRE(sinks[0].frames.load() > 0);
+        REQUIRE(extra.frames.load() == 0);
+    }
+    
     SECTION("rapid start-stop cycles") {
         StreamingService svc(camera, clock);
         REQUIRE(svc.init());
@@ -547,6 +647,223 @@ TEST_CASE("StreamingService edge cases", "[streaming][edge]") {
     }
 }
 
+//=============================================================================
+// Long-Poll Tests (acquire_frame_after)
+//=============================================================================
+
+// Lets the producer capture exactly N frames (blocks inside capture_frame)
+class FrameGate {
+public:
+    void allow(int n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        permits_ += n;
+        cv_.notify_all();
+    }
+    
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        cv_.notify_all();
+    }
+    
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return permits_ > 0 || open_; });
+        if (!open_) permits_--;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int permits_ = 0;
+    bool open_ = false;
+};
+
+// Spin (no sleeps) until pred holds; the bound only ends a failing test
+template <typename Pred>
+static bool spin_until(Pred pred) {
+    for (long i = 0; i < 50000000L && !pred(); i++) std::this_thread::yield();
+    return pred();
+}
+
+static bool wait_for_sequence(const StreamingService& svc, uint32_t seq) {
+    return spin_until([&] { return svc.last_sequence() >= seq; });
+}
+
+// Until `count` more pollers have entered the notifier and found nothing
+// ready. The gate holds the producer, so they stay asleep until the test
+// lets a frame through: no wall-clock window to guess.
+static bool wait_for_sleepers(const StreamingService& svc, uint32_t waits_before, uint32_t count) {
+    return spin_until([&] { return svc.notifier_stats().waits.load() >= waits_before + count; });
+}
+
+TEST_CASE("StreamingService long-poll", "[streaming][longpoll]") {
+    MockCamera camera;
+    MockClock clock;
+    camera.init({});
+    
+    clock.set_auto_advance_us(1000);  // Producer pacing runs on mock time
+    
+    FrameGate gate;
+    camera.set_capture_delay_callback([&gate] { gate.wait(); });
+    
+    StreamingService svc(camera, clock);
+    REQUIRE(svc.init({.target_fps = 30}));
+    REQUIRE(svc.start());
+    
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint32_t seq = 0;
+    int64_t ts = 0;
+    
+    SECTION("returns newest frame immediately when already newer") {
+        gate.allow(3);
+        REQUIRE(wait_for_sequence(svc, 3));
+        
+        int h = svc.acquire_frame_after(0, &data, &size, 0, &ts, &seq);
+        REQUIRE(h >= 0);
+        REQUIRE(seq == 3);  // Newest, intermediate frames skipped
+        REQUIRE(ts > 0);
+        svc.release_acquired_frame(h);
+    }
+    
+    SECTION("non-blocking call with nothing newer returns -1") {
+        gate.allow(1);
+        REQUIRE(wait_for_sequence(svc, 1));
+        REQUIRE(svc.acquire_frame_after(1, &data, &size, 0) == -1);
+    }
+    
+    SECTION("blocks until the next frame is committed") {
+        gate.allow(1);
+        REQUIRE(wait_for_sequence(svc, 1));
+        
+        uint32_t waits = svc.notifier_stats().waits.load();
+        std::atomic<bool> returned{false};
+        std::atomic<uint32_t> got{0};
+        std::thread poller([&] {
+            const uint8_t* d; size_t sz; uint32_t s = 0;
+            int h = svc.acquire_frame_after(1, &d, &sz, 60000, nullptr, &s);
+            got = s;
+            returned = true;
+            if (h >= 0) svc.release_acquired_frame(h);
+        });
+        
+        REQUIRE(wait_for_sleepers(svc, waits, 1));
+        REQUIRE_FALSE(returned.load());  // The gate holds frame 2 back
+        
+        gate.allow(1);
+        poller.join();
+        REQUIRE(got.load() == 2);
+        REQUIRE(svc.notifier_stats().timeouts.load() == 0);
+    }
+    
+    SECTION("one commit wakes every waiter") {
+        gate.allow(1);
+        REQUIRE(wait_for_sequence(svc, 1));
+        
+        constexpr int NUM_POLLERS = 4;
+        uint32_t waits = svc.notifier_stats().waits.load();
+        std::atomic<int> woke{0};
+        std::vector<std::thread> pollers;
+        for (int i = 0; i < NUM_POLLERS; i++) {
+            pollers.emplace_back([&] {
+                const uint8_t* d; size_t sz; uint32_t s = 0;
+                int h = svc.acquire_frame_after(1, &d, &sz, 60000, nullptr, &s);
+                if (h >= 0 && s == 2) woke++;
+                if (h >= 0) svc.release_acquired_frame(h);
+            });
+        }
+        
+        REQUIRE(wait_for_sleepers(svc, waits, NUM_POLLERS));
+        gate.allow(1);
+        for (auto& t : pollers) t.join();
+        REQUIRE(woke.load() == NUM_POLLERS);
+    }
+    
+    SECTION("times out when no newer frame arrives") {
+        gate.allow(1);
+        REQUIRE(wait_for_sequence(svc, 1));
+        
+        // The gate holds the producer: nothing can publish during the wait
+        uint32_t timeouts = svc.notifier_stats().timeouts.load();
+        REQUIRE(svc.acquire_frame_after(1, &data, &size, 0) == -1);
+        REQUIRE(svc.acquire_frame_after(1, &data, &size, 20) == -1);
+        REQUIRE(svc.notifier_stats().timeouts.load() == timeouts + 1);
+        REQUIRE(svc.last_sequence() == 1);
+    }
+    
+    SECTION("sequence ahead of the ring waits for the next frame") {
+        gate.allow(1);
+        REQUIRE(wait_for_sequence(svc, 1));
+        
+        uint32_t waits = svc.notifier_stats().waits.load();
+        std::atomic<int> handle{-1};
+        std::atomic<uint32_t> got{0};
+        std::thread poller([&] {
+            const uint8_t* d; size_t sz; uint32_t s = 0;
+            handle = svc.acquire_frame_after(1000, &d, &sz, 60000, nullptr, &s);
+            got = s;
+        });
+        REQUIRE(wait_for_sleepers(svc, waits, 1));
+        gate.allow(1);
+        poller.join();
+        REQUIRE(handle.load() >= 0);
+        REQUIRE(got.load() == 2);
+        svc.release_acquired_frame(handle.load());
+    }
+    
+    SECTION("does not take frames from the stream consumer") {
+        gate.allow(1);
+        REQUIRE(wait_for_sequence(svc, 1));
+        
+        int h = svc.acquire_frame_after(0, &data, &size, 0, nullptr, &seq);
+        REQUIRE(h >= 0);
+        
+        const uint8_t* stream_data; size_t stream_size; uint32_t stream_seq = 0;
+        REQUIRE(svc.get_frame(&stream_data, &stream_size, 100, nullptr, &stream_seq));
+        REQUIRE(stream_seq == seq);
+        svc.release_frame();
+        svc.release_acquired_frame(h);
+    }
+    
+    SECTION("successive polls see each sequence exactly once") {
+        uint32_t last = 0;
+        for (uint32_t i = 1; i <= 5; i++) {
+            gate.allow(1);
+            REQUIRE(wait_for_sequence(svc, i));
+            int h = svc.acquire_frame_after(last, &data, &size, 0, nullptr, &seq);
+            REQUIRE(h >= 0);
+            REQUIRE(seq == last + 1);   // None skipped
+            last = seq;
+            svc.release_acquired_frame(h);
+            // Asked again from the frame just seen: nothing until the next commit
+            REQUIRE(svc.acquire_frame_after(last, &data, &size, 0) == -1);
+        }
+        REQUIRE(last == 5);
+    }
+    
+    SECTION("stop wakes waiters") {
+        uint32_t waits = svc.notifier_stats().waits.load();
+        std::atomic<bool> returned{false};
+        std::thread poller([&] {
+            const uint8_t* d; size_t sz;
+            int h = svc.acquire_frame_after(1000, &d, &sz, 60000);
+            returned = true;
+            if (h >= 0) svc.release_acquired_frame(h);
+        });
+        REQUIRE(wait_for_sleepers(svc, waits, 1));
+        REQUIRE_FALSE(returned.load());
+        gate.open();
+        svc.stop();
+        poller.join();   // Would hang for the full minute without the wakeup
+        REQUIRE(returned.load());
+        REQUIRE(svc.notifier_stats().timeouts.load() == 0);
+    }
+    
+    gate.open();
+    svc.stop();
+}
+
 //=============================================================================
 // Mock Verification Tests
 //=============================================================================